@@ -49,6 +49,10 @@ namespace beva_demo_00_first_triangle
         { .pos = { 0.f, -.5f }, .col = { 1.f, 0.f, 0.f } }
     };
 
+    App::App(const beva_demos::HeadlessConfig& headless_config)
+        : headless(headless_config)
+    {}
+
     void App::run()
     {
         try
@@ -72,6 +76,7 @@ namespace beva_demo_00_first_triangle
         pick_physical_device();
         create_logical_device();
         create_memory_bank();
+        create_pipeline_cache();
         create_swapchain();
         create_render_pass();
         create_swapchain_framebuffers();
@@ -84,6 +89,24 @@ namespace beva_demo_00_first_triangle
 
     void App::main_loop()
     {
+        if (headless.has_value())
+        {
+            stats.reserve(headless->n_frames);
+            for (uint64_t i = 0; i < headless->n_frames; i++)
+            {
+                stats.begin_frame();
+
+                dump_frame =
+                    i + 1 == headless->n_frames
+                    && !headless->dump_path.empty();
+                draw_frame();
+
+                stats.end_frame();
+            }
+            device->wait_idle();
+            return;
+        }
+
         while (true)
         {
             glfwPollEvents();
@@ -116,18 +139,29 @@ namespace beva_demo_00_first_triangle
 
         cleanup_swapchain();
 
+        pipeline_cache->save(PIPELINE_CACHE_PATH);
+        pipeline_cache = nullptr;
+
         mem_bank = nullptr;
         device = nullptr;
         surface = nullptr;
         debug_messenger = nullptr;
         context = nullptr;
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (!headless.has_value())
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void App::init_window()
     {
+        if (headless.has_value())
+        {
+            return;
+        }
+
         glfwSetErrorCallback(glfw_error_callback);
 
         if (!glfwInit())
@@ -166,13 +200,21 @@ namespace beva_demo_00_first_triangle
 
         std::vector<std::string> extensions;
         {
-            // extensions required by GLFW
-            uint32_t glfw_ext_count = 0;
-            const char** glfw_exts;
-            glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
-            for (uint32_t i = 0; i < glfw_ext_count; i++)
+            if (headless.has_value())
             {
-                extensions.emplace_back(glfw_exts[i]);
+                // extensions required for headless surfaces
+                extensions = beva_demos::headless_instance_extensions();
+            }
+            else
+            {
+                // extensions required by GLFW
+                uint32_t glfw_ext_count = 0;
+                const char** glfw_exts;
+                glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+                for (uint32_t i = 0; i < glfw_ext_count; i++)
+                {
+                    extensions.emplace_back(glfw_exts[i]);
+                }
             }
 
             // debug utils extension
@@ -228,6 +270,12 @@ namespace beva_demo_00_first_triangle
 
     void App::create_surface()
     {
+        if (headless.has_value())
+        {
+            surface = bv::Surface::create_headless(context);
+            return;
+        }
+
         VkSurfaceKHR vk_surface;
         VkResult vk_result = glfwCreateWindowSurface(
             context->vk_instance(),
@@ -303,6 +351,22 @@ namespace beva_demo_00_first_triangle
             throw std::runtime_error("no supported physical devices");
         }
 
+        if (headless.has_value())
+        {
+            if (headless->physical_device_idx
+                >= supported_physical_devices.size())
+            {
+                throw std::runtime_error("invalid physical device index");
+            }
+            physical_device =
+                supported_physical_devices[headless->physical_device_idx];
+            std::cout << std::format(
+                "using physical device: {}\n\n",
+                physical_device->properties().device_name
+            );
+            return;
+        }
+
         std::cout << "pick a physical device by entering its index:\n";
         for (size_t i = 0; i < supported_physical_devices.size(); i++)
         {
@@ -399,6 +463,11 @@ namespace beva_demo_00_first_triangle
         mem_bank = bv::MemoryBank::create(device);
     }
 
+    void App::create_pipeline_cache()
+    {
+        pipeline_cache = bv::PipelineCache::load(device, PIPELINE_CACHE_PATH);
+    }
+
     void App::create_swapchain()
     {
         auto sc_support = physical_device->fetch_swapchain_support(surface);
@@ -430,7 +499,15 @@ namespace beva_demo_00_first_triangle
             || extent.height == std::numeric_limits<uint32_t>::max())
         {
             int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            if (headless.has_value())
+            {
+                width = (int)headless->width;
+                height = (int)headless->height;
+            }
+            else
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+            }
 
             extent = {
                 .width = (uint32_t)width,
@@ -459,6 +536,13 @@ namespace beva_demo_00_first_triangle
 
         auto pre_transform = sc_support->capabilities.current_transform;
 
+        // dumped frames are copied out of the swapchain images
+        VkImageUsageFlags image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (headless.has_value() && !headless->dump_path.empty())
+        {
+            image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         // create swapchain
         swapchain = bv::Swapchain::create(
             device,
@@ -470,7 +554,7 @@ namespace beva_demo_00_first_triangle
                 .image_color_space = surface_format.color_space,
                 .image_extent = extent,
                 .image_array_layers = 1,
-                .image_usage = { VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+                .image_usage = image_usage,
                 .image_sharing_mode = VK_SHARING_MODE_EXCLUSIVE,
                 .queue_family_indices = {},
                 .pre_transform = pre_transform,
@@ -710,7 +794,8 @@ namespace beva_demo_00_first_triangle
                 .render_pass = render_pass,
                 .subpass_index = 0,
                 .base_pipeline = std::nullopt
-            }
+            },
+            pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -807,30 +892,33 @@ namespace beva_demo_00_first_triangle
 
     void App::draw_frame()
     {
-        fences_in_flight[frame_idx]->wait();
+        {
+            beva_demos::ScopedTimer timer(stats.current().fence_wait_ms);
+            fences_in_flight[frame_idx]->wait();
+        }
 
         uint32_t img_idx;
         VkResult acquire_next_image_vk_result;
-        try
         {
-            img_idx = swapchain->acquire_next_image(
-                semaphs_image_available[frame_idx],
-                nullptr,
-                UINT64_MAX,
-                &acquire_next_image_vk_result
+            beva_demos::ScopedTimer timer(stats.current().acquire_ms);
+            acquire_next_image_vk_result = swapchain->try_acquire_next_image(
+                img_idx,
+                semaphs_image_available[frame_idx]
             );
         }
-        catch (const bv::Error& e)
+        if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
-            {
-                recreate_swapchain();
-                return;
-            }
-            else
-            {
-                throw e;
-            }
+            recreate_swapchain();
+            return;
+        }
+        else if (acquire_next_image_vk_result != VK_SUCCESS
+            && acquire_next_image_vk_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw bv::Error(
+                "failed to acquire next swapchain image",
+                acquire_next_image_vk_result,
+                false
+            );
         }
 
         fences_in_flight[frame_idx]->reset();
@@ -846,23 +934,36 @@ namespace beva_demo_00_first_triangle
             fences_in_flight[frame_idx]
         );
 
+        if (dump_frame)
+        {
+            fences_in_flight[frame_idx]->wait();
+            beva_demos::dump_swapchain_image(
+                device,
+                mem_bank,
+                graphics_present_queue,
+                swapchain->images()[img_idx],
+                headless->dump_path
+            );
+        }
+
         VkResult present_vk_result;
-        try
         {
-            graphics_present_queue->present(
-                { semaphs_render_finished[frame_idx] },
+            beva_demos::ScopedTimer timer(stats.current().present_ms);
+            present_vk_result = graphics_present_queue->try_present(
+                std::span(&semaphs_render_finished[frame_idx], 1),
                 swapchain,
-                img_idx,
-                &present_vk_result
+                img_idx
             );
         }
-        catch (const bv::Error& e)
+        if (present_vk_result != VK_SUCCESS
+            && present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
+            && present_vk_result != VK_SUBOPTIMAL_KHR)
         {
-            if (present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
-                && present_vk_result != VK_SUBOPTIMAL_KHR)
-            {
-                throw e;
-            }
+            throw bv::Error(
+                "failed to queue image for presentation",
+                present_vk_result,
+                false
+            );
         }
         if (present_vk_result == VK_ERROR_OUT_OF_DATE_KHR
             || present_vk_result == VK_SUBOPTIMAL_KHR
@@ -884,12 +985,15 @@ namespace beva_demo_00_first_triangle
 
     void App::recreate_swapchain()
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0)
+        if (!headless.has_value())
         {
+            int width = 0, height = 0;
             glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
+            while (width == 0 || height == 0)
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+                glfwWaitEvents();
+            }
         }
 
         device->wait_idle();
@@ -984,7 +1088,7 @@ namespace beva_demo_00_first_triangle
             .dstOffset = 0,
             .size = size
         };
-        vkCmdCopyBuffer(
+        cmd_buf->dispatch().vkCmdCopyBuffer(
             cmd_buf->handle(),
             src->handle(),
             dst->handle(),
@@ -1015,13 +1119,13 @@ namespace beva_demo_00_first_triangle
             .clearValueCount = 1,
             .pClearValues = &clear_val
         };
-        vkCmdBeginRenderPass(
+        cmd_buf->dispatch().vkCmdBeginRenderPass(
             cmd_buf->handle(),
             &render_pass_info,
             VK_SUBPASS_CONTENTS_INLINE
         );
 
-        vkCmdBindPipeline(
+        cmd_buf->dispatch().vkCmdBindPipeline(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             graphics_pipeline->handle()
@@ -1029,7 +1133,7 @@ namespace beva_demo_00_first_triangle
 
         VkBuffer vk_vertex_bufs[] = { vertex_buf->handle() };
         VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
             cmd_buf->handle(),
             0,
             1,
@@ -1045,15 +1149,20 @@ namespace beva_demo_00_first_triangle
             .minDepth = 0.f,
             .maxDepth = 1.f
         };
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
+        cmd_buf->dispatch().vkCmdSetViewport(
+            cmd_buf->handle(),
+            0,
+            1,
+            &viewport
+        );
 
         VkRect2D scissor{
             .offset = { 0, 0 },
             .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
         };
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
+        cmd_buf->dispatch().vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
 
-        vkCmdDraw(
+        cmd_buf->dispatch().vkCmdDraw(
             cmd_buf->handle(),
             (uint32_t)(vertices.size()),
             1,
@@ -1061,7 +1170,7 @@ namespace beva_demo_00_first_triangle
             0
         );
 
-        vkCmdEndRenderPass(cmd_buf->handle());
+        cmd_buf->dispatch().vkCmdEndRenderPass(cmd_buf->handle());
 
         cmd_buf->end();
     }
@@ -10,6 +10,9 @@
 
 #include "beva/beva.hpp"
 
+#include "headless.hpp"
+#include "frame_stats.hpp"
+
 #define GLM_FORCE_RADIANS
 #include "glm/glm.hpp"
 
@@ -28,8 +31,18 @@ namespace beva_demo_00_first_triangle
     {
     public:
         App() = default;
+
+        // run without a window, see beva_demos::HeadlessConfig
+        App(const beva_demos::HeadlessConfig& headless_config);
+
         void run();
 
+        // only recorded in headless mode
+        constexpr const beva_demos::FrameStats& frame_stats() const
+        {
+            return stats;
+        }
+
     private:
         static constexpr const char* TITLE = "beva demo: first triangle";
         static constexpr int INITIAL_WIDTH = 960;
@@ -38,6 +51,11 @@ namespace beva_demo_00_first_triangle
         static constexpr bool DEBUG_MODE = true;
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
+        // loaded at startup and saved at exit so that pipelines don't
+        // have to be compiled from scratch every time
+        static constexpr const char* PIPELINE_CACHE_PATH =
+            "pipeline_cache_00.bin";
+
         void init();
         void main_loop();
         void cleanup();
@@ -51,6 +69,7 @@ namespace beva_demo_00_first_triangle
         bv::DevicePtr device = nullptr;
         bv::QueuePtr graphics_present_queue = nullptr;
         bv::MemoryBankPtr mem_bank = nullptr;
+        bv::PipelineCachePtr pipeline_cache = nullptr;
         bv::SwapchainPtr swapchain = nullptr;
         std::vector<bv::ImageViewPtr> swapchain_imgviews;
         bv::RenderPassPtr render_pass = nullptr;
@@ -73,6 +92,13 @@ namespace beva_demo_00_first_triangle
         uint32_t graphics_present_family_idx = 0;
 
         bool framebuf_resized = false;
+
+        std::optional<beva_demos::HeadlessConfig> headless;
+
+        // whether draw_frame() should dump the frame it renders
+        bool dump_frame = false;
+
+        beva_demos::FrameStats stats;
         uint32_t frame_idx = 0;
 
         void init_window();
@@ -82,6 +108,7 @@ namespace beva_demo_00_first_triangle
         void pick_physical_device();
         void create_logical_device();
         void create_memory_bank();
+        void create_pipeline_cache();
         void create_swapchain();
         void create_render_pass();
         void create_swapchain_framebuffers();
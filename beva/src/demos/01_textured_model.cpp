@@ -84,6 +84,10 @@ namespace beva_demo_01_textured_model
         { .pos_offset = { -.5f, 0.f, 0.f }, .col = { 1.f, .8f, .7f } }
     };
 
+    App::App(const beva_demos::HeadlessConfig& headless_config)
+        : headless(headless_config)
+    {}
+
     void App::run()
     {
         try
@@ -109,6 +113,7 @@ namespace beva_demo_01_textured_model
         pick_physical_device();
         create_logical_device();
         create_memory_bank();
+        create_pipeline_cache();
         create_swapchain();
         create_render_pass();
         create_descriptor_set_layout();
@@ -133,6 +138,26 @@ namespace beva_demo_01_textured_model
     void App::main_loop()
     {
         start_time = std::chrono::high_resolution_clock::now();
+
+        if (headless.has_value())
+        {
+            stats.reserve(headless->n_frames);
+            for (uint64_t i = 0; i < headless->n_frames; i++)
+            {
+                stats.begin_frame();
+
+                headless_scene_time = (float)i * headless->time_step;
+                dump_frame =
+                    i + 1 == headless->n_frames
+                    && !headless->dump_path.empty();
+                draw_frame();
+
+                stats.end_frame();
+            }
+            device->wait_idle();
+            return;
+        }
+
         while (true)
         {
             glfwPollEvents();
@@ -186,18 +211,29 @@ namespace beva_demo_01_textured_model
 
         render_pass = nullptr;
 
+        pipeline_cache->save(PIPELINE_CACHE_PATH);
+        pipeline_cache = nullptr;
+
         mem_bank = nullptr;
         device = nullptr;
         surface = nullptr;
         debug_messenger = nullptr;
         context = nullptr;
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (!headless.has_value())
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void App::init_window()
     {
+        if (headless.has_value())
+        {
+            return;
+        }
+
         glfwSetErrorCallback(glfw_error_callback);
 
         if (!glfwInit())
@@ -236,13 +272,21 @@ namespace beva_demo_01_textured_model
 
         std::vector<std::string> extensions;
         {
-            // extensions required by GLFW
-            uint32_t glfw_ext_count = 0;
-            const char** glfw_exts;
-            glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
-            for (uint32_t i = 0; i < glfw_ext_count; i++)
+            if (headless.has_value())
             {
-                extensions.emplace_back(glfw_exts[i]);
+                // extensions required for headless surfaces
+                extensions = beva_demos::headless_instance_extensions();
+            }
+            else
+            {
+                // extensions required by GLFW
+                uint32_t glfw_ext_count = 0;
+                const char** glfw_exts;
+                glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+                for (uint32_t i = 0; i < glfw_ext_count; i++)
+                {
+                    extensions.emplace_back(glfw_exts[i]);
+                }
             }
 
             // debug utils extension
@@ -298,6 +342,12 @@ namespace beva_demo_01_textured_model
 
     void App::create_surface()
     {
+        if (headless.has_value())
+        {
+            surface = bv::Surface::create_headless(context);
+            return;
+        }
+
         VkSurfaceKHR vk_surface;
         VkResult vk_result = glfwCreateWindowSurface(
             context->vk_instance(),
@@ -373,6 +423,22 @@ namespace beva_demo_01_textured_model
             throw std::runtime_error("no supported physical devices");
         }
 
+        if (headless.has_value())
+        {
+            if (headless->physical_device_idx
+                >= supported_physical_devices.size())
+            {
+                throw std::runtime_error("invalid physical device index");
+            }
+            physical_device =
+                supported_physical_devices[headless->physical_device_idx];
+            std::cout << std::format(
+                "using physical device: {}\n\n",
+                physical_device->properties().device_name
+            );
+            return;
+        }
+
         std::cout << "pick a physical device by entering its index:\n";
         for (size_t i = 0; i < supported_physical_devices.size(); i++)
         {
@@ -472,6 +538,11 @@ namespace beva_demo_01_textured_model
         mem_bank = bv::MemoryBank::create(device);
     }
 
+    void App::create_pipeline_cache()
+    {
+        pipeline_cache = bv::PipelineCache::load(device, PIPELINE_CACHE_PATH);
+    }
+
     void App::create_swapchain()
     {
         auto sc_support = physical_device->fetch_swapchain_support(surface);
@@ -503,7 +574,15 @@ namespace beva_demo_01_textured_model
             || extent.height == std::numeric_limits<uint32_t>::max())
         {
             int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            if (headless.has_value())
+            {
+                width = (int)headless->width;
+                height = (int)headless->height;
+            }
+            else
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+            }
 
             extent = {
                 .width = (uint32_t)width,
@@ -532,6 +611,13 @@ namespace beva_demo_01_textured_model
 
         auto pre_transform = sc_support->capabilities.current_transform;
 
+        // dumped frames are copied out of the swapchain images
+        VkImageUsageFlags image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (headless.has_value() && !headless->dump_path.empty())
+        {
+            image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         // create swapchain
         swapchain = bv::Swapchain::create(
             device,
@@ -543,7 +629,7 @@ namespace beva_demo_01_textured_model
                 .image_color_space = surface_format.color_space,
                 .image_extent = extent,
                 .image_array_layers = 1,
-                .image_usage = { VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+                .image_usage = image_usage,
                 .image_sharing_mode = VK_SHARING_MODE_EXCLUSIVE,
                 .queue_family_indices = {},
                 .pre_transform = pre_transform,
@@ -854,7 +940,8 @@ namespace beva_demo_01_textured_model
                 .render_pass = render_pass,
                 .subpass_index = 0,
                 .base_pipeline = std::nullopt
-            }
+            },
+            pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -1425,35 +1512,40 @@ namespace beva_demo_01_textured_model
 
     void App::draw_frame()
     {
-        fences_in_flight[frame_idx]->wait();
+        {
+            beva_demos::ScopedTimer timer(stats.current().fence_wait_ms);
+            fences_in_flight[frame_idx]->wait();
+        }
 
         uint32_t img_idx;
         VkResult acquire_next_image_vk_result;
-        try
         {
-            img_idx = swapchain->acquire_next_image(
-                semaphs_image_available[frame_idx],
-                nullptr,
-                UINT64_MAX,
-                &acquire_next_image_vk_result
+            beva_demos::ScopedTimer timer(stats.current().acquire_ms);
+            acquire_next_image_vk_result = swapchain->try_acquire_next_image(
+                img_idx,
+                semaphs_image_available[frame_idx]
             );
         }
-        catch (const bv::Error& e)
+        if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
-            {
-                recreate_swapchain();
-                return;
-            }
-            else
-            {
-                throw e;
-            }
+            recreate_swapchain();
+            return;
+        }
+        else if (acquire_next_image_vk_result != VK_SUCCESS
+            && acquire_next_image_vk_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw bv::Error(
+                "failed to acquire next swapchain image",
+                acquire_next_image_vk_result,
+                false
+            );
         }
 
         const auto curr_time = std::chrono::high_resolution_clock::now();
         const float elapsed =
-            std::chrono::duration<float>(curr_time - start_time).count();
+            headless.has_value()
+            ? headless_scene_time
+            : std::chrono::duration<float>(curr_time - start_time).count();
 
         update_uniform_buffer(frame_idx, elapsed);
 
@@ -1470,23 +1562,36 @@ namespace beva_demo_01_textured_model
             fences_in_flight[frame_idx]
         );
 
+        if (dump_frame)
+        {
+            fences_in_flight[frame_idx]->wait();
+            beva_demos::dump_swapchain_image(
+                device,
+                mem_bank,
+                graphics_present_queue,
+                swapchain->images()[img_idx],
+                headless->dump_path
+            );
+        }
+
         VkResult present_vk_result;
-        try
         {
-            graphics_present_queue->present(
-                { semaphs_render_finished[frame_idx] },
+            beva_demos::ScopedTimer timer(stats.current().present_ms);
+            present_vk_result = graphics_present_queue->try_present(
+                std::span(&semaphs_render_finished[frame_idx], 1),
                 swapchain,
-                img_idx,
-                &present_vk_result
+                img_idx
             );
         }
-        catch (const bv::Error& e)
+        if (present_vk_result != VK_SUCCESS
+            && present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
+            && present_vk_result != VK_SUBOPTIMAL_KHR)
         {
-            if (present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
-                && present_vk_result != VK_SUBOPTIMAL_KHR)
-            {
-                throw e;
-            }
+            throw bv::Error(
+                "failed to queue image for presentation",
+                present_vk_result,
+                false
+            );
         }
         if (present_vk_result == VK_ERROR_OUT_OF_DATE_KHR
             || present_vk_result == VK_SUBOPTIMAL_KHR
@@ -1517,12 +1622,15 @@ namespace beva_demo_01_textured_model
 
     void App::recreate_swapchain()
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0)
+        if (!headless.has_value())
         {
+            int width = 0, height = 0;
             glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
+            while (width == 0 || height == 0)
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+                glfwWaitEvents();
+            }
         }
 
         device->wait_idle();
@@ -1739,7 +1847,7 @@ namespace beva_demo_01_textured_model
         }
         };
 
-        vkCmdPipelineBarrier(
+        cmd_buf->dispatch().vkCmdPipelineBarrier(
             cmd_buf->handle(),
             src_stage,
             dst_stage,
@@ -1772,7 +1880,7 @@ namespace beva_demo_01_textured_model
             .imageExtent = { width, height, 1 }
         };
 
-        vkCmdCopyBufferToImage(
+        cmd_buf->dispatch().vkCmdCopyBufferToImage(
             cmd_buf->handle(),
             buffer->handle(),
             image->handle(),
@@ -1831,7 +1939,7 @@ namespace beva_demo_01_textured_model
             barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
             barrier.subresourceRange.baseMipLevel = i - 1;
-            vkCmdPipelineBarrier(
+            cmd_buf->dispatch().vkCmdPipelineBarrier(
                 cmd_buf->handle(),
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -1858,7 +1966,7 @@ namespace beva_demo_01_textured_model
                 mip_height > 1 ? mip_height / 2 : 1,
                 1
             };
-            vkCmdBlitImage(
+            cmd_buf->dispatch().vkCmdBlitImage(
                 cmd_buf->handle(),
                 image->handle(),
                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -1874,7 +1982,7 @@ namespace beva_demo_01_textured_model
             barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
             barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
             barrier.subresourceRange.baseMipLevel = i - 1;
-            vkCmdPipelineBarrier(
+            cmd_buf->dispatch().vkCmdPipelineBarrier(
                 cmd_buf->handle(),
                 VK_PIPELINE_STAGE_TRANSFER_BIT,
 
@@ -1897,7 +2005,7 @@ namespace beva_demo_01_textured_model
         barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         barrier.subresourceRange.baseMipLevel = mip_levels - 1;
-        vkCmdPipelineBarrier(
+        cmd_buf->dispatch().vkCmdPipelineBarrier(
             cmd_buf->handle(),
             VK_PIPELINE_STAGE_TRANSFER_BIT,
 
@@ -1978,7 +2086,7 @@ namespace beva_demo_01_textured_model
             .dstOffset = 0,
             .size = size
         };
-        vkCmdCopyBuffer(
+        cmd_buf->dispatch().vkCmdCopyBuffer(
             cmd_buf->handle(),
             src->handle(),
             dst->handle(),
@@ -2011,13 +2119,13 @@ namespace beva_demo_01_textured_model
             .clearValueCount = (uint32_t)clear_vals.size(),
             .pClearValues = clear_vals.data()
         };
-        vkCmdBeginRenderPass(
+        cmd_buf->dispatch().vkCmdBeginRenderPass(
             cmd_buf->handle(),
             &render_pass_info,
             VK_SUBPASS_CONTENTS_INLINE
         );
 
-        vkCmdBindPipeline(
+        cmd_buf->dispatch().vkCmdBindPipeline(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             graphics_pipeline->handle()
@@ -2028,7 +2136,7 @@ namespace beva_demo_01_textured_model
             instance_buf->handle()
         };
         VkDeviceSize offsets[] = { 0, 0 };
-        vkCmdBindVertexBuffers(
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
             cmd_buf->handle(),
             0,
             2,
@@ -2036,7 +2144,7 @@ namespace beva_demo_01_textured_model
             offsets
         );
 
-        vkCmdBindIndexBuffer(
+        cmd_buf->dispatch().vkCmdBindIndexBuffer(
             cmd_buf->handle(),
             index_buf->handle(),
             0,
@@ -2051,16 +2159,21 @@ namespace beva_demo_01_textured_model
             .minDepth = 0.f,
             .maxDepth = 1.f
         };
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
+        cmd_buf->dispatch().vkCmdSetViewport(
+            cmd_buf->handle(),
+            0,
+            1,
+            &viewport
+        );
 
         VkRect2D scissor{
             .offset = { 0, 0 },
             .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
         };
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
+        cmd_buf->dispatch().vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
 
         auto vk_descriptor_set = descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipeline_layout->handle(),
@@ -2073,7 +2186,7 @@ namespace beva_demo_01_textured_model
 
         int32_t frag_push_constant_enable_tint =
             (std::fmod(elapsed, 2.f) > 1.f) ? 1 : 0;
-        vkCmdPushConstants(
+        cmd_buf->dispatch().vkCmdPushConstants(
             cmd_buf->handle(),
             pipeline_layout->handle(),
             VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -2082,7 +2195,7 @@ namespace beva_demo_01_textured_model
             &frag_push_constant_enable_tint
         );
 
-        vkCmdDrawIndexed(
+        cmd_buf->dispatch().vkCmdDrawIndexed(
             cmd_buf->handle(),
             (uint32_t)(indices.size()),
             (uint32_t)(instances.size()),
@@ -2091,7 +2204,7 @@ namespace beva_demo_01_textured_model
             0
         );
 
-        vkCmdEndRenderPass(cmd_buf->handle());
+        cmd_buf->dispatch().vkCmdEndRenderPass(cmd_buf->handle());
 
         cmd_buf->end();
     }
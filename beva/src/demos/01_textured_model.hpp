@@ -12,6 +12,9 @@
 
 #include "beva/beva.hpp"
 
+#include "headless.hpp"
+#include "frame_stats.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_ENABLE_EXPERIMENTAL
@@ -65,8 +68,18 @@ namespace beva_demo_01_textured_model
     {
     public:
         App() = default;
+
+        // run without a window, see beva_demos::HeadlessConfig
+        App(const beva_demos::HeadlessConfig& headless_config);
+
         void run();
 
+        // only recorded in headless mode
+        constexpr const beva_demos::FrameStats& frame_stats() const
+        {
+            return stats;
+        }
+
     private:
         static constexpr const char* TITLE =
             "beva demo: textured model (baked lighting)";
@@ -76,6 +89,11 @@ namespace beva_demo_01_textured_model
         static constexpr bool DEBUG_MODE = true;
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
+        // loaded at startup and saved at exit so that pipelines don't
+        // have to be compiled from scratch every time
+        static constexpr const char* PIPELINE_CACHE_PATH =
+            "pipeline_cache_01.bin";
+
         static constexpr const char* MODEL_PATH =
             "./models/korean_public_payphone_01.obj";
         static constexpr const char* TEXTURE_PATH
@@ -96,6 +114,7 @@ namespace beva_demo_01_textured_model
         bv::DevicePtr device = nullptr;
         bv::QueuePtr graphics_present_queue = nullptr;
         bv::MemoryBankPtr mem_bank = nullptr;
+        bv::PipelineCachePtr pipeline_cache = nullptr;
         bv::SwapchainPtr swapchain = nullptr;
         std::vector<bv::ImageViewPtr> swapchain_imgviews;
         bv::RenderPassPtr render_pass = nullptr;
@@ -150,6 +169,14 @@ namespace beva_demo_01_textured_model
         uint32_t graphics_present_family_idx = 0;
 
         bool framebuf_resized = false;
+
+        std::optional<beva_demos::HeadlessConfig> headless;
+
+        // whether draw_frame() should dump the frame it renders
+        bool dump_frame = false;
+
+        beva_demos::FrameStats stats;
+        float headless_scene_time = 0.f;
         uint32_t frame_idx = 0;
 
         VkSampleCountFlagBits msaa_samples = VK_SAMPLE_COUNT_1_BIT;
@@ -163,6 +190,7 @@ namespace beva_demo_01_textured_model
         void pick_physical_device();
         void create_logical_device();
         void create_memory_bank();
+        void create_pipeline_cache();
         void create_swapchain();
         void create_render_pass();
         void create_descriptor_set_layout();
@@ -23,6 +23,16 @@ namespace beva_demo_02_compute_shader
         int height
     );
 
+    // barrier for a color image that always stays in
+    // VK_IMAGE_LAYOUT_GENERAL
+    static bv::ImageMemoryBarrier general_image_barrier(
+        const bv::ImagePtr& image,
+        VkAccessFlags src_access_mask,
+        VkAccessFlags dst_access_mask,
+        uint32_t src_queue_family_index = VK_QUEUE_FAMILY_IGNORED,
+        uint32_t dst_queue_family_index = VK_QUEUE_FAMILY_IGNORED
+    );
+
     const bv::VertexInputBindingDescription Vertex::binding{
         .binding = 0,
         .stride = sizeof(Vertex),
@@ -55,6 +65,10 @@ namespace beva_demo_02_compute_shader
         { .pos = { -1.f, -1.f }, .texcoord = { 0.f, 0.f } } // tl
     };
 
+    App::App(const beva_demos::HeadlessConfig& headless_config)
+        : headless(headless_config)
+    {}
+
     void App::run()
     {
         try
@@ -84,6 +98,7 @@ namespace beva_demo_02_compute_shader
         pick_physical_device();
         create_logical_device();
         create_memory_bank();
+        create_pipeline_cache();
         create_swapchain();
 
         create_render_pass();
@@ -91,7 +106,6 @@ namespace beva_demo_02_compute_shader
         create_graphics_pipeline();
 
         create_compute_descriptor_set_layout();
-        create_compute_pipeline();
 
         create_command_pools();
         create_swapchain_framebuffers();
@@ -104,6 +118,9 @@ namespace beva_demo_02_compute_shader
         create_compute_descriptor_pool();
         create_compute_descriptor_sets();
 
+        // after the resources it's tuned on
+        create_compute_pipeline();
+
         create_command_buffers();
         create_sync_objects();
     }
@@ -111,6 +128,25 @@ namespace beva_demo_02_compute_shader
     void App::main_loop()
     {
         start_time = std::chrono::high_resolution_clock::now();
+
+        if (headless.has_value())
+        {
+            stats.reserve(headless->n_frames);
+            for (uint64_t i = 0; i < headless->n_frames; i++)
+            {
+                stats.begin_frame();
+
+                dump_frame =
+                    i + 1 == headless->n_frames
+                    && !headless->dump_path.empty();
+                draw_frame();
+
+                stats.end_frame();
+            }
+            device->wait_idle();
+            return;
+        }
+
         while (true)
         {
             glfwPollEvents();
@@ -126,10 +162,15 @@ namespace beva_demo_02_compute_shader
 
     void App::cleanup()
     {
+        bv::clear(semaphs_display_released);
+        bv::clear(semaphs_sim_finished);
         bv::clear(fences_in_flight);
         bv::clear(semaphs_render_finished);
         bv::clear(semaphs_image_available);
 
+        bv::clear(compute_cmd_bufs);
+        bv::clear(cmd_bufs);
+
         compute_descriptor_pool = nullptr;
         graphics_descriptor_pool = nullptr;
 
@@ -140,8 +181,13 @@ namespace beva_demo_02_compute_shader
         bv::clear(storage_imgs);
         bv::clear(storage_imgs_mem);
 
+        bv::clear(display_imgviews);
+        bv::clear(display_imgs);
+        bv::clear(display_imgs_mem);
+
         cleanup_swapchain();
 
+        compute_cmd_pool = nullptr;
         transient_cmd_pool = nullptr;
         cmd_pool = nullptr;
 
@@ -155,18 +201,29 @@ namespace beva_demo_02_compute_shader
 
         render_pass = nullptr;
 
+        pipeline_cache->save(PIPELINE_CACHE_PATH);
+        pipeline_cache = nullptr;
+
         mem_bank = nullptr;
         device = nullptr;
         surface = nullptr;
         debug_messenger = nullptr;
         context = nullptr;
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (!headless.has_value())
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void App::init_window()
     {
+        if (headless.has_value())
+        {
+            return;
+        }
+
         glfwSetErrorCallback(glfw_error_callback);
 
         if (!glfwInit())
@@ -205,13 +262,21 @@ namespace beva_demo_02_compute_shader
 
         std::vector<std::string> extensions;
         {
-            // extensions required by GLFW
-            uint32_t glfw_ext_count = 0;
-            const char** glfw_exts;
-            glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
-            for (uint32_t i = 0; i < glfw_ext_count; i++)
+            if (headless.has_value())
             {
-                extensions.emplace_back(glfw_exts[i]);
+                // extensions required for headless surfaces
+                extensions = beva_demos::headless_instance_extensions();
+            }
+            else
+            {
+                // extensions required by GLFW
+                uint32_t glfw_ext_count = 0;
+                const char** glfw_exts;
+                glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+                for (uint32_t i = 0; i < glfw_ext_count; i++)
+                {
+                    extensions.emplace_back(glfw_exts[i]);
+                }
             }
 
             // debug utils extension
@@ -267,6 +332,12 @@ namespace beva_demo_02_compute_shader
 
     void App::create_surface()
     {
+        if (headless.has_value())
+        {
+            surface = bv::Surface::create_headless(context);
+            return;
+        }
+
         VkSurfaceKHR vk_surface;
         VkResult vk_result = glfwCreateWindowSurface(
             context->vk_instance(),
@@ -346,6 +417,35 @@ namespace beva_demo_02_compute_shader
             throw std::runtime_error("no supported physical devices");
         }
 
+        if (headless.has_value())
+        {
+            if (headless->physical_device_idx
+                >= supported_physical_devices.size())
+            {
+                throw std::runtime_error("invalid physical device index");
+            }
+            physical_device =
+                supported_physical_devices[headless->physical_device_idx];
+            std::cout << std::format(
+                "using physical device: {}\n\n",
+                physical_device->properties().device_name
+            );
+
+            async_compute = headless->async_compute;
+            if (async_compute
+                && physical_device->find_queue_family_indices(
+                    VK_QUEUE_COMPUTE_BIT,
+                    VK_QUEUE_GRAPHICS_BIT
+                ).empty())
+            {
+                std::cout <<
+                    "no dedicated compute queue family, the simulation will "
+                    "run on the graphics queue\n\n";
+                async_compute = false;
+            }
+            return;
+        }
+
         std::cout << "pick a physical device by entering its index:\n";
         for (size_t i = 0; i < supported_physical_devices.size(); i++)
         {
@@ -401,6 +501,35 @@ namespace beva_demo_02_compute_shader
 
         physical_device = supported_physical_devices[idx];
 
+        // async compute needs a queue family with compute but no graphics
+        if (physical_device->find_queue_family_indices(
+            VK_QUEUE_COMPUTE_BIT,
+            VK_QUEUE_GRAPHICS_BIT
+        ).empty())
+        {
+            std::cout <<
+                "no dedicated compute queue family, the simulation will run "
+                "on the graphics queue\n\n";
+        }
+        else
+        {
+            std::cout <<
+                "run the simulation on a dedicated compute queue (async "
+                "compute)? [y/n]\n";
+            while (true)
+            {
+                std::string s_answer;
+                std::getline(std::cin, s_answer);
+                if (s_answer == "y" || s_answer == "n")
+                {
+                    async_compute = s_answer == "y";
+                    break;
+                }
+                std::cout << "enter y or n\n";
+            }
+            std::cout << '\n';
+        }
+
         glfwShowWindow(window);
     }
 
@@ -423,6 +552,16 @@ namespace beva_demo_02_compute_shader
             presentation_family_idx
         };
 
+        if (async_compute)
+        {
+            compute_family_idx =
+                physical_device->find_first_queue_family_index(
+                    VK_QUEUE_COMPUTE_BIT,
+                    VK_QUEUE_GRAPHICS_BIT
+                );
+            unique_queue_family_indices.insert(compute_family_idx);
+        }
+
         std::vector<bv::QueueRequest> queue_requests;
         for (auto family_idx : unique_queue_family_indices)
         {
@@ -452,6 +591,12 @@ namespace beva_demo_02_compute_shader
 
         presentation_queue =
             bv::Device::retrieve_queue(device, presentation_family_idx, 0);
+
+        if (async_compute)
+        {
+            compute_queue =
+                bv::Device::retrieve_queue(device, compute_family_idx, 0);
+        }
     }
 
     void App::create_memory_bank()
@@ -459,6 +604,11 @@ namespace beva_demo_02_compute_shader
         mem_bank = bv::MemoryBank::create(device);
     }
 
+    void App::create_pipeline_cache()
+    {
+        pipeline_cache = bv::PipelineCache::load(device, PIPELINE_CACHE_PATH);
+    }
+
     void App::create_swapchain()
     {
         auto sc_support = physical_device->fetch_swapchain_support(surface);
@@ -490,7 +640,15 @@ namespace beva_demo_02_compute_shader
             || extent.height == std::numeric_limits<uint32_t>::max())
         {
             int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            if (headless.has_value())
+            {
+                width = (int)headless->width;
+                height = (int)headless->height;
+            }
+            else
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+            }
 
             extent = {
                 .width = (uint32_t)width,
@@ -534,6 +692,13 @@ namespace beva_demo_02_compute_shader
 
         auto pre_transform = sc_support->capabilities.current_transform;
 
+        // dumped frames are copied out of the swapchain images
+        VkImageUsageFlags image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (headless.has_value() && !headless->dump_path.empty())
+        {
+            image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         // create swapchain
         swapchain = bv::Swapchain::create(
             device,
@@ -545,7 +710,7 @@ namespace beva_demo_02_compute_shader
                 .image_color_space = surface_format.color_space,
                 .image_extent = extent,
                 .image_array_layers = 1,
-                .image_usage = { VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+                .image_usage = image_usage,
                 .image_sharing_mode = image_sharing_mode,
                 .queue_family_indices = queue_family_indices,
                 .pre_transform = pre_transform,
@@ -790,7 +955,8 @@ namespace beva_demo_02_compute_shader
                 .render_pass = render_pass,
                 .subpass_index = 0,
                 .base_pipeline = std::nullopt
-            }
+            },
+            pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -833,60 +999,6 @@ namespace beva_demo_02_compute_shader
             std::move(read_file("./shaders/demo_02_comp.spv"))
         );
 
-        std::vector<bv::SpecializationMapEntry> map_entries{
-            {
-                .constant_id = 0,
-                .offset = 0,
-                .size = 4
-            },
-            {
-                .constant_id = 1,
-                .offset = 4,
-                .size = 4
-            },
-            {
-                .constant_id = 2,
-                .offset = 8,
-                .size = 4
-            }
-        };
-
-        const auto& limits = physical_device->properties().limits;
-        compute_local_size = {
-            std::clamp(limits.max_compute_work_group_size[0], 1u, 64u),
-            std::clamp(limits.max_compute_work_group_size[1], 1u, 64u),
-            1
-        };
-        while (
-            compute_local_size.x
-            * compute_local_size.y
-            * compute_local_size.z > limits.max_compute_work_group_invocations)
-        {
-            compute_local_size.x = std::max(1u, compute_local_size.x / 2u);
-            compute_local_size.y = std::max(1u, compute_local_size.y / 2u);
-            compute_local_size.z = std::max(1u, compute_local_size.z / 2u);
-
-            if (limits.max_compute_work_group_invocations < 1) break;
-        }
-
-        bv::SpecializationInfo specialization_info{
-            .map_entries = map_entries,
-            .data = std::vector<uint8_t>(sizeof(compute_local_size))
-        };
-        std::copy(
-            &compute_local_size,
-            &compute_local_size + 1,
-            reinterpret_cast<glm::uvec3*>(specialization_info.data.data())
-        );
-
-        bv::ShaderStage shader_stage{
-            .flags = {},
-            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
-            .module = shader_module,
-            .entry_point = "main",
-            .specialization_info = specialization_info
-        };
-
         bv::PushConstantRange push_constants{
             .stage_flags = VK_SHADER_STAGE_COMPUTE_BIT,
             .offset = 0,
@@ -902,15 +1014,90 @@ namespace beva_demo_02_compute_shader
             }
         );
 
-        compute_pipeline = bv::ComputePipeline::create(
+        // the local size is measured the first time the demo runs on a
+        // device and loaded from the results file after that
+        auto tuner = bv::ComputeWorkgroupTuner::create(
             device,
+            WORKGROUP_TUNER_RESULTS_PATH
+        );
+
+        bv::ComputeWorkgroupTunerConfig tuner_config{
+            .name = std::format("wave simulation {}", SIM_RESOLUTION),
+            .stage = {
+                .flags = {},
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = shader_module,
+                .entry_point = "main",
+                .specialization_info = std::nullopt
+            },
+            .layout = compute_pipeline_layout
+        };
+
+        // the candidates run a full simulation step (global_frame_idx > 0)
+        // on the first pair of images. the first frame overwrites whatever
+        // they leave behind.
+        auto result = tuner->tune(
+            tuner_config,
+            async_compute ? compute_queue : graphics_compute_queue,
+            async_compute ? compute_cmd_pool : transient_cmd_pool,
+            [&](
+                const bv::CommandBufferPtr& cmd_buf,
+                const bv::ComputePipelinePtr& pipeline,
+                const std::array<uint32_t, 3>& local_size
+                )
             {
-                .flags = 0,
-                .stage = shader_stage,
-                .layout = compute_pipeline_layout,
-                .base_pipeline = std::nullopt
-            }
+                auto vk_descriptor_set = compute_descriptor_sets[0]->handle();
+                cmd_buf->dispatch().vkCmdBindDescriptorSets(
+                    cmd_buf->handle(),
+                    VK_PIPELINE_BIND_POINT_COMPUTE,
+                    compute_pipeline_layout->handle(),
+                    0,
+                    1,
+                    &vk_descriptor_set,
+                    0,
+                    0
+                );
+
+                ComputeShaderPushConstants tuning_push_constants{
+                    .emitter_icoord = { -1, -1 },
+                    .global_frame_idx = 1
+                };
+                cmd_buf->dispatch().vkCmdPushConstants(
+                    cmd_buf->handle(),
+                    compute_pipeline_layout->handle(),
+                    VK_SHADER_STAGE_COMPUTE_BIT,
+                    0,
+                    sizeof(tuning_push_constants),
+                    &tuning_push_constants
+                );
+
+                cmd_buf->dispatch().vkCmdDispatch(
+                    cmd_buf->handle(),
+                    IDIV_CEIL(SIM_RESOLUTION, local_size[0]),
+                    IDIV_CEIL(SIM_RESOLUTION, local_size[1]),
+                    1
+                );
+            },
+            pipeline_cache
         );
+        tuner->save();
+
+        compute_pipeline = result.pipeline;
+        compute_local_size = {
+            result.local_size[0],
+            result.local_size[1],
+            result.local_size[2]
+        };
+        if (result.measured)
+        {
+            std::cout << std::format(
+                "tuned compute local size: {}x{}x{} ({:.3f} ms per step)\n",
+                compute_local_size.x,
+                compute_local_size.y,
+                compute_local_size.z,
+                result.time_ms
+            );
+        }
 
         shader_module = nullptr;
     }
@@ -931,6 +1118,17 @@ namespace beva_demo_02_compute_shader
                 .queue_family_index = graphics_compute_family_idx
             }
         );
+
+        if (async_compute)
+        {
+            compute_cmd_pool = bv::CommandPool::create(
+                device,
+                {
+                    .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                    .queue_family_index = compute_family_idx
+                }
+            );
+        }
     }
 
     void App::create_swapchain_framebuffers()
@@ -958,7 +1156,30 @@ namespace beva_demo_02_compute_shader
         storage_imgs_mem.resize(MAX_FRAMES_IN_FLIGHT);
         storage_imgviews.resize(MAX_FRAMES_IN_FLIGHT);
 
-        auto cmd_buf = begin_single_time_commands(true);
+        if (async_compute)
+        {
+            display_imgs.resize(MAX_FRAMES_IN_FLIGHT);
+            display_imgs_mem.resize(MAX_FRAMES_IN_FLIGHT);
+            display_imgviews.resize(MAX_FRAMES_IN_FLIGHT);
+        }
+
+        // in async compute mode, the images start out owned by the compute
+        // queue family so the layout transitions happen there too
+        bv::CommandBufferPtr cmd_buf;
+        if (async_compute)
+        {
+            cmd_buf = bv::CommandPool::allocate_buffer(
+                compute_cmd_pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY
+            );
+            cmd_buf->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        }
+        else
+        {
+            cmd_buf = begin_single_time_commands(true);
+        }
+
+        std::vector<bv::ImageMemoryBarrier> barriers;
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
             create_image(
@@ -968,7 +1189,11 @@ namespace beva_demo_02_compute_shader
                 VK_SAMPLE_COUNT_1_BIT,
                 SIM_IMAGE_FORMAT,
                 VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_STORAGE_BIT,
+
+                async_compute
+                ? (VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                : VK_IMAGE_USAGE_STORAGE_BIT,
+
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 storage_imgs[i],
                 storage_imgs_mem[i]
@@ -979,37 +1204,55 @@ namespace beva_demo_02_compute_shader
                 VK_IMAGE_ASPECT_COLOR_BIT,
                 1
             );
+            barriers.push_back(general_image_barrier(storage_imgs[i], 0, 0));
+            barriers.back().old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-            // transition layout to general
-            VkImageMemoryBarrier barrier{
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .pNext = nullptr,
-                .srcAccessMask = 0,
-                .dstAccessMask = 0,
-                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = storage_imgs[i]->handle(),
-                .subresourceRange = VkImageSubresourceRange{
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1
+            if (!async_compute)
+            {
+                continue;
             }
-            };
-            vkCmdPipelineBarrier(
-                cmd_buf->handle(),
-                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier
+
+            create_image(
+                SIM_RESOLUTION,
+                SIM_RESOLUTION,
+                1,
+                VK_SAMPLE_COUNT_1_BIT,
+                SIM_IMAGE_FORMAT,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                display_imgs[i],
+                display_imgs_mem[i]
+            );
+            display_imgviews[i] = create_image_view(
+                display_imgs[i],
+                SIM_IMAGE_FORMAT,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                1
             );
+            barriers.push_back(general_image_barrier(display_imgs[i], 0, 0));
+            barriers.back().old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+
+        // transition layouts to general
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            0,
+            {},
+            barriers
+        );
+
+        if (async_compute)
+        {
+            cmd_buf->end();
+            compute_queue->submit({}, {}, { cmd_buf }, {});
+            compute_queue->wait_idle();
+        }
+        else
+        {
+            end_single_time_commands(cmd_buf);
         }
-        end_single_time_commands(cmd_buf);
     }
 
     void App::create_vertex_buffer()
@@ -1087,9 +1330,12 @@ namespace beva_demo_02_compute_shader
 
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
+            // in async compute mode, the fragment shader reads the copy
             bv::DescriptorImageInfo img_info{
                 .sampler = std::nullopt,
-                .image_view = storage_imgviews[i],
+                .image_view =
+                async_compute ? display_imgviews[i] : storage_imgviews[i],
+
                 .image_layout = VK_IMAGE_LAYOUT_GENERAL
             };
 
@@ -1187,6 +1433,15 @@ namespace beva_demo_02_compute_shader
             VK_COMMAND_BUFFER_LEVEL_PRIMARY,
             MAX_FRAMES_IN_FLIGHT
         );
+
+        if (async_compute)
+        {
+            compute_cmd_bufs = bv::CommandPool::allocate_buffers(
+                compute_cmd_pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                MAX_FRAMES_IN_FLIGHT
+            );
+        }
     }
 
     void App::create_sync_objects()
@@ -1203,35 +1458,46 @@ namespace beva_demo_02_compute_shader
                 device,
                 VK_FENCE_CREATE_SIGNALED_BIT
             ));
+
+            if (async_compute)
+            {
+                semaphs_sim_finished.push_back(bv::Semaphore::create(device));
+                semaphs_display_released.push_back(
+                    bv::Semaphore::create(device)
+                );
+            }
         }
     }
 
     void App::draw_frame()
     {
-        fences_in_flight[frame_idx]->wait();
+        {
+            beva_demos::ScopedTimer timer(stats.current().fence_wait_ms);
+            fences_in_flight[frame_idx]->wait();
+        }
 
         uint32_t img_idx;
         VkResult acquire_next_image_vk_result;
-        try
         {
-            img_idx = swapchain->acquire_next_image(
-                semaphs_image_available[frame_idx],
-                nullptr,
-                UINT64_MAX,
-                &acquire_next_image_vk_result
+            beva_demos::ScopedTimer timer(stats.current().acquire_ms);
+            acquire_next_image_vk_result = swapchain->try_acquire_next_image(
+                img_idx,
+                semaphs_image_available[frame_idx]
             );
         }
-        catch (const bv::Error& e)
+        if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
-            {
-                recreate_swapchain();
-                return;
-            }
-            else
-            {
-                throw e;
-            }
+            recreate_swapchain();
+            return;
+        }
+        else if (acquire_next_image_vk_result != VK_SUCCESS
+            && acquire_next_image_vk_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw bv::Error(
+                "failed to acquire next swapchain image",
+                acquire_next_image_vk_result,
+                false
+            );
         }
 
         const auto curr_time = std::chrono::high_resolution_clock::now();
@@ -1240,34 +1506,100 @@ namespace beva_demo_02_compute_shader
 
         fences_in_flight[frame_idx]->reset();
 
-        cmd_bufs[frame_idx]->reset(0);
-        record_command_buffer(cmd_bufs[frame_idx], img_idx, elapsed);
+        if (async_compute)
+        {
+            // the fence also covers the compute submission because the
+            // graphics submission waits for it
+            compute_cmd_bufs[frame_idx]->reset(0);
+            record_compute_command_buffer(compute_cmd_bufs[frame_idx]);
+
+            // the display image of this frame index was released by the
+            // graphics queue MAX_FRAMES_IN_FLIGHT frames ago
+            bool display_img_used_before =
+                global_frame_idx >= MAX_FRAMES_IN_FLIGHT;
+            if (display_img_used_before)
+            {
+                compute_queue->submit(
+                    { VK_PIPELINE_STAGE_TRANSFER_BIT },
+                    { semaphs_display_released[frame_idx] },
+                    { compute_cmd_bufs[frame_idx] },
+                    { semaphs_sim_finished[frame_idx] }
+                );
+            }
+            else
+            {
+                compute_queue->submit(
+                    {},
+                    {},
+                    { compute_cmd_bufs[frame_idx] },
+                    { semaphs_sim_finished[frame_idx] }
+                );
+            }
 
-        graphics_compute_queue->submit(
-            { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
-            { semaphs_image_available[frame_idx] },
-            { cmd_bufs[frame_idx] },
-            { semaphs_render_finished[frame_idx] },
-            fences_in_flight[frame_idx]
-        );
+            cmd_bufs[frame_idx]->reset(0);
+            record_graphics_command_buffer(cmd_bufs[frame_idx], img_idx);
 
-        VkResult present_vk_result;
-        try
+            graphics_compute_queue->submit(
+                {
+                    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+                },
+                {
+                    semaphs_image_available[frame_idx],
+                    semaphs_sim_finished[frame_idx]
+                },
+                { cmd_bufs[frame_idx] },
+                {
+                    semaphs_render_finished[frame_idx],
+                    semaphs_display_released[frame_idx]
+                },
+                fences_in_flight[frame_idx]
+            );
+        }
+        else
         {
-            presentation_queue->present(
+            cmd_bufs[frame_idx]->reset(0);
+            record_command_buffer(cmd_bufs[frame_idx], img_idx, elapsed);
+
+            graphics_compute_queue->submit(
+                { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
+                { semaphs_image_available[frame_idx] },
+                { cmd_bufs[frame_idx] },
                 { semaphs_render_finished[frame_idx] },
+                fences_in_flight[frame_idx]
+            );
+        }
+
+        if (dump_frame)
+        {
+            fences_in_flight[frame_idx]->wait();
+            beva_demos::dump_swapchain_image(
+                device,
+                mem_bank,
+                graphics_compute_queue,
+                swapchain->images()[img_idx],
+                headless->dump_path
+            );
+        }
+
+        VkResult present_vk_result;
+        {
+            beva_demos::ScopedTimer timer(stats.current().present_ms);
+            present_vk_result = presentation_queue->try_present(
+                std::span(&semaphs_render_finished[frame_idx], 1),
                 swapchain,
-                img_idx,
-                &present_vk_result
+                img_idx
             );
         }
-        catch (const bv::Error& e)
+        if (present_vk_result != VK_SUCCESS
+            && present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
+            && present_vk_result != VK_SUBOPTIMAL_KHR)
         {
-            if (present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
-                && present_vk_result != VK_SUBOPTIMAL_KHR)
-            {
-                throw e;
-            }
+            throw bv::Error(
+                "failed to queue image for presentation",
+                present_vk_result,
+                false
+            );
         }
         if (present_vk_result == VK_ERROR_OUT_OF_DATE_KHR
             || present_vk_result == VK_SUBOPTIMAL_KHR
@@ -1290,12 +1622,15 @@ namespace beva_demo_02_compute_shader
 
     void App::recreate_swapchain()
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0)
+        if (!headless.has_value())
         {
+            int width = 0, height = 0;
             glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
+            while (width == 0 || height == 0)
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+                glfwWaitEvents();
+            }
         }
 
         device->wait_idle();
@@ -1479,7 +1814,7 @@ namespace beva_demo_02_compute_shader
             .dstOffset = 0,
             .size = size
         };
-        vkCmdCopyBuffer(
+        cmd_buf->dispatch().vkCmdCopyBuffer(
             cmd_buf->handle(),
             src->handle(),
             dst->handle(),
@@ -1496,14 +1831,185 @@ namespace beva_demo_02_compute_shader
     {
         cmd_buf->begin(0);
 
-        vkCmdBindPipeline(
+        record_simulation_step(cmd_buf);
+
+        // make the new step visible to the fragment shader
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            {},
+            {
+                general_image_barrier(
+                    storage_imgs[frame_idx],
+                    VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_ACCESS_SHADER_READ_BIT
+                )
+            }
+        );
+
+        record_draw(cmd_buf, img_idx);
+
+        cmd_buf->end();
+    }
+
+    void App::record_compute_command_buffer(
+        const bv::CommandBufferPtr& cmd_buf
+    )
+    {
+        cmd_buf->begin(0);
+
+        record_simulation_step(cmd_buf);
+
+        // acquire the display image from the graphics queue family (unless
+        // this is its first use) and wait for the simulation step
+        std::vector<bv::ImageMemoryBarrier> barriers{
+            general_image_barrier(
+                storage_imgs[frame_idx],
+                VK_ACCESS_SHADER_WRITE_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT
+            )
+        };
+        if (global_frame_idx >= MAX_FRAMES_IN_FLIGHT)
+        {
+            barriers.push_back(general_image_barrier(
+                display_imgs[frame_idx],
+                0,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                graphics_compute_family_idx,
+                compute_family_idx
+            ));
+        }
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            {},
+            barriers
+        );
+
+        VkImageCopy region{
+            .srcSubresource = VkImageSubresourceLayers{
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .srcOffset = { 0, 0, 0 },
+            .dstSubresource = VkImageSubresourceLayers{
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .dstOffset = { 0, 0, 0 },
+            .extent = { SIM_RESOLUTION, SIM_RESOLUTION, 1 }
+        };
+        cmd_buf->dispatch().vkCmdCopyImage(
+            cmd_buf->handle(),
+            storage_imgs[frame_idx]->handle(),
+            VK_IMAGE_LAYOUT_GENERAL,
+            display_imgs[frame_idx]->handle(),
+            VK_IMAGE_LAYOUT_GENERAL,
+            1,
+            &region
+        );
+
+        // release the display image to the graphics queue family
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            {},
+            {
+                general_image_barrier(
+                    display_imgs[frame_idx],
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    0,
+                    compute_family_idx,
+                    graphics_compute_family_idx
+                )
+            }
+        );
+
+        cmd_buf->end();
+    }
+
+    void App::record_graphics_command_buffer(
+        const bv::CommandBufferPtr& cmd_buf,
+        uint32_t img_idx
+    )
+    {
+        cmd_buf->begin(0);
+
+        // acquire the display image from the compute queue family
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            {},
+            {
+                general_image_barrier(
+                    display_imgs[frame_idx],
+                    0,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    compute_family_idx,
+                    graphics_compute_family_idx
+                )
+            }
+        );
+
+        record_draw(cmd_buf, img_idx);
+
+        // release it back to the compute queue family
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            {},
+            {
+                general_image_barrier(
+                    display_imgs[frame_idx],
+                    0,
+                    0,
+                    graphics_compute_family_idx,
+                    compute_family_idx
+                )
+            }
+        );
+
+        cmd_buf->end();
+    }
+
+    void App::record_simulation_step(const bv::CommandBufferPtr& cmd_buf)
+    {
+        // wait for the last step to finish writing the input image and
+        // reading the output image
+        cmd_buf->pipeline_barrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            {},
+            {
+                general_image_barrier(
+                    storage_imgs[
+                        (frame_idx + MAX_FRAMES_IN_FLIGHT - 1)
+                            % MAX_FRAMES_IN_FLIGHT
+                    ],
+                    VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_ACCESS_SHADER_READ_BIT
+                )
+            }
+        );
+
+        cmd_buf->dispatch().vkCmdBindPipeline(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_COMPUTE,
             compute_pipeline->handle()
         );
 
         auto vk_descriptor_set = compute_descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_COMPUTE,
             compute_pipeline_layout->handle(),
@@ -1515,7 +2021,8 @@ namespace beva_demo_02_compute_shader
         );
 
         glm::ivec2 mouse_icoord{ -1, -1 };
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+        if (!headless.has_value()
+            && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
         {
             double xpos, ypos;
             glfwGetCursorPos(window, &xpos, &ypos);
@@ -1531,7 +2038,7 @@ namespace beva_demo_02_compute_shader
             .emitter_icoord = mouse_icoord,
             .global_frame_idx = (uint32_t)global_frame_idx
         };
-        vkCmdPushConstants(
+        cmd_buf->dispatch().vkCmdPushConstants(
             cmd_buf->handle(),
             compute_pipeline_layout->handle(),
             VK_SHADER_STAGE_COMPUTE_BIT,
@@ -1540,13 +2047,19 @@ namespace beva_demo_02_compute_shader
             &compute_push_constants
         );
 
-        vkCmdDispatch(
+        cmd_buf->dispatch().vkCmdDispatch(
             cmd_buf->handle(),
             IDIV_CEIL(SIM_RESOLUTION, compute_local_size.x),
             IDIV_CEIL(SIM_RESOLUTION, compute_local_size.y),
             1
         );
+    }
 
+    void App::record_draw(
+        const bv::CommandBufferPtr& cmd_buf,
+        uint32_t img_idx
+    )
+    {
         VkClearValue clear_val;
         clear_val.color = { { 0.f, 0.f, 0.f, 1.f } };
 
@@ -1562,13 +2075,13 @@ namespace beva_demo_02_compute_shader
             .clearValueCount = 1,
             .pClearValues = &clear_val
         };
-        vkCmdBeginRenderPass(
+        cmd_buf->dispatch().vkCmdBeginRenderPass(
             cmd_buf->handle(),
             &render_pass_info,
             VK_SUBPASS_CONTENTS_INLINE
         );
 
-        vkCmdBindPipeline(
+        cmd_buf->dispatch().vkCmdBindPipeline(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             graphics_pipeline->handle()
@@ -1576,7 +2089,7 @@ namespace beva_demo_02_compute_shader
 
         VkBuffer vk_vertex_buf = vertex_buf->handle();
         VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
             cmd_buf->handle(),
             0,
             1,
@@ -1592,16 +2105,22 @@ namespace beva_demo_02_compute_shader
             .minDepth = 0.f,
             .maxDepth = 1.f
         };
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
+        cmd_buf->dispatch().vkCmdSetViewport(
+            cmd_buf->handle(),
+            0,
+            1,
+            &viewport
+        );
 
         VkRect2D scissor{
             .offset = { 0, 0 },
             .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
         };
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
+        cmd_buf->dispatch().vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
 
-        vk_descriptor_set = graphics_descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
+        VkDescriptorSet vk_descriptor_set =
+            graphics_descriptor_sets[frame_idx]->handle();
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
             cmd_buf->handle(),
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             graphics_pipeline_layout->handle(),
@@ -1612,7 +2131,7 @@ namespace beva_demo_02_compute_shader
             nullptr
         );
 
-        vkCmdDraw(
+        cmd_buf->dispatch().vkCmdDraw(
             cmd_buf->handle(),
             (uint32_t)vertices.size(),
             1,
@@ -1620,9 +2139,7 @@ namespace beva_demo_02_compute_shader
             0
         );
 
-        vkCmdEndRenderPass(cmd_buf->handle());
-
-        cmd_buf->end();
+        cmd_buf->dispatch().vkCmdEndRenderPass(cmd_buf->handle());
     }
 
     static std::vector<uint8_t> read_file(const std::string& filename)
@@ -1652,6 +2169,32 @@ namespace beva_demo_02_compute_shader
         std::cerr << std::format("GLFW error {}: {}\n", error, description);
     }
 
+    static bv::ImageMemoryBarrier general_image_barrier(
+        const bv::ImagePtr& image,
+        VkAccessFlags src_access_mask,
+        VkAccessFlags dst_access_mask,
+        uint32_t src_queue_family_index,
+        uint32_t dst_queue_family_index
+    )
+    {
+        return bv::ImageMemoryBarrier{
+            .src_access_mask = src_access_mask,
+            .dst_access_mask = dst_access_mask,
+            .old_layout = VK_IMAGE_LAYOUT_GENERAL,
+            .new_layout = VK_IMAGE_LAYOUT_GENERAL,
+            .src_queue_family_index = src_queue_family_index,
+            .dst_queue_family_index = dst_queue_family_index,
+            .image = image,
+            .subresource_range = bv::ImageSubresourceRange{
+                .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .base_mip_level = 0,
+                .level_count = 1,
+                .base_array_layer = 0,
+                .layer_count = 1
+            }
+        };
+    }
+
     static void glfw_framebuf_resize_callback(
         GLFWwindow* window,
         int width,
@@ -11,6 +11,9 @@
 
 #include "beva/beva.hpp"
 
+#include "headless.hpp"
+#include "frame_stats.hpp"
+
 #define GLM_FORCE_RADIANS
 #include "glm/glm.hpp"
 
@@ -42,8 +45,18 @@ namespace beva_demo_02_compute_shader
     {
     public:
         App() = default;
+
+        // run without a window, see beva_demos::HeadlessConfig
+        App(const beva_demos::HeadlessConfig& headless_config);
+
         void run();
 
+        // only recorded in headless mode
+        constexpr const beva_demos::FrameStats& frame_stats() const
+        {
+            return stats;
+        }
+
     private:
         static constexpr const char* TITLE =
             "beva demo: wave simulation";
@@ -53,6 +66,16 @@ namespace beva_demo_02_compute_shader
         static constexpr bool DEBUG_MODE = true;
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
+        // loaded at startup and saved at exit so that pipelines don't
+        // have to be compiled from scratch every time
+        static constexpr const char* PIPELINE_CACHE_PATH =
+            "pipeline_cache_02.bin";
+
+        // the compute shader's local size picked by bv::ComputeWorkgroupTuner
+        // for each device the demo ran on
+        static constexpr const char* WORKGROUP_TUNER_RESULTS_PATH =
+            "workgroup_sizes_02.bin";
+
         static constexpr VkFormat SIM_IMAGE_FORMAT = VK_FORMAT_R32G32_SFLOAT;
         static constexpr uint32_t SIM_RESOLUTION = 240;
 
@@ -69,7 +92,12 @@ namespace beva_demo_02_compute_shader
         bv::DevicePtr device = nullptr;
         bv::QueuePtr graphics_compute_queue = nullptr;
         bv::QueuePtr presentation_queue = nullptr;
+
+        // only used in async compute mode
+        bv::QueuePtr compute_queue = nullptr;
+
         bv::MemoryBankPtr mem_bank = nullptr;
+        bv::PipelineCachePtr pipeline_cache = nullptr;
         bv::SwapchainPtr swapchain = nullptr;
         std::vector<bv::ImageViewPtr> swapchain_imgviews;
 
@@ -84,6 +112,7 @@ namespace beva_demo_02_compute_shader
 
         bv::CommandPoolPtr cmd_pool = nullptr;
         bv::CommandPoolPtr transient_cmd_pool = nullptr;
+        bv::CommandPoolPtr compute_cmd_pool = nullptr;
 
         std::vector<bv::FramebufferPtr> swapchain_framebufs;
 
@@ -91,6 +120,14 @@ namespace beva_demo_02_compute_shader
         std::vector<bv::MemoryChunkPtr> storage_imgs_mem;
         std::vector<bv::ImageViewPtr> storage_imgviews;
 
+        // in async compute mode, the storage images never leave the compute
+        // queue family. each step is copied to a display image whose
+        // ownership goes back and forth between the two families, so the
+        // next step can be simulated while the last one is being drawn.
+        std::vector<bv::ImagePtr> display_imgs;
+        std::vector<bv::MemoryChunkPtr> display_imgs_mem;
+        std::vector<bv::ImageViewPtr> display_imgviews;
+
         bv::BufferPtr vertex_buf = nullptr;
         bv::MemoryChunkPtr vertex_buf_mem = nullptr;
 
@@ -106,10 +143,26 @@ namespace beva_demo_02_compute_shader
         std::vector<bv::SemaphorePtr> semaphs_render_finished;
         std::vector<bv::FencePtr> fences_in_flight;
 
+        // "per frame" stuff only used in async compute mode
+        std::vector<bv::CommandBufferPtr> compute_cmd_bufs;
+        std::vector<bv::SemaphorePtr> semaphs_sim_finished;
+        std::vector<bv::SemaphorePtr> semaphs_display_released;
+
         uint32_t graphics_compute_family_idx = 0;
         uint32_t presentation_family_idx = 0;
+        uint32_t compute_family_idx = 0;
+
+        // run the simulation on a dedicated compute queue
+        bool async_compute = false;
 
         bool framebuf_resized = false;
+
+        std::optional<beva_demos::HeadlessConfig> headless;
+
+        // whether draw_frame() should dump the frame it renders
+        bool dump_frame = false;
+
+        beva_demos::FrameStats stats;
         uint32_t frame_idx = 0;
         uint64_t global_frame_idx = 0;
 
@@ -124,6 +177,7 @@ namespace beva_demo_02_compute_shader
         void pick_physical_device();
         void create_logical_device();
         void create_memory_bank();
+        void create_pipeline_cache();
         void create_swapchain();
 
         void create_render_pass();
@@ -218,6 +272,17 @@ namespace beva_demo_02_compute_shader
             float elapsed
         );
 
+        // async compute mode
+        void record_compute_command_buffer(const bv::CommandBufferPtr& cmd_buf);
+        void record_graphics_command_buffer(
+            const bv::CommandBufferPtr& cmd_buf,
+            uint32_t img_idx
+        );
+
+        // shared by both modes
+        void record_simulation_step(const bv::CommandBufferPtr& cmd_buf);
+        void record_draw(const bv::CommandBufferPtr& cmd_buf, uint32_t img_idx);
+
         friend void glfw_framebuf_resize_callback(
             GLFWwindow* window,
             int width,
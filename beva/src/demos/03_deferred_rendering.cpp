@@ -1,7 +1,6 @@
 #include "03_deferred_rendering.hpp"
 
 #include <iostream>
-#include <fstream>
 #include <format>
 #include <set>
 #include <limits>
@@ -27,8 +26,6 @@ namespace beva_demo_03_deferred_rendering
     // theta, phi
     static glm::vec3 spherical_to_cartesian(glm::vec2 s);
 
-    static std::vector<uint8_t> read_file(const std::string& filename);
-
     static void glfw_error_callback(int error, const char* description);
     static void glfw_framebuf_resize_callback(
         GLFWwindow* window,
@@ -122,109 +119,9 @@ namespace beva_demo_03_deferred_rendering
         data1(pos_or_dir, 0.f)
     {}
 
-    GeometryPassRecreatables::GeometryPassRecreatables(App& app)
-    {
-        init(app);
-    }
-
-    GeometryPassRecreatables::~GeometryPassRecreatables()
-    {
-        cleanup();
-    }
-
-    void GeometryPassRecreatables::init(App& app)
+    GeometryPass::GeometryPass(App& app)
     {
-        auto sc_extent = app.swapchain->config().image_extent;
-
-        // images
-
-        auto layout_tran_cmd_buf = app.begin_single_time_commands(true);
-
-        app.create_image(
-            sc_extent.width,
-            sc_extent.height,
-            1,
-            VK_SAMPLE_COUNT_1_BIT,
-            DIFFUSE_METALLIC_GBUF_FORMAT,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            diffuse_metallic_img,
-            diffuse_metallic_mem
-        );
-        diffuse_metallic_view = app.create_image_view(
-            diffuse_metallic_img,
-            DIFFUSE_METALLIC_GBUF_FORMAT,
-            VK_IMAGE_ASPECT_COLOR_BIT,
-            1
-        );
-        app.transition_image_layout(
-            layout_tran_cmd_buf,
-            diffuse_metallic_img,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            1
-        );
-
-        app.create_image(
-            sc_extent.width,
-            sc_extent.height,
-            1,
-            VK_SAMPLE_COUNT_1_BIT,
-            NORMAL_ROUGHNESS_GBUF_FORMAT,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            normal_roughness_img,
-            normal_roughness_mem
-        );
-        normal_roughness_view = app.create_image_view(
-            normal_roughness_img,
-            NORMAL_ROUGHNESS_GBUF_FORMAT,
-            VK_IMAGE_ASPECT_COLOR_BIT,
-            1
-        );
-        app.transition_image_layout(
-            layout_tran_cmd_buf,
-            normal_roughness_img,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            1
-        );
-
-        VkFormat depth_format = app.find_depth_format();
-        app.create_image(
-            sc_extent.width,
-            sc_extent.height,
-            1,
-            VK_SAMPLE_COUNT_1_BIT,
-            depth_format,
-            VK_IMAGE_TILING_OPTIMAL,
-
-            VK_IMAGE_USAGE_SAMPLED_BIT
-            | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            depth_img,
-            depth_img_mem
-        );
-        depth_imgview = app.create_image_view(
-            depth_img,
-            depth_format,
-            VK_IMAGE_ASPECT_DEPTH_BIT,
-            1
-        );
-        app.transition_image_layout(
-            layout_tran_cmd_buf,
-            depth_img,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            1
-        );
-
-        app.end_single_time_commands(layout_tran_cmd_buf);
-
-        // samplers
+        // G-Buffer samplers
 
         for (size_t i = 0; i < 3; i++)
         {
@@ -256,151 +153,6 @@ namespace beva_demo_03_deferred_rendering
             );
         }
 
-        // render pass
-
-        bv::Attachment diffuse_metallic_attachment{
-            .flags = 0,
-            .format = DIFFUSE_METALLIC_GBUF_FORMAT,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencil_load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencil_store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        bv::AttachmentReference diffuse_metallic_attachment_ref{
-            .attachment = 0,
-            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
-
-        bv::Attachment normal_roughness_attachment{
-            .flags = 0,
-            .format = NORMAL_ROUGHNESS_GBUF_FORMAT,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencil_load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencil_store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        bv::AttachmentReference normal_roughness_attachment_ref{
-            .attachment = 1,
-            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
-
-        bv::Attachment depth_attachment{
-            .flags = 0,
-            .format = depth_format,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencil_load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencil_store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        bv::AttachmentReference depth_attachment_ref{
-            .attachment = 2,
-            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        };
-
-        bv::Subpass subpass{
-            .flags = 0,
-            .pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS,
-            .input_attachments = {},
-            .color_attachments = {
-                diffuse_metallic_attachment_ref,
-                normal_roughness_attachment_ref
-        },
-            .resolve_attachments = {},
-            .depth_stencil_attachment = depth_attachment_ref,
-            .preserve_attachment_indices = {}
-        };
-
-        bv::SubpassDependency dependency{
-            .src_subpass = VK_SUBPASS_EXTERNAL,
-            .dst_subpass = 0,
-
-            .src_stage_mask =
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-            | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-
-            .dst_stage_mask =
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-            | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-
-            .src_access_mask =
-            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-
-            .dst_access_mask =
-            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-
-            .dependency_flags = 0
-        };
-
-        render_pass = bv::RenderPass::create(
-            app.device,
-            {
-                .flags = 0,
-                .attachments = {
-                diffuse_metallic_attachment,
-                normal_roughness_attachment,
-                depth_attachment
-            },
-            .subpasses = { subpass },
-            .dependencies = { dependency }
-            }
-        );
-
-        // framebuffer
-        framebuf = bv::Framebuffer::create(
-            app.device,
-            {
-                .flags = 0,
-                .render_pass = render_pass,
-                .attachments = {
-                diffuse_metallic_view,
-                normal_roughness_view,
-                depth_imgview
-            },
-            .width = sc_extent.width,
-            .height = sc_extent.height,
-            .layers = 1
-            }
-        );
-    }
-
-    void GeometryPassRecreatables::cleanup()
-    {
-        framebuf = nullptr;
-        render_pass = nullptr;
-
-        depth_sampler = nullptr;
-        depth_imgview = nullptr;
-        depth_img = nullptr;
-        depth_img_mem = nullptr;
-
-        normal_roughness_sampler = nullptr;
-        normal_roughness_view = nullptr;
-        normal_roughness_img = nullptr;
-        normal_roughness_mem = nullptr;
-
-        diffuse_metallic_sampler = nullptr;
-        diffuse_metallic_view = nullptr;
-        diffuse_metallic_img = nullptr;
-        diffuse_metallic_mem = nullptr;
-    }
-
-    GeometryPass::GeometryPass(App& app)
-        : recreatables(app)
-    {
         // uniform buffers
 
         VkDeviceSize ubo_size = sizeof(GeometryPassUniforms);
@@ -468,13 +220,11 @@ namespace beva_demo_03_deferred_rendering
 
         // graphics pipeline
 
-        auto vert_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_gpass_vert.spv"))
+        auto vert_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_gpass_vert.spv"
         );
-        auto frag_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_gpass_frag.spv"))
+        auto frag_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_gpass_frag.spv"
         );
 
         std::vector<bv::ShaderStage> shader_stages;
@@ -609,10 +359,11 @@ namespace beva_demo_03_deferred_rendering
                 .color_blend_state = color_blend_state,
                 .dynamic_states = dynamic_states,
                 .layout = pipeline_layout,
-                .render_pass = recreatables.render_pass,
-                .subpass_index = 0,
+                .render_pass = app.render_graph->render_pass(app.rg_gpass),
+                .subpass_index = app.render_graph->subpass_index(app.rg_gpass),
                 .base_pipeline = std::nullopt
-            }
+            },
+            app.pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -719,60 +470,64 @@ namespace beva_demo_03_deferred_rendering
         graphics_pipeline = nullptr;
         pipeline_layout = nullptr;
         descriptor_set_layout = nullptr;
-    }
 
-    void GeometryPass::recreate(App& app)
-    {
-        recreatables.cleanup();
-        recreatables.init(app);
+        depth_sampler = nullptr;
+        normal_roughness_sampler = nullptr;
+        diffuse_metallic_sampler = nullptr;
     }
 
-    LightingPassRecreatables::LightingPassRecreatables(App& app)
+    void GeometryPass::record(App& app, const bv::CommandBufferPtr& cmd_buf)
     {
-        init(app);
-    }
+        cmd_buf->dispatch().vkCmdBindPipeline(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            graphics_pipeline->handle()
+        );
 
-    LightingPassRecreatables::~LightingPassRecreatables()
-    {
-        cleanup();
-    }
+        VkBuffer vk_vertex_bufs[]{ app.vertex_buf->handle() };
+        VkDeviceSize vb_offsets[] = { 0 };
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
+            cmd_buf->handle(),
+            0,
+            1,
+            vk_vertex_bufs,
+            vb_offsets
+        );
 
-    void LightingPassRecreatables::init(App& app)
-    {
-        auto sc_extent = app.swapchain->config().image_extent;
+        cmd_buf->dispatch().vkCmdBindIndexBuffer(
+            cmd_buf->handle(),
+            app.index_buf->handle(),
+            0,
+            VK_INDEX_TYPE_UINT32
+        );
 
-        // color image
+        app.set_viewport_and_scissor(cmd_buf);
 
-        app.create_image(
-            sc_extent.width,
-            sc_extent.height,
+        auto vk_descriptor_set = descriptor_sets[app.frame_idx]->handle();
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline_layout->handle(),
+            0,
             1,
-            VK_SAMPLE_COUNT_1_BIT,
-            LPASS_COLOR_FORMAT,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            color_img,
-            color_img_mem
-        );
-        color_imgview = app.create_image_view(
-            color_img,
-            LPASS_COLOR_FORMAT,
-            VK_IMAGE_ASPECT_COLOR_BIT,
-            1
+            &vk_descriptor_set,
+            0,
+            nullptr
         );
 
-        auto layout_tran_cmd_buf = app.begin_single_time_commands(true);
-        app.transition_image_layout(
-            layout_tran_cmd_buf,
-            color_img,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            1
+        cmd_buf->dispatch().vkCmdDrawIndexed(
+            cmd_buf->handle(),
+            (uint32_t)(app.indices.size()),
+            1,
+            0,
+            0,
+            0
         );
-        app.end_single_time_commands(layout_tran_cmd_buf);
+    }
 
-        // sampler
+    LightingPass::LightingPass(App& app)
+    {
+        // color image sampler (used by the FXAA pass)
         color_img_sampler = bv::Sampler::create(
             app.device,
             {
@@ -795,86 +550,6 @@ namespace beva_demo_03_deferred_rendering
             }
         );
 
-        // render pass
-
-        bv::Attachment color_attachment{
-            .flags = 0,
-            .format = LPASS_COLOR_FORMAT,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencil_load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencil_store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        bv::AttachmentReference color_attachment_ref{
-            .attachment = 0,
-            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
-
-        bv::Subpass subpass{
-            .flags = 0,
-            .pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS,
-            .input_attachments = {},
-            .color_attachments = { color_attachment_ref },
-            .resolve_attachments = {},
-            .depth_stencil_attachment = std::nullopt,
-            .preserve_attachment_indices = {}
-        };
-
-        bv::SubpassDependency dependency{
-            .src_subpass = VK_SUBPASS_EXTERNAL,
-            .dst_subpass = 0,
-            .src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .src_access_mask = 0,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .dependency_flags = 0
-        };
-
-        render_pass = bv::RenderPass::create(
-            app.device,
-            {
-                .flags = 0,
-                .attachments = { color_attachment },
-                .subpasses = { subpass },
-                .dependencies = { dependency }
-            }
-        );
-
-        // framebuffers
-        for (size_t i = 0; i < app.swapchain_imgviews.size(); i++)
-        {
-            framebuf = bv::Framebuffer::create(
-                app.device,
-                {
-                    .flags = 0,
-                    .render_pass = render_pass,
-                    .attachments = { color_imgview },
-                    .width = sc_extent.width,
-                    .height = sc_extent.height,
-                    .layers = 1
-                }
-            );
-        }
-    }
-
-    void LightingPassRecreatables::cleanup()
-    {
-        framebuf = nullptr;
-        render_pass = nullptr;
-
-        color_img_sampler = nullptr;
-        color_imgview = nullptr;
-        color_img = nullptr;
-        color_img_mem = nullptr;
-    }
-
-    LightingPass::LightingPass(App& app)
-        : recreatables(app)
-    {
         // light buffers
 
         VkDeviceSize light_buf_size = sizeof(lights[0]) * lights.size();
@@ -948,13 +623,11 @@ namespace beva_demo_03_deferred_rendering
 
         // graphics pipeline
 
-        auto vert_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_flat_vert.spv"))
+        auto vert_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_flat_vert.spv"
         );
-        auto frag_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_lpass_frag.spv"))
+        auto frag_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_lpass_frag.spv"
         );
 
         std::vector<bv::ShaderStage> shader_stages;
@@ -1082,10 +755,11 @@ namespace beva_demo_03_deferred_rendering
                 .color_blend_state = color_blend_state,
                 .dynamic_states = dynamic_states,
                 .layout = pipeline_layout,
-                .render_pass = recreatables.render_pass,
-                .subpass_index = 0,
+                .render_pass = app.render_graph->render_pass(app.rg_lpass),
+                .subpass_index = app.render_graph->subpass_index(app.rg_lpass),
                 .base_pipeline = std::nullopt
-            }
+            },
+            app.pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -1126,16 +800,65 @@ namespace beva_demo_03_deferred_rendering
         graphics_pipeline = nullptr;
         pipeline_layout = nullptr;
         descriptor_set_layout = nullptr;
+
+        color_img_sampler = nullptr;
     }
 
     void LightingPass::recreate(App& app)
     {
-        recreatables.cleanup();
-        recreatables.init(app);
-
         recreate_descriptor_sets(app);
     }
 
+    void LightingPass::record(App& app, const bv::CommandBufferPtr& cmd_buf)
+    {
+        cmd_buf->dispatch().vkCmdBindPipeline(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            graphics_pipeline->handle()
+        );
+
+        VkBuffer vk_vertex_bufs[]{ app.quad_vertex_buf->handle() };
+        VkDeviceSize vb_offsets[] = { 0 };
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
+            cmd_buf->handle(),
+            0,
+            1,
+            vk_vertex_bufs,
+            vb_offsets
+        );
+
+        app.set_viewport_and_scissor(cmd_buf);
+
+        auto vk_descriptor_set = descriptor_sets[app.frame_idx]->handle();
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline_layout->handle(),
+            0,
+            1,
+            &vk_descriptor_set,
+            0,
+            nullptr
+        );
+
+        cmd_buf->dispatch().vkCmdPushConstants(
+            cmd_buf->handle(),
+            pipeline_layout->handle(),
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(frag_push_constants),
+            &frag_push_constants
+        );
+
+        cmd_buf->dispatch().vkCmdDraw(
+            cmd_buf->handle(),
+            (uint32_t)quad_vertices.size(),
+            1,
+            0,
+            0
+        );
+    }
+
     void LightingPass::recreate_descriptor_sets(App& app)
     {
         bv::clear(descriptor_sets);
@@ -1151,20 +874,24 @@ namespace beva_demo_03_deferred_rendering
         for (size_t i = 0; i < App::MAX_FRAMES_IN_FLIGHT; i++)
         {
             bv::DescriptorImageInfo sampler0_image_info{
-                .sampler = app.gpass->recreatables.diffuse_metallic_sampler,
-                .image_view = app.gpass->recreatables.diffuse_metallic_view,
+                .sampler = app.gpass->diffuse_metallic_sampler,
+                .image_view = app.render_graph->image_view(
+                    app.rg_diffuse_metallic
+                ),
                 .image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
             };
 
             bv::DescriptorImageInfo sampler1_image_info{
-                .sampler = app.gpass->recreatables.normal_roughness_sampler,
-                .image_view = app.gpass->recreatables.normal_roughness_view,
+                .sampler = app.gpass->normal_roughness_sampler,
+                .image_view = app.render_graph->image_view(
+                    app.rg_normal_roughness
+                ),
                 .image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
             };
 
             bv::DescriptorImageInfo sampler2_image_info{
-                .sampler = app.gpass->recreatables.depth_sampler,
-                .image_view = app.gpass->recreatables.depth_imgview,
+                .sampler = app.gpass->depth_sampler,
+                .image_view = app.render_graph->image_view(app.rg_depth),
                 .image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
             };
 
@@ -1224,125 +951,34 @@ namespace beva_demo_03_deferred_rendering
         }
     }
 
-    FxaaPassRecreatables::FxaaPassRecreatables(App& app)
-    {
-        init(app);
-    }
-
-    FxaaPassRecreatables::~FxaaPassRecreatables()
-    {
-        cleanup();
-    }
-
-    void FxaaPassRecreatables::init(App& app)
+    FxaaPass::FxaaPass(App& app)
     {
-        // render pass
-
-        bv::Attachment color_attachment{
-            .flags = 0,
-            .format = app.swapchain->config().image_format,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .store_op = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencil_load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencil_store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
-            .final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-        };
-
-        bv::AttachmentReference color_attachment_ref{
-            .attachment = 0,
-            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        };
-
-        bv::Subpass subpass{
-            .flags = 0,
-            .pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS,
-            .input_attachments = {},
-            .color_attachments = { color_attachment_ref },
-            .resolve_attachments = {},
-            .depth_stencil_attachment = std::nullopt,
-            .preserve_attachment_indices = {}
-        };
+        // descriptor set layout
 
-        bv::SubpassDependency dependency{
-            .src_subpass = VK_SUBPASS_EXTERNAL,
-            .dst_subpass = 0,
-            .src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .src_access_mask = 0,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .dependency_flags = 0
+        bv::DescriptorSetLayoutBinding sampler0_layout_binding{
+            .binding = 0,
+            .descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptor_count = 1,
+            .stage_flags = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .immutable_samplers = {}
         };
 
-        render_pass = bv::RenderPass::create(
+        descriptor_set_layout = bv::DescriptorSetLayout::create(
             app.device,
             {
                 .flags = 0,
-                .attachments = { color_attachment },
-                .subpasses = { subpass },
-                .dependencies = { dependency }
+                .bindings = { sampler0_layout_binding }
             }
         );
 
-        // framebuffers
+        // graphics pipeline
 
-        auto sc_extent = app.swapchain->config().image_extent;
-
-        bv::clear(swapchain_framebufs);
-        for (size_t i = 0; i < app.swapchain_imgviews.size(); i++)
-        {
-            swapchain_framebufs.push_back(bv::Framebuffer::create(
-                app.device,
-                {
-                    .flags = 0,
-                    .render_pass = render_pass,
-                    .attachments = { app.swapchain_imgviews[i] },
-                    .width = sc_extent.width,
-                    .height = sc_extent.height,
-                    .layers = 1
-                }
-            ));
-        }
-    }
-
-    void FxaaPassRecreatables::cleanup()
-    {
-        bv::clear(swapchain_framebufs);
-        render_pass = nullptr;
-    }
-
-    FxaaPass::FxaaPass(App& app)
-        : recreatables(app)
-    {
-        // descriptor set layout
-
-        bv::DescriptorSetLayoutBinding sampler0_layout_binding{
-            .binding = 0,
-            .descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            .descriptor_count = 1,
-            .stage_flags = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .immutable_samplers = {}
-        };
-
-        descriptor_set_layout = bv::DescriptorSetLayout::create(
-            app.device,
-            {
-                .flags = 0,
-                .bindings = { sampler0_layout_binding }
-            }
-        );
-
-        // graphics pipeline
-
-        auto vert_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_flat_vert.spv"))
-        );
-        auto frag_shader_module = bv::ShaderModule::create(
-            app.device,
-            std::move(read_file("./shaders/demo_03_fxaa_frag.spv"))
-        );
+        auto vert_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_flat_vert.spv"
+        );
+        auto frag_shader_module = app.shader_registry->get(
+            "./shaders/demo_03_fxaa_frag.spv"
+        );
 
         std::vector<bv::ShaderStage> shader_stages;
         shader_stages.push_back(bv::ShaderStage{
@@ -1469,10 +1105,12 @@ namespace beva_demo_03_deferred_rendering
                 .color_blend_state = color_blend_state,
                 .dynamic_states = dynamic_states,
                 .layout = pipeline_layout,
-                .render_pass = recreatables.render_pass,
-                .subpass_index = 0,
+                .render_pass = app.render_graph->render_pass(app.rg_fxaa_pass),
+                .subpass_index =
+                app.render_graph->subpass_index(app.rg_fxaa_pass),
                 .base_pipeline = std::nullopt
-            }
+            },
+            app.pipeline_cache
         );
 
         vert_shader_module = nullptr;
@@ -1510,12 +1148,66 @@ namespace beva_demo_03_deferred_rendering
 
     void FxaaPass::recreate(App& app)
     {
-        recreatables.cleanup();
-        recreatables.init(app);
-
         recreate_descriptor_sets(app);
     }
 
+    void FxaaPass::record(App& app, const bv::CommandBufferPtr& cmd_buf)
+    {
+        cmd_buf->dispatch().vkCmdBindPipeline(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            graphics_pipeline->handle()
+        );
+
+        VkBuffer vk_vertex_bufs[]{ app.quad_vertex_buf->handle() };
+        VkDeviceSize vb_offsets[] = { 0 };
+        cmd_buf->dispatch().vkCmdBindVertexBuffers(
+            cmd_buf->handle(),
+            0,
+            1,
+            vk_vertex_bufs,
+            vb_offsets
+        );
+
+        app.set_viewport_and_scissor(cmd_buf);
+
+        auto vk_descriptor_set = descriptor_sets[app.frame_idx]->handle();
+        cmd_buf->dispatch().vkCmdBindDescriptorSets(
+            cmd_buf->handle(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline_layout->handle(),
+            0,
+            1,
+            &vk_descriptor_set,
+            0,
+            nullptr
+        );
+
+        frag_push_constants = {
+            .do_nothing =
+            app.lpass->frag_push_constants.render_mode != RenderMode::Lit
+            ? 1 : 0,
+
+            .global_frame_idx = (uint32_t)app.global_frame_idx
+        };
+        cmd_buf->dispatch().vkCmdPushConstants(
+            cmd_buf->handle(),
+            pipeline_layout->handle(),
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(frag_push_constants),
+            &frag_push_constants
+        );
+
+        cmd_buf->dispatch().vkCmdDraw(
+            cmd_buf->handle(),
+            (uint32_t)quad_vertices.size(),
+            1,
+            0,
+            0
+        );
+    }
+
     void FxaaPass::recreate_descriptor_sets(App& app)
     {
         bv::clear(descriptor_sets);
@@ -1531,8 +1223,8 @@ namespace beva_demo_03_deferred_rendering
         for (size_t i = 0; i < App::MAX_FRAMES_IN_FLIGHT; i++)
         {
             bv::DescriptorImageInfo sampler0_image_info{
-                .sampler = app.lpass->recreatables.color_img_sampler,
-                .image_view = app.lpass->recreatables.color_imgview,
+                .sampler = app.lpass->color_img_sampler,
+                .image_view = app.render_graph->image_view(app.rg_lpass_color),
                 .image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
             };
 
@@ -1551,6 +1243,10 @@ namespace beva_demo_03_deferred_rendering
         }
     }
 
+    App::App(const beva_demos::HeadlessConfig& headless_config)
+        : headless(headless_config)
+    {}
+
     void App::run()
     {
         try
@@ -1582,6 +1278,9 @@ namespace beva_demo_03_deferred_rendering
         pick_physical_device();
         create_logical_device();
         create_memory_bank();
+        create_pipeline_cache();
+        create_shader_registry();
+        create_upload_engine();
         create_command_pools();
         create_swapchain();
 
@@ -1592,9 +1291,13 @@ namespace beva_demo_03_deferred_rendering
         create_index_buffer();
         create_quad_vertex_buffer();
 
+        // all of the uploads above go out in a single submission on the
+        // transfer queue. rendering can't start without them anyway.
+        upload_engine->wait_idle();
+
+        create_render_graph();
         create_passes();
 
-        create_command_buffers();
         create_sync_objects();
     }
 
@@ -1603,6 +1306,30 @@ namespace beva_demo_03_deferred_rendering
         start_time = std::chrono::high_resolution_clock::now();
         frame_start_time = start_time;
 
+        if (headless.has_value())
+        {
+            stats.reserve(headless->n_frames);
+            for (uint64_t i = 0; i < headless->n_frames; i++)
+            {
+                stats.begin_frame();
+
+                scene_time = (float)i * headless->time_step;
+                delta_time = headless->time_step;
+
+                update_lights();
+                update_camera();
+
+                dump_frame =
+                    i + 1 == headless->n_frames
+                    && !headless->dump_path.empty();
+                draw_frame();
+
+                stats.end_frame();
+            }
+            device->wait_idle();
+            return;
+        }
+
         while (true)
         {
             // time
@@ -1647,6 +1374,8 @@ namespace beva_demo_03_deferred_rendering
         lpass = nullptr;
         gpass = nullptr;
 
+        render_graph = nullptr;
+
         bv::clear(fences_in_flight);
         bv::clear(semaphs_render_finished);
         bv::clear(semaphs_image_available);
@@ -1677,18 +1406,32 @@ namespace beva_demo_03_deferred_rendering
 
         transient_cmd_pool = nullptr;
         cmd_pool = nullptr;
+        upload_engine = nullptr;
+
+        pipeline_cache->save(PIPELINE_CACHE_PATH);
+        pipeline_cache = nullptr;
+        shader_registry = nullptr;
+
         mem_bank = nullptr;
         device = nullptr;
         surface = nullptr;
         debug_messenger = nullptr;
         context = nullptr;
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if (!headless.has_value())
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void App::init_window()
     {
+        if (headless.has_value())
+        {
+            return;
+        }
+
         glfwSetErrorCallback(glfw_error_callback);
 
         if (!glfwInit())
@@ -1728,13 +1471,21 @@ namespace beva_demo_03_deferred_rendering
 
         std::vector<std::string> extensions;
         {
-            // extensions required by GLFW
-            uint32_t glfw_ext_count = 0;
-            const char** glfw_exts;
-            glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
-            for (uint32_t i = 0; i < glfw_ext_count; i++)
+            if (headless.has_value())
             {
-                extensions.emplace_back(glfw_exts[i]);
+                // extensions required for headless surfaces
+                extensions = beva_demos::headless_instance_extensions();
+            }
+            else
+            {
+                // extensions required by GLFW
+                uint32_t glfw_ext_count = 0;
+                const char** glfw_exts;
+                glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+                for (uint32_t i = 0; i < glfw_ext_count; i++)
+                {
+                    extensions.emplace_back(glfw_exts[i]);
+                }
             }
 
             // debug utils extension
@@ -1790,6 +1541,12 @@ namespace beva_demo_03_deferred_rendering
 
     void App::create_surface()
     {
+        if (headless.has_value())
+        {
+            surface = bv::Surface::create_headless(context);
+            return;
+        }
+
         VkSurfaceKHR vk_surface;
         VkResult vk_result = glfwCreateWindowSurface(
             context->vk_instance(),
@@ -1840,6 +1597,28 @@ namespace beva_demo_03_deferred_rendering
                 continue;
             }
 
+            // create_logical_device() enables VK_KHR_timeline_semaphore for
+            // the upload engine. devices that support the extension must
+            // support its timelineSemaphore feature too.
+            bool has_timeline_semaphore_ext = false;
+            for (const auto& ext : pdev.fetch_available_extensions())
+            {
+                if (ext.name == VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)
+                {
+                    has_timeline_semaphore_ext = true;
+                    break;
+                }
+            }
+            if (!has_timeline_semaphore_ext)
+            {
+                continue;
+            }
+            if (pdev.vulkan12_features().has_value()
+                && !pdev.vulkan12_features()->timeline_semaphore)
+            {
+                continue;
+            }
+
             supported_physical_devices.push_back(pdev);
         }
         if (supported_physical_devices.empty())
@@ -1847,6 +1626,22 @@ namespace beva_demo_03_deferred_rendering
             throw std::runtime_error("no supported physical devices");
         }
 
+        if (headless.has_value())
+        {
+            if (headless->physical_device_idx
+                >= supported_physical_devices.size())
+            {
+                throw std::runtime_error("invalid physical device index");
+            }
+            physical_device =
+                supported_physical_devices[headless->physical_device_idx];
+            std::cout << std::format(
+                "using physical device: {}\n\n",
+                physical_device->properties().device_name
+            );
+            return;
+        }
+
         std::cout << "pick a physical device by entering its index:\n";
         for (size_t i = 0; i < supported_physical_devices.size(); i++)
         {
@@ -1914,6 +1709,17 @@ namespace beva_demo_03_deferred_rendering
                 surface
             );
 
+        // prefer a dedicated transfer queue family for uploads and fall back
+        // to the graphics queue if there isn't one
+        auto transfer_family_indices =
+            physical_device->find_queue_family_indices(
+                VK_QUEUE_TRANSFER_BIT,
+                VK_QUEUE_GRAPHICS_BIT
+            );
+        transfer_family_idx =
+            transfer_family_indices.empty()
+            ? graphics_present_family_idx : transfer_family_indices[0];
+
         std::vector<bv::QueueRequest> queue_requests;
         queue_requests.push_back(bv::QueueRequest{
             .flags = 0,
@@ -1921,6 +1727,15 @@ namespace beva_demo_03_deferred_rendering
             .num_queues_to_create = 1,
             .priorities = { 1.f }
             });
+        if (transfer_family_idx != graphics_present_family_idx)
+        {
+            queue_requests.push_back(bv::QueueRequest{
+                .flags = 0,
+                .queue_family_index = transfer_family_idx,
+                .num_queues_to_create = 1,
+                .priorities = { 1.f }
+                });
+        }
 
         bv::PhysicalDeviceFeatures enabled_features{};
         enabled_features.sampler_anisotropy = true;
@@ -1930,13 +1745,19 @@ namespace beva_demo_03_deferred_rendering
             physical_device.value(),
             {
                 .queue_requests = queue_requests,
-                .extensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME },
-                .enabled_features = enabled_features
+                .extensions = {
+                    VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+                    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME
+                },
+                .enabled_features = enabled_features,
+                .enable_timeline_semaphore = true
             }
         );
 
         graphics_present_queue =
             bv::Device::retrieve_queue(device, graphics_present_family_idx, 0);
+        transfer_queue =
+            bv::Device::retrieve_queue(device, transfer_family_idx, 0);
     }
 
     void App::create_memory_bank()
@@ -1944,6 +1765,28 @@ namespace beva_demo_03_deferred_rendering
         mem_bank = bv::MemoryBank::create(device);
     }
 
+    void App::create_pipeline_cache()
+    {
+        pipeline_cache = bv::PipelineCache::load(device, PIPELINE_CACHE_PATH);
+    }
+
+    void App::create_shader_registry()
+    {
+        shader_registry = bv::ShaderModuleRegistry::create(device);
+    }
+
+    void App::create_upload_engine()
+    {
+        upload_engine = bv::UploadEngine::create(
+            device,
+            mem_bank,
+            {
+                .transfer_queue = transfer_queue,
+                .dst_queue = graphics_present_queue
+            }
+        );
+    }
+
     void App::create_command_pools()
     {
         cmd_pool = bv::CommandPool::create(
@@ -1993,7 +1836,15 @@ namespace beva_demo_03_deferred_rendering
             || extent.height == std::numeric_limits<uint32_t>::max())
         {
             int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            if (headless.has_value())
+            {
+                width = (int)headless->width;
+                height = (int)headless->height;
+            }
+            else
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+            }
 
             extent = {
                 .width = (uint32_t)width,
@@ -2022,6 +1873,13 @@ namespace beva_demo_03_deferred_rendering
 
         auto pre_transform = sc_support->capabilities.current_transform;
 
+        // dumped frames are copied out of the swapchain images
+        VkImageUsageFlags image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (headless.has_value() && !headless->dump_path.empty())
+        {
+            image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         // create swapchain
         swapchain = bv::Swapchain::create(
             device,
@@ -2033,7 +1891,7 @@ namespace beva_demo_03_deferred_rendering
                 .image_color_space = surface_format.color_space,
                 .image_extent = extent,
                 .image_array_layers = 1,
-                .image_usage = { VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+                .image_usage = image_usage,
                 .image_sharing_mode = VK_SHARING_MODE_EXCLUSIVE,
                 .queue_family_indices = {},
                 .pre_transform = pre_transform,
@@ -2153,38 +2011,6 @@ namespace beva_demo_03_deferred_rendering
             (uint64_t)normal_roughness_w * (uint64_t)normal_roughness_h
             * 4ull // channels per pixel
             * 2ull; // bytes per channel
-        VkDeviceSize total_size = diffuse_metallic_size + normal_roughness_size;
-
-        // upload to staging buffer and free
-
-        bv::BufferPtr staging_buf;
-        bv::MemoryChunkPtr staging_buf_mem;
-        create_buffer(
-            total_size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-
-            staging_buf,
-            staging_buf_mem
-        );
-
-        void* mapped = staging_buf_mem->mapped();
-        std::copy(
-            (uint8_t*)diffuse_metallic_pixels,
-            (uint8_t*)diffuse_metallic_pixels + diffuse_metallic_size,
-            (uint8_t*)mapped
-        );
-        std::copy(
-            (uint8_t*)normal_roughness_pixels,
-            (uint8_t*)normal_roughness_pixels + normal_roughness_size,
-            (uint8_t*)mapped + diffuse_metallic_size
-        );
-        staging_buf_mem->flush();
-
-        stbi_image_free(diffuse_metallic_pixels);
-        stbi_image_free(normal_roughness_pixels);
 
         // create images
         create_image(
@@ -2212,61 +2038,20 @@ namespace beva_demo_03_deferred_rendering
             tex_normal_roughness_mem
         );
 
-        // copy from staging buffer to the images
-        auto cmd_buf = begin_single_time_commands(true);
-        {
-            transition_image_layout(
-                cmd_buf,
-                tex_diffuse_metallic_img,
-                VK_IMAGE_LAYOUT_UNDEFINED,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                1
-            );
-            transition_image_layout(
-                cmd_buf,
-                tex_normal_roughness_img,
-                VK_IMAGE_LAYOUT_UNDEFINED,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                1
-            );
-
-            copy_buffer_to_image(
-                cmd_buf,
-                staging_buf,
-                tex_diffuse_metallic_img,
-                (uint32_t)(diffuse_metallic_w),
-                (uint32_t)(diffuse_metallic_h),
-                0 // staging buffer offset
-            );
-            copy_buffer_to_image(
-                cmd_buf,
-                staging_buf,
-                tex_normal_roughness_img,
-                (uint32_t)(normal_roughness_w),
-                (uint32_t)(normal_roughness_h),
-                diffuse_metallic_size // staging buffer offset
-            );
-
-            transition_image_layout(
-                cmd_buf,
-                tex_diffuse_metallic_img,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                1
-            );
-            transition_image_layout(
-                cmd_buf,
-                tex_normal_roughness_img,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                1
-            );
-        }
-        end_single_time_commands(cmd_buf);
+        // upload and free
+        upload_engine->upload_to_image(
+            diffuse_metallic_pixels,
+            diffuse_metallic_size,
+            tex_diffuse_metallic_img
+        );
+        upload_engine->upload_to_image(
+            normal_roughness_pixels,
+            normal_roughness_size,
+            tex_normal_roughness_img
+        );
 
-        // destroy the staging buffer
-        staging_buf = nullptr;
-        staging_buf_mem = nullptr;
+        stbi_image_free(diffuse_metallic_pixels);
+        stbi_image_free(normal_roughness_pixels);
 
         // create image views
         tex_diffuse_metallic_view = create_image_view(
@@ -2386,27 +2171,6 @@ namespace beva_demo_03_deferred_rendering
     {
         VkDeviceSize size = sizeof(vertices[0]) * vertices.size();
 
-        bv::BufferPtr staging_buf;
-        bv::MemoryChunkPtr staging_buf_mem;
-        create_buffer(
-            size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-
-            staging_buf,
-            staging_buf_mem
-        );
-
-        void* mapped = staging_buf_mem->mapped();
-        std::copy(
-            vertices.data(),
-            vertices.data() + vertices.size(),
-            (GeometryPassVertex*)mapped
-        );
-        staging_buf_mem->flush();
-
         create_buffer(
             size,
 
@@ -2418,39 +2182,13 @@ namespace beva_demo_03_deferred_rendering
             vertex_buf_mem
         );
 
-        auto cmd_buf = begin_single_time_commands(true);
-        copy_buffer(cmd_buf, staging_buf, vertex_buf, size);
-        end_single_time_commands(cmd_buf);
-
-        staging_buf = nullptr;
-        staging_buf_mem = nullptr;
+        upload_engine->upload_to_buffer(vertices.data(), size, vertex_buf);
     }
 
     void App::create_index_buffer()
     {
         VkDeviceSize size = sizeof(indices[0]) * indices.size();
 
-        bv::BufferPtr staging_buf;
-        bv::MemoryChunkPtr staging_buf_mem;
-        create_buffer(
-            size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-
-            staging_buf,
-            staging_buf_mem
-        );
-
-        void* mapped = staging_buf_mem->mapped();
-        std::copy(
-            indices.data(),
-            indices.data() + indices.size(),
-            (uint32_t*)mapped
-        );
-        staging_buf_mem->flush();
-
         create_buffer(
             size,
 
@@ -2462,39 +2200,13 @@ namespace beva_demo_03_deferred_rendering
             index_buf_mem
         );
 
-        auto cmd_buf = begin_single_time_commands(true);
-        copy_buffer(cmd_buf, staging_buf, index_buf, size);
-        end_single_time_commands(cmd_buf);
-
-        staging_buf = nullptr;
-        staging_buf_mem = nullptr;
+        upload_engine->upload_to_buffer(indices.data(), size, index_buf);
     }
 
     void App::create_quad_vertex_buffer()
     {
         VkDeviceSize size = sizeof(quad_vertices[0]) * quad_vertices.size();
 
-        bv::BufferPtr staging_buf;
-        bv::MemoryChunkPtr staging_buf_mem;
-        create_buffer(
-            size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-
-            staging_buf,
-            staging_buf_mem
-        );
-
-        void* mapped = staging_buf_mem->mapped();
-        std::copy(
-            quad_vertices.data(),
-            quad_vertices.data() + quad_vertices.size(),
-            (FlatVertex*)mapped
-        );
-        staging_buf_mem->flush();
-
         create_buffer(
             size,
 
@@ -2506,12 +2218,149 @@ namespace beva_demo_03_deferred_rendering
             quad_vertex_buf_mem
         );
 
-        auto cmd_buf = begin_single_time_commands(true);
-        copy_buffer(cmd_buf, staging_buf, quad_vertex_buf, size);
-        end_single_time_commands(cmd_buf);
+        upload_engine->upload_to_buffer(quad_vertices.data(), size, quad_vertex_buf);
+    }
+
+    void App::create_render_graph()
+    {
+        render_graph = bv::RenderGraph::create(
+            device,
+            mem_bank,
+            {
+                .graphics_queue = graphics_present_queue,
+                .compute_queue = {},
+                .frames_in_flight = MAX_FRAMES_IN_FLIGHT
+            }
+        );
+        build_render_graph();
+    }
+
+    void App::build_render_graph()
+    {
+        render_graph->reset();
+
+        auto sc_extent = swapchain->config().image_extent;
+
+        // images
+
+        rg_diffuse_metallic = render_graph->add_transient_image({
+            .name = "diffuse_metallic",
+            .format = GeometryPass::DIFFUSE_METALLIC_GBUF_FORMAT,
+            .extent = sc_extent
+            });
+        rg_normal_roughness = render_graph->add_transient_image({
+            .name = "normal_roughness",
+            .format = GeometryPass::NORMAL_ROUGHNESS_GBUF_FORMAT,
+            .extent = sc_extent
+            });
+        rg_depth = render_graph->add_transient_image({
+            .name = "depth",
+            .format = find_depth_format(),
+            .extent = sc_extent
+            });
+        rg_lpass_color = render_graph->add_transient_image({
+            .name = "lpass_color",
+            .format = LightingPass::LPASS_COLOR_FORMAT,
+            .extent = sc_extent
+            });
+
+        // the view is set before each execution
+        rg_swapchain_img = render_graph->import_image({
+            .name = "swapchain",
+            .format = swapchain->config().image_format,
+            .extent = sc_extent,
+            .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .initial_stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+            });
+
+        // passes
+
+        VkClearValue diffuse_metallic_clear_val{};
+        diffuse_metallic_clear_val.color = { { .159f, .168f, .196f, 0.f } };
+
+        VkClearValue normal_roughness_clear_val{};
+        normal_roughness_clear_val.color = { { 0.f, 0.f, 0.f, 0.f } };
+
+        VkClearValue depth_clear_val{};
+        depth_clear_val.depthStencil = { 1.f, 0 };
+
+        rg_gpass = render_graph->add_pass({
+            .name = "geometry",
+            .queue = VK_QUEUE_GRAPHICS_BIT,
+            .accesses = {
+                {
+                    .image = rg_diffuse_metallic,
+                    .access = bv::RenderGraphAccess::ColorAttachment,
+                    .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                    .clear_value = diffuse_metallic_clear_val
+                },
+                {
+                    .image = rg_normal_roughness,
+                    .access = bv::RenderGraphAccess::ColorAttachment,
+                    .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                    .clear_value = normal_roughness_clear_val
+                },
+                {
+                    .image = rg_depth,
+                    .access = bv::RenderGraphAccess::DepthStencilAttachment,
+                    .load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                    .clear_value = depth_clear_val
+                }
+        },
+            .record = [this](const bv::CommandBufferPtr& cmd_buf)
+            {
+                gpass->record(*this, cmd_buf);
+            }
+            });
+
+        rg_lpass = render_graph->add_pass({
+            .name = "lighting",
+            .queue = VK_QUEUE_GRAPHICS_BIT,
+            .accesses = {
+                {
+                    .image = rg_diffuse_metallic,
+                    .access = bv::RenderGraphAccess::Sampled
+                },
+                {
+                    .image = rg_normal_roughness,
+                    .access = bv::RenderGraphAccess::Sampled
+                },
+                {
+                    .image = rg_depth,
+                    .access = bv::RenderGraphAccess::Sampled
+                },
+                {
+                    .image = rg_lpass_color,
+                    .access = bv::RenderGraphAccess::ColorAttachment
+                }
+        },
+            .record = [this](const bv::CommandBufferPtr& cmd_buf)
+            {
+                lpass->record(*this, cmd_buf);
+            }
+            });
+
+        rg_fxaa_pass = render_graph->add_pass({
+            .name = "fxaa",
+            .queue = VK_QUEUE_GRAPHICS_BIT,
+            .accesses = {
+                {
+                    .image = rg_lpass_color,
+                    .access = bv::RenderGraphAccess::Sampled
+                },
+                {
+                    .image = rg_swapchain_img,
+                    .access = bv::RenderGraphAccess::ColorAttachment
+                }
+        },
+            .record = [this](const bv::CommandBufferPtr& cmd_buf)
+            {
+                fxaa_pass->record(*this, cmd_buf);
+            }
+            });
 
-        staging_buf = nullptr;
-        staging_buf_mem = nullptr;
+        render_graph->compile();
     }
 
     void App::create_passes()
@@ -2521,15 +2370,6 @@ namespace beva_demo_03_deferred_rendering
         fxaa_pass = std::make_shared<FxaaPass>(*this);
     }
 
-    void App::create_command_buffers()
-    {
-        cmd_bufs = bv::CommandPool::allocate_buffers(
-            cmd_pool,
-            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-            MAX_FRAMES_IN_FLIGHT
-        );
-    }
-
     void App::create_sync_objects()
     {
         bv::clear(semaphs_image_available);
@@ -2593,6 +2433,18 @@ namespace beva_demo_03_deferred_rendering
 
     void App::update_camera()
     {
+        // there's no input in headless mode, so follow a fixed path that
+        // sways sideways while looking around
+        if (headless.has_value())
+        {
+            lpass->frag_push_constants.cam_pos =
+                DEFAULT_CAM_POS
+                + glm::vec3(.3f * std::sin(.5f * scene_time), 0.f, 0.f);
+            cam_dir_spherical.y =
+                DEFAULT_CAM_DIR_SPHERICAL.y + .4f * std::sin(.3f * scene_time);
+            return;
+        }
+
         // look around
         if (drag_mode)
         {
@@ -2646,64 +2498,81 @@ namespace beva_demo_03_deferred_rendering
 
     void App::draw_frame()
     {
-        fences_in_flight[frame_idx]->wait();
+        {
+            beva_demos::ScopedTimer timer(stats.current().fence_wait_ms);
+            fences_in_flight[frame_idx]->wait();
+        }
 
         uint32_t img_idx;
         VkResult acquire_next_image_vk_result;
-        try
         {
-            img_idx = swapchain->acquire_next_image(
-                semaphs_image_available[frame_idx],
-                nullptr,
-                UINT64_MAX,
-                &acquire_next_image_vk_result
+            beva_demos::ScopedTimer timer(stats.current().acquire_ms);
+            acquire_next_image_vk_result = swapchain->try_acquire_next_image(
+                img_idx,
+                semaphs_image_available[frame_idx]
             );
         }
-        catch (const bv::Error& e)
+        if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
         {
-            if (acquire_next_image_vk_result == VK_ERROR_OUT_OF_DATE_KHR)
-            {
-                recreate_swapchain();
-                return;
-            }
-            else
-            {
-                throw e;
-            }
+            recreate_swapchain();
+            return;
+        }
+        else if (acquire_next_image_vk_result != VK_SUCCESS
+            && acquire_next_image_vk_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw bv::Error(
+                "failed to acquire next swapchain image",
+                acquire_next_image_vk_result,
+                false
+            );
         }
 
         update_uniform_buffer(frame_idx);
 
         fences_in_flight[frame_idx]->reset();
 
-        cmd_bufs[frame_idx]->reset(0);
-        record_command_buffer(cmd_bufs[frame_idx], img_idx);
-
-        graphics_present_queue->submit(
+        render_graph->set_imported_view(
+            rg_swapchain_img,
+            swapchain_imgviews[img_idx]
+        );
+        render_graph->execute(
+            frame_idx,
             { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
             { semaphs_image_available[frame_idx] },
-            { cmd_bufs[frame_idx] },
             { semaphs_render_finished[frame_idx] },
             fences_in_flight[frame_idx]
         );
 
+        if (dump_frame)
+        {
+            fences_in_flight[frame_idx]->wait();
+            beva_demos::dump_swapchain_image(
+                device,
+                mem_bank,
+                graphics_present_queue,
+                swapchain->images()[img_idx],
+                headless->dump_path
+            );
+        }
+
         VkResult present_vk_result;
-        try
         {
-            graphics_present_queue->present(
-                { semaphs_render_finished[frame_idx] },
+            beva_demos::ScopedTimer timer(stats.current().present_ms);
+            present_vk_result = graphics_present_queue->try_present(
+                std::span(&semaphs_render_finished[frame_idx], 1),
                 swapchain,
-                img_idx,
-                &present_vk_result
+                img_idx
             );
         }
-        catch (const bv::Error& e)
+        if (present_vk_result != VK_SUCCESS
+            && present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
+            && present_vk_result != VK_SUBOPTIMAL_KHR)
         {
-            if (present_vk_result != VK_ERROR_OUT_OF_DATE_KHR
-                && present_vk_result != VK_SUBOPTIMAL_KHR)
-            {
-                throw e;
-            }
+            throw bv::Error(
+                "failed to queue image for presentation",
+                present_vk_result,
+                false
+            );
         }
         if (present_vk_result == VK_ERROR_OUT_OF_DATE_KHR
             || present_vk_result == VK_SUBOPTIMAL_KHR
@@ -2725,12 +2594,15 @@ namespace beva_demo_03_deferred_rendering
 
     void App::recreate_swapchain()
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0)
+        if (!headless.has_value())
         {
+            int width = 0, height = 0;
             glfwGetFramebufferSize(window, &width, &height);
-            glfwWaitEvents();
+            while (width == 0 || height == 0)
+            {
+                glfwGetFramebufferSize(window, &width, &height);
+                glfwWaitEvents();
+            }
         }
 
         device->wait_idle();
@@ -2738,7 +2610,9 @@ namespace beva_demo_03_deferred_rendering
         cleanup_swapchain();
         create_swapchain();
 
-        gpass->recreate(*this);
+        // the pipelines stay valid since the render passes created by the
+        // graph are compatible with the old ones
+        build_render_graph();
         lpass->recreate(*this);
         fxaa_pass->recreate(*this);
     }
@@ -2993,7 +2867,7 @@ namespace beva_demo_03_deferred_rendering
         }
         };
 
-        vkCmdPipelineBarrier(
+        cmd_buf->dispatch().vkCmdPipelineBarrier(
             cmd_buf->handle(),
             src_stage,
             dst_stage,
@@ -3004,39 +2878,6 @@ namespace beva_demo_03_deferred_rendering
         );
     }
 
-    void App::copy_buffer_to_image(
-        const bv::CommandBufferPtr& cmd_buf,
-        const bv::BufferPtr& buffer,
-        const bv::ImagePtr& image,
-        uint32_t width,
-        uint32_t height,
-        VkDeviceSize buffer_offset
-    )
-    {
-        VkBufferImageCopy region{
-            .bufferOffset = buffer_offset,
-            .bufferRowLength = 0,
-            .bufferImageHeight = 0,
-            .imageSubresource = VkImageSubresourceLayers{
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .mipLevel = 0,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-        },
-            .imageOffset = { 0, 0, 0 },
-            .imageExtent = { width, height, 1 }
-        };
-
-        vkCmdCopyBufferToImage(
-            cmd_buf->handle(),
-            buffer->handle(),
-            image->handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region
-        );
-    }
-
     bv::ImageViewPtr App::create_image_view(
         const bv::ImagePtr& image,
         VkFormat format,
@@ -3091,82 +2932,8 @@ namespace beva_demo_03_deferred_rendering
         out_memory_chunk->bind(out_buffer);
     }
 
-    void App::copy_buffer(
-        const bv::CommandBufferPtr& cmd_buf,
-        bv::BufferPtr src,
-        bv::BufferPtr dst,
-        VkDeviceSize size
-    )
+    void App::set_viewport_and_scissor(const bv::CommandBufferPtr& cmd_buf)
     {
-        VkBufferCopy copy_region{
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size = size
-        };
-        vkCmdCopyBuffer(
-            cmd_buf->handle(),
-            src->handle(),
-            dst->handle(),
-            1,
-            &copy_region
-        );
-    }
-
-    void App::record_command_buffer(
-        const bv::CommandBufferPtr& cmd_buf,
-        uint32_t img_idx
-    )
-    {
-        cmd_buf->begin(0);
-
-        // geometry pass
-
-        std::array<VkClearValue, 3> gpass_clear_vals{};
-        gpass_clear_vals[0].color = { { .159f, .168f, .196f, 0.f } };
-        gpass_clear_vals[1].color = { { 0.f, 0.f, 0.f, 0.f } };
-        gpass_clear_vals[2].depthStencil = { 1.f, 0 };
-
-        VkRenderPassBeginInfo gpass_render_pass_info{
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .pNext = nullptr,
-            .renderPass = gpass->recreatables.render_pass->handle(),
-            .framebuffer = gpass->recreatables.framebuf->handle(),
-            .renderArea = VkRect2D{
-                .offset = { 0, 0 },
-                .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
-        },
-            .clearValueCount = (uint32_t)gpass_clear_vals.size(),
-            .pClearValues = gpass_clear_vals.data()
-        };
-        vkCmdBeginRenderPass(
-            cmd_buf->handle(),
-            &gpass_render_pass_info,
-            VK_SUBPASS_CONTENTS_INLINE
-        );
-
-        vkCmdBindPipeline(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            gpass->graphics_pipeline->handle()
-        );
-
-        VkBuffer gpass_vk_vertex_bufs[]{ vertex_buf->handle() };
-        VkDeviceSize gpass_vb_offsets[] = { 0 };
-        vkCmdBindVertexBuffers(
-            cmd_buf->handle(),
-            0,
-            1,
-            gpass_vk_vertex_bufs,
-            gpass_vb_offsets
-        );
-
-        vkCmdBindIndexBuffer(
-            cmd_buf->handle(),
-            index_buf->handle(),
-            0,
-            VK_INDEX_TYPE_UINT32
-        );
-
         VkViewport viewport{
             .x = 0.f,
             .y = 0.f,
@@ -3175,191 +2942,18 @@ namespace beva_demo_03_deferred_rendering
             .minDepth = 0.f,
             .maxDepth = 1.f
         };
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
-
-        VkRect2D scissor{
-            .offset = { 0, 0 },
-            .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
-        };
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
-
-        auto gpass_vk_descriptor_set =
-            gpass->descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            gpass->pipeline_layout->handle(),
-            0,
-            1,
-            &gpass_vk_descriptor_set,
-            0,
-            nullptr
-        );
-
-        vkCmdDrawIndexed(
-            cmd_buf->handle(),
-            (uint32_t)(indices.size()),
-            1,
-            0,
-            0,
-            0
-        );
-
-        vkCmdEndRenderPass(cmd_buf->handle());
-
-        // lighting pass
-
-        VkRenderPassBeginInfo lpass_render_pass_info{
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .pNext = nullptr,
-            .renderPass = lpass->recreatables.render_pass->handle(),
-            .framebuffer = lpass->recreatables.framebuf->handle(),
-            .renderArea = VkRect2D{
-                .offset = { 0, 0 },
-                .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
-        },
-            .clearValueCount = 0,
-            .pClearValues = nullptr
-        };
-        vkCmdBeginRenderPass(
-            cmd_buf->handle(),
-            &lpass_render_pass_info,
-            VK_SUBPASS_CONTENTS_INLINE
-        );
-
-        vkCmdBindPipeline(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            lpass->graphics_pipeline->handle()
-        );
-
-        VkBuffer lpass_vk_vertex_bufs[]{ quad_vertex_buf->handle() };
-        VkDeviceSize lpass_vb_offsets[] = { 0 };
-        vkCmdBindVertexBuffers(
-            cmd_buf->handle(),
-            0,
-            1,
-            lpass_vk_vertex_bufs,
-            lpass_vb_offsets
-        );
-
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
-
-        auto lpass_vk_descriptor_set =
-            lpass->descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            lpass->pipeline_layout->handle(),
-            0,
-            1,
-            &lpass_vk_descriptor_set,
-            0,
-            nullptr
-        );
-
-        vkCmdPushConstants(
-            cmd_buf->handle(),
-            lpass->pipeline_layout->handle(),
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(lpass->frag_push_constants),
-            &lpass->frag_push_constants
-        );
-
-        vkCmdDraw(
-            cmd_buf->handle(),
-            (uint32_t)quad_vertices.size(),
-            1,
-            0,
-            0
-        );
-
-        vkCmdEndRenderPass(cmd_buf->handle());
-
-        // FXAA (+ post processing) pass
-
-        VkRenderPassBeginInfo fxaa_pass_render_pass_info{
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .pNext = nullptr,
-            .renderPass = fxaa_pass->recreatables.render_pass->handle(),
-
-            .framebuffer =
-            fxaa_pass->recreatables.swapchain_framebufs[img_idx]->handle(),
-
-            .renderArea = VkRect2D{
-                .offset = { 0, 0 },
-                .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
-        },
-            .clearValueCount = 0,
-            .pClearValues = nullptr
-        };
-        vkCmdBeginRenderPass(
-            cmd_buf->handle(),
-            &fxaa_pass_render_pass_info,
-            VK_SUBPASS_CONTENTS_INLINE
-        );
-
-        vkCmdBindPipeline(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            fxaa_pass->graphics_pipeline->handle()
-        );
-
-        VkBuffer fxaa_pass_vk_vertex_bufs[]{ quad_vertex_buf->handle() };
-        VkDeviceSize fxaa_pass_vb_offsets[] = { 0 };
-        vkCmdBindVertexBuffers(
+        cmd_buf->dispatch().vkCmdSetViewport(
             cmd_buf->handle(),
             0,
             1,
-            fxaa_pass_vk_vertex_bufs,
-            fxaa_pass_vb_offsets
+            &viewport
         );
 
-        vkCmdSetViewport(cmd_buf->handle(), 0, 1, &viewport);
-        vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
-
-        auto fxaa_pass_vk_descriptor_set =
-            fxaa_pass->descriptor_sets[frame_idx]->handle();
-        vkCmdBindDescriptorSets(
-            cmd_buf->handle(),
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            fxaa_pass->pipeline_layout->handle(),
-            0,
-            1,
-            &fxaa_pass_vk_descriptor_set,
-            0,
-            nullptr
-        );
-
-        fxaa_pass->frag_push_constants = {
-            .do_nothing =
-            lpass->frag_push_constants.render_mode != RenderMode::Lit
-            ? 1 : 0,
-
-            .global_frame_idx = (uint32_t)global_frame_idx
+        VkRect2D scissor{
+            .offset = { 0, 0 },
+            .extent = bv::Extent2d_to_vk(swapchain->config().image_extent)
         };
-        vkCmdPushConstants(
-            cmd_buf->handle(),
-            fxaa_pass->pipeline_layout->handle(),
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            sizeof(fxaa_pass->frag_push_constants),
-            &fxaa_pass->frag_push_constants
-        );
-
-        vkCmdDraw(
-            cmd_buf->handle(),
-            (uint32_t)quad_vertices.size(),
-            1,
-            0,
-            0
-        );
-
-        vkCmdEndRenderPass(cmd_buf->handle());
-
-        cmd_buf->end();
+        cmd_buf->dispatch().vkCmdSetScissor(cmd_buf->handle(), 0, 1, &scissor);
     }
 
     void App::update_uniform_buffer(uint32_t frame_idx)
@@ -3428,28 +3022,6 @@ namespace beva_demo_03_deferred_rendering
         );
     }
 
-    static std::vector<uint8_t> read_file(const std::string& filename)
-    {
-        std::ifstream f(filename, std::ios::ate | std::ios::binary);
-        if (!f.is_open())
-        {
-            throw std::runtime_error(std::format(
-                "failed to read file \"{}\"",
-                filename
-            ).c_str());
-        }
-
-        size_t size_in_chars = (size_t)f.tellg();
-        size_t size_in_bytes = size_in_chars * sizeof(char);
-
-        std::vector<uint8_t> buf(size_in_bytes);
-        f.seekg(0);
-        f.read(reinterpret_cast<char*>(buf.data()), size_in_chars);
-        f.close();
-
-        return buf;
-    }
-
     static void glfw_error_callback(int error, const char* description)
     {
         std::cerr << std::format("GLFW error {}: {}\n", error, description);
@@ -12,6 +12,9 @@
 
 #include "beva/beva.hpp"
 
+#include "headless.hpp"
+#include "frame_stats.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_ENABLE_EXPERIMENTAL
@@ -124,7 +127,7 @@ namespace beva_demo_03_deferred_rendering
 
     class App;
 
-    struct GeometryPassRecreatables
+    struct GeometryPass
     {
         // alpha = metallic
         static constexpr VkFormat DIFFUSE_METALLIC_GBUF_FORMAT =
@@ -134,37 +137,11 @@ namespace beva_demo_03_deferred_rendering
         static constexpr VkFormat NORMAL_ROUGHNESS_GBUF_FORMAT =
             VK_FORMAT_R16G16B16A16_UNORM;
 
-        bv::ImagePtr diffuse_metallic_img = nullptr;
-        bv::MemoryChunkPtr diffuse_metallic_mem = nullptr;
-        bv::ImageViewPtr diffuse_metallic_view = nullptr;
+        // the G-Buffer images themselves are owned by the render graph
         bv::SamplerPtr diffuse_metallic_sampler = nullptr;
-
-        bv::ImagePtr normal_roughness_img = nullptr;
-        bv::MemoryChunkPtr normal_roughness_mem = nullptr;
-        bv::ImageViewPtr normal_roughness_view = nullptr;
         bv::SamplerPtr normal_roughness_sampler = nullptr;
-
-        bv::ImagePtr depth_img = nullptr;
-        bv::MemoryChunkPtr depth_img_mem = nullptr;
-        bv::ImageViewPtr depth_imgview = nullptr;
         bv::SamplerPtr depth_sampler = nullptr;
 
-        bv::RenderPassPtr render_pass = nullptr;
-        bv::FramebufferPtr framebuf = nullptr;
-
-        GeometryPassRecreatables(App& app);
-        ~GeometryPassRecreatables();
-
-    private:
-        void init(App& app);
-        void cleanup();
-
-        friend struct GeometryPass;
-
-    };
-
-    struct GeometryPass
-    {
         std::vector<bv::BufferPtr> uniform_bufs;
         std::vector<bv::MemoryChunkPtr> uniform_bufs_mem;
         std::vector<void*> uniform_bufs_mapped;
@@ -176,40 +153,19 @@ namespace beva_demo_03_deferred_rendering
         bv::DescriptorPoolPtr descriptor_pool = nullptr;
         std::vector<bv::DescriptorSetPtr> descriptor_sets;
 
-        GeometryPassRecreatables recreatables;
-
         GeometryPass(App& app);
         ~GeometryPass();
 
-        void recreate(App& app);
+        void record(App& app, const bv::CommandBufferPtr& cmd_buf);
     };
 
-    struct LightingPassRecreatables
+    struct LightingPass
     {
         static constexpr VkFormat LPASS_COLOR_FORMAT =
             VK_FORMAT_R16G16B16A16_SFLOAT;
 
-        bv::ImagePtr color_img = nullptr;
-        bv::MemoryChunkPtr color_img_mem = nullptr;
-        bv::ImageViewPtr color_imgview = nullptr;
         bv::SamplerPtr color_img_sampler = nullptr;
 
-        bv::RenderPassPtr render_pass = nullptr;
-        bv::FramebufferPtr framebuf;
-
-        LightingPassRecreatables(App& app);
-        ~LightingPassRecreatables();
-
-    private:
-        void init(App& app);
-        void cleanup();
-
-        friend struct LightingPass;
-
-    };
-
-    struct LightingPass
-    {
         std::array<Light, 4> lights;
 
         std::vector<bv::BufferPtr> light_bufs;
@@ -223,33 +179,18 @@ namespace beva_demo_03_deferred_rendering
         bv::DescriptorPoolPtr descriptor_pool = nullptr;
         std::vector<bv::DescriptorSetPtr> descriptor_sets;
 
-        LightingPassRecreatables recreatables;
-
         LightingPassFragPushConstants frag_push_constants;
 
         LightingPass(App& app);
         ~LightingPass();
 
+        // the G-Buffer views change whenever the render graph is rebuilt
         void recreate(App& app);
 
-    private:
-        void recreate_descriptor_sets(App& app);
-
-    };
-
-    struct FxaaPassRecreatables
-    {
-        bv::RenderPassPtr render_pass = nullptr;
-        std::vector<bv::FramebufferPtr> swapchain_framebufs;
-
-        FxaaPassRecreatables(App& app);
-        ~FxaaPassRecreatables();
+        void record(App& app, const bv::CommandBufferPtr& cmd_buf);
 
     private:
-        void init(App& app);
-        void cleanup();
-
-        friend struct FxaaPass;
+        void recreate_descriptor_sets(App& app);
 
     };
 
@@ -262,8 +203,6 @@ namespace beva_demo_03_deferred_rendering
         bv::DescriptorPoolPtr descriptor_pool = nullptr;
         std::vector<bv::DescriptorSetPtr> descriptor_sets;
 
-        FxaaPassRecreatables recreatables;
-
         FxaaPassFragPushConstants frag_push_constants;
 
         FxaaPass(App& app);
@@ -271,6 +210,8 @@ namespace beva_demo_03_deferred_rendering
 
         void recreate(App& app);
 
+        void record(App& app, const bv::CommandBufferPtr& cmd_buf);
+
     private:
         void recreate_descriptor_sets(App& app);
 
@@ -280,8 +221,18 @@ namespace beva_demo_03_deferred_rendering
     {
     public:
         App() = default;
+
+        // run without a window, see beva_demos::HeadlessConfig
+        App(const beva_demos::HeadlessConfig& headless_config);
+
         void run();
 
+        // only recorded in headless mode
+        constexpr const beva_demos::FrameStats& frame_stats() const
+        {
+            return stats;
+        }
+
     private:
         static constexpr const char* TITLE =
             "beva demo: deferred lighting";
@@ -291,6 +242,11 @@ namespace beva_demo_03_deferred_rendering
         static constexpr bool DEBUG_MODE = true;
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
+        // loaded at startup and saved at exit so that pipelines don't
+        // have to be compiled from scratch every time
+        static constexpr const char* PIPELINE_CACHE_PATH =
+            "pipeline_cache_03.bin";
+
         static constexpr const char* MODEL_PATH =
             "./models/korean_fire_extinguisher_01_mod.obj";
 
@@ -323,7 +279,13 @@ namespace beva_demo_03_deferred_rendering
         std::optional<bv::PhysicalDevice> physical_device;
         bv::DevicePtr device = nullptr;
         bv::QueuePtr graphics_present_queue = nullptr;
+        bv::QueuePtr transfer_queue = nullptr;
         bv::MemoryBankPtr mem_bank = nullptr;
+        bv::PipelineCachePtr pipeline_cache = nullptr;
+
+        // the lighting and FXAA passes share the fullscreen vertex shader
+        bv::ShaderModuleRegistryPtr shader_registry = nullptr;
+        bv::UploadEnginePtr upload_engine = nullptr;
         bv::CommandPoolPtr cmd_pool = nullptr;
         bv::CommandPoolPtr transient_cmd_pool = nullptr;
 
@@ -352,20 +314,40 @@ namespace beva_demo_03_deferred_rendering
         bv::BufferPtr quad_vertex_buf = nullptr;
         bv::MemoryChunkPtr quad_vertex_buf_mem = nullptr;
 
+        // the render graph owns the G-Buffer and the lighting pass output,
+        // as well as the render passes, framebuffers, and command buffers.
+        // it's rebuilt whenever the swapchain is recreated.
+        bv::RenderGraphPtr render_graph = nullptr;
+        bv::RenderGraphImageId rg_diffuse_metallic = 0;
+        bv::RenderGraphImageId rg_normal_roughness = 0;
+        bv::RenderGraphImageId rg_depth = 0;
+        bv::RenderGraphImageId rg_lpass_color = 0;
+        bv::RenderGraphImageId rg_swapchain_img = 0;
+        bv::RenderGraphPassId rg_gpass = 0;
+        bv::RenderGraphPassId rg_lpass = 0;
+        bv::RenderGraphPassId rg_fxaa_pass = 0;
+
         // geometry pass, lighting pass, and FXAA (+ post processing) pass
         std::shared_ptr<GeometryPass> gpass = nullptr;
         std::shared_ptr<LightingPass> lpass = nullptr;
         std::shared_ptr<FxaaPass> fxaa_pass;
 
         // "per frame" stuff (as in frames in flight)
-        std::vector<bv::CommandBufferPtr> cmd_bufs;
         std::vector<bv::SemaphorePtr> semaphs_image_available;
         std::vector<bv::SemaphorePtr> semaphs_render_finished;
         std::vector<bv::FencePtr> fences_in_flight;
 
         uint32_t graphics_present_family_idx = 0;
+        uint32_t transfer_family_idx = 0;
 
         bool framebuf_resized = false;
+
+        std::optional<beva_demos::HeadlessConfig> headless;
+
+        // whether draw_frame() should dump the frame it renders
+        bool dump_frame = false;
+
+        beva_demos::FrameStats stats;
         uint32_t frame_idx = 0;
         uint64_t global_frame_idx = 0;
 
@@ -389,6 +371,9 @@ namespace beva_demo_03_deferred_rendering
         void pick_physical_device();
         void create_logical_device();
         void create_memory_bank();
+        void create_pipeline_cache();
+        void create_shader_registry();
+        void create_upload_engine();
         void create_command_pools();
         void create_swapchain();
 
@@ -399,9 +384,10 @@ namespace beva_demo_03_deferred_rendering
         void create_index_buffer();
         void create_quad_vertex_buffer();
 
+        void create_render_graph();
+        void build_render_graph();
         void create_passes();
 
-        void create_command_buffers();
         void create_sync_objects();
 
         void update_lights();
@@ -460,15 +446,6 @@ namespace beva_demo_03_deferred_rendering
             bool vertex_shader = false
         );
 
-        void copy_buffer_to_image(
-            const bv::CommandBufferPtr& cmd_buf,
-            const bv::BufferPtr& buffer,
-            const bv::ImagePtr& image,
-            uint32_t width,
-            uint32_t height,
-            VkDeviceSize buffer_offset = 0
-        );
-
         bv::ImageViewPtr create_image_view(
             const bv::ImagePtr& image,
             VkFormat format,
@@ -484,17 +461,8 @@ namespace beva_demo_03_deferred_rendering
             bv::MemoryChunkPtr& out_memory_chunk
         );
 
-        void copy_buffer(
-            const bv::CommandBufferPtr& cmd_buf,
-            bv::BufferPtr src,
-            bv::BufferPtr dst,
-            VkDeviceSize size
-        );
-
-        void record_command_buffer(
-            const bv::CommandBufferPtr& cmd_buf,
-            uint32_t img_idx
-        );
+        // the passes use dynamic viewport and scissor states
+        void set_viewport_and_scissor(const bv::CommandBufferPtr& cmd_buf);
 
         void update_uniform_buffer(uint32_t frame_idx);
 
@@ -505,11 +473,8 @@ namespace beva_demo_03_deferred_rendering
             GLFWwindow* window, int key, int scancode, int action, int mods
         );
 
-        friend struct GeometryPassRecreatables;
         friend struct GeometryPass;
-        friend struct LightingPassRecreatables;
         friend struct LightingPass;
-        friend struct FxaaPassRecreatables;
         friend struct FxaaPass;
 
     };
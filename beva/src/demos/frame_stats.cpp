@@ -0,0 +1,239 @@
+#include "frame_stats.hpp"
+
+#include "beva/beva.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <format>
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static std::atomic<uint64_t> n_host_allocations{ 0 };
+
+static void* counted_malloc(std::size_t size)
+{
+    n_host_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* counted_aligned_malloc(std::size_t size, std::align_val_t al)
+{
+    n_host_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t alignment = (std::size_t)al;
+#ifdef _WIN32
+    return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    // std::aligned_alloc() wants a multiple of the alignment
+    std::size_t aligned_size =
+        (std::max(size, (std::size_t)1) + alignment - 1) & ~(alignment - 1);
+    return std::aligned_alloc(alignment, aligned_size);
+#endif
+}
+
+static void aligned_free(void* ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+// count every heap allocation made through the global operator new. the
+// plain, nothrow, and aligned versions are all replaced because the
+// standard library may implement them separately. the array versions call
+// these.
+void* operator new(std::size_t size)
+{
+    void* ptr = counted_malloc(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_malloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t al)
+{
+    void* ptr = counted_aligned_malloc(size, al);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(
+    std::size_t size,
+    std::align_val_t al,
+    const std::nothrow_t&
+) noexcept
+{
+    return counted_aligned_malloc(size, al);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t size) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t al) noexcept
+{
+    aligned_free(ptr);
+}
+
+void operator delete(
+    void* ptr,
+    std::size_t size,
+    std::align_val_t al
+) noexcept
+{
+    aligned_free(ptr);
+}
+
+void operator delete(
+    void* ptr,
+    std::align_val_t al,
+    const std::nothrow_t&
+) noexcept
+{
+    aligned_free(ptr);
+}
+
+namespace beva_demos
+{
+
+    static double elapsed_ms(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+    }
+
+    void FrameStats::reserve(size_t n_frames)
+    {
+        _frames.reserve(n_frames);
+    }
+
+    void FrameStats::begin_frame()
+    {
+        _current = FrameTimings{};
+        frame_start_n_host_allocations = host_allocation_count();
+        frame_start_n_submits = bv::submit_count();
+        bv::reset_stall_stats();
+        frame_start = std::chrono::steady_clock::now();
+    }
+
+    void FrameStats::end_frame()
+    {
+        _current.frame_ms = elapsed_ms(frame_start);
+        _current.stall_ms = bv::total_stall_stats().total_ms();
+        _current.n_host_allocations =
+            host_allocation_count() - frame_start_n_host_allocations;
+        _current.n_submits =
+            (uint32_t)(bv::submit_count() - frame_start_n_submits);
+        _frames.push_back(_current);
+    }
+
+    std::string FrameStats::to_json(
+        const std::string& name,
+        size_t n_warmup_frames
+    ) const
+    {
+        size_t first = std::min(n_warmup_frames, _frames.size());
+        size_t n = _frames.size() - first;
+
+        std::vector<double> frame_ms;
+        frame_ms.reserve(n);
+        FrameTimings sums{};
+        for (size_t i = first; i < _frames.size(); i++)
+        {
+            const auto& frame = _frames[i];
+            frame_ms.push_back(frame.frame_ms);
+            sums.frame_ms += frame.frame_ms;
+            sums.fence_wait_ms += frame.fence_wait_ms;
+            sums.acquire_ms += frame.acquire_ms;
+            sums.present_ms += frame.present_ms;
+            sums.stall_ms += frame.stall_ms;
+            sums.n_submits += frame.n_submits;
+            sums.n_host_allocations += frame.n_host_allocations;
+        }
+        std::sort(frame_ms.begin(), frame_ms.end());
+
+        // lower nearest rank, no interpolation
+        auto percentile = [&](double p)
+        {
+            if (frame_ms.empty())
+            {
+                return 0.;
+            }
+            size_t rank = (size_t)(p / 100. * (double)(frame_ms.size() - 1));
+            return frame_ms[rank];
+        };
+        double n_frames = std::max((double)n, 1.);
+
+        return std::format(
+            "{{"
+            "\"demo\": \"{}\", "
+            "\"frames\": {}, "
+            "\"cpu_frame_ms\": {{"
+            "\"mean\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, "
+            "\"p99\": {:.4f}, \"max\": {:.4f}"
+            "}}, "
+            "\"fence_wait_ms_per_frame\": {:.4f}, "
+            "\"acquire_ms_per_frame\": {:.4f}, "
+            "\"present_ms_per_frame\": {:.4f}, "
+            "\"stall_ms_per_frame\": {:.4f}, "
+            "\"submits_per_frame\": {:.2f}, "
+            "\"host_allocations_per_frame\": {:.2f}"
+            "}}",
+            name,
+            n,
+            sums.frame_ms / n_frames,
+            percentile(50.),
+            percentile(90.),
+            percentile(99.),
+            frame_ms.empty() ? 0. : frame_ms.back(),
+            sums.fence_wait_ms / n_frames,
+            sums.acquire_ms / n_frames,
+            sums.present_ms / n_frames,
+            sums.stall_ms / n_frames,
+            (double)sums.n_submits / n_frames,
+            (double)sums.n_host_allocations / n_frames
+        );
+    }
+
+    ScopedTimer::ScopedTimer(double& out_ms)
+        : out_ms(out_ms), start(std::chrono::steady_clock::now())
+    {}
+
+    ScopedTimer::~ScopedTimer()
+    {
+        out_ms += elapsed_ms(start);
+    }
+
+    uint64_t host_allocation_count()
+    {
+        return n_host_allocations.load(std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace beva_demos
+{
+
+    // CPU timings of a single frame in milliseconds
+    struct FrameTimings
+    {
+        // from the start of the frame to the end of draw_frame()
+        double frame_ms = 0.;
+
+        double fence_wait_ms = 0.;
+        double acquire_ms = 0.;
+        double present_ms = 0.;
+
+        // time blocked in any of beva's blocking calls (including the ones
+        // above) according to bv::total_stall_stats()
+        double stall_ms = 0.;
+
+        // according to bv::submit_count()
+        uint32_t n_submits = 0;
+        uint64_t n_host_allocations = 0;
+    };
+
+    // collects FrameTimings for every frame of a headless run. beva's stall
+    // statistics are reset at the beginning of every frame.
+    class FrameStats
+    {
+    public:
+        // reserve memory for n_frames frames so that recording doesn't
+        // allocate
+        void reserve(size_t n_frames);
+
+        void begin_frame();
+        void end_frame();
+
+        // the frame between begin_frame() and end_frame()
+        constexpr FrameTimings& current()
+        {
+            return _current;
+        }
+
+        constexpr const std::vector<FrameTimings>& frames() const
+        {
+            return _frames;
+        }
+
+        // JSON object with frame time percentiles and per frame averages of
+        // the other timings. the first n_warmup_frames frames are ignored.
+        std::string to_json(
+            const std::string& name,
+            size_t n_warmup_frames
+        ) const;
+
+    private:
+        std::vector<FrameTimings> _frames;
+        FrameTimings _current;
+
+        std::chrono::steady_clock::time_point frame_start;
+        uint64_t frame_start_n_host_allocations = 0;
+        uint64_t frame_start_n_submits = 0;
+
+    };
+
+    // adds the time between its construction and destruction to out_ms
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(double& out_ms);
+        ~ScopedTimer();
+
+    private:
+        double& out_ms;
+        std::chrono::steady_clock::time_point start;
+
+    };
+
+    // number of calls to the global operator new since the program started
+    uint64_t host_allocation_count();
+
+}
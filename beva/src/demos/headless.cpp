@@ -0,0 +1,91 @@
+#include "headless.hpp"
+
+#include <fstream>
+#include <format>
+#include <stdexcept>
+
+namespace beva_demos
+{
+
+    std::vector<std::string> headless_instance_extensions()
+    {
+        return {
+            VK_KHR_SURFACE_EXTENSION_NAME,
+            VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME
+        };
+    }
+
+    void dump_swapchain_image(
+        const bv::DevicePtr& device,
+        const bv::MemoryBankPtr& mem_bank,
+        const bv::QueuePtr& queue,
+        const bv::ImagePtr& image,
+        const std::string& path
+    )
+    {
+        const auto& image_config = image->config();
+
+        bool is_bgra;
+        switch (image_config.format)
+        {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            is_bgra = true;
+            break;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            is_bgra = false;
+            break;
+        default:
+            throw std::runtime_error(
+                "failed to dump swapchain image: unsupported format"
+            );
+        }
+
+        uint32_t width = image_config.extent.width;
+        uint32_t height = image_config.extent.height;
+        VkDeviceSize size = (VkDeviceSize)width * height * 4;
+
+        // a fence is enough here, so we don't need the timeline semaphore
+        // feature to be enabled
+        auto readback_engine = bv::ReadbackEngine::create(
+            device,
+            mem_bank,
+            {
+                .queue = queue,
+                .staging_size = (size + 15) / 16 * 16,
+                .use_timeline_semaphore = false
+            }
+        );
+
+        std::vector<uint8_t> rgb((size_t)width * height * 3);
+        readback_engine->readback_image(
+            image,
+            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            size,
+            [&](std::span<const uint8_t> data)
+            {
+                for (size_t i = 0; i < (size_t)width * height; i++)
+                {
+                    rgb[i * 3 + 0] = data[i * 4 + (is_bgra ? 2 : 0)];
+                    rgb[i * 3 + 1] = data[i * 4 + 1];
+                    rgb[i * 3 + 2] = data[i * 4 + (is_bgra ? 0 : 2)];
+                }
+            }
+        );
+        readback_engine->wait_idle();
+
+        std::ofstream f(path, std::ios::binary);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(std::format(
+                "failed to write file \"{}\"",
+                path
+            ).c_str());
+        }
+        f << std::format("P6\n{} {}\n255\n", width, height);
+        f.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+        f.close();
+    }
+
+}
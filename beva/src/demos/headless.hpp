@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+
+#include "beva/beva.hpp"
+
+namespace beva_demos
+{
+
+    // makes a demo run without a window. frames are presented to a swapchain
+    // on a headless surface (VK_EXT_headless_surface), so the rendering code
+    // is the same as usual. input is ignored (demos with a camera follow a
+    // fixed path instead) and the physical device prompt is skipped.
+    struct HeadlessConfig
+    {
+        uint32_t width = 1280;
+        uint32_t height = 720;
+
+        // number of frames to render before returning from App::run()
+        uint64_t n_frames = 1000;
+
+        // animations advance by this many seconds per frame instead of
+        // following the clock, so every run renders the same frames
+        float time_step = 1.f / 60.f;
+
+        // index into the list of supported physical devices
+        uint32_t physical_device_idx = 0;
+
+        // run demo 02's simulation on a queue family with compute but no
+        // graphics support. ignored (with a warning) if there's no such
+        // family, like on Lavapipe.
+        bool async_compute = false;
+
+        // if not empty, the last frame is written to this path as a binary
+        // PPM image
+        std::string dump_path;
+    };
+
+    // instance extensions needed for creating a headless surface
+    std::vector<std::string> headless_instance_extensions();
+
+    // read back a swapchain image and write it to path as a binary PPM image.
+    // the image must be acquired, in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, created
+    // with VK_IMAGE_USAGE_TRANSFER_SRC_BIT, and not in use by the device.
+    // only 8-bit RGBA and BGRA formats are supported.
+    void dump_swapchain_image(
+        const bv::DevicePtr& device,
+        const bv::MemoryBankPtr& mem_bank,
+        const bv::QueuePtr& queue,
+        const bv::ImagePtr& image,
+        const std::string& path
+    );
+
+}
@@ -1,5 +1,28 @@
 #include "beva.hpp"
 
+// QueryPerformanceFrequency() for calibrated timestamps, file mapping for
+// PipelineCache::load() and flushed writes for write_file_atomically()
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+
+#ifdef BV_ENABLE_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
 // define a derived class named ClassName_public_ctor that lets us use the
 // previously private constructors (actually protected, just go with it) as
 // public ones so that they can be used in std::make_shared() or whatever
@@ -36,9 +59,12 @@ namespace bv
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(GraphicsPipeline);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(ComputePipeline);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(Framebuffer);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(FramebufferCache);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(CommandBuffer);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(CommandPool);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(Semaphore);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(TimelineSemaphore);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(FramePacer);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(Fence);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(Buffer);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(DeviceMemory);
@@ -46,10 +72,23 @@ namespace bv
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(DescriptorPool);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(BufferView);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(PipelineCache);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(PipelineCompiler);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(PipelineRegistry);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(PipelineLibraryLinker);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(ShaderModuleRegistry);
+#ifdef BV_ENABLE_SHADERC
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(GlslCompiler);
+#endif
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(QueryPool);
 
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(MemoryRegion);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(MemoryChunk);
     _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(MemoryBank);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(RenderGraph);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(UploadEngine);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(ReadbackEngine);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(GpuProfiler);
+    _BV_DEFINE_DERIVED_WITH_PUBLIC_CONSTRUCTOR(ComputeWorkgroupTuner);
 
 #define _BV_LOCK_WPTR_OR_RETURN(wptr, locked_name) \
     if (wptr.expired()) \
@@ -98,41 +137,260 @@ namespace bv
 
 #pragma endregion
 
-#pragma region Vulkan function loaders for extensions
+#pragma region Vulkan function loaders
+
+#define _BV_LOAD_INSTANCE_FUNCTION(name) \
+    dispatch->name = (PFN_##name)vkGetInstanceProcAddr(instance, #name);
+
+#define _BV_LOAD_DEVICE_FUNCTION(name) \
+    dispatch->name = (PFN_##name)get_device_proc_addr(device, #name);
+
+#define _BV_LOAD_DEVICE_FUNCTION_CORE_OR_KHR(name) \
+    dispatch->name = (PFN_##name)get_device_proc_addr(device, #name); \
+    if (dispatch->name == nullptr) \
+    { \
+        dispatch->name = \
+            (PFN_##name)get_device_proc_addr(device, #name "KHR"); \
+    }
+
+#define _BV_LOAD_DEVICE_FUNCTION_CORE_OR_EXT(name) \
+    dispatch->name = (PFN_##name)get_device_proc_addr(device, #name); \
+    if (dispatch->name == nullptr) \
+    { \
+        dispatch->name = \
+            (PFN_##name)get_device_proc_addr(device, #name "EXT"); \
+    }
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetInstanceProcAddr.html
+    static std::shared_ptr<const InstanceDispatch> load_instance_dispatch(
+        VkInstance instance
+    )
+    {
+        auto dispatch = std::make_shared<InstanceDispatch>();
+        _BV_INSTANCE_FUNCTIONS(_BV_LOAD_INSTANCE_FUNCTION)
+        return dispatch;
+    }
+
+    // functions promoted to core are only available under their core names on
+    // devices created with a recent enough API version, and only under their
+    // KHR or EXT names on older ones that enable the extension.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetDeviceProcAddr.html
+    static std::shared_ptr<const DeviceDispatch> load_device_dispatch(
+        const InstanceDispatch& instance_dispatch,
+        VkDevice device
+    )
+    {
+        PFN_vkGetDeviceProcAddr get_device_proc_addr =
+            instance_dispatch.vkGetDeviceProcAddr;
+
+        auto dispatch = std::make_shared<DeviceDispatch>();
+        _BV_DEVICE_FUNCTIONS(_BV_LOAD_DEVICE_FUNCTION)
+        _BV_DEVICE_FUNCTIONS_CORE_OR_KHR(_BV_LOAD_DEVICE_FUNCTION_CORE_OR_KHR)
+        _BV_DEVICE_FUNCTIONS_CORE_OR_EXT(_BV_LOAD_DEVICE_FUNCTION_CORE_OR_EXT)
+        return dispatch;
+    }
+
+    // the functions below are provided by extensions (or promoted to core) so
+    // their dispatch table entries might be nullptr.
 
     static VkResult CreateDebugUtilsMessengerEXT(
+        const InstanceDispatch& dispatch,
         VkInstance instance,
         const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
         const VkAllocationCallbacks* pAllocator,
         VkDebugUtilsMessengerEXT* pDebugMessenger
     )
     {
-        auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(
-            instance,
-            "vkCreateDebugUtilsMessengerEXT"
-        );
-        if (func != nullptr)
-        {
-            return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
-        }
-        else
+        if (dispatch.vkCreateDebugUtilsMessengerEXT == nullptr)
         {
             return VK_ERROR_EXTENSION_NOT_PRESENT;
         }
+        return dispatch.vkCreateDebugUtilsMessengerEXT(
+            instance,
+            pCreateInfo,
+            pAllocator,
+            pDebugMessenger
+        );
     }
     static void DestroyDebugUtilsMessengerEXT(
+        const InstanceDispatch& dispatch,
         VkInstance instance,
         VkDebugUtilsMessengerEXT debugMessenger,
         const VkAllocationCallbacks* pAllocator
     )
     {
-        auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(
+        if (dispatch.vkDestroyDebugUtilsMessengerEXT != nullptr)
+        {
+            dispatch.vkDestroyDebugUtilsMessengerEXT(
+                instance,
+                debugMessenger,
+                pAllocator
+            );
+        }
+    }
+
+    static VkResult CreateHeadlessSurfaceEXT(
+        const InstanceDispatch& dispatch,
+        VkInstance instance,
+        const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo,
+        const VkAllocationCallbacks* pAllocator,
+        VkSurfaceKHR* pSurface
+    )
+    {
+        if (dispatch.vkCreateHeadlessSurfaceEXT == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkCreateHeadlessSurfaceEXT(
             instance,
-            "vkDestroyDebugUtilsMessengerEXT"
+            pCreateInfo,
+            pAllocator,
+            pSurface
+        );
+    }
+
+    static VkResult QueueSubmit2KHR(
+        const DeviceDispatch& dispatch,
+        VkQueue queue,
+        uint32_t submitCount,
+        const VkSubmitInfo2* pSubmits,
+        VkFence fence
+    )
+    {
+        if (dispatch.vkQueueSubmit2 == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkQueueSubmit2(queue, submitCount, pSubmits, fence);
+    }
+    static VkResult CmdPipelineBarrier2KHR(
+        const DeviceDispatch& dispatch,
+        VkCommandBuffer commandBuffer,
+        const VkDependencyInfo* pDependencyInfo
+    )
+    {
+        if (dispatch.vkCmdPipelineBarrier2 == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        dispatch.vkCmdPipelineBarrier2(commandBuffer, pDependencyInfo);
+        return VK_SUCCESS;
+    }
+    static VkResult CmdBeginRenderingKHR(
+        const DeviceDispatch& dispatch,
+        VkCommandBuffer commandBuffer,
+        const VkRenderingInfo* pRenderingInfo
+    )
+    {
+        if (dispatch.vkCmdBeginRendering == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        dispatch.vkCmdBeginRendering(commandBuffer, pRenderingInfo);
+        return VK_SUCCESS;
+    }
+    static VkResult CmdEndRenderingKHR(
+        const DeviceDispatch& dispatch,
+        VkCommandBuffer commandBuffer
+    )
+    {
+        if (dispatch.vkCmdEndRendering == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        dispatch.vkCmdEndRendering(commandBuffer);
+        return VK_SUCCESS;
+    }
+    static VkResult GetSemaphoreCounterValueKHR(
+        const DeviceDispatch& dispatch,
+        VkDevice device,
+        VkSemaphore semaphore,
+        uint64_t* pValue
+    )
+    {
+        if (dispatch.vkGetSemaphoreCounterValue == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkGetSemaphoreCounterValue(device, semaphore, pValue);
+    }
+    static VkResult SignalSemaphoreKHR(
+        const DeviceDispatch& dispatch,
+        VkDevice device,
+        const VkSemaphoreSignalInfo* pSignalInfo
+    )
+    {
+        if (dispatch.vkSignalSemaphore == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkSignalSemaphore(device, pSignalInfo);
+    }
+    static VkResult WaitSemaphoresKHR(
+        const DeviceDispatch& dispatch,
+        VkDevice device,
+        const VkSemaphoreWaitInfo* pWaitInfo,
+        uint64_t timeout
+    )
+    {
+        if (dispatch.vkWaitSemaphores == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkWaitSemaphores(device, pWaitInfo, timeout);
+    }
+
+    static VkResult GetPhysicalDeviceCalibrateableTimeDomainsEXT(
+        const InstanceDispatch& dispatch,
+        VkPhysicalDevice physicalDevice,
+        uint32_t* pTimeDomainCount,
+        VkTimeDomainEXT* pTimeDomains
+    )
+    {
+        if (dispatch.vkGetPhysicalDeviceCalibrateableTimeDomainsEXT == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+            physicalDevice,
+            pTimeDomainCount,
+            pTimeDomains
+        );
+    }
+    static VkResult GetCalibratedTimestampsEXT(
+        const DeviceDispatch& dispatch,
+        VkDevice device,
+        uint32_t timestampCount,
+        const VkCalibratedTimestampInfoEXT* pTimestampInfos,
+        uint64_t* pTimestamps,
+        uint64_t* pMaxDeviation
+    )
+    {
+        if (dispatch.vkGetCalibratedTimestampsEXT == nullptr)
+        {
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        return dispatch.vkGetCalibratedTimestampsEXT(
+            device,
+            timestampCount,
+            pTimestampInfos,
+            pTimestamps,
+            pMaxDeviation
         );
-        if (func != nullptr)
+    }
+
+    // the dynamic state commands return void so instead of wrapping each one
+    // we just check that it was loaded before calling it.
+    template<typename PFN>
+    static void check_command_loaded(PFN command, const std::string& action)
+    {
+        if (command == nullptr)
         {
-            func(instance, debugMessenger, pAllocator);
+            throw Error(
+                "failed to " + action,
+                VK_ERROR_EXTENSION_NOT_PRESENT,
+                false
+            );
         }
     }
 
@@ -918,2435 +1176,11421 @@ namespace bv
         };
     }
 
-    Extent3d Extent3d_from_vk(const VkExtent3D& vk_extent_3d)
+    PhysicalDeviceVulkan11Features PhysicalDeviceVulkan11Features_from_vk(
+        const VkPhysicalDeviceVulkan11Features& vk_features
+    )
     {
-        return Extent3d{
-            .width = vk_extent_3d.width,
-            .height = vk_extent_3d.height,
-            .depth = vk_extent_3d.depth
-        };
-    }
+        return PhysicalDeviceVulkan11Features{
+            .storage_buffer_16bit_access =
+            (bool)vk_features.storageBuffer16BitAccess,
 
-    VkExtent3D Extent3d_to_vk(const Extent3d& extent_3d)
-    {
-        return VkExtent3D{
-            .width = extent_3d.width,
-            .height = extent_3d.height,
-            .depth = extent_3d.depth
-        };
-    }
+            .uniform_and_storage_buffer_16bit_access =
+            (bool)vk_features.uniformAndStorageBuffer16BitAccess,
 
-    Extent2d Extent2d_from_vk(const VkExtent2D& vk_extent_2d)
-    {
-        return Extent2d{
-            .width = vk_extent_2d.width,
-            .height = vk_extent_2d.height
-        };
-    }
+            .storage_push_constant16 =
+            (bool)vk_features.storagePushConstant16,
 
-    VkExtent2D Extent2d_to_vk(const Extent2d& extent_2d)
-    {
-        return VkExtent2D{
-            .width = extent_2d.width,
-            .height = extent_2d.height
-        };
-    }
+            .storage_input_output16 =
+            (bool)vk_features.storageInputOutput16,
 
-    QueueFamily QueueFamily_from_vk(const VkQueueFamilyProperties& vk_family)
-    {
-        return QueueFamily{
-            .queue_flags = vk_family.queueFlags,
-            .queue_count = vk_family.queueCount,
-            .timestamp_valid_bits = vk_family.timestampValidBits,
-            .min_image_transfer_granularity = Extent3d_from_vk(
-                vk_family.minImageTransferGranularity
-            )
-        };
-    }
+            .multiview =
+            (bool)vk_features.multiview,
 
-    SurfaceCapabilities SurfaceCapabilities_from_vk(
-        const VkSurfaceCapabilitiesKHR& vk_capabilities
-    )
-    {
-        return SurfaceCapabilities{
-            .min_image_count = vk_capabilities.minImageCount,
-            .max_image_count = vk_capabilities.maxImageCount,
-            .current_extent = Extent2d_from_vk(vk_capabilities.currentExtent),
-            .min_image_extent = Extent2d_from_vk(
-                vk_capabilities.minImageExtent
-            ),
-            .max_image_extent = Extent2d_from_vk(
-                vk_capabilities.maxImageExtent
-            ),
-            .max_image_array_layers = vk_capabilities.maxImageArrayLayers,
-            .supported_transforms = vk_capabilities.supportedTransforms,
-            .current_transform = vk_capabilities.currentTransform,
+            .multiview_geometry_shader =
+            (bool)vk_features.multiviewGeometryShader,
 
-            .supported_composite_alpha =
-            vk_capabilities.supportedCompositeAlpha,
+            .multiview_tessellation_shader =
+            (bool)vk_features.multiviewTessellationShader,
 
-            .supported_usage_flags = vk_capabilities.supportedUsageFlags
-        };
-    }
+            .variable_pointers_storage_buffer =
+            (bool)vk_features.variablePointersStorageBuffer,
 
-    SurfaceFormat SurfaceFormat_from_vk(
-        const VkSurfaceFormatKHR& vk_surface_format
-    )
-    {
-        return SurfaceFormat{
-            .format = vk_surface_format.format,
-            .color_space = vk_surface_format.colorSpace
-        };
-    }
+            .variable_pointers =
+            (bool)vk_features.variablePointers,
 
-    DebugLabel DebugLabel_from_vk(const VkDebugUtilsLabelEXT& vk_label)
-    {
-        return DebugLabel{
-            .name = cstr_to_std(vk_label.pLabelName),
-            .color = raw_arr_to_std<4>(vk_label.color)
-        };
-    }
+            .protected_memory =
+            (bool)vk_features.protectedMemory,
 
-    DebugObjectInfo DebugObjectInfo_from_vk(
-        const VkDebugUtilsObjectNameInfoEXT& vk_info
-    )
-    {
-        return DebugObjectInfo{
-            .type = vk_info.objectType,
-            .handle = vk_info.objectHandle,
-            .name = cstr_to_std(vk_info.pObjectName)
+            .sampler_ycbcr_conversion =
+            (bool)vk_features.samplerYcbcrConversion,
+
+            .shader_draw_parameters =
+            (bool)vk_features.shaderDrawParameters
         };
     }
 
-    DebugMessageData DebugMessageData_from_vk(
-        const VkDebugUtilsMessengerCallbackDataEXT& vk_data
+    VkPhysicalDeviceVulkan11Features PhysicalDeviceVulkan11Features_to_vk(
+        const PhysicalDeviceVulkan11Features& features
     )
     {
-        std::vector<DebugLabel> queue_labels;
-        for (size_t i = 0; i < vk_data.queueLabelCount; i++)
-        {
-            queue_labels.push_back(
-                DebugLabel_from_vk(vk_data.pQueueLabels[i])
-            );
-        }
+        return VkPhysicalDeviceVulkan11Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+            .pNext = nullptr,
 
-        std::vector<DebugLabel> cmd_buf_labels;
-        for (size_t i = 0; i < vk_data.cmdBufLabelCount; i++)
-        {
-            cmd_buf_labels.push_back(
-                DebugLabel_from_vk(vk_data.pCmdBufLabels[i])
-            );
-        }
+            .storageBuffer16BitAccess =
+            features.storage_buffer_16bit_access,
 
-        std::vector<DebugObjectInfo> objects;
-        for (size_t i = 0; i < vk_data.objectCount; i++)
-        {
-            objects.push_back(
-                DebugObjectInfo_from_vk(vk_data.pObjects[i])
-            );
-        }
+            .uniformAndStorageBuffer16BitAccess =
+            features.uniform_and_storage_buffer_16bit_access,
 
-        return DebugMessageData{
-            .message_id_name = cstr_to_std(vk_data.pMessageIdName),
-            .message_id_number = vk_data.messageIdNumber,
-            .message = cstr_to_std(vk_data.pMessage),
-            .queue_labels = queue_labels,
-            .cmd_buf_labels = cmd_buf_labels,
-            .objects = objects
-        };;
-    }
+            .storagePushConstant16 =
+            features.storage_push_constant16,
 
-    VkDeviceQueueCreateInfo QueueRequest_to_vk(
-        const QueueRequest& request,
-        std::vector<float>& waste_priorities
-    )
-    {
-        waste_priorities = request.priorities;
-        return VkDeviceQueueCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = request.flags,
-            .queueFamilyIndex = request.queue_family_index,
-            .queueCount = request.num_queues_to_create,
-            .pQueuePriorities = waste_priorities.data()
-        };
-    }
+            .storageInputOutput16 =
+            features.storage_input_output16,
 
-    VkComponentMapping ComponentMapping_to_vk(const ComponentMapping& mapping)
-    {
-        return VkComponentMapping{
-            .r = mapping.r,
-            .g = mapping.g,
-            .b = mapping.b,
-            .a = mapping.a
+            .multiview =
+            features.multiview,
+
+            .multiviewGeometryShader =
+            features.multiview_geometry_shader,
+
+            .multiviewTessellationShader =
+            features.multiview_tessellation_shader,
+
+            .variablePointersStorageBuffer =
+            features.variable_pointers_storage_buffer,
+
+            .variablePointers =
+            features.variable_pointers,
+
+            .protectedMemory =
+            features.protected_memory,
+
+            .samplerYcbcrConversion =
+            features.sampler_ycbcr_conversion,
+
+            .shaderDrawParameters =
+            features.shader_draw_parameters
         };
     }
 
-    VkImageSubresourceRange ImageSubresourceRange_to_vk(
-        const ImageSubresourceRange& range
+    PhysicalDeviceVulkan12Features PhysicalDeviceVulkan12Features_from_vk(
+        const VkPhysicalDeviceVulkan12Features& vk_features
     )
     {
-        return VkImageSubresourceRange{
-            .aspectMask = range.aspect_mask,
-            .baseMipLevel = range.base_mip_level,
-            .levelCount = range.level_count,
-            .baseArrayLayer = range.base_array_layer,
-            .layerCount = range.layer_count
-        };
-    }
+        return PhysicalDeviceVulkan12Features{
+            .sampler_mirror_clamp_to_edge =
+            (bool)vk_features.samplerMirrorClampToEdge,
 
-    VkSpecializationMapEntry SpecializationMapEntry_to_vk(
-        const SpecializationMapEntry& entry
-    )
-    {
-        return VkSpecializationMapEntry{
-            .constantID = entry.constant_id,
-            .offset = entry.offset,
-            .size = entry.size
-        };
-    }
+            .draw_indirect_count =
+            (bool)vk_features.drawIndirectCount,
 
-    VkSpecializationInfo SpecializationInfo_to_vk(
-        const SpecializationInfo& info,
-        std::vector<VkSpecializationMapEntry>& waste_vk_map_entries,
-        std::vector<uint8_t>& waste_data
-    )
-    {
-        waste_vk_map_entries.resize(info.map_entries.size());
-        for (size_t i = 0; i < info.map_entries.size(); i++)
-        {
-            waste_vk_map_entries[i] = SpecializationMapEntry_to_vk(
-                info.map_entries[i]
-            );
-        }
+            .storage_buffer_8bit_access =
+            (bool)vk_features.storageBuffer8BitAccess,
 
-        waste_data = info.data;
+            .uniform_and_storage_buffer_8bit_access =
+            (bool)vk_features.uniformAndStorageBuffer8BitAccess,
 
-        return VkSpecializationInfo{
-            .mapEntryCount = (uint32_t)waste_vk_map_entries.size(),
-            .pMapEntries = waste_vk_map_entries.data(),
-            .dataSize = waste_data.size(),
-            .pData = reinterpret_cast<const void*>(waste_data.data())
-        };
-    }
+            .storage_push_constant8 =
+            (bool)vk_features.storagePushConstant8,
 
-    VkPipelineShaderStageCreateInfo ShaderStage_to_vk(
-        const ShaderStage& stage,
-        VkSpecializationInfo& waste_vk_specialization_info,
-        std::vector<VkSpecializationMapEntry>& waste_vk_map_entries,
-        std::vector<uint8_t>& waste_data
-    )
-    {
-        if (stage.specialization_info.has_value())
-        {
-            waste_vk_specialization_info = SpecializationInfo_to_vk(
-                stage.specialization_info.value(),
-                waste_vk_map_entries,
-                waste_data
-            );
-        }
+            .shader_buffer_int64_atomics =
+            (bool)vk_features.shaderBufferInt64Atomics,
 
-        return VkPipelineShaderStageCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = stage.flags,
-            .stage = stage.stage,
-            .module = lock_wptr(stage.module)->handle(),
-            .pName = stage.entry_point.c_str(),
+            .shader_shared_int64_atomics =
+            (bool)vk_features.shaderSharedInt64Atomics,
 
-            .pSpecializationInfo = stage.specialization_info.has_value()
-            ? &waste_vk_specialization_info
-            : nullptr
+            .shader_float16 =
+            (bool)vk_features.shaderFloat16,
+
+            .shader_int8 =
+            (bool)vk_features.shaderInt8,
+
+            .descriptor_indexing =
+            (bool)vk_features.descriptorIndexing,
+
+            .shader_input_attachment_array_dynamic_indexing =
+            (bool)vk_features.shaderInputAttachmentArrayDynamicIndexing,
+
+            .shader_uniform_texel_buffer_array_dynamic_indexing =
+            (bool)vk_features.shaderUniformTexelBufferArrayDynamicIndexing,
+
+            .shader_storage_texel_buffer_array_dynamic_indexing =
+            (bool)vk_features.shaderStorageTexelBufferArrayDynamicIndexing,
+
+            .shader_uniform_buffer_array_non_uniform_indexing =
+            (bool)vk_features.shaderUniformBufferArrayNonUniformIndexing,
+
+            .shader_sampled_image_array_non_uniform_indexing =
+            (bool)vk_features.shaderSampledImageArrayNonUniformIndexing,
+
+            .shader_storage_buffer_array_non_uniform_indexing =
+            (bool)vk_features.shaderStorageBufferArrayNonUniformIndexing,
+
+            .shader_storage_image_array_non_uniform_indexing =
+            (bool)vk_features.shaderStorageImageArrayNonUniformIndexing,
+
+            .shader_input_attachment_array_non_uniform_indexing =
+            (bool)vk_features.shaderInputAttachmentArrayNonUniformIndexing,
+
+            .shader_uniform_texel_buffer_array_non_uniform_indexing =
+            (bool)vk_features.shaderUniformTexelBufferArrayNonUniformIndexing,
+
+            .shader_storage_texel_buffer_array_non_uniform_indexing =
+            (bool)vk_features.shaderStorageTexelBufferArrayNonUniformIndexing,
+
+            .descriptor_binding_uniform_buffer_update_after_bind =
+            (bool)vk_features.descriptorBindingUniformBufferUpdateAfterBind,
+
+            .descriptor_binding_sampled_image_update_after_bind =
+            (bool)vk_features.descriptorBindingSampledImageUpdateAfterBind,
+
+            .descriptor_binding_storage_image_update_after_bind =
+            (bool)vk_features.descriptorBindingStorageImageUpdateAfterBind,
+
+            .descriptor_binding_storage_buffer_update_after_bind =
+            (bool)vk_features.descriptorBindingStorageBufferUpdateAfterBind,
+
+            .descriptor_binding_uniform_texel_buffer_update_after_bind =
+            (bool)vk_features.descriptorBindingUniformTexelBufferUpdateAfterBind,
+
+            .descriptor_binding_storage_texel_buffer_update_after_bind =
+            (bool)vk_features.descriptorBindingStorageTexelBufferUpdateAfterBind,
+
+            .descriptor_binding_update_unused_while_pending =
+            (bool)vk_features.descriptorBindingUpdateUnusedWhilePending,
+
+            .descriptor_binding_partially_bound =
+            (bool)vk_features.descriptorBindingPartiallyBound,
+
+            .descriptor_binding_variable_descriptor_count =
+            (bool)vk_features.descriptorBindingVariableDescriptorCount,
+
+            .runtime_descriptor_array =
+            (bool)vk_features.runtimeDescriptorArray,
+
+            .sampler_filter_minmax =
+            (bool)vk_features.samplerFilterMinmax,
+
+            .scalar_block_layout =
+            (bool)vk_features.scalarBlockLayout,
+
+            .imageless_framebuffer =
+            (bool)vk_features.imagelessFramebuffer,
+
+            .uniform_buffer_standard_layout =
+            (bool)vk_features.uniformBufferStandardLayout,
+
+            .shader_subgroup_extended_types =
+            (bool)vk_features.shaderSubgroupExtendedTypes,
+
+            .separate_depth_stencil_layouts =
+            (bool)vk_features.separateDepthStencilLayouts,
+
+            .host_query_reset =
+            (bool)vk_features.hostQueryReset,
+
+            .timeline_semaphore =
+            (bool)vk_features.timelineSemaphore,
+
+            .buffer_device_address =
+            (bool)vk_features.bufferDeviceAddress,
+
+            .buffer_device_address_capture_replay =
+            (bool)vk_features.bufferDeviceAddressCaptureReplay,
+
+            .buffer_device_address_multi_device =
+            (bool)vk_features.bufferDeviceAddressMultiDevice,
+
+            .vulkan_memory_model =
+            (bool)vk_features.vulkanMemoryModel,
+
+            .vulkan_memory_model_device_scope =
+            (bool)vk_features.vulkanMemoryModelDeviceScope,
+
+            .vulkan_memory_model_availability_visibility_chains =
+            (bool)vk_features.vulkanMemoryModelAvailabilityVisibilityChains,
+
+            .shader_output_viewport_index =
+            (bool)vk_features.shaderOutputViewportIndex,
+
+            .shader_output_layer =
+            (bool)vk_features.shaderOutputLayer,
+
+            .subgroup_broadcast_dynamic_id =
+            (bool)vk_features.subgroupBroadcastDynamicId
         };
     }
 
-    VkPipelineDynamicStateCreateInfo DynamicStates_to_vk(
-        const DynamicStates& states,
-        std::vector<VkDynamicState>& waste_dynamic_states
+    VkPhysicalDeviceVulkan12Features PhysicalDeviceVulkan12Features_to_vk(
+        const PhysicalDeviceVulkan12Features& features
     )
     {
-        waste_dynamic_states = states;
-        return VkPipelineDynamicStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        return VkPhysicalDeviceVulkan12Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = nullptr,
-            .flags = 0,
-            .dynamicStateCount = (uint32_t)waste_dynamic_states.size(),
-            .pDynamicStates = waste_dynamic_states.data()
+
+            .samplerMirrorClampToEdge =
+            features.sampler_mirror_clamp_to_edge,
+
+            .drawIndirectCount =
+            features.draw_indirect_count,
+
+            .storageBuffer8BitAccess =
+            features.storage_buffer_8bit_access,
+
+            .uniformAndStorageBuffer8BitAccess =
+            features.uniform_and_storage_buffer_8bit_access,
+
+            .storagePushConstant8 =
+            features.storage_push_constant8,
+
+            .shaderBufferInt64Atomics =
+            features.shader_buffer_int64_atomics,
+
+            .shaderSharedInt64Atomics =
+            features.shader_shared_int64_atomics,
+
+            .shaderFloat16 =
+            features.shader_float16,
+
+            .shaderInt8 =
+            features.shader_int8,
+
+            .descriptorIndexing =
+            features.descriptor_indexing,
+
+            .shaderInputAttachmentArrayDynamicIndexing =
+            features.shader_input_attachment_array_dynamic_indexing,
+
+            .shaderUniformTexelBufferArrayDynamicIndexing =
+            features.shader_uniform_texel_buffer_array_dynamic_indexing,
+
+            .shaderStorageTexelBufferArrayDynamicIndexing =
+            features.shader_storage_texel_buffer_array_dynamic_indexing,
+
+            .shaderUniformBufferArrayNonUniformIndexing =
+            features.shader_uniform_buffer_array_non_uniform_indexing,
+
+            .shaderSampledImageArrayNonUniformIndexing =
+            features.shader_sampled_image_array_non_uniform_indexing,
+
+            .shaderStorageBufferArrayNonUniformIndexing =
+            features.shader_storage_buffer_array_non_uniform_indexing,
+
+            .shaderStorageImageArrayNonUniformIndexing =
+            features.shader_storage_image_array_non_uniform_indexing,
+
+            .shaderInputAttachmentArrayNonUniformIndexing =
+            features.shader_input_attachment_array_non_uniform_indexing,
+
+            .shaderUniformTexelBufferArrayNonUniformIndexing =
+            features.shader_uniform_texel_buffer_array_non_uniform_indexing,
+
+            .shaderStorageTexelBufferArrayNonUniformIndexing =
+            features.shader_storage_texel_buffer_array_non_uniform_indexing,
+
+            .descriptorBindingUniformBufferUpdateAfterBind =
+            features.descriptor_binding_uniform_buffer_update_after_bind,
+
+            .descriptorBindingSampledImageUpdateAfterBind =
+            features.descriptor_binding_sampled_image_update_after_bind,
+
+            .descriptorBindingStorageImageUpdateAfterBind =
+            features.descriptor_binding_storage_image_update_after_bind,
+
+            .descriptorBindingStorageBufferUpdateAfterBind =
+            features.descriptor_binding_storage_buffer_update_after_bind,
+
+            .descriptorBindingUniformTexelBufferUpdateAfterBind =
+            features.descriptor_binding_uniform_texel_buffer_update_after_bind,
+
+            .descriptorBindingStorageTexelBufferUpdateAfterBind =
+            features.descriptor_binding_storage_texel_buffer_update_after_bind,
+
+            .descriptorBindingUpdateUnusedWhilePending =
+            features.descriptor_binding_update_unused_while_pending,
+
+            .descriptorBindingPartiallyBound =
+            features.descriptor_binding_partially_bound,
+
+            .descriptorBindingVariableDescriptorCount =
+            features.descriptor_binding_variable_descriptor_count,
+
+            .runtimeDescriptorArray =
+            features.runtime_descriptor_array,
+
+            .samplerFilterMinmax =
+            features.sampler_filter_minmax,
+
+            .scalarBlockLayout =
+            features.scalar_block_layout,
+
+            .imagelessFramebuffer =
+            features.imageless_framebuffer,
+
+            .uniformBufferStandardLayout =
+            features.uniform_buffer_standard_layout,
+
+            .shaderSubgroupExtendedTypes =
+            features.shader_subgroup_extended_types,
+
+            .separateDepthStencilLayouts =
+            features.separate_depth_stencil_layouts,
+
+            .hostQueryReset =
+            features.host_query_reset,
+
+            .timelineSemaphore =
+            features.timeline_semaphore,
+
+            .bufferDeviceAddress =
+            features.buffer_device_address,
+
+            .bufferDeviceAddressCaptureReplay =
+            features.buffer_device_address_capture_replay,
+
+            .bufferDeviceAddressMultiDevice =
+            features.buffer_device_address_multi_device,
+
+            .vulkanMemoryModel =
+            features.vulkan_memory_model,
+
+            .vulkanMemoryModelDeviceScope =
+            features.vulkan_memory_model_device_scope,
+
+            .vulkanMemoryModelAvailabilityVisibilityChains =
+            features.vulkan_memory_model_availability_visibility_chains,
+
+            .shaderOutputViewportIndex =
+            features.shader_output_viewport_index,
+
+            .shaderOutputLayer =
+            features.shader_output_layer,
+
+            .subgroupBroadcastDynamicId =
+            features.subgroup_broadcast_dynamic_id
         };
     }
 
-    VkVertexInputBindingDescription VertexInputBindingDescription_to_vk(
-        const VertexInputBindingDescription& description
+    PhysicalDeviceVulkan13Features PhysicalDeviceVulkan13Features_from_vk(
+        const VkPhysicalDeviceVulkan13Features& vk_features
     )
     {
-        return VkVertexInputBindingDescription{
-            .binding = description.binding,
-            .stride = description.stride,
-            .inputRate = description.input_rate
+        return PhysicalDeviceVulkan13Features{
+            .robust_image_access =
+            (bool)vk_features.robustImageAccess,
+
+            .inline_uniform_block =
+            (bool)vk_features.inlineUniformBlock,
+
+            .descriptor_binding_inline_uniform_block_update_after_bind =
+            (bool)vk_features.descriptorBindingInlineUniformBlockUpdateAfterBind,
+
+            .pipeline_creation_cache_control =
+            (bool)vk_features.pipelineCreationCacheControl,
+
+            .private_data =
+            (bool)vk_features.privateData,
+
+            .shader_demote_to_helper_invocation =
+            (bool)vk_features.shaderDemoteToHelperInvocation,
+
+            .shader_terminate_invocation =
+            (bool)vk_features.shaderTerminateInvocation,
+
+            .subgroup_size_control =
+            (bool)vk_features.subgroupSizeControl,
+
+            .compute_full_subgroups =
+            (bool)vk_features.computeFullSubgroups,
+
+            .synchronization2 =
+            (bool)vk_features.synchronization2,
+
+            .texture_compression_astc_hdr =
+            (bool)vk_features.textureCompressionASTC_HDR,
+
+            .shader_zero_initialize_workgroup_memory =
+            (bool)vk_features.shaderZeroInitializeWorkgroupMemory,
+
+            .dynamic_rendering =
+            (bool)vk_features.dynamicRendering,
+
+            .shader_integer_dot_product =
+            (bool)vk_features.shaderIntegerDotProduct,
+
+            .maintenance4 =
+            (bool)vk_features.maintenance4
         };
     }
 
-    VkVertexInputAttributeDescription VertexInputAttributeDescription_to_vk(
-        const VertexInputAttributeDescription& description
+    VkPhysicalDeviceVulkan13Features PhysicalDeviceVulkan13Features_to_vk(
+        const PhysicalDeviceVulkan13Features& features
     )
     {
-        return VkVertexInputAttributeDescription{
-            .location = description.location,
-            .binding = description.binding,
-            .format = description.format,
-            .offset = description.offset
-        };
-    }
+        return VkPhysicalDeviceVulkan13Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+            .pNext = nullptr,
 
-    VkPipelineVertexInputStateCreateInfo VertexInputState_to_vk(
-        const VertexInputState& state,
+            .robustImageAccess =
+            features.robust_image_access,
 
-        std::vector<VkVertexInputBindingDescription>&
-        waste_vk_binding_descriptions,
+            .inlineUniformBlock =
+            features.inline_uniform_block,
 
-        std::vector<VkVertexInputAttributeDescription>&
-        waste_vk_attribute_descriptions
-    )
-    {
-        waste_vk_binding_descriptions.resize(state.binding_descriptions.size());
-        for (size_t i = 0; i < state.binding_descriptions.size(); i++)
-        {
-            waste_vk_binding_descriptions[i] =
-                VertexInputBindingDescription_to_vk(
-                    state.binding_descriptions[i]
-                );
-        }
+            .descriptorBindingInlineUniformBlockUpdateAfterBind =
+            features.descriptor_binding_inline_uniform_block_update_after_bind,
 
-        waste_vk_attribute_descriptions.resize(
-            state.attribute_descriptions.size()
-        );
-        for (size_t i = 0; i < state.attribute_descriptions.size(); i++)
-        {
-            waste_vk_attribute_descriptions[i] =
-                VertexInputAttributeDescription_to_vk(
-                    state.attribute_descriptions[i]
-                );
-        }
+            .pipelineCreationCacheControl =
+            features.pipeline_creation_cache_control,
 
-        return VkPipelineVertexInputStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
+            .privateData =
+            features.private_data,
 
-            .vertexBindingDescriptionCount =
-            (uint32_t)waste_vk_binding_descriptions.size(),
+            .shaderDemoteToHelperInvocation =
+            features.shader_demote_to_helper_invocation,
 
-            .pVertexBindingDescriptions = waste_vk_binding_descriptions.data(),
+            .shaderTerminateInvocation =
+            features.shader_terminate_invocation,
 
-            .vertexAttributeDescriptionCount =
-            (uint32_t)waste_vk_attribute_descriptions.size(),
+            .subgroupSizeControl =
+            features.subgroup_size_control,
 
-            .pVertexAttributeDescriptions =
-            waste_vk_attribute_descriptions.data()
+            .computeFullSubgroups =
+            features.compute_full_subgroups,
+
+            .synchronization2 =
+            features.synchronization2,
+
+            .textureCompressionASTC_HDR =
+            features.texture_compression_astc_hdr,
+
+            .shaderZeroInitializeWorkgroupMemory =
+            features.shader_zero_initialize_workgroup_memory,
+
+            .dynamicRendering =
+            features.dynamic_rendering,
+
+            .shaderIntegerDotProduct =
+            features.shader_integer_dot_product,
+
+            .maintenance4 =
+            features.maintenance4
         };
     }
 
-    VkPipelineInputAssemblyStateCreateInfo InputAssemblyState_to_vk(
-        const InputAssemblyState& state
-    )
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT
+        PhysicalDeviceExtendedDynamicState2Features_to_vk(
+            const PhysicalDeviceExtendedDynamicState2Features& features
+        )
     {
-        return VkPipelineInputAssemblyStateCreateInfo{
+        return VkPhysicalDeviceExtendedDynamicState2FeaturesEXT{
             .sType =
-            VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT,
 
             .pNext = nullptr,
-            .flags = 0,
-            .topology = state.topology,
-            .primitiveRestartEnable = state.primitive_restart_enable
-        };
-    }
 
-    VkPipelineTessellationStateCreateInfo TessellationState_to_vk(
-        const TessellationState& state
-    )
-    {
-        return VkPipelineTessellationStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .patchControlPoints = state.patch_control_points
+            .extendedDynamicState2 =
+            features.extended_dynamic_state2,
+
+            .extendedDynamicState2LogicOp =
+            features.extended_dynamic_state2_logic_op,
+
+            .extendedDynamicState2PatchControlPoints =
+            features.extended_dynamic_state2_patch_control_points
         };
     }
 
-    VkViewport Viewport_to_vk(const Viewport& viewport)
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT
+        PhysicalDeviceExtendedDynamicState3Features_to_vk(
+            const PhysicalDeviceExtendedDynamicState3Features& features
+        )
     {
-        return VkViewport{
-            .x = viewport.x,
-            .y = viewport.y,
-            .width = viewport.width,
-            .height = viewport.height,
-            .minDepth = viewport.min_depth,
-            .maxDepth = viewport.max_depth
-        };
-    }
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT vk_features{};
+        vk_features.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+        vk_features.pNext = nullptr;
 
-    VkOffset2D Offset2d_to_vk(const Offset2d& offset)
-    {
-        return VkOffset2D{
-            .x = offset.x,
-            .y = offset.y
-        };
-    }
+        vk_features.extendedDynamicState3DepthClampEnable =
+            features.depth_clamp_enable;
 
-    VkOffset3D Offset3d_to_vk(const Offset3d& offset)
-    {
-        return VkOffset3D{
-            .x = offset.x,
-            .y = offset.y,
-            .z = offset.z
-        };
+        vk_features.extendedDynamicState3PolygonMode =
+            features.polygon_mode;
+
+        vk_features.extendedDynamicState3RasterizationSamples =
+            features.rasterization_samples;
+
+        vk_features.extendedDynamicState3SampleMask =
+            features.sample_mask;
+
+        vk_features.extendedDynamicState3AlphaToCoverageEnable =
+            features.alpha_to_coverage_enable;
+
+        vk_features.extendedDynamicState3AlphaToOneEnable =
+            features.alpha_to_one_enable;
+
+        vk_features.extendedDynamicState3LogicOpEnable =
+            features.logic_op_enable;
+
+        vk_features.extendedDynamicState3ColorBlendEnable =
+            features.color_blend_enable;
+
+        vk_features.extendedDynamicState3ColorBlendEquation =
+            features.color_blend_equation;
+
+        vk_features.extendedDynamicState3ColorWriteMask =
+            features.color_write_mask;
+
+        return vk_features;
     }
 
-    VkRect2D Rect2d_to_vk(const Rect2d& rect)
+    PhysicalDeviceVulkan11Properties PhysicalDeviceVulkan11Properties_from_vk(
+        const VkPhysicalDeviceVulkan11Properties& vk_properties
+    )
     {
-        return VkRect2D{
-            .offset = Offset2d_to_vk(rect.offset),
-            .extent = Extent2d_to_vk(rect.extent)
+        return PhysicalDeviceVulkan11Properties{
+            .device_uuid = raw_arr_to_std<VK_UUID_SIZE>(
+                vk_properties.deviceUUID
+            ),
+
+            .driver_uuid = raw_arr_to_std<VK_UUID_SIZE>(
+                vk_properties.driverUUID
+            ),
+
+            .device_luid = raw_arr_to_std<VK_LUID_SIZE>(
+                vk_properties.deviceLUID
+            ),
+
+            .device_node_mask =
+            vk_properties.deviceNodeMask,
+
+            .device_luid_valid =
+            (bool)vk_properties.deviceLUIDValid,
+
+            .subgroup_size =
+            vk_properties.subgroupSize,
+
+            .subgroup_supported_stages =
+            vk_properties.subgroupSupportedStages,
+
+            .subgroup_supported_operations =
+            vk_properties.subgroupSupportedOperations,
+
+            .subgroup_quad_operations_in_all_stages =
+            (bool)vk_properties.subgroupQuadOperationsInAllStages,
+
+            .point_clipping_behavior =
+            vk_properties.pointClippingBehavior,
+
+            .max_multiview_view_count =
+            vk_properties.maxMultiviewViewCount,
+
+            .max_multiview_instance_index =
+            vk_properties.maxMultiviewInstanceIndex,
+
+            .protected_no_fault =
+            (bool)vk_properties.protectedNoFault,
+
+            .max_per_set_descriptors =
+            vk_properties.maxPerSetDescriptors,
+
+            .max_memory_allocation_size =
+            vk_properties.maxMemoryAllocationSize
         };
     }
 
-    VkPipelineViewportStateCreateInfo ViewportState_to_vk(
-        const ViewportState& state,
-        std::vector<VkViewport>& waste_vk_viewports,
-        std::vector<VkRect2D>& waste_vk_scissors
+    PhysicalDeviceVulkan12Properties PhysicalDeviceVulkan12Properties_from_vk(
+        const VkPhysicalDeviceVulkan12Properties& vk_properties
     )
     {
-        waste_vk_viewports.resize(state.viewports.size());
-        for (size_t i = 0; i < state.viewports.size(); i++)
-        {
-            waste_vk_viewports[i] = Viewport_to_vk(state.viewports[i]);
-        }
+        return PhysicalDeviceVulkan12Properties{
+            .driver_id =
+            vk_properties.driverID,
 
-        waste_vk_scissors.resize(state.scissors.size());
-        for (size_t i = 0; i < state.scissors.size(); i++)
-        {
-            waste_vk_scissors[i] = Rect2d_to_vk(state.scissors[i]);
-        }
+            .driver_name = cstr_to_std(vk_properties.driverName),
 
-        return VkPipelineViewportStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .viewportCount = (uint32_t)waste_vk_viewports.size(),
-            .pViewports = waste_vk_viewports.data(),
-            .scissorCount = (uint32_t)waste_vk_scissors.size(),
-            .pScissors = waste_vk_scissors.data()
+            .driver_info = cstr_to_std(vk_properties.driverInfo),
+
+            .conformance_version =
+            vk_properties.conformanceVersion,
+
+            .denorm_behavior_independence =
+            vk_properties.denormBehaviorIndependence,
+
+            .rounding_mode_independence =
+            vk_properties.roundingModeIndependence,
+
+            .shader_signed_zero_inf_nan_preserve_float16 =
+            (bool)vk_properties.shaderSignedZeroInfNanPreserveFloat16,
+
+            .shader_signed_zero_inf_nan_preserve_float32 =
+            (bool)vk_properties.shaderSignedZeroInfNanPreserveFloat32,
+
+            .shader_signed_zero_inf_nan_preserve_float64 =
+            (bool)vk_properties.shaderSignedZeroInfNanPreserveFloat64,
+
+            .shader_denorm_preserve_float16 =
+            (bool)vk_properties.shaderDenormPreserveFloat16,
+
+            .shader_denorm_preserve_float32 =
+            (bool)vk_properties.shaderDenormPreserveFloat32,
+
+            .shader_denorm_preserve_float64 =
+            (bool)vk_properties.shaderDenormPreserveFloat64,
+
+            .shader_denorm_flush_to_zero_float16 =
+            (bool)vk_properties.shaderDenormFlushToZeroFloat16,
+
+            .shader_denorm_flush_to_zero_float32 =
+            (bool)vk_properties.shaderDenormFlushToZeroFloat32,
+
+            .shader_denorm_flush_to_zero_float64 =
+            (bool)vk_properties.shaderDenormFlushToZeroFloat64,
+
+            .shader_rounding_mode_rte_float16 =
+            (bool)vk_properties.shaderRoundingModeRTEFloat16,
+
+            .shader_rounding_mode_rte_float32 =
+            (bool)vk_properties.shaderRoundingModeRTEFloat32,
+
+            .shader_rounding_mode_rte_float64 =
+            (bool)vk_properties.shaderRoundingModeRTEFloat64,
+
+            .shader_rounding_mode_rtz_float16 =
+            (bool)vk_properties.shaderRoundingModeRTZFloat16,
+
+            .shader_rounding_mode_rtz_float32 =
+            (bool)vk_properties.shaderRoundingModeRTZFloat32,
+
+            .shader_rounding_mode_rtz_float64 =
+            (bool)vk_properties.shaderRoundingModeRTZFloat64,
+
+            .max_update_after_bind_descriptors_in_all_pools =
+            vk_properties.maxUpdateAfterBindDescriptorsInAllPools,
+
+            .shader_uniform_buffer_array_non_uniform_indexing_native =
+            (bool)vk_properties.shaderUniformBufferArrayNonUniformIndexingNative,
+
+            .shader_sampled_image_array_non_uniform_indexing_native =
+            (bool)vk_properties.shaderSampledImageArrayNonUniformIndexingNative,
+
+            .shader_storage_buffer_array_non_uniform_indexing_native =
+            (bool)vk_properties.shaderStorageBufferArrayNonUniformIndexingNative,
+
+            .shader_storage_image_array_non_uniform_indexing_native =
+            (bool)vk_properties.shaderStorageImageArrayNonUniformIndexingNative,
+
+            .shader_input_attachment_array_non_uniform_indexing_native =
+            (bool)vk_properties.shaderInputAttachmentArrayNonUniformIndexingNative,
+
+            .robust_buffer_access_update_after_bind =
+            (bool)vk_properties.robustBufferAccessUpdateAfterBind,
+
+            .quad_divergent_implicit_lod =
+            (bool)vk_properties.quadDivergentImplicitLod,
+
+            .max_per_stage_descriptor_update_after_bind_samplers =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+
+            .max_per_stage_descriptor_update_after_bind_uniform_buffers =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindUniformBuffers,
+
+            .max_per_stage_descriptor_update_after_bind_storage_buffers =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+
+            .max_per_stage_descriptor_update_after_bind_sampled_images =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+
+            .max_per_stage_descriptor_update_after_bind_storage_images =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindStorageImages,
+
+            .max_per_stage_descriptor_update_after_bind_input_attachments =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindInputAttachments,
+
+            .max_per_stage_update_after_bind_resources =
+            vk_properties.maxPerStageUpdateAfterBindResources,
+
+            .max_descriptor_set_update_after_bind_samplers =
+            vk_properties.maxDescriptorSetUpdateAfterBindSamplers,
+
+            .max_descriptor_set_update_after_bind_uniform_buffers =
+            vk_properties.maxDescriptorSetUpdateAfterBindUniformBuffers,
+
+            .max_descriptor_set_update_after_bind_uniform_buffers_dynamic =
+            vk_properties.maxDescriptorSetUpdateAfterBindUniformBuffersDynamic,
+
+            .max_descriptor_set_update_after_bind_storage_buffers =
+            vk_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+
+            .max_descriptor_set_update_after_bind_storage_buffers_dynamic =
+            vk_properties.maxDescriptorSetUpdateAfterBindStorageBuffersDynamic,
+
+            .max_descriptor_set_update_after_bind_sampled_images =
+            vk_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+
+            .max_descriptor_set_update_after_bind_storage_images =
+            vk_properties.maxDescriptorSetUpdateAfterBindStorageImages,
+
+            .max_descriptor_set_update_after_bind_input_attachments =
+            vk_properties.maxDescriptorSetUpdateAfterBindInputAttachments,
+
+            .supported_depth_resolve_modes =
+            vk_properties.supportedDepthResolveModes,
+
+            .supported_stencil_resolve_modes =
+            vk_properties.supportedStencilResolveModes,
+
+            .independent_resolve_none =
+            (bool)vk_properties.independentResolveNone,
+
+            .independent_resolve =
+            (bool)vk_properties.independentResolve,
+
+            .filter_minmax_single_component_formats =
+            (bool)vk_properties.filterMinmaxSingleComponentFormats,
+
+            .filter_minmax_image_component_mapping =
+            (bool)vk_properties.filterMinmaxImageComponentMapping,
+
+            .max_timeline_semaphore_value_difference =
+            vk_properties.maxTimelineSemaphoreValueDifference,
+
+            .framebuffer_integer_color_sample_counts =
+            vk_properties.framebufferIntegerColorSampleCounts
         };
     }
 
-    VkPipelineRasterizationStateCreateInfo RasterizationState_to_vk(
-        const RasterizationState& state
+    PhysicalDeviceVulkan13Properties PhysicalDeviceVulkan13Properties_from_vk(
+        const VkPhysicalDeviceVulkan13Properties& vk_properties
     )
     {
-        return VkPipelineRasterizationStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .depthClampEnable = state.depth_clamp_enable,
-            .rasterizerDiscardEnable = state.rasterizer_discard_enable,
-            .polygonMode = state.polygon_mode,
-            .cullMode = state.cull_mode,
-            .frontFace = state.front_face,
-            .depthBiasEnable = state.depth_bias_enable,
-            .depthBiasConstantFactor = state.depth_bias_constant_factor,
-            .depthBiasClamp = state.depth_bias_clamp,
-            .depthBiasSlopeFactor = state.depth_bias_slope_factor,
-            .lineWidth = state.line_width
+        return PhysicalDeviceVulkan13Properties{
+            .min_subgroup_size =
+            vk_properties.minSubgroupSize,
+
+            .max_subgroup_size =
+            vk_properties.maxSubgroupSize,
+
+            .max_compute_workgroup_subgroups =
+            vk_properties.maxComputeWorkgroupSubgroups,
+
+            .required_subgroup_size_stages =
+            vk_properties.requiredSubgroupSizeStages,
+
+            .max_inline_uniform_block_size =
+            vk_properties.maxInlineUniformBlockSize,
+
+            .max_per_stage_descriptor_inline_uniform_blocks =
+            vk_properties.maxPerStageDescriptorInlineUniformBlocks,
+
+            .max_per_stage_descriptor_update_after_bind_inline_uniform_blocks =
+            vk_properties.maxPerStageDescriptorUpdateAfterBindInlineUniformBlocks,
+
+            .max_descriptor_set_inline_uniform_blocks =
+            vk_properties.maxDescriptorSetInlineUniformBlocks,
+
+            .max_descriptor_set_update_after_bind_inline_uniform_blocks =
+            vk_properties.maxDescriptorSetUpdateAfterBindInlineUniformBlocks,
+
+            .max_inline_uniform_total_size =
+            vk_properties.maxInlineUniformTotalSize,
+
+            .integer_dot_product_8bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProduct8BitUnsignedAccelerated,
+
+            .integer_dot_product_8bit_signed_accelerated =
+            (bool)vk_properties.integerDotProduct8BitSignedAccelerated,
+
+            .integer_dot_product_8bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProduct8BitMixedSignednessAccelerated,
+
+            .integer_dot_product_4x8bit_packed_unsigned_accelerated =
+            (bool)vk_properties.integerDotProduct4x8BitPackedUnsignedAccelerated,
+
+            .integer_dot_product_4x8bit_packed_signed_accelerated =
+            (bool)vk_properties.integerDotProduct4x8BitPackedSignedAccelerated,
+
+            .integer_dot_product_4x8bit_packed_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProduct4x8BitPackedMixedSignednessAccelerated,
+
+            .integer_dot_product_16bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProduct16BitUnsignedAccelerated,
+
+            .integer_dot_product_16bit_signed_accelerated =
+            (bool)vk_properties.integerDotProduct16BitSignedAccelerated,
+
+            .integer_dot_product_16bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProduct16BitMixedSignednessAccelerated,
+
+            .integer_dot_product_32bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProduct32BitUnsignedAccelerated,
+
+            .integer_dot_product_32bit_signed_accelerated =
+            (bool)vk_properties.integerDotProduct32BitSignedAccelerated,
+
+            .integer_dot_product_32bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProduct32BitMixedSignednessAccelerated,
+
+            .integer_dot_product_64bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProduct64BitUnsignedAccelerated,
+
+            .integer_dot_product_64bit_signed_accelerated =
+            (bool)vk_properties.integerDotProduct64BitSignedAccelerated,
+
+            .integer_dot_product_64bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProduct64BitMixedSignednessAccelerated,
+
+            .integer_dot_product_accumulating_saturating_8bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating8BitUnsignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_8bit_signed_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating8BitSignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_8bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating8BitMixedSignednessAccelerated,
+
+            .integer_dot_product_accumulating_saturating_4x8bit_packed_unsigned_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating4x8BitPackedUnsignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_4x8bit_packed_signed_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating4x8BitPackedSignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_4x8bit_packed_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating4x8BitPackedMixedSignednessAccelerated,
+
+            .integer_dot_product_accumulating_saturating_16bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating16BitUnsignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_16bit_signed_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating16BitSignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_16bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating16BitMixedSignednessAccelerated,
+
+            .integer_dot_product_accumulating_saturating_32bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating32BitUnsignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_32bit_signed_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating32BitSignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_32bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating32BitMixedSignednessAccelerated,
+
+            .integer_dot_product_accumulating_saturating_64bit_unsigned_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating64BitUnsignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_64bit_signed_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating64BitSignedAccelerated,
+
+            .integer_dot_product_accumulating_saturating_64bit_mixed_signedness_accelerated =
+            (bool)vk_properties.integerDotProductAccumulatingSaturating64BitMixedSignednessAccelerated,
+
+            .storage_texel_buffer_offset_alignment_bytes =
+            vk_properties.storageTexelBufferOffsetAlignmentBytes,
+
+            .storage_texel_buffer_offset_single_texel_alignment =
+            (bool)vk_properties.storageTexelBufferOffsetSingleTexelAlignment,
+
+            .uniform_texel_buffer_offset_alignment_bytes =
+            vk_properties.uniformTexelBufferOffsetAlignmentBytes,
+
+            .uniform_texel_buffer_offset_single_texel_alignment =
+            (bool)vk_properties.uniformTexelBufferOffsetSingleTexelAlignment,
+
+            .max_buffer_size =
+            vk_properties.maxBufferSize
         };
     }
 
-    VkPipelineMultisampleStateCreateInfo MultisampleState_to_vk(
-        const MultisampleState& state,
-        std::vector<VkSampleMask>& waste_sample_mask
-    )
+    Extent3d Extent3d_from_vk(const VkExtent3D& vk_extent_3d)
     {
-        waste_sample_mask = state.sample_mask;
-        return VkPipelineMultisampleStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .rasterizationSamples = state.rasterization_samples,
-            .sampleShadingEnable = state.sample_shading_enable,
-            .minSampleShading = state.min_sample_shading,
-            .pSampleMask = waste_sample_mask.data(),
-            .alphaToCoverageEnable = state.alpha_to_coverage_enable,
-            .alphaToOneEnable = state.alpha_to_one_enable
+        return Extent3d{
+            .width = vk_extent_3d.width,
+            .height = vk_extent_3d.height,
+            .depth = vk_extent_3d.depth
         };
     }
 
-    VkStencilOpState StencilOpState_to_vk(const StencilOpState& state)
+    VkExtent3D Extent3d_to_vk(const Extent3d& extent_3d)
     {
-        return VkStencilOpState{
-            .failOp = state.fail_op,
-            .passOp = state.pass_op,
-            .depthFailOp = state.depth_fail_op,
-            .compareOp = state.compare_op,
-            .compareMask = state.compare_mask,
-            .writeMask = state.write_mask,
-            .reference = state.reference
+        return VkExtent3D{
+            .width = extent_3d.width,
+            .height = extent_3d.height,
+            .depth = extent_3d.depth
         };
     }
 
-    VkPipelineDepthStencilStateCreateInfo DepthStencilState_to_vk(
-        const DepthStencilState& state
-    )
+    Extent2d Extent2d_from_vk(const VkExtent2D& vk_extent_2d)
     {
-        return VkPipelineDepthStencilStateCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = state.flags,
-            .depthTestEnable = state.depth_test_enable,
-            .depthWriteEnable = state.depth_write_enable,
-            .depthCompareOp = state.depth_compare_op,
-            .depthBoundsTestEnable = state.depth_bounds_test_enable,
-            .stencilTestEnable = state.stencil_test_enable,
-            .front = StencilOpState_to_vk(state.front),
-            .back = StencilOpState_to_vk(state.back),
-            .minDepthBounds = state.min_depth_bounds,
-            .maxDepthBounds = state.max_depth_bounds
+        return Extent2d{
+            .width = vk_extent_2d.width,
+            .height = vk_extent_2d.height
         };
     }
 
-    VkPipelineColorBlendAttachmentState ColorBlendAttachment_to_vk(
-        const ColorBlendAttachment& attachment
-    )
+    VkExtent2D Extent2d_to_vk(const Extent2d& extent_2d)
     {
-        return VkPipelineColorBlendAttachmentState{
-            .blendEnable = attachment.blend_enable,
-            .srcColorBlendFactor = attachment.src_color_blend_factor,
-            .dstColorBlendFactor = attachment.dst_color_blend_factor,
-            .colorBlendOp = attachment.color_blend_op,
-            .srcAlphaBlendFactor = attachment.src_alpha_blend_factor,
-            .dstAlphaBlendFactor = attachment.dst_alpha_blend_factor,
-            .alphaBlendOp = attachment.alpha_blend_op,
-            .colorWriteMask = attachment.color_write_mask
+        return VkExtent2D{
+            .width = extent_2d.width,
+            .height = extent_2d.height
         };
     }
 
-    VkPipelineColorBlendStateCreateInfo ColorBlendState_to_vk(
-        const ColorBlendState& state,
-
-        std::vector<VkPipelineColorBlendAttachmentState>&
-        waste_vk_color_blend_attachments
-    )
+    QueueFamily QueueFamily_from_vk(const VkQueueFamilyProperties& vk_family)
     {
-        waste_vk_color_blend_attachments.resize(state.attachments.size());
-        for (size_t i = 0; i < state.attachments.size(); i++)
-        {
-            waste_vk_color_blend_attachments[i] = ColorBlendAttachment_to_vk(
-                state.attachments[i]
-            );
-        }
-
-        VkPipelineColorBlendStateCreateInfo info{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = state.flags,
-            .logicOpEnable = state.logic_op_enable,
-            .logicOp = state.logic_op,
-
-            .attachmentCount =
-            (uint32_t)waste_vk_color_blend_attachments.size(),
-
-            .pAttachments = waste_vk_color_blend_attachments.data()
+        return QueueFamily{
+            .queue_flags = vk_family.queueFlags,
+            .queue_count = vk_family.queueCount,
+            .timestamp_valid_bits = vk_family.timestampValidBits,
+            .min_image_transfer_granularity = Extent3d_from_vk(
+                vk_family.minImageTransferGranularity
+            )
         };
-        std::copy(
-            state.blend_constants.data(),
-            state.blend_constants.data() + 4,
-            info.blendConstants
-        );
-        return info;
     }
 
-    VkDescriptorSetLayoutBinding DescriptorSetLayoutBinding_to_vk(
-        const DescriptorSetLayoutBinding& binding,
-        std::vector<VkSampler>& waste_vk_immutable_samplers
+    SurfaceCapabilities SurfaceCapabilities_from_vk(
+        const VkSurfaceCapabilitiesKHR& vk_capabilities
     )
     {
-        waste_vk_immutable_samplers.resize(binding.immutable_samplers.size());
-        for (size_t i = 0; i < binding.immutable_samplers.size(); i++)
-        {
-            waste_vk_immutable_samplers[i] =
-                lock_wptr(binding.immutable_samplers[i])->handle();
-        }
+        return SurfaceCapabilities{
+            .min_image_count = vk_capabilities.minImageCount,
+            .max_image_count = vk_capabilities.maxImageCount,
+            .current_extent = Extent2d_from_vk(vk_capabilities.currentExtent),
+            .min_image_extent = Extent2d_from_vk(
+                vk_capabilities.minImageExtent
+            ),
+            .max_image_extent = Extent2d_from_vk(
+                vk_capabilities.maxImageExtent
+            ),
+            .max_image_array_layers = vk_capabilities.maxImageArrayLayers,
+            .supported_transforms = vk_capabilities.supportedTransforms,
+            .current_transform = vk_capabilities.currentTransform,
 
-        return VkDescriptorSetLayoutBinding{
-            .binding = binding.binding,
-            .descriptorType = binding.descriptor_type,
-            .descriptorCount = binding.descriptor_count,
-            .stageFlags = binding.stage_flags,
+            .supported_composite_alpha =
+            vk_capabilities.supportedCompositeAlpha,
 
-            .pImmutableSamplers =
-            waste_vk_immutable_samplers.empty()
-            ? nullptr
-            : waste_vk_immutable_samplers.data()
+            .supported_usage_flags = vk_capabilities.supportedUsageFlags
         };
     }
 
-    VkPushConstantRange PushConstantRange_to_vk(const PushConstantRange& range)
+    SurfaceFormat SurfaceFormat_from_vk(
+        const VkSurfaceFormatKHR& vk_surface_format
+    )
     {
-        return VkPushConstantRange{
-            .stageFlags = range.stage_flags,
-            .offset = range.offset,
-            .size = range.size
+        return SurfaceFormat{
+            .format = vk_surface_format.format,
+            .color_space = vk_surface_format.colorSpace
         };
     }
 
-    VkAttachmentDescription Attachment_to_vk(
-        const Attachment& attachment
-    )
+    DebugLabel DebugLabel_from_vk(const VkDebugUtilsLabelEXT& vk_label)
     {
-        return VkAttachmentDescription{
-            .flags = attachment.flags,
-            .format = attachment.format,
-            .samples = attachment.samples,
-            .loadOp = attachment.load_op,
-            .storeOp = attachment.store_op,
-            .stencilLoadOp = attachment.stencil_load_op,
-            .stencilStoreOp = attachment.stencil_store_op,
-            .initialLayout = attachment.initial_layout,
-            .finalLayout = attachment.final_layout
+        return DebugLabel{
+            .name = cstr_to_std(vk_label.pLabelName),
+            .color = raw_arr_to_std<4>(vk_label.color)
         };
     }
 
-    VkAttachmentReference AttachmentReference_to_vk(
-        const AttachmentReference& ref
+    DebugObjectInfo DebugObjectInfo_from_vk(
+        const VkDebugUtilsObjectNameInfoEXT& vk_info
     )
     {
-        return VkAttachmentReference{
-            .attachment = ref.attachment,
-            .layout = ref.layout
+        return DebugObjectInfo{
+            .type = vk_info.objectType,
+            .handle = vk_info.objectHandle,
+            .name = cstr_to_std(vk_info.pObjectName)
         };
     }
 
-    VkSubpassDescription Subpass_to_vk(
-        const Subpass& subpass,
-        std::vector<VkAttachmentReference>& waste_vk_input_attachments,
-        std::vector<VkAttachmentReference>& waste_vk_color_attachments,
-        std::vector<VkAttachmentReference>& waste_vk_resolve_attachments,
-        VkAttachmentReference& waste_vk_depth_stencil_attachment,
-        std::vector<uint32_t>& waste_preserve_attachment_indices
+    DebugMessageData DebugMessageData_from_vk(
+        const VkDebugUtilsMessengerCallbackDataEXT& vk_data
     )
     {
-        waste_vk_input_attachments.resize(subpass.input_attachments.size());
-        for (size_t i = 0; i < subpass.input_attachments.size(); i++)
-        {
-            waste_vk_input_attachments[i] = AttachmentReference_to_vk(
-                subpass.input_attachments[i]
-            );
-        }
-
-        waste_vk_color_attachments.resize(subpass.color_attachments.size());
-        for (size_t i = 0; i < subpass.color_attachments.size(); i++)
+        std::vector<DebugLabel> queue_labels;
+        for (size_t i = 0; i < vk_data.queueLabelCount; i++)
         {
-            waste_vk_color_attachments[i] = AttachmentReference_to_vk(
-                subpass.color_attachments[i]
+            queue_labels.push_back(
+                DebugLabel_from_vk(vk_data.pQueueLabels[i])
             );
         }
 
-        waste_vk_resolve_attachments.resize(subpass.resolve_attachments.size());
-        for (size_t i = 0; i < subpass.resolve_attachments.size(); i++)
+        std::vector<DebugLabel> cmd_buf_labels;
+        for (size_t i = 0; i < vk_data.cmdBufLabelCount; i++)
         {
-            waste_vk_resolve_attachments[i] = AttachmentReference_to_vk(
-                subpass.resolve_attachments[i]
+            cmd_buf_labels.push_back(
+                DebugLabel_from_vk(vk_data.pCmdBufLabels[i])
             );
         }
 
-        if (subpass.depth_stencil_attachment.has_value())
+        std::vector<DebugObjectInfo> objects;
+        for (size_t i = 0; i < vk_data.objectCount; i++)
         {
-            waste_vk_depth_stencil_attachment = AttachmentReference_to_vk(
-                subpass.depth_stencil_attachment.value()
+            objects.push_back(
+                DebugObjectInfo_from_vk(vk_data.pObjects[i])
             );
         }
 
-        waste_preserve_attachment_indices = subpass.preserve_attachment_indices;
-
-        return VkSubpassDescription{
-            .flags = subpass.flags,
-            .pipelineBindPoint = subpass.pipeline_bind_point,
-            .inputAttachmentCount = (uint32_t)waste_vk_input_attachments.size(),
-            .pInputAttachments = waste_vk_input_attachments.data(),
-            .colorAttachmentCount = (uint32_t)waste_vk_color_attachments.size(),
-            .pColorAttachments = waste_vk_color_attachments.data(),
-
-            .pResolveAttachments =
-            waste_vk_resolve_attachments.empty()
-            ? nullptr
-            : waste_vk_resolve_attachments.data(),
-
-            .pDepthStencilAttachment =
-            subpass.depth_stencil_attachment.has_value()
-            ? &waste_vk_depth_stencil_attachment
-            : nullptr,
-
-            .preserveAttachmentCount =
-            (uint32_t)waste_preserve_attachment_indices.size(),
-
-            .pPreserveAttachments = waste_preserve_attachment_indices.data()
-        };
+        return DebugMessageData{
+            .message_id_name = cstr_to_std(vk_data.pMessageIdName),
+            .message_id_number = vk_data.messageIdNumber,
+            .message = cstr_to_std(vk_data.pMessage),
+            .queue_labels = queue_labels,
+            .cmd_buf_labels = cmd_buf_labels,
+            .objects = objects
+        };;
     }
 
-    VkSubpassDependency SubpassDependency_to_vk(const SubpassDependency& dep)
+    VkDeviceQueueCreateInfo QueueRequest_to_vk(
+        const QueueRequest& request,
+        std::vector<float>& waste_priorities
+    )
     {
-        return VkSubpassDependency{
-            .srcSubpass = dep.src_subpass,
-            .dstSubpass = dep.dst_subpass,
-            .srcStageMask = dep.src_stage_mask,
-            .dstStageMask = dep.dst_stage_mask,
-            .srcAccessMask = dep.src_access_mask,
-            .dstAccessMask = dep.dst_access_mask,
-            .dependencyFlags = dep.dependency_flags
+        waste_priorities = request.priorities;
+        return VkDeviceQueueCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = request.flags,
+            .queueFamilyIndex = request.queue_family_index,
+            .queueCount = request.num_queues_to_create,
+            .pQueuePriorities = waste_priorities.data()
         };
     }
 
-    MemoryRequirements MemoryRequirements_from_vk(
-        const VkMemoryRequirements& req
-    )
+    VkComponentMapping ComponentMapping_to_vk(const ComponentMapping& mapping)
     {
-        return MemoryRequirements{
-            .size = req.size,
-            .alignment = req.alignment,
-            .memory_type_bits = req.memoryTypeBits
+        return VkComponentMapping{
+            .r = mapping.r,
+            .g = mapping.g,
+            .b = mapping.b,
+            .a = mapping.a
         };
     }
 
-    MemoryType MemoryType_from_vk(const VkMemoryType& type)
+    VkImageSubresourceRange ImageSubresourceRange_to_vk(
+        const ImageSubresourceRange& range
+    )
     {
-        return MemoryType{
-            .property_flags = type.propertyFlags,
-            .heap_index = type.heapIndex
+        return VkImageSubresourceRange{
+            .aspectMask = range.aspect_mask,
+            .baseMipLevel = range.base_mip_level,
+            .levelCount = range.level_count,
+            .baseArrayLayer = range.base_array_layer,
+            .layerCount = range.layer_count
         };
     }
 
-    MemoryHeap MemoryHeap_from_vk(const VkMemoryHeap& heap)
+    VkSpecializationMapEntry SpecializationMapEntry_to_vk(
+        const SpecializationMapEntry& entry
+    )
     {
-        return MemoryHeap{
-            .size = heap.size,
-            .flags = heap.flags
+        return VkSpecializationMapEntry{
+            .constantID = entry.constant_id,
+            .offset = entry.offset,
+            .size = entry.size
         };
     }
 
-    PhysicalDeviceMemoryProperties PhysicalDeviceMemoryProperties_from_vk(
-        const VkPhysicalDeviceMemoryProperties& properties
+    VkSpecializationInfo SpecializationInfo_to_vk(
+        const SpecializationInfo& info,
+        std::vector<VkSpecializationMapEntry>& waste_vk_map_entries,
+        std::vector<uint8_t>& waste_data
     )
     {
-        std::vector<MemoryType> memory_types(properties.memoryTypeCount);
-        for (size_t i = 0; i < properties.memoryTypeCount; i++)
+        waste_vk_map_entries.resize(info.map_entries.size());
+        for (size_t i = 0; i < info.map_entries.size(); i++)
         {
-            memory_types[i] = MemoryType_from_vk(properties.memoryTypes[i]);
+            waste_vk_map_entries[i] = SpecializationMapEntry_to_vk(
+                info.map_entries[i]
+            );
         }
 
-        std::vector<MemoryHeap> memory_heaps(properties.memoryHeapCount);
-        for (size_t i = 0; i < properties.memoryHeapCount; i++)
+        waste_data = info.data;
+
+        return VkSpecializationInfo{
+            .mapEntryCount = (uint32_t)waste_vk_map_entries.size(),
+            .pMapEntries = waste_vk_map_entries.data(),
+            .dataSize = waste_data.size(),
+            .pData = reinterpret_cast<const void*>(waste_data.data())
+        };
+    }
+
+    VkPipelineShaderStageCreateInfo ShaderStage_to_vk(
+        const ShaderStage& stage,
+        VkSpecializationInfo& waste_vk_specialization_info,
+        std::vector<VkSpecializationMapEntry>& waste_vk_map_entries,
+        std::vector<uint8_t>& waste_data,
+
+        VkPipelineShaderStageModuleIdentifierCreateInfoEXT&
+        waste_vk_identifier_info
+    )
+    {
+        if (stage.specialization_info.has_value())
         {
-            memory_heaps[i] = MemoryHeap_from_vk(properties.memoryHeaps[i]);
+            waste_vk_specialization_info = SpecializationInfo_to_vk(
+                stage.specialization_info.value(),
+                waste_vk_map_entries,
+                waste_data
+            );
         }
 
-        return PhysicalDeviceMemoryProperties{
-            .memory_types = memory_types,
-            .memory_heaps = memory_heaps
+        auto module = lock_wptr(stage.module);
+        VkShaderModule vk_module = module->handle();
+        if (vk_module == nullptr)
+        {
+            waste_vk_identifier_info =
+                VkPipelineShaderStageModuleIdentifierCreateInfoEXT{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_MODULE_IDENTIFIER_CREATE_INFO_EXT,
+
+                    .pNext = nullptr,
+                    .identifierSize = (uint32_t)module->identifier().size(),
+                    .pIdentifier = module->identifier().data()
+                };
+        }
+
+        return VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = vk_module == nullptr ? &waste_vk_identifier_info : nullptr,
+            .flags = stage.flags,
+            .stage = stage.stage,
+            .module = vk_module,
+            .pName = stage.entry_point.c_str(),
+
+            .pSpecializationInfo = stage.specialization_info.has_value()
+            ? &waste_vk_specialization_info
+            : nullptr
         };
     }
 
-    VkDescriptorPoolSize DescriptorPoolSize_to_vk(
-        const DescriptorPoolSize& pool_size
+    VkPipelineDynamicStateCreateInfo DynamicStates_to_vk(
+        const DynamicStates& states,
+        std::vector<VkDynamicState>& waste_dynamic_states
     )
     {
-        return VkDescriptorPoolSize{
-            .type = pool_size.type,
-            .descriptorCount = pool_size.descriptor_count
+        waste_dynamic_states = states;
+        return VkPipelineDynamicStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .dynamicStateCount = (uint32_t)waste_dynamic_states.size(),
+            .pDynamicStates = waste_dynamic_states.data()
         };
     }
 
-    VkDescriptorImageInfo DescriptorImageInfo_to_vk(
-        const DescriptorImageInfo& info
+    VkPipelineRenderingCreateInfo PipelineRenderingFormats_to_vk(
+        const PipelineRenderingFormats& formats
     )
     {
-        return VkDescriptorImageInfo{
-            .sampler = info.sampler.has_value()
-            ? lock_wptr(info.sampler.value())->handle()
-            : nullptr,
+        return VkPipelineRenderingCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .pNext = nullptr,
+            .viewMask = formats.view_mask,
 
-            .imageView = info.image_view.has_value()
-            ? lock_wptr(info.image_view.value())->handle()
-            : nullptr,
+            .colorAttachmentCount =
+            (uint32_t)formats.color_attachment_formats.size(),
 
-            .imageLayout = info.image_layout
+            .pColorAttachmentFormats = formats.color_attachment_formats.empty()
+            ? nullptr : formats.color_attachment_formats.data(),
+
+            .depthAttachmentFormat = formats.depth_attachment_format,
+            .stencilAttachmentFormat = formats.stencil_attachment_format
         };
     }
 
-    VkDescriptorBufferInfo DescriptorBufferInfo_to_vk(
-        const DescriptorBufferInfo& info
+    VkVertexInputBindingDescription VertexInputBindingDescription_to_vk(
+        const VertexInputBindingDescription& description
     )
     {
-        return VkDescriptorBufferInfo{
-            .buffer = lock_wptr(info.buffer)->handle(),
-            .offset = info.offset,
-            .range = info.range
+        return VkVertexInputBindingDescription{
+            .binding = description.binding,
+            .stride = description.stride,
+            .inputRate = description.input_rate
         };
     }
 
-    VkWriteDescriptorSet WriteDescriptorSet_to_vk(
-        const WriteDescriptorSet& write,
-        std::vector<VkDescriptorImageInfo>& waste_vk_image_infos,
-        std::vector<VkDescriptorBufferInfo>& waste_vk_buffer_infos,
-        std::vector<VkBufferView>& waste_vk_texel_buffer_views
+    VkVertexInputAttributeDescription VertexInputAttributeDescription_to_vk(
+        const VertexInputAttributeDescription& description
     )
     {
-        waste_vk_image_infos.resize(write.image_infos.size());
-        for (size_t i = 0; i < write.image_infos.size(); i++)
-        {
-            waste_vk_image_infos[i] = DescriptorImageInfo_to_vk(
-                write.image_infos[i]
-            );
-        }
+        return VkVertexInputAttributeDescription{
+            .location = description.location,
+            .binding = description.binding,
+            .format = description.format,
+            .offset = description.offset
+        };
+    }
 
-        waste_vk_buffer_infos.resize(write.buffer_infos.size());
-        for (size_t i = 0; i < write.buffer_infos.size(); i++)
+    VkPipelineVertexInputStateCreateInfo VertexInputState_to_vk(
+        const VertexInputState& state,
+
+        std::vector<VkVertexInputBindingDescription>&
+        waste_vk_binding_descriptions,
+
+        std::vector<VkVertexInputAttributeDescription>&
+        waste_vk_attribute_descriptions
+    )
+    {
+        waste_vk_binding_descriptions.resize(state.binding_descriptions.size());
+        for (size_t i = 0; i < state.binding_descriptions.size(); i++)
         {
-            waste_vk_buffer_infos[i] = DescriptorBufferInfo_to_vk(
-                write.buffer_infos[i]
-            );
+            waste_vk_binding_descriptions[i] =
+                VertexInputBindingDescription_to_vk(
+                    state.binding_descriptions[i]
+                );
         }
 
-        waste_vk_texel_buffer_views.resize(write.texel_buffer_views.size());
-        for (size_t i = 0; i < write.texel_buffer_views.size(); i++)
+        waste_vk_attribute_descriptions.resize(
+            state.attribute_descriptions.size()
+        );
+        for (size_t i = 0; i < state.attribute_descriptions.size(); i++)
         {
-            waste_vk_texel_buffer_views[i] =
-                lock_wptr(write.texel_buffer_views[i])->handle();
+            waste_vk_attribute_descriptions[i] =
+                VertexInputAttributeDescription_to_vk(
+                    state.attribute_descriptions[i]
+                );
         }
 
-        return VkWriteDescriptorSet{
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        return VkPipelineVertexInputStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
             .pNext = nullptr,
-            .dstSet = lock_wptr(write.dst_set)->handle(),
-            .dstBinding = write.dst_binding,
-            .dstArrayElement = write.dst_array_element,
-            .descriptorCount = write.descriptor_count,
-            .descriptorType = write.descriptor_type,
+            .flags = 0,
 
-            .pImageInfo = waste_vk_image_infos.empty()
-            ? nullptr : waste_vk_image_infos.data(),
+            .vertexBindingDescriptionCount =
+            (uint32_t)waste_vk_binding_descriptions.size(),
 
-            .pBufferInfo = waste_vk_buffer_infos.empty()
-            ? nullptr : waste_vk_buffer_infos.data(),
+            .pVertexBindingDescriptions = waste_vk_binding_descriptions.data(),
 
-            .pTexelBufferView = waste_vk_texel_buffer_views.empty()
-            ? nullptr : waste_vk_texel_buffer_views.data()
+            .vertexAttributeDescriptionCount =
+            (uint32_t)waste_vk_attribute_descriptions.size(),
+
+            .pVertexAttributeDescriptions =
+            waste_vk_attribute_descriptions.data()
         };
     }
 
-    VkCopyDescriptorSet CopyDescriptorSet_to_vk(const CopyDescriptorSet& copy)
+    VkPipelineInputAssemblyStateCreateInfo InputAssemblyState_to_vk(
+        const InputAssemblyState& state
+    )
     {
-        return VkCopyDescriptorSet{
-            .sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET,
+        return VkPipelineInputAssemblyStateCreateInfo{
+            .sType =
+            VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+
             .pNext = nullptr,
-            .srcSet = lock_wptr(copy.src_set)->handle(),
-            .srcBinding = copy.src_binding,
-            .srcArrayElement = copy.src_array_element,
-            .dstSet = lock_wptr(copy.dst_set)->handle(),
-            .dstBinding = copy.dst_binding,
-            .dstArrayElement = copy.dst_array_element,
-            .descriptorCount = copy.descriptor_count
+            .flags = 0,
+            .topology = state.topology,
+            .primitiveRestartEnable = state.primitive_restart_enable
         };
     }
 
-    FormatProperties FormatProperties_from_vk(
-        const VkFormatProperties& properties
+    VkPipelineTessellationStateCreateInfo TessellationState_to_vk(
+        const TessellationState& state
     )
     {
-        return FormatProperties{
-            .linear_tiling_features = properties.linearTilingFeatures,
-            .optimal_tiling_features = properties.optimalTilingFeatures,
-            .buffer_features = properties.bufferFeatures
+        return VkPipelineTessellationStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .patchControlPoints = state.patch_control_points
         };
     }
 
-    ImageFormatProperties ImageFormatProperties_from_vk(
-        const VkImageFormatProperties& properties
-    )
+    VkViewport Viewport_to_vk(const Viewport& viewport)
     {
-        return ImageFormatProperties{
-            .max_extent = Extent3d_from_vk(properties.maxExtent),
-            .max_mip_levels = properties.maxMipLevels,
-            .max_array_layers = properties.maxArrayLayers,
-            .sample_counts = properties.sampleCounts,
-            .max_resource_size = properties.maxResourceSize
+        return VkViewport{
+            .x = viewport.x,
+            .y = viewport.y,
+            .width = viewport.width,
+            .height = viewport.height,
+            .minDepth = viewport.min_depth,
+            .maxDepth = viewport.max_depth
         };
     }
 
-#pragma endregion
+    VkOffset2D Offset2d_to_vk(const Offset2d& offset)
+    {
+        return VkOffset2D{
+            .x = offset.x,
+            .y = offset.y
+        };
+    }
 
-#pragma region error handling
+    VkOffset3D Offset3d_to_vk(const Offset3d& offset)
+    {
+        return VkOffset3D{
+            .x = offset.x,
+            .y = offset.y,
+            .z = offset.z
+        };
+    }
 
-    Error::Error()
-        : message("no error information provided"),
-        _vk_result(std::nullopt),
-        stringify_vk_result(false)
-    {}
+    VkRect2D Rect2d_to_vk(const Rect2d& rect)
+    {
+        return VkRect2D{
+            .offset = Offset2d_to_vk(rect.offset),
+            .extent = Extent2d_to_vk(rect.extent)
+        };
+    }
 
-    Error::Error(std::string message)
-        : message(std::move(message)),
-        _vk_result(std::nullopt),
-        stringify_vk_result(false)
-    {}
+    VkPipelineViewportStateCreateInfo ViewportState_to_vk(
+        const ViewportState& state,
+        std::vector<VkViewport>& waste_vk_viewports,
+        std::vector<VkRect2D>& waste_vk_scissors
+    )
+    {
+        waste_vk_viewports.resize(state.viewports.size());
+        for (size_t i = 0; i < state.viewports.size(); i++)
+        {
+            waste_vk_viewports[i] = Viewport_to_vk(state.viewports[i]);
+        }
 
-    Error::Error(const VkResult vk_result)
-        : message(""),
+        waste_vk_scissors.resize(state.scissors.size());
+        for (size_t i = 0; i < state.scissors.size(); i++)
+        {
+            waste_vk_scissors[i] = Rect2d_to_vk(state.scissors[i]);
+        }
+
+        return VkPipelineViewportStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .viewportCount = (uint32_t)waste_vk_viewports.size(),
+            .pViewports = waste_vk_viewports.data(),
+            .scissorCount = (uint32_t)waste_vk_scissors.size(),
+            .pScissors = waste_vk_scissors.data()
+        };
+    }
+
+    VkPipelineRasterizationStateCreateInfo RasterizationState_to_vk(
+        const RasterizationState& state
+    )
+    {
+        return VkPipelineRasterizationStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .depthClampEnable = state.depth_clamp_enable,
+            .rasterizerDiscardEnable = state.rasterizer_discard_enable,
+            .polygonMode = state.polygon_mode,
+            .cullMode = state.cull_mode,
+            .frontFace = state.front_face,
+            .depthBiasEnable = state.depth_bias_enable,
+            .depthBiasConstantFactor = state.depth_bias_constant_factor,
+            .depthBiasClamp = state.depth_bias_clamp,
+            .depthBiasSlopeFactor = state.depth_bias_slope_factor,
+            .lineWidth = state.line_width
+        };
+    }
+
+    VkPipelineMultisampleStateCreateInfo MultisampleState_to_vk(
+        const MultisampleState& state,
+        std::vector<VkSampleMask>& waste_sample_mask
+    )
+    {
+        waste_sample_mask = state.sample_mask;
+        return VkPipelineMultisampleStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .rasterizationSamples = state.rasterization_samples,
+            .sampleShadingEnable = state.sample_shading_enable,
+            .minSampleShading = state.min_sample_shading,
+            .pSampleMask = waste_sample_mask.data(),
+            .alphaToCoverageEnable = state.alpha_to_coverage_enable,
+            .alphaToOneEnable = state.alpha_to_one_enable
+        };
+    }
+
+    VkStencilOpState StencilOpState_to_vk(const StencilOpState& state)
+    {
+        return VkStencilOpState{
+            .failOp = state.fail_op,
+            .passOp = state.pass_op,
+            .depthFailOp = state.depth_fail_op,
+            .compareOp = state.compare_op,
+            .compareMask = state.compare_mask,
+            .writeMask = state.write_mask,
+            .reference = state.reference
+        };
+    }
+
+    VkPipelineDepthStencilStateCreateInfo DepthStencilState_to_vk(
+        const DepthStencilState& state
+    )
+    {
+        return VkPipelineDepthStencilStateCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = state.flags,
+            .depthTestEnable = state.depth_test_enable,
+            .depthWriteEnable = state.depth_write_enable,
+            .depthCompareOp = state.depth_compare_op,
+            .depthBoundsTestEnable = state.depth_bounds_test_enable,
+            .stencilTestEnable = state.stencil_test_enable,
+            .front = StencilOpState_to_vk(state.front),
+            .back = StencilOpState_to_vk(state.back),
+            .minDepthBounds = state.min_depth_bounds,
+            .maxDepthBounds = state.max_depth_bounds
+        };
+    }
+
+    VkPipelineColorBlendAttachmentState ColorBlendAttachment_to_vk(
+        const ColorBlendAttachment& attachment
+    )
+    {
+        return VkPipelineColorBlendAttachmentState{
+            .blendEnable = attachment.blend_enable,
+            .srcColorBlendFactor = attachment.src_color_blend_factor,
+            .dstColorBlendFactor = attachment.dst_color_blend_factor,
+            .colorBlendOp = attachment.color_blend_op,
+            .srcAlphaBlendFactor = attachment.src_alpha_blend_factor,
+            .dstAlphaBlendFactor = attachment.dst_alpha_blend_factor,
+            .alphaBlendOp = attachment.alpha_blend_op,
+            .colorWriteMask = attachment.color_write_mask
+        };
+    }
+
+    VkColorBlendEquationEXT ColorBlendEquation_to_vk(
+        const ColorBlendEquation& equation
+    )
+    {
+        return VkColorBlendEquationEXT{
+            .srcColorBlendFactor = equation.src_color_blend_factor,
+            .dstColorBlendFactor = equation.dst_color_blend_factor,
+            .colorBlendOp = equation.color_blend_op,
+            .srcAlphaBlendFactor = equation.src_alpha_blend_factor,
+            .dstAlphaBlendFactor = equation.dst_alpha_blend_factor,
+            .alphaBlendOp = equation.alpha_blend_op
+        };
+    }
+
+    VkPipelineColorBlendStateCreateInfo ColorBlendState_to_vk(
+        const ColorBlendState& state,
+
+        std::vector<VkPipelineColorBlendAttachmentState>&
+        waste_vk_color_blend_attachments
+    )
+    {
+        waste_vk_color_blend_attachments.resize(state.attachments.size());
+        for (size_t i = 0; i < state.attachments.size(); i++)
+        {
+            waste_vk_color_blend_attachments[i] = ColorBlendAttachment_to_vk(
+                state.attachments[i]
+            );
+        }
+
+        VkPipelineColorBlendStateCreateInfo info{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = state.flags,
+            .logicOpEnable = state.logic_op_enable,
+            .logicOp = state.logic_op,
+
+            .attachmentCount =
+            (uint32_t)waste_vk_color_blend_attachments.size(),
+
+            .pAttachments = waste_vk_color_blend_attachments.data()
+        };
+        std::copy(
+            state.blend_constants.data(),
+            state.blend_constants.data() + 4,
+            info.blendConstants
+        );
+        return info;
+    }
+
+    VkDescriptorSetLayoutBinding DescriptorSetLayoutBinding_to_vk(
+        const DescriptorSetLayoutBinding& binding,
+        std::vector<VkSampler>& waste_vk_immutable_samplers
+    )
+    {
+        waste_vk_immutable_samplers.resize(binding.immutable_samplers.size());
+        for (size_t i = 0; i < binding.immutable_samplers.size(); i++)
+        {
+            waste_vk_immutable_samplers[i] =
+                lock_wptr(binding.immutable_samplers[i])->handle();
+        }
+
+        return VkDescriptorSetLayoutBinding{
+            .binding = binding.binding,
+            .descriptorType = binding.descriptor_type,
+            .descriptorCount = binding.descriptor_count,
+            .stageFlags = binding.stage_flags,
+
+            .pImmutableSamplers =
+            waste_vk_immutable_samplers.empty()
+            ? nullptr
+            : waste_vk_immutable_samplers.data()
+        };
+    }
+
+    VkPushConstantRange PushConstantRange_to_vk(const PushConstantRange& range)
+    {
+        return VkPushConstantRange{
+            .stageFlags = range.stage_flags,
+            .offset = range.offset,
+            .size = range.size
+        };
+    }
+
+    VkAttachmentDescription Attachment_to_vk(
+        const Attachment& attachment
+    )
+    {
+        return VkAttachmentDescription{
+            .flags = attachment.flags,
+            .format = attachment.format,
+            .samples = attachment.samples,
+            .loadOp = attachment.load_op,
+            .storeOp = attachment.store_op,
+            .stencilLoadOp = attachment.stencil_load_op,
+            .stencilStoreOp = attachment.stencil_store_op,
+            .initialLayout = attachment.initial_layout,
+            .finalLayout = attachment.final_layout
+        };
+    }
+
+    VkAttachmentReference AttachmentReference_to_vk(
+        const AttachmentReference& ref
+    )
+    {
+        return VkAttachmentReference{
+            .attachment = ref.attachment,
+            .layout = ref.layout
+        };
+    }
+
+    VkSubpassDescription Subpass_to_vk(
+        const Subpass& subpass,
+        std::vector<VkAttachmentReference>& waste_vk_input_attachments,
+        std::vector<VkAttachmentReference>& waste_vk_color_attachments,
+        std::vector<VkAttachmentReference>& waste_vk_resolve_attachments,
+        VkAttachmentReference& waste_vk_depth_stencil_attachment,
+        std::vector<uint32_t>& waste_preserve_attachment_indices
+    )
+    {
+        waste_vk_input_attachments.resize(subpass.input_attachments.size());
+        for (size_t i = 0; i < subpass.input_attachments.size(); i++)
+        {
+            waste_vk_input_attachments[i] = AttachmentReference_to_vk(
+                subpass.input_attachments[i]
+            );
+        }
+
+        waste_vk_color_attachments.resize(subpass.color_attachments.size());
+        for (size_t i = 0; i < subpass.color_attachments.size(); i++)
+        {
+            waste_vk_color_attachments[i] = AttachmentReference_to_vk(
+                subpass.color_attachments[i]
+            );
+        }
+
+        waste_vk_resolve_attachments.resize(subpass.resolve_attachments.size());
+        for (size_t i = 0; i < subpass.resolve_attachments.size(); i++)
+        {
+            waste_vk_resolve_attachments[i] = AttachmentReference_to_vk(
+                subpass.resolve_attachments[i]
+            );
+        }
+
+        if (subpass.depth_stencil_attachment.has_value())
+        {
+            waste_vk_depth_stencil_attachment = AttachmentReference_to_vk(
+                subpass.depth_stencil_attachment.value()
+            );
+        }
+
+        waste_preserve_attachment_indices = subpass.preserve_attachment_indices;
+
+        return VkSubpassDescription{
+            .flags = subpass.flags,
+            .pipelineBindPoint = subpass.pipeline_bind_point,
+            .inputAttachmentCount = (uint32_t)waste_vk_input_attachments.size(),
+            .pInputAttachments = waste_vk_input_attachments.data(),
+            .colorAttachmentCount = (uint32_t)waste_vk_color_attachments.size(),
+            .pColorAttachments = waste_vk_color_attachments.data(),
+
+            .pResolveAttachments =
+            waste_vk_resolve_attachments.empty()
+            ? nullptr
+            : waste_vk_resolve_attachments.data(),
+
+            .pDepthStencilAttachment =
+            subpass.depth_stencil_attachment.has_value()
+            ? &waste_vk_depth_stencil_attachment
+            : nullptr,
+
+            .preserveAttachmentCount =
+            (uint32_t)waste_preserve_attachment_indices.size(),
+
+            .pPreserveAttachments = waste_preserve_attachment_indices.data()
+        };
+    }
+
+    VkSubpassDependency SubpassDependency_to_vk(const SubpassDependency& dep)
+    {
+        return VkSubpassDependency{
+            .srcSubpass = dep.src_subpass,
+            .dstSubpass = dep.dst_subpass,
+            .srcStageMask = dep.src_stage_mask,
+            .dstStageMask = dep.dst_stage_mask,
+            .srcAccessMask = dep.src_access_mask,
+            .dstAccessMask = dep.dst_access_mask,
+            .dependencyFlags = dep.dependency_flags
+        };
+    }
+
+    MemoryRequirements MemoryRequirements_from_vk(
+        const VkMemoryRequirements& req
+    )
+    {
+        return MemoryRequirements{
+            .size = req.size,
+            .alignment = req.alignment,
+            .memory_type_bits = req.memoryTypeBits
+        };
+    }
+
+    MemoryType MemoryType_from_vk(const VkMemoryType& type)
+    {
+        return MemoryType{
+            .property_flags = type.propertyFlags,
+            .heap_index = type.heapIndex
+        };
+    }
+
+    MemoryHeap MemoryHeap_from_vk(const VkMemoryHeap& heap)
+    {
+        return MemoryHeap{
+            .size = heap.size,
+            .flags = heap.flags
+        };
+    }
+
+    PhysicalDeviceMemoryProperties PhysicalDeviceMemoryProperties_from_vk(
+        const VkPhysicalDeviceMemoryProperties& properties
+    )
+    {
+        std::vector<MemoryType> memory_types(properties.memoryTypeCount);
+        for (size_t i = 0; i < properties.memoryTypeCount; i++)
+        {
+            memory_types[i] = MemoryType_from_vk(properties.memoryTypes[i]);
+        }
+
+        std::vector<MemoryHeap> memory_heaps(properties.memoryHeapCount);
+        for (size_t i = 0; i < properties.memoryHeapCount; i++)
+        {
+            memory_heaps[i] = MemoryHeap_from_vk(properties.memoryHeaps[i]);
+        }
+
+        return PhysicalDeviceMemoryProperties{
+            .memory_types = memory_types,
+            .memory_heaps = memory_heaps
+        };
+    }
+
+    VkDescriptorPoolSize DescriptorPoolSize_to_vk(
+        const DescriptorPoolSize& pool_size
+    )
+    {
+        return VkDescriptorPoolSize{
+            .type = pool_size.type,
+            .descriptorCount = pool_size.descriptor_count
+        };
+    }
+
+    VkDescriptorImageInfo DescriptorImageInfo_to_vk(
+        const DescriptorImageInfo& info
+    )
+    {
+        return VkDescriptorImageInfo{
+            .sampler = info.sampler.has_value()
+            ? lock_wptr(info.sampler.value())->handle()
+            : nullptr,
+
+            .imageView = info.image_view.has_value()
+            ? lock_wptr(info.image_view.value())->handle()
+            : nullptr,
+
+            .imageLayout = info.image_layout
+        };
+    }
+
+    VkDescriptorBufferInfo DescriptorBufferInfo_to_vk(
+        const DescriptorBufferInfo& info
+    )
+    {
+        return VkDescriptorBufferInfo{
+            .buffer = lock_wptr(info.buffer)->handle(),
+            .offset = info.offset,
+            .range = info.range
+        };
+    }
+
+    VkWriteDescriptorSet WriteDescriptorSet_to_vk(
+        const WriteDescriptorSet& write,
+        std::vector<VkDescriptorImageInfo>& waste_vk_image_infos,
+        std::vector<VkDescriptorBufferInfo>& waste_vk_buffer_infos,
+        std::vector<VkBufferView>& waste_vk_texel_buffer_views
+    )
+    {
+        waste_vk_image_infos.resize(write.image_infos.size());
+        for (size_t i = 0; i < write.image_infos.size(); i++)
+        {
+            waste_vk_image_infos[i] = DescriptorImageInfo_to_vk(
+                write.image_infos[i]
+            );
+        }
+
+        waste_vk_buffer_infos.resize(write.buffer_infos.size());
+        for (size_t i = 0; i < write.buffer_infos.size(); i++)
+        {
+            waste_vk_buffer_infos[i] = DescriptorBufferInfo_to_vk(
+                write.buffer_infos[i]
+            );
+        }
+
+        waste_vk_texel_buffer_views.resize(write.texel_buffer_views.size());
+        for (size_t i = 0; i < write.texel_buffer_views.size(); i++)
+        {
+            waste_vk_texel_buffer_views[i] =
+                lock_wptr(write.texel_buffer_views[i])->handle();
+        }
+
+        return VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = lock_wptr(write.dst_set)->handle(),
+            .dstBinding = write.dst_binding,
+            .dstArrayElement = write.dst_array_element,
+            .descriptorCount = write.descriptor_count,
+            .descriptorType = write.descriptor_type,
+
+            .pImageInfo = waste_vk_image_infos.empty()
+            ? nullptr : waste_vk_image_infos.data(),
+
+            .pBufferInfo = waste_vk_buffer_infos.empty()
+            ? nullptr : waste_vk_buffer_infos.data(),
+
+            .pTexelBufferView = waste_vk_texel_buffer_views.empty()
+            ? nullptr : waste_vk_texel_buffer_views.data()
+        };
+    }
+
+    VkCopyDescriptorSet CopyDescriptorSet_to_vk(const CopyDescriptorSet& copy)
+    {
+        return VkCopyDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .srcSet = lock_wptr(copy.src_set)->handle(),
+            .srcBinding = copy.src_binding,
+            .srcArrayElement = copy.src_array_element,
+            .dstSet = lock_wptr(copy.dst_set)->handle(),
+            .dstBinding = copy.dst_binding,
+            .dstArrayElement = copy.dst_array_element,
+            .descriptorCount = copy.descriptor_count
+        };
+    }
+
+    FormatProperties FormatProperties_from_vk(
+        const VkFormatProperties& properties
+    )
+    {
+        return FormatProperties{
+            .linear_tiling_features = properties.linearTilingFeatures,
+            .optimal_tiling_features = properties.optimalTilingFeatures,
+            .buffer_features = properties.bufferFeatures
+        };
+    }
+
+    ImageFormatProperties ImageFormatProperties_from_vk(
+        const VkImageFormatProperties& properties
+    )
+    {
+        return ImageFormatProperties{
+            .max_extent = Extent3d_from_vk(properties.maxExtent),
+            .max_mip_levels = properties.maxMipLevels,
+            .max_array_layers = properties.maxArrayLayers,
+            .sample_counts = properties.sampleCounts,
+            .max_resource_size = properties.maxResourceSize
+        };
+    }
+
+    VkBufferMemoryBarrier BufferMemoryBarrier_to_vk(
+        const BufferMemoryBarrier& barrier
+    )
+    {
+        return VkBufferMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = barrier.src_access_mask,
+            .dstAccessMask = barrier.dst_access_mask,
+            .srcQueueFamilyIndex = barrier.src_queue_family_index,
+            .dstQueueFamilyIndex = barrier.dst_queue_family_index,
+            .buffer = lock_wptr(barrier.buffer)->handle(),
+            .offset = barrier.offset,
+            .size = barrier.size
+        };
+    }
+
+    VkImageMemoryBarrier ImageMemoryBarrier_to_vk(
+        const ImageMemoryBarrier& barrier
+    )
+    {
+        return VkImageMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = barrier.src_access_mask,
+            .dstAccessMask = barrier.dst_access_mask,
+            .oldLayout = barrier.old_layout,
+            .newLayout = barrier.new_layout,
+            .srcQueueFamilyIndex = barrier.src_queue_family_index,
+            .dstQueueFamilyIndex = barrier.dst_queue_family_index,
+            .image = lock_wptr(barrier.image)->handle(),
+            .subresourceRange = ImageSubresourceRange_to_vk(
+                barrier.subresource_range
+            )
+        };
+    }
+
+    VkSemaphoreSubmitInfo SemaphoreSubmitInfo_to_vk(
+        const SemaphoreSubmitInfo& info
+    )
+    {
+        return VkSemaphoreSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .semaphore = lock_wptr(info.semaphore)->handle(),
+            .value = info.value,
+            .stageMask = info.stage_mask,
+            .deviceIndex = info.device_index
+        };
+    }
+
+    VkMemoryBarrier2 MemoryBarrier2_to_vk(const MemoryBarrier2& barrier)
+    {
+        return VkMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = barrier.src_stage_mask,
+            .srcAccessMask = barrier.src_access_mask,
+            .dstStageMask = barrier.dst_stage_mask,
+            .dstAccessMask = barrier.dst_access_mask
+        };
+    }
+
+    VkBufferMemoryBarrier2 BufferMemoryBarrier2_to_vk(
+        const BufferMemoryBarrier2& barrier
+    )
+    {
+        return VkBufferMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = barrier.src_stage_mask,
+            .srcAccessMask = barrier.src_access_mask,
+            .dstStageMask = barrier.dst_stage_mask,
+            .dstAccessMask = barrier.dst_access_mask,
+            .srcQueueFamilyIndex = barrier.src_queue_family_index,
+            .dstQueueFamilyIndex = barrier.dst_queue_family_index,
+            .buffer = lock_wptr(barrier.buffer)->handle(),
+            .offset = barrier.offset,
+            .size = barrier.size
+        };
+    }
+
+    VkImageMemoryBarrier2 ImageMemoryBarrier2_to_vk(
+        const ImageMemoryBarrier2& barrier
+    )
+    {
+        return VkImageMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = barrier.src_stage_mask,
+            .srcAccessMask = barrier.src_access_mask,
+            .dstStageMask = barrier.dst_stage_mask,
+            .dstAccessMask = barrier.dst_access_mask,
+            .oldLayout = barrier.old_layout,
+            .newLayout = barrier.new_layout,
+            .srcQueueFamilyIndex = barrier.src_queue_family_index,
+            .dstQueueFamilyIndex = barrier.dst_queue_family_index,
+            .image = lock_wptr(barrier.image)->handle(),
+            .subresourceRange = ImageSubresourceRange_to_vk(
+                barrier.subresource_range
+            )
+        };
+    }
+
+    VkDependencyInfo DependencyInfo_to_vk(
+        const DependencyInfo& info,
+        std::vector<VkMemoryBarrier2>& waste_vk_memory_barriers,
+        std::vector<VkBufferMemoryBarrier2>& waste_vk_buffer_memory_barriers,
+        std::vector<VkImageMemoryBarrier2>& waste_vk_image_memory_barriers
+    )
+    {
+        waste_vk_memory_barriers.resize(info.memory_barriers.size());
+        for (size_t i = 0; i < info.memory_barriers.size(); i++)
+        {
+            waste_vk_memory_barriers[i] = MemoryBarrier2_to_vk(
+                info.memory_barriers[i]
+            );
+        }
+
+        waste_vk_buffer_memory_barriers.resize(
+            info.buffer_memory_barriers.size()
+        );
+        for (size_t i = 0; i < info.buffer_memory_barriers.size(); i++)
+        {
+            waste_vk_buffer_memory_barriers[i] = BufferMemoryBarrier2_to_vk(
+                info.buffer_memory_barriers[i]
+            );
+        }
+
+        waste_vk_image_memory_barriers.resize(
+            info.image_memory_barriers.size()
+        );
+        for (size_t i = 0; i < info.image_memory_barriers.size(); i++)
+        {
+            waste_vk_image_memory_barriers[i] = ImageMemoryBarrier2_to_vk(
+                info.image_memory_barriers[i]
+            );
+        }
+
+        return VkDependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = nullptr,
+            .dependencyFlags = info.dependency_flags,
+
+            .memoryBarrierCount = (uint32_t)waste_vk_memory_barriers.size(),
+            .pMemoryBarriers = waste_vk_memory_barriers.empty()
+            ? nullptr : waste_vk_memory_barriers.data(),
+
+            .bufferMemoryBarrierCount =
+            (uint32_t)waste_vk_buffer_memory_barriers.size(),
+
+            .pBufferMemoryBarriers = waste_vk_buffer_memory_barriers.empty()
+            ? nullptr : waste_vk_buffer_memory_barriers.data(),
+
+            .imageMemoryBarrierCount =
+            (uint32_t)waste_vk_image_memory_barriers.size(),
+
+            .pImageMemoryBarriers = waste_vk_image_memory_barriers.empty()
+            ? nullptr : waste_vk_image_memory_barriers.data()
+        };
+    }
+
+    VkRenderingAttachmentInfo RenderingAttachmentInfo_to_vk(
+        const RenderingAttachmentInfo& info
+    )
+    {
+        bool resolve = info.resolve_mode != VK_RESOLVE_MODE_NONE;
+        if (resolve && !info.resolve_image_view.has_value())
+        {
+            throw Error(
+                "resolve_image_view must be provided if resolve_mode is not "
+                "VK_RESOLVE_MODE_NONE"
+            );
+        }
+        return VkRenderingAttachmentInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = nullptr,
+            .imageView = lock_wptr(info.image_view)->handle(),
+            .imageLayout = info.image_layout,
+            .resolveMode = info.resolve_mode,
+
+            .resolveImageView = resolve
+            ? lock_wptr(info.resolve_image_view.value())->handle()
+            : VK_NULL_HANDLE,
+
+            .resolveImageLayout = info.resolve_image_layout,
+            .loadOp = info.load_op,
+            .storeOp = info.store_op,
+            .clearValue = info.clear_value
+        };
+    }
+
+    VkRenderingInfo RenderingInfo_to_vk(
+        const RenderingInfo& info,
+        std::vector<VkRenderingAttachmentInfo>& waste_vk_color_attachments,
+        VkRenderingAttachmentInfo& waste_vk_depth_attachment,
+        VkRenderingAttachmentInfo& waste_vk_stencil_attachment
+    )
+    {
+        waste_vk_color_attachments.resize(info.color_attachments.size());
+        for (size_t i = 0; i < info.color_attachments.size(); i++)
+        {
+            waste_vk_color_attachments[i] = RenderingAttachmentInfo_to_vk(
+                info.color_attachments[i]
+            );
+        }
+
+        if (info.depth_attachment.has_value())
+        {
+            waste_vk_depth_attachment = RenderingAttachmentInfo_to_vk(
+                info.depth_attachment.value()
+            );
+        }
+        if (info.stencil_attachment.has_value())
+        {
+            waste_vk_stencil_attachment = RenderingAttachmentInfo_to_vk(
+                info.stencil_attachment.value()
+            );
+        }
+
+        return VkRenderingInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .pNext = nullptr,
+            .flags = info.flags,
+            .renderArea = Rect2d_to_vk(info.render_area),
+            .layerCount = info.layer_count,
+            .viewMask = info.view_mask,
+            .colorAttachmentCount = (uint32_t)waste_vk_color_attachments.size(),
+
+            .pColorAttachments = waste_vk_color_attachments.empty()
+            ? nullptr : waste_vk_color_attachments.data(),
+
+            .pDepthAttachment = info.depth_attachment.has_value()
+            ? &waste_vk_depth_attachment : nullptr,
+
+            .pStencilAttachment = info.stencil_attachment.has_value()
+            ? &waste_vk_stencil_attachment : nullptr
+        };
+    }
+
+#pragma endregion
+
+#pragma region error handling
+
+    Error::Error()
+        : message("no error information provided"),
+        _vk_result(std::nullopt),
+        stringify_vk_result(false)
+    {}
+
+    Error::Error(std::string message)
+        : message(std::move(message)),
+        _vk_result(std::nullopt),
+        stringify_vk_result(false)
+    {}
+
+    Error::Error(const VkResult vk_result)
+        : message(""),
         _vk_result(vk_result),
         stringify_vk_result(true)
     {}
 
-    Error::Error(
-        std::string message,
-        const std::optional<VkResult>& vk_result,
-        bool vk_result_already_embedded_in_message
+    Error::Error(
+        std::string message,
+        const std::optional<VkResult>& vk_result,
+        bool vk_result_already_embedded_in_message
+    )
+        : message(std::move(message)),
+        _vk_result(vk_result),
+        stringify_vk_result(!vk_result_already_embedded_in_message)
+    {}
+
+    std::string Error::to_string() const
+    {
+        std::string s = message;
+        if (vk_result().has_value() && stringify_vk_result)
+        {
+            if (!message.empty())
+            {
+                s += ": ";
+            }
+            s += VkResult_to_string(vk_result().value());
+        }
+        return s;
+    }
+
+#pragma endregion
+
+#pragma region tracing
+
+    // also used for stall statistics, which don't depend on tracing
+    static int64_t trace_now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+#ifdef BV_ENABLE_TRACING
+
+    // events recorded by a single thread. only that thread writes to it and
+    // it publishes new events by incrementing n_events, so exporting never
+    // has to stop it.
+    struct ThreadTraceBuffer
+    {
+        uint32_t thread_idx;
+        std::vector<TraceEvent> events;
+        std::atomic<size_t> n_events = 0;
+        std::atomic<uint64_t> n_dropped_events = 0;
+    };
+
+    // buffers of every thread that has ever recorded a zone. they're kept
+    // alive after their thread exits so that its events can be exported.
+    static std::mutex trace_buffers_mutex;
+    static std::vector<std::shared_ptr<ThreadTraceBuffer>> trace_buffers;
+
+    static ThreadTraceBuffer& this_thread_trace_buffer()
+    {
+        thread_local std::shared_ptr<ThreadTraceBuffer> buffer = []()
+        {
+            auto new_buffer = std::make_shared<ThreadTraceBuffer>();
+            new_buffer->events.resize(TRACE_EVENTS_PER_THREAD);
+
+            std::scoped_lock lock(trace_buffers_mutex);
+            new_buffer->thread_idx = (uint32_t)trace_buffers.size();
+            trace_buffers.push_back(new_buffer);
+            return new_buffer;
+        }();
+        return *buffer;
+    }
+
+    // names are expected to be plain identifiers, this only escapes what
+    // would break the JSON
+    static std::string escape_json_string(const char* s)
+    {
+        std::string escaped;
+        for (; *s != '\0'; s++)
+        {
+            if (*s == '"' || *s == '\\')
+            {
+                escaped += '\\';
+            }
+            escaped += *s;
+        }
+        return escaped;
+    }
+
+    TraceZone::TraceZone(const char* name)
+        : name(name), begin_ns(trace_now_ns())
+    {}
+
+    TraceZone::~TraceZone()
+    {
+        auto& buffer = this_thread_trace_buffer();
+        size_t idx = buffer.n_events.load(std::memory_order_relaxed);
+        if (idx >= buffer.events.size())
+        {
+            buffer.n_dropped_events.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer.events[idx] = TraceEvent{
+            .name = name,
+            .begin_ns = begin_ns,
+            .end_ns = trace_now_ns()
+        };
+        buffer.n_events.store(idx + 1, std::memory_order_release);
+    }
+
+    std::string trace_to_chrome_json()
+    {
+        std::scoped_lock lock(trace_buffers_mutex);
+
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& buffer : trace_buffers)
+        {
+            json += std::format(
+                "{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                "\"tid\":{},\"args\":{{\"name\":\"thread {}\"}}}}",
+                first ? "" : ",",
+                buffer->thread_idx,
+                buffer->thread_idx
+            );
+            first = false;
+
+            size_t n_events =
+                buffer->n_events.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n_events; i++)
+            {
+                const auto& event = buffer->events[i];
+                json += std::format(
+                    ",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,"
+                    "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                    escape_json_string(event.name),
+                    buffer->thread_idx,
+                    (double)event.begin_ns * 1e-3,
+                    (double)(event.end_ns - event.begin_ns) * 1e-3
+                );
+            }
+        }
+        json += "\n]}\n";
+        return json;
+    }
+
+    void trace_clear()
+    {
+        std::scoped_lock lock(trace_buffers_mutex);
+        for (auto& buffer : trace_buffers)
+        {
+            buffer->n_events.store(0, std::memory_order_release);
+            buffer->n_dropped_events.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t trace_n_dropped_events()
+    {
+        std::scoped_lock lock(trace_buffers_mutex);
+        uint64_t n = 0;
+        for (const auto& buffer : trace_buffers)
+        {
+            n += buffer->n_dropped_events.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+#endif
+
+#pragma endregion
+
+#pragma region stall statistics
+
+    struct StallCallSiteEntry
+    {
+        StallCallSite site;
+
+        // the entry is stale if this isn't stall_epoch
+        uint64_t epoch;
+    };
+
+    // everything here is guarded by stall_mutex. resetting only increments
+    // the epoch so that it doesn't have to visit every counter.
+    static std::mutex stall_mutex;
+    static uint64_t stall_epoch = 1;
+    static std::atomic_bool stall_tracking = true;
+    static std::map<
+        std::tuple<std::string_view, uint32_t, uint32_t, std::string_view>,
+        StallCallSiteEntry
+    > stall_call_site_entries;
+
+    static void add_stall(StallStats& stats, uint64_t ns)
+    {
+        stats.n_calls++;
+        stats.total_ns += ns;
+        stats.max_ns = std::max(stats.max_ns, ns);
+    }
+
+    // the caller must hold stall_mutex
+    static void record_stall_call_site(
+        const char* call,
+        const std::source_location& location,
+        uint64_t ns
+    )
+    {
+        auto key = std::make_tuple(
+            std::string_view(location.file_name()),
+            location.line(),
+            location.column(),
+            std::string_view(call)
+        );
+        auto it = stall_call_site_entries.find(key);
+        if (it == stall_call_site_entries.end())
+        {
+            StallCallSiteEntry new_entry{
+                .site = StallCallSite{
+                    .call = call,
+                    .location = location,
+                    .stats = {}
+                },
+                .epoch = stall_epoch
+            };
+            it = stall_call_site_entries.emplace(key, new_entry).first;
+        }
+
+        auto& entry = it->second;
+        if (entry.epoch != stall_epoch)
+        {
+            entry.site.stats = {};
+            entry.epoch = stall_epoch;
+        }
+        add_stall(entry.site.stats, ns);
+    }
+
+    // measures how long the enclosing scope blocks and adds it to the call
+    // site and the counters of the objects involved under a single lock.
+    // does nothing if stall tracking is disabled.
+    class StallTimer
+    {
+    public:
+        StallTimer(
+            const char* call,
+            const std::source_location& location,
+            StallCounter& counter
+        )
+            : call(call),
+            location(location),
+            single_counter(&counter),
+            counters(&single_counter, 1),
+            enabled(stall_tracking_enabled()),
+            begin_ns(enabled ? trace_now_ns() : 0)
+        {}
+
+        StallTimer(
+            const char* call,
+            const std::source_location& location,
+            std::span<StallCounter* const> counters
+        )
+            : call(call),
+            location(location),
+            counters(counters),
+            enabled(stall_tracking_enabled()),
+            begin_ns(enabled ? trace_now_ns() : 0)
+        {}
+
+        StallTimer(const StallTimer& other) = delete;
+        StallTimer& operator=(const StallTimer& other) = delete;
+
+        ~StallTimer()
+        {
+            if (!enabled)
+            {
+                return;
+            }
+
+            uint64_t ns = (uint64_t)(trace_now_ns() - begin_ns);
+            std::scoped_lock lock(stall_mutex);
+            record_stall_call_site(call, location, ns);
+            for (auto counter : counters)
+            {
+                counter->add_locked(ns);
+            }
+        }
+
+    private:
+        const char* call;
+        std::source_location location;
+        StallCounter* single_counter = nullptr;
+        std::span<StallCounter* const> counters;
+        bool enabled;
+        int64_t begin_ns;
+
+    };
+
+    StallStats StallCounter::stats() const
+    {
+        std::scoped_lock lock(stall_mutex);
+        return epoch == stall_epoch ? _stats : StallStats{};
+    }
+
+    void StallCounter::add(uint64_t ns)
+    {
+        std::scoped_lock lock(stall_mutex);
+        add_locked(ns);
+    }
+
+    void StallCounter::add_locked(uint64_t ns)
+    {
+        if (epoch != stall_epoch)
+        {
+            _stats = {};
+            epoch = stall_epoch;
+        }
+        add_stall(_stats, ns);
+    }
+
+    std::vector<StallCallSite> stall_call_sites()
+    {
+        std::scoped_lock lock(stall_mutex);
+
+        std::vector<StallCallSite> sites;
+        for (const auto& [key, entry] : stall_call_site_entries)
+        {
+            if (entry.epoch == stall_epoch)
+            {
+                sites.push_back(entry.site);
+            }
+        }
+        return sites;
+    }
+
+    StallStats total_stall_stats()
+    {
+        std::scoped_lock lock(stall_mutex);
+
+        StallStats total{};
+        for (const auto& [key, entry] : stall_call_site_entries)
+        {
+            if (entry.epoch == stall_epoch)
+            {
+                total.n_calls += entry.site.stats.n_calls;
+                total.total_ns += entry.site.stats.total_ns;
+                total.max_ns = std::max(total.max_ns, entry.site.stats.max_ns);
+            }
+        }
+        return total;
+    }
+
+    void reset_stall_stats()
+    {
+        std::scoped_lock lock(stall_mutex);
+        stall_epoch++;
+    }
+
+    void set_stall_tracking_enabled(bool enabled)
+    {
+        stall_tracking.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool stall_tracking_enabled()
+    {
+        return stall_tracking.load(std::memory_order_relaxed);
+    }
+
+#pragma endregion
+
+#pragma region classes and object wrappers
+
+    std::vector<ExtensionProperties> PhysicalDevice::fetch_available_extensions(
+        const std::string& layer_name
+    ) const
+    {
+        try
+        {
+            const char* layer_name_cstr = nullptr;
+            if (!layer_name.empty())
+            {
+                layer_name_cstr = layer_name.c_str();
+            }
+
+            uint32_t count = 0;
+            dispatch().vkEnumerateDeviceExtensionProperties(
+                handle(),
+                layer_name_cstr,
+                &count,
+                nullptr
+            );
+
+            std::vector<VkExtensionProperties> vk_extensions(count);
+            VkResult vk_result =
+                dispatch().vkEnumerateDeviceExtensionProperties(
+                    handle(),
+                    layer_name_cstr,
+                    &count,
+                    vk_extensions.data()
+                );
+            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<ExtensionProperties> extensions;
+            extensions.reserve(vk_extensions.size());
+            for (const auto& vk_ext : vk_extensions)
+            {
+                extensions.push_back(ExtensionProperties_from_vk(vk_ext));
+            }
+            return extensions;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch available device extensions: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    FormatProperties PhysicalDevice::fetch_format_properties(
+        VkFormat format
+    ) const
+    {
+        VkFormatProperties vk_properties;
+        dispatch().vkGetPhysicalDeviceFormatProperties(
+            handle(),
+            format,
+            &vk_properties
+        );
+        return FormatProperties_from_vk(vk_properties);
+    }
+
+    std::optional<VkFormat> PhysicalDevice::find_supported_image_format(
+        const std::vector<VkFormat>& candidates,
+        VkImageTiling tiling,
+        VkFormatFeatureFlags features
+    ) const
+    {
+        for (VkFormat format : candidates)
+        {
+            auto props = fetch_format_properties(format);
+            if (tiling == VK_IMAGE_TILING_LINEAR
+                && (props.linear_tiling_features & features) == features)
+            {
+                return format;
+            }
+            else if (tiling == VK_IMAGE_TILING_OPTIMAL
+                && (props.optimal_tiling_features & features) == features)
+            {
+                return format;
+            }
+        }
+        return std::nullopt;
+    }
+
+    ImageFormatProperties PhysicalDevice::fetch_image_format_properties(
+        VkFormat format,
+        VkImageType type,
+        VkImageTiling tiling,
+        VkImageUsageFlags usage,
+        VkImageCreateFlags flags
+    ) const
+    {
+        try
+        {
+            VkImageFormatProperties vk_properties;
+            VkResult vk_result =
+                dispatch().vkGetPhysicalDeviceImageFormatProperties(
+                    handle(),
+                    format,
+                    type,
+                    tiling,
+                    usage,
+                    flags,
+                    &vk_properties
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return ImageFormatProperties_from_vk(vk_properties);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch image format properties: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::optional<SwapchainSupport> PhysicalDevice::fetch_swapchain_support(
+        const SurfacePtr& surface
+    ) const
+    {
+        if (surface == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        try
+        {
+            // check for extension
+            auto available_extensions = fetch_available_extensions();
+            bool has_extension = false;
+            for (const auto& ext : available_extensions)
+            {
+                if (ext.name == VK_KHR_SWAPCHAIN_EXTENSION_NAME)
+                {
+                    has_extension = true;
+                    break;
+                }
+            }
+            if (!has_extension)
+            {
+                return std::nullopt;
+            }
+
+            VkSurfaceCapabilitiesKHR vk_capabilities;
+            VkResult vk_result =
+                dispatch().vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+                    handle(),
+                    surface->handle(),
+                    &vk_capabilities
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(
+                    "failed to get physical device surface capabilities",
+                    vk_result,
+                    false
+                );
+            }
+
+            std::vector<SurfaceFormat> surface_formats;
+            {
+                uint32_t surface_format_count;
+                dispatch().vkGetPhysicalDeviceSurfaceFormatsKHR(
+                    handle(),
+                    surface->handle(),
+                    &surface_format_count,
+                    nullptr
+                );
+
+                std::vector<VkSurfaceFormatKHR> vk_surface_formats(
+                    surface_format_count
+                );
+                vk_result = dispatch().vkGetPhysicalDeviceSurfaceFormatsKHR(
+                    handle(),
+                    surface->handle(),
+                    &surface_format_count,
+                    vk_surface_formats.data()
+                );
+                if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+                {
+                    throw Error(
+                        "failed to get physical device surface formats",
+                        vk_result,
+                        false
+                    );
+                }
+
+                surface_formats.reserve(vk_surface_formats.size());
+                for (const auto& vk_surface_format : vk_surface_formats)
+                {
+                    surface_formats.push_back(
+                        SurfaceFormat_from_vk(vk_surface_format)
+                    );
+                }
+            }
+
+            std::vector<VkPresentModeKHR> present_modes;
+            {
+                uint32_t present_mode_count;
+                dispatch().vkGetPhysicalDeviceSurfacePresentModesKHR(
+                    handle(),
+                    surface->handle(),
+                    &present_mode_count,
+                    nullptr
+                );
+
+                present_modes.resize(present_mode_count);
+                vk_result =
+                    dispatch().vkGetPhysicalDeviceSurfacePresentModesKHR(
+                        handle(),
+                        surface->handle(),
+                        &present_mode_count,
+                        present_modes.data()
+                    );
+                if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+                {
+                    throw Error(
+                        "failed to get physical device surface present modes",
+                        vk_result,
+                        false
+                    );
+                }
+            }
+
+            return SwapchainSupport{
+                .capabilities = SurfaceCapabilities_from_vk(vk_capabilities),
+                .surface_formats = surface_formats,
+                .present_modes = present_modes
+            };
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch swapchain support details: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<uint32_t> PhysicalDevice::find_queue_family_indices(
+        VkQueueFlags must_support,
+        VkQueueFlags must_not_support,
+        const SurfacePtr& must_support_surface,
+        uint32_t min_queue_count
+    ) const
+    {
+        try
+        {
+            std::vector<uint32_t> indices;
+            for (size_t i = 0; i < queue_families().size(); i++)
+            {
+                const auto& fam = queue_families()[i];
+                if ((fam.queue_flags & must_support) != must_support)
+                {
+                    continue;
+                }
+                if ((fam.queue_flags & must_not_support) != 0)
+                {
+                    continue;
+                }
+                if (must_support_surface != nullptr)
+                {
+                    VkBool32 vk_surface_support = VK_FALSE;
+                    VkResult vk_result =
+                        dispatch().vkGetPhysicalDeviceSurfaceSupportKHR(
+                            handle(),
+                            (uint32_t)i,
+                            must_support_surface->handle(),
+                            &vk_surface_support
+                        );
+                    if (vk_result != VK_SUCCESS)
+                    {
+                        throw Error(
+                            "failed to check physical device's surface support",
+                            vk_result,
+                            false
+                        );
+                    }
+
+                    if (!vk_surface_support)
+                    {
+                        continue;
+                    }
+                }
+                if (min_queue_count > 0 && fam.queue_count < min_queue_count)
+                {
+                    continue;
+                }
+
+                indices.push_back(i);
+            }
+            return indices;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to find queue family indices: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    uint32_t PhysicalDevice::find_first_queue_family_index(
+        VkQueueFlags must_support,
+        VkQueueFlags must_not_support,
+        const SurfacePtr& must_support_surface,
+        uint32_t min_queue_count
+    ) const
+    {
+        auto indices = find_queue_family_indices(
+            must_support,
+            must_not_support,
+            must_support_surface,
+            min_queue_count
+        );
+        if (indices.empty())
+        {
+            throw Error("no queue family meets the required criteria");
+        }
+        return indices[0];
+    }
+
+    PhysicalDevice::PhysicalDevice(
+        const std::shared_ptr<const InstanceDispatch>& dispatch,
+        VkPhysicalDevice handle,
+        const PhysicalDeviceProperties& properties,
+        const PhysicalDeviceFeatures& features,
+        const PhysicalDeviceMemoryProperties& memory_properties,
+        const std::vector<QueueFamily>& queue_families
+    )
+        : _handle(handle),
+        _properties(properties),
+        _features(features),
+        _memory_properties(memory_properties),
+        _queue_families(queue_families),
+        _dispatch(dispatch)
+    {}
+
+    Context::Context(Context&& other) noexcept
+        : _config(std::move(other._config))
+    {
+        _config = other._config;
+        other._config = {};
+
+        _allocator = other._allocator;
+        other._allocator = nullptr;
+
+        _vk_allocator = other._vk_allocator;
+        _vk_allocator.pUserData = _allocator.get();
+        other._vk_allocator = VkAllocationCallbacks{};
+
+        _vk_instance = other._vk_instance;
+        other._vk_instance = nullptr;
+
+        _dispatch = std::move(other._dispatch);
+    }
+
+    ContextPtr Context::create(
+        const ContextConfig& config,
+        const AllocatorPtr& allocator
+    )
+    {
+        try
+        {
+            ContextPtr c = std::make_shared<Context_public_ctor>(
+                config,
+                allocator
+            );
+
+            // allocation callbacks
+            {
+                c->_vk_allocator.pUserData = c->allocator().get();
+                c->_vk_allocator.pfnAllocation = vk_allocation_callback;
+                c->_vk_allocator.pfnReallocation = vk_reallocation_callback;
+                c->_vk_allocator.pfnFree = vk_free_callback;
+                c->_vk_allocator.pfnInternalAllocation =
+                    vk_internal_allocation_notification;
+                c->_vk_allocator.pfnInternalFree =
+                    vk_internal_free_notification;
+            }
+
+            VkInstanceCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+
+            if (c->config().will_enumerate_portability)
+                create_info.flags |=
+                VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+
+            VkApplicationInfo app_info{};
+            {
+                app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+
+                app_info.pApplicationName = c->config().app_name.c_str();
+                app_info.applicationVersion = c->config().app_version.encode();
+
+                app_info.pEngineName = c->config().engine_name.c_str();
+                app_info.engineVersion = c->config().engine_version.encode();
+
+                app_info.apiVersion = VulkanApiVersion_encode(
+                    c->config().vulkan_api_version
+                );
+            }
+            create_info.pApplicationInfo = &app_info;
+
+            std::vector<const char*> layers_cstr;
+            {
+                layers_cstr.reserve(
+                    c->config().layers.size()
+                );
+                for (const auto& layer : c->config().layers)
+                {
+                    layers_cstr.push_back(layer.c_str());
+                }
+
+                create_info.enabledLayerCount =
+                    (uint32_t)layers_cstr.size();
+                create_info.ppEnabledLayerNames =
+                    layers_cstr.data();
+            }
+
+            std::vector<const char*> extensions_cstr;
+            {
+                extensions_cstr.reserve(
+                    c->config().extensions.size()
+                );
+                for (const auto& ext : c->config().extensions)
+                {
+                    extensions_cstr.push_back(ext.c_str());
+                }
+
+                create_info.enabledExtensionCount =
+                    (uint32_t)extensions_cstr.size();
+                create_info.ppEnabledExtensionNames =
+                    extensions_cstr.data();
+            }
+
+            VkResult vk_result = vkCreateInstance(
+                &create_info,
+                c->vk_allocator_ptr(),
+                &c->_vk_instance
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            c->_dispatch = load_instance_dispatch(c->_vk_instance);
+            return c;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create instance for context: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<LayerProperties> Context::fetch_available_layers()
+    {
+        try
+        {
+            uint32_t count = 0;
+            vkEnumerateInstanceLayerProperties(
+                &count,
+                nullptr
+            );
+
+            std::vector<VkLayerProperties> vk_layers(count);
+            VkResult vk_result = vkEnumerateInstanceLayerProperties(
+                &count,
+                vk_layers.data()
+            );
+            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<LayerProperties> layers;
+            layers.reserve(vk_layers.size());
+            for (const auto& vk_layer : vk_layers)
+            {
+                layers.push_back(LayerProperties_from_vk(vk_layer));
+            }
+            return layers;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch available instance layers: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<ExtensionProperties> Context::fetch_available_extensions(
+        const std::string& layer_name
+    )
+    {
+        try
+        {
+            const char* layer_name_cstr = nullptr;
+            if (!layer_name.empty())
+            {
+                layer_name_cstr = layer_name.c_str();
+            }
+
+            uint32_t count = 0;
+            vkEnumerateInstanceExtensionProperties(
+                layer_name_cstr,
+                &count,
+                nullptr
+            );
+
+            std::vector<VkExtensionProperties> vk_extensions(count);
+            VkResult vk_result = vkEnumerateInstanceExtensionProperties(
+                layer_name_cstr,
+                &count,
+                vk_extensions.data()
+            );
+            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<ExtensionProperties> extensions;
+            extensions.reserve(vk_extensions.size());
+            for (const auto& vk_ext : vk_extensions)
+            {
+                extensions.push_back(ExtensionProperties_from_vk(vk_ext));
+            }
+            return extensions;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch available instance extensions: "
+                + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Context::set_allocator(const AllocatorPtr& allocator)
+    {
+        _allocator = allocator;
+        _vk_allocator.pUserData = _allocator.get();
+    }
+
+    const VkAllocationCallbacks* Context::vk_allocator_ptr() const
+    {
+        if (_allocator == nullptr)
+        {
+            return nullptr;
+        }
+        return &_vk_allocator;
+    }
+
+    // VkPhysicalDeviceVulkan11Features only exists since Vulkan 1.2. on 1.1
+    // the same features come from the structs of the promoted extensions.
+    static VkPhysicalDeviceVulkan11Features fetch_vulkan11_features_on_1_1(
+        const InstanceDispatch& dispatch,
+        VkPhysicalDevice vk_physical_device
+    )
+    {
+        VkPhysicalDeviceShaderDrawParametersFeatures vk_draw_parameters{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES,
+
+            .pNext = nullptr
+        };
+        VkPhysicalDeviceSamplerYcbcrConversionFeatures vk_ycbcr{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES,
+
+            .pNext = &vk_draw_parameters
+        };
+        VkPhysicalDeviceProtectedMemoryFeatures vk_protected_memory{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROTECTED_MEMORY_FEATURES,
+
+            .pNext = &vk_ycbcr
+        };
+        VkPhysicalDeviceVariablePointersFeatures vk_variable_pointers{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VARIABLE_POINTERS_FEATURES,
+
+            .pNext = &vk_protected_memory
+        };
+        VkPhysicalDeviceMultiviewFeatures vk_multiview{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES,
+            .pNext = &vk_variable_pointers
+        };
+        VkPhysicalDevice16BitStorageFeatures vk_16bit_storage{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES,
+            .pNext = &vk_multiview
+        };
+        VkPhysicalDeviceFeatures2 vk_features2{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &vk_16bit_storage
+        };
+        dispatch.vkGetPhysicalDeviceFeatures2(
+            vk_physical_device,
+            &vk_features2
+        );
+
+        return VkPhysicalDeviceVulkan11Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+            .pNext = nullptr,
+
+            .storageBuffer16BitAccess =
+            vk_16bit_storage.storageBuffer16BitAccess,
+
+            .uniformAndStorageBuffer16BitAccess =
+            vk_16bit_storage.uniformAndStorageBuffer16BitAccess,
+
+            .storagePushConstant16 = vk_16bit_storage.storagePushConstant16,
+            .storageInputOutput16 = vk_16bit_storage.storageInputOutput16,
+            .multiview = vk_multiview.multiview,
+            .multiviewGeometryShader = vk_multiview.multiviewGeometryShader,
+
+            .multiviewTessellationShader =
+            vk_multiview.multiviewTessellationShader,
+
+            .variablePointersStorageBuffer =
+            vk_variable_pointers.variablePointersStorageBuffer,
+
+            .variablePointers = vk_variable_pointers.variablePointers,
+            .protectedMemory = vk_protected_memory.protectedMemory,
+            .samplerYcbcrConversion = vk_ycbcr.samplerYcbcrConversion,
+            .shaderDrawParameters = vk_draw_parameters.shaderDrawParameters
+        };
+    }
+
+    // the structs of the extensions promoted to Vulkan 1.1 that together
+    // hold the same features as VkPhysicalDeviceVulkan11Features
+    struct Vulkan11FeatureStructs
+    {
+        VkPhysicalDevice16BitStorageFeatures storage_16bit;
+        VkPhysicalDeviceMultiviewFeatures multiview;
+        VkPhysicalDeviceVariablePointersFeatures variable_pointers;
+        VkPhysicalDeviceProtectedMemoryFeatures protected_memory;
+        VkPhysicalDeviceSamplerYcbcrConversionFeatures ycbcr;
+        VkPhysicalDeviceShaderDrawParametersFeatures draw_parameters;
+    };
+
+    // the opposite of fetch_vulkan11_features_on_1_1() for enabling features
+    // on a Vulkan 1.1 device. fills out_structs, chains them in front of
+    // p_next, and returns the new head of the chain.
+    static void* chain_vulkan11_features_on_1_1(
+        const VkPhysicalDeviceVulkan11Features& vk_features,
+        Vulkan11FeatureStructs& out_structs,
+        void* p_next
+    )
+    {
+        out_structs.storage_16bit = VkPhysicalDevice16BitStorageFeatures{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES,
+            .pNext = p_next,
+
+            .storageBuffer16BitAccess =
+            vk_features.storageBuffer16BitAccess,
+
+            .uniformAndStorageBuffer16BitAccess =
+            vk_features.uniformAndStorageBuffer16BitAccess,
+
+            .storagePushConstant16 = vk_features.storagePushConstant16,
+            .storageInputOutput16 = vk_features.storageInputOutput16
+        };
+        out_structs.multiview = VkPhysicalDeviceMultiviewFeatures{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES,
+            .pNext = &out_structs.storage_16bit,
+            .multiview = vk_features.multiview,
+            .multiviewGeometryShader = vk_features.multiviewGeometryShader,
+
+            .multiviewTessellationShader =
+            vk_features.multiviewTessellationShader
+        };
+        out_structs.variable_pointers =
+            VkPhysicalDeviceVariablePointersFeatures{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VARIABLE_POINTERS_FEATURES,
+
+                .pNext = &out_structs.multiview,
+
+                .variablePointersStorageBuffer =
+                vk_features.variablePointersStorageBuffer,
+
+                .variablePointers = vk_features.variablePointers
+            };
+        out_structs.protected_memory = VkPhysicalDeviceProtectedMemoryFeatures{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROTECTED_MEMORY_FEATURES,
+
+            .pNext = &out_structs.variable_pointers,
+            .protectedMemory = vk_features.protectedMemory
+        };
+        out_structs.ycbcr = VkPhysicalDeviceSamplerYcbcrConversionFeatures{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES,
+
+            .pNext = &out_structs.protected_memory,
+            .samplerYcbcrConversion = vk_features.samplerYcbcrConversion
+        };
+        out_structs.draw_parameters =
+            VkPhysicalDeviceShaderDrawParametersFeatures{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES,
+
+                .pNext = &out_structs.ycbcr,
+                .shaderDrawParameters = vk_features.shaderDrawParameters
+            };
+        return &out_structs.draw_parameters;
+    }
+
+    // VkPhysicalDeviceVulkan11Properties only exists since Vulkan 1.2. on 1.1
+    // the same limits come from the structs of the promoted extensions.
+    static VkPhysicalDeviceVulkan11Properties fetch_vulkan11_properties_on_1_1(
+        const InstanceDispatch& dispatch,
+        VkPhysicalDevice vk_physical_device
+    )
+    {
+        VkPhysicalDeviceMaintenance3Properties vk_maintenance3{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_3_PROPERTIES,
+
+            .pNext = nullptr
+        };
+        VkPhysicalDeviceProtectedMemoryProperties vk_protected_memory{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROTECTED_MEMORY_PROPERTIES,
+
+            .pNext = &vk_maintenance3
+        };
+        VkPhysicalDeviceMultiviewProperties vk_multiview{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES,
+            .pNext = &vk_protected_memory
+        };
+        VkPhysicalDevicePointClippingProperties vk_point_clipping{
+            .sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_POINT_CLIPPING_PROPERTIES,
+
+            .pNext = &vk_multiview
+        };
+        VkPhysicalDeviceSubgroupProperties vk_subgroup{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+            .pNext = &vk_point_clipping
+        };
+        VkPhysicalDeviceIDProperties vk_id{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+            .pNext = &vk_subgroup
+        };
+        VkPhysicalDeviceProperties2 vk_properties2{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &vk_id
+        };
+        dispatch.vkGetPhysicalDeviceProperties2(
+            vk_physical_device,
+            &vk_properties2
+        );
+
+        VkPhysicalDeviceVulkan11Properties vk_properties11{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_PROPERTIES,
+            .pNext = nullptr,
+            .deviceNodeMask = vk_id.deviceNodeMask,
+            .deviceLUIDValid = vk_id.deviceLUIDValid,
+            .subgroupSize = vk_subgroup.subgroupSize,
+            .subgroupSupportedStages = vk_subgroup.supportedStages,
+            .subgroupSupportedOperations = vk_subgroup.supportedOperations,
+
+            .subgroupQuadOperationsInAllStages =
+            vk_subgroup.quadOperationsInAllStages,
+
+            .pointClippingBehavior = vk_point_clipping.pointClippingBehavior,
+            .maxMultiviewViewCount = vk_multiview.maxMultiviewViewCount,
+
+            .maxMultiviewInstanceIndex =
+            vk_multiview.maxMultiviewInstanceIndex,
+
+            .protectedNoFault = vk_protected_memory.protectedNoFault,
+            .maxPerSetDescriptors = vk_maintenance3.maxPerSetDescriptors,
+
+            .maxMemoryAllocationSize =
+            vk_maintenance3.maxMemoryAllocationSize
+        };
+        std::copy(
+            std::begin(vk_id.deviceUUID),
+            std::end(vk_id.deviceUUID),
+            vk_properties11.deviceUUID
+        );
+        std::copy(
+            std::begin(vk_id.driverUUID),
+            std::end(vk_id.driverUUID),
+            vk_properties11.driverUUID
+        );
+        std::copy(
+            std::begin(vk_id.deviceLUID),
+            std::end(vk_id.deviceLUID),
+            vk_properties11.deviceLUID
+        );
+        return vk_properties11;
+    }
+
+    std::vector<PhysicalDevice> Context::fetch_physical_devices() const
+    {
+        try
+        {
+            uint32_t count = 0;
+            dispatch().vkEnumeratePhysicalDevices(
+                _vk_instance,
+                &count,
+                nullptr
+            );
+
+            std::vector<VkPhysicalDevice> vk_physical_devices(count);
+            VkResult vk_result = dispatch().vkEnumeratePhysicalDevices(
+                _vk_instance,
+                &count,
+                vk_physical_devices.data()
+            );
+            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<PhysicalDevice> physical_devices;
+            physical_devices.reserve(vk_physical_devices.size());
+            for (const auto& vk_physical_device : vk_physical_devices)
+            {
+                VkPhysicalDeviceProperties vk_properties;
+                dispatch().vkGetPhysicalDeviceProperties(
+                    vk_physical_device,
+                    &vk_properties
+                );
+                auto properties = PhysicalDeviceProperties_from_vk(
+                    vk_properties
+                );
+
+                VkPhysicalDeviceFeatures vk_features;
+                dispatch().vkGetPhysicalDeviceFeatures(
+                    vk_physical_device,
+                    &vk_features
+                );
+                auto features = PhysicalDeviceFeatures_from_vk(vk_features);
+
+                VkPhysicalDeviceMemoryProperties vk_memory_properties;
+                dispatch().vkGetPhysicalDeviceMemoryProperties(
+                    vk_physical_device,
+                    &vk_memory_properties
+                );
+                auto memory_properties = PhysicalDeviceMemoryProperties_from_vk(
+                    vk_memory_properties
+                );
+
+                uint32_t queue_family_count = 0;
+                dispatch().vkGetPhysicalDeviceQueueFamilyProperties(
+                    vk_physical_device,
+                    &queue_family_count,
+                    nullptr
+                );
+
+                std::vector<VkQueueFamilyProperties> vk_queue_families(
+                    queue_family_count
+                );
+                dispatch().vkGetPhysicalDeviceQueueFamilyProperties(
+                    vk_physical_device,
+                    &queue_family_count,
+                    vk_queue_families.data()
+                );
+
+                std::vector<QueueFamily> queue_families;
+                queue_families.reserve(vk_queue_families.size());
+                for (const auto& vk_family : vk_queue_families)
+                {
+                    queue_families.push_back(QueueFamily_from_vk(vk_family));
+                }
+
+                PhysicalDevice physical_device(
+                    _dispatch,
+                    vk_physical_device,
+                    properties,
+                    features,
+                    memory_properties,
+                    queue_families
+                );
+
+                // the Vulkan 1.x feature and property structs can only be
+                // chained if both the instance and the device support the
+                // matching API version. the 1.1 structs themselves were only
+                // added in 1.2 though.
+                uint32_t api_version = std::min(
+                    VulkanApiVersion_encode(config().vulkan_api_version),
+                    vk_properties.apiVersion
+                );
+                if (api_version >= VK_API_VERSION_1_1
+                    && dispatch().vkGetPhysicalDeviceFeatures2 != nullptr
+                    && dispatch().vkGetPhysicalDeviceProperties2 != nullptr)
+                {
+                    VkPhysicalDeviceVulkan13Features vk_features13{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+
+                        .pNext = nullptr
+                    };
+                    VkPhysicalDeviceVulkan12Features vk_features12{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+
+                        .pNext = api_version >= VK_API_VERSION_1_3
+                        ? &vk_features13 : nullptr
+                    };
+                    VkPhysicalDeviceVulkan11Features vk_features11{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+
+                        .pNext = api_version >= VK_API_VERSION_1_2
+                        ? &vk_features12 : nullptr
+                    };
+                    VkPhysicalDeviceFeatures2 vk_features2{
+                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                        .pNext = &vk_features11
+                    };
+                    if (api_version >= VK_API_VERSION_1_2)
+                    {
+                        dispatch().vkGetPhysicalDeviceFeatures2(
+                            vk_physical_device,
+                            &vk_features2
+                        );
+                    }
+                    else
+                    {
+                        vk_features11 = fetch_vulkan11_features_on_1_1(
+                            dispatch(),
+                            vk_physical_device
+                        );
+                    }
+
+                    VkPhysicalDeviceVulkan13Properties vk_properties13{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_PROPERTIES,
+
+                        .pNext = nullptr
+                    };
+                    VkPhysicalDeviceVulkan12Properties vk_properties12{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+
+                        .pNext = api_version >= VK_API_VERSION_1_3
+                        ? &vk_properties13 : nullptr
+                    };
+                    VkPhysicalDeviceVulkan11Properties vk_properties11{
+                        .sType =
+                        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_PROPERTIES,
+
+                        .pNext = api_version >= VK_API_VERSION_1_2
+                        ? &vk_properties12 : nullptr
+                    };
+                    VkPhysicalDeviceProperties2 vk_properties2{
+                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                        .pNext = &vk_properties11
+                    };
+                    if (api_version >= VK_API_VERSION_1_2)
+                    {
+                        dispatch().vkGetPhysicalDeviceProperties2(
+                            vk_physical_device,
+                            &vk_properties2
+                        );
+                    }
+                    else
+                    {
+                        vk_properties11 = fetch_vulkan11_properties_on_1_1(
+                            dispatch(),
+                            vk_physical_device
+                        );
+                    }
+
+                    physical_device._vulkan11_features =
+                        PhysicalDeviceVulkan11Features_from_vk(vk_features11);
+                    physical_device._vulkan11_properties =
+                        PhysicalDeviceVulkan11Properties_from_vk(
+                            vk_properties11
+                        );
+                    if (api_version >= VK_API_VERSION_1_2)
+                    {
+                        physical_device._vulkan12_features =
+                            PhysicalDeviceVulkan12Features_from_vk(
+                                vk_features12
+                            );
+                        physical_device._vulkan12_properties =
+                            PhysicalDeviceVulkan12Properties_from_vk(
+                                vk_properties12
+                            );
+                    }
+                    if (api_version >= VK_API_VERSION_1_3)
+                    {
+                        physical_device._vulkan13_features =
+                            PhysicalDeviceVulkan13Features_from_vk(
+                                vk_features13
+                            );
+                        physical_device._vulkan13_properties =
+                            PhysicalDeviceVulkan13Properties_from_vk(
+                                vk_properties13
+                            );
+                    }
+                }
+
+                physical_devices.push_back(std::move(physical_device));
+            }
+
+            return physical_devices;
+
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to fetch physical devices: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Context::~Context()
+    {
+        if (_dispatch == nullptr)
+        {
+            return;
+        }
+        dispatch().vkDestroyInstance(_vk_instance, vk_allocator_ptr());
+    }
+
+    Context::Context(
+        const ContextConfig& config,
+        const AllocatorPtr& allocator
+    )
+        : _config(config), _allocator(allocator)
+    {}
+
+    DebugMessengerPtr DebugMessenger::create(
+        const ContextPtr& context,
+        VkDebugUtilsMessageSeverityFlagsEXT message_severity_filter,
+        VkDebugUtilsMessageTypeFlagsEXT message_type_filter,
+        const DebugCallback& callback
+    )
+    {
+        try
+        {
+            DebugMessengerPtr messenger =
+                std::make_shared<DebugMessenger_public_ctor>(
+                    context,
+                    message_severity_filter,
+                    message_type_filter,
+                    callback
+                );
+
+            VkDebugUtilsMessengerCreateInfoEXT create_info{
+                .sType =
+                VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+
+                .pNext = nullptr,
+                .flags = 0,
+                .messageSeverity = messenger->message_severity_filter(),
+                .messageType = messenger->message_type_filter(),
+                .pfnUserCallback = vk_debug_callback,
+                .pUserData = messenger.get()
+            };
+
+            VkResult vk_result = CreateDebugUtilsMessengerEXT(
+                context->dispatch(),
+                context->vk_instance(),
+                &create_info,
+                context->vk_allocator_ptr(),
+                &messenger->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return messenger;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create debug messenger: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    DebugMessenger::~DebugMessenger()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
+        DestroyDebugUtilsMessengerEXT(
+            context_locked->dispatch(),
+            context_locked->vk_instance(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    DebugMessenger::DebugMessenger(
+        const ContextPtr& context,
+        VkDebugUtilsMessageSeverityFlagsEXT message_severity_filter,
+        VkDebugUtilsMessageTypeFlagsEXT message_type_filter,
+        const DebugCallback& callback
+    )
+        : _context(context),
+        _message_severity_filter(message_severity_filter),
+        _message_type_filter(message_type_filter),
+        _callback(callback)
+    {}
+
+    SurfacePtr Surface::create(
+        const ContextPtr& context,
+        VkSurfaceKHR handle
+    )
+    {
+        return std::make_shared<Surface_public_ctor>(context, handle);
+    }
+
+    SurfacePtr Surface::create_headless(const ContextPtr& context)
+    {
+        VkHeadlessSurfaceCreateInfoEXT create_info{
+            .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+            .pNext = nullptr,
+            .flags = 0
+        };
+
+        VkSurfaceKHR vk_surface;
+        VkResult vk_result = CreateHeadlessSurfaceEXT(
+            context->dispatch(),
+            context->vk_instance(),
+            &create_info,
+            context->vk_allocator_ptr(),
+            &vk_surface
+        );
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error("failed to create headless surface", vk_result, false);
+        }
+        return std::make_shared<Surface_public_ctor>(context, vk_surface);
+    }
+
+    Surface::~Surface()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
+        context_locked->dispatch().vkDestroySurfaceKHR(
+            context_locked->vk_instance(),
+            _handle,
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Surface::Surface(
+        const ContextPtr& context,
+        VkSurfaceKHR handle
+    )
+        : _context(context), _handle(handle)
+    {}
+
+    // convert the smart pointers to handles in arrays on the stack and call
+    // func with a batch using them. only falls back to the heap for unusually
+    // large submissions.
+    template<typename F>
+    static auto with_submit_batch(
+        const std::vector<VkPipelineStageFlags>& wait_stages,
+        const std::vector<SemaphorePtr>& wait_semaphores,
+        const std::vector<CommandBufferPtr>& command_buffers,
+        const std::vector<SemaphorePtr>& signal_semaphores,
+        const std::vector<uint64_t>& wait_values,
+        const std::vector<uint64_t>& signal_values,
+        F func
+    )
+    {
+        constexpr size_t n_inline_handles = 16;
+
+        std::array<VkSemaphore, n_inline_handles> inline_vk_semaphores;
+        std::vector<VkSemaphore> heap_vk_semaphores;
+        VkSemaphore* vk_semaphores = inline_vk_semaphores.data();
+
+        size_t n_semaphores = wait_semaphores.size() + signal_semaphores.size();
+        if (n_semaphores > n_inline_handles)
+        {
+            heap_vk_semaphores.resize(n_semaphores);
+            vk_semaphores = heap_vk_semaphores.data();
+        }
+
+        std::array<VkCommandBuffer, n_inline_handles>
+            inline_vk_command_buffers;
+        std::vector<VkCommandBuffer> heap_vk_command_buffers;
+        VkCommandBuffer* vk_command_buffers = inline_vk_command_buffers.data();
+
+        if (command_buffers.size() > n_inline_handles)
+        {
+            heap_vk_command_buffers.resize(command_buffers.size());
+            vk_command_buffers = heap_vk_command_buffers.data();
+        }
+
+        for (size_t i = 0; i < wait_semaphores.size(); i++)
+        {
+            vk_semaphores[i] = wait_semaphores[i]->handle();
+        }
+        for (size_t i = 0; i < signal_semaphores.size(); i++)
+        {
+            vk_semaphores[wait_semaphores.size() + i] =
+                signal_semaphores[i]->handle();
+        }
+        for (size_t i = 0; i < command_buffers.size(); i++)
+        {
+            vk_command_buffers[i] = command_buffers[i]->handle();
+        }
+
+        SubmitBatch batch{
+            .wait_semaphores = std::span<const VkSemaphore>(
+                vk_semaphores,
+                wait_semaphores.size()
+            ),
+            .wait_stages = wait_stages,
+            .command_buffers = std::span<const VkCommandBuffer>(
+                vk_command_buffers,
+                command_buffers.size()
+            ),
+            .signal_semaphores = std::span<const VkSemaphore>(
+                vk_semaphores + wait_semaphores.size(),
+                signal_semaphores.size()
+            ),
+            .wait_values = wait_values,
+            .signal_values = signal_values
+        };
+        return func(std::span<const SubmitBatch>(&batch, 1));
+    }
+
+    // see submit_count()
+    static std::atomic<uint64_t> n_submits = 0;
+
+    // what's wrong with the sizes of a batch's spans or nullptr if nothing
+    static const char* submit_batch_size_mismatch(const SubmitBatch& batch)
+    {
+        if (batch.wait_stages.size() != batch.wait_semaphores.size())
+        {
+            return "there should be one wait stage mask per wait semaphore";
+        }
+        if ((!batch.wait_values.empty()
+            && batch.wait_values.size() != batch.wait_semaphores.size())
+            || (!batch.signal_values.empty()
+                && batch.signal_values.size()
+                != batch.signal_semaphores.size()))
+        {
+            return
+                "there should either be no semaphore values or one value per "
+                "semaphore";
+        }
+        return nullptr;
+    }
+
+    void Queue::submit(
+        const std::vector<VkPipelineStageFlags>& wait_stages,
+        const std::vector<SemaphorePtr>& wait_semaphores,
+        const std::vector<CommandBufferPtr>& command_buffers,
+        const std::vector<SemaphorePtr>& signal_semaphores,
+        const FencePtr& signal_fence,
+        const std::vector<uint64_t>& wait_values,
+        const std::vector<uint64_t>& signal_values
+    )
+    {
+        BV_TRACE_ZONE("bv::Queue::submit");
+
+        with_submit_batch(
+            wait_stages,
+            wait_semaphores,
+            command_buffers,
+            signal_semaphores,
+            wait_values,
+            signal_values,
+            [&](std::span<const SubmitBatch> batches)
+            {
+                submit_batches(
+                    batches,
+                    signal_fence == nullptr
+                    ? VK_NULL_HANDLE : signal_fence->handle()
+                );
+            }
+        );
+    }
+
+    VkResult Queue::try_submit(
+        const std::vector<VkPipelineStageFlags>& wait_stages,
+        const std::vector<SemaphorePtr>& wait_semaphores,
+        const std::vector<CommandBufferPtr>& command_buffers,
+        const std::vector<SemaphorePtr>& signal_semaphores,
+        const FencePtr& signal_fence,
+        const std::vector<uint64_t>& wait_values,
+        const std::vector<uint64_t>& signal_values
+    )
+    {
+        BV_TRACE_ZONE("bv::Queue::try_submit");
+
+        return with_submit_batch(
+            wait_stages,
+            wait_semaphores,
+            command_buffers,
+            signal_semaphores,
+            wait_values,
+            signal_values,
+            [&](std::span<const SubmitBatch> batches)
+            {
+                return try_submit_batches(
+                    batches,
+                    signal_fence == nullptr
+                    ? VK_NULL_HANDLE : signal_fence->handle()
+                );
+            }
+        );
+    }
+
+    void Queue::submit_batches(
+        std::span<const SubmitBatch> batches,
+        VkFence signal_fence
+    )
+    {
+        BV_TRACE_ZONE("bv::Queue::submit_batches");
+
+        try
+        {
+            for (const auto& batch : batches)
+            {
+                const char* mismatch = submit_batch_size_mismatch(batch);
+                if (mismatch != nullptr)
+                {
+                    throw Error(mismatch);
+                }
+            }
+
+            VkResult vk_result = try_submit_batches(batches, signal_fence);
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to submit command buffer(s) to queue: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    VkResult Queue::try_submit_batches(
+        std::span<const SubmitBatch> batches,
+        VkFence signal_fence
+    )
+    {
+        for (const auto& batch : batches)
+        {
+            if (submit_batch_size_mismatch(batch) != nullptr)
+            {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
+
+        std::array<VkSubmitInfo, max_batches_per_submit> submit_infos;
+        std::array<VkTimelineSemaphoreSubmitInfo, max_batches_per_submit>
+            timeline_infos;
+
+        // submit at least once even if there are no batches so that the
+        // fence still gets signaled.
+        size_t offset = 0;
+        do
+        {
+            size_t n_batches = std::min(
+                batches.size() - offset,
+                max_batches_per_submit
+            );
+            for (size_t i = 0; i < n_batches; i++)
+            {
+                const auto& batch = batches[offset + i];
+
+                timeline_infos[i] = VkTimelineSemaphoreSubmitInfo{
+                    .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                    .pNext = nullptr,
+
+                    .waitSemaphoreValueCount =
+                    (uint32_t)batch.wait_values.size(),
+
+                    .pWaitSemaphoreValues =
+                    batch.wait_values.empty()
+                    ? nullptr : batch.wait_values.data(),
+
+                    .signalSemaphoreValueCount =
+                    (uint32_t)batch.signal_values.size(),
+
+                    .pSignalSemaphoreValues =
+                    batch.signal_values.empty()
+                    ? nullptr : batch.signal_values.data()
+                };
+                bool has_values =
+                    !batch.wait_values.empty()
+                    || !batch.signal_values.empty();
+
+                submit_infos[i] = VkSubmitInfo{
+                    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                    .pNext = has_values ? &timeline_infos[i] : nullptr,
+
+                    .waitSemaphoreCount =
+                    (uint32_t)batch.wait_semaphores.size(),
+
+                    .pWaitSemaphores =
+                    batch.wait_semaphores.empty()
+                    ? nullptr : batch.wait_semaphores.data(),
+
+                    .pWaitDstStageMask =
+                    batch.wait_stages.empty()
+                    ? nullptr : batch.wait_stages.data(),
+
+                    .commandBufferCount =
+                    (uint32_t)batch.command_buffers.size(),
+
+                    .pCommandBuffers =
+                    batch.command_buffers.empty()
+                    ? nullptr : batch.command_buffers.data(),
+
+                    .signalSemaphoreCount =
+                    (uint32_t)batch.signal_semaphores.size(),
+
+                    .pSignalSemaphores =
+                    batch.signal_semaphores.empty()
+                    ? nullptr : batch.signal_semaphores.data()
+                };
+            }
+            offset += n_batches;
+
+            // only the last chunk signals the fence
+            n_submits.fetch_add(1, std::memory_order_relaxed);
+            VkResult vk_result = dispatch().vkQueueSubmit(
+                handle(),
+                (uint32_t)n_batches,
+                submit_infos.data(),
+                offset == batches.size() ? signal_fence : VK_NULL_HANDLE
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                return vk_result;
+            }
+        } while (offset < batches.size());
+
+        return VK_SUCCESS;
+    }
+
+    void Queue::submit2(
+        const std::vector<SemaphoreSubmitInfo>& wait_semaphore_infos,
+        const std::vector<CommandBufferPtr>& command_buffers,
+        const std::vector<SemaphoreSubmitInfo>& signal_semaphore_infos,
+        const FencePtr& signal_fence
+    )
+    {
+        BV_TRACE_ZONE("bv::Queue::submit2");
+
+        try
+        {
+            std::vector<VkSemaphoreSubmitInfo> vk_semaphore_infos(
+                wait_semaphore_infos.size() + signal_semaphore_infos.size()
+            );
+            for (size_t i = 0; i < wait_semaphore_infos.size(); i++)
+            {
+                vk_semaphore_infos[i] = SemaphoreSubmitInfo_to_vk(
+                    wait_semaphore_infos[i]
+                );
+            }
+            for (size_t i = 0; i < signal_semaphore_infos.size(); i++)
+            {
+                vk_semaphore_infos[wait_semaphore_infos.size() + i] =
+                    SemaphoreSubmitInfo_to_vk(signal_semaphore_infos[i]);
+            }
+
+            std::vector<VkCommandBufferSubmitInfo> vk_command_buffer_infos(
+                command_buffers.size()
+            );
+            for (size_t i = 0; i < command_buffers.size(); i++)
+            {
+                vk_command_buffer_infos[i] = VkCommandBufferSubmitInfo{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                    .pNext = nullptr,
+                    .commandBuffer = command_buffers[i]->handle(),
+                    .deviceMask = 0
+                };
+            }
+
+            VkSubmitInfo2 submit_info{
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                .pNext = nullptr,
+                .flags = 0,
+
+                .waitSemaphoreInfoCount =
+                (uint32_t)wait_semaphore_infos.size(),
+
+                .pWaitSemaphoreInfos =
+                wait_semaphore_infos.empty()
+                ? nullptr : vk_semaphore_infos.data(),
+
+                .commandBufferInfoCount =
+                (uint32_t)vk_command_buffer_infos.size(),
+
+                .pCommandBufferInfos = vk_command_buffer_infos.data(),
+
+                .signalSemaphoreInfoCount =
+                (uint32_t)signal_semaphore_infos.size(),
+
+                .pSignalSemaphoreInfos =
+                signal_semaphore_infos.empty()
+                ? nullptr
+                : vk_semaphore_infos.data() + wait_semaphore_infos.size()
+            };
+
+            n_submits.fetch_add(1, std::memory_order_relaxed);
+            VkResult vk_result = QueueSubmit2KHR(
+                dispatch(),
+                handle(),
+                1,
+                &submit_info,
+                signal_fence == nullptr ? nullptr : signal_fence->handle()
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to submit command buffer(s) to queue: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Queue::present(
+        const std::vector<SemaphorePtr>& wait_semaphores,
+        const SwapchainPtr& swapchain,
+        uint32_t image_index,
+        VkResult* out_vk_result,
+        const std::source_location& location
+    )
+    {
+        VkResult vk_result = try_present(
+            wait_semaphores,
+            swapchain,
+            image_index,
+            location
+        );
+        if (out_vk_result != nullptr)
+        {
+            *out_vk_result = vk_result;
+        }
+        if (vk_result != VK_SUCCESS && vk_result != VK_SUBOPTIMAL_KHR)
+        {
+            throw Error(
+                "failed to queue image for presentation",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    VkResult Queue::try_present(
+        std::span<const SemaphorePtr> wait_semaphores,
+        const SwapchainPtr& swapchain,
+        uint32_t image_index,
+        const std::source_location& location
+    )
+    {
+        BV_TRACE_ZONE("bv::Queue::present");
+        StallTimer stall_timer("Queue::present", location, _stall_counter);
+
+        constexpr size_t n_inline_handles = 16;
+
+        std::array<VkSemaphore, n_inline_handles> inline_vk_semaphores;
+        std::vector<VkSemaphore> heap_vk_semaphores;
+        VkSemaphore* vk_semaphores = inline_vk_semaphores.data();
+
+        if (wait_semaphores.size() > n_inline_handles)
+        {
+            heap_vk_semaphores.resize(wait_semaphores.size());
+            vk_semaphores = heap_vk_semaphores.data();
+        }
+        for (size_t i = 0; i < wait_semaphores.size(); i++)
+        {
+            vk_semaphores[i] = wait_semaphores[i]->handle();
+        }
+
+        VkSwapchainKHR vk_swapchain = swapchain->handle();
+
+        VkPresentInfoKHR present_info{
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .pNext = nullptr,
+            .waitSemaphoreCount = (uint32_t)wait_semaphores.size(),
+            .pWaitSemaphores = vk_semaphores,
+            .swapchainCount = 1,
+            .pSwapchains = &vk_swapchain,
+            .pImageIndices = &image_index,
+            .pResults = nullptr
+        };
+
+        return dispatch().vkQueuePresentKHR(handle(), &present_info);
+    }
+
+    void Queue::wait_idle(const std::source_location& location)
+    {
+        StallTimer stall_timer("Queue::wait_idle", location, _stall_counter);
+
+        VkResult vk_result = dispatch().vkQueueWaitIdle(handle());
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error(
+                "failed to wait for queue to become idle",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    Queue::Queue(
+        const DevicePtr& device,
+        uint32_t queue_family_index,
+        uint32_t queue_index,
+        VkQueue handle
+    )
+        : _device(device),
+        _queue_family_index(queue_family_index),
+        _queue_index(queue_index),
+        _handle(handle),
+        _dispatch(device->dispatch_ptr())
+    {}
+
+    uint64_t submit_count()
+    {
+        return n_submits.load(std::memory_order_relaxed);
+    }
+
+    DevicePtr Device::create(
+        const ContextPtr& context,
+        const PhysicalDevice& physical_device,
+        const DeviceConfig& config
+    )
+    {
+        try
+        {
+            DevicePtr device = std::make_shared<Device_public_ctor>(
+                context,
+                physical_device,
+                config
+            );
+
+            std::vector<VkDeviceQueueCreateInfo> vk_queue_requests;
+            std::vector<std::vector<float>> wastes_priorities(
+                device->config().queue_requests.size()
+            );
+            for (size_t i = 0; i < device->config().queue_requests.size(); i++)
+            {
+                const auto& queue_request = device->config().queue_requests[i];
+
+                if (queue_request.priorities.size()
+                    != queue_request.num_queues_to_create)
+                {
+                    throw Error(
+                        "there should be the same number of queue priorities "
+                        "as the number of queues to create"
+                    );
+                }
+
+                vk_queue_requests.push_back(
+                    QueueRequest_to_vk(
+                        queue_request,
+                        wastes_priorities[i]
+                    )
+                );
+            }
+
+            std::vector<const char*> layers_cstr;
+            {
+                layers_cstr.reserve(
+                    context->config().layers.size()
+                );
+                for (const auto& layer
+                    : context->config().layers)
+                {
+                    layers_cstr.push_back(layer.c_str());
+                }
+            }
+
+            std::vector<const char*> extensions_cstr;
+            {
+                extensions_cstr.reserve(
+                    device->config().extensions.size()
+                );
+                for (const auto& ext : device->config().extensions)
+                {
+                    extensions_cstr.push_back(ext.c_str());
+                }
+            }
+
+            VkPhysicalDeviceFeatures vk_enabled_features =
+                PhysicalDeviceFeatures_to_vk(
+                    device->config().enabled_features
+                );
+
+            // the Vulkan 1.x structs can only be chained if both the
+            // instance and the device support the matching API version, same
+            // as when PhysicalDevice fetches them.
+            uint32_t api_version = std::min(
+                VulkanApiVersion_encode(context->config().vulkan_api_version),
+                physical_device.properties().api_version.encode()
+            );
+            if (device->config().enabled_vulkan11_features.has_value()
+                && api_version < VK_API_VERSION_1_1)
+            {
+                throw Error(
+                    "enabled_vulkan11_features needs Vulkan 1.1 on both the "
+                    "context and the physical device"
+                );
+            }
+            if (device->config().enabled_vulkan12_features.has_value()
+                && api_version < VK_API_VERSION_1_2)
+            {
+                throw Error(
+                    "enabled_vulkan12_features needs Vulkan 1.2 on both the "
+                    "context and the physical device"
+                );
+            }
+            if (device->config().enabled_vulkan13_features.has_value()
+                && api_version < VK_API_VERSION_1_3)
+            {
+                throw Error(
+                    "enabled_vulkan13_features needs Vulkan 1.3 on both the "
+                    "context and the physical device"
+                );
+            }
+
+            // optional feature structs are chained in front of each other
+            void* p_next = nullptr;
+
+            // the Vulkan 1.x structs can't be chained together with the
+            // individual structs of features they contain, so the dedicated
+            // flags below are merged into them instead if they're provided.
+            // VkPhysicalDeviceVulkan11Features itself only exists since
+            // Vulkan 1.2, so on 1.1 it's split into the promoted structs.
+            VkPhysicalDeviceVulkan11Features vk_vulkan11_features{};
+            Vulkan11FeatureStructs vk_vulkan11_feature_structs{};
+            if (device->config().enabled_vulkan11_features.has_value())
+            {
+                vk_vulkan11_features = PhysicalDeviceVulkan11Features_to_vk(
+                    device->config().enabled_vulkan11_features.value()
+                );
+                if (api_version >= VK_API_VERSION_1_2)
+                {
+                    vk_vulkan11_features.pNext = p_next;
+                    p_next = &vk_vulkan11_features;
+                }
+                else
+                {
+                    p_next = chain_vulkan11_features_on_1_1(
+                        vk_vulkan11_features,
+                        vk_vulkan11_feature_structs,
+                        p_next
+                    );
+                }
+            }
+
+            VkPhysicalDeviceVulkan12Features vk_vulkan12_features{};
+            if (device->config().enabled_vulkan12_features.has_value())
+            {
+                vk_vulkan12_features = PhysicalDeviceVulkan12Features_to_vk(
+                    device->config().enabled_vulkan12_features.value()
+                );
+                if (device->config().enable_timeline_semaphore)
+                {
+                    vk_vulkan12_features.timelineSemaphore = VK_TRUE;
+                }
+                if (device->config().enable_imageless_framebuffer)
+                {
+                    vk_vulkan12_features.imagelessFramebuffer = VK_TRUE;
+                }
+                vk_vulkan12_features.pNext = p_next;
+                p_next = &vk_vulkan12_features;
+            }
+
+            VkPhysicalDeviceVulkan13Features vk_vulkan13_features{};
+            if (device->config().enabled_vulkan13_features.has_value())
+            {
+                vk_vulkan13_features = PhysicalDeviceVulkan13Features_to_vk(
+                    device->config().enabled_vulkan13_features.value()
+                );
+                if (device->config().enable_synchronization2)
+                {
+                    vk_vulkan13_features.synchronization2 = VK_TRUE;
+                }
+                if (device->config().enable_dynamic_rendering)
+                {
+                    vk_vulkan13_features.dynamicRendering = VK_TRUE;
+                }
+                if (device->config().enable_shader_module_identifier)
+                {
+                    vk_vulkan13_features.pipelineCreationCacheControl =
+                        VK_TRUE;
+                }
+                vk_vulkan13_features.pNext = p_next;
+                p_next = &vk_vulkan13_features;
+            }
+
+            VkPhysicalDeviceSynchronization2Features vk_sync2_features{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+
+                .pNext = nullptr,
+                .synchronization2 = VK_TRUE
+            };
+            if (device->config().enable_synchronization2
+                && !device->config().enabled_vulkan13_features.has_value())
+            {
+                vk_sync2_features.pNext = p_next;
+                p_next = &vk_sync2_features;
+            }
+
+            VkPhysicalDeviceDynamicRenderingFeatures vk_dyn_rendering_features{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
+
+                .pNext = nullptr,
+                .dynamicRendering = VK_TRUE
+            };
+            if (device->config().enable_dynamic_rendering
+                && !device->config().enabled_vulkan13_features.has_value())
+            {
+                vk_dyn_rendering_features.pNext = p_next;
+                p_next = &vk_dyn_rendering_features;
+            }
+
+            VkPhysicalDeviceTimelineSemaphoreFeatures vk_timeline_features{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+
+                .pNext = nullptr,
+                .timelineSemaphore = VK_TRUE
+            };
+            if (device->config().enable_timeline_semaphore
+                && !device->config().enabled_vulkan12_features.has_value())
+            {
+                vk_timeline_features.pNext = p_next;
+                p_next = &vk_timeline_features;
+            }
+
+            VkPhysicalDeviceImagelessFramebufferFeatures vk_imageless_features{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGELESS_FRAMEBUFFER_FEATURES,
+
+                .pNext = nullptr,
+                .imagelessFramebuffer = VK_TRUE
+            };
+            if (device->config().enable_imageless_framebuffer
+                && !device->config().enabled_vulkan12_features.has_value())
+            {
+                vk_imageless_features.pNext = p_next;
+                p_next = &vk_imageless_features;
+            }
+
+            VkPhysicalDeviceExtendedDynamicStateFeaturesEXT vk_eds_features{
+                .sType =
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+
+                .pNext = nullptr,
+                .extendedDynamicState = VK_TRUE
+            };
+            if (device->config().enable_extended_dynamic_state)
+            {
+                vk_eds_features.pNext = p_next;
+                p_next = &vk_eds_features;
+            }
+
+            VkPhysicalDeviceExtendedDynamicState2FeaturesEXT
+                vk_eds2_features{};
+            if (device->config().enabled_extended_dynamic_state2_features
+                .has_value())
+            {
+                vk_eds2_features =
+                    PhysicalDeviceExtendedDynamicState2Features_to_vk(
+                        device->config()
+                        .enabled_extended_dynamic_state2_features.value()
+                    );
+                vk_eds2_features.pNext = p_next;
+                p_next = &vk_eds2_features;
+            }
+
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT
+                vk_eds3_features{};
+            if (device->config().enabled_extended_dynamic_state3_features
+                .has_value())
+            {
+                vk_eds3_features =
+                    PhysicalDeviceExtendedDynamicState3Features_to_vk(
+                        device->config()
+                        .enabled_extended_dynamic_state3_features.value()
+                    );
+                vk_eds3_features.pNext = p_next;
+                p_next = &vk_eds3_features;
+            }
+
+            VkPhysicalDeviceVertexInputDynamicStateFeaturesEXT
+                vk_vertex_input_features{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_INPUT_DYNAMIC_STATE_FEATURES_EXT,
+
+                    .pNext = nullptr,
+                    .vertexInputDynamicState = VK_TRUE
+                };
+            if (device->config().enable_vertex_input_dynamic_state)
+            {
+                vk_vertex_input_features.pNext = p_next;
+                p_next = &vk_vertex_input_features;
+            }
+
+            VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT
+                vk_module_identifier_features{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT,
+
+                    .pNext = nullptr,
+                    .shaderModuleIdentifier = VK_TRUE
+                };
+            if (device->config().enable_shader_module_identifier)
+            {
+                vk_module_identifier_features.pNext = p_next;
+                p_next = &vk_module_identifier_features;
+            }
+
+            VkPhysicalDevicePipelineCreationCacheControlFeatures
+                vk_cache_control_features{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES,
+
+                    .pNext = nullptr,
+                    .pipelineCreationCacheControl = VK_TRUE
+                };
+            if (device->config().enable_shader_module_identifier
+                && !device->config().enabled_vulkan13_features.has_value())
+            {
+                vk_cache_control_features.pNext = p_next;
+                p_next = &vk_cache_control_features;
+            }
+
+            VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT
+                vk_pipeline_library_features{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+
+                    .pNext = nullptr,
+                    .graphicsPipelineLibrary = VK_TRUE
+                };
+            if (device->config().enable_graphics_pipeline_library)
+            {
+                vk_pipeline_library_features.pNext = p_next;
+                p_next = &vk_pipeline_library_features;
+            }
+
+            VkDeviceCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .pNext = p_next,
+
+                .flags = 0,
+                .queueCreateInfoCount = (uint32_t)vk_queue_requests.size(),
+                .pQueueCreateInfos = vk_queue_requests.data(),
+                .enabledLayerCount = (uint32_t)layers_cstr.size(),
+                .ppEnabledLayerNames = layers_cstr.data(),
+                .enabledExtensionCount = (uint32_t)extensions_cstr.size(),
+                .ppEnabledExtensionNames = extensions_cstr.data(),
+                .pEnabledFeatures = &vk_enabled_features
+            };
+
+            VkDevice vk_device;
+            VkResult vk_result = physical_device.dispatch().vkCreateDevice(
+                device->physical_device().handle(),
+                &create_info,
+                context->vk_allocator_ptr(),
+                &vk_device
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            // ~Device() can't destroy the handle without the dispatch table,
+            // so only keep it once the table is loaded
+            std::shared_ptr<const DeviceDispatch> dispatch;
+            try
+            {
+                dispatch = load_device_dispatch(
+                    physical_device.dispatch(),
+                    vk_device
+                );
+            }
+            catch (...)
+            {
+                auto destroy_device = (PFN_vkDestroyDevice)
+                    physical_device.dispatch().vkGetDeviceProcAddr(
+                        vk_device,
+                        "vkDestroyDevice"
+                    );
+                if (destroy_device != nullptr)
+                {
+                    destroy_device(vk_device, context->vk_allocator_ptr());
+                }
+                throw;
+            }
+            device->_handle = vk_device;
+            device->_dispatch = dispatch;
+            return device;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create device: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    QueuePtr Device::retrieve_queue(
+        const DevicePtr& device,
+        uint32_t queue_family_index,
+        uint32_t queue_index
+    )
+    {
+        VkQueue vk_queue;
+        device->dispatch().vkGetDeviceQueue(
+            device->handle(),
+            queue_family_index,
+            queue_index,
+            &vk_queue
+        );
+        return std::make_shared<Queue_public_ctor>(
+            device,
+            queue_family_index,
+            queue_index,
+            vk_queue
+        );
+    }
+
+    void Device::wait_idle(const std::source_location& location)
+    {
+        StallTimer stall_timer("Device::wait_idle", location, _stall_counter);
+
+        VkResult vk_result = dispatch().vkDeviceWaitIdle(_handle);
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error(
+                "failed to wait for device to become idle",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    Device::~Device()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
+        if (_dispatch == nullptr)
+        {
+            return;
+        }
+        dispatch().vkDestroyDevice(
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Device::Device(
+        const ContextPtr& context,
+        const PhysicalDevice& physical_device,
+        const DeviceConfig& config
+    )
+        : _context(context),
+        _physical_device(physical_device),
+        _config(config)
+    {}
+
+    ImagePtr Image::create(
+        const DevicePtr& device,
+        const ImageConfig& config
+    )
+    {
+        try
+        {
+            ImageFormatProperties img_format_props{};
+            try
+            {
+                img_format_props =
+                    device->physical_device().fetch_image_format_properties(
+                        config.format,
+                        config.image_type,
+                        config.tiling,
+                        config.usage,
+                        config.flags
+                    );
+            }
+            catch (const Error& e)
+            {
+                if (e.vk_result().has_value()
+                    && e.vk_result().value() == VK_ERROR_FORMAT_NOT_SUPPORTED)
+                {
+                    throw Error(
+                        "image format not supported with the provided "
+                        "parameters",
+                        e.vk_result(),
+                        true
+                    );
+                }
+                else
+                {
+                    throw e;
+                }
+            }
+
+            ImagePtr img = std::make_shared<Image_public_ctor>(
+                device,
+                config
+            );
+
+            VkImageCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = img->config().flags,
+                .imageType = img->config().image_type,
+                .format = img->config().format,
+                .extent = Extent3d_to_vk(img->config().extent),
+                .mipLevels = img->config().mip_levels,
+                .arrayLayers = img->config().array_layers,
+                .samples = img->config().samples,
+                .tiling = img->config().tiling,
+                .usage = img->config().usage,
+                .sharingMode = img->config().sharing_mode,
+
+                .queueFamilyIndexCount =
+                (uint32_t)img->config().queue_family_indices.size(),
+
+                .pQueueFamilyIndices =
+                img->config().queue_family_indices.data(),
+
+                .initialLayout = img->config().initial_layout
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateImage(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &img->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            VkMemoryRequirements vk_mem_requirements;
+            device->dispatch().vkGetImageMemoryRequirements(
+                device->handle(),
+                img->handle(),
+                &vk_mem_requirements
+            );
+            img->_memory_requirements = MemoryRequirements_from_vk(
+                vk_mem_requirements
+            );
+
+            return img;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create image: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Image::bind_memory(
+        const DeviceMemoryPtr& memory,
+        VkDeviceSize memory_offset
+    )
+    {
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = device_locked->dispatch().vkBindImageMemory(
+                device_locked->handle(),
+                handle(),
+                memory->handle(),
+                memory_offset
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to bind image memory: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Image::~Image()
+    {
+        if (created_externally())
+        {
+            return;
+        }
+
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyImage(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Image::Image(const DevicePtr& device, const ImageConfig& config)
+        : _created_externally(false),
+        _device(device),
+        _config(config),
+        _memory_requirements({}),
+        _handle(nullptr)
+    {}
+
+    Image::Image(VkImage handle_created_externally, const ImageConfig& config)
+        : _created_externally(true),
+        _device({}),
+        _config(config),
+        _memory_requirements({}),
+        _handle(handle_created_externally)
+    {}
+
+    SwapchainPtr Swapchain::create(
+        const DevicePtr& device,
+        const SurfacePtr& surface,
+        const SwapchainConfig& config,
+        const SwapchainPtr& old_swapchain
+    )
+    {
+        try
+        {
+            SwapchainPtr sc = std::make_shared<Swapchain_public_ctor>(
+                device,
+                surface,
+                config,
+                old_swapchain
+            );
+
+            VkSwapchainKHR vk_old_swapchain = nullptr;
+            if (old_swapchain != nullptr)
+            {
+                vk_old_swapchain = old_swapchain->handle();
+            }
+
+            VkSwapchainCreateInfoKHR create_info{
+                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                .pNext = nullptr,
+                .flags = sc->config().flags,
+                .surface = surface->handle(),
+                .minImageCount = sc->config().min_image_count,
+                .imageFormat = sc->config().image_format,
+                .imageColorSpace = sc->config().image_color_space,
+                .imageExtent = Extent2d_to_vk(sc->config().image_extent),
+                .imageArrayLayers = sc->config().image_array_layers,
+                .imageUsage = sc->config().image_usage,
+                .imageSharingMode = sc->config().image_sharing_mode,
+
+                .queueFamilyIndexCount =
+                (uint32_t)sc->config().queue_family_indices.size(),
+
+                .pQueueFamilyIndices = sc->config().queue_family_indices.data(),
+                .preTransform = sc->config().pre_transform,
+                .compositeAlpha = sc->config().composite_alpha,
+                .presentMode = sc->config().present_mode,
+                .clipped = sc->config().clipped,
+                .oldSwapchain = vk_old_swapchain
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateSwapchainKHR(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &sc->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            uint32_t actual_image_count;
+            device->dispatch().vkGetSwapchainImagesKHR(
+                device->handle(),
+                sc->handle(),
+                &actual_image_count,
+                nullptr
+            );
+
+            std::vector<VkImage> vk_images(actual_image_count);
+            vk_result = device->dispatch().vkGetSwapchainImagesKHR(
+                device->handle(),
+                sc->handle(),
+                &actual_image_count,
+                vk_images.data()
+            );
+            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            {
+                throw Error(
+                    "failed to retrieve swapchain images after creating it",
+                    vk_result,
+                    false
+                );
+            }
+
+            ImageConfig image_config{
+                .flags = 0,
+                .image_type = VK_IMAGE_TYPE_2D,
+                .format = config.image_format,
+                .extent = Extent3d{
+                    .width = config.image_extent.width,
+                    .height = config.image_extent.height,
+                    .depth = 1
+                },
+                .mip_levels = 1,
+                .array_layers = config.image_array_layers,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = config.image_usage,
+                .sharing_mode = config.image_sharing_mode,
+                .queue_family_indices = config.queue_family_indices,
+                .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED
+            };
+
+            sc->_images.reserve(actual_image_count);
+            for (auto vk_image : vk_images)
+            {
+                sc->_images.push_back(
+                    std::make_shared<Image_public_ctor>(vk_image, image_config)
+                );
+            }
+
+            return sc;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create swapchain: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    uint32_t Swapchain::acquire_next_image(
+        const SemaphorePtr& semaphore,
+        const FencePtr& fence,
+        uint64_t timeout,
+        VkResult* out_vk_result,
+        const std::source_location& location
+    )
+    {
+        uint32_t image_index;
+        VkResult vk_result = try_acquire_next_image(
+            image_index,
+            semaphore,
+            fence,
+            timeout,
+            location
+        );
+        if (out_vk_result != nullptr)
+        {
+            *out_vk_result = vk_result;
+        }
+        if (vk_result == VK_SUCCESS || vk_result == VK_SUBOPTIMAL_KHR)
+        {
+            return image_index;
+        }
+        throw Error(
+            "failed to acquire next swapchain image",
+            vk_result,
+            false
+        );
+    }
+
+    VkResult Swapchain::try_acquire_next_image(
+        uint32_t& out_image_index,
+        const SemaphorePtr& semaphore,
+        const FencePtr& fence,
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        BV_TRACE_ZONE("bv::Swapchain::acquire_next_image");
+        StallTimer stall_timer(
+            "Swapchain::acquire_next_image",
+            location,
+            _stall_counter
+        );
+
+        // a destroyed device is a bug in the caller, not a result to handle
+        auto device_locked = device().lock();
+        if (device_locked == nullptr)
+        {
+            throw Error(
+                "failed to acquire next swapchain image: device has been "
+                "destroyed"
+            );
+        }
+
+        return device_locked->dispatch().vkAcquireNextImageKHR(
+            device_locked->handle(),
+            handle(),
+            timeout,
+            semaphore == nullptr ? nullptr : semaphore->handle(),
+            fence == nullptr ? nullptr : fence->handle(),
+            &out_image_index
+        );
+    }
+
+    Swapchain::~Swapchain()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroySwapchainKHR(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Swapchain::Swapchain(
+        const DevicePtr& device,
+        const SurfacePtr& surface,
+        const SwapchainConfig& config,
+        const SwapchainPtr& old_swapchain
+    )
+        : _device(device),
+        _surface(surface),
+        _config(config),
+        _old_swapchain(std::nullopt)
+    {
+        if (old_swapchain != nullptr)
+        {
+            _old_swapchain = old_swapchain;
+        }
+    }
+
+    ImageViewPtr ImageView::create(
+        const DevicePtr& device,
+        const ImagePtr& image,
+        const ImageViewConfig& config
+    )
+    {
+        try
+        {
+            ImageViewPtr view = std::make_shared<ImageView_public_ctor>(
+                device,
+                image,
+                config
+            );
+
+            VkImageViewCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = view->config().flags,
+                .image = lock_wptr(view->image())->handle(),
+                .viewType = view->config().view_type,
+                .format = view->config().format,
+                .components = ComponentMapping_to_vk(view->config().components),
+                .subresourceRange = ImageSubresourceRange_to_vk(
+                    view->config().subresource_range
+                )
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateImageView(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &view->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return view;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create image view: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    ImageView::~ImageView()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyImageView(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    ImageView::ImageView(
+        const DevicePtr& device,
+        const ImagePtr& image,
+        const ImageViewConfig& config
+    )
+        : _device(device),
+        _image(image),
+        _config(config)
+    {}
+
+    // a read-only mapping of a whole file. data() is empty if the file
+    // couldn't be opened or mapped.
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string& path)
+        {
+#ifdef _WIN32
+            file = CreateFileA(
+                path.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr
+            );
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                return;
+            }
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+            {
+                return;
+            }
+            mapping = CreateFileMappingA(
+                file,
+                nullptr,
+                PAGE_READONLY,
+                0,
+                0,
+                nullptr
+            );
+            if (mapping == nullptr)
+            {
+                return;
+            }
+            void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (ptr == nullptr)
+            {
+                return;
+            }
+            _data = std::span<const uint8_t>(
+                (const uint8_t*)ptr,
+                (size_t)file_size.QuadPart
+            );
+#else
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                return;
+            }
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+            {
+                return;
+            }
+            void* ptr = mmap(
+                nullptr,
+                (size_t)file_stat.st_size,
+                PROT_READ,
+                MAP_PRIVATE,
+                fd,
+                0
+            );
+            if (ptr == MAP_FAILED)
+            {
+                return;
+            }
+            _data = std::span<const uint8_t>(
+                (const uint8_t*)ptr,
+                (size_t)file_stat.st_size
+            );
+#endif
+        }
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        constexpr std::span<const uint8_t> data() const
+        {
+            return _data;
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+            if (!_data.empty())
+            {
+                UnmapViewOfFile(_data.data());
+            }
+            if (mapping != nullptr)
+            {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file);
+            }
+#else
+            if (!_data.empty())
+            {
+                munmap((void*)_data.data(), _data.size());
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+#endif
+        }
+
+    private:
+        std::span<const uint8_t> _data;
+
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+
+    };
+
+    // write to a temporary file and rename it so that a crash never leaves
+    // a partially written file behind. the temporary file is named after the
+    // calling process and thread so that processes and threads writing the
+    // same file don't interfere.
+    static void write_file_atomically(
+        const std::string& path,
+        std::span<const uint8_t> data
+    )
+    {
+#ifdef _WIN32
+        uint64_t pid = GetCurrentProcessId();
+#else
+        uint64_t pid = (uint64_t)getpid();
+#endif
+        std::string tmp_path = std::format(
+            "{}.{}.{:x}.tmp",
+            path,
+            pid,
+            std::hash<std::thread::id>{}(std::this_thread::get_id())
+        );
+        // the data has to reach the disk before the rename does, otherwise a
+        // crash can leave an empty or truncated file under the final name
+        bool ok = true;
+        size_t offset = 0;
+#ifdef _WIN32
+        HANDLE file = CreateFileA(
+            tmp_path.c_str(),
+            GENERIC_WRITE,
+            0,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw Error(std::format("failed to create \"{}\"", tmp_path));
+        }
+        while (ok && offset < data.size())
+        {
+            DWORD n_to_write = (DWORD)std::min<size_t>(
+                data.size() - offset,
+                1 << 30
+            );
+            DWORD n_written = 0;
+            ok = WriteFile(
+                file,
+                data.data() + offset,
+                n_to_write,
+                &n_written,
+                nullptr
+            ) && n_written > 0;
+            offset += n_written;
+        }
+        ok = ok && FlushFileBuffers(file);
+        ok = CloseHandle(file) && ok;
+#else
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            throw Error(std::format("failed to create \"{}\"", tmp_path));
+        }
+        while (ok && offset < data.size())
+        {
+            ssize_t n_written = write(
+                fd,
+                data.data() + offset,
+                data.size() - offset
+            );
+            if (n_written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            ok = n_written > 0;
+            if (ok)
+            {
+                offset += (size_t)n_written;
+            }
+        }
+        ok = ok && fsync(fd) == 0;
+        ok = close(fd) == 0 && ok;
+#endif
+        if (!ok)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(tmp_path, ignored);
+            throw Error(std::format("failed to write to \"{}\"", tmp_path));
+        }
+
+        std::error_code error_code;
+        std::filesystem::rename(tmp_path, path, error_code);
+        if (error_code)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(tmp_path, ignored);
+            throw Error(std::format(
+                "failed to rename \"{}\" to \"{}\": {}",
+                tmp_path,
+                path,
+                error_code.message()
+            ));
+        }
+    }
+
+    static constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+    static constexpr uint64_t FNV1A_PRIME = 1099511628211ull;
+
+    static uint64_t fnv1a_hash(
+        std::span<const uint8_t> data,
+        uint64_t hash = FNV1A_OFFSET_BASIS
+    )
+    {
+        for (uint8_t byte : data)
+        {
+            hash ^= byte;
+            hash *= FNV1A_PRIME;
+        }
+        return hash;
+    }
+
+    static VkResult create_vk_shader_module(
+        const DevicePtr& device,
+        std::span<const uint8_t> code,
+        VkShaderModule& vk_module
+    )
+    {
+        std::vector<uint8_t> code_aligned;
+        bool needs_alignment = (code.size() % 8 != 0);
+        if (needs_alignment)
+        {
+            code_aligned.assign(code.begin(), code.end());
+            for (size_t i = 0; i < 8 - (code.size() % 8); i++)
+            {
+                code_aligned.push_back(0);
+            }
+        }
+
+        VkShaderModuleCreateInfo create_info{
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .codeSize = code.size(),
+            .pCode = reinterpret_cast<const uint32_t*>(
+                needs_alignment ? code_aligned.data() : code.data()
+                )
+        };
+
+        return device->dispatch().vkCreateShaderModule(
+            device->handle(),
+            &create_info,
+            lock_wptr(device->context())->vk_allocator_ptr(),
+            &vk_module
+        );
+    }
+
+    static bool shader_module_identifier_enabled(const DevicePtr& device)
+    {
+        return device->config().enable_shader_module_identifier
+            && device->dispatch().vkGetShaderModuleIdentifierEXT != nullptr;
+    }
+
+    ShaderModulePtr ShaderModule::create(
+        const DevicePtr& device,
+        std::span<const uint8_t> code
+    )
+    {
+        try
+        {
+            ShaderModulePtr module = std::make_shared<ShaderModule_public_ctor>(
+                device
+            );
+
+            VkShaderModule vk_module = nullptr;
+            VkResult vk_result = create_vk_shader_module(
+                device,
+                code,
+                vk_module
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            module->_handle->store(vk_module);
+            module->_code_hash = fnv1a_hash(code);
+
+            if (shader_module_identifier_enabled(device))
+            {
+                VkShaderModuleIdentifierEXT vk_identifier{
+                    .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT,
+                    .pNext = nullptr
+                };
+                device->dispatch().vkGetShaderModuleIdentifierEXT(
+                    device->handle(),
+                    vk_module,
+                    &vk_identifier
+                );
+                module->_identifier.assign(
+                    vk_identifier.identifier,
+                    vk_identifier.identifier + vk_identifier.identifierSize
+                );
+            }
+            return module;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create shader module: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    ShaderModulePtr ShaderModule::create_from_identifier(
+        const DevicePtr& device,
+        uint64_t code_hash,
+        const std::vector<uint8_t>& identifier,
+        const std::function<std::vector<uint8_t>()>& load_code
+    )
+    {
+        ShaderModulePtr module = std::make_shared<ShaderModule_public_ctor>(
+            device
+        );
+        module->_code_hash = code_hash;
+        module->_identifier = identifier;
+        module->load_code = load_code;
+        return module;
+    }
+
+#ifdef BV_ENABLE_SHADERC
+    ShaderModulePtr ShaderModule::create_from_glsl(
+        const DevicePtr& device,
+        const GlslCompilerPtr& compiler,
+        const GlslSource& source
+    )
+    {
+        return create(device, compiler->compile(source));
+    }
+#endif
+
+    VkShaderModule ShaderModule::handle() const
+    {
+        // moved from
+        if (_handle == nullptr)
+        {
+            return nullptr;
+        }
+        return _handle->load(std::memory_order_acquire);
+    }
+
+    void ShaderModule::ensure_handle()
+    {
+        BV_TRACE_ZONE("bv::ShaderModule::ensure_handle");
+
+        if (handle() != nullptr)
+        {
+            return;
+        }
+
+        try
+        {
+            if (handle_mutex == nullptr)
+            {
+                throw Error("the module was moved from");
+            }
+
+            std::scoped_lock lock(*handle_mutex);
+            if (handle() != nullptr)
+            {
+                return;
+            }
+
+            // the code might have changed since the identifier was saved
+            std::vector<uint8_t> code = load_code();
+            if (fnv1a_hash(code) != code_hash())
+            {
+                throw Error("code doesn't match the module's code hash");
+            }
+
+            VkShaderModule vk_module = nullptr;
+            VkResult vk_result = create_vk_shader_module(
+                lock_wptr(device()),
+                code,
+                vk_module
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            _handle->store(vk_module, std::memory_order_release);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create shader module handle: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    ShaderModule::~ShaderModule()
+    {
+        // moved from
+        if (_handle == nullptr)
+        {
+            return;
+        }
+
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyShaderModule(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    ShaderModule::ShaderModule(const DevicePtr& device)
+        : _device(device),
+        _handle(std::make_shared<std::atomic<VkShaderModule>>(nullptr)),
+        handle_mutex(std::make_shared<std::mutex>())
+    {}
+
+    // the identifier cache starts with this header followed by n_entries
+    // entries of a code hash (uint64_t), an identifier size (uint32_t), and
+    // the identifier. identifiers are only useful for pipelines that are in
+    // the pipeline cache, so the file is matched against the device the same
+    // way as pipeline cache data.
+    struct ShaderModuleIdentifierCacheHeader
+    {
+        uint32_t magic;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+        uint32_t n_entries;
+    };
+
+    static constexpr uint32_t SHADER_MODULE_IDENTIFIER_CACHE_MAGIC =
+        0x49534256; // "BVSI"
+
+    ShaderModuleRegistryPtr ShaderModuleRegistry::create(
+        const DevicePtr& device,
+        const std::string& identifier_cache_path
+    )
+    {
+        BV_TRACE_ZONE("bv::ShaderModuleRegistry::create");
+
+        ShaderModuleRegistryPtr registry =
+            std::make_shared<ShaderModuleRegistry_public_ctor>(
+                device,
+                identifier_cache_path
+            );
+        if (identifier_cache_path.empty()
+            || !shader_module_identifier_enabled(device))
+        {
+            return registry;
+        }
+
+        MappedFile file(identifier_cache_path);
+        std::span<const uint8_t> data = file.data();
+
+        ShaderModuleIdentifierCacheHeader header;
+        if (data.size() < sizeof(header))
+        {
+            return registry;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        const auto& properties = device->physical_device().properties();
+        if (header.magic != SHADER_MODULE_IDENTIFIER_CACHE_MAGIC
+            || header.vendor_id != properties.vendor_id
+            || header.device_id != properties.device_id
+            || std::memcmp(
+                header.pipeline_cache_uuid,
+                properties.pipeline_cache_uuid.data(),
+                VK_UUID_SIZE
+            ) != 0)
+        {
+            return registry;
+        }
+
+        // entries are read until the first one that's cut off
+        size_t offset = sizeof(header);
+        for (uint32_t i = 0; i < header.n_entries; i++)
+        {
+            uint64_t code_hash;
+            uint32_t identifier_size;
+            if (data.size() - offset < sizeof(code_hash) + sizeof(uint32_t))
+            {
+                break;
+            }
+            std::memcpy(&code_hash, data.data() + offset, sizeof(code_hash));
+            offset += sizeof(code_hash);
+            std::memcpy(
+                &identifier_size,
+                data.data() + offset,
+                sizeof(identifier_size)
+            );
+            offset += sizeof(identifier_size);
+            if (data.size() - offset < identifier_size)
+            {
+                break;
+            }
+            registry->identifiers[code_hash] = std::vector<uint8_t>(
+                data.data() + offset,
+                data.data() + offset + identifier_size
+            );
+            offset += identifier_size;
+        }
+        return registry;
+    }
+
+    ShaderModulePtr ShaderModuleRegistry::get(const std::string& path)
+    {
+        BV_TRACE_ZONE("bv::ShaderModuleRegistry::get");
+
+        try
+        {
+            MappedFile file(path);
+            if (file.data().empty())
+            {
+                throw Error(std::format("failed to map \"{}\"", path));
+            }
+            return get(
+                fnv1a_hash(file.data()),
+                file.data(),
+                [path]()
+                {
+                    MappedFile reloaded_file(path);
+                    return std::vector<uint8_t>(
+                        reloaded_file.data().begin(),
+                        reloaded_file.data().end()
+                    );
+                }
+            );
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                std::format(
+                    "failed to get registered shader module \"{}\": {}",
+                    path,
+                    e.to_string()
+                ),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    ShaderModulePtr ShaderModuleRegistry::get(std::span<const uint8_t> code)
+    {
+        BV_TRACE_ZONE("bv::ShaderModuleRegistry::get");
+
+        try
+        {
+            // the code is only copied if the module is created from an
+            // identifier
+            uint64_t code_hash = fnv1a_hash(code);
+            std::function<std::vector<uint8_t>()> load_code = nullptr;
+            {
+                std::scoped_lock lock(*mutex);
+                if (identifiers.contains(code_hash))
+                {
+                    load_code = [code_copy = std::vector<uint8_t>(
+                        code.begin(),
+                        code.end()
+                    )]()
+                    {
+                        return code_copy;
+                    };
+                }
+            }
+            return get(code_hash, code, load_code);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to get registered shader module: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void ShaderModuleRegistry::save_identifiers()
+    {
+        BV_TRACE_ZONE("bv::ShaderModuleRegistry::save_identifiers");
+
+        if (identifier_cache_path.empty())
+        {
+            return;
+        }
+
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            const auto& properties =
+                device_locked->physical_device().properties();
+
+            std::vector<uint8_t> data(
+                sizeof(ShaderModuleIdentifierCacheHeader)
+            );
+            {
+                std::scoped_lock lock(*mutex);
+
+                ShaderModuleIdentifierCacheHeader header{
+                    .magic = SHADER_MODULE_IDENTIFIER_CACHE_MAGIC,
+                    .vendor_id = properties.vendor_id,
+                    .device_id = properties.device_id,
+                    .n_entries = (uint32_t)identifiers.size()
+                };
+                std::memcpy(
+                    header.pipeline_cache_uuid,
+                    properties.pipeline_cache_uuid.data(),
+                    VK_UUID_SIZE
+                );
+                std::memcpy(data.data(), &header, sizeof(header));
+
+                for (const auto& [code_hash, identifier] : identifiers)
+                {
+                    uint32_t identifier_size = (uint32_t)identifier.size();
+                    data.insert(
+                        data.end(),
+                        (const uint8_t*)&code_hash,
+                        (const uint8_t*)&code_hash + sizeof(code_hash)
+                    );
+                    data.insert(
+                        data.end(),
+                        (const uint8_t*)&identifier_size,
+                        (const uint8_t*)&identifier_size
+                        + sizeof(identifier_size)
+                    );
+                    data.insert(
+                        data.end(),
+                        identifier.begin(),
+                        identifier.end()
+                    );
+                }
+            }
+            write_file_atomically(identifier_cache_path, data);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to save shader module identifiers: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void ShaderModuleRegistry::prune()
+    {
+        std::scoped_lock lock(*mutex);
+        std::erase_if(
+            modules,
+            [](const auto& entry)
+            {
+                return entry.second.use_count() == 1;
+            }
+        );
+    }
+
+    void ShaderModuleRegistry::clear()
+    {
+        std::scoped_lock lock(*mutex);
+        modules.clear();
+    }
+
+    uint64_t ShaderModuleRegistry::n_reused() const
+    {
+        std::scoped_lock lock(*mutex);
+        return _n_reused;
+    }
+
+    uint64_t ShaderModuleRegistry::n_identifier_hits() const
+    {
+        std::scoped_lock lock(*mutex);
+        return _n_identifier_hits;
+    }
+
+    size_t ShaderModuleRegistry::size() const
+    {
+        std::scoped_lock lock(*mutex);
+        return modules.size();
+    }
+
+    ShaderModuleRegistry::ShaderModuleRegistry(
+        const DevicePtr& device,
+        const std::string& identifier_cache_path
+    )
+        : _device(device),
+        identifier_cache_path(identifier_cache_path),
+        mutex(std::make_shared<std::mutex>())
+    {}
+
+    ShaderModulePtr ShaderModuleRegistry::get(
+        uint64_t code_hash,
+        std::span<const uint8_t> code,
+        const std::function<std::vector<uint8_t>()>& load_code
+    )
+    {
+        auto device_locked = lock_wptr(device());
+
+        std::vector<uint8_t> identifier;
+        {
+            std::scoped_lock lock(*mutex);
+            auto it = modules.find(code_hash);
+            if (it != modules.end())
+            {
+                _n_reused++;
+                return it->second;
+            }
+
+            auto identifier_it = identifiers.find(code_hash);
+            if (identifier_it != identifiers.end() && load_code != nullptr)
+            {
+                identifier = identifier_it->second;
+            }
+        }
+
+        // the lock isn't held while creating the module. if another thread
+        // registered the same module in the meantime, theirs is kept.
+        ShaderModulePtr module = nullptr;
+        if (!identifier.empty())
+        {
+            module = ShaderModule::create_from_identifier(
+                device_locked,
+                code_hash,
+                identifier,
+                load_code
+            );
+        }
+        else
+        {
+            module = ShaderModule::create(device_locked, code);
+        }
+
+        std::scoped_lock lock(*mutex);
+        auto& entry = modules[code_hash];
+        if (entry != nullptr)
+        {
+            return entry;
+        }
+        entry = module;
+        if (!identifier.empty())
+        {
+            _n_identifier_hits++;
+        }
+        else if (!module->identifier().empty())
+        {
+            identifiers[code_hash] = module->identifier();
+        }
+        return module;
+    }
+
+#ifdef BV_ENABLE_SHADERC
+    // bump this if the way GlslCompiler uses shaderc changes in a way that
+    // affects the output, so that old cache entries are ignored
+    static constexpr uint32_t GLSL_COMPILER_CACHE_VERSION = 1;
+
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    static shaderc_shader_kind VkShaderStageFlagBits_to_shaderc_kind(
+        VkShaderStageFlagBits stage
+    )
+    {
+        switch (stage)
+        {
+        case VK_SHADER_STAGE_VERTEX_BIT:
+            return shaderc_vertex_shader;
+        case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+            return shaderc_tess_control_shader;
+        case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+            return shaderc_tess_evaluation_shader;
+        case VK_SHADER_STAGE_GEOMETRY_BIT:
+            return shaderc_geometry_shader;
+        case VK_SHADER_STAGE_FRAGMENT_BIT:
+            return shaderc_fragment_shader;
+        case VK_SHADER_STAGE_COMPUTE_BIT:
+            return shaderc_compute_shader;
+        case 0:
+            return shaderc_glsl_infer_from_source;
+        default:
+            throw Error(std::format(
+                "unsupported shader stage {}",
+                string_VkShaderStageFlagBits(stage)
+            ));
+        }
+    }
+
+    // like a C preprocessor, resolves #include "..." relative to the
+    // directory of the including file and then in the include directories,
+    // and #include <...> only in the include directories
+    class GlslIncluder : public shaderc::CompileOptions::IncluderInterface
+    {
+    public:
+        GlslIncluder(const std::vector<std::string>& include_dirs)
+            : include_dirs(include_dirs)
+        {}
+
+        shaderc_include_result* GetInclude(
+            const char* requested_source,
+            shaderc_include_type type,
+            const char* requesting_source,
+            size_t include_depth
+        ) override
+        {
+            auto include = new Include;
+
+            std::vector<std::filesystem::path> candidates;
+            if (type == shaderc_include_type_relative)
+            {
+                candidates.push_back(
+                    std::filesystem::path(requesting_source).parent_path()
+                    / requested_source
+                );
+            }
+            for (const auto& dir : include_dirs)
+            {
+                candidates.push_back(
+                    std::filesystem::path(dir) / requested_source
+                );
+            }
+
+            for (const auto& path : candidates)
+            {
+                std::ifstream file(path, std::ios::binary);
+                if (file.is_open())
+                {
+                    include->name = path.string();
+                    include->content.assign(
+                        std::istreambuf_iterator<char>(file),
+                        std::istreambuf_iterator<char>()
+                    );
+                    break;
+                }
+            }
+
+            // an empty name tells shaderc that the include failed and that
+            // the content is the error message
+            if (include->name.empty())
+            {
+                include->content = std::format(
+                    "failed to find \"{}\"",
+                    requested_source
+                );
+                if (type == shaderc_include_type_standard
+                    && include_dirs.empty())
+                {
+                    include->content +=
+                        ", #include <...> is only resolved in "
+                        "GlslSource::include_dirs";
+                }
+            }
+
+            include->result = shaderc_include_result{
+                .source_name = include->name.c_str(),
+                .source_name_length = include->name.size(),
+                .content = include->content.c_str(),
+                .content_length = include->content.size(),
+                .user_data = include
+            };
+            return &include->result;
+        }
+
+        void ReleaseInclude(shaderc_include_result* data) override
+        {
+            delete (Include*)data->user_data;
+        }
+
+    private:
+        struct Include
+        {
+            std::string name;
+            std::string content;
+            shaderc_include_result result;
+        };
+
+        std::vector<std::string> include_dirs;
+
+    };
+
+    static uint64_t glsl_cache_key(
+        const GlslSource& source,
+        std::string_view preprocessed_source,
+        uint32_t target_vulkan_version
+    )
+    {
+        unsigned int spirv_version = 0;
+        unsigned int spirv_revision = 0;
+        shaderc_get_spv_version(&spirv_version, &spirv_revision);
+
+        const uint32_t options[]{
+            GLSL_COMPILER_CACHE_VERSION,
+            (uint32_t)spirv_version,
+            (uint32_t)spirv_revision,
+            target_vulkan_version,
+            (uint32_t)source.stage,
+            (uint32_t)source.optimize,
+            (uint32_t)source.generate_debug_info
+        };
+        uint64_t hash = fnv1a_hash(std::span<const uint8_t>(
+            (const uint8_t*)options,
+            sizeof(options)
+        ));
+
+        // the null terminators separate the strings. the path matters
+        // because it ends up in the debug info and in #line directives.
+        for (const std::string* str : { &source.entry_point, &source.path })
+        {
+            hash = fnv1a_hash(
+                std::span<const uint8_t>(
+                    (const uint8_t*)str->c_str(),
+                    str->size() + 1
+                ),
+                hash
+            );
+        }
+        return fnv1a_hash(
+            std::span<const uint8_t>(
+                (const uint8_t*)preprocessed_source.data(),
+                preprocessed_source.size()
+            ),
+            hash
+        );
+    }
+
+    static bool is_spirv(std::span<const uint8_t> code)
+    {
+        // the header alone is 5 words
+        if (code.size() < 5 * sizeof(uint32_t)
+            || code.size() % sizeof(uint32_t) != 0)
+        {
+            return false;
+        }
+        uint32_t magic;
+        std::memcpy(&magic, code.data(), sizeof(magic));
+        return magic == SPIRV_MAGIC;
+    }
+
+    GlslCompilerPtr GlslCompiler::create(
+        const std::string& cache_dir,
+        uint32_t target_vulkan_version
+    )
+    {
+        if (!cache_dir.empty())
+        {
+            std::error_code error_code;
+            std::filesystem::create_directories(cache_dir, error_code);
+            if (error_code)
+            {
+                throw Error(std::format(
+                    "failed to create GLSL compiler cache directory \"{}\": "
+                    "{}",
+                    cache_dir,
+                    error_code.message()
+                ));
+            }
+        }
+        return std::make_shared<GlslCompiler_public_ctor>(
+            cache_dir,
+            target_vulkan_version
+        );
+    }
+
+    std::vector<uint8_t> GlslCompiler::compile(const GlslSource& source)
+    {
+        BV_TRACE_ZONE("bv::GlslCompiler::compile");
+
+        try
+        {
+            MappedFile file(source.path);
+            if (file.data().empty())
+            {
+                throw Error(std::format("failed to map \"{}\"", source.path));
+            }
+            const char* text = (const char*)file.data().data();
+            size_t text_size = file.data().size();
+
+            shaderc_shader_kind kind =
+                VkShaderStageFlagBits_to_shaderc_kind(source.stage);
+
+            shaderc::CompileOptions options;
+            for (const auto& [name, value] : source.defines)
+            {
+                options.AddMacroDefinition(name, value);
+            }
+            options.SetTargetEnvironment(
+                shaderc_target_env_vulkan,
+                _target_vulkan_version
+            );
+            options.SetOptimizationLevel(
+                source.optimize
+                ? shaderc_optimization_level_performance
+                : shaderc_optimization_level_zero
+            );
+            if (source.generate_debug_info)
+            {
+                options.SetGenerateDebugInfo();
+            }
+            options.SetIncluder(
+                std::make_unique<GlslIncluder>(source.include_dirs)
+            );
+
+            shaderc::Compiler compiler;
+
+            std::string cache_path;
+            if (!_cache_dir.empty())
+            {
+                shaderc::PreprocessedSourceCompilationResult preprocessed =
+                    compiler.PreprocessGlsl(
+                        text,
+                        text_size,
+                        kind,
+                        source.path.c_str(),
+                        options
+                    );
+                if (preprocessed.GetCompilationStatus()
+                    != shaderc_compilation_status_success)
+                {
+                    throw Error(preprocessed.GetErrorMessage());
+                }
+
+                uint64_t key = glsl_cache_key(
+                    source,
+                    std::string_view(
+                        preprocessed.cbegin(),
+                        preprocessed.cend() - preprocessed.cbegin()
+                    ),
+                    _target_vulkan_version
+                );
+                cache_path = (
+                    std::filesystem::path(_cache_dir)
+                    / std::format("{:016x}.spv", key)
+                ).string();
+
+                MappedFile cached_file(cache_path);
+                if (is_spirv(cached_file.data()))
+                {
+                    std::scoped_lock lock(*stats_mutex);
+                    _n_cache_hits++;
+                    return std::vector<uint8_t>(
+                        cached_file.data().begin(),
+                        cached_file.data().end()
+                    );
+                }
+            }
+
+            // the original source is compiled rather than the preprocessed
+            // one so that the compiler's messages point at the right files
+            shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
+                text,
+                text_size,
+                kind,
+                source.path.c_str(),
+                source.entry_point.c_str(),
+                options
+            );
+            if (result.GetCompilationStatus()
+                != shaderc_compilation_status_success)
+            {
+                throw Error(result.GetErrorMessage());
+            }
+
+            std::vector<uint8_t> code(
+                (const uint8_t*)result.cbegin(),
+                (const uint8_t*)result.cend()
+            );
+            // the cache is only an optimization, so the code is returned
+            // even if it can't be stored
+            if (!cache_path.empty())
+            {
+                try
+                {
+                    write_file_atomically(cache_path, code);
+                }
+                catch (const Error&)
+                {}
+            }
+
+            std::scoped_lock lock(*stats_mutex);
+            _n_compiled++;
+            return code;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                std::format(
+                    "failed to compile \"{}\": {}",
+                    source.path,
+                    e.to_string()
+                ),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> GlslCompiler::compile_multiple(
+        const std::vector<GlslSource>& sources,
+        uint32_t n_threads
+    )
+    {
+        BV_TRACE_ZONE("bv::GlslCompiler::compile_multiple");
+
+        if (n_threads == 0)
+        {
+            n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        n_threads = (uint32_t)std::min((size_t)n_threads, sources.size());
+
+        std::vector<std::vector<uint8_t>> codes(sources.size());
+        std::atomic_size_t next_idx = 0;
+
+        std::mutex error_mutex;
+        std::exception_ptr first_error = nullptr;
+
+        std::vector<std::thread> threads;
+        threads.reserve(n_threads);
+        for (uint32_t i = 0; i < n_threads; i++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    while (true)
+                    {
+                        size_t idx = next_idx++;
+                        if (idx >= sources.size())
+                        {
+                            return;
+                        }
+
+                        try
+                        {
+                            codes[idx] = compile(sources[idx]);
+                        }
+                        catch (...)
+                        {
+                            std::scoped_lock lock(error_mutex);
+                            if (first_error == nullptr)
+                            {
+                                first_error = std::current_exception();
+                            }
+                        }
+                    }
+                }
+            );
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        if (first_error != nullptr)
+        {
+            std::rethrow_exception(first_error);
+        }
+        return codes;
+    }
+
+    uint64_t GlslCompiler::n_cache_hits() const
+    {
+        std::scoped_lock lock(*stats_mutex);
+        return _n_cache_hits;
+    }
+
+    uint64_t GlslCompiler::n_compiled() const
+    {
+        std::scoped_lock lock(*stats_mutex);
+        return _n_compiled;
+    }
+
+    GlslCompiler::GlslCompiler(
+        const std::string& cache_dir,
+        uint32_t target_vulkan_version
+    )
+        : _cache_dir(cache_dir),
+        _target_vulkan_version(target_vulkan_version),
+        stats_mutex(std::make_shared<std::mutex>())
+    {}
+#endif
+
+    SamplerPtr Sampler::create(
+        const DevicePtr& device,
+        const SamplerConfig& config
+    )
+    {
+        try
+        {
+            SamplerPtr sampler = std::make_shared<Sampler_public_ctor>(
+                device,
+                config
+            );
+
+            VkSamplerCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = sampler->config().flags,
+                .magFilter = sampler->config().mag_filter,
+                .minFilter = sampler->config().min_filter,
+                .mipmapMode = sampler->config().mipmap_mode,
+                .addressModeU = sampler->config().address_mode_u,
+                .addressModeV = sampler->config().address_mode_v,
+                .addressModeW = sampler->config().address_mode_w,
+                .mipLodBias = sampler->config().mip_lod_bias,
+                .anisotropyEnable = sampler->config().anisotropy_enable,
+                .maxAnisotropy = sampler->config().max_anisotropy,
+                .compareEnable = sampler->config().compare_enable,
+                .compareOp = sampler->config().compare_op,
+                .minLod = sampler->config().min_lod,
+                .maxLod = sampler->config().max_lod,
+                .borderColor = sampler->config().border_color,
+
+                .unnormalizedCoordinates =
+                sampler->config().unnormalized_coordinates
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateSampler(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &sampler->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return sampler;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create sampler: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Sampler::~Sampler()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroySampler(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Sampler::Sampler(
+        const DevicePtr& device,
+        const SamplerConfig& config
+    )
+        : _device(device),
+        _config(config)
+    {}
+
+    DescriptorSetLayoutPtr DescriptorSetLayout::create(
+        const DevicePtr& device,
+        const DescriptorSetLayoutConfig& config
+    )
+    {
+        try
+        {
+            DescriptorSetLayoutPtr layout =
+                std::make_shared<DescriptorSetLayout_public_ctor>(
+                    device,
+                    config
+                );
+
+            std::vector<VkDescriptorSetLayoutBinding> vk_bindings(
+                layout->config().bindings.size()
+            );
+            std::vector<std::vector<VkSampler>> wastes_vk_immutable_samplers(
+                layout->config().bindings.size()
+            );
+            for (size_t i = 0; i < layout->config().bindings.size(); i++)
+            {
+                vk_bindings[i] = DescriptorSetLayoutBinding_to_vk(
+                    layout->config().bindings[i],
+                    wastes_vk_immutable_samplers[i]
+                );
+            }
+
+            VkDescriptorSetLayoutCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = layout->config().flags,
+                .bindingCount = (uint32_t)vk_bindings.size(),
+                .pBindings = vk_bindings.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateDescriptorSetLayout(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &layout->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return layout;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create descriptor set layout: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    DescriptorSetLayout::~DescriptorSetLayout()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyDescriptorSetLayout(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    DescriptorSetLayout::DescriptorSetLayout(
+        const DevicePtr& device,
+        const DescriptorSetLayoutConfig& config
+    )
+        : _device(device),
+        _config(config)
+    {}
+
+    PipelineLayoutPtr PipelineLayout::create(
+        const DevicePtr& device,
+        const PipelineLayoutConfig& config
+    )
+    {
+        try
+        {
+            PipelineLayoutPtr layout =
+                std::make_shared<PipelineLayout_public_ctor>(
+                    device,
+                    config
+                );
+
+            std::vector<VkDescriptorSetLayout> vk_set_layouts(
+                layout->config().set_layouts.size()
+            );
+            for (size_t i = 0; i < layout->config().set_layouts.size(); i++)
+            {
+                vk_set_layouts[i] =
+                    lock_wptr(layout->config().set_layouts[i])->handle();
+            }
+
+            std::vector<VkPushConstantRange> vk_push_constant_ranges(
+                layout->config().push_constant_ranges.size()
+            );
+            for (size_t i = 0;
+                i < layout->config().push_constant_ranges.size();
+                i++)
+            {
+                vk_push_constant_ranges[i] = PushConstantRange_to_vk(
+                    layout->config().push_constant_ranges[i]
+                );
+            }
+
+            VkPipelineLayoutCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = layout->config().flags,
+                .setLayoutCount = (uint32_t)vk_set_layouts.size(),
+                .pSetLayouts = vk_set_layouts.data(),
+
+                .pushConstantRangeCount =
+                (uint32_t)vk_push_constant_ranges.size(),
+
+                .pPushConstantRanges = vk_push_constant_ranges.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreatePipelineLayout(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &layout->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return layout;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create pipeline layout: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    PipelineLayout::~PipelineLayout()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyPipelineLayout(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    PipelineLayout::PipelineLayout(
+        const DevicePtr& device,
+        const PipelineLayoutConfig& config
+    )
+        : _device(device), _config(config)
+    {}
+
+    RenderPassPtr RenderPass::create(
+        const DevicePtr& device,
+        const RenderPassConfig& config
+    )
+    {
+        try
+        {
+            RenderPassPtr pass = std::make_shared<RenderPass_public_ctor>(
+                device,
+                config
+            );
+
+            std::vector<VkAttachmentDescription> vk_attachments(
+                pass->config().attachments.size()
+            );
+            for (size_t i = 0; i < pass->config().attachments.size(); i++)
+            {
+                vk_attachments[i] = Attachment_to_vk(
+                    pass->config().attachments[i]
+                );
+            }
+
+            std::vector<VkSubpassDescription> vk_subpasses(
+                pass->config().subpasses.size()
+            );
+            std::vector<std::vector<VkAttachmentReference>>
+                wastes_vk_input_attachments(pass->config().subpasses.size());
+            std::vector<std::vector<VkAttachmentReference>>
+                wastes_vk_color_attachments(pass->config().subpasses.size());
+            std::vector<std::vector<VkAttachmentReference>>
+                wastes_vk_resolve_attachments(pass->config().subpasses.size());
+            std::vector<VkAttachmentReference>
+                wastes_vk_depth_stencil_attachment(
+                    pass->config().subpasses.size()
+                );
+            std::vector<std::vector<uint32_t>>
+                wastes_preserve_attachment_indices(
+                    pass->config().subpasses.size()
+                );
+            for (size_t i = 0; i < pass->config().subpasses.size(); i++)
+            {
+                vk_subpasses[i] = Subpass_to_vk(
+                    pass->config().subpasses[i],
+                    wastes_vk_input_attachments[i],
+                    wastes_vk_color_attachments[i],
+                    wastes_vk_resolve_attachments[i],
+                    wastes_vk_depth_stencil_attachment[i],
+                    wastes_preserve_attachment_indices[i]
+                );
+            }
+
+            std::vector<VkSubpassDependency> vk_dependencies(
+                pass->config().dependencies.size()
+            );
+            for (size_t i = 0; i < pass->config().dependencies.size(); i++)
+            {
+                vk_dependencies[i] = SubpassDependency_to_vk(
+                    pass->config().dependencies[i]
+                );
+            }
+
+            VkRenderPassCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = pass->config().flags,
+                .attachmentCount = (uint32_t)vk_attachments.size(),
+                .pAttachments = vk_attachments.data(),
+                .subpassCount = (uint32_t)vk_subpasses.size(),
+                .pSubpasses = vk_subpasses.data(),
+                .dependencyCount = (uint32_t)vk_dependencies.size(),
+                .pDependencies = vk_dependencies.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateRenderPass(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &pass->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return pass;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create render pass: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    RenderPass::~RenderPass()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyRenderPass(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    RenderPass::RenderPass(
+        const DevicePtr& device,
+        const RenderPassConfig& config
+    )
+        : _device(device), _config(config)
+    {}
+
+    // VkPipelineCreationFeedbackCreateInfo can only be chained if
+    // VK_EXT_pipeline_creation_feedback is enabled or Vulkan 1.3 is used
+    static bool pipeline_creation_feedback_supported(const DevicePtr& device)
+    {
+        if (device->physical_device().vulkan13_features().has_value())
+        {
+            return true;
+        }
+        const auto& extensions = device->config().extensions;
+        return std::find(
+            extensions.begin(),
+            extensions.end(),
+            VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME
+        ) != extensions.end();
+    }
+
+    // modules created from an identifier only work for pipelines that are
+    // in the pipeline cache. such pipelines are created with
+    // VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT and if that
+    // fails, the modules get their handles and the pipeline is created again.
+    static void ensure_shader_stage_handles(
+        const std::vector<ShaderStage>& stages
+    )
+    {
+        for (const auto& stage : stages)
+        {
+            lock_wptr(stage.module)->ensure_handle();
+        }
+    }
+
+    // the create info of a graphics pipeline along with everything it points
+    // to. it can't be copied or moved since the create info points into its
+    // own members.
+    struct GraphicsPipelineVkInfo
+    {
+        std::vector<VkPipelineShaderStageCreateInfo> vk_stages;
+        std::vector<VkSpecializationInfo> wastes_vk_specialization_info;
+        std::vector<std::vector<VkSpecializationMapEntry>>
+            wastes_vk_map_entries;
+        std::vector<std::vector<uint8_t>> wastes_data;
+        std::vector<VkPipelineShaderStageModuleIdentifierCreateInfoEXT>
+            wastes_vk_identifier_info;
+
+        VkPipelineVertexInputStateCreateInfo vk_vertex_input_state{};
+        std::vector<VkVertexInputBindingDescription>
+            waste_vk_binding_descriptions;
+        std::vector<VkVertexInputAttributeDescription>
+            waste_vk_attribute_descriptions;
+
+        VkPipelineInputAssemblyStateCreateInfo vk_input_assembly_state{};
+        VkPipelineTessellationStateCreateInfo vk_tessellation_state{};
+
+        VkPipelineViewportStateCreateInfo vk_viewport_state{};
+        std::vector<VkViewport> waste_vk_viewports;
+        std::vector<VkRect2D> waste_vk_scissors;
+
+        VkPipelineRasterizationStateCreateInfo vk_rasterization_state{};
+
+        VkPipelineMultisampleStateCreateInfo vk_multisample_state{};
+        std::vector<VkSampleMask> waste_sample_mask;
+
+        VkPipelineDepthStencilStateCreateInfo vk_depth_stencil_state{};
+
+        VkPipelineColorBlendStateCreateInfo vk_color_blend_state{};
+        std::vector<VkPipelineColorBlendAttachmentState>
+            waste_vk_color_blend_attachments;
+
+        VkPipelineDynamicStateCreateInfo vk_dynamic_states{};
+        std::vector<VkDynamicState> waste_dynamic_states;
+
+        VkPipelineRenderingCreateInfo vk_rendering_formats{};
+
+        VkGraphicsPipelineLibraryCreateInfoEXT vk_library_info{};
+        VkPipelineLibraryCreateInfoKHR vk_libraries_info{};
+        std::vector<VkPipeline> waste_vk_libraries;
+
+        // feedback is only gathered for the stats of the cache
+        VkPipelineCreationFeedback vk_feedback{};
+        VkPipelineCreationFeedbackCreateInfo vk_feedback_info{};
+
+        VkGraphicsPipelineCreateInfo create_info{};
+
+        GraphicsPipelineVkInfo(
+            const GraphicsPipelineConfig& config,
+            bool gather_feedback
+        )
+        {
+            vk_stages.resize(config.stages.size());
+            wastes_vk_specialization_info.resize(config.stages.size());
+            wastes_vk_map_entries.resize(config.stages.size());
+            wastes_data.resize(config.stages.size());
+            wastes_vk_identifier_info.resize(config.stages.size());
+            bool uses_identifiers = false;
+            for (size_t i = 0; i < config.stages.size(); i++)
+            {
+                vk_stages[i] = ShaderStage_to_vk(
+                    config.stages[i],
+                    wastes_vk_specialization_info[i],
+                    wastes_vk_map_entries[i],
+                    wastes_data[i],
+                    wastes_vk_identifier_info[i]
+                );
+                uses_identifiers |= (vk_stages[i].module == nullptr);
+            }
+
+            if (config.vertex_input_state.has_value())
+            {
+                vk_vertex_input_state = VertexInputState_to_vk(
+                    config.vertex_input_state.value(),
+                    waste_vk_binding_descriptions,
+                    waste_vk_attribute_descriptions
+                );
+            }
+
+            if (config.input_assembly_state.has_value())
+            {
+                vk_input_assembly_state = InputAssemblyState_to_vk(
+                    config.input_assembly_state.value()
+                );
+            }
+
+            if (config.tessellation_state.has_value())
+            {
+                vk_tessellation_state = TessellationState_to_vk(
+                    config.tessellation_state.value()
+                );
+            }
+
+            if (config.viewport_state.has_value())
+            {
+                vk_viewport_state = ViewportState_to_vk(
+                    config.viewport_state.value(),
+                    waste_vk_viewports,
+                    waste_vk_scissors
+                );
+            }
+
+            if (config.rasterization_state.has_value())
+            {
+                vk_rasterization_state = RasterizationState_to_vk(
+                    config.rasterization_state.value()
+                );
+            }
+
+            if (config.multisample_state.has_value())
+            {
+                vk_multisample_state = MultisampleState_to_vk(
+                    config.multisample_state.value(),
+                    waste_sample_mask
+                );
+            }
+
+            if (config.depth_stencil_state.has_value())
+            {
+                vk_depth_stencil_state = DepthStencilState_to_vk(
+                    config.depth_stencil_state.value()
+                );
+            }
+
+            if (config.color_blend_state.has_value())
+            {
+                vk_color_blend_state = ColorBlendState_to_vk(
+                    config.color_blend_state.value(),
+                    waste_vk_color_blend_attachments
+                );
+            }
+
+            vk_dynamic_states = DynamicStates_to_vk(
+                config.dynamic_states,
+                waste_dynamic_states
+            );
+
+            bool dynamic_rendering = config.rendering_formats.has_value();
+            if (dynamic_rendering)
+            {
+                vk_rendering_formats = PipelineRenderingFormats_to_vk(
+                    config.rendering_formats.value()
+                );
+            }
+
+            const void* p_next =
+                dynamic_rendering ? &vk_rendering_formats : nullptr;
+
+            VkPipelineCreateFlags flags = config.flags;
+            if (uses_identifiers)
+            {
+                flags |=
+                    VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT;
+            }
+            if (config.library_flags != 0)
+            {
+                flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+                vk_library_info = VkGraphicsPipelineLibraryCreateInfoEXT{
+                    .sType =
+                    VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+
+                    .pNext = p_next,
+                    .flags = config.library_flags
+                };
+                p_next = &vk_library_info;
+            }
+
+            if (!config.libraries.empty())
+            {
+                waste_vk_libraries.resize(config.libraries.size());
+                for (size_t i = 0; i < config.libraries.size(); i++)
+                {
+                    waste_vk_libraries[i] =
+                        lock_wptr(config.libraries[i])->handle();
+                }
+                vk_libraries_info = VkPipelineLibraryCreateInfoKHR{
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+                    .pNext = p_next,
+                    .libraryCount = (uint32_t)waste_vk_libraries.size(),
+                    .pLibraries = waste_vk_libraries.data()
+                };
+                p_next = &vk_libraries_info;
+            }
+
+            if (gather_feedback)
+            {
+                vk_feedback_info = VkPipelineCreationFeedbackCreateInfo{
+                    .sType =
+                    VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+
+                    .pNext = p_next,
+                    .pPipelineCreationFeedback = &vk_feedback,
+                    .pipelineStageCreationFeedbackCount = 0,
+                    .pPipelineStageCreationFeedbacks = nullptr
+                };
+                p_next = &vk_feedback_info;
+            }
+
+            create_info = VkGraphicsPipelineCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                .pNext = p_next,
+                .flags = flags,
+                .stageCount = (uint32_t)vk_stages.size(),
+                .pStages = vk_stages.data(),
+
+                .pVertexInputState =
+                config.vertex_input_state.has_value()
+                ? &vk_vertex_input_state : nullptr,
+
+                .pInputAssemblyState =
+                config.input_assembly_state.has_value()
+                ? &vk_input_assembly_state : nullptr,
+
+                .pTessellationState =
+                config.tessellation_state.has_value()
+                ? &vk_tessellation_state : nullptr,
+
+                .pViewportState =
+                config.viewport_state.has_value()
+                ? &vk_viewport_state : nullptr,
+
+                .pRasterizationState =
+                config.rasterization_state.has_value()
+                ? &vk_rasterization_state : nullptr,
+
+                .pMultisampleState =
+                config.multisample_state.has_value()
+                ? &vk_multisample_state : nullptr,
+
+                .pDepthStencilState =
+                config.depth_stencil_state.has_value()
+                ? &vk_depth_stencil_state : nullptr,
+
+                .pColorBlendState =
+                config.color_blend_state.has_value()
+                ? &vk_color_blend_state : nullptr,
+
+                .pDynamicState =
+                config.dynamic_states.empty()
+                ? nullptr : &vk_dynamic_states,
+
+                .layout = lock_wptr(config.layout)->handle(),
+
+                .renderPass = dynamic_rendering
+                ? VK_NULL_HANDLE
+                : lock_wptr(config.render_pass)->handle(),
+
+                .subpass = dynamic_rendering ? 0 : config.subpass_index,
+
+                .basePipelineHandle =
+                config.base_pipeline.has_value()
+                ? lock_wptr(config.base_pipeline.value())->handle()
+                : nullptr,
+
+                .basePipelineIndex = -1
+            };
+        }
+
+        GraphicsPipelineVkInfo(const GraphicsPipelineVkInfo& other) = delete;
+        GraphicsPipelineVkInfo& operator=(
+            const GraphicsPipelineVkInfo& other
+        ) = delete;
+    };
+
+    GraphicsPipelinePtr GraphicsPipeline::create(
+        const DevicePtr& device,
+        const GraphicsPipelineConfig& config,
+        const PipelineCachePtr& cache
+    )
+    {
+        BV_TRACE_ZONE("bv::GraphicsPipeline::create");
+
+        try
+        {
+            GraphicsPipelinePtr pipe =
+                std::make_shared<GraphicsPipeline_public_ctor>(
+                    device,
+                    config,
+                    cache
+                );
+
+            // without a cache the pipeline can't be found by identifiers
+            if (cache == nullptr)
+            {
+                ensure_shader_stage_handles(pipe->config().stages);
+            }
+
+            bool gather_feedback =
+                cache != nullptr
+                && pipeline_creation_feedback_supported(device);
+            std::optional<GraphicsPipelineVkInfo> vk_info;
+            vk_info.emplace(pipe->config(), gather_feedback);
+
+            auto create_vk_pipeline = [&]()
+            {
+                return device->dispatch().vkCreateGraphicsPipelines(
+                    device->handle(),
+                    cache == nullptr ? nullptr : cache->handle(),
+                    1,
+                    &vk_info->create_info,
+                    lock_wptr(device->context())->vk_allocator_ptr(),
+                    &pipe->_handle
+                );
+            };
+
+            VkResult vk_result = create_vk_pipeline();
+            if (vk_result == VK_PIPELINE_COMPILE_REQUIRED)
+            {
+                ensure_shader_stage_handles(pipe->config().stages);
+                vk_info.emplace(pipe->config(), gather_feedback);
+                vk_result = create_vk_pipeline();
+            }
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            if (gather_feedback)
+            {
+                cache->add_creation_feedback(vk_info->vk_feedback);
+            }
+            return pipe;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create graphics pipeline: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<GraphicsPipelinePtr> GraphicsPipeline::create_multiple(
+        const DevicePtr& device,
+        const std::vector<GraphicsPipelineConfig>& configs,
+        const PipelineCachePtr& cache
+    )
+    {
+        BV_TRACE_ZONE("bv::GraphicsPipeline::create_multiple");
+
+        try
+        {
+            bool gather_feedback =
+                cache != nullptr
+                && pipeline_creation_feedback_supported(device);
+
+            // deque elements stay in place when more are added
+            std::vector<GraphicsPipelinePtr> pipes(configs.size());
+            std::deque<GraphicsPipelineVkInfo> vk_infos;
+            std::vector<VkGraphicsPipelineCreateInfo> create_infos(
+                configs.size()
+            );
+            for (size_t i = 0; i < configs.size(); i++)
+            {
+                // a failed batch can't be retried for single pipelines, so
+                // identifiers aren't used here
+                ensure_shader_stage_handles(configs[i].stages);
+                pipes[i] = std::make_shared<GraphicsPipeline_public_ctor>(
+                    device,
+                    configs[i],
+                    cache
+                );
+                create_infos[i] = vk_infos.emplace_back(
+                    pipes[i]->config(),
+                    gather_feedback
+                ).create_info;
+            }
+
+            std::vector<VkPipeline> vk_pipelines(configs.size(), nullptr);
+            VkResult vk_result = device->dispatch().vkCreateGraphicsPipelines(
+                device->handle(),
+                cache == nullptr ? nullptr : cache->handle(),
+                (uint32_t)create_infos.size(),
+                create_infos.data(),
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                vk_pipelines.data()
+            );
+
+            // if some of the pipelines failed, the ones that were created are
+            // destroyed along with pipes
+            for (size_t i = 0; i < pipes.size(); i++)
+            {
+                pipes[i]->_handle = vk_pipelines[i];
+            }
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            if (gather_feedback)
+            {
+                for (const auto& vk_info : vk_infos)
+                {
+                    cache->add_creation_feedback(vk_info.vk_feedback);
+                }
+            }
+            return pipes;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create graphics pipelines: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    GraphicsPipeline::~GraphicsPipeline()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyPipeline(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    GraphicsPipeline::GraphicsPipeline(
+        const DevicePtr& device,
+        const GraphicsPipelineConfig& config,
+        const PipelineCachePtr& cache
+    )
+        : _device(device), _config(config), _cache(cache)
+    {}
+
+    // the create info of a compute pipeline along with everything it points
+    // to. it can't be copied or moved since the create info points into its
+    // own members.
+    struct ComputePipelineVkInfo
+    {
+        VkSpecializationInfo waste_vk_specialization_info;
+        std::vector<VkSpecializationMapEntry> waste_vk_map_entries;
+        std::vector<uint8_t> waste_data;
+        VkPipelineShaderStageModuleIdentifierCreateInfoEXT
+            waste_vk_identifier_info{};
+
+        // feedback is only gathered for the stats of the cache
+        VkPipelineCreationFeedback vk_feedback{};
+        VkPipelineCreationFeedbackCreateInfo vk_feedback_info{};
+
+        VkComputePipelineCreateInfo create_info{};
+
+        ComputePipelineVkInfo(
+            const ComputePipelineConfig& config,
+            bool gather_feedback
+        )
+        {
+            VkPipelineShaderStageCreateInfo vk_stage = ShaderStage_to_vk(
+                config.stage,
+                waste_vk_specialization_info,
+                waste_vk_map_entries,
+                waste_data,
+                waste_vk_identifier_info
+            );
+
+            VkPipelineCreateFlags flags = config.flags;
+            if (vk_stage.module == nullptr)
+            {
+                flags |=
+                    VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT;
+            }
+
+            vk_feedback_info = VkPipelineCreationFeedbackCreateInfo{
+                .sType =
+                VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+
+                .pNext = nullptr,
+                .pPipelineCreationFeedback = &vk_feedback,
+                .pipelineStageCreationFeedbackCount = 0,
+                .pPipelineStageCreationFeedbacks = nullptr
+            };
+
+            create_info = VkComputePipelineCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                .pNext = gather_feedback ? &vk_feedback_info : nullptr,
+                .flags = flags,
+                .stage = vk_stage,
+                .layout = lock_wptr(config.layout)->handle(),
+
+                .basePipelineHandle =
+                config.base_pipeline.has_value()
+                ? lock_wptr(config.base_pipeline.value())->handle()
+                : nullptr,
+
+                .basePipelineIndex = -1
+            };
+        }
+
+        ComputePipelineVkInfo(const ComputePipelineVkInfo& other) = delete;
+        ComputePipelineVkInfo& operator=(
+            const ComputePipelineVkInfo& other
+        ) = delete;
+    };
+
+    ComputePipelinePtr ComputePipeline::create(
+        const DevicePtr& device,
+        const ComputePipelineConfig& config,
+        const PipelineCachePtr& cache
+    )
+    {
+        BV_TRACE_ZONE("bv::ComputePipeline::create");
+
+        try
+        {
+            ComputePipelinePtr pipe =
+                std::make_shared<ComputePipeline_public_ctor>(
+                    device,
+                    config,
+                    cache
+                );
+
+            // without a cache the pipeline can't be found by identifiers
+            if (cache == nullptr)
+            {
+                ensure_shader_stage_handles({ pipe->config().stage });
+            }
+
+            bool gather_feedback =
+                cache != nullptr
+                && pipeline_creation_feedback_supported(device);
+            std::optional<ComputePipelineVkInfo> vk_info;
+            vk_info.emplace(pipe->config(), gather_feedback);
+
+            auto create_vk_pipeline = [&]()
+            {
+                return device->dispatch().vkCreateComputePipelines(
+                    device->handle(),
+                    cache == nullptr ? nullptr : cache->handle(),
+                    1,
+                    &vk_info->create_info,
+                    lock_wptr(device->context())->vk_allocator_ptr(),
+                    &pipe->_handle
+                );
+            };
+
+            VkResult vk_result = create_vk_pipeline();
+            if (vk_result == VK_PIPELINE_COMPILE_REQUIRED)
+            {
+                ensure_shader_stage_handles({ pipe->config().stage });
+                vk_info.emplace(pipe->config(), gather_feedback);
+                vk_result = create_vk_pipeline();
+            }
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            if (gather_feedback)
+            {
+                cache->add_creation_feedback(vk_info->vk_feedback);
+            }
+            return pipe;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create compute pipeline: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<ComputePipelinePtr> ComputePipeline::create_multiple(
+        const DevicePtr& device,
+        const std::vector<ComputePipelineConfig>& configs,
+        const PipelineCachePtr& cache
+    )
+    {
+        BV_TRACE_ZONE("bv::ComputePipeline::create_multiple");
+
+        try
+        {
+            bool gather_feedback =
+                cache != nullptr
+                && pipeline_creation_feedback_supported(device);
+
+            // deque elements stay in place when more are added
+            std::vector<ComputePipelinePtr> pipes(configs.size());
+            std::deque<ComputePipelineVkInfo> vk_infos;
+            std::vector<VkComputePipelineCreateInfo> create_infos(
+                configs.size()
+            );
+            for (size_t i = 0; i < configs.size(); i++)
+            {
+                // a failed batch can't be retried for single pipelines, so
+                // identifiers aren't used here
+                ensure_shader_stage_handles({ configs[i].stage });
+                pipes[i] = std::make_shared<ComputePipeline_public_ctor>(
+                    device,
+                    configs[i],
+                    cache
+                );
+                create_infos[i] = vk_infos.emplace_back(
+                    pipes[i]->config(),
+                    gather_feedback
+                ).create_info;
+            }
+
+            std::vector<VkPipeline> vk_pipelines(configs.size(), nullptr);
+            VkResult vk_result = device->dispatch().vkCreateComputePipelines(
+                device->handle(),
+                cache == nullptr ? nullptr : cache->handle(),
+                (uint32_t)create_infos.size(),
+                create_infos.data(),
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                vk_pipelines.data()
+            );
+
+            // if some of the pipelines failed, the ones that were created are
+            // destroyed along with pipes
+            for (size_t i = 0; i < pipes.size(); i++)
+            {
+                pipes[i]->_handle = vk_pipelines[i];
+            }
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            if (gather_feedback)
+            {
+                for (const auto& vk_info : vk_infos)
+                {
+                    cache->add_creation_feedback(vk_info.vk_feedback);
+                }
+            }
+            return pipes;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create compute pipelines: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    ComputePipeline::~ComputePipeline()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyPipeline(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    ComputePipeline::ComputePipeline(
+        const DevicePtr& device,
+        const ComputePipelineConfig& config,
+        const PipelineCachePtr& cache
+    )
+        : _device(device), _config(config), _cache(cache)
+    {}
+
+    FramebufferPtr Framebuffer::create(
+        const DevicePtr& device,
+        const FramebufferConfig& config
+    )
+    {
+        try
+        {
+            FramebufferPtr buf = std::make_shared<Framebuffer_public_ctor>(
+                device,
+                config
+            );
+
+            std::vector<VkImageView> vk_attachments(
+                buf->config().attachments.size()
+            );
+            for (size_t i = 0; i < buf->config().attachments.size(); i++)
+            {
+                vk_attachments[i] =
+                    lock_wptr(buf->config().attachments[i])->handle();
+            }
+
+            const auto& image_infos = buf->config().attachment_image_infos;
+            bool imageless = !image_infos.empty();
+            if (imageless && !vk_attachments.empty())
+            {
+                throw Error(
+                    "attachments must be empty for imageless framebuffers"
+                );
+            }
+
+            std::vector<VkFramebufferAttachmentImageInfo> vk_image_infos(
+                image_infos.size()
+            );
+            for (size_t i = 0; i < image_infos.size(); i++)
+            {
+                vk_image_infos[i] = VkFramebufferAttachmentImageInfo{
+                    .sType =
+                    VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENT_IMAGE_INFO,
+
+                    .pNext = nullptr,
+                    .flags = image_infos[i].flags,
+                    .usage = image_infos[i].usage,
+                    .width = image_infos[i].width,
+                    .height = image_infos[i].height,
+                    .layerCount = image_infos[i].layer_count,
+                    .viewFormatCount =
+                    (uint32_t)image_infos[i].view_formats.size(),
+
+                    .pViewFormats = image_infos[i].view_formats.data()
+                };
+            }
+
+            VkFramebufferAttachmentsCreateInfo vk_attachments_info{
+                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_ATTACHMENTS_CREATE_INFO,
+                .pNext = nullptr,
+                .attachmentImageInfoCount = (uint32_t)vk_image_infos.size(),
+                .pAttachmentImageInfos = vk_image_infos.data()
+            };
+
+            VkFramebufferCreateFlags flags = buf->config().flags;
+            if (imageless)
+            {
+                flags |= VK_FRAMEBUFFER_CREATE_IMAGELESS_BIT;
+            }
+
+            VkFramebufferCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                .pNext = imageless ? &vk_attachments_info : nullptr,
+                .flags = flags,
+                .renderPass = lock_wptr(buf->config().render_pass)->handle(),
+                .attachmentCount = imageless
+                ? (uint32_t)vk_image_infos.size()
+                : (uint32_t)vk_attachments.size(),
+
+                .pAttachments = imageless ? nullptr : vk_attachments.data(),
+                .width = buf->config().width,
+                .height = buf->config().height,
+                .layers = buf->config().layers
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateFramebuffer(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &buf->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return buf;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create framebuffer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Framebuffer::~Framebuffer()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyFramebuffer(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Framebuffer::Framebuffer(
+        const DevicePtr& device,
+        const FramebufferConfig& config
+    )
+        : _device(device), _config(config)
+    {}
+
+    // hash of the handles of the render pass and attachments along with
+    // everything else in the config that the framebuffer depends on. entries
+    // with the same key are told apart by framebuffer_configs_match().
+    static uint64_t framebuffer_cache_key(const FramebufferConfig& config)
+    {
+        uint64_t hash = FNV1A_OFFSET_BASIS;
+        const auto mix = [&hash](uint64_t value)
+        {
+            hash = fnv1a_hash(
+                std::span<const uint8_t>((const uint8_t*)&value, sizeof(value)),
+                hash
+            );
+        };
+
+        mix((uint64_t)lock_wptr(config.render_pass)->handle());
+        mix(config.flags);
+        mix(config.width);
+        mix(config.height);
+        mix(config.layers);
+        mix(config.attachments.size());
+        for (const auto& view : config.attachments)
+        {
+            mix((uint64_t)lock_wptr(view)->handle());
+        }
+        for (const auto& info : config.attachment_image_infos)
+        {
+            mix(info.flags);
+            mix(info.usage);
+            mix(info.width);
+            mix(info.height);
+            mix(info.layer_count);
+            mix(info.view_formats.size());
+            for (auto format : info.view_formats)
+            {
+                mix((uint64_t)format);
+            }
+        }
+        return hash;
+    }
+
+    template<typename T>
+    static bool same_object(
+        const std::weak_ptr<T>& a,
+        const std::weak_ptr<T>& b
+    )
+    {
+        return !a.owner_before(b) && !b.owner_before(a);
+    }
+
+    // whether a cached framebuffer was created with the same objects and
+    // parameters as config
+    static bool framebuffer_configs_match(
+        const FramebufferConfig& a,
+        const FramebufferConfig& b
+    )
+    {
+        if (!same_object(a.render_pass, b.render_pass)
+            || a.flags != b.flags
+            || a.width != b.width
+            || a.height != b.height
+            || a.layers != b.layers
+            || a.attachments.size() != b.attachments.size()
+            || a.attachment_image_infos.size()
+            != b.attachment_image_infos.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.attachments.size(); i++)
+        {
+            if (!same_object(a.attachments[i], b.attachments[i]))
+            {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < a.attachment_image_infos.size(); i++)
+        {
+            const auto& info_a = a.attachment_image_infos[i];
+            const auto& info_b = b.attachment_image_infos[i];
+            if (info_a.flags != info_b.flags
+                || info_a.usage != info_b.usage
+                || info_a.width != info_b.width
+                || info_a.height != info_b.height
+                || info_a.layer_count != info_b.layer_count
+                || info_a.view_formats != info_b.view_formats)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // handles can be reused by the driver after an object is destroyed, so
+    // a cached framebuffer is only valid while the objects it was created
+    // with are still alive.
+    static bool framebuffer_config_expired(const FramebufferConfig& config)
+    {
+        if (config.render_pass.expired())
+        {
+            return true;
+        }
+        for (const auto& view : config.attachments)
+        {
+            if (view.expired())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    FramebufferCachePtr FramebufferCache::create(const DevicePtr& device)
+    {
+        return std::make_shared<FramebufferCache_public_ctor>(device);
+    }
+
+    FramebufferPtr FramebufferCache::get(const FramebufferConfig& config)
+    {
+        try
+        {
+            uint64_t key = framebuffer_cache_key(config);
+
+            std::scoped_lock lock(*mutex);
+            auto it = framebufs.find(key);
+            if (it != framebufs.end()
+                && !framebuffer_config_expired(it->second->config())
+                && framebuffer_configs_match(it->second->config(), config))
+            {
+                return it->second;
+            }
+
+            auto framebuf = Framebuffer::create(lock_wptr(device()), config);
+            framebufs[key] = framebuf;
+            return framebuf;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to get cached framebuffer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void FramebufferCache::prune()
+    {
+        std::scoped_lock lock(*mutex);
+        std::erase_if(
+            framebufs,
+            [](const auto& entry)
+            {
+                return framebuffer_config_expired(entry.second->config());
+            }
+        );
+    }
+
+    void FramebufferCache::clear()
+    {
+        std::scoped_lock lock(*mutex);
+        framebufs.clear();
+    }
+
+    size_t FramebufferCache::size() const
+    {
+        std::scoped_lock lock(*mutex);
+        return framebufs.size();
+    }
+
+    FramebufferCache::FramebufferCache(const DevicePtr& device)
+        : _device(device), mutex(std::make_shared<std::mutex>())
+    {}
+
+    void CommandBuffer::reset(VkCommandBufferResetFlags flags)
+    {
+        VkResult vk_result = dispatch().vkResetCommandBuffer(_handle, flags);
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error(
+                "failed to reset command buffer",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    void CommandBuffer::begin(
+        VkCommandBufferUsageFlags flags,
+        std::optional<CommandBufferInheritance> inheritance
+    )
+    {
+        try
+        {
+            VkCommandBufferInheritanceInfo vk_inheritance;
+            if (inheritance.has_value())
+            {
+                vk_inheritance = VkCommandBufferInheritanceInfo{
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                    .pNext = nullptr,
+                    .renderPass = lock_wptr(inheritance->render_pass)->handle(),
+                    .subpass = inheritance->subpass_index,
+
+                    .framebuffer =
+                    inheritance->framebuffer.has_value()
+                    ? lock_wptr(
+                        inheritance->framebuffer.value()
+                    )->handle()
+                    : nullptr,
+
+                    .occlusionQueryEnable = inheritance->occlusion_query_enable,
+                    .queryFlags = inheritance->query_flags,
+                    .pipelineStatistics = inheritance->pipeline_statistics
+                };
+            }
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.pNext = nullptr;
+            begin_info.flags = flags;
+            begin_info.pInheritanceInfo =
+                inheritance.has_value() ? &vk_inheritance : nullptr;
+
+            VkResult vk_result = dispatch().vkBeginCommandBuffer(
+                handle(),
+                &begin_info
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to begin recording a command buffer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void CommandBuffer::end()
+    {
+        VkResult vk_result = dispatch().vkEndCommandBuffer(handle());
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error(
+                "failed to end recording a command buffer",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    void CommandBuffer::pipeline_barrier(
+        VkPipelineStageFlags src_stage_mask,
+        VkPipelineStageFlags dst_stage_mask,
+        VkDependencyFlags dependency_flags,
+        const std::vector<BufferMemoryBarrier>& buffer_memory_barriers,
+        const std::vector<ImageMemoryBarrier>& image_memory_barriers
+    )
+    {
+        try
+        {
+            std::vector<VkBufferMemoryBarrier> vk_buffer_memory_barriers(
+                buffer_memory_barriers.size()
+            );
+            for (size_t i = 0; i < buffer_memory_barriers.size(); i++)
+            {
+                vk_buffer_memory_barriers[i] = BufferMemoryBarrier_to_vk(
+                    buffer_memory_barriers[i]
+                );
+            }
+
+            std::vector<VkImageMemoryBarrier> vk_image_memory_barriers(
+                image_memory_barriers.size()
+            );
+            for (size_t i = 0; i < image_memory_barriers.size(); i++)
+            {
+                vk_image_memory_barriers[i] = ImageMemoryBarrier_to_vk(
+                    image_memory_barriers[i]
+                );
+            }
+
+            dispatch().vkCmdPipelineBarrier(
+                handle(),
+                src_stage_mask,
+                dst_stage_mask,
+                dependency_flags,
+                0,
+                nullptr,
+                (uint32_t)vk_buffer_memory_barriers.size(),
+                vk_buffer_memory_barriers.data(),
+                (uint32_t)vk_image_memory_barriers.size(),
+                vk_image_memory_barriers.data()
+            );
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to record pipeline barrier: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void CommandBuffer::pipeline_barrier2(
+        const DependencyInfo& dependency_info
+    )
+    {
+        try
+        {
+            std::vector<VkMemoryBarrier2> waste_vk_memory_barriers;
+            std::vector<VkBufferMemoryBarrier2> waste_vk_buffer_memory_barriers;
+            std::vector<VkImageMemoryBarrier2> waste_vk_image_memory_barriers;
+            VkDependencyInfo vk_dependency_info = DependencyInfo_to_vk(
+                dependency_info,
+                waste_vk_memory_barriers,
+                waste_vk_buffer_memory_barriers,
+                waste_vk_image_memory_barriers
+            );
+
+            VkResult vk_result = CmdPipelineBarrier2KHR(
+                dispatch(),
+                handle(),
+                &vk_dependency_info
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to record pipeline barrier: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void CommandBuffer::reset_query_pool(
+        const QueryPoolPtr& query_pool,
+        uint32_t first_query,
+        uint32_t query_count
+    )
+    {
+        dispatch().vkCmdResetQueryPool(
+            handle(),
+            query_pool->handle(),
+            first_query,
+            query_count
+        );
+    }
+
+    void CommandBuffer::write_timestamp(
+        VkPipelineStageFlagBits stage,
+        const QueryPoolPtr& query_pool,
+        uint32_t query
+    )
+    {
+        dispatch().vkCmdWriteTimestamp(
+            handle(),
+            stage,
+            query_pool->handle(),
+            query
+        );
+    }
+
+    void CommandBuffer::begin_query(
+        const QueryPoolPtr& query_pool,
+        uint32_t query,
+        VkQueryControlFlags flags
+    )
+    {
+        dispatch().vkCmdBeginQuery(
+            handle(),
+            query_pool->handle(),
+            query,
+            flags
+        );
+    }
+
+    void CommandBuffer::end_query(
+        const QueryPoolPtr& query_pool,
+        uint32_t query
+    )
+    {
+        dispatch().vkCmdEndQuery(handle(), query_pool->handle(), query);
+    }
+
+    void CommandBuffer::begin_rendering(const RenderingInfo& rendering_info)
+    {
+        try
+        {
+            VkRenderingAttachmentInfo waste_vk_depth_attachment{};
+            VkRenderingAttachmentInfo waste_vk_stencil_attachment{};
+            VkRenderingInfo vk_rendering_info = RenderingInfo_to_vk(
+                rendering_info,
+                scratch_vk_color_attachments,
+                waste_vk_depth_attachment,
+                waste_vk_stencil_attachment
+            );
+
+            VkResult vk_result = CmdBeginRenderingKHR(
+                dispatch(),
+                handle(),
+                &vk_rendering_info
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to begin rendering: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void CommandBuffer::end_rendering()
+    {
+        VkResult vk_result = CmdEndRenderingKHR(dispatch(), handle());
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error("failed to end rendering", vk_result, false);
+        }
+    }
+
+    void CommandBuffer::begin_render_pass(
+        const RenderPassPtr& render_pass,
+        const FramebufferPtr& framebuffer,
+        const Rect2d& render_area,
+        const std::vector<VkClearValue>& clear_values,
+        VkSubpassContents contents,
+        const std::vector<ImageViewPtr>& attachments
+    )
+    {
+        bool imageless =
+            !framebuffer->config().attachment_image_infos.empty();
+        if (imageless == attachments.empty())
+        {
+            throw Error(
+                "failed to begin render pass: attachments must be provided if "
+                "and only if the framebuffer is imageless"
+            );
+        }
+
+        scratch_vk_attachments.resize(attachments.size());
+        for (size_t i = 0; i < attachments.size(); i++)
+        {
+            scratch_vk_attachments[i] = attachments[i]->handle();
+        }
+
+        VkRenderPassAttachmentBeginInfo attachment_begin_info{
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_ATTACHMENT_BEGIN_INFO,
+            .pNext = nullptr,
+            .attachmentCount = (uint32_t)scratch_vk_attachments.size(),
+            .pAttachments = scratch_vk_attachments.data()
+        };
+
+        VkRenderPassBeginInfo begin_info{
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .pNext = imageless ? &attachment_begin_info : nullptr,
+            .renderPass = render_pass->handle(),
+            .framebuffer = framebuffer->handle(),
+            .renderArea = Rect2d_to_vk(render_area),
+            .clearValueCount = (uint32_t)clear_values.size(),
+            .pClearValues = clear_values.data()
+        };
+        dispatch().vkCmdBeginRenderPass(handle(), &begin_info, contents);
+    }
+
+    void CommandBuffer::end_render_pass()
+    {
+        dispatch().vkCmdEndRenderPass(handle());
+    }
+
+    void CommandBuffer::set_cull_mode(VkCullModeFlags cull_mode)
+    {
+        check_command_loaded(dispatch().vkCmdSetCullMode, "set cull mode");
+        dispatch().vkCmdSetCullMode(handle(), cull_mode);
+    }
+
+    void CommandBuffer::set_front_face(VkFrontFace front_face)
+    {
+        check_command_loaded(dispatch().vkCmdSetFrontFace, "set front face");
+        dispatch().vkCmdSetFrontFace(handle(), front_face);
+    }
+
+    void CommandBuffer::set_primitive_topology(VkPrimitiveTopology topology)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetPrimitiveTopology,
+            "set primitive topology"
+        );
+        dispatch().vkCmdSetPrimitiveTopology(handle(), topology);
+    }
+
+    void CommandBuffer::set_viewport_with_count(
+        const std::vector<Viewport>& viewports
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetViewportWithCount,
+            "set viewport with count"
+        );
+
+        std::vector<VkViewport> vk_viewports(viewports.size());
+        for (size_t i = 0; i < viewports.size(); i++)
+        {
+            vk_viewports[i] = Viewport_to_vk(viewports[i]);
+        }
+        dispatch().vkCmdSetViewportWithCount(
+            handle(),
+            (uint32_t)vk_viewports.size(),
+            vk_viewports.data()
+        );
+    }
+
+    void CommandBuffer::set_scissor_with_count(
+        const std::vector<Rect2d>& scissors
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetScissorWithCount,
+            "set scissor with count"
+        );
+
+        std::vector<VkRect2D> vk_scissors(scissors.size());
+        for (size_t i = 0; i < scissors.size(); i++)
+        {
+            vk_scissors[i] = Rect2d_to_vk(scissors[i]);
+        }
+        dispatch().vkCmdSetScissorWithCount(
+            handle(),
+            (uint32_t)vk_scissors.size(),
+            vk_scissors.data()
+        );
+    }
+
+    void CommandBuffer::bind_vertex_buffers2(
+        uint32_t first_binding,
+        const std::vector<BufferPtr>& buffers,
+        const std::vector<VkDeviceSize>& offsets,
+        const std::vector<VkDeviceSize>& sizes,
+        const std::vector<VkDeviceSize>& strides
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdBindVertexBuffers2,
+            "bind vertex buffers"
+        );
+
+        std::vector<VkBuffer> vk_buffers(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            vk_buffers[i] = buffers[i]->handle();
+        }
+        dispatch().vkCmdBindVertexBuffers2(
+            handle(),
+            first_binding,
+            (uint32_t)vk_buffers.size(),
+            vk_buffers.data(),
+            offsets.data(),
+            sizes.empty() ? nullptr : sizes.data(),
+            strides.empty() ? nullptr : strides.data()
+        );
+    }
+
+    void CommandBuffer::set_depth_test_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthTestEnable,
+            "set depth test enable"
+        );
+        dispatch().vkCmdSetDepthTestEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_depth_write_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthWriteEnable,
+            "set depth write enable"
+        );
+        dispatch().vkCmdSetDepthWriteEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_depth_compare_op(VkCompareOp compare_op)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthCompareOp,
+            "set depth compare op"
+        );
+        dispatch().vkCmdSetDepthCompareOp(handle(), compare_op);
+    }
+
+    void CommandBuffer::set_depth_bounds_test_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthBoundsTestEnable,
+            "set depth bounds test enable"
+        );
+        dispatch().vkCmdSetDepthBoundsTestEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_stencil_test_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetStencilTestEnable,
+            "set stencil test enable"
+        );
+        dispatch().vkCmdSetStencilTestEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_stencil_op(
+        VkStencilFaceFlags face_mask,
+        VkStencilOp fail_op,
+        VkStencilOp pass_op,
+        VkStencilOp depth_fail_op,
+        VkCompareOp compare_op
+    )
+    {
+        check_command_loaded(dispatch().vkCmdSetStencilOp, "set stencil op");
+        dispatch().vkCmdSetStencilOp(
+            handle(),
+            face_mask,
+            fail_op,
+            pass_op,
+            depth_fail_op,
+            compare_op
+        );
+    }
+
+    void CommandBuffer::set_rasterizer_discard_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetRasterizerDiscardEnable,
+            "set rasterizer discard enable"
+        );
+        dispatch().vkCmdSetRasterizerDiscardEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_depth_bias_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthBiasEnable,
+            "set depth bias enable"
+        );
+        dispatch().vkCmdSetDepthBiasEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_primitive_restart_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetPrimitiveRestartEnable,
+            "set primitive restart enable"
+        );
+        dispatch().vkCmdSetPrimitiveRestartEnable(handle(), enable);
+    }
+
+    void CommandBuffer::set_logic_op(VkLogicOp logic_op)
+    {
+        check_command_loaded(dispatch().vkCmdSetLogicOpEXT, "set logic op");
+        dispatch().vkCmdSetLogicOpEXT(handle(), logic_op);
+    }
+
+    void CommandBuffer::set_patch_control_points(uint32_t patch_control_points)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetPatchControlPointsEXT,
+            "set patch control points"
+        );
+        dispatch().vkCmdSetPatchControlPointsEXT(
+            handle(),
+            patch_control_points
+        );
+    }
+
+    void CommandBuffer::set_depth_clamp_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetDepthClampEnableEXT,
+            "set depth clamp enable"
+        );
+        dispatch().vkCmdSetDepthClampEnableEXT(handle(), enable);
+    }
+
+    void CommandBuffer::set_polygon_mode(VkPolygonMode polygon_mode)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetPolygonModeEXT,
+            "set polygon mode"
+        );
+        dispatch().vkCmdSetPolygonModeEXT(handle(), polygon_mode);
+    }
+
+    void CommandBuffer::set_rasterization_samples(
+        VkSampleCountFlagBits samples
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetRasterizationSamplesEXT,
+            "set rasterization samples"
+        );
+        dispatch().vkCmdSetRasterizationSamplesEXT(handle(), samples);
+    }
+
+    void CommandBuffer::set_sample_mask(
+        VkSampleCountFlagBits samples,
+        const std::vector<VkSampleMask>& sample_mask
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetSampleMaskEXT,
+            "set sample mask"
+        );
+        dispatch().vkCmdSetSampleMaskEXT(
+            handle(),
+            samples,
+            sample_mask.data()
+        );
+    }
+
+    void CommandBuffer::set_alpha_to_coverage_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetAlphaToCoverageEnableEXT,
+            "set alpha to coverage enable"
+        );
+        dispatch().vkCmdSetAlphaToCoverageEnableEXT(handle(), enable);
+    }
+
+    void CommandBuffer::set_alpha_to_one_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetAlphaToOneEnableEXT,
+            "set alpha to one enable"
+        );
+        dispatch().vkCmdSetAlphaToOneEnableEXT(handle(), enable);
+    }
+
+    void CommandBuffer::set_logic_op_enable(bool enable)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetLogicOpEnableEXT,
+            "set logic op enable"
+        );
+        dispatch().vkCmdSetLogicOpEnableEXT(handle(), enable);
+    }
+
+    void CommandBuffer::set_color_blend_enable(
+        uint32_t first_attachment,
+        const std::vector<bool>& enables
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetColorBlendEnableEXT,
+            "set color blend enable"
+        );
+
+        std::vector<VkBool32> vk_enables(enables.begin(), enables.end());
+        dispatch().vkCmdSetColorBlendEnableEXT(
+            handle(),
+            first_attachment,
+            (uint32_t)vk_enables.size(),
+            vk_enables.data()
+        );
+    }
+
+    void CommandBuffer::set_color_blend_equation(
+        uint32_t first_attachment,
+        const std::vector<ColorBlendEquation>& equations
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetColorBlendEquationEXT,
+            "set color blend equation"
+        );
+
+        std::vector<VkColorBlendEquationEXT> vk_equations(equations.size());
+        for (size_t i = 0; i < equations.size(); i++)
+        {
+            vk_equations[i] = ColorBlendEquation_to_vk(equations[i]);
+        }
+        dispatch().vkCmdSetColorBlendEquationEXT(
+            handle(),
+            first_attachment,
+            (uint32_t)vk_equations.size(),
+            vk_equations.data()
+        );
+    }
+
+    void CommandBuffer::set_color_write_mask(
+        uint32_t first_attachment,
+        const std::vector<VkColorComponentFlags>& masks
+    )
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetColorWriteMaskEXT,
+            "set color write mask"
+        );
+        dispatch().vkCmdSetColorWriteMaskEXT(
+            handle(),
+            first_attachment,
+            (uint32_t)masks.size(),
+            masks.data()
+        );
+    }
+
+    void CommandBuffer::set_vertex_input(const VertexInputState& state)
+    {
+        check_command_loaded(
+            dispatch().vkCmdSetVertexInputEXT,
+            "set vertex input"
+        );
+
+        std::vector<VkVertexInputBindingDescription2EXT> vk_bindings(
+            state.binding_descriptions.size()
+        );
+        for (size_t i = 0; i < state.binding_descriptions.size(); i++)
+        {
+            const auto& binding = state.binding_descriptions[i];
+            vk_bindings[i] = VkVertexInputBindingDescription2EXT{
+                .sType =
+                VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT,
+
+                .pNext = nullptr,
+                .binding = binding.binding,
+                .stride = binding.stride,
+                .inputRate = binding.input_rate,
+                .divisor = 1
+            };
+        }
+
+        std::vector<VkVertexInputAttributeDescription2EXT> vk_attributes(
+            state.attribute_descriptions.size()
+        );
+        for (size_t i = 0; i < state.attribute_descriptions.size(); i++)
+        {
+            const auto& attribute = state.attribute_descriptions[i];
+            vk_attributes[i] = VkVertexInputAttributeDescription2EXT{
+                .sType =
+                VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT,
+
+                .pNext = nullptr,
+                .location = attribute.location,
+                .binding = attribute.binding,
+                .format = attribute.format,
+                .offset = attribute.offset
+            };
+        }
+
+        dispatch().vkCmdSetVertexInputEXT(
+            handle(),
+            (uint32_t)vk_bindings.size(),
+            vk_bindings.data(),
+            (uint32_t)vk_attributes.size(),
+            vk_attributes.data()
+        );
+    }
+
+    CommandBuffer::~CommandBuffer()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(pool(), pool_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            pool_locked->device(),
+            device_locked
+        );
+
+        device_locked->dispatch().vkFreeCommandBuffers(
+            device_locked->handle(),
+            pool_locked->handle(),
+            1,
+            &_handle
+        );
+    }
+
+    CommandBuffer::CommandBuffer(
+        const CommandPoolWPtr& pool,
+        VkCommandBuffer handle,
+        const std::shared_ptr<const DeviceDispatch>& dispatch
+    )
+        : _pool(pool),
+        _handle(handle),
+        _dispatch(dispatch)
+    {}
+
+    CommandPoolPtr CommandPool::create(
+        const DevicePtr& device,
+        const CommandPoolConfig& config
+    )
+    {
+        try
+        {
+            CommandPoolPtr pool = std::make_shared<CommandPool_public_ctor>(
+                device,
+                config
+            );
+
+            VkCommandPoolCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = pool->config().flags,
+                .queueFamilyIndex = pool->config().queue_family_index
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateCommandPool(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &pool->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return pool;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create command pool: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    CommandBufferPtr CommandPool::allocate_buffer(
+        const CommandPoolPtr& pool,
+        VkCommandBufferLevel level
+    )
+    {
+        try
+        {
+            VkCommandBufferAllocateInfo alloc_info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .commandPool = pool->handle(),
+                .level = level,
+                .commandBufferCount = 1
+            };
+
+            VkCommandBuffer vk_command_buffer;
+            auto device_locked = lock_wptr(pool->device());
+            VkResult vk_result =
+                device_locked->dispatch().vkAllocateCommandBuffers(
+                    device_locked->handle(),
+                    &alloc_info,
+                    &vk_command_buffer
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return std::make_shared<CommandBuffer_public_ctor>(
+                pool,
+                vk_command_buffer,
+                device_locked->dispatch_ptr()
+            );
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to allocate command buffer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    std::vector<CommandBufferPtr> CommandPool::allocate_buffers(
+        const CommandPoolPtr& pool,
+        VkCommandBufferLevel level,
+        uint32_t count
+    )
+    {
+        if (count < 1)
+        {
+            return {};
+        }
+
+        try
+        {
+            VkCommandBufferAllocateInfo alloc_info{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .commandPool = pool->handle(),
+                .level = level,
+                .commandBufferCount = count
+            };
+
+            std::vector<VkCommandBuffer> vk_command_buffers(count);
+            auto device_locked = lock_wptr(pool->device());
+            VkResult vk_result =
+                device_locked->dispatch().vkAllocateCommandBuffers(
+                    device_locked->handle(),
+                    &alloc_info,
+                    vk_command_buffers.data()
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<CommandBufferPtr> command_buffers(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                command_buffers[i] =
+                    std::make_shared<CommandBuffer_public_ctor>(
+                        pool,
+                        vk_command_buffers[i],
+                        device_locked->dispatch_ptr()
+                    );
+            }
+            return command_buffers;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to allocate command buffer(s): " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    CommandPool::~CommandPool()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyCommandPool(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    CommandPool::CommandPool(
+        const DevicePtr& device,
+        const CommandPoolConfig& config
+    )
+        : _device(device), _config(config)
+    {}
+
+    SemaphorePtr Semaphore::create(const DevicePtr& device)
+    {
+        try
+        {
+            SemaphorePtr sema = std::make_shared<Semaphore_public_ctor>(device);
+
+            VkSemaphoreCreateInfo  create_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateSemaphore(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &sema->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return sema;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create semaphore: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Semaphore::~Semaphore()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroySemaphore(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Semaphore::Semaphore(const DevicePtr& device)
+        : _device(device)
+    {}
+
+    TimelineSemaphorePtr TimelineSemaphore::create(
+        const DevicePtr& device,
+        uint64_t initial_value
+    )
+    {
+        try
+        {
+            TimelineSemaphorePtr sema =
+                std::make_shared<TimelineSemaphore_public_ctor>(device);
+
+            VkSemaphoreTypeCreateInfo type_create_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .pNext = nullptr,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                .initialValue = initial_value
+            };
+
+            VkSemaphoreCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = &type_create_info,
+                .flags = 0
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateSemaphore(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &sema->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return sema;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create timeline semaphore: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    uint64_t TimelineSemaphore::counter_value() const
+    {
+        try
+        {
+            uint64_t value = 0;
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = GetSemaphoreCounterValueKHR(
+                device_locked->dispatch(),
+                device_locked->handle(),
+                handle(),
+                &value
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return value;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to get timeline semaphore counter value: "
+                + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void TimelineSemaphore::signal(uint64_t value)
+    {
+        try
+        {
+            VkSemaphoreSignalInfo signal_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+                .pNext = nullptr,
+                .semaphore = handle(),
+                .value = value
+            };
+
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = SignalSemaphoreKHR(
+                device_locked->dispatch(),
+                device_locked->handle(),
+                &signal_info
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to signal timeline semaphore: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void TimelineSemaphore::wait(
+        uint64_t value,
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        StallTimer stall_timer(
+            "TimelineSemaphore::wait",
+            location,
+            _stall_counter
+        );
+
+        try
+        {
+            VkSemaphoreWaitInfo wait_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .semaphoreCount = 1,
+                .pSemaphores = &_handle,
+                .pValues = &value
+            };
+
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = WaitSemaphoresKHR(
+                device_locked->dispatch(),
+                device_locked->handle(),
+                &wait_info,
+                timeout
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to wait for timeline semaphore: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void TimelineSemaphore::wait_multiple(
+        const std::vector<TimelineSemaphorePtr>& semaphores,
+        const std::vector<uint64_t>& values,
+        bool wait_all,
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        if (semaphores.empty())
+        {
+            return;
+        }
+
+        // reused by the calling thread so that waiting doesn't allocate
+        thread_local std::vector<StallCounter*> stall_counters;
+        stall_counters.clear();
+        if (stall_tracking_enabled())
+        {
+            for (const auto& semaphore : semaphores)
+            {
+                stall_counters.push_back(&semaphore->_stall_counter);
+            }
+        }
+        StallTimer stall_timer(
+            "TimelineSemaphore::wait_multiple",
+            location,
+            stall_counters
+        );
+
+        try
+        {
+            if (values.size() != semaphores.size())
+            {
+                throw Error(
+                    "there should be the same number of values as the number "
+                    "of semaphores"
+                );
+            }
+
+            thread_local std::vector<VkSemaphore> vk_semaphores;
+            vk_semaphores.resize(semaphores.size());
+            for (size_t i = 0; i < semaphores.size(); i++)
+            {
+                vk_semaphores[i] = semaphores[i]->handle();
+            }
+
+            VkSemaphoreWaitInfo wait_info{
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext = nullptr,
+                .flags = (VkSemaphoreWaitFlags)(
+                    wait_all ? 0 : VK_SEMAPHORE_WAIT_ANY_BIT
+                ),
+                .semaphoreCount = (uint32_t)vk_semaphores.size(),
+                .pSemaphores = vk_semaphores.data(),
+                .pValues = values.data()
+            };
+
+            auto device_locked = lock_wptr(semaphores[0]->device());
+            VkResult vk_result = WaitSemaphoresKHR(
+                device_locked->dispatch(),
+                device_locked->handle(),
+                &wait_info,
+                timeout
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to wait for timeline semaphores: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    TimelineSemaphore::TimelineSemaphore(const DevicePtr& device)
+        : Semaphore(device)
+    {}
+
+    FramePacerPtr FramePacer::create(
+        const DevicePtr& device,
+        uint32_t frames_in_flight
+    )
+    {
+        try
+        {
+            if (frames_in_flight < 1)
+            {
+                throw Error("there should be at least one frame in flight");
+            }
+
+            return std::make_shared<FramePacer_public_ctor>(
+                frames_in_flight,
+                TimelineSemaphore::create(device, 0)
+            );
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create frame pacer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    uint32_t FramePacer::begin_frame(
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        // frame N signals N + 1, so frame N - frames_in_flight is done when
+        // the timeline reaches N - frames_in_flight + 1
+        if (_frame_number >= _frames_in_flight)
+        {
+            _timeline->wait(
+                _frame_number - _frames_in_flight + 1,
+                timeout,
+                location
+            );
+        }
+        return frame_idx();
+    }
+
+    void FramePacer::end_frame()
+    {
+        _frame_number++;
+    }
+
+    void FramePacer::wait_all(
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        if (_frame_number > 0)
+        {
+            _timeline->wait(_frame_number, timeout, location);
+        }
+    }
+
+    FramePacer::FramePacer(
+        uint32_t frames_in_flight,
+        const TimelineSemaphorePtr& timeline
+    )
+        : _frames_in_flight(frames_in_flight),
+        _timeline(timeline)
+    {}
+
+    FencePtr Fence::create(
+        const DevicePtr& device,
+        VkFenceCreateFlags flags
+    )
+    {
+        try
+        {
+            FencePtr fence = std::make_shared<Fence_public_ctor>(device);
+
+            VkFenceCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = flags
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateFence(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &fence->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return fence;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create fence: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Fence::wait(uint64_t timeout, const std::source_location& location)
+    {
+        VkResult vk_result = try_wait(timeout, location);
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error(
+                "failed to wait for fence to become signaled",
+                vk_result,
+                false
+            );
+        }
+    }
+
+    VkResult Fence::try_wait(
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        BV_TRACE_ZONE("bv::Fence::wait");
+        StallTimer stall_timer("Fence::wait", location, _stall_counter);
+
+        // a destroyed device is a bug in the caller, not a result to handle
+        auto device_locked = device().lock();
+        if (device_locked == nullptr)
+        {
+            throw Error(
+                "failed to wait for fence to become signaled: device has "
+                "been destroyed"
+            );
+        }
+
+        return device_locked->dispatch().vkWaitForFences(
+            device_locked->handle(),
+            1,
+            &_handle,
+            VK_TRUE,
+            timeout
+        );
+    }
+
+    void Fence::wait_multiple(
+        const std::vector<FencePtr>& fences,
+        bool wait_all,
+        uint64_t timeout,
+        const std::source_location& location
+    )
+    {
+        BV_TRACE_ZONE("bv::Fence::wait_multiple");
+
+        if (fences.empty())
+        {
+            return;
+        }
+
+        // reused by the calling thread so that waiting doesn't allocate
+        thread_local std::vector<StallCounter*> stall_counters;
+        stall_counters.clear();
+        if (stall_tracking_enabled())
+        {
+            for (const auto& fence : fences)
+            {
+                stall_counters.push_back(&fence->_stall_counter);
+            }
+        }
+        StallTimer stall_timer(
+            "Fence::wait_multiple",
+            location,
+            stall_counters
+        );
+
+        try
+        {
+            thread_local std::vector<VkFence> vk_fences;
+            vk_fences.resize(fences.size());
+            for (size_t i = 0; i < fences.size(); i++)
+            {
+                vk_fences[i] = fences[i]->handle();
+            }
+
+            auto device_locked = lock_wptr(fences[0]->device());
+            VkResult vk_result = device_locked->dispatch().vkWaitForFences(
+                device_locked->handle(),
+                (uint32_t)vk_fences.size(),
+                vk_fences.data(),
+                wait_all,
+                timeout
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to wait for fence(s) to become signaled: "
+                + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Fence::reset()
+    {
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = device_locked->dispatch().vkResetFences(
+                device_locked->handle(),
+                1,
+                &_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to reset fence: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    bool Fence::is_signaled() const
+    {
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = device_locked->dispatch().vkGetFenceStatus(
+                device_locked->handle(),
+                handle()
+            );
+            if (vk_result == VK_SUCCESS)
+            {
+                return true;
+            }
+            else if (vk_result == VK_NOT_READY)
+            {
+                return false;
+            }
+            throw Error(vk_result);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to get fence status: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Fence::~Fence()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyFence(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Fence::Fence(const DevicePtr& device)
+        : _device(device)
+    {}
+
+    BufferPtr Buffer::create(
+        const DevicePtr& device,
+        const BufferConfig& config
+    )
+    {
+        try
+        {
+            BufferPtr buf = std::make_shared<Buffer_public_ctor>(
+                device,
+                config
+            );
+
+            VkBufferCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = buf->config().flags,
+                .size = buf->config().size,
+                .usage = buf->config().usage,
+                .sharingMode = buf->config().sharing_mode,
+
+                .queueFamilyIndexCount =
+                (uint32_t)buf->config().queue_family_indices.size(),
+
+                .pQueueFamilyIndices = buf->config().queue_family_indices.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateBuffer(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &buf->_handle
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            VkMemoryRequirements vk_mem_requirements;
+            device->dispatch().vkGetBufferMemoryRequirements(
+                device->handle(),
+                buf->handle(),
+                &vk_mem_requirements
+            );
+            buf->_memory_requirements = MemoryRequirements_from_vk(
+                vk_mem_requirements
+            );
+
+            return buf;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to create buffer: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void Buffer::bind_memory(
+        const DeviceMemoryPtr& memory,
+        VkDeviceSize memory_offset
     )
-        : message(std::move(message)),
-        _vk_result(vk_result),
-        stringify_vk_result(!vk_result_already_embedded_in_message)
+    {
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = device_locked->dispatch().vkBindBufferMemory(
+                device_locked->handle(),
+                handle(),
+                memory->handle(),
+                memory_offset
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to bind buffer memory: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    Buffer::~Buffer()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyBuffer(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    Buffer::Buffer(const DevicePtr& device, const BufferConfig& config)
+        : _device(device), _config(config)
     {}
 
-    std::string Error::to_string() const
+    DeviceMemoryPtr DeviceMemory::allocate(
+        const DevicePtr& device,
+        const DeviceMemoryConfig& config
+    )
     {
-        std::string s = message;
-        if (vk_result().has_value() && stringify_vk_result)
+        try
         {
-            if (!message.empty())
+            DeviceMemoryPtr mem = std::make_shared<DeviceMemory_public_ctor>(
+                device,
+                config
+            );
+
+            VkMemoryAllocateInfo allocate_info{
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .allocationSize = mem->config().allocation_size,
+                .memoryTypeIndex = mem->config().memory_type_index
+            };
+
+            VkResult vk_result = device->dispatch().vkAllocateMemory(
+                device->handle(),
+                &allocate_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &mem->_handle
+            );
+            if (vk_result != VK_SUCCESS)
             {
-                s += ": ";
+                throw Error(vk_result);
             }
-            s += VkResult_to_string(vk_result().value());
+            return mem;
         }
-        return s;
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to allocate device memory: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void* DeviceMemory::map(VkDeviceSize offset, VkDeviceSize size)
+    {
+        try
+        {
+            void* p;
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = device_locked->dispatch().vkMapMemory(
+                device_locked->handle(),
+                handle(),
+                offset,
+                size,
+                0,
+                &p
+            );
+            if (vk_result != VK_SUCCESS)
+            {
+                unmap();
+                throw Error(vk_result);
+            }
+            return p;
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to map device memory: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void DeviceMemory::unmap()
+    {
+        if (device().expired())
+        {
+            return;
+        }
+        auto device_locked = lock_wptr(device());
+        device_locked->dispatch().vkUnmapMemory(
+            device_locked->handle(),
+            handle()
+        );
+    }
+
+    void DeviceMemory::flush_mapped_range(
+        VkDeviceSize offset,
+        VkDeviceSize size
+    )
+    {
+        try
+        {
+            VkMappedMemoryRange vk_mapped_range{
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .pNext = nullptr,
+                .memory = handle(),
+                .offset = offset,
+                .size = size
+            };
+
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result =
+                device_locked->dispatch().vkFlushMappedMemoryRanges(
+                    device_locked->handle(),
+                    1,
+                    &vk_mapped_range
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to flush mapped device memory range: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void DeviceMemory::invalidate_mapped_range(
+        VkDeviceSize offset,
+        VkDeviceSize size
+    )
+    {
+        try
+        {
+            VkMappedMemoryRange vk_mapped_range{
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .pNext = nullptr,
+                .memory = handle(),
+                .offset = offset,
+                .size = size
+            };
+
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result =
+                device_locked->dispatch().vkInvalidateMappedMemoryRanges(
+                    device_locked->handle(),
+                    1,
+                    &vk_mapped_range
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to invalidate mapped device memory range: "
+                + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    void DeviceMemory::upload(void* data, VkDeviceSize data_size)
+    {
+        try
+        {
+            if (data_size > config().allocation_size)
+            {
+                throw Error("data is too big");
+            }
+
+            void* mapped = map(0, config().allocation_size);
+            std::copy(
+                (uint8_t*)data,
+                (uint8_t*)data + data_size,
+                (uint8_t*)mapped
+            );
+            flush_mapped_range(0, VK_WHOLE_SIZE);
+            unmap();
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to upload data to device memory: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
+    }
+
+    DeviceMemory::~DeviceMemory()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkFreeMemory(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
     }
 
-#pragma endregion
+    DeviceMemory::DeviceMemory(
+        const DevicePtr& device,
+        const DeviceMemoryConfig& config
+    )
+        : _device(device), _config(config)
+    {}
+
+    void DescriptorSet::update_sets(
+        const DevicePtr& device,
+        const std::vector<WriteDescriptorSet>& writes,
+        const std::vector<CopyDescriptorSet>& copies
+    )
+    {
+        BV_TRACE_ZONE("bv::DescriptorSet::update_sets");
 
-#pragma region classes and object wrappers
+        if (writes.empty() && copies.empty())
+        {
+            return;
+        }
 
-    std::vector<ExtensionProperties> PhysicalDevice::fetch_available_extensions(
-        const std::string& layer_name
-    ) const
-    {
         try
         {
-            const char* layer_name_cstr = nullptr;
-            if (!layer_name.empty())
+            std::vector<VkWriteDescriptorSet> vk_writes(writes.size());
+            std::vector<std::vector<VkDescriptorImageInfo>>
+                wastes_vk_image_infos(writes.size());
+            std::vector<std::vector<VkDescriptorBufferInfo>>
+                wastes_vk_buffer_infos(writes.size());
+            std::vector<std::vector<VkBufferView>>
+                wastes_vk_texel_buffer_views(writes.size());
+            for (size_t i = 0; i < writes.size(); i++)
             {
-                layer_name_cstr = layer_name.c_str();
+                vk_writes[i] = WriteDescriptorSet_to_vk(
+                    writes[i],
+                    wastes_vk_image_infos[i],
+                    wastes_vk_buffer_infos[i],
+                    wastes_vk_texel_buffer_views[i]
+                );
             }
 
-            uint32_t count = 0;
-            vkEnumerateDeviceExtensionProperties(
-                handle(),
-                layer_name_cstr,
-                &count,
-                nullptr
-            );
-
-            std::vector<VkExtensionProperties> vk_extensions(count);
-            VkResult vk_result = vkEnumerateDeviceExtensionProperties(
-                handle(),
-                layer_name_cstr,
-                &count,
-                vk_extensions.data()
-            );
-            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            std::vector<VkCopyDescriptorSet> vk_copies(copies.size());
+            for (size_t i = 0; i < copies.size(); i++)
             {
-                throw Error(vk_result);
+                vk_copies[i] = CopyDescriptorSet_to_vk(copies[i]);
             }
 
-            std::vector<ExtensionProperties> extensions;
-            extensions.reserve(vk_extensions.size());
-            for (const auto& vk_ext : vk_extensions)
-            {
-                extensions.push_back(ExtensionProperties_from_vk(vk_ext));
-            }
-            return extensions;
+            device->dispatch().vkUpdateDescriptorSets(
+                device->handle(),
+                (uint32_t)vk_writes.size(),
+                vk_writes.data(),
+                (uint32_t)vk_copies.size(),
+                vk_copies.data()
+            );
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to fetch available device extensions: " + e.to_string(),
+                "failed to update descriptor sets: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    FormatProperties PhysicalDevice::fetch_format_properties(
-        VkFormat format
-    ) const
+    DescriptorSet::~DescriptorSet()
     {
-        VkFormatProperties vk_properties;
-        vkGetPhysicalDeviceFormatProperties(
-            handle(),
-            format,
-            &vk_properties
+        _BV_LOCK_WPTR_OR_RETURN(pool(), pool_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            pool_locked->device(),
+            device_locked
+        );
+
+        device_locked->dispatch().vkFreeDescriptorSets(
+            device_locked->handle(),
+            pool_locked->handle(),
+            1,
+            &_handle
         );
-        return FormatProperties_from_vk(vk_properties);
     }
 
-    std::optional<VkFormat> PhysicalDevice::find_supported_image_format(
-        const std::vector<VkFormat>& candidates,
-        VkImageTiling tiling,
-        VkFormatFeatureFlags features
-    ) const
+    DescriptorSet::DescriptorSet(
+        const DescriptorPoolPtr& pool,
+        VkDescriptorSet handle
+    )
+        : _pool(pool), _handle(handle)
+    {}
+
+    DescriptorPoolPtr DescriptorPool::create(
+        const DevicePtr& device,
+        const DescriptorPoolConfig& config
+    )
     {
-        for (VkFormat format : candidates)
+        try
         {
-            auto props = fetch_format_properties(format);
-            if (tiling == VK_IMAGE_TILING_LINEAR
-                && (props.linear_tiling_features & features) == features)
-            {
-                return format;
-            }
-            else if (tiling == VK_IMAGE_TILING_OPTIMAL
-                && (props.optimal_tiling_features & features) == features)
+            DescriptorPoolPtr pool =
+                std::make_shared<DescriptorPool_public_ctor>(
+                    device,
+                    config
+                );
+
+            std::vector<VkDescriptorPoolSize> vk_pool_sizes(
+                pool->config().pool_sizes.size()
+            );
+            for (size_t i = 0; i < pool->config().pool_sizes.size(); i++)
             {
-                return format;
+                vk_pool_sizes[i] = DescriptorPoolSize_to_vk(
+                    pool->config().pool_sizes[i]
+                );
             }
-        }
-        return std::nullopt;
-    }
 
-    ImageFormatProperties PhysicalDevice::fetch_image_format_properties(
-        VkFormat format,
-        VkImageType type,
-        VkImageTiling tiling,
-        VkImageUsageFlags usage,
-        VkImageCreateFlags flags
-    ) const
-    {
-        try
-        {
-            VkImageFormatProperties vk_properties;
-            VkResult vk_result = vkGetPhysicalDeviceImageFormatProperties(
-                handle(),
-                format,
-                type,
-                tiling,
-                usage,
-                flags,
-                &vk_properties
+            VkDescriptorPoolCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = pool->config().flags,
+                .maxSets = pool->config().max_sets,
+                .poolSizeCount = (uint32_t)vk_pool_sizes.size(),
+                .pPoolSizes = vk_pool_sizes.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreateDescriptorPool(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &pool->_handle
             );
             if (vk_result != VK_SUCCESS)
             {
                 throw Error(vk_result);
             }
-            return ImageFormatProperties_from_vk(vk_properties);
+            return pool;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to fetch image format properties: " + e.to_string(),
+                "failed to create descriptor pool: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::optional<SwapchainSupport> PhysicalDevice::fetch_swapchain_support(
-        const SurfacePtr& surface
-    ) const
+    DescriptorSetPtr DescriptorPool::allocate_set(
+        const DescriptorPoolPtr& pool,
+        const DescriptorSetLayoutPtr& set_layout
+    )
     {
-        if (surface == nullptr)
-        {
-            return std::nullopt;
-        }
-
         try
         {
-            // check for extension
-            auto available_extensions = fetch_available_extensions();
-            bool has_extension = false;
-            for (const auto& ext : available_extensions)
-            {
-                if (ext.name == VK_KHR_SWAPCHAIN_EXTENSION_NAME)
-                {
-                    has_extension = true;
-                    break;
-                }
-            }
-            if (!has_extension)
-            {
-                return std::nullopt;
-            }
-
-            VkSurfaceCapabilitiesKHR vk_capabilities;
-            VkResult vk_result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
-                handle(),
-                surface->handle(),
-                &vk_capabilities
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(
-                    "failed to get physical device surface capabilities",
-                    vk_result,
-                    false
-                );
-            }
-
-            std::vector<SurfaceFormat> surface_formats;
-            {
-                uint32_t surface_format_count;
-                vkGetPhysicalDeviceSurfaceFormatsKHR(
-                    handle(),
-                    surface->handle(),
-                    &surface_format_count,
-                    nullptr
-                );
-
-                std::vector<VkSurfaceFormatKHR> vk_surface_formats(
-                    surface_format_count
-                );
-                vk_result = vkGetPhysicalDeviceSurfaceFormatsKHR(
-                    handle(),
-                    surface->handle(),
-                    &surface_format_count,
-                    vk_surface_formats.data()
-                );
-                if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
-                {
-                    throw Error(
-                        "failed to get physical device surface formats",
-                        vk_result,
-                        false
-                    );
-                }
-
-                surface_formats.reserve(vk_surface_formats.size());
-                for (const auto& vk_surface_format : vk_surface_formats)
-                {
-                    surface_formats.push_back(
-                        SurfaceFormat_from_vk(vk_surface_format)
-                    );
-                }
-            }
-
-            std::vector<VkPresentModeKHR> present_modes;
-            {
-                uint32_t present_mode_count;
-                vkGetPhysicalDeviceSurfacePresentModesKHR(
-                    handle(),
-                    surface->handle(),
-                    &present_mode_count,
-                    nullptr
-                );
-
-                present_modes.resize(present_mode_count);
-                vk_result = vkGetPhysicalDeviceSurfacePresentModesKHR(
-                    handle(),
-                    surface->handle(),
-                    &present_mode_count,
-                    present_modes.data()
-                );
-                if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
-                {
-                    throw Error(
-                        "failed to get physical device surface present modes",
-                        vk_result,
-                        false
-                    );
-                }
-            }
+            VkDescriptorSetLayout vk_set_layout = set_layout->handle();
 
-            return SwapchainSupport{
-                .capabilities = SurfaceCapabilities_from_vk(vk_capabilities),
-                .surface_formats = surface_formats,
-                .present_modes = present_modes
+            VkDescriptorSetAllocateInfo alloc_info{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .descriptorPool = pool->handle(),
+                .descriptorSetCount = 1,
+                .pSetLayouts = &vk_set_layout
             };
+
+            VkDescriptorSet vk_set;
+            auto device_locked = lock_wptr(pool->device());
+            VkResult vk_result =
+                device_locked->dispatch().vkAllocateDescriptorSets(
+                    device_locked->handle(),
+                    &alloc_info,
+                    &vk_set
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+            return std::make_shared<DescriptorSet_public_ctor>(
+                pool,
+                vk_set
+            );
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to fetch swapchain support details: " + e.to_string(),
+                "failed to allocate descriptor set: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::vector<uint32_t> PhysicalDevice::find_queue_family_indices(
-        VkQueueFlags must_support,
-        VkQueueFlags must_not_support,
-        const SurfacePtr& must_support_surface,
-        uint32_t min_queue_count
-    ) const
+    std::vector<DescriptorSetPtr> DescriptorPool::allocate_sets(
+        const DescriptorPoolPtr& pool,
+        uint32_t count,
+        const std::vector<DescriptorSetLayoutPtr>& set_layouts
+    )
     {
         try
         {
-            std::vector<uint32_t> indices;
-            for (size_t i = 0; i < queue_families().size(); i++)
+            if (count != set_layouts.size())
             {
-                const auto& fam = queue_families()[i];
-                if ((fam.queue_flags & must_support) != must_support)
-                {
-                    continue;
-                }
-                if ((fam.queue_flags & must_not_support) != 0)
-                {
-                    continue;
-                }
-                if (must_support_surface != nullptr)
-                {
-                    VkBool32 vk_surface_support = VK_FALSE;
-                    VkResult vk_result = vkGetPhysicalDeviceSurfaceSupportKHR(
-                        handle(),
-                        (uint32_t)i,
-                        must_support_surface->handle(),
-                        &vk_surface_support
-                    );
-                    if (vk_result != VK_SUCCESS)
-                    {
-                        throw Error(
-                            "failed to check physical device's surface support",
-                            vk_result,
-                            false
-                        );
-                    }
+                throw Error(
+                    "there should be the same number of descriptor set layouts "
+                    "as the number of sets to create"
+                );
+            }
 
-                    if (!vk_surface_support)
-                    {
-                        continue;
-                    }
-                }
-                if (min_queue_count > 0 && fam.queue_count < min_queue_count)
-                {
-                    continue;
-                }
+            if (count < 1)
+            {
+                return {};
+            }
 
-                indices.push_back(i);
+            std::vector<VkDescriptorSetLayout>vk_set_layouts(
+                set_layouts.size()
+            );
+            for (size_t i = 0; i < set_layouts.size(); i++)
+            {
+                vk_set_layouts[i] = set_layouts[i]->handle();
             }
-            return indices;
+
+            VkDescriptorSetAllocateInfo alloc_info{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .pNext = nullptr,
+                .descriptorPool = pool->handle(),
+                .descriptorSetCount = count,
+                .pSetLayouts = vk_set_layouts.data()
+            };
+
+            std::vector<VkDescriptorSet> vk_sets(count);
+            auto device_locked = lock_wptr(pool->device());
+            VkResult vk_result =
+                device_locked->dispatch().vkAllocateDescriptorSets(
+                    device_locked->handle(),
+                    &alloc_info,
+                    vk_sets.data()
+                );
+            if (vk_result != VK_SUCCESS)
+            {
+                throw Error(vk_result);
+            }
+
+            std::vector<DescriptorSetPtr> sets(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                sets[i] = std::make_shared<DescriptorSet_public_ctor>(
+                    pool,
+                    vk_sets[i]
+                );
+            }
+            return sets;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to find queue family indices: " + e.to_string(),
+                "failed to allocate descriptor set(s): " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    uint32_t PhysicalDevice::find_first_queue_family_index(
-        VkQueueFlags must_support,
-        VkQueueFlags must_not_support,
-        const SurfacePtr& must_support_surface,
-        uint32_t min_queue_count
-    ) const
+    DescriptorPool::~DescriptorPool()
     {
-        auto indices = find_queue_family_indices(
-            must_support,
-            must_not_support,
-            must_support_surface,
-            min_queue_count
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyDescriptorPool(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
         );
-        if (indices.empty())
-        {
-            throw Error("no queue family meets the required criteria");
-        }
-        return indices[0];
     }
 
-    PhysicalDevice::PhysicalDevice(
-        VkPhysicalDevice handle,
-        const PhysicalDeviceProperties& properties,
-        const PhysicalDeviceFeatures& features,
-        const PhysicalDeviceMemoryProperties& memory_properties,
-        const std::vector<QueueFamily>& queue_families
+    DescriptorPool::DescriptorPool(
+        const DevicePtr& device,
+        const DescriptorPoolConfig& config
     )
-        : _handle(handle),
-        _properties(properties),
-        _features(features),
-        _memory_properties(memory_properties),
-        _queue_families(queue_families)
+        : _device(device), _config(config)
     {}
 
-    Context::Context(Context&& other) noexcept
-        : _config(std::move(other._config))
-    {
-        _config = other._config;
-        other._config = {};
-
-        _allocator = other._allocator;
-        other._allocator = nullptr;
-
-        _vk_allocator = other._vk_allocator;
-        _vk_allocator.pUserData = _allocator.get();
-        other._vk_allocator = VkAllocationCallbacks{};
-
-        _vk_instance = other._vk_instance;
-        other._vk_instance = nullptr;
-    }
-
-    ContextPtr Context::create(
-        const ContextConfig& config,
-        const AllocatorPtr& allocator
+    BufferViewPtr BufferView::create(
+        const DevicePtr& device,
+        const BufferPtr& buffer,
+        const BufferViewConfig& config
     )
     {
         try
         {
-            ContextPtr c = std::make_shared<Context_public_ctor>(
-                config,
-                allocator
+            BufferViewPtr view = std::make_shared<BufferView_public_ctor>(
+                device,
+                buffer,
+                config
             );
 
-            // allocation callbacks
-            {
-                c->_vk_allocator.pUserData = c->allocator().get();
-                c->_vk_allocator.pfnAllocation = vk_allocation_callback;
-                c->_vk_allocator.pfnReallocation = vk_reallocation_callback;
-                c->_vk_allocator.pfnFree = vk_free_callback;
-                c->_vk_allocator.pfnInternalAllocation =
-                    vk_internal_allocation_notification;
-                c->_vk_allocator.pfnInternalFree =
-                    vk_internal_free_notification;
-            }
-
-            VkInstanceCreateInfo create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-
-            if (c->config().will_enumerate_portability)
-                create_info.flags |=
-                VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-
-            VkApplicationInfo app_info{};
-            {
-                app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-
-                app_info.pApplicationName = c->config().app_name.c_str();
-                app_info.applicationVersion = c->config().app_version.encode();
-
-                app_info.pEngineName = c->config().engine_name.c_str();
-                app_info.engineVersion = c->config().engine_version.encode();
-
-                app_info.apiVersion = VulkanApiVersion_encode(
-                    c->config().vulkan_api_version
-                );
-            }
-            create_info.pApplicationInfo = &app_info;
-
-            std::vector<const char*> layers_cstr;
-            {
-                layers_cstr.reserve(
-                    c->config().layers.size()
-                );
-                for (const auto& layer : c->config().layers)
-                {
-                    layers_cstr.push_back(layer.c_str());
-                }
-
-                create_info.enabledLayerCount =
-                    (uint32_t)layers_cstr.size();
-                create_info.ppEnabledLayerNames =
-                    layers_cstr.data();
-            }
-
-            std::vector<const char*> extensions_cstr;
-            {
-                extensions_cstr.reserve(
-                    c->config().extensions.size()
-                );
-                for (const auto& ext : c->config().extensions)
-                {
-                    extensions_cstr.push_back(ext.c_str());
-                }
-
-                create_info.enabledExtensionCount =
-                    (uint32_t)extensions_cstr.size();
-                create_info.ppEnabledExtensionNames =
-                    extensions_cstr.data();
-            }
+            VkBufferViewCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .buffer = lock_wptr(view->buffer())->handle(),
+                .format = view->config().format,
+                .offset = view->config().offset,
+                .range = view->config().range
+            };
 
-            VkResult vk_result = vkCreateInstance(
+            VkResult vk_result = device->dispatch().vkCreateBufferView(
+                device->handle(),
                 &create_info,
-                c->vk_allocator_ptr(),
-                &c->_vk_instance
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &view->_handle
             );
             if (vk_result != VK_SUCCESS)
             {
                 throw Error(vk_result);
             }
-            return c;
+            return view;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create instance for context: " + e.to_string(),
+                "failed to create buffer view: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::vector<LayerProperties> Context::fetch_available_layers()
+    BufferView::~BufferView()
+    {
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyBufferView(
+            device_locked->handle(),
+            handle(),
+            context_locked->vk_allocator_ptr()
+        );
+    }
+
+    BufferView::BufferView(
+        const DevicePtr& device,
+        const BufferPtr& buffer,
+        const BufferViewConfig& config
+    )
+        : _device(device),
+        _buffer(buffer),
+        _config(config)
+    {}
+
+    PipelineCachePtr PipelineCache::create(
+        const DevicePtr& device,
+        VkPipelineCacheCreateFlags flags,
+        std::span<const uint8_t> initial_data
+    )
     {
         try
         {
-            uint32_t count = 0;
-            vkEnumerateInstanceLayerProperties(
-                &count,
-                nullptr
-            );
+            PipelineCachePtr cache =
+                std::make_shared<PipelineCache_public_ctor>(
+                    device,
+                    flags
+                );
 
-            std::vector<VkLayerProperties> vk_layers(count);
-            VkResult vk_result = vkEnumerateInstanceLayerProperties(
-                &count,
-                vk_layers.data()
+            VkPipelineCacheCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = cache->flags(),
+                .initialDataSize = initial_data.size(),
+                .pInitialData = initial_data.data()
+            };
+
+            VkResult vk_result = device->dispatch().vkCreatePipelineCache(
+                device->handle(),
+                &create_info,
+                lock_wptr(device->context())->vk_allocator_ptr(),
+                &cache->_handle
             );
-            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            if (vk_result != VK_SUCCESS)
             {
                 throw Error(vk_result);
             }
-
-            std::vector<LayerProperties> layers;
-            layers.reserve(vk_layers.size());
-            for (const auto& vk_layer : vk_layers)
-            {
-                layers.push_back(LayerProperties_from_vk(vk_layer));
-            }
-            return layers;
+            return cache;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to fetch available instance layers: " + e.to_string(),
+                "failed to create pipeline cache: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::vector<ExtensionProperties> Context::fetch_available_extensions(
-        const std::string& layer_name
-    )
+    std::vector<uint8_t> PipelineCache::get_cache_data()
     {
         try
         {
-            const char* layer_name_cstr = nullptr;
-            if (!layer_name.empty())
-            {
-                layer_name_cstr = layer_name.c_str();
-            }
+            auto device_locked = lock_wptr(device());
 
-            uint32_t count = 0;
-            vkEnumerateInstanceExtensionProperties(
-                layer_name_cstr,
-                &count,
+            size_t size;
+            device_locked->dispatch().vkGetPipelineCacheData(
+                device_locked->handle(),
+                handle(),
+                &size,
                 nullptr
             );
 
-            std::vector<VkExtensionProperties> vk_extensions(count);
-            VkResult vk_result = vkEnumerateInstanceExtensionProperties(
-                layer_name_cstr,
-                &count,
-                vk_extensions.data()
-            );
+            std::vector<uint8_t> data(size);
+            VkResult vk_result =
+                device_locked->dispatch().vkGetPipelineCacheData(
+                    device_locked->handle(),
+                    handle(),
+                    &size,
+                    data.data()
+                );
             if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
             {
                 throw Error(vk_result);
             }
 
-            std::vector<ExtensionProperties> extensions;
-            extensions.reserve(vk_extensions.size());
-            for (const auto& vk_ext : vk_extensions)
-            {
-                extensions.push_back(ExtensionProperties_from_vk(vk_ext));
-            }
-            return extensions;
+            return data;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to fetch available instance extensions: "
-                + e.to_string(),
+                "failed to get pipeline cache data: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    void Context::set_allocator(const AllocatorPtr& allocator)
+    PipelineCachePtr PipelineCache::load(
+        const DevicePtr& device,
+        const std::string& path,
+        VkPipelineCacheCreateFlags flags
+    )
     {
-        _allocator = allocator;
-        _vk_allocator.pUserData = _allocator.get();
-    }
+        BV_TRACE_ZONE("bv::PipelineCache::load");
 
-    const VkAllocationCallbacks* Context::vk_allocator_ptr() const
-    {
-        if (_allocator == nullptr)
+        MappedFile file(path);
+        std::span<const uint8_t> data = file.data();
+        if (!is_compatible(device->physical_device(), data))
         {
-            return nullptr;
+            data = {};
         }
-        return &_vk_allocator;
+        return create(device, flags, data);
     }
 
-    std::vector<PhysicalDevice> Context::fetch_physical_devices() const
+    bool PipelineCache::is_compatible(
+        const PhysicalDevice& physical_device,
+        std::span<const uint8_t> data
+    )
     {
-        try
-        {
-            uint32_t count = 0;
-            vkEnumeratePhysicalDevices(_vk_instance, &count, nullptr);
-
-            std::vector<VkPhysicalDevice> vk_physical_devices(count);
-            VkResult vk_result = vkEnumeratePhysicalDevices(
-                _vk_instance,
-                &count,
-                vk_physical_devices.data()
-            );
-            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
-            {
-                throw Error(vk_result);
-            }
-
-            std::vector<PhysicalDevice> physical_devices;
-            physical_devices.reserve(vk_physical_devices.size());
-            for (const auto& vk_physical_device : vk_physical_devices)
-            {
-                VkPhysicalDeviceProperties vk_properties;
-                vkGetPhysicalDeviceProperties(
-                    vk_physical_device,
-                    &vk_properties
-                );
-                auto properties = PhysicalDeviceProperties_from_vk(
-                    vk_properties
-                );
-
-                VkPhysicalDeviceFeatures vk_features;
-                vkGetPhysicalDeviceFeatures(vk_physical_device, &vk_features);
-                auto features = PhysicalDeviceFeatures_from_vk(vk_features);
-
-                VkPhysicalDeviceMemoryProperties vk_memory_properties;
-                vkGetPhysicalDeviceMemoryProperties(
-                    vk_physical_device,
-                    &vk_memory_properties
-                );
-                auto memory_properties = PhysicalDeviceMemoryProperties_from_vk(
-                    vk_memory_properties
-                );
-
-                uint32_t queue_family_count = 0;
-                vkGetPhysicalDeviceQueueFamilyProperties(
-                    vk_physical_device,
-                    &queue_family_count,
-                    nullptr
-                );
-
-                std::vector<VkQueueFamilyProperties> vk_queue_families(
-                    queue_family_count
-                );
-                vkGetPhysicalDeviceQueueFamilyProperties(
-                    vk_physical_device,
-                    &queue_family_count,
-                    vk_queue_families.data()
-                );
-
-                std::vector<QueueFamily> queue_families;
-                queue_families.reserve(vk_queue_families.size());
-                for (const auto& vk_family : vk_queue_families)
-                {
-                    queue_families.push_back(QueueFamily_from_vk(vk_family));
-                }
-
-                physical_devices.push_back(PhysicalDevice(
-                    vk_physical_device,
-                    properties,
-                    features,
-                    memory_properties,
-                    queue_families
-                ));
-            }
-
-            return physical_devices;
-
-        }
-        catch (const Error& e)
+        VkPipelineCacheHeaderVersionOne header;
+        if (data.size() < sizeof(header))
         {
-            throw Error(
-                "failed to fetch physical devices: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            return false;
         }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        const auto& properties = physical_device.properties();
+        return header.headerSize >= sizeof(header)
+            && header.headerSize <= data.size()
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == properties.vendor_id
+            && header.deviceID == properties.device_id
+            && std::memcmp(
+                header.pipelineCacheUUID,
+                properties.pipeline_cache_uuid.data(),
+                VK_UUID_SIZE
+            ) == 0;
     }
 
-    Context::~Context()
+    void PipelineCache::save(const std::string& path)
     {
-        vkDestroyInstance(_vk_instance, vk_allocator_ptr());
-    }
-
-    Context::Context(
-        const ContextConfig& config,
-        const AllocatorPtr& allocator
-    )
-        : _config(config), _allocator(allocator)
-    {}
+        BV_TRACE_ZONE("bv::PipelineCache::save");
 
-    DebugMessengerPtr DebugMessenger::create(
-        const ContextPtr& context,
-        VkDebugUtilsMessageSeverityFlagsEXT message_severity_filter,
-        VkDebugUtilsMessageTypeFlagsEXT message_type_filter,
-        const DebugCallback& callback
-    )
-    {
         try
-        {
-            DebugMessengerPtr messenger =
-                std::make_shared<DebugMessenger_public_ctor>(
-                    context,
-                    message_severity_filter,
-                    message_type_filter,
-                    callback
-                );
-
-            VkDebugUtilsMessengerCreateInfoEXT create_info{
-                .sType =
-                VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
-
-                .pNext = nullptr,
-                .flags = 0,
-                .messageSeverity = messenger->message_severity_filter(),
-                .messageType = messenger->message_type_filter(),
-                .pfnUserCallback = vk_debug_callback,
-                .pUserData = messenger.get()
-            };
-
-            VkResult vk_result = CreateDebugUtilsMessengerEXT(
-                context->vk_instance(),
-                &create_info,
-                context->vk_allocator_ptr(),
-                &messenger->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return messenger;
+        {
+            write_file_atomically(path, get_cache_data());
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create debug messenger: " + e.to_string(),
+                "failed to save pipeline cache: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    DebugMessenger::~DebugMessenger()
+    void PipelineCache::merge(const std::vector<PipelineCachePtr>& src_caches)
     {
-        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
-        DestroyDebugUtilsMessengerEXT(
-            context_locked->vk_instance(),
+        auto device_locked = lock_wptr(device());
+
+        std::vector<VkPipelineCache> vk_src_caches(src_caches.size());
+        for (size_t i = 0; i < src_caches.size(); i++)
+        {
+            vk_src_caches[i] = src_caches[i]->handle();
+        }
+
+        VkResult vk_result = device_locked->dispatch().vkMergePipelineCaches(
+            device_locked->handle(),
             handle(),
-            context_locked->vk_allocator_ptr()
+            (uint32_t)vk_src_caches.size(),
+            vk_src_caches.data()
         );
+        if (vk_result != VK_SUCCESS)
+        {
+            throw Error("failed to merge pipeline caches", vk_result, false);
+        }
+
+        for (const auto& src_cache : src_caches)
+        {
+            PipelineCacheStats src_stats = src_cache->stats();
+
+            std::scoped_lock lock(*stats_mutex);
+            _stats.n_pipelines += src_stats.n_pipelines;
+            _stats.n_hits += src_stats.n_hits;
+            _stats.total_creation_ns += src_stats.total_creation_ns;
+        }
     }
 
-    DebugMessenger::DebugMessenger(
-        const ContextPtr& context,
-        VkDebugUtilsMessageSeverityFlagsEXT message_severity_filter,
-        VkDebugUtilsMessageTypeFlagsEXT message_type_filter,
-        const DebugCallback& callback
-    )
-        : _context(context),
-        _message_severity_filter(message_severity_filter),
-        _message_type_filter(message_type_filter),
-        _callback(callback)
-    {}
+    PipelineCacheStats PipelineCache::stats() const
+    {
+        std::scoped_lock lock(*stats_mutex);
+        return _stats;
+    }
 
-    SurfacePtr Surface::create(
-        const ContextPtr& context,
-        VkSurfaceKHR handle
+    void PipelineCache::reset_stats()
+    {
+        std::scoped_lock lock(*stats_mutex);
+        _stats = {};
+    }
+
+    void PipelineCache::add_creation_feedback(
+        const VkPipelineCreationFeedback& feedback
     )
     {
-        return std::make_shared<Surface_public_ctor>(context, handle);
+        if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+        {
+            return;
+        }
+
+        std::scoped_lock lock(*stats_mutex);
+        _stats.n_pipelines++;
+        if (feedback.flags
+            & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+        {
+            _stats.n_hits++;
+        }
+        _stats.total_creation_ns += feedback.duration;
     }
 
-    Surface::~Surface()
+    PipelineCache::~PipelineCache()
     {
-        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
-        vkDestroySurfaceKHR(
-            context_locked->vk_instance(),
-            _handle,
+        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
+        _BV_LOCK_WPTR_OR_RETURN(
+            device_locked->context(),
+            context_locked
+        );
+
+        device_locked->dispatch().vkDestroyPipelineCache(
+            device_locked->handle(),
+            handle(),
             context_locked->vk_allocator_ptr()
         );
     }
 
-    Surface::Surface(
-        const ContextPtr& context,
-        VkSurfaceKHR handle
+    PipelineCache::PipelineCache(
+        const DevicePtr& device,
+        VkPipelineCacheCreateFlags flags
     )
-        : _context(context), _handle(handle)
+        : _device(device),
+        _flags(flags),
+        stats_mutex(std::make_shared<std::mutex>())
     {}
 
-    void Queue::submit(
-        const std::vector<VkPipelineStageFlags>& wait_stages,
-        const std::vector<SemaphorePtr>& wait_semaphores,
-        const std::vector<CommandBufferPtr>& command_buffers,
-        const std::vector<SemaphorePtr>& signal_semaphores,
-        const FencePtr& signal_fence
+    PipelineCompilerPtr PipelineCompiler::create(
+        const DevicePtr& device,
+        const PipelineCachePtr& cache,
+        uint32_t n_threads
     )
     {
-        try
+        if (n_threads == 0)
         {
-            std::vector<VkSemaphore> vk_semaphores(
-                wait_semaphores.size() + signal_semaphores.size()
-            );
-            for (size_t i = 0; i < wait_semaphores.size(); i++)
-            {
-                vk_semaphores[i] = wait_semaphores[i]->handle();
-            }
-            for (size_t i = 0; i < signal_semaphores.size(); i++)
-            {
-                vk_semaphores[wait_semaphores.size() + i] =
-                    signal_semaphores[i]->handle();
-            }
+            n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        return std::make_shared<PipelineCompiler_public_ctor>(
+            device,
+            cache,
+            n_threads
+        );
+    }
 
-            std::vector<VkCommandBuffer> vk_command_buffers(
-                command_buffers.size()
-            );
-            for (size_t i = 0; i < command_buffers.size(); i++)
+    std::vector<GraphicsPipelinePtr>
+        PipelineCompiler::create_graphics_pipelines(
+            const std::vector<GraphicsPipelineConfig>& configs
+        )
+    {
+        BV_TRACE_ZONE("bv::PipelineCompiler::create_graphics_pipelines");
+
+        auto device_locked = lock_wptr(device());
+
+        std::vector<GraphicsPipelinePtr> pipes(configs.size());
+        run(
+            configs.size(),
+            [&](size_t job_idx, const PipelineCachePtr& worker_cache)
             {
-                vk_command_buffers[i] = command_buffers[i]->handle();
+                pipes[job_idx] = GraphicsPipeline::create(
+                    device_locked,
+                    configs[job_idx],
+                    worker_cache
+                );
             }
+        );
 
-            VkSubmitInfo submit_info{
-                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                .pNext = nullptr,
-                .waitSemaphoreCount = (uint32_t)wait_semaphores.size(),
-                .pWaitSemaphores = vk_semaphores.data(),
-                .pWaitDstStageMask = wait_stages.data(),
-                .commandBufferCount = (uint32_t)vk_command_buffers.size(),
-                .pCommandBuffers = vk_command_buffers.data(),
-                .signalSemaphoreCount = (uint32_t)signal_semaphores.size(),
-
-                .pSignalSemaphores =
-                signal_semaphores.empty()
-                ? nullptr : vk_semaphores.data() + wait_semaphores.size()
-            };
+        // the worker caches are destroyed after the merge
+        for (auto& pipe : pipes)
+        {
+            pipe->_cache = cache();
+        }
+        return pipes;
+    }
 
-            VkResult vk_result = vkQueueSubmit(
-                handle(),
-                1,
-                &submit_info,
-                signal_fence == nullptr ? nullptr : signal_fence->handle()
-            );
-            if (vk_result != VK_SUCCESS)
+    std::vector<ComputePipelinePtr>
+        PipelineCompiler::create_compute_pipelines(
+            const std::vector<ComputePipelineConfig>& configs
+        )
+    {
+        BV_TRACE_ZONE("bv::PipelineCompiler::create_compute_pipelines");
+
+        auto device_locked = lock_wptr(device());
+
+        std::vector<ComputePipelinePtr> pipes(configs.size());
+        run(
+            configs.size(),
+            [&](size_t job_idx, const PipelineCachePtr& worker_cache)
             {
-                throw Error(vk_result);
+                pipes[job_idx] = ComputePipeline::create(
+                    device_locked,
+                    configs[job_idx],
+                    worker_cache
+                );
             }
+        );
+
+        // the worker caches are destroyed after the merge
+        for (auto& pipe : pipes)
+        {
+            pipe->_cache = cache();
         }
-        catch (const Error& e)
+        return pipes;
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+        // moved from
+        if (work_queue == nullptr)
         {
-            throw Error(
-                "failed to submit command buffer(s) to queue: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            return;
+        }
+
+        {
+            std::scoped_lock lock(work_queue->mutex);
+            work_queue->stop = true;
+        }
+        work_queue->cv.notify_all();
+        for (auto& thread : threads)
+        {
+            thread.join();
         }
     }
 
-    void Queue::present(
-        const std::vector<SemaphorePtr>& wait_semaphores,
-        const SwapchainPtr& swapchain,
-        uint32_t image_index,
-        VkResult* out_vk_result
+    PipelineCompiler::PipelineCompiler(
+        const DevicePtr& device,
+        const PipelineCachePtr& cache,
+        uint32_t n_threads
     )
+        : _device(device),
+        _cache(cache),
+        work_queue(std::make_shared<WorkQueue>())
     {
-        try
+        for (uint32_t i = 0; i < n_threads; i++)
         {
-            std::vector<VkSemaphore> vk_semaphores(wait_semaphores.size());
-            for (size_t i = 0; i < wait_semaphores.size(); i++)
-            {
-                vk_semaphores[i] = wait_semaphores[i]->handle();
-            }
+            threads.emplace_back(
+                [work_queue = work_queue, i]()
+                {
+                    while (true)
+                    {
+                        std::function<void(uint32_t worker_idx)> job;
+                        {
+                            std::unique_lock lock(work_queue->mutex);
+                            work_queue->cv.wait(
+                                lock,
+                                [&]()
+                                {
+                                    return work_queue->stop
+                                        || !work_queue->jobs.empty();
+                                }
+                            );
+                            if (work_queue->jobs.empty())
+                            {
+                                return;
+                            }
+                            job = std::move(work_queue->jobs.front());
+                            work_queue->jobs.pop_front();
+                        }
+                        job(i);
+                    }
+                }
+            );
+        }
+    }
+
+    void PipelineCompiler::run(size_t n_jobs, const Job& job)
+    {
+        auto device_locked = lock_wptr(device());
+        PipelineCachePtr cache_locked = _cache.lock();
 
-            VkSwapchainKHR vk_swapchain = swapchain->handle();
+        // the worker caches are only created by the workers that pick up a
+        // job, and each worker only touches its own
+        std::vector<uint8_t> seed_data;
+        if (cache_locked != nullptr)
+        {
+            seed_data = cache_locked->get_cache_data();
+        }
+        std::vector<PipelineCachePtr> worker_caches(threads.size());
 
-            VkPresentInfoKHR present_info{
-                .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-                .pNext = nullptr,
-                .waitSemaphoreCount = (uint32_t)wait_semaphores.size(),
-                .pWaitSemaphores = vk_semaphores.data(),
-                .swapchainCount = 1,
-                .pSwapchains = &vk_swapchain,
-                .pImageIndices = &image_index,
-                .pResults = nullptr
-            };
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        size_t n_remaining = n_jobs;
+        std::exception_ptr first_error = nullptr;
 
-            VkResult vk_result = vkQueuePresentKHR(
-                handle(),
-                &present_info
-            );
-            if (out_vk_result != nullptr)
+        {
+            std::scoped_lock lock(work_queue->mutex);
+            for (size_t i = 0; i < n_jobs; i++)
             {
-                *out_vk_result = vk_result;
+                work_queue->jobs.push_back(
+                    [&, i](uint32_t worker_idx)
+                    {
+                        try
+                        {
+                            auto& worker_cache = worker_caches[worker_idx];
+                            if (cache_locked != nullptr
+                                && worker_cache == nullptr)
+                            {
+                                worker_cache = PipelineCache::create(
+                                    device_locked,
+                                    0,
+                                    seed_data
+                                );
+                            }
+                            job(i, worker_cache);
+                        }
+                        catch (...)
+                        {
+                            std::scoped_lock lock(done_mutex);
+                            if (first_error == nullptr)
+                            {
+                                first_error = std::current_exception();
+                            }
+                        }
+
+                        std::scoped_lock lock(done_mutex);
+                        n_remaining--;
+                        if (n_remaining == 0)
+                        {
+                            done_cv.notify_all();
+                        }
+                    }
+                );
             }
-            if (vk_result != VK_SUCCESS && vk_result != VK_SUBOPTIMAL_KHR)
+        }
+        work_queue->cv.notify_all();
+
+        {
+            std::unique_lock lock(done_mutex);
+            done_cv.wait(lock, [&]() { return n_remaining == 0; });
+        }
+
+        std::vector<PipelineCachePtr> used_worker_caches;
+        for (const auto& worker_cache : worker_caches)
+        {
+            if (worker_cache != nullptr)
             {
-                throw Error(vk_result);
+                used_worker_caches.push_back(worker_cache);
             }
         }
-        catch (const Error& e)
+        if (!used_worker_caches.empty())
         {
-            throw Error(
-                "failed to queue image for presentation: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            cache_locked->merge(used_worker_caches);
         }
-    }
 
-    void Queue::wait_idle()
-    {
-        VkResult vk_result = vkQueueWaitIdle(handle());
-        if (vk_result != VK_SUCCESS)
+        if (first_error != nullptr)
         {
-            throw Error(
-                "failed to wait for queue to become idle",
-                vk_result,
-                false
-            );
+            std::rethrow_exception(first_error);
         }
     }
 
-    Queue::Queue(
-        const DeviceWPtr& device,
-        uint32_t queue_family_index,
-        uint32_t queue_index,
-        VkQueue handle
-    )
-        : _device(device),
-        _queue_family_index(queue_family_index),
-        _queue_index(queue_index),
-        _handle(handle)
-    {}
-
-    DevicePtr Device::create(
-        const ContextPtr& context,
-        const PhysicalDevice& physical_device,
-        const DeviceConfig& config
-    )
+    // appends the fields of pipeline configs and their nested structs to a
+    // PipelineStateKey. optionals and vectors are prefixed with whether they
+    // have a value and their size so that different layouts can't produce
+    // the same words.
+    class PipelineStateKeyBuilder
     {
-        try
+    public:
+        void add(uint64_t value)
         {
-            DevicePtr device = std::make_shared<Device_public_ctor>(
-                context,
-                physical_device,
-                config
-            );
+            key.words.push_back(value);
+        }
 
-            std::vector<VkDeviceQueueCreateInfo> vk_queue_requests;
-            std::vector<std::vector<float>> wastes_priorities(
-                device->config().queue_requests.size()
-            );
-            for (size_t i = 0; i < device->config().queue_requests.size(); i++)
+        void add(float value)
+        {
+            // -0 and 0 compare equal and so should their keys
+            add((uint64_t)(value == 0.f ? 0u : std::bit_cast<uint32_t>(value)));
+        }
+
+        void add(std::span<const uint8_t> bytes)
+        {
+            add((uint64_t)bytes.size());
+            for (size_t i = 0; i < bytes.size(); i += 8)
             {
-                const auto& queue_request = device->config().queue_requests[i];
+                uint64_t word = 0;
+                size_t n = std::min(bytes.size() - i, (size_t)8);
+                std::memcpy(&word, bytes.data() + i, n);
+                add(word);
+            }
+        }
 
-                if (queue_request.priorities.size()
-                    != queue_request.num_queues_to_create)
+        void add(const std::string& str)
+        {
+            add(std::span<const uint8_t>(
+                (const uint8_t*)str.data(),
+                str.size()
+            ));
+        }
+
+        void add(const ShaderStage& stage)
+        {
+            add((uint64_t)stage.flags);
+            add((uint64_t)stage.stage);
+            add(lock_wptr(stage.module)->code_hash());
+            add(stage.entry_point);
+            add((uint64_t)stage.specialization_info.has_value());
+            if (stage.specialization_info.has_value())
+            {
+                const auto& info = stage.specialization_info.value();
+                add((uint64_t)info.map_entries.size());
+                for (const auto& entry : info.map_entries)
                 {
-                    throw Error(
-                        "there should be the same number of queue priorities "
-                        "as the number of queues to create"
-                    );
+                    add((uint64_t)entry.constant_id);
+                    add((uint64_t)entry.offset);
+                    add((uint64_t)entry.size);
                 }
+                add(std::span<const uint8_t>(info.data));
+            }
+        }
 
-                vk_queue_requests.push_back(
-                    QueueRequest_to_vk(
-                        queue_request,
-                        wastes_priorities[i]
-                    )
-                );
+        void add(const VertexInputState& state)
+        {
+            add((uint64_t)state.binding_descriptions.size());
+            for (const auto& binding : state.binding_descriptions)
+            {
+                add((uint64_t)binding.binding);
+                add((uint64_t)binding.stride);
+                add((uint64_t)binding.input_rate);
+            }
+            add((uint64_t)state.attribute_descriptions.size());
+            for (const auto& attribute : state.attribute_descriptions)
+            {
+                add((uint64_t)attribute.location);
+                add((uint64_t)attribute.binding);
+                add((uint64_t)attribute.format);
+                add((uint64_t)attribute.offset);
             }
+        }
 
-            std::vector<const char*> layers_cstr;
+        void add(const InputAssemblyState& state)
+        {
+            add((uint64_t)state.topology);
+            add((uint64_t)state.primitive_restart_enable);
+        }
+
+        void add(const TessellationState& state)
+        {
+            add((uint64_t)state.patch_control_points);
+        }
+
+        void add(const ViewportState& state)
+        {
+            add((uint64_t)state.viewports.size());
+            for (const auto& viewport : state.viewports)
             {
-                layers_cstr.reserve(
-                    context->config().layers.size()
-                );
-                for (const auto& layer
-                    : context->config().layers)
-                {
-                    layers_cstr.push_back(layer.c_str());
-                }
+                add(viewport.x);
+                add(viewport.y);
+                add(viewport.width);
+                add(viewport.height);
+                add(viewport.min_depth);
+                add(viewport.max_depth);
             }
+            add((uint64_t)state.scissors.size());
+            for (const auto& scissor : state.scissors)
+            {
+                add((uint64_t)(uint32_t)scissor.offset.x);
+                add((uint64_t)(uint32_t)scissor.offset.y);
+                add((uint64_t)scissor.extent.width);
+                add((uint64_t)scissor.extent.height);
+            }
+        }
 
-            std::vector<const char*> extensions_cstr;
+        void add(const RasterizationState& state)
+        {
+            add((uint64_t)state.depth_clamp_enable);
+            add((uint64_t)state.rasterizer_discard_enable);
+            add((uint64_t)state.polygon_mode);
+            add((uint64_t)state.cull_mode);
+            add((uint64_t)state.front_face);
+            add((uint64_t)state.depth_bias_enable);
+            add(state.depth_bias_constant_factor);
+            add(state.depth_bias_clamp);
+            add(state.depth_bias_slope_factor);
+            add(state.line_width);
+        }
+
+        void add(const MultisampleState& state)
+        {
+            add((uint64_t)state.rasterization_samples);
+            add((uint64_t)state.sample_shading_enable);
+            add(state.min_sample_shading);
+            add((uint64_t)state.sample_mask.size());
+            for (auto mask : state.sample_mask)
             {
-                extensions_cstr.reserve(
-                    device->config().extensions.size()
-                );
-                for (const auto& ext : device->config().extensions)
-                {
-                    extensions_cstr.push_back(ext.c_str());
-                }
+                add((uint64_t)mask);
             }
+            add((uint64_t)state.alpha_to_coverage_enable);
+            add((uint64_t)state.alpha_to_one_enable);
+        }
 
-            VkPhysicalDeviceFeatures vk_enabled_features =
-                PhysicalDeviceFeatures_to_vk(
-                    device->config().enabled_features
-                );
+        void add(const StencilOpState& state)
+        {
+            add((uint64_t)state.fail_op);
+            add((uint64_t)state.pass_op);
+            add((uint64_t)state.depth_fail_op);
+            add((uint64_t)state.compare_op);
+            add((uint64_t)state.compare_mask);
+            add((uint64_t)state.write_mask);
+            add((uint64_t)state.reference);
+        }
 
-            VkDeviceCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0,
-                .queueCreateInfoCount = (uint32_t)vk_queue_requests.size(),
-                .pQueueCreateInfos = vk_queue_requests.data(),
-                .enabledLayerCount = (uint32_t)layers_cstr.size(),
-                .ppEnabledLayerNames = layers_cstr.data(),
-                .enabledExtensionCount = (uint32_t)extensions_cstr.size(),
-                .ppEnabledExtensionNames = extensions_cstr.data(),
-                .pEnabledFeatures = &vk_enabled_features
-            };
+        void add(const DepthStencilState& state)
+        {
+            add((uint64_t)state.flags);
+            add((uint64_t)state.depth_test_enable);
+            add((uint64_t)state.depth_write_enable);
+            add((uint64_t)state.depth_compare_op);
+            add((uint64_t)state.depth_bounds_test_enable);
+            add((uint64_t)state.stencil_test_enable);
+            add(state.front);
+            add(state.back);
+            add(state.min_depth_bounds);
+            add(state.max_depth_bounds);
+        }
 
-            VkResult vk_result = vkCreateDevice(
-                device->physical_device().handle(),
-                &create_info,
-                context->vk_allocator_ptr(),
-                &device->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+        void add(const ColorBlendState& state)
+        {
+            add((uint64_t)state.flags);
+            add((uint64_t)state.logic_op_enable);
+            add((uint64_t)state.logic_op);
+            add((uint64_t)state.attachments.size());
+            for (const auto& attachment : state.attachments)
             {
-                throw Error(vk_result);
+                add((uint64_t)attachment.blend_enable);
+                add((uint64_t)attachment.src_color_blend_factor);
+                add((uint64_t)attachment.dst_color_blend_factor);
+                add((uint64_t)attachment.color_blend_op);
+                add((uint64_t)attachment.src_alpha_blend_factor);
+                add((uint64_t)attachment.dst_alpha_blend_factor);
+                add((uint64_t)attachment.alpha_blend_op);
+                add((uint64_t)attachment.color_write_mask);
+            }
+            for (float constant : state.blend_constants)
+            {
+                add(constant);
             }
-            return device;
         }
-        catch (const Error& e)
+
+        void add(const PipelineRenderingFormats& formats)
         {
-            throw Error(
-                "failed to create device: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            add((uint64_t)formats.view_mask);
+            add((uint64_t)formats.color_attachment_formats.size());
+            for (auto format : formats.color_attachment_formats)
+            {
+                add((uint64_t)format);
+            }
+            add((uint64_t)formats.depth_attachment_format);
+            add((uint64_t)formats.stencil_attachment_format);
         }
-    }
 
-    QueuePtr Device::retrieve_queue(
-        const DevicePtr& device,
-        uint32_t queue_family_index,
-        uint32_t queue_index
-    )
-    {
-        VkQueue vk_queue;
-        vkGetDeviceQueue(
-            device->handle(),
-            queue_family_index,
-            queue_index,
-            &vk_queue
-        );
-        return std::make_shared<Queue_public_ctor>(
-            device,
-            queue_family_index,
-            queue_index,
-            vk_queue
-        );
-    }
+        template<typename T>
+        void add(const std::optional<T>& value)
+        {
+            add((uint64_t)value.has_value());
+            if (value.has_value())
+            {
+                add(value.value());
+            }
+        }
 
-    void Device::wait_idle()
-    {
-        VkResult vk_result = vkDeviceWaitIdle(_handle);
-        if (vk_result != VK_SUCCESS)
+        // objects are identified by their address rather than their Vulkan
+        // handle, since distinct non-dispatchable objects may share a handle
+        template<typename T>
+        void add_object(const std::weak_ptr<T>& object)
         {
-            throw Error(
-                "failed to wait for device to become idle",
-                vk_result,
-                false
-            );
+            add((uint64_t)(uintptr_t)lock_wptr(object).get());
         }
-    }
 
-    Device::~Device()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(context(), context_locked);
-        vkDestroyDevice(handle(), context_locked->vk_allocator_ptr());
-    }
+        PipelineStateKey finish()
+        {
+            key.hash = fnv1a_hash(std::span<const uint8_t>(
+                (const uint8_t*)key.words.data(),
+                key.words.size() * sizeof(uint64_t)
+            ));
+            return std::move(key);
+        }
 
-    Device::Device(
-        const ContextPtr& context,
-        const PhysicalDevice& physical_device,
-        const DeviceConfig& config
+    private:
+        PipelineStateKey key;
+
+    };
+
+    static VkPrimitiveTopology topology_class_representative(
+        VkPrimitiveTopology topology
     )
-        : _context(context),
-        _physical_device(physical_device),
-        _config(config)
-    {}
+    {
+        switch (topology)
+        {
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+        case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+            return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+        case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+        case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+        case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST_WITH_ADJACENCY:
+        case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY:
+            return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        default:
+            return topology;
+        }
+    }
 
-    ImagePtr Image::create(
-        const DevicePtr& device,
-        const ImageConfig& config
+    GraphicsPipelineConfig GraphicsPipelineConfig_strip_dynamic_state(
+        const GraphicsPipelineConfig& config
     )
     {
-        try
+        GraphicsPipelineConfig stripped = config;
+        auto& vertex_input = stripped.vertex_input_state;
+        auto& input_assembly = stripped.input_assembly_state;
+        auto& tessellation = stripped.tessellation_state;
+        auto& viewport = stripped.viewport_state;
+        auto& rasterization = stripped.rasterization_state;
+        auto& multisample = stripped.multisample_state;
+        auto& depth_stencil = stripped.depth_stencil_state;
+        auto& color_blend = stripped.color_blend_state;
+
+        for (auto state : config.dynamic_states)
         {
-            ImageFormatProperties img_format_props{};
-            try
+            switch (state)
             {
-                img_format_props =
-                    device->physical_device().fetch_image_format_properties(
-                        config.format,
-                        config.image_type,
-                        config.tiling,
-                        config.usage,
-                        config.flags
+            case VK_DYNAMIC_STATE_VIEWPORT:
+                if (viewport.has_value())
+                {
+                    for (auto& v : viewport->viewports)
+                    {
+                        v = Viewport{};
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_SCISSOR:
+                if (viewport.has_value())
+                {
+                    for (auto& scissor : viewport->scissors)
+                    {
+                        scissor = Rect2d{};
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT:
+                if (viewport.has_value())
+                {
+                    viewport->viewports.clear();
+                }
+                break;
+            case VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT:
+                if (viewport.has_value())
+                {
+                    viewport->scissors.clear();
+                }
+                break;
+            case VK_DYNAMIC_STATE_LINE_WIDTH:
+                if (rasterization.has_value())
+                {
+                    rasterization->line_width = 0.f;
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_BIAS:
+                if (rasterization.has_value())
+                {
+                    rasterization->depth_bias_constant_factor = 0.f;
+                    rasterization->depth_bias_clamp = 0.f;
+                    rasterization->depth_bias_slope_factor = 0.f;
+                }
+                break;
+            case VK_DYNAMIC_STATE_BLEND_CONSTANTS:
+                if (color_blend.has_value())
+                {
+                    color_blend->blend_constants = {};
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_BOUNDS:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->min_depth_bounds = 0.f;
+                    depth_stencil->max_depth_bounds = 0.f;
+                }
+                break;
+            case VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->front.compare_mask = 0;
+                    depth_stencil->back.compare_mask = 0;
+                }
+                break;
+            case VK_DYNAMIC_STATE_STENCIL_WRITE_MASK:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->front.write_mask = 0;
+                    depth_stencil->back.write_mask = 0;
+                }
+                break;
+            case VK_DYNAMIC_STATE_STENCIL_REFERENCE:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->front.reference = 0;
+                    depth_stencil->back.reference = 0;
+                }
+                break;
+            case VK_DYNAMIC_STATE_CULL_MODE:
+                if (rasterization.has_value())
+                {
+                    rasterization->cull_mode = VK_CULL_MODE_NONE;
+                }
+                break;
+            case VK_DYNAMIC_STATE_FRONT_FACE:
+                if (rasterization.has_value())
+                {
+                    rasterization->front_face =
+                        VK_FRONT_FACE_COUNTER_CLOCKWISE;
+                }
+                break;
+            case VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY:
+                if (input_assembly.has_value())
+                {
+                    input_assembly->topology = topology_class_representative(
+                        input_assembly->topology
                     );
+                }
+                break;
+            case VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE:
+                if (vertex_input.has_value())
+                {
+                    for (auto& binding : vertex_input->binding_descriptions)
+                    {
+                        binding.stride = 0;
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->depth_test_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->depth_write_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_COMPARE_OP:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->depth_compare_op = VK_COMPARE_OP_NEVER;
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->depth_bounds_test_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE:
+                if (depth_stencil.has_value())
+                {
+                    depth_stencil->stencil_test_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_STENCIL_OP:
+                if (depth_stencil.has_value())
+                {
+                    for (auto face : { &depth_stencil->front,
+                                       &depth_stencil->back })
+                    {
+                        face->fail_op = VK_STENCIL_OP_KEEP;
+                        face->pass_op = VK_STENCIL_OP_KEEP;
+                        face->depth_fail_op = VK_STENCIL_OP_KEEP;
+                        face->compare_op = VK_COMPARE_OP_NEVER;
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE:
+                if (rasterization.has_value())
+                {
+                    rasterization->rasterizer_discard_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE:
+                if (rasterization.has_value())
+                {
+                    rasterization->depth_bias_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE:
+                if (input_assembly.has_value())
+                {
+                    input_assembly->primitive_restart_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_LOGIC_OP_EXT:
+                if (color_blend.has_value())
+                {
+                    color_blend->logic_op = VK_LOGIC_OP_CLEAR;
+                }
+                break;
+            case VK_DYNAMIC_STATE_PATCH_CONTROL_POINTS_EXT:
+                if (tessellation.has_value())
+                {
+                    tessellation->patch_control_points = 0;
+                }
+                break;
+            case VK_DYNAMIC_STATE_VERTEX_INPUT_EXT:
+                vertex_input = std::nullopt;
+                break;
+            case VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT:
+                if (rasterization.has_value())
+                {
+                    rasterization->depth_clamp_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_POLYGON_MODE_EXT:
+                if (rasterization.has_value())
+                {
+                    rasterization->polygon_mode = VK_POLYGON_MODE_FILL;
+                }
+                break;
+            case VK_DYNAMIC_STATE_RASTERIZATION_SAMPLES_EXT:
+                if (multisample.has_value())
+                {
+                    multisample->rasterization_samples = VK_SAMPLE_COUNT_1_BIT;
+                }
+                break;
+            case VK_DYNAMIC_STATE_SAMPLE_MASK_EXT:
+                if (multisample.has_value())
+                {
+                    multisample->sample_mask.clear();
+                }
+                break;
+            case VK_DYNAMIC_STATE_ALPHA_TO_COVERAGE_ENABLE_EXT:
+                if (multisample.has_value())
+                {
+                    multisample->alpha_to_coverage_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_ALPHA_TO_ONE_ENABLE_EXT:
+                if (multisample.has_value())
+                {
+                    multisample->alpha_to_one_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_LOGIC_OP_ENABLE_EXT:
+                if (color_blend.has_value())
+                {
+                    color_blend->logic_op_enable = false;
+                }
+                break;
+            case VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT:
+                if (color_blend.has_value())
+                {
+                    for (auto& attachment : color_blend->attachments)
+                    {
+                        attachment.blend_enable = false;
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT:
+                if (color_blend.has_value())
+                {
+                    for (auto& attachment : color_blend->attachments)
+                    {
+                        attachment.src_color_blend_factor =
+                            VK_BLEND_FACTOR_ZERO;
+                        attachment.dst_color_blend_factor =
+                            VK_BLEND_FACTOR_ZERO;
+                        attachment.color_blend_op = VK_BLEND_OP_ADD;
+                        attachment.src_alpha_blend_factor =
+                            VK_BLEND_FACTOR_ZERO;
+                        attachment.dst_alpha_blend_factor =
+                            VK_BLEND_FACTOR_ZERO;
+                        attachment.alpha_blend_op = VK_BLEND_OP_ADD;
+                    }
+                }
+                break;
+            case VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT:
+                if (color_blend.has_value())
+                {
+                    for (auto& attachment : color_blend->attachments)
+                    {
+                        attachment.color_write_mask = 0;
+                    }
+                }
+                break;
+            default:
+                break;
             }
-            catch (const Error& e)
+        }
+        return stripped;
+    }
+
+    GraphicsPipelineConfig GraphicsPipelineConfig_library_part(
+        const GraphicsPipelineConfig& config,
+        VkGraphicsPipelineLibraryFlagBitsEXT part
+    )
+    {
+        GraphicsPipelineConfig part_config{
+            .flags = config.flags,
+            .dynamic_states = config.dynamic_states,
+            .layout = config.layout,
+            .render_pass = config.render_pass,
+            .subpass_index = config.subpass_index,
+            .base_pipeline = config.base_pipeline,
+            .rendering_formats = config.rendering_formats,
+            .library_flags = (VkGraphicsPipelineLibraryFlagsEXT)part
+        };
+
+        switch (part)
+        {
+        case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+            part_config.vertex_input_state = config.vertex_input_state;
+            part_config.input_assembly_state = config.input_assembly_state;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+            for (const auto& stage : config.stages)
             {
-                if (e.vk_result().has_value()
-                    && e.vk_result().value() == VK_ERROR_FORMAT_NOT_SUPPORTED)
+                if (stage.stage != VK_SHADER_STAGE_FRAGMENT_BIT)
                 {
-                    throw Error(
-                        "image format not supported with the provided "
-                        "parameters",
-                        e.vk_result(),
-                        true
-                    );
+                    part_config.stages.push_back(stage);
                 }
-                else
+            }
+            part_config.tessellation_state = config.tessellation_state;
+            part_config.viewport_state = config.viewport_state;
+            part_config.rasterization_state = config.rasterization_state;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+            for (const auto& stage : config.stages)
+            {
+                if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
                 {
-                    throw e;
+                    part_config.stages.push_back(stage);
                 }
             }
+            part_config.multisample_state = config.multisample_state;
+            part_config.depth_stencil_state = config.depth_stencil_state;
+            break;
+        case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+            part_config.multisample_state = config.multisample_state;
+            part_config.color_blend_state = config.color_blend_state;
+            break;
+        default:
+            break;
+        }
+        return part_config;
+    }
 
-            ImagePtr img = std::make_shared<Image_public_ctor>(
-                device,
-                config
-            );
-
-            VkImageCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = img->config().flags,
-                .imageType = img->config().image_type,
-                .format = img->config().format,
-                .extent = Extent3d_to_vk(img->config().extent),
-                .mipLevels = img->config().mip_levels,
-                .arrayLayers = img->config().array_layers,
-                .samples = img->config().samples,
-                .tiling = img->config().tiling,
-                .usage = img->config().usage,
-                .sharingMode = img->config().sharing_mode,
+    PipelineStateKey GraphicsPipelineConfig_key(
+        const GraphicsPipelineConfig& config
+    )
+    {
+        // configs that only differ in dynamic state share a pipeline
+        GraphicsPipelineConfig stripped =
+            GraphicsPipelineConfig_strip_dynamic_state(config);
+
+        PipelineStateKeyBuilder builder;
+        builder.add((uint64_t)stripped.flags);
+        builder.add((uint64_t)stripped.stages.size());
+        for (const auto& stage : stripped.stages)
+        {
+            builder.add(stage);
+        }
+        builder.add(stripped.vertex_input_state);
+        builder.add(stripped.input_assembly_state);
+        builder.add(stripped.tessellation_state);
+        builder.add(stripped.viewport_state);
+        builder.add(stripped.rasterization_state);
+        builder.add(stripped.multisample_state);
+        builder.add(stripped.depth_stencil_state);
+        builder.add(stripped.color_blend_state);
+        builder.add((uint64_t)stripped.dynamic_states.size());
+        for (auto state : stripped.dynamic_states)
+        {
+            builder.add((uint64_t)state);
+        }
+        builder.add_object(stripped.layout);
 
-                .queueFamilyIndexCount =
-                (uint32_t)img->config().queue_family_indices.size(),
+        // the render pass is ignored with dynamic rendering
+        builder.add(stripped.rendering_formats);
+        if (!stripped.rendering_formats.has_value())
+        {
+            builder.add_object(stripped.render_pass);
+            builder.add((uint64_t)stripped.subpass_index);
+        }
 
-                .pQueueFamilyIndices =
-                img->config().queue_family_indices.data(),
+        builder.add((uint64_t)stripped.base_pipeline.has_value());
+        if (stripped.base_pipeline.has_value())
+        {
+            builder.add_object(stripped.base_pipeline.value());
+        }
 
-                .initialLayout = img->config().initial_layout
-            };
+        builder.add((uint64_t)stripped.library_flags);
+        builder.add((uint64_t)stripped.libraries.size());
+        for (const auto& library : stripped.libraries)
+        {
+            builder.add_object(library);
+        }
+        return builder.finish();
+    }
 
-            VkResult vk_result = vkCreateImage(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &img->_handle
+    PipelineStateKey ComputePipelineConfig_key(
+        const ComputePipelineConfig& config
+    )
+    {
+        PipelineStateKeyBuilder builder;
+        builder.add((uint64_t)config.flags);
+        builder.add(config.stage);
+        builder.add_object(config.layout);
+        builder.add((uint64_t)config.base_pipeline.has_value());
+        if (config.base_pipeline.has_value())
+        {
+            builder.add_object(config.base_pipeline.value());
+        }
+        return builder.finish();
+    }
+
+    PipelineRegistryPtr PipelineRegistry::create(
+        const DevicePtr& device,
+        const PipelineCachePtr& cache
+    )
+    {
+        return std::make_shared<PipelineRegistry_public_ctor>(device, cache);
+    }
+
+    // the address of a destroyed object can be reused by a new one, so a
+    // registered pipeline only matches while the objects it was created with
+    // are still alive. two live objects never share an address, so then the
+    // keys identify the objects exactly.
+    static bool pipeline_objects_expired(const GraphicsPipelineConfig& config)
+    {
+        return config.layout.expired()
+            || (!config.rendering_formats.has_value()
+                && config.render_pass.expired())
+            || (config.base_pipeline.has_value()
+                && config.base_pipeline->expired())
+            || std::any_of(
+                config.libraries.begin(),
+                config.libraries.end(),
+                [](const GraphicsPipelineWPtr& library)
+                {
+                    return library.expired();
+                }
             );
-            if (vk_result != VK_SUCCESS)
+    }
+
+    static bool pipeline_objects_expired(const ComputePipelineConfig& config)
+    {
+        return config.layout.expired()
+            || (config.base_pipeline.has_value()
+                && config.base_pipeline->expired());
+    }
+
+    GraphicsPipelinePtr PipelineRegistry::get_graphics_pipeline(
+        const GraphicsPipelineConfig& config
+    )
+    {
+        try
+        {
+            // the pipeline is created from the stripped config so that its
+            // config() doesn't depend on which caller happened to create it
+            GraphicsPipelineConfig stripped =
+                GraphicsPipelineConfig_strip_dynamic_state(config);
+            auto key = GraphicsPipelineConfig_key(stripped);
             {
-                throw Error(vk_result);
+                std::scoped_lock lock(*mutex);
+                auto it = graphics_pipelines.find(key);
+                if (it != graphics_pipelines.end())
+                {
+                    auto pipe = it->second.lock();
+                    if (pipe != nullptr
+                        && !pipeline_objects_expired(pipe->config()))
+                    {
+                        _n_reused++;
+                        return pipe;
+                    }
+                }
             }
 
-            VkMemoryRequirements vk_mem_requirements;
-            vkGetImageMemoryRequirements(
-                device->handle(),
-                img->handle(),
-                &vk_mem_requirements
-            );
-            img->_memory_requirements = MemoryRequirements_from_vk(
-                vk_mem_requirements
+            // the lock isn't held while compiling. if another thread
+            // registered the same pipeline in the meantime, theirs is kept.
+            auto pipe = GraphicsPipeline::create(
+                lock_wptr(device()),
+                stripped,
+                _cache.lock()
             );
 
-            return img;
+            std::scoped_lock lock(*mutex);
+            auto& entry = graphics_pipelines[key];
+            auto existing = entry.lock();
+            if (existing != nullptr
+                && !pipeline_objects_expired(existing->config()))
+            {
+                return existing;
+            }
+            entry = pipe;
+            return pipe;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create image: " + e.to_string(),
+                "failed to get registered graphics pipeline: "
+                + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    void Image::bind_memory(
-        const DeviceMemoryPtr& memory,
-        VkDeviceSize memory_offset
+    ComputePipelinePtr PipelineRegistry::get_compute_pipeline(
+        const ComputePipelineConfig& config
     )
     {
         try
         {
-            VkResult vk_result = vkBindImageMemory(
-                lock_wptr(device())->handle(),
-                handle(),
-                memory->handle(),
-                memory_offset
+            auto key = ComputePipelineConfig_key(config);
+            {
+                std::scoped_lock lock(*mutex);
+                auto it = compute_pipelines.find(key);
+                if (it != compute_pipelines.end())
+                {
+                    auto pipe = it->second.lock();
+                    if (pipe != nullptr
+                        && !pipeline_objects_expired(pipe->config()))
+                    {
+                        _n_reused++;
+                        return pipe;
+                    }
+                }
+            }
+
+            // the lock isn't held while compiling. if another thread
+            // registered the same pipeline in the meantime, theirs is kept.
+            auto pipe = ComputePipeline::create(
+                lock_wptr(device()),
+                config,
+                _cache.lock()
             );
-            if (vk_result != VK_SUCCESS)
+
+            std::scoped_lock lock(*mutex);
+            auto& entry = compute_pipelines[key];
+            auto existing = entry.lock();
+            if (existing != nullptr
+                && !pipeline_objects_expired(existing->config()))
             {
-                throw Error(vk_result);
+                return existing;
             }
+            entry = pipe;
+            return pipe;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to bind image memory: " + e.to_string(),
+                "failed to get registered compute pipeline: "
+                + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    Image::~Image()
+    void PipelineRegistry::prune()
     {
-        if (created_externally())
-        {
-            return;
-        }
-
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
+        std::scoped_lock lock(*mutex);
+        std::erase_if(
+            graphics_pipelines,
+            [](const auto& entry)
+            {
+                auto pipe = entry.second.lock();
+                return pipe == nullptr
+                    || pipeline_objects_expired(pipe->config());
+            }
         );
-
-        vkDestroyImage(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
+        std::erase_if(
+            compute_pipelines,
+            [](const auto& entry)
+            {
+                auto pipe = entry.second.lock();
+                return pipe == nullptr
+                    || pipeline_objects_expired(pipe->config());
+            }
         );
     }
 
-    Image::Image(const DevicePtr& device, const ImageConfig& config)
-        : _created_externally(false),
-        _device(device),
-        _config(config),
-        _memory_requirements({}),
-        _handle(nullptr)
-    {}
+    uint64_t PipelineRegistry::n_reused() const
+    {
+        std::scoped_lock lock(*mutex);
+        return _n_reused;
+    }
 
-    Image::Image(VkImage handle_created_externally)
-        : _created_externally(true),
-        _device({}),
-        _config({}),
-        _memory_requirements({}),
-        _handle(handle_created_externally)
+    size_t PipelineRegistry::size() const
+    {
+        std::scoped_lock lock(*mutex);
+        return graphics_pipelines.size() + compute_pipelines.size();
+    }
+
+    PipelineRegistry::PipelineRegistry(
+        const DevicePtr& device,
+        const PipelineCachePtr& cache
+    )
+        : _device(device),
+        _cache(cache),
+        mutex(std::make_shared<std::mutex>())
     {}
 
-    SwapchainPtr Swapchain::create(
+    static constexpr std::array<VkGraphicsPipelineLibraryFlagBitsEXT, 4>
+        GRAPHICS_PIPELINE_LIBRARY_PARTS{
+            VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+            VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+        };
+
+    // a pipeline made of nothing but the libraries. with optimize, link time
+    // optimization is done which takes about as long as a full compilation.
+    static GraphicsPipelineConfig library_link_config(
+        const GraphicsPipelineConfig& config,
+        const std::vector<GraphicsPipelinePtr>& libraries,
+        bool optimize
+    )
+    {
+        GraphicsPipelineConfig link_config{
+            .flags = config.flags,
+            .layout = config.layout,
+            .render_pass = config.render_pass,
+            .subpass_index = config.subpass_index,
+            .rendering_formats = config.rendering_formats
+        };
+        if (optimize)
+        {
+            link_config.flags |=
+                VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+        }
+        for (const auto& library : libraries)
+        {
+            link_config.libraries.push_back(library);
+        }
+        return link_config;
+    }
+
+    PipelineLibraryLinkerPtr PipelineLibraryLinker::create(
         const DevicePtr& device,
-        const SurfacePtr& surface,
-        const SwapchainConfig& config,
-        const SwapchainPtr& old_swapchain
+        const PipelineCachePtr& cache
+    )
+    {
+        return std::make_shared<PipelineLibraryLinker_public_ctor>(
+            device,
+            cache
+        );
+    }
+
+    GraphicsPipelinePtr PipelineLibraryLinker::get(
+        const GraphicsPipelineConfig& config
     )
     {
+        BV_TRACE_ZONE("bv::PipelineLibraryLinker::get");
+
         try
         {
-            SwapchainPtr sc = std::make_shared<Swapchain_public_ctor>(
-                device,
-                surface,
-                config,
-                old_swapchain
-            );
-
-            VkSwapchainKHR vk_old_swapchain = nullptr;
-            if (old_swapchain != nullptr)
+            auto key = GraphicsPipelineConfig_key(config);
             {
-                vk_old_swapchain = old_swapchain->handle();
+                std::scoped_lock lock(*mutex);
+                auto it = pipelines.find(key);
+                if (it != pipelines.end()
+                    && !pipeline_objects_expired(it->second->fast->config()))
+                {
+                    if (it->second->optimized != nullptr)
+                    {
+                        return it->second->optimized;
+                    }
+                    return it->second->fast;
+                }
             }
 
-            VkSwapchainCreateInfoKHR create_info{
-                .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-                .pNext = nullptr,
-                .flags = sc->config().flags,
-                .surface = surface->handle(),
-                .minImageCount = sc->config().min_image_count,
-                .imageFormat = sc->config().image_format,
-                .imageColorSpace = sc->config().image_color_space,
-                .imageExtent = Extent2d_to_vk(sc->config().image_extent),
-                .imageArrayLayers = sc->config().image_array_layers,
-                .imageUsage = sc->config().image_usage,
-                .imageSharingMode = sc->config().image_sharing_mode,
-
-                .queueFamilyIndexCount =
-                (uint32_t)sc->config().queue_family_indices.size(),
-
-                .pQueueFamilyIndices = sc->config().queue_family_indices.data(),
-                .preTransform = sc->config().pre_transform,
-                .compositeAlpha = sc->config().composite_alpha,
-                .presentMode = sc->config().present_mode,
-                .clipped = sc->config().clipped,
-                .oldSwapchain = vk_old_swapchain
-            };
-
-            VkResult vk_result = vkCreateSwapchainKHR(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &sc->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+            std::vector<GraphicsPipelinePtr> parts;
+            for (auto part : GRAPHICS_PIPELINE_LIBRARY_PARTS)
             {
-                throw Error(vk_result);
+                parts.push_back(get_library(config, part));
             }
 
-            uint32_t actual_image_count;
-            vkGetSwapchainImagesKHR(
-                device->handle(),
-                sc->handle(),
-                &actual_image_count,
-                nullptr
-            );
-
-            std::vector<VkImage> vk_images(actual_image_count);
-            vk_result = vkGetSwapchainImagesKHR(
-                device->handle(),
-                sc->handle(),
-                &actual_image_count,
-                vk_images.data()
-            );
-            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            auto device_locked = lock_wptr(device());
+            PipelineCachePtr cache_locked = _cache.lock();
+
+            auto linked = std::make_shared<LinkedPipeline>(LinkedPipeline{
+                .fast = GraphicsPipeline::create(
+                    device_locked,
+                    library_link_config(config, parts, false),
+                    cache_locked
+                ),
+                .optimized = nullptr
+            });
+
+            // the lock isn't held while linking. if another thread linked the
+            // same pipeline in the meantime, theirs is kept.
             {
-                throw Error(
-                    "failed to retrieve swapchain images after creating it",
-                    vk_result,
-                    false
-                );
+                std::scoped_lock lock(*mutex);
+                auto& entry = pipelines[key];
+                if (entry != nullptr
+                    && !pipeline_objects_expired(entry->fast->config()))
+                {
+                    if (entry->optimized != nullptr)
+                    {
+                        return entry->optimized;
+                    }
+                    return entry->fast;
+                }
+                entry = linked;
             }
 
-            sc->_images.reserve(actual_image_count);
-            for (auto vk_image : vk_images)
+            // the job holds on to the libraries in case they're pruned
             {
-                sc->_images.push_back(
-                    std::make_shared<Image_public_ctor>(vk_image)
+                std::scoped_lock lock(background_queue->mutex);
+                background_queue->n_pending++;
+                background_queue->jobs.push_back(
+                    [
+                        device_locked,
+                        cache_locked,
+                        link_config = library_link_config(config, parts, true),
+                        parts,
+                        linked,
+                        mutex = mutex
+                    ]()
+                    {
+                        try
+                        {
+                            auto optimized = GraphicsPipeline::create(
+                                device_locked,
+                                link_config,
+                                cache_locked
+                            );
+                            std::scoped_lock lock(*mutex);
+                            linked->optimized = optimized;
+                        }
+                        catch (...)
+                        {
+                            // the fast-linked pipeline keeps being used.
+                            // nothing may escape, n_pending still has to be
+                            // decremented after the job.
+                        }
+                    }
                 );
             }
+            background_queue->cv.notify_one();
 
-            return sc;
+            return linked->fast;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create swapchain: " + e.to_string(),
+                "failed to get linked graphics pipeline: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    uint32_t Swapchain::acquire_next_image(
-        const SemaphorePtr& semaphore,
-        const FencePtr& fence,
-        uint64_t timeout,
-        VkResult* out_vk_result
-    )
+    void PipelineLibraryLinker::wait_idle()
+    {
+        std::unique_lock lock(background_queue->mutex);
+        background_queue->idle_cv.wait(
+            lock,
+            [&]()
+            {
+                return background_queue->n_pending == 0;
+            }
+        );
+    }
+
+    size_t PipelineLibraryLinker::n_pending() const
+    {
+        std::scoped_lock lock(background_queue->mutex);
+        return background_queue->n_pending;
+    }
+
+    void PipelineLibraryLinker::prune()
+    {
+        std::scoped_lock lock(*mutex);
+        std::erase_if(
+            pipelines,
+            [](const auto& entry)
+            {
+                return pipeline_objects_expired(entry.second->fast->config());
+            }
+        );
+        std::erase_if(
+            libraries,
+            [](const auto& entry)
+            {
+                return pipeline_objects_expired(entry.second->config());
+            }
+        );
+    }
+
+    void PipelineLibraryLinker::clear()
+    {
+        std::scoped_lock lock(*mutex);
+        pipelines.clear();
+        libraries.clear();
+    }
+
+    size_t PipelineLibraryLinker::size() const
+    {
+        std::scoped_lock lock(*mutex);
+        return pipelines.size();
+    }
+
+    PipelineLibraryLinker::~PipelineLibraryLinker()
     {
-        try
+        // moved from
+        if (background_queue == nullptr)
         {
-            uint32_t image_index;
-            VkResult vk_result = vkAcquireNextImageKHR(
-                lock_wptr(device())->handle(),
-                handle(),
-                timeout,
-                semaphore == nullptr ? nullptr : semaphore->handle(),
-                fence == nullptr ? nullptr : fence->handle(),
-                &image_index
-            );
-            if (out_vk_result != nullptr)
-            {
-                *out_vk_result = vk_result;
-            }
-            if (vk_result == VK_SUCCESS
-                || vk_result == VK_SUBOPTIMAL_KHR)
-            {
-                return image_index;
-            }
-            throw Error(vk_result);
+            return;
         }
-        catch (const Error& e)
+
+        // optimized pipelines that haven't been started are dropped
         {
-            throw Error(
-                "failed to acquire next swapchain image: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            std::scoped_lock lock(background_queue->mutex);
+            background_queue->stop = true;
+            background_queue->n_pending -= background_queue->jobs.size();
+            background_queue->jobs.clear();
         }
+        background_queue->cv.notify_all();
+        background_thread.join();
     }
 
-    Swapchain::~Swapchain()
+    PipelineLibraryLinker::PipelineLibraryLinker(
+        const DevicePtr& device,
+        const PipelineCachePtr& cache
+    )
+        : _device(device),
+        _cache(cache),
+        mutex(std::make_shared<std::mutex>()),
+        background_queue(std::make_shared<BackgroundQueue>())
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        background_thread = std::thread(
+            [background_queue = background_queue]()
+            {
+                while (true)
+                {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock lock(background_queue->mutex);
+                        background_queue->cv.wait(
+                            lock,
+                            [&]()
+                            {
+                                return background_queue->stop
+                                    || !background_queue->jobs.empty();
+                            }
+                        );
+                        if (background_queue->stop)
+                        {
+                            return;
+                        }
+                        job = std::move(background_queue->jobs.front());
+                        background_queue->jobs.pop_front();
+                    }
+                    job();
 
-        vkDestroySwapchainKHR(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
+                    {
+                        std::scoped_lock lock(background_queue->mutex);
+                        background_queue->n_pending--;
+                    }
+                    background_queue->idle_cv.notify_all();
+                }
+            }
         );
     }
 
-    Swapchain::Swapchain(
-        const DevicePtr& device,
-        const SurfacePtr& surface,
-        const SwapchainConfig& config,
-        const SwapchainPtr& old_swapchain
+    GraphicsPipelinePtr PipelineLibraryLinker::get_library(
+        const GraphicsPipelineConfig& config,
+        VkGraphicsPipelineLibraryFlagBitsEXT part
     )
-        : _device(device),
-        _surface(surface),
-        _config(config),
-        _old_swapchain(std::nullopt)
     {
-        if (old_swapchain != nullptr)
+        // the libraries are linked twice, the second time with link time
+        // optimization which needs this flag
+        GraphicsPipelineConfig part_config =
+            GraphicsPipelineConfig_library_part(config, part);
+        part_config.flags |=
+            VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+        auto key = GraphicsPipelineConfig_key(part_config);
         {
-            _old_swapchain = old_swapchain;
+            std::scoped_lock lock(*mutex);
+            auto it = libraries.find(key);
+            if (it != libraries.end()
+                && !pipeline_objects_expired(it->second->config()))
+            {
+                return it->second;
+            }
+        }
+
+        auto library = GraphicsPipeline::create(
+            lock_wptr(device()),
+            part_config,
+            _cache.lock()
+        );
+
+        std::scoped_lock lock(*mutex);
+        auto& entry = libraries[key];
+        if (entry != nullptr && !pipeline_objects_expired(entry->config()))
+        {
+            return entry;
         }
+        entry = library;
+        return library;
     }
 
-    ImageViewPtr ImageView::create(
+    QueryPoolPtr QueryPool::create(
         const DevicePtr& device,
-        const ImagePtr& image,
-        const ImageViewConfig& config
+        const QueryPoolConfig& config
     )
     {
         try
         {
-            ImageViewPtr view = std::make_shared<ImageView_public_ctor>(
+            QueryPoolPtr pool = std::make_shared<QueryPool_public_ctor>(
                 device,
-                image,
                 config
             );
 
-            VkImageViewCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            VkQueryPoolCreateInfo create_info{
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
                 .pNext = nullptr,
-                .flags = view->config().flags,
-                .image = lock_wptr(view->image())->handle(),
-                .viewType = view->config().view_type,
-                .format = view->config().format,
-                .components = ComponentMapping_to_vk(view->config().components),
-                .subresourceRange = ImageSubresourceRange_to_vk(
-                    view->config().subresource_range
-                )
+                .flags = 0,
+                .queryType = pool->config().query_type,
+                .queryCount = pool->config().query_count,
+                .pipelineStatistics = pool->config().pipeline_statistics
             };
 
-            VkResult vk_result = vkCreateImageView(
+            VkResult vk_result = device->dispatch().vkCreateQueryPool(
                 device->handle(),
                 &create_info,
                 lock_wptr(device->context())->vk_allocator_ptr(),
-                &view->_handle
+                &pool->_handle
             );
             if (vk_result != VK_SUCCESS)
             {
                 throw Error(vk_result);
             }
-            return view;
+            return pool;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create image view: " + e.to_string(),
+                "failed to create query pool: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    ImageView::~ImageView()
+    uint32_t QueryPool::values_per_query() const
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkDestroyImageView(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        if (config().query_type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+        {
+            return (uint32_t)std::popcount(
+                (uint32_t)config().pipeline_statistics
+            );
+        }
+        return 1;
     }
 
-    ImageView::ImageView(
-        const DevicePtr& device,
-        const ImagePtr& image,
-        const ImageViewConfig& config
-    )
-        : _device(device),
-        _image(image),
-        _config(config)
-    {}
-
-    ShaderModulePtr ShaderModule::create(
-        const DevicePtr& device,
-        const std::vector<uint8_t>& code
+    bool QueryPool::get_results(
+        uint32_t first_query,
+        uint32_t query_count,
+        std::span<uint64_t> results,
+        VkQueryResultFlags flags
     )
     {
         try
         {
-            ShaderModulePtr module = std::make_shared<ShaderModule_public_ctor>(
-                device
-            );
-
-            std::vector<uint8_t> code_aligned;
-            bool needs_alignment = (code.size() % 8 != 0);
-            if (needs_alignment)
+            uint32_t stride = values_per_query();
+            if (flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)
             {
-                code_aligned = code;
-                for (size_t i = 0; i < 8 - (code.size() % 8); i++)
-                {
-                    code_aligned.push_back(0);
-                }
+                stride++;
+            }
+            if (results.size() < (size_t)stride * query_count)
+            {
+                throw Error("results span is too small");
             }
 
-            VkShaderModuleCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0,
-                .codeSize = code.size(),
-                .pCode = reinterpret_cast<const uint32_t*>(
-                    needs_alignment ? code_aligned.data() : code.data()
-                    )
-            };
-
-            VkResult vk_result = vkCreateShaderModule(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &module->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result =
+                device_locked->dispatch().vkGetQueryPoolResults(
+                    device_locked->handle(),
+                    handle(),
+                    first_query,
+                    query_count,
+                    results.size_bytes(),
+                    results.data(),
+                    stride * sizeof(uint64_t),
+                    flags | VK_QUERY_RESULT_64_BIT
+                );
+            if (vk_result == VK_SUCCESS)
             {
-                throw Error(vk_result);
+                return true;
             }
-            return module;
+            else if (vk_result == VK_NOT_READY)
+            {
+                return false;
+            }
+            throw Error(vk_result);
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create shader module: " + e.to_string(),
+                "failed to get query pool results: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    ShaderModule::~ShaderModule()
+    QueryPool::~QueryPool()
     {
         _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
         _BV_LOCK_WPTR_OR_RETURN(
@@ -3354,2422 +12598,4399 @@ namespace bv
             context_locked
         );
 
-        vkDestroyShaderModule(
+        device_locked->dispatch().vkDestroyQueryPool(
             device_locked->handle(),
             handle(),
             context_locked->vk_allocator_ptr()
         );
     }
 
-    ShaderModule::ShaderModule(const DevicePtr& device)
-        : _device(device)
+    QueryPool::QueryPool(
+        const DevicePtr& device,
+        const QueryPoolConfig& config
+    )
+        : _device(device), _config(config)
     {}
 
-    SamplerPtr Sampler::create(
-        const DevicePtr& device,
-        const SamplerConfig& config
+#pragma endregion
+
+#pragma region helper functions
+
+    std::string cstr_to_std(const char* cstr)
+    {
+        return (cstr == nullptr) ? std::string() : std::string(cstr);
+    }
+
+    bool format_has_depth_component(VkFormat format)
+    {
+        return
+            format == VK_FORMAT_D16_UNORM
+            || format == VK_FORMAT_X8_D24_UNORM_PACK32
+            || format == VK_FORMAT_D32_SFLOAT
+            || format == VK_FORMAT_D16_UNORM_S8_UINT
+            || format == VK_FORMAT_D24_UNORM_S8_UINT
+            || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    bool format_has_stencil_component(VkFormat format)
+    {
+        return
+            format == VK_FORMAT_S8_UINT
+            || format == VK_FORMAT_D16_UNORM_S8_UINT
+            || format == VK_FORMAT_D24_UNORM_S8_UINT
+            || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+#pragma endregion
+
+#pragma region memory management
+
+    static uint32_t find_memory_type_idx(
+        const bv::PhysicalDevice& physical_device,
+        uint32_t supported_type_bits,
+        VkMemoryPropertyFlags required_properties,
+        VkDeviceSize required_size
     )
     {
-        try
+        const auto& mem_props = physical_device.memory_properties();
+        for (uint32_t i = 0; i < mem_props.memory_types.size(); i++)
         {
-            SamplerPtr sampler = std::make_shared<Sampler_public_ctor>(
-                device,
-                config
-            );
-
-            VkSamplerCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = sampler->config().flags,
-                .magFilter = sampler->config().mag_filter,
-                .minFilter = sampler->config().min_filter,
-                .mipmapMode = sampler->config().mipmap_mode,
-                .addressModeU = sampler->config().address_mode_u,
-                .addressModeV = sampler->config().address_mode_v,
-                .addressModeW = sampler->config().address_mode_w,
-                .mipLodBias = sampler->config().mip_lod_bias,
-                .anisotropyEnable = sampler->config().anisotropy_enable,
-                .maxAnisotropy = sampler->config().max_anisotropy,
-                .compareEnable = sampler->config().compare_enable,
-                .compareOp = sampler->config().compare_op,
-                .minLod = sampler->config().min_lod,
-                .maxLod = sampler->config().max_lod,
-                .borderColor = sampler->config().border_color,
+            bool has_required_properties =
+                (required_properties & mem_props.memory_types[i].property_flags)
+                == required_properties;
 
-                .unnormalizedCoordinates =
-                sampler->config().unnormalized_coordinates
-            };
+            if (!(supported_type_bits & (1 << i)) || !has_required_properties)
+            {
+                continue;
+            }
 
-            VkResult vk_result = vkCreateSampler(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &sampler->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+            VkDeviceSize heap_size = mem_props.memory_heaps[
+                mem_props.memory_types[i].heap_index
+            ].size;
+            if (required_size > heap_size)
             {
-                throw Error(vk_result);
+                continue;
             }
-            return sampler;
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to create sampler: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+
+            return i;
         }
+        throw Error("failed to find a suitable memory type");
+    }
+
+    MemoryRegion::MemoryRegion(const bv::DeviceMemoryPtr& mem)
+        : mem(mem)
+    {}
+
+    const bv::DeviceMemoryPtr& MemoryChunk::memory() const
+    {
+        return region->mem;
     }
 
-    Sampler::~Sampler()
+    void MemoryChunk::bind(bv::BufferPtr& buffer)
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        buffer->bind_memory(memory(), offset());
+    }
 
-        vkDestroySampler(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+    void MemoryChunk::bind(bv::ImagePtr& image)
+    {
+        image->bind_memory(memory(), offset());
     }
 
-    Sampler::Sampler(
-        const DevicePtr& device,
-        const SamplerConfig& config
-    )
-        : _device(device),
-        _config(config)
-    {}
+    void* MemoryChunk::mapped()
+    {
+        if (region->mapped == nullptr)
+        {
+            throw Error("failed to map memory chunk: unmappable memory");
+        }
+        return (void*)((uint8_t*)region->mapped + offset());
+    }
 
-    DescriptorSetLayoutPtr DescriptorSetLayout::create(
-        const DevicePtr& device,
-        const DescriptorSetLayoutConfig& config
-    )
+    void MemoryChunk::flush()
     {
-        try
+        if (region->mapped != nullptr)
         {
-            DescriptorSetLayoutPtr layout =
-                std::make_shared<DescriptorSetLayout_public_ctor>(
-                    device,
-                    config
-                );
+            region->mem->flush_mapped_range(0, VK_WHOLE_SIZE);
+        }
+    }
 
-            std::vector<VkDescriptorSetLayoutBinding> vk_bindings(
-                layout->config().bindings.size()
-            );
-            std::vector<std::vector<VkSampler>> wastes_vk_immutable_samplers(
-                layout->config().bindings.size()
-            );
-            for (size_t i = 0; i < layout->config().bindings.size(); i++)
+    void MemoryChunk::invalidate(VkDeviceSize offset, VkDeviceSize size)
+    {
+        if (region->mapped == nullptr || region->coherent)
+        {
+            return;
+        }
+
+        try
+        {
+            if (size == VK_WHOLE_SIZE)
             {
-                vk_bindings[i] = DescriptorSetLayoutBinding_to_vk(
-                    layout->config().bindings[i],
-                    wastes_vk_immutable_samplers[i]
-                );
+                size = this->size() - offset;
             }
 
-            VkDescriptorSetLayoutCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = layout->config().flags,
-                .bindingCount = (uint32_t)vk_bindings.size(),
-                .pBindings = vk_bindings.data()
-            };
-
-            VkResult vk_result = vkCreateDescriptorSetLayout(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &layout->_handle
+            // the range must be aligned to nonCoherentAtomSize relative to the
+            // start of the memory object
+            VkDeviceSize atom_size = lock_wptr(memory()->device())
+                ->physical_device().properties().limits.non_coherent_atom_size;
+            VkDeviceSize begin = ((this->offset() + offset) / atom_size)
+                * atom_size;
+            VkDeviceSize end = std::min(
+                _BV_IDIV_CEIL(this->offset() + offset + size, atom_size)
+                * atom_size,
+                memory()->config().allocation_size
             );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return layout;
+
+            memory()->invalidate_mapped_range(begin, end - begin);
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create descriptor set layout: " + e.to_string(),
+                "failed to invalidate memory chunk: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    DescriptorSetLayout::~DescriptorSetLayout()
+    MemoryChunk::~MemoryChunk()
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        std::scoped_lock lock(*mutex);
 
-        vkDestroyDescriptorSetLayout(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        // set the block bits to free
+        uint64_t start_block_idx = offset() / block_size;
+        uint64_t end_block_idx = _BV_IDIV_CEIL(offset() + size(), block_size);
+        for (size_t i = start_block_idx; i < end_block_idx; i++)
+        {
+            region->blocks[i] = false;
+        }
     }
 
-    DescriptorSetLayout::DescriptorSetLayout(
-        const DevicePtr& device,
-        const DescriptorSetLayoutConfig& config
+    MemoryChunk::MemoryChunk(
+        const std::shared_ptr<std::mutex>& mutex,
+        const MemoryRegionPtr& region,
+        VkDeviceSize offset,
+        VkDeviceSize size,
+        VkDeviceSize block_size
     )
-        : _device(device),
-        _config(config)
+        : mutex(mutex),
+        region(region),
+        _offset(offset),
+        _size(size),
+        block_size(block_size)
     {}
 
-    PipelineLayoutPtr PipelineLayout::create(
+    MemoryBankPtr MemoryBank::create(
         const DevicePtr& device,
-        const PipelineLayoutConfig& config
+        VkDeviceSize block_size,
+        VkDeviceSize min_region_size
+    )
+    {
+        return std::make_shared<MemoryBank_public_ctor>(
+            device,
+            block_size,
+            min_region_size
+        );
+    }
+
+    MemoryChunkPtr MemoryBank::allocate(
+        const bv::MemoryRequirements& requirements,
+        VkMemoryPropertyFlags required_properties,
+        VkMemoryPropertyFlags preferred_properties
     )
     {
+        BV_TRACE_ZONE("bv::MemoryBank::allocate");
+
         try
         {
-            PipelineLayoutPtr layout =
-                std::make_shared<PipelineLayout_public_ctor>(
-                    device,
-                    config
-                );
+            std::scoped_lock lock(*mutex);
 
-            std::vector<VkDescriptorSetLayout> vk_set_layouts(
-                layout->config().set_layouts.size()
-            );
-            for (size_t i = 0; i < layout->config().set_layouts.size(); i++)
+            // make sure the chunk size is divisible by the block size
+            uint64_t chunk_size = requirements.size;
+            if (chunk_size % block_size() != 0)
             {
-                vk_set_layouts[i] =
-                    lock_wptr(layout->config().set_layouts[i])->handle();
+                chunk_size += block_size() - (chunk_size % block_size());
+            }
+
+            uint64_t n_blocks_in_chunk =
+                _BV_IDIV_CEIL(chunk_size, block_size());
+
+            const auto& mem_props =
+                device()->physical_device().memory_properties();
+
+            // require the preferred properties too if any compatible memory
+            // type has them
+            if (preferred_properties != 0)
+            {
+                VkMemoryPropertyFlags all_properties =
+                    required_properties | preferred_properties;
+                for (uint32_t i = 0; i < mem_props.memory_types.size(); i++)
+                {
+                    if ((requirements.memory_type_bits & (1 << i))
+                        && (mem_props.memory_types[i].property_flags
+                            & all_properties) == all_properties)
+                    {
+                        required_properties = all_properties;
+                        break;
+                    }
+                }
             }
 
-            std::vector<VkPushConstantRange> vk_push_constant_ranges(
-                layout->config().push_constant_ranges.size()
-            );
-            for (size_t i = 0;
-                i < layout->config().push_constant_ranges.size();
-                i++)
-            {
-                vk_push_constant_ranges[i] = PushConstantRange_to_vk(
-                    layout->config().push_constant_ranges[i]
-                );
-            }
+            for (auto& region : regions)
+            {
+                // check if region is large enough
+                if (chunk_size > region->mem->config().allocation_size)
+                {
+                    continue;
+                }
+
+                // check if region has a compatible memory type
+                if (!(
+                    requirements.memory_type_bits
+                    & (1 << region->mem->config().memory_type_index)
+                    ))
+                {
+                    continue;
+                }
+
+                // check if region's memory type has the required properties
+                uint32_t mem_type_idx = region->mem->config().memory_type_index;
+                bool has_required_properties =
+                    (required_properties
+                        & mem_props.memory_types[mem_type_idx].property_flags)
+                    == required_properties;
+                if (!has_required_properties)
+                {
+                    continue;
+                }
+
+                // try to find a free range and return a chunk if found
+                uint64_t start_block_idx = 0;
+                while (true)
+                {
+                    while (start_block_idx < region->blocks.size()
+                        && region->blocks[start_block_idx])
+                    {
+                        start_block_idx++;
+                    }
+                    if (start_block_idx >= region->blocks.size())
+                    {
+                        break;
+                    }
+
+                    uint64_t end_block_idx = start_block_idx + 1;
+                    while (end_block_idx < region->blocks.size()
+                        && !region->blocks[end_block_idx])
+                    {
+                        end_block_idx++;
+                    }
+
+                    uint64_t n_free_blocks = end_block_idx - start_block_idx;
+
+                    // if we have found a free and usable block range
+                    if (n_free_blocks >= n_blocks_in_chunk)
+                    {
+                        // figure out the byte offset in the region
+                        VkDeviceSize offs = start_block_idx * block_size();
+
+                        // adjust the offset if it doesn't meet the alignment
+                        // requirements
+                        if (offs % requirements.alignment != 0)
+                        {
+                            offs +=
+                                requirements.alignment
+                                - (offs % requirements.alignment);
+                        }
+
+                        // recalculate the start block index
+                        start_block_idx = offs / block_size();
+
+                        // if the start block index is now stepping into the
+                        // end of the range, we'll restart the search.
+                        if (start_block_idx >= end_block_idx)
+                        {
+                            continue;
+                        }
+
+                        // recalculate the new number of free blocks
+                        n_free_blocks = end_block_idx - start_block_idx;
+
+                        // if the new number of free blocks is no longer large
+                        // enough, we'll restart the search.
+                        if (n_free_blocks < n_blocks_in_chunk)
+                        {
+                            start_block_idx = end_block_idx;
+                            continue;
+                        }
+
+                        // set the block bits to allocated
+                        for (size_t i = start_block_idx;
+                            i < start_block_idx + n_blocks_in_chunk;
+                            i++)
+                        {
+                            region->blocks[i] = true;
+                        }
 
-            VkPipelineLayoutCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = layout->config().flags,
-                .setLayoutCount = (uint32_t)vk_set_layouts.size(),
-                .pSetLayouts = vk_set_layouts.data(),
+                        // make a copy of the region pointer to avoid losing it
+                        // when we delete empty regions.
+                        bv::MemoryRegionPtr region_ptr_copy = region;
 
-                .pushConstantRangeCount =
-                (uint32_t)vk_push_constant_ranges.size(),
+                        // delete empty regions
+                        delete_empty_regions();
 
-                .pPushConstantRanges = vk_push_constant_ranges.data()
-            };
+                        // return a new chunk based on the region
+                        return std::make_shared<MemoryChunk_public_ctor>(
+                            mutex,
+                            region_ptr_copy,
+                            offs,
+                            chunk_size,
+                            block_size()
+                        );
+                    }
 
-            VkResult vk_result = vkCreatePipelineLayout(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &layout->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
+                    // continue the search
+                    start_block_idx = end_block_idx;
+                }
             }
-            return layout;
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to create pipeline layout: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
-        }
-    }
-
-    PipelineLayout::~PipelineLayout()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
 
-        vkDestroyPipelineLayout(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
-    }
+            // couldn't find a usable range in any of the regions, so we'll
+            // create a new region and use it instead.
 
-    PipelineLayout::PipelineLayout(
-        const DevicePtr& device,
-        const PipelineLayoutConfig& config
-    )
-        : _device(device), _config(config)
-    {}
+            // figure out the allocation size and make sure it's divisible by
+            // the block size.
+            VkDeviceSize region_size = std::max(chunk_size, min_region_size());
+            if (region_size % block_size() != 0)
+            {
+                region_size += block_size() - (region_size % block_size());
+            }
 
-    RenderPassPtr RenderPass::create(
-        const DevicePtr& device,
-        const RenderPassConfig& config
-    )
-    {
-        try
-        {
-            RenderPassPtr pass = std::make_shared<RenderPass_public_ctor>(
-                device,
-                config
+            // find suitable memory type index
+            uint32_t memory_type_idx = find_memory_type_idx(
+                device()->physical_device(),
+                requirements.memory_type_bits,
+                required_properties,
+                region_size
             );
 
-            std::vector<VkAttachmentDescription> vk_attachments(
-                pass->config().attachments.size()
+            // allocate memory
+            auto mem = bv::DeviceMemory::allocate(
+                device(),
+                {
+                    .allocation_size = region_size,
+                    .memory_type_index = memory_type_idx
+                }
             );
-            for (size_t i = 0; i < pass->config().attachments.size(); i++)
-            {
-                vk_attachments[i] = Attachment_to_vk(
-                    pass->config().attachments[i]
-                );
-            }
 
-            std::vector<VkSubpassDescription> vk_subpasses(
-                pass->config().subpasses.size()
+            // create a region based on that memory
+            auto new_region = std::make_shared<MemoryRegion_public_ctor>(mem);
+
+            // setup the block bitset for the region
+            new_region->blocks.resize(
+                _BV_IDIV_CEIL(region_size, block_size()),
+                false
             );
-            std::vector<std::vector<VkAttachmentReference>>
-                wastes_vk_input_attachments(pass->config().subpasses.size());
-            std::vector<std::vector<VkAttachmentReference>>
-                wastes_vk_color_attachments(pass->config().subpasses.size());
-            std::vector<std::vector<VkAttachmentReference>>
-                wastes_vk_resolve_attachments(pass->config().subpasses.size());
-            std::vector<VkAttachmentReference>
-                wastes_vk_depth_stencil_attachment(
-                    pass->config().subpasses.size()
-                );
-            std::vector<std::vector<uint32_t>>
-                wastes_preserve_attachment_indices(
-                    pass->config().subpasses.size()
-                );
-            for (size_t i = 0; i < pass->config().subpasses.size(); i++)
+            for (size_t i = 0; i < n_blocks_in_chunk; i++)
             {
-                vk_subpasses[i] = Subpass_to_vk(
-                    pass->config().subpasses[i],
-                    wastes_vk_input_attachments[i],
-                    wastes_vk_color_attachments[i],
-                    wastes_vk_resolve_attachments[i],
-                    wastes_vk_depth_stencil_attachment[i],
-                    wastes_preserve_attachment_indices[i]
-                );
+                new_region->blocks[i] = true;
             }
 
-            std::vector<VkSubpassDependency> vk_dependencies(
-                pass->config().dependencies.size()
-            );
-            for (size_t i = 0; i < pass->config().dependencies.size(); i++)
+            // map the memory if it's mappable
+            bool is_mappable =
+                (required_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+                || (required_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            if (is_mappable)
             {
-                vk_dependencies[i] = SubpassDependency_to_vk(
-                    pass->config().dependencies[i]
-                );
+                new_region->mapped = mem->map(0, VK_WHOLE_SIZE);
             }
+            new_region->coherent =
+                mem_props.memory_types[memory_type_idx].property_flags
+                & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-            VkRenderPassCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = pass->config().flags,
-                .attachmentCount = (uint32_t)vk_attachments.size(),
-                .pAttachments = vk_attachments.data(),
-                .subpassCount = (uint32_t)vk_subpasses.size(),
-                .pSubpasses = vk_subpasses.data(),
-                .dependencyCount = (uint32_t)vk_dependencies.size(),
-                .pDependencies = vk_dependencies.data()
-            };
+            // delete empty regions
+            delete_empty_regions();
 
-            VkResult vk_result = vkCreateRenderPass(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &pass->_handle
+            // add the region to our regions vector
+            regions.push_back(new_region);
+
+            // return a new chunk based on the region
+            return std::make_shared<MemoryChunk_public_ctor>(
+                mutex,
+                new_region,
+                0,
+                chunk_size,
+                block_size()
             );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return pass;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create render pass: " + e.to_string(),
+                "failed to allocate chunk from memory bank: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    RenderPass::~RenderPass()
+    std::string MemoryBank::to_string()
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        std::scoped_lock lock(*mutex);
 
-        vkDestroyRenderPass(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
+        std::string s = std::format(
+            "-----------------------------------------\n"
+            "memory bank status\n"
+            "  n. regions: {}\n"
+            "  block size: {}\n",
+            regions.size(),
+            block_size()
         );
+        for (size_t i = 0; i < regions.size(); i++)
+        {
+            const auto& region = regions[i];
+            s += std::format(
+                "-----------------------------------------\n"
+                "region {}\n"
+                "  size: {}\n"
+                "  mapped: {}\n"
+                "  blocks: {} blocks allocated out of {}\n",
+                i,
+                region->mem->config().allocation_size,
+                region->mapped != nullptr,
+                region->blocks.count(),
+                region->blocks.size()
+            );
+        }
+        s += "-----------------------------------------\n";
+        return s;
     }
 
-    RenderPass::RenderPass(
-        const DevicePtr& device,
-        const RenderPassConfig& config
+    MemoryBank::~MemoryBank()
+    {
+        std::scoped_lock lock(*mutex);
+    }
+
+    MemoryBank::MemoryBank(
+        const bv::DevicePtr& device,
+        VkDeviceSize block_size,
+        VkDeviceSize min_region_size
     )
-        : _device(device), _config(config)
+        : _device(device),
+        mutex(std::make_shared<std::mutex>()),
+        _block_size(block_size),
+        _min_region_size(min_region_size)
     {}
 
-    GraphicsPipelinePtr GraphicsPipeline::create(
-        const DevicePtr& device,
-        const GraphicsPipelineConfig& config,
-        const PipelineCachePtr& cache
-    )
+    void MemoryBank::delete_empty_regions()
     {
-        try
+        for (size_t i = 0; i < regions.size();)
         {
-            GraphicsPipelinePtr pipe =
-                std::make_shared<GraphicsPipeline_public_ctor>(
-                    device,
-                    config,
-                    cache
-                );
-
-            std::vector<VkPipelineShaderStageCreateInfo> vk_stages(
-                pipe->config().stages.size()
-            );
-            std::vector<VkSpecializationInfo> wastes_vk_specialization_info(
-                pipe->config().stages.size()
-            );
-            std::vector<std::vector<VkSpecializationMapEntry>>
-                wastes_vk_map_entries(pipe->config().stages.size());
-            std::vector<std::vector<uint8_t>> wastes_data(
-                pipe->config().stages.size()
-            );
-            for (size_t i = 0; i < pipe->config().stages.size(); i++)
-            {
-                vk_stages[i] = ShaderStage_to_vk(
-                    pipe->config().stages[i],
-                    wastes_vk_specialization_info[i],
-                    wastes_vk_map_entries[i],
-                    wastes_data[i]
-                );
-            }
-
-            VkPipelineVertexInputStateCreateInfo vk_vertex_input_state{};
-            std::vector<VkVertexInputBindingDescription>
-                waste_vk_binding_descriptions;
-            std::vector<VkVertexInputAttributeDescription>
-                waste_vk_attribute_descriptions;
-            if (pipe->config().vertex_input_state.has_value())
+            if (regions[i]->blocks.none())
             {
-                vk_vertex_input_state = VertexInputState_to_vk(
-                    pipe->config().vertex_input_state.value(),
-                    waste_vk_binding_descriptions,
-                    waste_vk_attribute_descriptions
-                );
+                regions.erase(regions.begin() + i);
             }
-
-            VkPipelineInputAssemblyStateCreateInfo vk_input_assembly_state{};
-            if (pipe->config().input_assembly_state.has_value())
+            else
             {
-                vk_input_assembly_state = InputAssemblyState_to_vk(
-                    pipe->config().input_assembly_state.value()
-                );
+                i++;
             }
+        }
 
-            VkPipelineTessellationStateCreateInfo vk_tessellation_state{};
-            if (pipe->config().tessellation_state.has_value())
-            {
-                vk_tessellation_state = TessellationState_to_vk(
-                    pipe->config().tessellation_state.value()
-                );
-            }
+    }
 
-            VkPipelineViewportStateCreateInfo vk_viewport_state{};
-            std::vector<VkViewport> waste_vk_viewports;
-            std::vector<VkRect2D> waste_vk_scissors;
-            if (pipe->config().viewport_state.has_value())
-            {
-                vk_viewport_state = ViewportState_to_vk(
-                    pipe->config().viewport_state.value(),
-                    waste_vk_viewports,
-                    waste_vk_scissors
-                );
-            }
+#pragma endregion
 
-            VkPipelineRasterizationStateCreateInfo vk_rasterization_state{};
-            if (pipe->config().rasterization_state.has_value())
-            {
-                vk_rasterization_state = RasterizationState_to_vk(
-                    pipe->config().rasterization_state.value()
-                );
-            }
+#pragma region render graph
 
-            VkPipelineMultisampleStateCreateInfo vk_multisample_state{};
-            std::vector<VkSampleMask> waste_sample_mask;
-            if (pipe->config().multisample_state.has_value())
-            {
-                vk_multisample_state = MultisampleState_to_vk(
-                    pipe->config().multisample_state.value(),
-                    waste_sample_mask
-                );
-            }
+    struct RenderGraphAccessInfo
+    {
+        VkImageLayout layout;
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        bool reads;
+        bool writes;
+        bool attachment;
+    };
+
+    static constexpr VkAccessFlags RENDER_GRAPH_WRITE_ACCESS_MASK =
+        VK_ACCESS_SHADER_WRITE_BIT
+        | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+        | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    static bool format_is_depth_stencil(VkFormat format)
+    {
+        return
+            format_has_depth_component(format)
+            || format_has_stencil_component(format);
+    }
 
-            VkPipelineDepthStencilStateCreateInfo vk_depth_stencil_state{};
-            if (pipe->config().depth_stencil_state.has_value())
-            {
-                vk_depth_stencil_state = DepthStencilState_to_vk(
-                    pipe->config().depth_stencil_state.value()
-                );
-            }
+    static VkImageAspectFlags render_graph_aspect_mask(
+        VkFormat format,
+        bool for_view
+    )
+    {
+        if (!format_is_depth_stencil(format))
+        {
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
 
-            VkPipelineColorBlendStateCreateInfo vk_color_blend_state{};
-            std::vector<VkPipelineColorBlendAttachmentState>
-                waste_vk_color_blend_attachments;
-            if (pipe->config().color_blend_state.has_value())
-            {
-                vk_color_blend_state = ColorBlendState_to_vk(
-                    pipe->config().color_blend_state.value(),
-                    waste_vk_color_blend_attachments
-                );
-            }
+        // views only use the depth aspect so that they can be sampled.
+        // barriers need both aspects for combined depth/stencil formats.
+        VkImageAspectFlags aspect = 0;
+        if (format_has_depth_component(format))
+        {
+            aspect |= VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+        if (format_has_stencil_component(format)
+            && (!for_view || aspect == 0))
+        {
+            aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        return aspect;
+    }
 
-            std::vector<VkDynamicState> waste_dynamic_states;
-            VkPipelineDynamicStateCreateInfo vk_dynamic_states =
-                DynamicStates_to_vk(
-                    pipe->config().dynamic_states,
-                    waste_dynamic_states
-                );
+    static RenderGraphAccessInfo render_graph_access_info(
+        const RenderGraphImageAccess& access,
+        VkQueueFlagBits queue,
+        VkFormat format
+    )
+    {
+        VkPipelineStageFlags shader_stages = access.stages;
+        if (shader_stages == 0)
+        {
+            shader_stages =
+                (queue == VK_QUEUE_COMPUTE_BIT)
+                ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
 
-            VkGraphicsPipelineCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = pipe->config().flags,
-                .stageCount = (uint32_t)vk_stages.size(),
-                .pStages = vk_stages.data(),
+        bool load = access.load_op == VK_ATTACHMENT_LOAD_OP_LOAD;
 
-                .pVertexInputState =
-                pipe->config().vertex_input_state.has_value()
-                ? &vk_vertex_input_state : nullptr,
+        switch (access.access)
+        {
+        case RenderGraphAccess::ColorAttachment:
+            return {
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .access = (VkAccessFlags)(
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                    | (load ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0)
+                    ),
+                .reads = load,
+                .writes = true,
+                .attachment = true
+            };
+        case RenderGraphAccess::DepthStencilAttachment:
+            return {
+                .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                .stages =
+                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                .access =
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                .reads = load,
+                .writes = true,
+                .attachment = true
+            };
+        case RenderGraphAccess::InputAttachment:
+            return {
+                .layout =
+                format_is_depth_stencil(format)
+                ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                .access = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+                .reads = true,
+                .writes = false,
+                .attachment = true
+            };
+        case RenderGraphAccess::Sampled:
+            return {
+                .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .stages = shader_stages,
+                .access = VK_ACCESS_SHADER_READ_BIT,
+                .reads = true,
+                .writes = false,
+                .attachment = false
+            };
+        case RenderGraphAccess::StorageRead:
+            return {
+                .layout = VK_IMAGE_LAYOUT_GENERAL,
+                .stages = shader_stages,
+                .access = VK_ACCESS_SHADER_READ_BIT,
+                .reads = true,
+                .writes = false,
+                .attachment = false
+            };
+        case RenderGraphAccess::StorageWrite:
+            return {
+                .layout = VK_IMAGE_LAYOUT_GENERAL,
+                .stages = shader_stages,
+                .access = VK_ACCESS_SHADER_WRITE_BIT,
+                .reads = false,
+                .writes = true,
+                .attachment = false
+            };
+        case RenderGraphAccess::StorageReadWrite:
+            return {
+                .layout = VK_IMAGE_LAYOUT_GENERAL,
+                .stages = shader_stages,
+                .access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                .reads = true,
+                .writes = true,
+                .attachment = false
+            };
+        case RenderGraphAccess::TransferSrc:
+            return {
+                .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .stages = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .access = VK_ACCESS_TRANSFER_READ_BIT,
+                .reads = true,
+                .writes = false,
+                .attachment = false
+            };
+        case RenderGraphAccess::TransferDst:
+            return {
+                .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .stages = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .access = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .reads = false,
+                .writes = true,
+                .attachment = false
+            };
+        default:
+            throw Error("invalid render graph access");
+        }
+    }
 
-                .pInputAssemblyState =
-                pipe->config().input_assembly_state.has_value()
-                ? &vk_input_assembly_state : nullptr,
+    static bool imageless_framebuffer_enabled(const DevicePtr& device)
+    {
+        const auto& vulkan12_features =
+            device->config().enabled_vulkan12_features;
+        return device->config().enable_imageless_framebuffer
+            || (vulkan12_features.has_value()
+                && vulkan12_features->imageless_framebuffer);
+    }
 
-                .pTessellationState =
-                pipe->config().tessellation_state.has_value()
-                ? &vk_tessellation_state : nullptr,
+    static VkImageUsageFlags render_graph_access_usage(
+        RenderGraphAccess access
+    )
+    {
+        switch (access)
+        {
+        case RenderGraphAccess::ColorAttachment:
+            return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        case RenderGraphAccess::DepthStencilAttachment:
+            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        case RenderGraphAccess::InputAttachment:
+            return VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+        case RenderGraphAccess::Sampled:
+            return VK_IMAGE_USAGE_SAMPLED_BIT;
+        case RenderGraphAccess::StorageRead:
+        case RenderGraphAccess::StorageWrite:
+        case RenderGraphAccess::StorageReadWrite:
+            return VK_IMAGE_USAGE_STORAGE_BIT;
+        case RenderGraphAccess::TransferSrc:
+            return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        case RenderGraphAccess::TransferDst:
+            return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        default:
+            return 0;
+        }
+    }
 
-                .pViewportState =
-                pipe->config().viewport_state.has_value()
-                ? &vk_viewport_state : nullptr,
+    static bool render_graph_access_is_attachment(RenderGraphAccess access)
+    {
+        return
+            access == RenderGraphAccess::ColorAttachment
+            || access == RenderGraphAccess::DepthStencilAttachment
+            || access == RenderGraphAccess::InputAttachment;
+    }
 
-                .pRasterizationState =
-                pipe->config().rasterization_state.has_value()
-                ? &vk_rasterization_state : nullptr,
+    // graphics passes with at least one attachment get a subpass in a render
+    // pass, everything else is recorded outside of render passes.
+    static bool render_graph_pass_is_raster(const RenderGraphPass& pass)
+    {
+        if (pass.queue != VK_QUEUE_GRAPHICS_BIT)
+        {
+            return false;
+        }
+        for (const auto& access : pass.accesses)
+        {
+            if (render_graph_access_is_attachment(access.access))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
-                .pMultisampleState =
-                pipe->config().multisample_state.has_value()
-                ? &vk_multisample_state : nullptr,
+    RenderGraphPtr RenderGraph::create(
+        const DevicePtr& device,
+        const MemoryBankPtr& mem_bank,
+        const RenderGraphConfig& config
+    )
+    {
+        return std::make_shared<RenderGraph_public_ctor>(
+            device,
+            mem_bank,
+            config
+        );
+    }
 
-                .pDepthStencilState =
-                pipe->config().depth_stencil_state.has_value()
-                ? &vk_depth_stencil_state : nullptr,
+    RenderGraphImageId RenderGraph::add_transient_image(
+        const RenderGraphTransientImage& image
+    )
+    {
+        _compiled = false;
+        images.push_back(ImageNode{
+            .name = image.name,
+            .format = image.format,
+            .extent = image.extent,
+            .samples = image.samples,
+            .imported = false
+            });
+        return (RenderGraphImageId)(images.size() - 1);
+    }
 
-                .pColorBlendState =
-                pipe->config().color_blend_state.has_value()
-                ? &vk_color_blend_state : nullptr,
+    RenderGraphImageId RenderGraph::import_image(
+        const RenderGraphImportedImage& image
+    )
+    {
+        _compiled = false;
+        images.push_back(ImageNode{
+            .name = image.name,
+            .format = image.format,
+            .extent = image.extent,
+            .samples = image.samples,
+            .imported = true,
+            .initial_layout = image.initial_layout,
+            .initial_stages = image.initial_stages,
+            .final_layout = image.final_layout
+            });
+        return (RenderGraphImageId)(images.size() - 1);
+    }
 
-                .pDynamicState =
-                pipe->config().dynamic_states.empty()
-                ? nullptr : &vk_dynamic_states,
+    RenderGraphPassId RenderGraph::add_pass(const RenderGraphPass& pass)
+    {
+        _compiled = false;
+        passes.push_back(pass);
+        return (RenderGraphPassId)(passes.size() - 1);
+    }
 
-                .layout = lock_wptr(pipe->config().layout)->handle(),
-                .renderPass = lock_wptr(pipe->config().render_pass)->handle(),
-                .subpass = pipe->config().subpass_index,
+    void RenderGraph::reset()
+    {
+        destroy_compiled_objects();
+        clear(passes);
+        clear(images);
+    }
 
-                .basePipelineHandle =
-                pipe->config().base_pipeline.has_value()
-                ? lock_wptr(pipe->config().base_pipeline.value())->handle()
-                : nullptr,
+    void RenderGraph::compile()
+    {
+        try
+        {
+            destroy_compiled_objects();
 
-                .basePipelineIndex = -1
-            };
+            cull_passes();
+            build_physical_passes();
+            build_batches();
+            create_images();
+            plan_physical_passes();
+            create_sync_objects();
 
-            VkResult vk_result = vkCreateGraphicsPipelines(
-                device->handle(),
-                cache == nullptr ? nullptr : cache->handle(),
-                1,
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &pipe->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return pipe;
+            _compiled = true;
         }
         catch (const Error& e)
         {
+            destroy_compiled_objects();
             throw Error(
-                "failed to create graphics pipeline: " + e.to_string(),
+                "failed to compile render graph: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    GraphicsPipeline::~GraphicsPipeline()
+    void RenderGraph::set_imported_view(
+        RenderGraphImageId image,
+        const ImageViewPtr& view
+    )
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        if (!images.at(image).imported)
+        {
+            throw Error(std::format(
+                "render graph image \"{}\" is not imported",
+                images[image].name
+            ));
+        }
+        images[image].imported_view = view;
+    }
 
-        vkDestroyPipeline(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+    ImagePtr RenderGraph::image(RenderGraphImageId image) const
+    {
+        return images.at(image).image;
     }
 
-    GraphicsPipeline::GraphicsPipeline(
-        const DevicePtr& device,
-        const GraphicsPipelineConfig& config,
-        const PipelineCachePtr& cache
-    )
-        : _device(device), _config(config), _cache(cache)
-    {}
+    ImageViewPtr RenderGraph::image_view(RenderGraphImageId image) const
+    {
+        const auto& node = images.at(image);
+        return node.imported ? node.imported_view : node.view;
+    }
 
-    ComputePipelinePtr ComputePipeline::create(
-        const DevicePtr& device,
-        const ComputePipelineConfig& config,
-        const PipelineCachePtr& cache
+    RenderPassPtr RenderGraph::render_pass(RenderGraphPassId pass) const
+    {
+        int32_t phys_idx = pass_to_physical.at(pass);
+        if (phys_idx < 0)
+        {
+            return nullptr;
+        }
+        return physical_passes[phys_idx].render_pass;
+    }
+
+    uint32_t RenderGraph::subpass_index(RenderGraphPassId pass) const
+    {
+        return pass_to_subpass.at(pass);
+    }
+
+    bool RenderGraph::is_culled(RenderGraphPassId pass) const
+    {
+        return culled.at(pass);
+    }
+
+    void RenderGraph::execute(
+        uint32_t frame_idx,
+        const std::vector<VkPipelineStageFlags>& wait_stages,
+        const std::vector<SemaphorePtr>& wait_semaphores,
+        const std::vector<SemaphorePtr>& signal_semaphores,
+        const FencePtr& signal_fence
     )
     {
         try
         {
-            ComputePipelinePtr pipe =
-                std::make_shared<ComputePipeline_public_ctor>(
-                    device,
-                    config,
-                    cache
+            if (!compiled())
+            {
+                throw Error("render graph is not compiled");
+            }
+            if (frame_idx >= config().frames_in_flight)
+            {
+                throw Error("frame index out of range");
+            }
+            if (batches.empty())
+            {
+                // nothing survived culling but the caller might still be
+                // relying on the semaphores and the fence.
+                lock_wptr(config().graphics_queue)->submit(
+                    wait_stages,
+                    wait_semaphores,
+                    {},
+                    signal_semaphores,
+                    signal_fence
                 );
+                return;
+            }
 
-            VkSpecializationInfo waste_vk_specialization_info;
-            std::vector<VkSpecializationMapEntry> waste_vk_map_entries;
-            std::vector<uint8_t> waste_data;
-            VkPipelineShaderStageCreateInfo vk_stage = ShaderStage_to_vk(
-                pipe->config().stage,
-                waste_vk_specialization_info,
-                waste_vk_map_entries,
-                waste_data
-            );
+            QueuePtr graphics_queue = lock_wptr(config().graphics_queue);
+            size_t first_graphics_batch = 0;
+            for (size_t i = 0; i < batches.size(); i++)
+            {
+                if (batches[i].queue == graphics_queue)
+                {
+                    first_graphics_batch = i;
+                    break;
+                }
+            }
 
-            VkComputePipelineCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = pipe->config().flags,
-                .stage = vk_stage,
-                .layout = lock_wptr(pipe->config().layout)->handle(),
+            bool wait_for_last_frame =
+                !frame_chain_semaphs.empty() && last_frame_idx.has_value();
 
-                .basePipelineHandle =
-                pipe->config().base_pipeline.has_value()
-                ? lock_wptr(pipe->config().base_pipeline.value())->handle()
-                : nullptr,
+            for (size_t b = 0; b < batches.size(); b++)
+            {
+                auto& batch = batches[b];
+                bool is_last = (b == batches.size() - 1);
+
+                const CommandBufferPtr& cmd_buf = batch.cmd_bufs[frame_idx];
+                cmd_buf->reset(0);
+                cmd_buf->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+                for (auto phys_idx : batch.physical_passes)
+                {
+                    record_physical_pass(cmd_buf, physical_passes[phys_idx]);
+                }
+                cmd_buf->end();
+
+                std::vector<VkPipelineStageFlags> batch_wait_stages;
+                std::vector<SemaphorePtr> batch_wait_semaphs;
+                for (auto edge_idx : batch.wait_edges)
+                {
+                    batch_wait_stages.push_back(
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+                    );
+                    batch_wait_semaphs.push_back(
+                        edges[edge_idx].semaphores[frame_idx]
+                    );
+                }
+                if (b == first_graphics_batch)
+                {
+                    batch_wait_stages.insert(
+                        batch_wait_stages.end(),
+                        wait_stages.begin(),
+                        wait_stages.end()
+                    );
+                    batch_wait_semaphs.insert(
+                        batch_wait_semaphs.end(),
+                        wait_semaphores.begin(),
+                        wait_semaphores.end()
+                    );
+                }
+                if (wait_for_last_frame)
+                {
+                    for (size_t i = 0; i < root_batches.size(); i++)
+                    {
+                        if (root_batches[i] != b)
+                        {
+                            continue;
+                        }
+                        batch_wait_stages.push_back(
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+                        );
+                        batch_wait_semaphs.push_back(
+                            frame_chain_semaphs[i][last_frame_idx.value()]
+                        );
+                    }
+                }
 
-                .basePipelineIndex = -1
-            };
+                std::vector<SemaphorePtr> batch_signal_semaphs;
+                for (auto edge_idx : batch.signal_edges)
+                {
+                    batch_signal_semaphs.push_back(
+                        edges[edge_idx].semaphores[frame_idx]
+                    );
+                }
+                if (is_last)
+                {
+                    batch_signal_semaphs.insert(
+                        batch_signal_semaphs.end(),
+                        signal_semaphores.begin(),
+                        signal_semaphores.end()
+                    );
+                    for (const auto& semaphs : frame_chain_semaphs)
+                    {
+                        batch_signal_semaphs.push_back(semaphs[frame_idx]);
+                    }
+                }
 
-            VkResult vk_result = vkCreateComputePipelines(
-                device->handle(),
-                cache == nullptr ? nullptr : cache->handle(),
-                1,
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &pipe->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
+                batch.queue->submit(
+                    batch_wait_stages,
+                    batch_wait_semaphs,
+                    { cmd_buf },
+                    batch_signal_semaphs,
+                    is_last ? signal_fence : nullptr
+                );
             }
-            return pipe;
+
+            last_frame_idx = frame_idx;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create compute pipeline: " + e.to_string(),
+                "failed to execute render graph: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    ComputePipeline::~ComputePipeline()
+    std::string RenderGraph::to_string() const
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
+        std::string s = std::format(
+            "-----------------------------------------\n"
+            "render graph status\n"
+            "  compiled: {}\n"
+            "  n. passes: {}\n"
+            "  n. images: {}\n",
+            compiled(),
+            passes.size(),
+            images.size()
         );
+        if (!compiled())
+        {
+            s += "-----------------------------------------\n";
+            return s;
+        }
 
-        vkDestroyPipeline(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            if (culled[i])
+            {
+                s += std::format("  culled pass: \"{}\"\n", passes[i].name);
+            }
+        }
+
+        for (size_t b = 0; b < batches.size(); b++)
+        {
+            const auto& batch = batches[b];
+            s += std::format(
+                "-----------------------------------------\n"
+                "batch {}\n"
+                "  queue family: {}\n"
+                "  waits on {} batch(es), signals {} batch(es)\n",
+                b,
+                batch.queue->queue_family_index(),
+                batch.wait_edges.size(),
+                batch.signal_edges.size()
+            );
+            for (auto phys_idx : batch.physical_passes)
+            {
+                const auto& phys = physical_passes[phys_idx];
+                s += std::format(
+                    "  physical pass {} ({} barrier(s) before, {} after)\n",
+                    phys_idx,
+                    phys.barriers_before.size(),
+                    phys.barriers_after.size()
+                );
+                for (size_t i = 0; i < phys.passes.size(); i++)
+                {
+                    s += std::format(
+                        "    {} {}: \"{}\"\n",
+                        phys.render_pass != nullptr ? "subpass" : "pass",
+                        i,
+                        passes[phys.passes[i]].name
+                    );
+                }
+            }
+        }
+
+        for (size_t i = 0; i < memory_slots.size(); i++)
+        {
+            const auto& slot = memory_slots[i];
+            s += std::format(
+                "-----------------------------------------\n"
+                "memory slot {}\n"
+                "  size: {}\n",
+                i,
+                slot.requirements.size
+            );
+            for (auto image_id : slot.images)
+            {
+                s += std::format(
+                    "  image \"{}\" (physical passes {} to {})\n",
+                    images[image_id].name,
+                    images[image_id].first_physical_pass,
+                    images[image_id].last_physical_pass
+                );
+            }
+        }
+
+        s += "-----------------------------------------\n";
+        return s;
     }
 
-    ComputePipeline::ComputePipeline(
+    RenderGraph::~RenderGraph()
+    {
+        destroy_compiled_objects();
+    }
+
+    RenderGraph::RenderGraph(
         const DevicePtr& device,
-        const ComputePipelineConfig& config,
-        const PipelineCachePtr& cache
+        const MemoryBankPtr& mem_bank,
+        const RenderGraphConfig& config
     )
-        : _device(device), _config(config), _cache(cache)
+        : _device(device),
+        _mem_bank(mem_bank),
+        _config(config)
     {}
 
-    FramebufferPtr Framebuffer::create(
-        const DevicePtr& device,
-        const FramebufferConfig& config
-    )
+    QueuePtr RenderGraph::queue_for(const RenderGraphPass& pass) const
     {
-        try
+        if (pass.queue == VK_QUEUE_COMPUTE_BIT
+            && !config().compute_queue.expired())
         {
-            FramebufferPtr buf = std::make_shared<Framebuffer_public_ctor>(
-                device,
-                config
-            );
+            return config().compute_queue.lock();
+        }
+        return lock_wptr(config().graphics_queue);
+    }
 
-            std::vector<VkImageView> vk_attachments(
-                buf->config().attachments.size()
-            );
-            for (size_t i = 0; i < buf->config().attachments.size(); i++)
+    bool RenderGraph::can_merge(
+        const PhysicalPass& phys,
+        RenderGraphPassId pass
+    ) const
+    {
+        if (phys.render_pass == nullptr && phys.attachments.empty())
+        {
+            return false;
+        }
+
+        const auto& new_pass = passes[pass];
+        for (const auto& access : new_pass.accesses)
+        {
+            const auto& node = images[access.image];
+
+            if (render_graph_access_is_attachment(access.access))
             {
-                vk_attachments[i] =
-                    lock_wptr(buf->config().attachments[i])->handle();
+                // all attachments in a render pass share the same area and
+                // subpasses can't mix sample counts
+                if (node.extent.width != phys.extent.width
+                    || node.extent.height != phys.extent.height
+                    || node.samples != images[phys.attachments[0]].samples)
+                {
+                    return false;
+                }
             }
 
-            VkFramebufferCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = buf->config().flags,
-                .renderPass = lock_wptr(buf->config().render_pass)->handle(),
-                .attachmentCount = (uint32_t)vk_attachments.size(),
-                .pAttachments = vk_attachments.data(),
-                .width = buf->config().width,
-                .height = buf->config().height,
-                .layers = buf->config().layers
-            };
-
-            VkResult vk_result = vkCreateFramebuffer(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &buf->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+            // images shared with earlier subpasses must only be used as
+            // attachments, anything else would need a barrier inside the
+            // render pass. clearing an image that's already in use would need
+            // vkCmdClearAttachments() instead of a load op.
+            for (auto other_pass_id : phys.passes)
             {
-                throw Error(vk_result);
+                for (const auto& other : passes[other_pass_id].accesses)
+                {
+                    if (other.image != access.image)
+                    {
+                        continue;
+                    }
+                    if (!render_graph_access_is_attachment(access.access)
+                        || !render_graph_access_is_attachment(other.access)
+                        || access.load_op == VK_ATTACHMENT_LOAD_OP_CLEAR)
+                    {
+                        return false;
+                    }
+                }
             }
-            return buf;
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to create framebuffer: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
         }
+        return true;
     }
 
-    Framebuffer::~Framebuffer()
+    void RenderGraph::add_edge(uint32_t src_batch, uint32_t dst_batch)
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        for (auto edge_idx : batches[dst_batch].wait_edges)
+        {
+            if (edges[edge_idx].src_batch == src_batch)
+            {
+                return;
+            }
+        }
 
-        vkDestroyFramebuffer(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
+        edges.push_back(Edge{
+            .src_batch = src_batch,
+            .dst_batch = dst_batch
+            });
+        batches[src_batch].signal_edges.push_back(
+            (uint32_t)(edges.size() - 1)
         );
+        batches[dst_batch].wait_edges.push_back((uint32_t)(edges.size() - 1));
     }
 
-    Framebuffer::Framebuffer(
-        const DevicePtr& device,
-        const FramebufferConfig& config
-    )
-        : _device(device), _config(config)
-    {}
+    void RenderGraph::destroy_compiled_objects()
+    {
+        // framebuffers and render passes go first, then image views and
+        // images, and the memory they're bound to at the end.
+        _compiled = false;
+        last_frame_idx = std::nullopt;
+
+        clear(physical_passes);
+        clear(batches);
+        clear(edges);
+        clear(frame_chain_semaphs);
+        clear(root_batches);
+        clear(cmd_pools);
+
+        for (auto& node : images)
+        {
+            node.view = nullptr;
+            node.image = nullptr;
+            node.usage = 0;
+            node.memory_slot = -1;
+            node.first_physical_pass = -1;
+            node.last_physical_pass = -1;
+        }
+        clear(memory_slots);
 
-    void CommandBuffer::reset(VkCommandBufferResetFlags flags)
+        clear(culled);
+        clear(pass_to_physical);
+        clear(pass_to_subpass);
+        clear(frame_start_states);
+    }
+
+    void RenderGraph::cull_passes()
     {
-        VkResult vk_result = vkResetCommandBuffer(_handle, flags);
-        if (vk_result != VK_SUCCESS)
+        culled.assign(passes.size(), true);
+
+        // walk backwards from the outputs. an image is "needed" if a live
+        // pass after the current one reads it before anything overwrites it.
+        std::vector<bool> needed(images.size(), false);
+        for (int64_t i = (int64_t)passes.size() - 1; i >= 0; i--)
         {
-            throw Error(
-                "failed to reset command buffer",
-                vk_result,
-                false
-            );
+            const auto& pass = passes[i];
+
+            bool live = pass.has_side_effects;
+            for (const auto& access : pass.accesses)
+            {
+                const auto& node = images.at(access.image);
+                auto info = render_graph_access_info(
+                    access,
+                    pass.queue,
+                    node.format
+                );
+                if (info.writes && (node.imported || needed[access.image]))
+                {
+                    live = true;
+                }
+            }
+            if (!live)
+            {
+                continue;
+            }
+            culled[i] = false;
+
+            for (const auto& access : pass.accesses)
+            {
+                auto info = render_graph_access_info(
+                    access,
+                    pass.queue,
+                    images[access.image].format
+                );
+                if (info.writes && !info.reads)
+                {
+                    needed[access.image] = false;
+                }
+            }
+            for (const auto& access : pass.accesses)
+            {
+                auto info = render_graph_access_info(
+                    access,
+                    pass.queue,
+                    images[access.image].format
+                );
+                if (info.reads)
+                {
+                    needed[access.image] = true;
+                }
+            }
         }
     }
 
-    void CommandBuffer::begin(
-        VkCommandBufferUsageFlags flags,
-        std::optional<CommandBufferInheritance> inheritance
-    )
+    void RenderGraph::build_physical_passes()
     {
-        try
+        pass_to_physical.assign(passes.size(), -1);
+        pass_to_subpass.assign(passes.size(), 0);
+
+        for (size_t i = 0; i < passes.size(); i++)
         {
-            VkCommandBufferInheritanceInfo vk_inheritance;
-            if (inheritance.has_value())
+            if (culled[i])
             {
-                vk_inheritance = VkCommandBufferInheritanceInfo{
-                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
-                    .pNext = nullptr,
-                    .renderPass = lock_wptr(inheritance->render_pass)->handle(),
-                    .subpass = inheritance->subpass_index,
+                continue;
+            }
 
-                    .framebuffer =
-                    inheritance->framebuffer.has_value()
-                    ? lock_wptr(
-                        inheritance->framebuffer.value()
-                    )->handle()
-                    : nullptr,
+            const auto& pass = passes[i];
+            bool raster = render_graph_pass_is_raster(pass);
 
-                    .occlusionQueryEnable = inheritance->occlusion_query_enable,
-                    .queryFlags = inheritance->query_flags,
-                    .pipelineStatistics = inheritance->pipeline_statistics
-                };
+            bool merge =
+                raster
+                && !physical_passes.empty()
+                && render_graph_pass_is_raster(
+                    passes[physical_passes.back().passes[0]]
+                )
+                && can_merge(physical_passes.back(), (RenderGraphPassId)i);
+
+            if (!merge)
+            {
+                physical_passes.push_back(PhysicalPass{});
             }
+            auto& phys = physical_passes.back();
 
-            VkCommandBufferBeginInfo begin_info{};
-            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            begin_info.pNext = nullptr;
-            begin_info.flags = flags;
-            begin_info.pInheritanceInfo =
-                inheritance.has_value() ? &vk_inheritance : nullptr;
+            pass_to_physical[i] = (int32_t)(physical_passes.size() - 1);
+            pass_to_subpass[i] = (uint32_t)phys.passes.size();
+            phys.passes.push_back((RenderGraphPassId)i);
+
+            for (const auto& access : pass.accesses)
+            {
+                auto& node = images[access.image];
+                if (node.first_physical_pass < 0)
+                {
+                    node.first_physical_pass = pass_to_physical[i];
+                }
+                node.last_physical_pass = pass_to_physical[i];
+
+                if (!raster
+                    || !render_graph_access_is_attachment(access.access))
+                {
+                    continue;
+                }
+
+                if (phys.attachments.empty())
+                {
+                    phys.extent = node.extent;
+                }
+                if (std::find(
+                    phys.attachments.begin(),
+                    phys.attachments.end(),
+                    access.image
+                ) == phys.attachments.end())
+                {
+                    phys.attachments.push_back(access.image);
+                }
+            }
+        }
+    }
+
+    void RenderGraph::build_batches()
+    {
+        for (size_t i = 0; i < physical_passes.size(); i++)
+        {
+            auto& phys = physical_passes[i];
+            QueuePtr queue = queue_for(passes[phys.passes[0]]);
+
+            if (batches.empty() || batches.back().queue != queue)
+            {
+                batches.push_back(Batch{ .queue = queue });
+            }
+            phys.batch = (uint32_t)(batches.size() - 1);
+            batches.back().physical_passes.push_back((uint32_t)i);
+        }
+    }
 
-            VkResult vk_result = vkBeginCommandBuffer(handle(), &begin_info);
-            if (vk_result != VK_SUCCESS)
+    void RenderGraph::create_images()
+    {
+        auto device_locked = lock_wptr(device());
+        auto mem_bank_locked = lock_wptr(_mem_bank);
+
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            if (culled[i])
             {
-                throw Error(vk_result);
+                continue;
+            }
+            for (const auto& access : passes[i].accesses)
+            {
+                images[access.image].usage |=
+                    render_graph_access_usage(access.access);
             }
         }
-        catch (const Error& e)
+
+        // transient images touched by more than one queue family use
+        // concurrent sharing so we don't need ownership transfers.
+        std::vector<uint32_t> queue_family_indices;
+        for (const auto& batch : batches)
         {
-            throw Error(
-                "failed to begin recording a command buffer: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            uint32_t family_idx = batch.queue->queue_family_index();
+            if (std::find(
+                queue_family_indices.begin(),
+                queue_family_indices.end(),
+                family_idx
+            ) == queue_family_indices.end())
+            {
+                queue_family_indices.push_back(family_idx);
+            }
         }
-    }
+        bool concurrent = queue_family_indices.size() > 1;
 
-    void CommandBuffer::end()
-    {
-        VkResult vk_result = vkEndCommandBuffer(handle());
-        if (vk_result != VK_SUCCESS)
+        std::vector<RenderGraphImageId> transient_ids;
+        for (size_t i = 0; i < images.size(); i++)
         {
-            throw Error(
-                "failed to end recording a command buffer",
-                vk_result,
-                false
+            auto& node = images[i];
+            if (node.imported || node.first_physical_pass < 0)
+            {
+                continue;
+            }
+
+            node.image = Image::create(
+                device_locked,
+                {
+                    .flags = 0,
+                    .image_type = VK_IMAGE_TYPE_2D,
+                    .format = node.format,
+                    .extent = Extent3d{
+                        .width = node.extent.width,
+                        .height = node.extent.height,
+                        .depth = 1
+                },
+                    .mip_levels = 1,
+                    .array_layers = 1,
+                    .samples = node.samples,
+                    .tiling = VK_IMAGE_TILING_OPTIMAL,
+                    .usage = node.usage,
+
+                    .sharing_mode =
+                    concurrent
+                    ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+
+                    .queue_family_indices =
+                    concurrent
+                    ? queue_family_indices : std::vector<uint32_t>(),
+
+                    .initial_layout = VK_IMAGE_LAYOUT_UNDEFINED
+                }
             );
+            transient_ids.push_back((RenderGraphImageId)i);
         }
-    }
 
-    CommandBuffer::~CommandBuffer()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(pool(), pool_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            pool_locked->device(),
-            device_locked
+        // assign images to memory slots, largest first. an image can share a
+        // slot with others if their lifetimes (in physical passes) don't
+        // overlap and they're all used within the same batch, so that
+        // submission order and regular barriers are enough to keep them
+        // apart.
+        std::sort(
+            transient_ids.begin(),
+            transient_ids.end(),
+            [this](RenderGraphImageId a, RenderGraphImageId b)
+            {
+                return
+                    images[a].image->memory_requirements().size
+                    > images[b].image->memory_requirements().size;
+            }
         );
+        for (auto image_id : transient_ids)
+        {
+            auto& node = images[image_id];
+            const auto& requirements = node.image->memory_requirements();
 
-        vkFreeCommandBuffers(
-            device_locked->handle(),
-            pool_locked->handle(),
-            1,
-            &_handle
-        );
-    }
+            uint32_t first_batch =
+                physical_passes[node.first_physical_pass].batch;
+            uint32_t last_batch =
+                physical_passes[node.last_physical_pass].batch;
 
-    CommandBuffer::CommandBuffer(
-        const CommandPoolWPtr& pool,
-        VkCommandBuffer handle
-    )
-        : _pool(pool),
-        _handle(handle)
-    {}
+            int32_t slot_idx = -1;
+            for (size_t i = 0; i < memory_slots.size() && first_batch == last_batch; i++)
+            {
+                auto& slot = memory_slots[i];
+                if (slot.batch != first_batch
+                    || !(slot.requirements.memory_type_bits
+                        & requirements.memory_type_bits))
+                {
+                    continue;
+                }
 
-    CommandPoolPtr CommandPool::create(
-        const DevicePtr& device,
-        const CommandPoolConfig& config
-    )
-    {
-        try
-        {
-            CommandPoolPtr pool = std::make_shared<CommandPool_public_ctor>(
-                device,
-                config
-            );
+                bool overlaps = false;
+                for (auto other_id : slot.images)
+                {
+                    const auto& other = images[other_id];
+                    if (node.first_physical_pass <= other.last_physical_pass
+                        && other.first_physical_pass <= node.last_physical_pass)
+                    {
+                        overlaps = true;
+                        break;
+                    }
+                }
+                if (!overlaps)
+                {
+                    slot_idx = (int32_t)i;
+                    break;
+                }
+            }
 
-            VkCommandPoolCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = pool->config().flags,
-                .queueFamilyIndex = pool->config().queue_family_index
-            };
+            if (slot_idx < 0)
+            {
+                memory_slots.push_back(MemorySlot{
+                    .requirements = requirements,
+
+                    // images used in more than one batch never share memory
+                    .batch =
+                    (first_batch == last_batch)
+                    ? first_batch : std::numeric_limits<uint32_t>::max()
+                    });
+                slot_idx = (int32_t)(memory_slots.size() - 1);
+            }
+            else
+            {
+                auto& slot_req = memory_slots[slot_idx].requirements;
+                slot_req.size = std::max(slot_req.size, requirements.size);
+                slot_req.alignment = std::max(
+                    slot_req.alignment,
+                    requirements.alignment
+                );
+                slot_req.memory_type_bits &= requirements.memory_type_bits;
+            }
 
-            VkResult vk_result = vkCreateCommandPool(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &pool->_handle
+            memory_slots[slot_idx].images.push_back(image_id);
+            node.memory_slot = slot_idx;
+        }
+
+        for (auto& slot : memory_slots)
+        {
+            slot.chunk = mem_bank_locked->allocate(
+                slot.requirements,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
-            if (vk_result != VK_SUCCESS)
+            for (auto image_id : slot.images)
             {
-                throw Error(vk_result);
+                slot.chunk->bind(images[image_id].image);
             }
-            return pool;
         }
-        catch (const Error& e)
+
+        for (auto image_id : transient_ids)
         {
-            throw Error(
-                "failed to create command pool: " + e.to_string(),
-                e.vk_result(),
-                true
+            auto& node = images[image_id];
+            node.view = ImageView::create(
+                device_locked,
+                node.image,
+                {
+                    .flags = 0,
+                    .view_type = VK_IMAGE_VIEW_TYPE_2D,
+                    .format = node.format,
+                    .components = {},
+                    .subresource_range = ImageSubresourceRange{
+                        .aspect_mask = render_graph_aspect_mask(
+                            node.format,
+                            true
+                        ),
+                        .base_mip_level = 0,
+                        .level_count = 1,
+                        .base_array_layer = 0,
+                        .layer_count = 1
+                }
+                }
             );
         }
     }
 
-    CommandBufferPtr CommandPool::allocate_buffer(
-        const CommandPoolPtr& pool,
-        VkCommandBufferLevel level
-    )
+    void RenderGraph::plan_physical_passes()
     {
-        try
+        auto device_locked = lock_wptr(device());
+
+        bool multi_queue = false;
+        for (const auto& batch : batches)
         {
-            VkCommandBufferAllocateInfo alloc_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                .pNext = nullptr,
-                .commandPool = pool->handle(),
-                .level = level,
-                .commandBufferCount = 1
-            };
+            multi_queue |= (batch.queue != batches[0].queue);
+        }
 
-            VkCommandBuffer vk_command_buffer;
-            VkResult vk_result = vkAllocateCommandBuffers(
-                lock_wptr(pool->device())->handle(),
-                &alloc_info,
-                &vk_command_buffer
-            );
-            if (vk_result != VK_SUCCESS)
+        // how each image was last used in a frame, which is what the first
+        // use in the next frame (or of an aliasing image) has to wait for.
+        std::vector<VkPipelineStageFlags> last_use_stages(images.size(), 0);
+        std::vector<VkAccessFlags> last_use_access(images.size(), 0);
+        std::vector<int32_t> last_use_phys(images.size(), -1);
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            if (culled[i])
             {
-                throw Error(vk_result);
+                continue;
+            }
+            for (const auto& access : passes[i].accesses)
+            {
+                auto info = render_graph_access_info(
+                    access,
+                    passes[i].queue,
+                    images[access.image].format
+                );
+                if (last_use_phys[access.image] != pass_to_physical[i])
+                {
+                    last_use_stages[access.image] = 0;
+                    last_use_access[access.image] = 0;
+                    last_use_phys[access.image] = pass_to_physical[i];
+                }
+                last_use_stages[access.image] |= info.stages;
+                last_use_access[access.image] |= info.access;
             }
-            return std::make_shared<CommandBuffer_public_ctor>(
-                pool,
-                vk_command_buffer
-            );
         }
-        catch (const Error& e)
+
+        frame_start_states.resize(images.size());
+        for (size_t i = 0; i < images.size(); i++)
         {
-            throw Error(
-                "failed to allocate command buffer: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            const auto& node = images[i];
+            auto& state = frame_start_states[i];
+            state.batch = -1;
+
+            if (node.imported)
+            {
+                state.layout = node.initial_layout;
+                state.stages = node.initial_stages;
+                state.access = 0;
+                continue;
+            }
+
+            state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            state.stages = 0;
+            state.access = 0;
+            if (node.memory_slot < 0)
+            {
+                continue;
+            }
+            if (multi_queue)
+            {
+                // the previous frame is waited for with a semaphore
+                state.stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                continue;
+            }
+            for (auto other_id : memory_slots[node.memory_slot].images)
+            {
+                state.stages |= last_use_stages[other_id];
+                state.access |=
+                    last_use_access[other_id] & RENDER_GRAPH_WRITE_ACCESS_MASK;
+            }
         }
-    }
 
-    std::vector<CommandBufferPtr> CommandPool::allocate_buffers(
-        const CommandPoolPtr& pool,
-        VkCommandBufferLevel level,
-        uint32_t count
-    )
-    {
-        if (count < 1)
+        std::vector<ImageState> states = frame_start_states;
+
+        // stages and access to wait for before an image can be used in a
+        // batch. work from other queues is waited for with a semaphore, so
+        // the barrier only has to chain with the semaphore wait.
+        auto src_of = [&](RenderGraphImageId image_id, uint32_t batch_idx)
         {
-            return {};
+            auto& state = states[image_id];
+            if (state.batch >= 0
+                && batches[state.batch].queue != batches[batch_idx].queue)
+            {
+                add_edge((uint32_t)state.batch, batch_idx);
+                return std::make_pair(
+                    (VkPipelineStageFlags)VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    (VkAccessFlags)0
+                );
+            }
+            return std::make_pair(
+                state.stages,
+                (VkAccessFlags)(state.access & RENDER_GRAPH_WRITE_ACCESS_MASK)
+            );
+        };
+
+        for (size_t p = 0; p < physical_passes.size(); p++)
+        {
+            auto& phys = physical_passes[p];
+            bool raster = !phys.attachments.empty();
+
+            // barriers for everything that isn't an attachment. in render
+            // passes, these go before the render pass begins.
+            std::vector<RenderGraphImageId> barrier_images;
+            std::vector<RenderGraphAccessInfo> barrier_infos;
+            for (auto pass_id : phys.passes)
+            {
+                const auto& pass = passes[pass_id];
+                for (const auto& access : pass.accesses)
+                {
+                    if (raster
+                        && render_graph_access_is_attachment(access.access))
+                    {
+                        continue;
+                    }
+
+                    auto info = render_graph_access_info(
+                        access,
+                        pass.queue,
+                        images[access.image].format
+                    );
+
+                    auto it = std::find(
+                        barrier_images.begin(),
+                        barrier_images.end(),
+                        access.image
+                    );
+                    if (it == barrier_images.end())
+                    {
+                        barrier_images.push_back(access.image);
+                        barrier_infos.push_back(info);
+                    }
+                    else
+                    {
+                        auto& existing =
+                            barrier_infos[it - barrier_images.begin()];
+                        existing.stages |= info.stages;
+                        existing.access |= info.access;
+                        existing.writes |= info.writes;
+                    }
+                }
+            }
+            for (size_t i = 0; i < barrier_images.size(); i++)
+            {
+                auto image_id = barrier_images[i];
+                const auto& info = barrier_infos[i];
+                auto& state = states[image_id];
+
+                auto [src_stages, src_access] = src_of(image_id, phys.batch);
+
+                bool needs_barrier =
+                    state.layout != info.layout
+                    || src_access != 0
+                    || (info.writes && src_stages != 0);
+                if (needs_barrier)
+                {
+                    phys.barriers_before.push_back(Barrier{
+                        .image = image_id,
+                        .old_layout = state.layout,
+                        .new_layout = info.layout,
+                        .src_stages = src_stages,
+                        .dst_stages = info.stages,
+                        .src_access = src_access,
+                        .dst_access = info.access
+                        });
+                }
+
+                state = ImageState{
+                    .layout = info.layout,
+                    .stages = info.stages,
+                    .access = info.access,
+                    .batch = (int32_t)phys.batch
+                };
+            }
+
+            if (!raster)
+            {
+                continue;
+            }
+
+            // attachments are transitioned by the render pass itself, with
+            // subpass dependencies between the subpasses sharing them and
+            // from VK_SUBPASS_EXTERNAL for the first use.
+            RenderPassConfig rp_config{
+                .flags = 0,
+                .attachments = {},
+                .subpasses = {},
+                .dependencies = {}
+            };
+            phys.clear_values.resize(phys.attachments.size());
+
+            std::vector<Subpass> subpasses(phys.passes.size());
+            for (size_t s = 0; s < phys.passes.size(); s++)
+            {
+                subpasses[s] = Subpass{
+                    .flags = 0,
+                    .pipeline_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    .input_attachments = {},
+                    .color_attachments = {},
+                    .resolve_attachments = {},
+                    .depth_stencil_attachment = std::nullopt,
+                    .preserve_attachment_indices = {}
+                };
+            }
+
+            auto add_dependency = [&](SubpassDependency dep)
+            {
+                for (auto& existing : rp_config.dependencies)
+                {
+                    if (existing.src_subpass == dep.src_subpass
+                        && existing.dst_subpass == dep.dst_subpass)
+                    {
+                        existing.src_stage_mask |= dep.src_stage_mask;
+                        existing.dst_stage_mask |= dep.dst_stage_mask;
+                        existing.src_access_mask |= dep.src_access_mask;
+                        existing.dst_access_mask |= dep.dst_access_mask;
+                        return;
+                    }
+                }
+                rp_config.dependencies.push_back(dep);
+            };
+
+            for (size_t a = 0; a < phys.attachments.size(); a++)
+            {
+                auto image_id = phys.attachments[a];
+                const auto& node = images[image_id];
+                auto& state = states[image_id];
+
+                // uses of this attachment in subpass order
+                std::vector<uint32_t> use_subpasses;
+                std::vector<const RenderGraphImageAccess*> use_accesses;
+                std::vector<RenderGraphAccessInfo> use_infos;
+                for (size_t s = 0; s < phys.passes.size(); s++)
+                {
+                    const auto& pass = passes[phys.passes[s]];
+                    for (const auto& access : pass.accesses)
+                    {
+                        if (access.image != image_id
+                            || !render_graph_access_is_attachment(
+                                access.access
+                            ))
+                        {
+                            continue;
+                        }
+
+                        auto info = render_graph_access_info(
+                            access,
+                            pass.queue,
+                            node.format
+                        );
+                        use_subpasses.push_back((uint32_t)s);
+                        use_accesses.push_back(&access);
+                        use_infos.push_back(info);
+
+                        AttachmentReference ref{
+                            .attachment = (uint32_t)a,
+                            .layout = info.layout
+                        };
+                        if (access.access == RenderGraphAccess::ColorAttachment)
+                        {
+                            subpasses[s].color_attachments.push_back(ref);
+                        }
+                        else if (access.access
+                            == RenderGraphAccess::DepthStencilAttachment)
+                        {
+                            subpasses[s].depth_stencil_attachment = ref;
+                        }
+                        else
+                        {
+                            subpasses[s].input_attachments.push_back(ref);
+                        }
+                    }
+                }
+
+                const auto* first_access = use_accesses.front();
+                VkAttachmentLoadOp load_op =
+                    (first_access->access == RenderGraphAccess::InputAttachment)
+                    ? VK_ATTACHMENT_LOAD_OP_LOAD
+                    : first_access->load_op;
+
+                // keep the contents if anything reads them later, imported
+                // images always keep them.
+                VkAttachmentStoreOp store_op =
+                    (node.imported || node.last_physical_pass > (int32_t)p)
+                    ? VK_ATTACHMENT_STORE_OP_STORE
+                    : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+                VkImageLayout final_layout = use_infos.back().layout;
+                if (node.imported && node.last_physical_pass == (int32_t)p)
+                {
+                    final_layout = node.final_layout;
+                }
+
+                bool has_stencil = format_has_stencil_component(node.format);
+                rp_config.attachments.push_back(Attachment{
+                    .flags = 0,
+                    .format = node.format,
+                    .samples = node.samples,
+                    .load_op = load_op,
+                    .store_op = store_op,
+
+                    .stencil_load_op =
+                    has_stencil ? load_op : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+
+                    .stencil_store_op =
+                    has_stencil ? store_op : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+
+                    // discarding the contents lets the driver skip the
+                    // transition from the previous layout
+                    .initial_layout =
+                    (load_op == VK_ATTACHMENT_LOAD_OP_LOAD)
+                    ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+
+                    .final_layout = final_layout
+                    });
+                if (load_op == VK_ATTACHMENT_LOAD_OP_CLEAR)
+                {
+                    phys.clear_values[a] = first_access->clear_value;
+                }
+
+                auto [src_stages, src_access] = src_of(image_id, phys.batch);
+                add_dependency(SubpassDependency{
+                    .src_subpass = VK_SUBPASS_EXTERNAL,
+                    .dst_subpass = use_subpasses.front(),
+
+                    .src_stage_mask =
+                    src_stages != 0
+                    ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+
+                    .dst_stage_mask = use_infos.front().stages,
+                    .src_access_mask = src_access,
+                    .dst_access_mask = use_infos.front().access,
+                    .dependency_flags = 0
+                    });
+
+                for (size_t u = 1; u < use_subpasses.size(); u++)
+                {
+                    if (use_subpasses[u] == use_subpasses[u - 1])
+                    {
+                        continue;
+                    }
+                    add_dependency(SubpassDependency{
+                        .src_subpass = use_subpasses[u - 1],
+                        .dst_subpass = use_subpasses[u],
+                        .src_stage_mask = use_infos[u - 1].stages,
+                        .dst_stage_mask = use_infos[u].stages,
+
+                        .src_access_mask =
+                        use_infos[u - 1].access
+                        & RENDER_GRAPH_WRITE_ACCESS_MASK,
+
+                        .dst_access_mask = use_infos[u].access,
+                        .dependency_flags = VK_DEPENDENCY_BY_REGION_BIT
+                        });
+                }
+
+                // subpasses in between the first and last use that don't
+                // touch the attachment need to preserve its contents
+                for (uint32_t s = use_subpasses.front() + 1;
+                    s < use_subpasses.back();
+                    s++)
+                {
+                    if (std::find(
+                        use_subpasses.begin(),
+                        use_subpasses.end(),
+                        s
+                    ) == use_subpasses.end())
+                    {
+                        subpasses[s].preserve_attachment_indices.push_back(
+                            (uint32_t)a
+                        );
+                    }
+                }
+
+                state = ImageState{
+                    .layout = final_layout,
+                    .stages = use_infos.back().stages,
+                    .access = use_infos.back().access,
+                    .batch = (int32_t)phys.batch
+                };
+            }
+
+            rp_config.subpasses = subpasses;
+            phys.render_pass = RenderPass::create(device_locked, rp_config);
         }
 
-        try
+        // leave imported images in their final layouts
+        for (size_t i = 0; i < images.size(); i++)
         {
-            VkCommandBufferAllocateInfo alloc_info{
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                .pNext = nullptr,
-                .commandPool = pool->handle(),
-                .level = level,
-                .commandBufferCount = count
-            };
-
-            std::vector<VkCommandBuffer> vk_command_buffers(count);
-            VkResult vk_result = vkAllocateCommandBuffers(
-                lock_wptr(pool->device())->handle(),
-                &alloc_info,
-                vk_command_buffers.data()
-            );
-            if (vk_result != VK_SUCCESS)
+            const auto& node = images[i];
+            const auto& state = states[i];
+            if (!node.imported
+                || node.last_physical_pass < 0
+                || state.layout == node.final_layout)
             {
-                throw Error(vk_result);
+                continue;
             }
 
-            std::vector<CommandBufferPtr> command_buffers(count);
-            for (size_t i = 0; i < count; i++)
-            {
-                command_buffers[i] =
-                    std::make_shared<CommandBuffer_public_ctor>(
-                        pool,
-                        vk_command_buffers[i]
-                    );
-            }
-            return command_buffers;
+            physical_passes[node.last_physical_pass].barriers_after.push_back(
+                Barrier{
+                    .image = (RenderGraphImageId)i,
+                    .old_layout = state.layout,
+                    .new_layout = node.final_layout,
+                    .src_stages = state.stages,
+                    .dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                    .src_access = state.access & RENDER_GRAPH_WRITE_ACCESS_MASK,
+                    .dst_access = 0
+                }
+            );
         }
-        catch (const Error& e)
+
+        // make the last batch wait for every batch nothing else waits for, so
+        // that the fence and semaphores it signals cover the whole frame.
+        if (multi_queue)
         {
-            throw Error(
-                "failed to allocate command buffer(s): " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            uint32_t last_batch = (uint32_t)(batches.size() - 1);
+            for (uint32_t b = 0; b < last_batch; b++)
+            {
+                if (batches[b].signal_edges.empty())
+                {
+                    add_edge(b, last_batch);
+                }
+            }
         }
     }
 
-    CommandPool::~CommandPool()
+    void RenderGraph::create_sync_objects()
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkDestroyCommandPool(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
-    }
-
-    CommandPool::CommandPool(
-        const DevicePtr& device,
-        const CommandPoolConfig& config
-    )
-        : _device(device), _config(config)
-    {}
+        auto device_locked = lock_wptr(device());
+        uint32_t frames_in_flight = config().frames_in_flight;
 
-    SemaphorePtr Semaphore::create(const DevicePtr& device)
-    {
-        try
+        for (auto& batch : batches)
         {
-            SemaphorePtr sema = std::make_shared<Semaphore_public_ctor>(device);
-
-            VkSemaphoreCreateInfo  create_info{
-                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0
-            };
+            CommandPoolPtr pool = nullptr;
+            for (const auto& existing : cmd_pools)
+            {
+                if (existing->config().queue_family_index
+                    == batch.queue->queue_family_index())
+                {
+                    pool = existing;
+                    break;
+                }
+            }
+            if (pool == nullptr)
+            {
+                pool = CommandPool::create(
+                    device_locked,
+                    {
+                        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                        .queue_family_index = batch.queue->queue_family_index()
+                    }
+                );
+                cmd_pools.push_back(pool);
+            }
 
-            VkResult vk_result = vkCreateSemaphore(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &sema->_handle
+            batch.cmd_bufs = CommandPool::allocate_buffers(
+                pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                frames_in_flight
             );
-            if (vk_result != VK_SUCCESS)
+        }
+
+        for (auto& edge : edges)
+        {
+            for (uint32_t i = 0; i < frames_in_flight; i++)
             {
-                throw Error(vk_result);
+                edge.semaphores.push_back(Semaphore::create(device_locked));
             }
-            return sema;
         }
-        catch (const Error& e)
+
+        // with more than one queue, the queue submission order alone won't
+        // keep consecutive frames from overlapping on the transient images.
+        if (!edges.empty())
         {
-            throw Error(
-                "failed to create semaphore: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            for (uint32_t b = 0; b < batches.size(); b++)
+            {
+                if (!batches[b].wait_edges.empty())
+                {
+                    continue;
+                }
+                root_batches.push_back(b);
+
+                std::vector<SemaphorePtr> semaphs;
+                for (uint32_t i = 0; i < frames_in_flight; i++)
+                {
+                    semaphs.push_back(Semaphore::create(device_locked));
+                }
+                frame_chain_semaphs.push_back(semaphs);
+            }
         }
     }
 
-    Semaphore::~Semaphore()
+    VkImage RenderGraph::vk_image_of(RenderGraphImageId image) const
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkDestroySemaphore(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        const auto& node = images[image];
+        if (!node.imported)
+        {
+            return node.image->handle();
+        }
+        if (node.imported_view == nullptr)
+        {
+            throw Error(std::format(
+                "no view was set for imported render graph image \"{}\"",
+                node.name
+            ));
+        }
+        return lock_wptr(node.imported_view->image())->handle();
     }
 
-    Semaphore::Semaphore(const DevicePtr& device)
-        : _device(device)
-    {}
-
-    FencePtr Fence::create(
-        const DevicePtr& device,
-        VkFenceCreateFlags flags
-    )
+    VkImageView RenderGraph::vk_view_of(RenderGraphImageId image) const
     {
-        try
+        const auto& node = images[image];
+        if (!node.imported)
         {
-            FencePtr fence = std::make_shared<Fence_public_ctor>(device);
-
-            VkFenceCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = flags
-            };
-
-            VkResult vk_result = vkCreateFence(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &fence->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return fence;
+            return node.view->handle();
         }
-        catch (const Error& e)
+        if (node.imported_view == nullptr)
         {
-            throw Error(
-                "failed to create fence: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            throw Error(std::format(
+                "no view was set for imported render graph image \"{}\"",
+                node.name
+            ));
         }
+        return node.imported_view->handle();
     }
 
-    void Fence::wait(uint64_t timeout)
+    void RenderGraph::record_barriers(
+        const CommandBufferPtr& cmd_buf,
+        const std::vector<Barrier>& barriers
+    ) const
     {
-        try
+        if (barriers.empty())
         {
-            VkResult vk_result = vkWaitForFences(
-                lock_wptr(device())->handle(),
-                1,
-                &_handle,
-                VK_TRUE,
-                timeout
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
+            return;
         }
-        catch (const Error& e)
+
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        std::vector<VkImageMemoryBarrier> vk_barriers(barriers.size());
+        for (size_t i = 0; i < barriers.size(); i++)
         {
-            throw Error(
-                "failed to wait for fence to become signaled: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            const auto& barrier = barriers[i];
+            src_stages |= barrier.src_stages;
+            dst_stages |= barrier.dst_stages;
+
+            vk_barriers[i] = VkImageMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = barrier.src_access,
+                .dstAccessMask = barrier.dst_access,
+                .oldLayout = barrier.old_layout,
+                .newLayout = barrier.new_layout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = vk_image_of(barrier.image),
+                .subresourceRange = VkImageSubresourceRange{
+                    .aspectMask = render_graph_aspect_mask(
+                        images[barrier.image].format,
+                        false
+                    ),
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+            }
+            };
         }
+
+        cmd_buf->dispatch().vkCmdPipelineBarrier(
+            cmd_buf->handle(),
+            src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            dst_stages != 0 ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            (uint32_t)vk_barriers.size(), vk_barriers.data()
+        );
     }
 
-    void Fence::wait_multiple(
-        const std::vector<FencePtr>& fences,
-        bool wait_all,
-        uint64_t timeout
+    void RenderGraph::record_physical_pass(
+        const CommandBufferPtr& cmd_buf,
+        PhysicalPass& phys
     )
     {
-        if (fences.empty())
+        record_barriers(cmd_buf, phys.barriers_before);
+
+        if (phys.render_pass == nullptr)
         {
+            for (auto pass_id : phys.passes)
+            {
+                if (passes[pass_id].record)
+                {
+                    passes[pass_id].record(cmd_buf);
+                }
+            }
+            record_barriers(cmd_buf, phys.barriers_after);
             return;
         }
 
-        try
+        FramebufferPtr framebuf = nullptr;
+        std::vector<ImageViewPtr> imageless_views;
+        if (imageless_framebuffer_enabled(lock_wptr(device())))
         {
-            std::vector<VkFence> vk_fences(fences.size());
-            for (size_t i = 0; i < fences.size(); i++)
+            // an imageless framebuffer only depends on the images' create
+            // info, so a single one serves every imported view (like all the
+            // swapchain images) and the views are passed when beginning the
+            // render pass instead.
+            imageless_views.resize(phys.attachments.size());
+            for (size_t i = 0; i < phys.attachments.size(); i++)
             {
-                vk_fences[i] = fences[i]->handle();
+                imageless_views[i] = image_view(phys.attachments[i]);
             }
 
-            VkResult vk_result = vkWaitForFences(
-                lock_wptr(fences[0]->device())->handle(),
-                (uint32_t)vk_fences.size(),
-                vk_fences.data(),
-                wait_all,
-                timeout
-            );
-            if (vk_result != VK_SUCCESS)
+            if (phys.imageless_framebuf == nullptr)
             {
-                throw Error(vk_result);
+                std::vector<FramebufferAttachmentImageInfo> image_infos(
+                    imageless_views.size()
+                );
+                for (size_t i = 0; i < imageless_views.size(); i++)
+                {
+                    const auto& image_config =
+                        lock_wptr(imageless_views[i]->image())->config();
+                    image_infos[i] = FramebufferAttachmentImageInfo{
+                        .flags = image_config.flags,
+                        .usage = image_config.usage,
+                        .width = image_config.extent.width,
+                        .height = image_config.extent.height,
+                        .layer_count = image_config.array_layers,
+                        .view_formats = { imageless_views[i]->config().format }
+                    };
+                }
+
+                phys.imageless_framebuf = Framebuffer::create(
+                    lock_wptr(device()),
+                    {
+                        .flags = 0,
+                        .render_pass = phys.render_pass,
+                        .attachments = {},
+                        .width = phys.extent.width,
+                        .height = phys.extent.height,
+                        .layers = 1,
+                        .attachment_image_infos = image_infos
+                    }
+                );
             }
+            framebuf = phys.imageless_framebuf;
         }
-        catch (const Error& e)
+        else
         {
-            throw Error(
-                "failed to wait for fence(s) to become signaled: "
-                + e.to_string(),
-                e.vk_result(),
-                true
+            // imported views (like swapchain images) change between
+            // executions, so framebuffers are cached per combination of
+            // attachment views. entries are matched by the identity of the
+            // views rather than their handles, and the ones with destroyed
+            // views are evicted.
+            std::vector<ImageViewPtr> views(phys.attachments.size());
+            for (size_t i = 0; i < phys.attachments.size(); i++)
+            {
+                views[i] = image_view(phys.attachments[i]);
+                if (views[i] == nullptr)
+                {
+                    // throws a descriptive error for unset imported views
+                    vk_view_of(phys.attachments[i]);
+                }
+            }
+
+            std::erase_if(
+                phys.framebufs,
+                [](const CachedFramebuffer& cached)
+                {
+                    return std::any_of(
+                        cached.views.begin(),
+                        cached.views.end(),
+                        [](const ImageViewWPtr& view)
+                        {
+                            return view.expired();
+                        }
+                    );
+                }
             );
-        }
-    }
 
-    void Fence::reset()
-    {
-        try
-        {
-            VkResult vk_result = vkResetFences(
-                lock_wptr(device())->handle(),
-                1,
-                &_handle
+            auto it = std::find_if(
+                phys.framebufs.begin(),
+                phys.framebufs.end(),
+                [&](const CachedFramebuffer& cached)
+                {
+                    for (size_t i = 0; i < views.size(); i++)
+                    {
+                        if (cached.views[i].owner_before(views[i])
+                            || views[i].owner_before(cached.views[i]))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
             );
-            if (vk_result != VK_SUCCESS)
+            if (it == phys.framebufs.end())
             {
-                throw Error(vk_result);
+                CachedFramebuffer cached{
+                    .views = std::vector<ImageViewWPtr>(
+                        views.begin(),
+                        views.end()
+                    ),
+                    .framebuf = Framebuffer::create(
+                        lock_wptr(device()),
+                        {
+                            .flags = 0,
+                            .render_pass = phys.render_pass,
+                            .attachments = std::vector<ImageViewWPtr>(
+                                views.begin(),
+                                views.end()
+                            ),
+                            .width = phys.extent.width,
+                            .height = phys.extent.height,
+                            .layers = 1
+                        }
+                    )
+                };
+                phys.framebufs.push_back(std::move(cached));
+                it = phys.framebufs.end() - 1;
             }
+            framebuf = it->framebuf;
         }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to reset fence: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
-        }
-    }
 
-    bool Fence::is_signaled() const
-    {
-        try
+        cmd_buf->begin_render_pass(
+            phys.render_pass,
+            framebuf,
+            Rect2d{
+                .offset = { 0, 0 },
+                .extent = phys.extent
+            },
+            phys.clear_values,
+            VK_SUBPASS_CONTENTS_INLINE,
+            imageless_views
+        );
+
+        for (size_t i = 0; i < phys.passes.size(); i++)
         {
-            VkResult vk_result = vkGetFenceStatus(
-                lock_wptr(device())->handle(),
-                handle()
-            );
-            if (vk_result == VK_SUCCESS)
+            if (i > 0)
             {
-                return true;
+                cmd_buf->dispatch().vkCmdNextSubpass(
+                    cmd_buf->handle(),
+                    VK_SUBPASS_CONTENTS_INLINE
+                );
             }
-            else if (vk_result == VK_NOT_READY)
+            if (passes[phys.passes[i]].record)
             {
-                return false;
+                passes[phys.passes[i]].record(cmd_buf);
             }
-            throw Error(vk_result);
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to get fence status: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
         }
-    }
 
-    Fence::~Fence()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        cmd_buf->end_render_pass();
 
-        vkDestroyFence(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        record_barriers(cmd_buf, phys.barriers_after);
     }
 
-    Fence::Fence(const DevicePtr& device)
-        : _device(device)
-    {}
+#pragma endregion
 
-    BufferPtr Buffer::create(
+#pragma region staging ring
+
+    StagingRing::StagingRing(
         const DevicePtr& device,
-        const BufferConfig& config
+        const MemoryBankPtr& mem_bank,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags required_mem_props,
+        VkMemoryPropertyFlags preferred_mem_props
     )
+        : _size(size)
     {
-        try
+        if (size == 0 || size % 16 != 0)
         {
-            BufferPtr buf = std::make_shared<Buffer_public_ctor>(
-                device,
-                config
-            );
+            throw Error("staging size should be a non-zero multiple of 16");
+        }
 
-            VkBufferCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = buf->config().flags,
-                .size = buf->config().size,
-                .usage = buf->config().usage,
-                .sharingMode = buf->config().sharing_mode,
+        _buffer = Buffer::create(
+            device,
+            {
+                .flags = 0,
+                .size = size,
+                .usage = usage,
+                .sharing_mode = VK_SHARING_MODE_EXCLUSIVE,
+                .queue_family_indices = {}
+            }
+        );
+        _memory = mem_bank->allocate(
+            _buffer->memory_requirements(),
+            required_mem_props,
+            preferred_mem_props
+        );
+        _memory->bind(_buffer);
+        _mapped = (uint8_t*)_memory->mapped();
+    }
 
-                .queueFamilyIndexCount =
-                (uint32_t)buf->config().queue_family_indices.size(),
+    VkDeviceSize StagingRing::allocate(
+        VkDeviceSize size,
+        const std::function<void()>& make_room
+    )
+    {
+        // 16 covers the offset alignment of buffer to image copies for every
+        // format with a power of 2 texel size
+        constexpr VkDeviceSize alignment = 16;
 
-                .pQueueFamilyIndices = buf->config().queue_family_indices.data()
-            };
+        if (size > _size)
+        {
+            throw Error(std::format(
+                "size ({}) is larger than the staging buffer ({})",
+                size,
+                _size
+            ));
+        }
 
-            VkResult vk_result = vkCreateBuffer(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &buf->_handle
-            );
-            if (vk_result != VK_SUCCESS)
+        while (true)
+        {
+            VkDeviceSize begin = _BV_IDIV_CEIL(head, alignment) * alignment;
+
+            // allocations can't wrap around the end of the ring
+            if (begin / _size != (begin + size - 1) / _size)
             {
-                throw Error(vk_result);
+                begin = _BV_IDIV_CEIL(begin, _size) * _size;
             }
 
-            VkMemoryRequirements vk_mem_requirements;
-            vkGetBufferMemoryRequirements(
-                device->handle(),
-                buf->handle(),
-                &vk_mem_requirements
-            );
-            buf->_memory_requirements = MemoryRequirements_from_vk(
-                vk_mem_requirements
-            );
+            // oldest memory still in use
+            VkDeviceSize tail = begin;
+            if (!batch_begins.empty())
+            {
+                tail = batch_begins.front();
+            }
+            else if (has_pending)
+            {
+                tail = pending_begin;
+            }
 
-            return buf;
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to create buffer: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            if (begin + size - tail <= _size)
+            {
+                if (!has_pending)
+                {
+                    pending_begin = begin;
+                    has_pending = true;
+                }
+                head = begin + size;
+                return begin % _size;
+            }
+
+            make_room();
         }
     }
 
-    void Buffer::bind_memory(
-        const DeviceMemoryPtr& memory,
-        VkDeviceSize memory_offset
+    void StagingRing::submit()
+    {
+        batch_begins.push_back(has_pending ? pending_begin : head);
+        has_pending = false;
+    }
+
+    void StagingRing::retire()
+    {
+        batch_begins.pop_front();
+    }
+
+    // reuse a command buffer that was returned to free_cmd_bufs or allocate a
+    // new one from the pool
+    static CommandBufferPtr take_free_cmd_buf(
+        const CommandPoolPtr& pool,
+        std::vector<CommandBufferPtr>& free_cmd_bufs
     )
     {
-        try
-        {
-            VkResult vk_result = vkBindBufferMemory(
-                lock_wptr(device())->handle(),
-                handle(),
-                memory->handle(),
-                memory_offset
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-        }
-        catch (const Error& e)
+        if (free_cmd_bufs.empty())
         {
-            throw Error(
-                "failed to bind buffer memory: " + e.to_string(),
-                e.vk_result(),
-                true
+            return CommandPool::allocate_buffer(
+                pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY
             );
         }
-    }
-
-    Buffer::~Buffer()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
 
-        vkDestroyBuffer(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+        CommandBufferPtr cmd_buf = free_cmd_bufs.back();
+        free_cmd_bufs.pop_back();
+        cmd_buf->reset(0);
+        return cmd_buf;
     }
 
-    Buffer::Buffer(const DevicePtr& device, const BufferConfig& config)
-        : _device(device), _config(config)
-    {}
+#pragma endregion
 
-    DeviceMemoryPtr DeviceMemory::allocate(
+#pragma region upload engine
+
+    UploadEnginePtr UploadEngine::create(
         const DevicePtr& device,
-        const DeviceMemoryConfig& config
+        const MemoryBankPtr& mem_bank,
+        const UploadEngineConfig& config
     )
     {
         try
         {
-            DeviceMemoryPtr mem = std::make_shared<DeviceMemory_public_ctor>(
+            QueuePtr transfer_queue = lock_wptr(config.transfer_queue);
+            QueuePtr dst_queue =
+                config.dst_queue.expired() ? nullptr : config.dst_queue.lock();
+
+            auto engine = std::make_shared<UploadEngine_public_ctor>(
                 device,
-                config
+                config,
+                transfer_queue,
+                dst_queue,
+                TimelineSemaphore::create(device, 0)
             );
 
-            VkMemoryAllocateInfo allocate_info{
-                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                .pNext = nullptr,
-                .allocationSize = mem->config().allocation_size,
-                .memoryTypeIndex = mem->config().memory_type_index
-            };
+            engine->staging = StagingRing(
+                device,
+                mem_bank,
+                config.staging_size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 
-            VkResult vk_result = vkAllocateMemory(
-                device->handle(),
-                &allocate_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &mem->_handle
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
             );
-            if (vk_result != VK_SUCCESS)
+
+            engine->transfer_cmd_pool = CommandPool::create(
+                device,
+                {
+                    .flags =
+                    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+                    | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+
+                    .queue_family_index = transfer_queue->queue_family_index()
+                }
+            );
+            if (engine->transfers_ownership())
             {
-                throw Error(vk_result);
+                engine->acquire_cmd_pool = CommandPool::create(
+                    device,
+                    {
+                        .flags =
+                        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+                        | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+
+                        .queue_family_index = dst_queue->queue_family_index()
+                    }
+                );
             }
-            return mem;
+
+            return engine;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to allocate device memory: " + e.to_string(),
+                "failed to create upload engine: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    void* DeviceMemory::map(VkDeviceSize offset, VkDeviceSize size)
+    void UploadEngine::upload_to_buffer(
+        const void* data,
+        VkDeviceSize size,
+        const BufferPtr& dst_buffer,
+        VkDeviceSize dst_offset
+    )
     {
         try
         {
-            void* p;
-            VkResult vk_result = vkMapMemory(
-                lock_wptr(device())->handle(),
-                handle(),
-                offset,
-                size,
-                0,
-                &p
-            );
-            if (vk_result != VK_SUCCESS)
+            if (size == 0)
             {
-                unmap();
-                throw Error(vk_result);
+                return;
             }
-            return p;
-        }
-        catch (const Error& e)
-        {
-            throw Error(
-                "failed to map device memory: " + e.to_string(),
-                e.vk_result(),
-                true
+
+            VkDeviceSize staging_offset = allocate_staging(size);
+            std::copy(
+                (const uint8_t*)data,
+                (const uint8_t*)data + size,
+                staging.mapped() + staging_offset
             );
-        }
-    }
 
-    void DeviceMemory::unmap()
-    {
-        if (device().expired())
-        {
-            return;
-        }
-        vkUnmapMemory(device().lock()->handle(), handle());
-    }
+            begin_pending();
 
-    void DeviceMemory::flush_mapped_range(
-        VkDeviceSize offset,
-        VkDeviceSize size
-    )
-    {
-        try
-        {
-            VkMappedMemoryRange vk_mapped_range{
-                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-                .pNext = nullptr,
-                .memory = handle(),
-                .offset = offset,
+            VkBufferCopy region{
+                .srcOffset = staging_offset,
+                .dstOffset = dst_offset,
                 .size = size
             };
-
-            VkResult vk_result = vkFlushMappedMemoryRanges(
-                lock_wptr(device())->handle(),
+            pending_cmd_buf->dispatch().vkCmdCopyBuffer(
+                pending_cmd_buf->handle(),
+                staging.buffer()->handle(),
+                dst_buffer->handle(),
                 1,
-                &vk_mapped_range
+                &region
             );
-            if (vk_result != VK_SUCCESS)
+
+            if (transfers_ownership())
             {
-                throw Error(vk_result);
+                pending_buffer_barriers.push_back(VkBufferMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .pNext = nullptr,
+                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .dstAccessMask = 0,
+                    .srcQueueFamilyIndex = transfer_queue->queue_family_index(),
+                    .dstQueueFamilyIndex = dst_queue->queue_family_index(),
+                    .buffer = dst_buffer->handle(),
+                    .offset = dst_offset,
+                    .size = size
+                    });
             }
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to flush mapped device memory range: " + e.to_string(),
+                "failed to upload to buffer: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    void DeviceMemory::invalidate_mapped_range(
-        VkDeviceSize offset,
-        VkDeviceSize size
+    void UploadEngine::upload_to_image(
+        const void* data,
+        VkDeviceSize size,
+        const ImagePtr& dst_image,
+        VkImageAspectFlags aspect_mask,
+        VkImageLayout final_layout
     )
     {
         try
         {
-            VkMappedMemoryRange vk_mapped_range{
-                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+            if (size == 0)
+            {
+                return;
+            }
+
+            const auto& image_config = dst_image->config();
+            VkImageSubresourceRange subresource_range{
+                .aspectMask = aspect_mask,
+                .baseMipLevel = 0,
+                .levelCount = image_config.mip_levels,
+                .baseArrayLayer = 0,
+                .layerCount = image_config.array_layers
+            };
+
+            VkDeviceSize staging_offset = allocate_staging(size);
+            std::copy(
+                (const uint8_t*)data,
+                (const uint8_t*)data + size,
+                staging.mapped() + staging_offset
+            );
+
+            begin_pending();
+
+            VkImageMemoryBarrier to_transfer_dst{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
                 .pNext = nullptr,
-                .memory = handle(),
-                .offset = offset,
-                .size = size
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = dst_image->handle(),
+                .subresourceRange = subresource_range
             };
+            pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                pending_cmd_buf->handle(),
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0,
+                nullptr,
+                0,
+                nullptr,
+                1,
+                &to_transfer_dst
+            );
 
-            VkResult vk_result = vkInvalidateMappedMemoryRanges(
-                lock_wptr(device())->handle(),
+            VkBufferImageCopy region{
+                .bufferOffset = staging_offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = VkImageSubresourceLayers{
+                    .aspectMask = aspect_mask,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = image_config.array_layers
+                },
+                .imageOffset = VkOffset3D{ 0, 0, 0 },
+                .imageExtent = VkExtent3D{
+                    image_config.extent.width,
+                    image_config.extent.height,
+                    image_config.extent.depth
+                }
+            };
+            pending_cmd_buf->dispatch().vkCmdCopyBufferToImage(
+                pending_cmd_buf->handle(),
+                staging.buffer()->handle(),
+                dst_image->handle(),
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 1,
-                &vk_mapped_range
+                &region
             );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
+
+            // the final layout transition is recorded in flush(). it doubles
+            // as the release half of the ownership transfer if there is one.
+            pending_image_barriers.push_back(VkImageMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = 0,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = final_layout,
+
+                .srcQueueFamilyIndex =
+                transfers_ownership()
+                ? transfer_queue->queue_family_index()
+                : VK_QUEUE_FAMILY_IGNORED,
+
+                .dstQueueFamilyIndex =
+                transfers_ownership()
+                ? dst_queue->queue_family_index()
+                : VK_QUEUE_FAMILY_IGNORED,
+
+                .image = dst_image->handle(),
+                .subresourceRange = subresource_range
+                });
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to invalidate mapped device memory range: "
-                + e.to_string(),
+                "failed to upload to image: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    void DeviceMemory::upload(void* data, VkDeviceSize data_size)
+    uint64_t UploadEngine::flush(const UploadCallback& callback)
     {
         try
         {
-            if (data_size > config().allocation_size)
+            if (pending_cmd_buf == nullptr)
             {
-                throw Error("data is too big");
+                if (callback != nullptr)
+                {
+                    if (in_flight.empty())
+                    {
+                        callback();
+                    }
+                    else
+                    {
+                        in_flight.back().callbacks.push_back(callback);
+                    }
+                }
+                return last_flushed_value();
             }
 
-            void* mapped = map(0, config().allocation_size);
-            std::copy(
-                (uint8_t*)data,
-                (uint8_t*)data + data_size,
-                (uint8_t*)mapped
+            // release barriers, or just the final layout transitions if
+            // there's no ownership transfer
+            if (!pending_buffer_barriers.empty()
+                || !pending_image_barriers.empty())
+            {
+                pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                    pending_cmd_buf->handle(),
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    (uint32_t)pending_buffer_barriers.size(),
+                    pending_buffer_barriers.data(),
+                    (uint32_t)pending_image_barriers.size(),
+                    pending_image_barriers.data()
+                );
+            }
+            pending_cmd_buf->end();
+
+            InFlight flight{
+                .value = last_flushed_value() + 1,
+                .transfer_cmd_buf = pending_cmd_buf,
+                .acquire_cmd_buf = nullptr,
+                .callbacks = {}
+            };
+            pending_cmd_buf = nullptr;
+            staging.submit();
+
+            VkSemaphore vk_timeline = timeline()->handle();
+            VkCommandBuffer vk_transfer_cmd_buf =
+                flight.transfer_cmd_buf->handle();
+            uint64_t transfer_value = flight.value;
+
+            SubmitBatch transfer_batch{
+                .wait_semaphores = {},
+                .wait_stages = {},
+                .command_buffers = std::span<const VkCommandBuffer>(
+                    &vk_transfer_cmd_buf,
+                    1
+                ),
+                .signal_semaphores = std::span<const VkSemaphore>(
+                    &vk_timeline,
+                    1
+                ),
+                .wait_values = {},
+                .signal_values = std::span<const uint64_t>(
+                    &transfer_value,
+                    1
+                )
+            };
+            transfer_queue->submit_batches(
+                std::span<const SubmitBatch>(&transfer_batch, 1)
             );
-            flush_mapped_range(0, VK_WHOLE_SIZE);
-            unmap();
+
+            if (transfers_ownership())
+            {
+                // turn the release barriers into the matching acquire
+                // barriers
+                for (auto& barrier : pending_buffer_barriers)
+                {
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask =
+                        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                }
+                for (auto& barrier : pending_image_barriers)
+                {
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask =
+                        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                }
+
+                flight.acquire_cmd_buf = take_cmd_buf(true);
+                flight.acquire_cmd_buf->begin(
+                    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+                );
+                flight.acquire_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                    flight.acquire_cmd_buf->handle(),
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    (uint32_t)pending_buffer_barriers.size(),
+                    pending_buffer_barriers.data(),
+                    (uint32_t)pending_image_barriers.size(),
+                    pending_image_barriers.data()
+                );
+                flight.acquire_cmd_buf->end();
+
+                flight.value = transfer_value + 1;
+
+                VkPipelineStageFlags wait_stage =
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                VkCommandBuffer vk_acquire_cmd_buf =
+                    flight.acquire_cmd_buf->handle();
+
+                SubmitBatch acquire_batch{
+                    .wait_semaphores = std::span<const VkSemaphore>(
+                        &vk_timeline,
+                        1
+                    ),
+                    .wait_stages = std::span<const VkPipelineStageFlags>(
+                        &wait_stage,
+                        1
+                    ),
+                    .command_buffers = std::span<const VkCommandBuffer>(
+                        &vk_acquire_cmd_buf,
+                        1
+                    ),
+                    .signal_semaphores = std::span<const VkSemaphore>(
+                        &vk_timeline,
+                        1
+                    ),
+                    .wait_values = std::span<const uint64_t>(
+                        &transfer_value,
+                        1
+                    ),
+                    .signal_values = std::span<const uint64_t>(
+                        &flight.value,
+                        1
+                    )
+                };
+                dst_queue->submit_batches(
+                    std::span<const SubmitBatch>(&acquire_batch, 1)
+                );
+            }
+
+            pending_buffer_barriers.clear();
+            pending_image_barriers.clear();
+
+            if (callback != nullptr)
+            {
+                flight.callbacks.push_back(callback);
+            }
+            _last_flushed_value = flight.value;
+            in_flight.push_back(std::move(flight));
+
+            return last_flushed_value();
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to upload data to device memory: " + e.to_string(),
+                "failed to flush uploads: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    DeviceMemory::~DeviceMemory()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkFreeMemory(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
-    }
-
-    DeviceMemory::DeviceMemory(
-        const DevicePtr& device,
-        const DeviceMemoryConfig& config
-    )
-        : _device(device), _config(config)
-    {}
-
-    void DescriptorSet::update_sets(
-        const DevicePtr& device,
-        const std::vector<WriteDescriptorSet>& writes,
-        const std::vector<CopyDescriptorSet>& copies
-    )
+    void UploadEngine::poll()
     {
-        if (writes.empty() && copies.empty())
+        if (in_flight.empty())
         {
             return;
         }
 
-        try
+        uint64_t completed_value = timeline()->counter_value();
+        while (!in_flight.empty() && in_flight.front().value <= completed_value)
         {
-            std::vector<VkWriteDescriptorSet> vk_writes(writes.size());
-            std::vector<std::vector<VkDescriptorImageInfo>>
-                wastes_vk_image_infos(writes.size());
-            std::vector<std::vector<VkDescriptorBufferInfo>>
-                wastes_vk_buffer_infos(writes.size());
-            std::vector<std::vector<VkBufferView>>
-                wastes_vk_texel_buffer_views(writes.size());
-            for (size_t i = 0; i < writes.size(); i++)
+            // pop first in case a callback uploads something
+            InFlight flight = std::move(in_flight.front());
+            in_flight.pop_front();
+            staging.retire();
+
+            free_transfer_cmd_bufs.push_back(flight.transfer_cmd_buf);
+            if (flight.acquire_cmd_buf != nullptr)
             {
-                vk_writes[i] = WriteDescriptorSet_to_vk(
-                    writes[i],
-                    wastes_vk_image_infos[i],
-                    wastes_vk_buffer_infos[i],
-                    wastes_vk_texel_buffer_views[i]
-                );
+                free_acquire_cmd_bufs.push_back(flight.acquire_cmd_buf);
             }
 
-            std::vector<VkCopyDescriptorSet> vk_copies(copies.size());
-            for (size_t i = 0; i < copies.size(); i++)
+            for (const auto& callback : flight.callbacks)
             {
-                vk_copies[i] = CopyDescriptorSet_to_vk(copies[i]);
+                callback();
             }
+        }
+    }
 
-            vkUpdateDescriptorSets(
-                device->handle(),
-                (uint32_t)vk_writes.size(),
-                vk_writes.data(),
-                (uint32_t)vk_copies.size(),
-                vk_copies.data()
-            );
+    void UploadEngine::wait(uint64_t value, uint64_t timeout)
+    {
+        timeline()->wait(value, timeout);
+        poll();
+    }
+
+    void UploadEngine::wait_idle()
+    {
+        wait(flush());
+    }
+
+    UploadEngine::~UploadEngine()
+    {
+        // the staging buffer and the command buffers must not be destroyed
+        // while the device is still using them
+        if (!in_flight.empty())
+        {
+            try
+            {
+                timeline()->wait(last_flushed_value());
+            }
+            catch (const Error&)
+            {}
         }
-        catch (const Error& e)
+    }
+
+    UploadEngine::UploadEngine(
+        const DevicePtr& device,
+        const UploadEngineConfig& config,
+        const QueuePtr& transfer_queue,
+        const QueuePtr& dst_queue,
+        const TimelineSemaphorePtr& timeline
+    )
+        : _device(device),
+        _config(config),
+        transfer_queue(transfer_queue),
+        dst_queue(dst_queue),
+
+        _transfers_ownership(
+            dst_queue != nullptr
+            && dst_queue->queue_family_index()
+            != transfer_queue->queue_family_index()
+        ),
+
+        _timeline(timeline)
+    {}
+
+    CommandBufferPtr UploadEngine::take_cmd_buf(bool acquire)
+    {
+        if (acquire)
         {
-            throw Error(
-                "failed to update descriptor sets: " + e.to_string(),
-                e.vk_result(),
-                true
-            );
+            return take_free_cmd_buf(acquire_cmd_pool, free_acquire_cmd_bufs);
         }
+        return take_free_cmd_buf(transfer_cmd_pool, free_transfer_cmd_bufs);
     }
 
-    DescriptorSet::~DescriptorSet()
+    void UploadEngine::begin_pending()
     {
-        _BV_LOCK_WPTR_OR_RETURN(pool(), pool_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            pool_locked->device(),
-            device_locked
-        );
+        if (pending_cmd_buf != nullptr)
+        {
+            return;
+        }
+        pending_cmd_buf = take_cmd_buf(false);
+        pending_cmd_buf->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    }
 
-        vkFreeDescriptorSets(
-            device_locked->handle(),
-            pool_locked->handle(),
-            1,
-            &_handle
+    VkDeviceSize UploadEngine::allocate_staging(VkDeviceSize size)
+    {
+        return staging.allocate(
+            size,
+            [this]()
+            {
+                // the ring is full, free up space
+                if (in_flight.empty())
+                {
+                    flush();
+                }
+                else
+                {
+                    wait(in_flight.front().value);
+                }
+            }
         );
     }
 
-    DescriptorSet::DescriptorSet(
-        const DescriptorPoolPtr& pool,
-        VkDescriptorSet handle
+#pragma endregion
+
+#pragma region readback engine
+
+    // size of a texel of an uncompressed format in a buffer to image copy.
+    // depth/stencil formats are copied one aspect at a time, so their size
+    // depends on the aspect.
+    static VkDeviceSize format_texel_size(
+        VkFormat format,
+        VkImageAspectFlags aspect_mask
     )
-        : _pool(pool), _handle(handle)
-    {}
+    {
+        bool stencil = aspect_mask == VK_IMAGE_ASPECT_STENCIL_BIT;
+        switch (format)
+        {
+        case VK_FORMAT_D16_UNORM:
+            return 2;
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return 4;
+        case VK_FORMAT_S8_UINT:
+            return 1;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+            return stencil ? 1 : 2;
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return stencil ? 1 : 4;
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+            return 4;
+        default:
+            break;
+        }
 
-    DescriptorPoolPtr DescriptorPool::create(
+        // the core formats are grouped by layout in the enum
+        const auto in = [format](VkFormat first, VkFormat last)
+        {
+            return format >= first && format <= last;
+        };
+        if (format == VK_FORMAT_R4G4_UNORM_PACK8
+            || in(VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB))
+        {
+            return 1;
+        }
+        if (in(
+            VK_FORMAT_R4G4B4A4_UNORM_PACK16,
+            VK_FORMAT_A1R5G5B5_UNORM_PACK16
+        )
+            || in(VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB)
+            || in(VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT))
+        {
+            return 2;
+        }
+        if (in(VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB))
+        {
+            return 3;
+        }
+        if (in(VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32)
+            || in(VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT)
+            || in(VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT))
+        {
+            return 4;
+        }
+        if (in(VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT))
+        {
+            return 6;
+        }
+        if (in(VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT)
+            || in(VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT)
+            || in(VK_FORMAT_R64_UINT, VK_FORMAT_R64_SFLOAT))
+        {
+            return 8;
+        }
+        if (in(VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT))
+        {
+            return 12;
+        }
+        if (in(VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT)
+            || in(VK_FORMAT_R64G64_UINT, VK_FORMAT_R64G64_SFLOAT))
+        {
+            return 16;
+        }
+        if (in(VK_FORMAT_R64G64B64_UINT, VK_FORMAT_R64G64B64_SFLOAT))
+        {
+            return 24;
+        }
+        if (in(VK_FORMAT_R64G64B64A64_UINT, VK_FORMAT_R64G64B64A64_SFLOAT))
+        {
+            return 32;
+        }
+        throw Error(std::format(
+            "unsupported format {}",
+            string_VkFormat(format)
+        ));
+    }
+
+    ReadbackEnginePtr ReadbackEngine::create(
         const DevicePtr& device,
-        const DescriptorPoolConfig& config
+        const MemoryBankPtr& mem_bank,
+        const ReadbackEngineConfig& config
     )
     {
         try
         {
-            DescriptorPoolPtr pool =
-                std::make_shared<DescriptorPool_public_ctor>(
-                    device,
-                    config
-                );
+            auto engine = std::make_shared<ReadbackEngine_public_ctor>(
+                device,
+                config,
+                lock_wptr(config.queue),
 
-            std::vector<VkDescriptorPoolSize> vk_pool_sizes(
-                pool->config().pool_sizes.size()
+                config.use_timeline_semaphore
+                ? TimelineSemaphore::create(device, 0)
+                : nullptr
             );
-            for (size_t i = 0; i < pool->config().pool_sizes.size(); i++)
-            {
-                vk_pool_sizes[i] = DescriptorPoolSize_to_vk(
-                    pool->config().pool_sizes[i]
-                );
-            }
 
-            VkDescriptorPoolCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = pool->config().flags,
-                .maxSets = pool->config().max_sets,
-                .poolSizeCount = (uint32_t)vk_pool_sizes.size(),
-                .pPoolSizes = vk_pool_sizes.data()
-            };
+            engine->staging = StagingRing(
+                device,
+                mem_bank,
+                config.staging_size,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+            );
 
-            VkResult vk_result = vkCreateDescriptorPool(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &pool->_handle
+            const auto& mem_config =
+                engine->staging.memory()->memory()->config();
+            engine->_staging_is_cached =
+                device->physical_device().memory_properties().memory_types[
+                    mem_config.memory_type_index
+                ].property_flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+            engine->cmd_pool = CommandPool::create(
+                device,
+                {
+                    .flags =
+                    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+                    | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+
+                    .queue_family_index = engine->queue->queue_family_index()
+                }
             );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
-            }
-            return pool;
+
+            return engine;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create descriptor pool: " + e.to_string(),
+                "failed to create readback engine: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    DescriptorSetPtr DescriptorPool::allocate_set(
-        const DescriptorPoolPtr& pool,
-        const DescriptorSetLayoutPtr& set_layout
+    void ReadbackEngine::readback_buffer(
+        const BufferPtr& src_buffer,
+        VkDeviceSize src_offset,
+        VkDeviceSize size,
+        const ReadbackCallback& callback
     )
     {
         try
         {
-            VkDescriptorSetLayout vk_set_layout = set_layout->handle();
-
-            VkDescriptorSetAllocateInfo alloc_info{
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                .pNext = nullptr,
-                .descriptorPool = pool->handle(),
-                .descriptorSetCount = 1,
-                .pSetLayouts = &vk_set_layout
-            };
-
-            VkDescriptorSet vk_set;
-            VkResult vk_result = vkAllocateDescriptorSets(
-                lock_wptr(pool->device())->handle(),
-                &alloc_info,
-                &vk_set
-            );
-            if (vk_result != VK_SUCCESS)
+            if (size == 0)
             {
-                throw Error(vk_result);
+                return;
             }
-            return std::make_shared<DescriptorSet_public_ctor>(
-                pool,
-                vk_set
+
+            VkDeviceSize staging_offset = allocate_staging(size);
+            begin_pending();
+
+            VkBufferCopy region{
+                .srcOffset = src_offset,
+                .dstOffset = staging_offset,
+                .size = size
+            };
+            pending_cmd_buf->dispatch().vkCmdCopyBuffer(
+                pending_cmd_buf->handle(),
+                src_buffer->handle(),
+                staging.buffer()->handle(),
+                1,
+                &region
             );
+
+            pending_readbacks.push_back(Readback{
+                .staging_offset = staging_offset,
+                .size = size,
+                .callback = callback
+                });
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to allocate descriptor set: " + e.to_string(),
+                "failed to read back buffer: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::vector<DescriptorSetPtr> DescriptorPool::allocate_sets(
-        const DescriptorPoolPtr& pool,
-        uint32_t count,
-        const std::vector<DescriptorSetLayoutPtr>& set_layouts
+    void ReadbackEngine::readback_image(
+        const ImagePtr& src_image,
+        VkImageLayout layout,
+        VkDeviceSize size,
+        const ReadbackCallback& callback,
+        VkImageAspectFlags aspect_mask
     )
     {
         try
         {
-            if (count != set_layouts.size())
+            if (size == 0)
             {
-                throw Error(
-                    "there should be the same number of descriptor set layouts "
-                    "as the number of sets to create"
-                );
+                return;
             }
 
-            if (count < 1)
+            const auto& image_config = src_image->config();
+
+            // the copy writes the whole image no matter what size says, so
+            // a smaller size would overrun the staging allocation and a
+            // larger one would hand uninitialized bytes to the callback
+            VkDeviceSize image_size =
+                format_texel_size(image_config.format, aspect_mask)
+                * image_config.extent.width
+                * image_config.extent.height
+                * image_config.extent.depth
+                * image_config.array_layers;
+            if (size != image_size)
             {
-                return {};
+                throw Error(std::format(
+                    "size ({}) doesn't match the size of the image data ({})",
+                    size,
+                    image_size
+                ));
             }
 
-            std::vector<VkDescriptorSetLayout>vk_set_layouts(
-                set_layouts.size()
-            );
-            for (size_t i = 0; i < set_layouts.size(); i++)
-            {
-                vk_set_layouts[i] = set_layouts[i]->handle();
-            }
+            VkDeviceSize staging_offset = allocate_staging(size);
+            begin_pending();
 
-            VkDescriptorSetAllocateInfo alloc_info{
-                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            bool needs_transition =
+                layout != VK_IMAGE_LAYOUT_GENERAL
+                && layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            VkImageLayout copy_layout =
+                needs_transition
+                ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                : layout;
+
+            VkImageMemoryBarrier barrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
                 .pNext = nullptr,
-                .descriptorPool = pool->handle(),
-                .descriptorSetCount = count,
-                .pSetLayouts = vk_set_layouts.data()
+                .srcAccessMask = 0,
+                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .oldLayout = layout,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = src_image->handle(),
+                .subresourceRange = VkImageSubresourceRange{
+                    .aspectMask = aspect_mask,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = image_config.array_layers
+                }
             };
 
-            std::vector<VkDescriptorSet> vk_sets(count);
-            VkResult vk_result = vkAllocateDescriptorSets(
-                lock_wptr(pool->device())->handle(),
-                &alloc_info,
-                vk_sets.data()
-            );
-            if (vk_result != VK_SUCCESS)
+            // the memory dependency on earlier writes is covered by the
+            // barrier recorded in begin_pending()
+            if (needs_transition)
             {
-                throw Error(vk_result);
+                pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                    pending_cmd_buf->handle(),
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr,
+                    1,
+                    &barrier
+                );
             }
 
-            std::vector<DescriptorSetPtr> sets(count);
-            for (size_t i = 0; i < count; i++)
+            VkBufferImageCopy region{
+                .bufferOffset = staging_offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = VkImageSubresourceLayers{
+                    .aspectMask = aspect_mask,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = image_config.array_layers
+                },
+                .imageOffset = VkOffset3D{ 0, 0, 0 },
+                .imageExtent = VkExtent3D{
+                    image_config.extent.width,
+                    image_config.extent.height,
+                    image_config.extent.depth
+                }
+            };
+            pending_cmd_buf->dispatch().vkCmdCopyImageToBuffer(
+                pending_cmd_buf->handle(),
+                src_image->handle(),
+                copy_layout,
+                staging.buffer()->handle(),
+                1,
+                &region
+            );
+
+            // transition back to the original layout for later submissions.
+            // the destination scope is the transfer stage so that the next
+            // readback of the same image in this command buffer, whose
+            // barrier starts there, is ordered after this transition.
+            if (needs_transition)
             {
-                sets[i] = std::make_shared<DescriptorSet_public_ctor>(
-                    pool,
-                    vk_sets[i]
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask =
+                    VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.newLayout = layout;
+                pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                    pending_cmd_buf->handle(),
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    0,
+                    nullptr,
+                    0,
+                    nullptr,
+                    1,
+                    &barrier
                 );
             }
-            return sets;
+
+            pending_readbacks.push_back(Readback{
+                .staging_offset = staging_offset,
+                .size = size,
+                .callback = callback
+                });
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to allocate descriptor set(s): " + e.to_string(),
+                "failed to read back image: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    DescriptorPool::~DescriptorPool()
-    {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkDestroyDescriptorPool(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
-    }
-
-    DescriptorPool::DescriptorPool(
-        const DevicePtr& device,
-        const DescriptorPoolConfig& config
-    )
-        : _device(device), _config(config)
-    {}
-
-    BufferViewPtr BufferView::create(
-        const DevicePtr& device,
-        const BufferPtr& buffer,
-        const BufferViewConfig& config
-    )
+    uint64_t ReadbackEngine::flush()
     {
         try
         {
-            BufferViewPtr view = std::make_shared<BufferView_public_ctor>(
-                device,
-                buffer,
-                config
-            );
+            if (pending_cmd_buf == nullptr)
+            {
+                return last_flushed_value();
+            }
 
-            VkBufferViewCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO,
+            // make the copies visible to the host
+            VkMemoryBarrier to_host{
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
                 .pNext = nullptr,
-                .flags = 0,
-                .buffer = lock_wptr(view->buffer())->handle(),
-                .format = view->config().format,
-                .offset = view->config().offset,
-                .range = view->config().range
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_HOST_READ_BIT
             };
-
-            VkResult vk_result = vkCreateBufferView(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &view->_handle
+            pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+                pending_cmd_buf->handle(),
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_HOST_BIT,
+                0,
+                1,
+                &to_host,
+                0,
+                nullptr,
+                0,
+                nullptr
             );
-            if (vk_result != VK_SUCCESS)
+            pending_cmd_buf->end();
+
+            InFlight flight{
+                .value = last_flushed_value() + 1,
+                .cmd_buf = pending_cmd_buf,
+                .fence = nullptr,
+                .readbacks = std::move(pending_readbacks)
+            };
+            pending_cmd_buf = nullptr;
+            pending_readbacks.clear();
+            staging.submit();
+
+            if (timeline() != nullptr)
             {
-                throw Error(vk_result);
+                VkSemaphore vk_timeline = timeline()->handle();
+                VkCommandBuffer vk_cmd_buf = flight.cmd_buf->handle();
+
+                SubmitBatch batch{
+                    .wait_semaphores = {},
+                    .wait_stages = {},
+                    .command_buffers = std::span<const VkCommandBuffer>(
+                        &vk_cmd_buf,
+                        1
+                    ),
+                    .signal_semaphores = std::span<const VkSemaphore>(
+                        &vk_timeline,
+                        1
+                    ),
+                    .wait_values = {},
+                    .signal_values = std::span<const uint64_t>(
+                        &flight.value,
+                        1
+                    )
+                };
+                queue->submit_batches(std::span<const SubmitBatch>(&batch, 1));
             }
-            return view;
+            else
+            {
+                if (free_fences.empty())
+                {
+                    flight.fence = Fence::create(lock_wptr(device()), 0);
+                }
+                else
+                {
+                    flight.fence = free_fences.back();
+                    free_fences.pop_back();
+                    flight.fence->reset();
+                }
+                queue->submit({}, {}, { flight.cmd_buf }, {}, flight.fence);
+            }
+
+            _last_flushed_value = flight.value;
+            in_flight.push_back(std::move(flight));
+
+            return last_flushed_value();
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create buffer view: " + e.to_string(),
+                "failed to flush readbacks: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    BufferView::~BufferView()
+    void ReadbackEngine::poll()
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
+        while (!in_flight.empty() && is_complete(in_flight.front()))
+        {
+            // pop first in case a callback reads something back
+            InFlight flight = std::move(in_flight.front());
+            in_flight.pop_front();
+            staging.retire();
 
-        vkDestroyBufferView(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
+            for (const auto& readback : flight.readbacks)
+            {
+                staging.memory()->invalidate(
+                    readback.staging_offset,
+                    readback.size
+                );
+                if (readback.callback != nullptr)
+                {
+                    readback.callback(std::span<const uint8_t>(
+                        staging.mapped() + readback.staging_offset,
+                        readback.size
+                    ));
+                }
+            }
+
+            free_cmd_bufs.push_back(flight.cmd_buf);
+            if (flight.fence != nullptr)
+            {
+                free_fences.push_back(flight.fence);
+            }
+        }
     }
 
-    BufferView::BufferView(
+    void ReadbackEngine::wait(uint64_t value, uint64_t timeout)
+    {
+        if (timeline() != nullptr)
+        {
+            timeline()->wait(value, timeout);
+        }
+        else
+        {
+            for (const auto& flight : in_flight)
+            {
+                if (flight.value >= value)
+                {
+                    flight.fence->wait(timeout);
+                    break;
+                }
+            }
+        }
+        poll();
+    }
+
+    void ReadbackEngine::wait_idle()
+    {
+        wait(flush());
+    }
+
+    ReadbackEngine::~ReadbackEngine()
+    {
+        // the staging buffer and the command buffers must not be destroyed
+        // while the device is still using them
+        if (!in_flight.empty())
+        {
+            try
+            {
+                if (timeline() != nullptr)
+                {
+                    timeline()->wait(last_flushed_value());
+                }
+                else
+                {
+                    in_flight.back().fence->wait();
+                }
+            }
+            catch (const Error&)
+            {}
+        }
+    }
+
+    ReadbackEngine::ReadbackEngine(
         const DevicePtr& device,
-        const BufferPtr& buffer,
-        const BufferViewConfig& config
+        const ReadbackEngineConfig& config,
+        const QueuePtr& queue,
+        const TimelineSemaphorePtr& timeline
     )
         : _device(device),
-        _buffer(buffer),
-        _config(config)
+        _config(config),
+        queue(queue),
+        _timeline(timeline)
     {}
 
-    PipelineCachePtr PipelineCache::create(
+    bool ReadbackEngine::is_complete(const InFlight& flight) const
+    {
+        if (timeline() != nullptr)
+        {
+            return flight.value <= timeline()->counter_value();
+        }
+        return flight.fence->is_signaled();
+    }
+
+    void ReadbackEngine::begin_pending()
+    {
+        if (pending_cmd_buf != nullptr)
+        {
+            return;
+        }
+
+        pending_cmd_buf = take_free_cmd_buf(cmd_pool, free_cmd_bufs);
+        pending_cmd_buf->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        // wait for earlier submissions to finish writing the sources
+        VkMemoryBarrier from_writes{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+        };
+        pending_cmd_buf->dispatch().vkCmdPipelineBarrier(
+            pending_cmd_buf->handle(),
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &from_writes,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+    }
+
+    VkDeviceSize ReadbackEngine::allocate_staging(VkDeviceSize size)
+    {
+        return staging.allocate(
+            size,
+            [this]()
+            {
+                // the ring is full, free up space
+                if (in_flight.empty())
+                {
+                    flush();
+                }
+                else
+                {
+                    wait(in_flight.front().value);
+                }
+            }
+        );
+    }
+
+#pragma endregion
+
+#pragma region GPU profiler
+
+    // the host clock that matches std::chrono::steady_clock
+#ifdef _WIN32
+    static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN =
+        VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+    static constexpr VkTimeDomainEXT HOST_TIME_DOMAIN =
+        VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+    // convert a timestamp in HOST_TIME_DOMAIN to nanoseconds the same way
+    // std::chrono::steady_clock does
+    static int64_t host_timestamp_to_ns(uint64_t timestamp)
+    {
+#ifdef _WIN32
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const int64_t freq = frequency.QuadPart;
+        const int64_t ticks = (int64_t)timestamp;
+        return (ticks / freq) * 1'000'000'000
+            + (ticks % freq) * 1'000'000'000 / freq;
+#else
+        return (int64_t)timestamp;
+#endif
+    }
+
+    // b - a in ticks of a counter with the given mask of valid bits,
+    // accounting for wrap-around
+    static int64_t timestamp_delta(uint64_t a, uint64_t b, uint64_t mask)
+    {
+        uint64_t delta = (b - a) & mask;
+        if (delta > mask / 2)
+        {
+            return -(int64_t)((mask - delta) + 1);
+        }
+        return (int64_t)delta;
+    }
+
+    GpuProfilerPtr GpuProfiler::create(
         const DevicePtr& device,
-        VkPipelineCacheCreateFlags flags,
-        const std::vector<uint8_t>& initial_data
+        const GpuProfilerConfig& config
     )
     {
         try
         {
-            PipelineCachePtr cache =
-                std::make_shared<PipelineCache_public_ctor>(
-                    device,
-                    flags
+            if (config.frames_in_flight == 0
+                || config.max_regions_per_frame == 0)
+            {
+                throw Error(
+                    "frames_in_flight and max_regions_per_frame must be "
+                    "non-zero"
                 );
+            }
 
-            VkPipelineCacheCreateInfo create_info{
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = cache->flags(),
-                .initialDataSize = initial_data.size(),
-                .pInitialData = initial_data.data()
-            };
+            auto profiler = std::make_shared<GpuProfiler_public_ctor>(
+                device,
+                config
+            );
+
+            const auto& physical_device = device->physical_device();
+            uint32_t valid_bits = physical_device.queue_families()[
+                lock_wptr(config.queue)->queue_family_index()
+            ].timestamp_valid_bits;
+            if (valid_bits == 0)
+            {
+                throw Error("the queue family doesn't support timestamps");
+            }
+            profiler->timestamp_mask =
+                valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1;
+            profiler->ns_per_tick =
+                physical_device.properties().limits.timestamp_period;
+
+            uint32_t max_queries = 2 * config.max_regions_per_frame;
+            profiler->_query_pool = QueryPool::create(
+                device,
+                {
+                    .query_type = VK_QUERY_TYPE_TIMESTAMP,
+                    .query_count = config.frames_in_flight * max_queries
+                }
+            );
+
+            // reserve everything up front so that profiling a frame doesn't
+            // allocate (other than for long region names)
+            profiler->slots.resize(config.frames_in_flight);
+            for (auto& slot : profiler->slots)
+            {
+                slot.regions.reserve(config.max_regions_per_frame);
+            }
+            profiler->open_regions.reserve(config.max_regions_per_frame);
+            profiler->timestamps.resize(max_queries);
+            profiler->_results.reserve(config.max_regions_per_frame);
+
+            if (config.calibrate)
+            {
+                uint32_t n_domains = 0;
+                VkResult vk_result =
+                    GetPhysicalDeviceCalibrateableTimeDomainsEXT(
+                        physical_device.dispatch(),
+                        physical_device.handle(),
+                        &n_domains,
+                        nullptr
+                    );
+                if (vk_result != VK_SUCCESS)
+                {
+                    throw Error(vk_result);
+                }
+
+                std::vector<VkTimeDomainEXT> domains(n_domains);
+                vk_result = GetPhysicalDeviceCalibrateableTimeDomainsEXT(
+                    physical_device.dispatch(),
+                    physical_device.handle(),
+                    &n_domains,
+                    domains.data()
+                );
+                if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+                {
+                    throw Error(vk_result);
+                }
+
+                bool supports_device_domain = false;
+                bool supports_host_domain = false;
+                for (const auto& domain : domains)
+                {
+                    if (domain == VK_TIME_DOMAIN_DEVICE_EXT)
+                    {
+                        supports_device_domain = true;
+                    }
+                    else if (domain == HOST_TIME_DOMAIN)
+                    {
+                        supports_host_domain = true;
+                    }
+                }
+                if (!supports_device_domain || !supports_host_domain)
+                {
+                    throw Error(
+                        "the device can't calibrate its timestamps against "
+                        "the host clock"
+                    );
+                }
 
-            VkResult vk_result = vkCreatePipelineCache(
-                device->handle(),
-                &create_info,
-                lock_wptr(device->context())->vk_allocator_ptr(),
-                &cache->_handle
-            );
-            if (vk_result != VK_SUCCESS)
-            {
-                throw Error(vk_result);
+                profiler->calibrate();
             }
-            return cache;
+
+            return profiler;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to create pipeline cache: " + e.to_string(),
+                "failed to create GPU profiler: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::vector<uint8_t> PipelineCache::get_cache_data()
+    void GpuProfiler::calibrate()
     {
         try
         {
-            auto device_locked = lock_wptr(device());
-
-            size_t size;
-            vkGetPipelineCacheData(
-                device_locked->handle(),
-                handle(),
-                &size,
-                nullptr
-            );
+            std::array<VkCalibratedTimestampInfoEXT, 2> infos{
+                VkCalibratedTimestampInfoEXT{
+                    .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                    .pNext = nullptr,
+                    .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT
+                },
+                VkCalibratedTimestampInfoEXT{
+                    .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                    .pNext = nullptr,
+                    .timeDomain = HOST_TIME_DOMAIN
+                }
+            };
+            std::array<uint64_t, 2> timestamps;
+            uint64_t max_deviation;
 
-            std::vector<uint8_t> data(size);
-            VkResult vk_result = vkGetPipelineCacheData(
+            auto device_locked = lock_wptr(device());
+            VkResult vk_result = GetCalibratedTimestampsEXT(
+                device_locked->dispatch(),
                 device_locked->handle(),
-                handle(),
-                &size,
-                data.data()
+                (uint32_t)infos.size(),
+                infos.data(),
+                timestamps.data(),
+                &max_deviation
             );
-            if (vk_result != VK_SUCCESS && vk_result != VK_INCOMPLETE)
+            if (vk_result != VK_SUCCESS)
             {
                 throw Error(vk_result);
             }
 
-            return data;
+            calibration_ticks = timestamps[0];
+            calibration_host_ns = host_timestamp_to_ns(timestamps[1]);
+            calibrated = true;
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to get pipeline cache data: " + e.to_string(),
+                "failed to calibrate GPU profiler: " + e.to_string(),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    PipelineCache::~PipelineCache()
+    void GpuProfiler::begin_frame(const CommandBufferPtr& cmd_buf)
     {
-        _BV_LOCK_WPTR_OR_RETURN(device(), device_locked);
-        _BV_LOCK_WPTR_OR_RETURN(
-            device_locked->context(),
-            context_locked
-        );
-
-        vkDestroyPipelineCache(
-            device_locked->handle(),
-            handle(),
-            context_locked->vk_allocator_ptr()
-        );
-    }
-
-    PipelineCache::PipelineCache(
-        const DevicePtr& device,
-        VkPipelineCacheCreateFlags flags
-    )
-        : _device(device), _flags(flags)
-    {}
+        if (config().calibrate)
+        {
+            int64_t now_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()
+                ).count();
+            if (!calibrated
+                || now_ns - calibration_host_ns
+                >= (int64_t)config().calibration_interval_ms * 1'000'000)
+            {
+                calibrate();
+            }
+        }
 
-#pragma endregion
+        read_results();
 
-#pragma region helper functions
+        auto& slot = current_slot();
+        slot.frame_idx = frame_idx;
+        slot.regions.clear();
+        open_regions.clear();
 
-    std::string cstr_to_std(const char* cstr)
-    {
-        return (cstr == nullptr) ? std::string() : std::string(cstr);
+        cmd_buf->reset_query_pool(
+            _query_pool,
+            first_query(frame_idx),
+            2 * config().max_regions_per_frame
+        );
     }
 
-    bool format_has_depth_component(VkFormat format)
+    void GpuProfiler::begin_region(
+        const CommandBufferPtr& cmd_buf,
+        const std::string& name,
+        VkPipelineStageFlagBits stage
+    )
     {
-        return
-            format == VK_FORMAT_D16_UNORM
-            || format == VK_FORMAT_X8_D24_UNORM_PACK32
-            || format == VK_FORMAT_D32_SFLOAT
-            || format == VK_FORMAT_D16_UNORM_S8_UINT
-            || format == VK_FORMAT_D24_UNORM_S8_UINT
-            || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
-    }
+        auto& slot = current_slot();
+        if (slot.regions.size() >= config().max_regions_per_frame)
+        {
+            throw Error(
+                "failed to begin GPU profiler region: max_regions_per_frame "
+                "exceeded"
+            );
+        }
 
-    bool format_has_stencil_component(VkFormat format)
-    {
-        return
-            format == VK_FORMAT_S8_UINT
-            || format == VK_FORMAT_D16_UNORM_S8_UINT
-            || format == VK_FORMAT_D24_UNORM_S8_UINT
-            || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+        uint32_t region_idx = (uint32_t)slot.regions.size();
+        slot.regions.push_back(RegionInfo{
+            .name = name,
+            .depth = (uint32_t)open_regions.size()
+            });
+        open_regions.push_back(region_idx);
+
+        cmd_buf->write_timestamp(
+            stage,
+            _query_pool,
+            first_query(frame_idx) + 2 * region_idx
+        );
     }
 
-#pragma endregion
-
-#pragma region memory management
-
-    static uint32_t find_memory_type_idx(
-        const bv::PhysicalDevice& physical_device,
-        uint32_t supported_type_bits,
-        VkMemoryPropertyFlags required_properties,
-        VkDeviceSize required_size
+    void GpuProfiler::end_region(
+        const CommandBufferPtr& cmd_buf,
+        VkPipelineStageFlagBits stage
     )
     {
-        const auto& mem_props = physical_device.memory_properties();
-        for (uint32_t i = 0; i < mem_props.memory_types.size(); i++)
+        if (open_regions.empty())
         {
-            bool has_required_properties =
-                (required_properties & mem_props.memory_types[i].property_flags)
-                == required_properties;
-
-            if (!(supported_type_bits & (1 << i)) || !has_required_properties)
-            {
-                continue;
-            }
-
-            VkDeviceSize heap_size = mem_props.memory_heaps[
-                mem_props.memory_types[i].heap_index
-            ].size;
-            if (required_size > heap_size)
-            {
-                continue;
-            }
-
-            return i;
+            throw Error("failed to end GPU profiler region: no open regions");
         }
-        throw Error("failed to find a suitable memory type");
-    }
 
-    MemoryRegion::MemoryRegion(const bv::DeviceMemoryPtr& mem)
-        : mem(mem)
-    {}
+        uint32_t region_idx = open_regions.back();
+        open_regions.pop_back();
 
-    const bv::DeviceMemoryPtr& MemoryChunk::memory() const
-    {
-        return region->mem;
+        cmd_buf->write_timestamp(
+            stage,
+            _query_pool,
+            first_query(frame_idx) + 2 * region_idx + 1
+        );
     }
 
-    void MemoryChunk::bind(bv::BufferPtr& buffer)
+    void GpuProfiler::end_frame()
     {
-        buffer->bind_memory(memory(), offset());
+        frame_idx++;
     }
 
-    void MemoryChunk::bind(bv::ImagePtr& image)
-    {
-        image->bind_memory(memory(), offset());
-    }
+    GpuProfiler::GpuProfiler(
+        const DevicePtr& device,
+        const GpuProfilerConfig& config
+    )
+        : _device(device), _config(config)
+    {}
 
-    void* MemoryChunk::mapped()
+    void GpuProfiler::read_results()
     {
-        if (region->mapped == nullptr)
+        const auto& slot = current_slot();
+        if (slot.frame_idx == UINT64_MAX || slot.regions.empty())
         {
-            throw Error("failed to map memory chunk: unmappable memory");
+            return;
         }
-        return (void*)((uint8_t*)region->mapped + offset());
-    }
 
-    void MemoryChunk::flush()
-    {
-        if (region->mapped != nullptr)
+        // don't wait, if the results aren't there yet the frame is dropped
+        uint32_t n_queries = 2 * (uint32_t)slot.regions.size();
+        bool available = _query_pool->get_results(
+            first_query(slot.frame_idx),
+            n_queries,
+            std::span(timestamps.data(), n_queries)
+        );
+        if (!available)
         {
-            region->mem->flush_mapped_range(0, VK_WHOLE_SIZE);
+            _n_dropped_frames++;
+            return;
         }
-    }
 
-    MemoryChunk::~MemoryChunk()
-    {
-        std::scoped_lock lock(*mutex);
+        // regions recorded in different command buffers don't necessarily
+        // begin in order on the device
+        int64_t frame_begin = 0;
+        for (uint32_t i = 0; i < n_queries; i += 2)
+        {
+            frame_begin = std::min(
+                frame_begin,
+                timestamp_delta(timestamps[0], timestamps[i], timestamp_mask)
+            );
+        }
 
-        // set the block bits to free
-        uint64_t start_block_idx = offset() / block_size;
-        uint64_t end_block_idx = _BV_IDIV_CEIL(offset() + size(), block_size);
-        for (size_t i = start_block_idx; i < end_block_idx; i++)
+        auto ticks_to_ms = [this](int64_t ticks)
         {
-            region->blocks[i] = false;
+            return (double)ticks * ns_per_tick * 1e-6;
+        };
+        auto ticks_to_host_ns = [this](uint64_t timestamp)
+        {
+            int64_t ticks = timestamp_delta(
+                calibration_ticks,
+                timestamp,
+                timestamp_mask
+            );
+            return calibration_host_ns
+                + (int64_t)((double)ticks * ns_per_tick);
+        };
+
+        _results.resize(slot.regions.size());
+        for (size_t i = 0; i < slot.regions.size(); i++)
+        {
+            uint64_t begin = timestamps[2 * i];
+            uint64_t end = timestamps[2 * i + 1];
+
+            auto& result = _results[i];
+            result.name = slot.regions[i].name;
+            result.depth = slot.regions[i].depth;
+            result.begin_ms = ticks_to_ms(
+                timestamp_delta(timestamps[0], begin, timestamp_mask)
+                - frame_begin
+            );
+            result.end_ms = ticks_to_ms(
+                timestamp_delta(timestamps[0], end, timestamp_mask)
+                - frame_begin
+            );
+            result.host_begin_ns = calibrated ? ticks_to_host_ns(begin) : 0;
+            result.host_end_ns = calibrated ? ticks_to_host_ns(end) : 0;
         }
+        _results_frame_idx = slot.frame_idx;
     }
 
-    MemoryChunk::MemoryChunk(
-        const std::shared_ptr<std::mutex>& mutex,
-        const MemoryRegionPtr& region,
-        VkDeviceSize offset,
-        VkDeviceSize size,
-        VkDeviceSize block_size
-    )
-        : mutex(mutex),
-        region(region),
-        _offset(offset),
-        _size(size),
-        block_size(block_size)
-    {}
-
-    MemoryBankPtr MemoryBank::create(
-        const DevicePtr& device,
-        VkDeviceSize block_size,
-        VkDeviceSize min_region_size
+    GpuProfilerScope::GpuProfilerScope(
+        const GpuProfilerPtr& profiler,
+        const CommandBufferPtr& cmd_buf,
+        const std::string& name
     )
+        : profiler(profiler), cmd_buf(cmd_buf)
     {
-        return std::make_shared<MemoryBank_public_ctor>(
-            device,
-            block_size,
-            min_region_size
-        );
+        profiler->begin_region(cmd_buf, name);
     }
 
-    MemoryChunkPtr MemoryBank::allocate(
-        const bv::MemoryRequirements& requirements,
-        VkMemoryPropertyFlags required_properties
-    )
+    GpuProfilerScope::~GpuProfilerScope()
     {
         try
         {
-            std::scoped_lock lock(*mutex);
+            profiler->end_region(cmd_buf);
+        }
+        catch (const Error&)
+        {}
+    }
 
-            // make sure the chunk size is divisible by the block size
-            uint64_t chunk_size = requirements.size;
-            if (chunk_size % block_size() != 0)
-            {
-                chunk_size += block_size() - (chunk_size % block_size());
-            }
+#pragma endregion
 
-            uint64_t n_blocks_in_chunk =
-                _BV_IDIV_CEIL(chunk_size, block_size());
+#pragma region compute workgroup tuner
 
-            const auto& mem_props =
-                device()->physical_device().memory_properties();
+    // the results file starts with this header followed by n_entries
+    // entries of a result key (uint64_t) and a local size (3 uint32_t). the
+    // keys include the device, so results of several devices can share a
+    // file.
+    struct ComputeWorkgroupTunerResultsHeader
+    {
+        uint32_t magic;
+        uint32_t n_entries;
+    };
 
-            for (auto& region : regions)
-            {
-                // check if region is large enough
-                if (chunk_size > region->mem->config().allocation_size)
-                {
-                    continue;
-                }
+    static constexpr uint32_t COMPUTE_WORKGROUP_TUNER_RESULTS_MAGIC =
+        0x47574256; // "BVWG"
 
-                // check if region has a compatible memory type
-                if (!(
-                    requirements.memory_type_bits
-                    & (1 << region->mem->config().memory_type_index)
-                    ))
-                {
-                    continue;
-                }
+    static constexpr size_t COMPUTE_WORKGROUP_TUNER_RESULTS_ENTRY_SIZE =
+        sizeof(uint64_t) + 3 * sizeof(uint32_t);
 
-                // check if region's memory type has the required properties
-                uint32_t mem_type_idx = region->mem->config().memory_type_index;
-                bool has_required_properties =
-                    (required_properties
-                        & mem_props.memory_types[mem_type_idx].property_flags)
-                    == required_properties;
-                if (!has_required_properties)
-                {
-                    continue;
-                }
+    // whether a local size is within the device's compute workgroup limits
+    static bool workgroup_size_fits_limits(
+        const std::array<uint32_t, 3>& local_size,
+        const PhysicalDeviceLimits& limits
+    )
+    {
+        uint64_t n_invocations =
+            (uint64_t)local_size[0] * local_size[1] * local_size[2];
+        return n_invocations != 0
+            && n_invocations <= limits.max_compute_work_group_invocations
+            && local_size[0] <= limits.max_compute_work_group_size[0]
+            && local_size[1] <= limits.max_compute_work_group_size[1]
+            && local_size[2] <= limits.max_compute_work_group_size[2];
+    }
 
-                // try to find a free range and return a chunk if found
-                uint64_t start_block_idx = 0;
-                while (true)
-                {
-                    while (start_block_idx < region->blocks.size()
-                        && region->blocks[start_block_idx])
-                    {
-                        start_block_idx++;
-                    }
-                    if (start_block_idx >= region->blocks.size())
-                    {
-                        break;
-                    }
+    // the config's pipeline with the local size specialization constants
+    // replaced by local_size
+    static ComputePipelineConfig workgroup_tuner_pipeline_config(
+        const ComputeWorkgroupTunerConfig& config,
+        const std::array<uint32_t, 3>& local_size
+    )
+    {
+        SpecializationInfo specialization_info =
+            config.stage.specialization_info.value_or(SpecializationInfo{});
+        std::erase_if(
+            specialization_info.map_entries,
+            [&](const SpecializationMapEntry& entry)
+            {
+                return std::find(
+                    config.local_size_constant_ids.begin(),
+                    config.local_size_constant_ids.end(),
+                    entry.constant_id
+                ) != config.local_size_constant_ids.end();
+            }
+        );
+        for (size_t i = 0; i < 3; i++)
+        {
+            specialization_info.map_entries.push_back(SpecializationMapEntry{
+                .constant_id = config.local_size_constant_ids[i],
+                .offset = (uint32_t)specialization_info.data.size(),
+                .size = sizeof(uint32_t)
+            });
+            specialization_info.data.insert(
+                specialization_info.data.end(),
+                (const uint8_t*)&local_size[i],
+                (const uint8_t*)&local_size[i] + sizeof(uint32_t)
+            );
+        }
 
-                    uint64_t end_block_idx = start_block_idx + 1;
-                    while (end_block_idx < region->blocks.size()
-                        && !region->blocks[end_block_idx])
-                    {
-                        end_block_idx++;
-                    }
+        ShaderStage stage = config.stage;
+        stage.specialization_info = specialization_info;
+        return ComputePipelineConfig{
+            .flags = config.flags,
+            .stage = stage,
+            .layout = config.layout,
+            .base_pipeline = std::nullopt
+        };
+    }
 
-                    uint64_t n_free_blocks = end_block_idx - start_block_idx;
+    ComputeWorkgroupTunerPtr ComputeWorkgroupTuner::create(
+        const DevicePtr& device,
+        const std::string& results_path
+    )
+    {
+        ComputeWorkgroupTunerPtr tuner =
+            std::make_shared<ComputeWorkgroupTuner_public_ctor>(
+                device,
+                results_path
+            );
+        if (results_path.empty())
+        {
+            return tuner;
+        }
 
-                    // if we have found a free and usable block range
-                    if (n_free_blocks >= n_blocks_in_chunk)
-                    {
-                        // figure out the byte offset in the region
-                        VkDeviceSize offs = start_block_idx * block_size();
+        MappedFile file(results_path);
+        std::span<const uint8_t> data = file.data();
+        const auto& limits = device->physical_device().properties().limits;
 
-                        // adjust the offset if it doesn't meet the alignment
-                        // requirements
-                        if (offs % requirements.alignment != 0)
-                        {
-                            offs +=
-                                requirements.alignment
-                                - (offs % requirements.alignment);
-                        }
+        ComputeWorkgroupTunerResultsHeader header;
+        if (data.size() < sizeof(header))
+        {
+            return tuner;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (header.magic != COMPUTE_WORKGROUP_TUNER_RESULTS_MAGIC)
+        {
+            return tuner;
+        }
 
-                        // recalculate the start block index
-                        start_block_idx = offs / block_size();
+        // entries are read until the first one that's cut off
+        size_t offset = sizeof(header);
+        for (uint32_t i = 0; i < header.n_entries; i++)
+        {
+            if (data.size() - offset
+                < COMPUTE_WORKGROUP_TUNER_RESULTS_ENTRY_SIZE)
+            {
+                break;
+            }
+            uint64_t key;
+            std::array<uint32_t, 3> local_size;
+            std::memcpy(&key, data.data() + offset, sizeof(key));
+            offset += sizeof(key);
+            std::memcpy(
+                local_size.data(),
+                data.data() + offset,
+                sizeof(local_size)
+            );
+            offset += sizeof(local_size);
 
-                        // if the start block index is now stepping into the
-                        // end of the range, we'll restart the search.
-                        if (start_block_idx >= end_block_idx)
-                        {
-                            continue;
-                        }
+            // the file could be corrupted or edited by hand, and a local size
+            // out of the limits would fail pipeline creation in tune()
+            if (workgroup_size_fits_limits(local_size, limits))
+            {
+                tuner->results[key] = local_size;
+            }
+        }
+        return tuner;
+    }
 
-                        // recalculate the new number of free blocks
-                        n_free_blocks = end_block_idx - start_block_idx;
+    ComputeWorkgroupTunerResult ComputeWorkgroupTuner::tune(
+        const ComputeWorkgroupTunerConfig& config,
+        const QueuePtr& queue,
+        const CommandPoolPtr& cmd_pool,
+        const ComputeWorkgroupTunerRecordFn& record,
+        const PipelineCachePtr& cache
+    )
+    {
+        BV_TRACE_ZONE("bv::ComputeWorkgroupTuner::tune");
 
-                        // if the new number of free blocks is no longer large
-                        // enough, we'll restart the search.
-                        if (n_free_blocks < n_blocks_in_chunk)
-                        {
-                            start_block_idx = end_block_idx;
-                            continue;
-                        }
+        try
+        {
+            auto device_locked = lock_wptr(device());
+            const auto& physical_device = device_locked->physical_device();
+            const auto& limits = physical_device.properties().limits;
 
-                        // set the block bits to allocated
-                        for (size_t i = start_block_idx;
-                            i < start_block_idx + n_blocks_in_chunk;
-                            i++)
-                        {
-                            region->blocks[i] = true;
-                        }
+            uint64_t key = result_key(config);
+            auto it = results.find(key);
+            if (it != results.end())
+            {
+                return ComputeWorkgroupTunerResult{
+                    .local_size = it->second,
+                    .pipeline = ComputePipeline::create(
+                        device_locked,
+                        workgroup_tuner_pipeline_config(config, it->second),
+                        cache
+                    ),
+                    .measured = false,
+                    .time_ms = 0.
+                };
+            }
 
-                        // make a copy of the region pointer to avoid losing it
-                        // when we delete empty regions.
-                        bv::MemoryRegionPtr region_ptr_copy = region;
+            if (config.n_timed_runs == 0)
+            {
+                throw Error("n_timed_runs must be non-zero");
+            }
 
-                        // delete empty regions
-                        delete_empty_regions();
+            uint32_t valid_bits = physical_device.queue_families()[
+                queue->queue_family_index()
+            ].timestamp_valid_bits;
+            if (valid_bits == 0)
+            {
+                throw Error("the queue family doesn't support timestamps");
+            }
+            uint64_t timestamp_mask =
+                valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1;
 
-                        // return a new chunk based on the region
-                        return std::make_shared<MemoryChunk_public_ctor>(
-                            mutex,
-                            region_ptr_copy,
-                            offs,
-                            chunk_size,
-                            block_size()
-                        );
+            std::vector<std::array<uint32_t, 3>> candidates;
+            for (uint32_t x : config.candidates_x)
+            {
+                for (uint32_t y : config.candidates_y)
+                {
+                    for (uint32_t z : config.candidates_z)
+                    {
+                        if ((uint64_t)x * y * z < config.min_invocations
+                            || !workgroup_size_fits_limits({ x, y, z }, limits))
+                        {
+                            continue;
+                        }
+                        candidates.push_back({ x, y, z });
                     }
-
-                    // continue the search
-                    start_block_idx = end_block_idx;
                 }
             }
-
-            // couldn't find a usable range in any of the regions, so we'll
-            // create a new region and use it instead.
-
-            // figure out the allocation size and make sure it's divisible by
-            // the block size.
-            VkDeviceSize region_size = std::max(chunk_size, min_region_size());
-            if (region_size % block_size() != 0)
+            if (candidates.empty())
             {
-                region_size += block_size() - (region_size % block_size());
+                throw Error("none of the candidates fit the device's limits");
             }
 
-            // find suitable memory type index
-            uint32_t memory_type_idx = find_memory_type_idx(
-                device()->physical_device(),
-                requirements.memory_type_bits,
-                required_properties,
-                region_size
-            );
+            std::vector<ComputePipelineConfig> pipeline_configs;
+            pipeline_configs.reserve(candidates.size());
+            for (const auto& local_size : candidates)
+            {
+                pipeline_configs.push_back(
+                    workgroup_tuner_pipeline_config(config, local_size)
+                );
+            }
+            std::vector<ComputePipelinePtr> pipelines =
+                ComputePipeline::create_multiple(
+                    device_locked,
+                    pipeline_configs,
+                    cache
+                );
 
-            // allocate memory
-            auto mem = bv::DeviceMemory::allocate(
-                device(),
+            uint32_t n_runs = config.n_warmup_runs + config.n_timed_runs;
+            uint32_t n_queries = 2 * n_runs * (uint32_t)candidates.size();
+            QueryPoolPtr query_pool = QueryPool::create(
+                device_locked,
                 {
-                    .allocation_size = region_size,
-                    .memory_type_index = memory_type_idx
+                    .query_type = VK_QUERY_TYPE_TIMESTAMP,
+                    .query_count = n_queries
                 }
             );
 
-            // create a region based on that memory
-            auto new_region = std::make_shared<MemoryRegion_public_ctor>(mem);
-
-            // setup the block bitset for the region
-            new_region->blocks.resize(
-                _BV_IDIV_CEIL(region_size, block_size()),
-                false
+            CommandBufferPtr cmd_buf = CommandPool::allocate_buffer(
+                cmd_pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY
             );
-            for (size_t i = 0; i < n_blocks_in_chunk; i++)
-            {
-                new_region->blocks[i] = true;
-            }
+            cmd_buf->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            cmd_buf->reset_query_pool(query_pool, 0, n_queries);
 
-            // map the memory if it's mappable
-            bool is_mappable =
-                (required_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
-                || (required_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-            if (is_mappable)
+            uint32_t query = 0;
+            for (size_t i = 0; i < candidates.size(); i++)
             {
-                new_region->mapped = mem->map(0, VK_WHOLE_SIZE);
+                for (uint32_t run = 0; run < n_runs; run++)
+                {
+                    // runs must not overlap, and a bottom of pipe timestamp
+                    // is only written once all previous commands are done,
+                    // so the two timestamps enclose exactly this run. the
+                    // runs usually write the same buffers, so the previous
+                    // run's writes are also made visible to this one.
+                    VkMemoryBarrier between_runs{
+                        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                        .pNext = nullptr,
+                        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+
+                        .dstAccessMask =
+                        VK_ACCESS_SHADER_READ_BIT
+                        | VK_ACCESS_SHADER_WRITE_BIT
+                    };
+                    cmd_buf->dispatch().vkCmdPipelineBarrier(
+                        cmd_buf->handle(),
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                        0,
+                        1,
+                        &between_runs,
+                        0,
+                        nullptr,
+                        0,
+                        nullptr
+                    );
+                    cmd_buf->write_timestamp(
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        query_pool,
+                        query++
+                    );
+                    cmd_buf->dispatch().vkCmdBindPipeline(
+                        cmd_buf->handle(),
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        pipelines[i]->handle()
+                    );
+                    record(cmd_buf, pipelines[i], candidates[i]);
+                    cmd_buf->write_timestamp(
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        query_pool,
+                        query++
+                    );
+                }
             }
+            cmd_buf->end();
 
-            // delete empty regions
-            delete_empty_regions();
-
-            // add the region to our regions vector
-            regions.push_back(new_region);
+            FencePtr fence = Fence::create(device_locked, 0);
+            queue->submit({}, {}, { cmd_buf }, {}, fence);
+            fence->wait();
 
-            // return a new chunk based on the region
-            return std::make_shared<MemoryChunk_public_ctor>(
-                mutex,
-                new_region,
+            std::vector<uint64_t> timestamps(n_queries);
+            query_pool->get_results(
                 0,
-                chunk_size,
-                block_size()
+                n_queries,
+                timestamps,
+                VK_QUERY_RESULT_WAIT_BIT
             );
+
+            size_t best_idx = 0;
+            double best_time_ms = std::numeric_limits<double>::infinity();
+            std::vector<double> times_ms(config.n_timed_runs);
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                for (uint32_t run = 0; run < config.n_timed_runs; run++)
+                {
+                    size_t begin_query =
+                        2 * (i * n_runs + config.n_warmup_runs + run);
+                    int64_t ticks = timestamp_delta(
+                        timestamps[begin_query],
+                        timestamps[begin_query + 1],
+                        timestamp_mask
+                    );
+                    times_ms[run] =
+                        (double)ticks
+                        * (double)limits.timestamp_period
+                        / 1'000'000.;
+                }
+
+                auto median = times_ms.begin() + times_ms.size() / 2;
+                std::nth_element(times_ms.begin(), median, times_ms.end());
+                if (*median < best_time_ms)
+                {
+                    best_idx = i;
+                    best_time_ms = *median;
+                }
+            }
+
+            results[key] = candidates[best_idx];
+            return ComputeWorkgroupTunerResult{
+                .local_size = candidates[best_idx],
+                .pipeline = pipelines[best_idx],
+                .measured = true,
+                .time_ms = best_time_ms
+            };
         }
         catch (const Error& e)
         {
             throw Error(
-                "failed to allocate chunk from memory bank: " + e.to_string(),
+                std::format(
+                    "failed to tune the workgroup size of \"{}\": {}",
+                    config.name,
+                    e.to_string()
+                ),
                 e.vk_result(),
                 true
             );
         }
     }
 
-    std::string MemoryBank::to_string()
+    void ComputeWorkgroupTuner::forget(
+        const ComputeWorkgroupTunerConfig& config
+    )
     {
-        std::scoped_lock lock(*mutex);
+        results.erase(result_key(config));
+    }
 
-        std::string s = std::format(
-            "-----------------------------------------\n"
-            "memory bank status\n"
-            "  n. regions: {}\n"
-            "  block size: {}\n",
-            regions.size(),
-            block_size()
-        );
-        for (size_t i = 0; i < regions.size(); i++)
+    void ComputeWorkgroupTuner::save()
+    {
+        BV_TRACE_ZONE("bv::ComputeWorkgroupTuner::save");
+
+        if (results_path.empty())
         {
-            const auto& region = regions[i];
-            s += std::format(
-                "-----------------------------------------\n"
-                "region {}\n"
-                "  size: {}\n"
-                "  mapped: {}\n"
-                "  blocks: {} blocks allocated out of {}\n",
-                i,
-                region->mem->config().allocation_size,
-                region->mapped != nullptr,
-                region->blocks.count(),
-                region->blocks.size()
-            );
+            return;
         }
-        s += "-----------------------------------------\n";
-        return s;
-    }
 
-    MemoryBank::~MemoryBank()
-    {
-        std::scoped_lock lock(*mutex);
+        try
+        {
+            ComputeWorkgroupTunerResultsHeader header{
+                .magic = COMPUTE_WORKGROUP_TUNER_RESULTS_MAGIC,
+                .n_entries = (uint32_t)results.size()
+            };
+
+            std::vector<uint8_t> data(sizeof(header));
+            data.reserve(
+                sizeof(header)
+                + results.size() * COMPUTE_WORKGROUP_TUNER_RESULTS_ENTRY_SIZE
+            );
+            std::memcpy(data.data(), &header, sizeof(header));
+            for (const auto& [key, local_size] : results)
+            {
+                data.insert(
+                    data.end(),
+                    (const uint8_t*)&key,
+                    (const uint8_t*)&key + sizeof(key)
+                );
+                data.insert(
+                    data.end(),
+                    (const uint8_t*)local_size.data(),
+                    (const uint8_t*)local_size.data() + sizeof(local_size)
+                );
+            }
+            write_file_atomically(results_path, data);
+        }
+        catch (const Error& e)
+        {
+            throw Error(
+                "failed to save workgroup tuner results: " + e.to_string(),
+                e.vk_result(),
+                true
+            );
+        }
     }
 
-    MemoryBank::MemoryBank(
-        const bv::DevicePtr& device,
-        VkDeviceSize block_size,
-        VkDeviceSize min_region_size
+    ComputeWorkgroupTuner::ComputeWorkgroupTuner(
+        const DevicePtr& device,
+        const std::string& results_path
     )
         : _device(device),
-        mutex(std::make_shared<std::mutex>()),
-        _block_size(block_size),
-        _min_region_size(min_region_size)
+        results_path(results_path)
     {}
 
-    void MemoryBank::delete_empty_regions()
+    uint64_t ComputeWorkgroupTuner::result_key(
+        const ComputeWorkgroupTunerConfig& config
+    )
     {
-        for (size_t i = 0; i < regions.size();)
+        auto device_locked = lock_wptr(device());
+        const auto& physical_device = device_locked->physical_device();
+
+        uint64_t hash = 0;
+        const auto& vulkan11_properties =
+            physical_device.vulkan11_properties();
+        if (vulkan11_properties.has_value())
         {
-            if (regions[i]->blocks.none())
-            {
-                regions.erase(regions.begin() + i);
-            }
-            else
-            {
-                i++;
-            }
+            hash = fnv1a_hash(vulkan11_properties->device_uuid);
+        }
+        else
+        {
+            const auto& properties = physical_device.properties();
+            const uint32_t ids[]{ properties.vendor_id, properties.device_id };
+            hash = fnv1a_hash(std::span<const uint8_t>(
+                (const uint8_t*)ids,
+                sizeof(ids)
+            ));
         }
 
+        uint64_t code_hash = lock_wptr(config.stage.module)->code_hash();
+        hash = fnv1a_hash(
+            std::span<const uint8_t>(
+                (const uint8_t*)&code_hash,
+                sizeof(code_hash)
+            ),
+            hash
+        );
+        if (config.stage.specialization_info.has_value())
+        {
+            hash = fnv1a_hash(config.stage.specialization_info->data, hash);
+        }
+        return fnv1a_hash(
+            std::span<const uint8_t>(
+                (const uint8_t*)config.name.data(),
+                config.name.size()
+            ),
+            hash
+        );
     }
 
 #pragma endregion
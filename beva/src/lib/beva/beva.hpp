@@ -5,15 +5,25 @@
 #include <format>
 #include <array>
 #include <unordered_map>
+#include <map>
+#include <tuple>
 #include <memory>
 #include <any>
 #include <optional>
+#include <deque>
 #include <limits>
 #include <type_traits>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <stdexcept>
 #include <cstdint>
+#include <span>
+#include <bit>
+#include <source_location>
 
 #include "vulkan/vulkan.h"
 #include "vulkan/vk_enum_string_helper.h"
@@ -3834,19 +3844,33 @@ namespace bv
     class GraphicsPipeline;
     class ComputePipeline;
     class Framebuffer;
+    class FramebufferCache;
     class CommandBuffer;
     class CommandPool;
     class Semaphore;
+    class TimelineSemaphore;
     class Fence;
+    class FramePacer;
     class Buffer;
     class DeviceMemory;
     class DescriptorSet;
     class DescriptorPool;
     class BufferView;
     class PipelineCache;
+    class PipelineCompiler;
+    class PipelineRegistry;
+    class PipelineLibraryLinker;
+    class ShaderModuleRegistry;
+    class GlslCompiler;
     class MemoryRegion;
     class MemoryChunk;
     class MemoryBank;
+    class RenderGraph;
+    class UploadEngine;
+    class ReadbackEngine;
+    class QueryPool;
+    class GpuProfiler;
+    class ComputeWorkgroupTuner;
 
     // smart pointer type aliases
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(Allocator);
@@ -3866,19 +3890,33 @@ namespace bv
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(GraphicsPipeline);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(ComputePipeline);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(Framebuffer);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(FramebufferCache);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(CommandBuffer);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(CommandPool);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(Semaphore);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(TimelineSemaphore);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(Fence);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(FramePacer);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(Buffer);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(DeviceMemory);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(DescriptorSet);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(DescriptorPool);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(BufferView);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(PipelineCache);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(PipelineCompiler);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(PipelineRegistry);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(PipelineLibraryLinker);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(ShaderModuleRegistry);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(GlslCompiler);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(MemoryRegion);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(MemoryChunk);
     _BV_DEFINE_SMART_PTR_TYPE_ALIASES(MemoryBank);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(RenderGraph);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(UploadEngine);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(ReadbackEngine);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(QueryPool);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(GpuProfiler);
+    _BV_DEFINE_SMART_PTR_TYPE_ALIASES(ComputeWorkgroupTuner);
 
 #pragma region data-only structs and enums
 
@@ -4414,6 +4452,301 @@ namespace bv
         const PhysicalDeviceFeatures& features
     );
 
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan11Features.html
+    struct PhysicalDeviceVulkan11Features
+    {
+        bool storage_buffer_16bit_access : 1 = false;
+        bool uniform_and_storage_buffer_16bit_access : 1 = false;
+        bool storage_push_constant16 : 1 = false;
+        bool storage_input_output16 : 1 = false;
+        bool multiview : 1 = false;
+        bool multiview_geometry_shader : 1 = false;
+        bool multiview_tessellation_shader : 1 = false;
+        bool variable_pointers_storage_buffer : 1 = false;
+        bool variable_pointers : 1 = false;
+        bool protected_memory : 1 = false;
+        bool sampler_ycbcr_conversion : 1 = false;
+        bool shader_draw_parameters : 1 = false;
+    };
+
+    PhysicalDeviceVulkan11Features PhysicalDeviceVulkan11Features_from_vk(
+        const VkPhysicalDeviceVulkan11Features& vk_features
+    );
+
+    // pNext is left as nullptr
+    VkPhysicalDeviceVulkan11Features PhysicalDeviceVulkan11Features_to_vk(
+        const PhysicalDeviceVulkan11Features& features
+    );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan12Features.html
+    struct PhysicalDeviceVulkan12Features
+    {
+        bool sampler_mirror_clamp_to_edge : 1 = false;
+        bool draw_indirect_count : 1 = false;
+        bool storage_buffer_8bit_access : 1 = false;
+        bool uniform_and_storage_buffer_8bit_access : 1 = false;
+        bool storage_push_constant8 : 1 = false;
+        bool shader_buffer_int64_atomics : 1 = false;
+        bool shader_shared_int64_atomics : 1 = false;
+        bool shader_float16 : 1 = false;
+        bool shader_int8 : 1 = false;
+        bool descriptor_indexing : 1 = false;
+        bool shader_input_attachment_array_dynamic_indexing : 1 = false;
+        bool shader_uniform_texel_buffer_array_dynamic_indexing : 1 = false;
+        bool shader_storage_texel_buffer_array_dynamic_indexing : 1 = false;
+        bool shader_uniform_buffer_array_non_uniform_indexing : 1 = false;
+        bool shader_sampled_image_array_non_uniform_indexing : 1 = false;
+        bool shader_storage_buffer_array_non_uniform_indexing : 1 = false;
+        bool shader_storage_image_array_non_uniform_indexing : 1 = false;
+        bool shader_input_attachment_array_non_uniform_indexing : 1 = false;
+        bool shader_uniform_texel_buffer_array_non_uniform_indexing : 1 = false;
+        bool shader_storage_texel_buffer_array_non_uniform_indexing : 1 = false;
+        bool descriptor_binding_uniform_buffer_update_after_bind : 1 = false;
+        bool descriptor_binding_sampled_image_update_after_bind : 1 = false;
+        bool descriptor_binding_storage_image_update_after_bind : 1 = false;
+        bool descriptor_binding_storage_buffer_update_after_bind : 1 = false;
+        bool descriptor_binding_uniform_texel_buffer_update_after_bind : 1 = false;
+        bool descriptor_binding_storage_texel_buffer_update_after_bind : 1 = false;
+        bool descriptor_binding_update_unused_while_pending : 1 = false;
+        bool descriptor_binding_partially_bound : 1 = false;
+        bool descriptor_binding_variable_descriptor_count : 1 = false;
+        bool runtime_descriptor_array : 1 = false;
+        bool sampler_filter_minmax : 1 = false;
+        bool scalar_block_layout : 1 = false;
+        bool imageless_framebuffer : 1 = false;
+        bool uniform_buffer_standard_layout : 1 = false;
+        bool shader_subgroup_extended_types : 1 = false;
+        bool separate_depth_stencil_layouts : 1 = false;
+        bool host_query_reset : 1 = false;
+        bool timeline_semaphore : 1 = false;
+        bool buffer_device_address : 1 = false;
+        bool buffer_device_address_capture_replay : 1 = false;
+        bool buffer_device_address_multi_device : 1 = false;
+        bool vulkan_memory_model : 1 = false;
+        bool vulkan_memory_model_device_scope : 1 = false;
+        bool vulkan_memory_model_availability_visibility_chains : 1 = false;
+        bool shader_output_viewport_index : 1 = false;
+        bool shader_output_layer : 1 = false;
+        bool subgroup_broadcast_dynamic_id : 1 = false;
+    };
+
+    PhysicalDeviceVulkan12Features PhysicalDeviceVulkan12Features_from_vk(
+        const VkPhysicalDeviceVulkan12Features& vk_features
+    );
+
+    // pNext is left as nullptr
+    VkPhysicalDeviceVulkan12Features PhysicalDeviceVulkan12Features_to_vk(
+        const PhysicalDeviceVulkan12Features& features
+    );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan13Features.html
+    struct PhysicalDeviceVulkan13Features
+    {
+        bool robust_image_access : 1 = false;
+        bool inline_uniform_block : 1 = false;
+        bool descriptor_binding_inline_uniform_block_update_after_bind : 1 = false;
+        bool pipeline_creation_cache_control : 1 = false;
+        bool private_data : 1 = false;
+        bool shader_demote_to_helper_invocation : 1 = false;
+        bool shader_terminate_invocation : 1 = false;
+        bool subgroup_size_control : 1 = false;
+        bool compute_full_subgroups : 1 = false;
+        bool synchronization2 : 1 = false;
+        bool texture_compression_astc_hdr : 1 = false;
+        bool shader_zero_initialize_workgroup_memory : 1 = false;
+        bool dynamic_rendering : 1 = false;
+        bool shader_integer_dot_product : 1 = false;
+        bool maintenance4 : 1 = false;
+    };
+
+    PhysicalDeviceVulkan13Features PhysicalDeviceVulkan13Features_from_vk(
+        const VkPhysicalDeviceVulkan13Features& vk_features
+    );
+
+    // pNext is left as nullptr
+    VkPhysicalDeviceVulkan13Features PhysicalDeviceVulkan13Features_to_vk(
+        const PhysicalDeviceVulkan13Features& features
+    );
+
+    // provided by VK_EXT_extended_dynamic_state2. the base feature is core in
+    // Vulkan 1.3, the other two are not.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceExtendedDynamicState2FeaturesEXT.html
+    struct PhysicalDeviceExtendedDynamicState2Features
+    {
+        bool extended_dynamic_state2 : 1 = false;
+        bool extended_dynamic_state2_logic_op : 1 = false;
+        bool extended_dynamic_state2_patch_control_points : 1 = false;
+    };
+
+    // pNext is left as nullptr
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT
+        PhysicalDeviceExtendedDynamicState2Features_to_vk(
+            const PhysicalDeviceExtendedDynamicState2Features& features
+        );
+
+    // provided by VK_EXT_extended_dynamic_state3. only the features whose
+    // commands are wrapped by CommandBuffer are listed here, the rest are
+    // left disabled.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceExtendedDynamicState3FeaturesEXT.html
+    struct PhysicalDeviceExtendedDynamicState3Features
+    {
+        bool depth_clamp_enable : 1 = false;
+        bool polygon_mode : 1 = false;
+        bool rasterization_samples : 1 = false;
+        bool sample_mask : 1 = false;
+        bool alpha_to_coverage_enable : 1 = false;
+        bool alpha_to_one_enable : 1 = false;
+        bool logic_op_enable : 1 = false;
+        bool color_blend_enable : 1 = false;
+        bool color_blend_equation : 1 = false;
+        bool color_write_mask : 1 = false;
+    };
+
+    // pNext is left as nullptr
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT
+        PhysicalDeviceExtendedDynamicState3Features_to_vk(
+            const PhysicalDeviceExtendedDynamicState3Features& features
+        );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan11Properties.html
+    struct PhysicalDeviceVulkan11Properties
+    {
+        std::array<uint8_t, VK_UUID_SIZE> device_uuid;
+        std::array<uint8_t, VK_UUID_SIZE> driver_uuid;
+        std::array<uint8_t, VK_LUID_SIZE> device_luid;
+        uint32_t device_node_mask;
+        bool device_luid_valid;
+        uint32_t subgroup_size;
+        VkShaderStageFlags subgroup_supported_stages;
+        VkSubgroupFeatureFlags subgroup_supported_operations;
+        bool subgroup_quad_operations_in_all_stages;
+        VkPointClippingBehavior point_clipping_behavior;
+        uint32_t max_multiview_view_count;
+        uint32_t max_multiview_instance_index;
+        bool protected_no_fault;
+        uint32_t max_per_set_descriptors;
+        VkDeviceSize max_memory_allocation_size;
+    };
+
+    PhysicalDeviceVulkan11Properties PhysicalDeviceVulkan11Properties_from_vk(
+        const VkPhysicalDeviceVulkan11Properties& vk_properties
+    );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan12Properties.html
+    struct PhysicalDeviceVulkan12Properties
+    {
+        VkDriverId driver_id;
+        std::string driver_name;
+        std::string driver_info;
+        VkConformanceVersion conformance_version;
+        VkShaderFloatControlsIndependence denorm_behavior_independence;
+        VkShaderFloatControlsIndependence rounding_mode_independence;
+        bool shader_signed_zero_inf_nan_preserve_float16;
+        bool shader_signed_zero_inf_nan_preserve_float32;
+        bool shader_signed_zero_inf_nan_preserve_float64;
+        bool shader_denorm_preserve_float16;
+        bool shader_denorm_preserve_float32;
+        bool shader_denorm_preserve_float64;
+        bool shader_denorm_flush_to_zero_float16;
+        bool shader_denorm_flush_to_zero_float32;
+        bool shader_denorm_flush_to_zero_float64;
+        bool shader_rounding_mode_rte_float16;
+        bool shader_rounding_mode_rte_float32;
+        bool shader_rounding_mode_rte_float64;
+        bool shader_rounding_mode_rtz_float16;
+        bool shader_rounding_mode_rtz_float32;
+        bool shader_rounding_mode_rtz_float64;
+        uint32_t max_update_after_bind_descriptors_in_all_pools;
+        bool shader_uniform_buffer_array_non_uniform_indexing_native;
+        bool shader_sampled_image_array_non_uniform_indexing_native;
+        bool shader_storage_buffer_array_non_uniform_indexing_native;
+        bool shader_storage_image_array_non_uniform_indexing_native;
+        bool shader_input_attachment_array_non_uniform_indexing_native;
+        bool robust_buffer_access_update_after_bind;
+        bool quad_divergent_implicit_lod;
+        uint32_t max_per_stage_descriptor_update_after_bind_samplers;
+        uint32_t max_per_stage_descriptor_update_after_bind_uniform_buffers;
+        uint32_t max_per_stage_descriptor_update_after_bind_storage_buffers;
+        uint32_t max_per_stage_descriptor_update_after_bind_sampled_images;
+        uint32_t max_per_stage_descriptor_update_after_bind_storage_images;
+        uint32_t max_per_stage_descriptor_update_after_bind_input_attachments;
+        uint32_t max_per_stage_update_after_bind_resources;
+        uint32_t max_descriptor_set_update_after_bind_samplers;
+        uint32_t max_descriptor_set_update_after_bind_uniform_buffers;
+        uint32_t max_descriptor_set_update_after_bind_uniform_buffers_dynamic;
+        uint32_t max_descriptor_set_update_after_bind_storage_buffers;
+        uint32_t max_descriptor_set_update_after_bind_storage_buffers_dynamic;
+        uint32_t max_descriptor_set_update_after_bind_sampled_images;
+        uint32_t max_descriptor_set_update_after_bind_storage_images;
+        uint32_t max_descriptor_set_update_after_bind_input_attachments;
+        VkResolveModeFlags supported_depth_resolve_modes;
+        VkResolveModeFlags supported_stencil_resolve_modes;
+        bool independent_resolve_none;
+        bool independent_resolve;
+        bool filter_minmax_single_component_formats;
+        bool filter_minmax_image_component_mapping;
+        uint64_t max_timeline_semaphore_value_difference;
+        VkSampleCountFlags framebuffer_integer_color_sample_counts;
+    };
+
+    PhysicalDeviceVulkan12Properties PhysicalDeviceVulkan12Properties_from_vk(
+        const VkPhysicalDeviceVulkan12Properties& vk_properties
+    );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan13Properties.html
+    struct PhysicalDeviceVulkan13Properties
+    {
+        uint32_t min_subgroup_size;
+        uint32_t max_subgroup_size;
+        uint32_t max_compute_workgroup_subgroups;
+        VkShaderStageFlags required_subgroup_size_stages;
+        uint32_t max_inline_uniform_block_size;
+        uint32_t max_per_stage_descriptor_inline_uniform_blocks;
+        uint32_t max_per_stage_descriptor_update_after_bind_inline_uniform_blocks;
+        uint32_t max_descriptor_set_inline_uniform_blocks;
+        uint32_t max_descriptor_set_update_after_bind_inline_uniform_blocks;
+        uint32_t max_inline_uniform_total_size;
+        bool integer_dot_product_8bit_unsigned_accelerated;
+        bool integer_dot_product_8bit_signed_accelerated;
+        bool integer_dot_product_8bit_mixed_signedness_accelerated;
+        bool integer_dot_product_4x8bit_packed_unsigned_accelerated;
+        bool integer_dot_product_4x8bit_packed_signed_accelerated;
+        bool integer_dot_product_4x8bit_packed_mixed_signedness_accelerated;
+        bool integer_dot_product_16bit_unsigned_accelerated;
+        bool integer_dot_product_16bit_signed_accelerated;
+        bool integer_dot_product_16bit_mixed_signedness_accelerated;
+        bool integer_dot_product_32bit_unsigned_accelerated;
+        bool integer_dot_product_32bit_signed_accelerated;
+        bool integer_dot_product_32bit_mixed_signedness_accelerated;
+        bool integer_dot_product_64bit_unsigned_accelerated;
+        bool integer_dot_product_64bit_signed_accelerated;
+        bool integer_dot_product_64bit_mixed_signedness_accelerated;
+        bool integer_dot_product_accumulating_saturating_8bit_unsigned_accelerated;
+        bool integer_dot_product_accumulating_saturating_8bit_signed_accelerated;
+        bool integer_dot_product_accumulating_saturating_8bit_mixed_signedness_accelerated;
+        bool integer_dot_product_accumulating_saturating_4x8bit_packed_unsigned_accelerated;
+        bool integer_dot_product_accumulating_saturating_4x8bit_packed_signed_accelerated;
+        bool integer_dot_product_accumulating_saturating_4x8bit_packed_mixed_signedness_accelerated;
+        bool integer_dot_product_accumulating_saturating_16bit_unsigned_accelerated;
+        bool integer_dot_product_accumulating_saturating_16bit_signed_accelerated;
+        bool integer_dot_product_accumulating_saturating_16bit_mixed_signedness_accelerated;
+        bool integer_dot_product_accumulating_saturating_32bit_unsigned_accelerated;
+        bool integer_dot_product_accumulating_saturating_32bit_signed_accelerated;
+        bool integer_dot_product_accumulating_saturating_32bit_mixed_signedness_accelerated;
+        bool integer_dot_product_accumulating_saturating_64bit_unsigned_accelerated;
+        bool integer_dot_product_accumulating_saturating_64bit_signed_accelerated;
+        bool integer_dot_product_accumulating_saturating_64bit_mixed_signedness_accelerated;
+        VkDeviceSize storage_texel_buffer_offset_alignment_bytes;
+        bool storage_texel_buffer_offset_single_texel_alignment;
+        VkDeviceSize uniform_texel_buffer_offset_alignment_bytes;
+        bool uniform_texel_buffer_offset_single_texel_alignment;
+        VkDeviceSize max_buffer_size;
+    };
+
+    PhysicalDeviceVulkan13Properties PhysicalDeviceVulkan13Properties_from_vk(
+        const VkPhysicalDeviceVulkan13Properties& vk_properties
+    );
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkExtent3D.html
     struct Extent3d
     {
@@ -4579,6 +4912,77 @@ namespace bv
         std::vector<QueueRequest> queue_requests;
         std::vector<std::string> extensions;
         PhysicalDeviceFeatures enabled_features;
+
+        // Vulkan 1.1, 1.2, and 1.3 features to enable. these need both the
+        // physical device and ContextConfig::vulkan_api_version to support
+        // the matching API version, otherwise Device::create() throws.
+        // VkPhysicalDeviceVulkan11Features only exists since Vulkan 1.2, so
+        // if the lower of the two versions is 1.1, the 1.1 features are
+        // enabled through the structs of the extensions that were promoted
+        // to 1.1 instead (16-bit storage, multiview, and so on). check the
+        // physical device's vulkan1x_features() to see which features are
+        // available.
+        std::optional<PhysicalDeviceVulkan11Features> enabled_vulkan11_features;
+        std::optional<PhysicalDeviceVulkan12Features> enabled_vulkan12_features;
+        std::optional<PhysicalDeviceVulkan13Features> enabled_vulkan13_features;
+
+        // enable the synchronization2 feature (VK_KHR_synchronization2 or
+        // Vulkan 1.3) which is needed for Queue::submit2() and
+        // CommandBuffer::pipeline_barrier2()
+        bool enable_synchronization2 = false;
+
+        // enable the timelineSemaphore feature (VK_KHR_timeline_semaphore or
+        // Vulkan 1.2) which is needed for TimelineSemaphore
+        bool enable_timeline_semaphore = false;
+
+        // enable the dynamicRendering feature (VK_KHR_dynamic_rendering or
+        // Vulkan 1.3) which is needed for CommandBuffer::begin_rendering()
+        // and GraphicsPipelineConfig::rendering_formats
+        bool enable_dynamic_rendering = false;
+
+        // enable the imagelessFramebuffer feature
+        // (VK_KHR_imageless_framebuffer or Vulkan 1.2) which is needed for
+        // FramebufferConfig::attachment_image_infos
+        bool enable_imageless_framebuffer = false;
+
+        // extended dynamic state lets a single pipeline be used with many
+        // values of state that would otherwise be baked into it, so fewer
+        // pipeline permutations need to be compiled. the matching extensions
+        // must be listed in extensions. on Vulkan 1.3 devices the
+        // VK_EXT_extended_dynamic_state commands and the base
+        // VK_EXT_extended_dynamic_state2 commands are core and need neither
+        // the extensions nor these features.
+
+        // enable the extendedDynamicState feature
+        // (VK_EXT_extended_dynamic_state)
+        bool enable_extended_dynamic_state = false;
+
+        // VK_EXT_extended_dynamic_state2 features to enable
+        std::optional<PhysicalDeviceExtendedDynamicState2Features>
+            enabled_extended_dynamic_state2_features;
+
+        // VK_EXT_extended_dynamic_state3 features to enable
+        std::optional<PhysicalDeviceExtendedDynamicState3Features>
+            enabled_extended_dynamic_state3_features;
+
+        // enable the vertexInputDynamicState feature
+        // (VK_EXT_vertex_input_dynamic_state) which is needed for
+        // CommandBuffer::set_vertex_input()
+        bool enable_vertex_input_dynamic_state = false;
+
+        // enable the shaderModuleIdentifier feature
+        // (VK_EXT_shader_module_identifier) along with the
+        // pipelineCreationCacheControl feature it relies on
+        // (VK_EXT_pipeline_creation_cache_control or Vulkan 1.3). this lets
+        // ShaderModuleRegistry skip creating shader modules for pipelines
+        // that are in the pipeline cache.
+        bool enable_shader_module_identifier = false;
+
+        // enable the graphicsPipelineLibrary feature
+        // (VK_EXT_graphics_pipeline_library, which also needs
+        // VK_KHR_pipeline_library) which is needed for
+        // GraphicsPipelineConfig::library_flags and PipelineLibraryLinker
+        bool enable_graphics_pipeline_library = false;
     };
 
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageCreateInfo.html
@@ -4689,13 +5093,44 @@ namespace bv
         std::optional<SpecializationInfo> specialization_info;
     };
 
+    // if the module doesn't have a handle yet (see
+    // ShaderModule::create_from_identifier()), its identifier is passed in a
+    // VkPipelineShaderStageModuleIdentifierCreateInfoEXT instead.
     VkPipelineShaderStageCreateInfo ShaderStage_to_vk(
         const ShaderStage& stage,
         VkSpecializationInfo& waste_vk_specialization_info,
         std::vector<VkSpecializationMapEntry>& waste_vk_map_entries,
-        std::vector<uint8_t>& waste_data
+        std::vector<uint8_t>& waste_data,
+
+        VkPipelineShaderStageModuleIdentifierCreateInfoEXT&
+        waste_vk_identifier_info
     );
 
+#ifdef BV_ENABLE_SHADERC
+    // a GLSL file for GlslCompiler. #include "..." is resolved relative to
+    // the directory of the including file and then in include_dirs, and
+    // #include <...> only in include_dirs.
+    struct GlslSource
+    {
+        std::string path;
+
+        // searched in order, like glslc's -I
+        std::vector<std::string> include_dirs;
+
+        // if this is 0, the stage is inferred from a #pragma shader_stage()
+        // in the source
+        VkShaderStageFlagBits stage = (VkShaderStageFlagBits)0;
+
+        std::string entry_point = "main";
+
+        // name and value pairs, like glslc's -DNAME=VALUE
+        std::vector<std::pair<std::string, std::string>> defines;
+
+        bool optimize = true;
+        bool generate_debug_info = false;
+    };
+#endif
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineDynamicStateCreateInfo.html
     using DynamicStates = std::vector<VkDynamicState>;
 
@@ -4704,6 +5139,22 @@ namespace bv
         std::vector<VkDynamicState>& waste_dynamic_states
     );
 
+    // attachment formats of a graphics pipeline that is used with dynamic
+    // rendering instead of a render pass.
+    // provided by VK_KHR_dynamic_rendering (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineRenderingCreateInfo.html
+    struct PipelineRenderingFormats
+    {
+        uint32_t view_mask = 0;
+        std::vector<VkFormat> color_attachment_formats;
+        VkFormat depth_attachment_format = VK_FORMAT_UNDEFINED;
+        VkFormat stencil_attachment_format = VK_FORMAT_UNDEFINED;
+    };
+
+    VkPipelineRenderingCreateInfo PipelineRenderingFormats_to_vk(
+        const PipelineRenderingFormats& formats
+    );
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkVertexInputBindingDescription.html
     struct VertexInputBindingDescription
     {
@@ -4906,6 +5357,22 @@ namespace bv
         const ColorBlendAttachment& attachment
     );
 
+    // provided by VK_EXT_extended_dynamic_state3
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkColorBlendEquationEXT.html
+    struct ColorBlendEquation
+    {
+        VkBlendFactor src_color_blend_factor;
+        VkBlendFactor dst_color_blend_factor;
+        VkBlendOp color_blend_op;
+        VkBlendFactor src_alpha_blend_factor;
+        VkBlendFactor dst_alpha_blend_factor;
+        VkBlendOp alpha_blend_op;
+    };
+
+    VkColorBlendEquationEXT ColorBlendEquation_to_vk(
+        const ColorBlendEquation& equation
+    );
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineColorBlendStateCreateInfo.html
     struct ColorBlendState
     {
@@ -5072,11 +5539,53 @@ namespace bv
         std::optional<ColorBlendState> color_blend_state;
         DynamicStates dynamic_states;
         PipelineLayoutWPtr layout;
+
+        // ignored if rendering_formats has a value
         RenderPassWPtr render_pass;
         uint32_t subpass_index;
+
         std::optional<GraphicsPipelineWPtr> base_pipeline;
+
+        // if this has a value, the pipeline is created without a render pass
+        // and can only be used between CommandBuffer::begin_rendering() and
+        // end_rendering(). since it only depends on the attachment formats, it
+        // stays valid when the swapchain is resized. the dynamicRendering
+        // feature must be enabled in DeviceConfig.
+        std::optional<PipelineRenderingFormats> rendering_formats;
+
+        // if this isn't 0, the pipeline is created as a graphics pipeline
+        // library that only holds the given parts of the pipeline state and
+        // VK_PIPELINE_CREATE_LIBRARY_BIT_KHR is added to flags. the
+        // graphicsPipelineLibrary feature must be enabled in DeviceConfig.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkGraphicsPipelineLibraryCreateInfoEXT.html
+        VkGraphicsPipelineLibraryFlagsEXT library_flags = 0;
+
+        // graphics pipeline libraries to link into this pipeline. the state
+        // they hold should be left out of this config.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineLibraryCreateInfoKHR.html
+        std::vector<GraphicsPipelineWPtr> libraries;
     };
 
+    // returns a copy of config where the state that's overridden by its
+    // dynamic states is reset, so that configs that only differ in dynamic
+    // state compare (and hash) equal. the primitive topology is only reduced
+    // to its topology class since the pipeline still depends on it. the
+    // result is still valid for pipeline creation.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDynamicState.html
+    GraphicsPipelineConfig GraphicsPipelineConfig_strip_dynamic_state(
+        const GraphicsPipelineConfig& config
+    );
+
+    // returns the part of config that a graphics pipeline library with the
+    // given part flag would hold, with library_flags set to part. the shader
+    // stages are split between the pre-rasterization and fragment shader
+    // parts, the layout and render pass are kept in all of them.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkGraphicsPipelineLibraryFlagBitsEXT.html
+    GraphicsPipelineConfig GraphicsPipelineConfig_library_part(
+        const GraphicsPipelineConfig& config,
+        VkGraphicsPipelineLibraryFlagBitsEXT part
+    );
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkComputePipelineCreateInfo.html
     struct ComputePipelineConfig
     {
@@ -5086,6 +5595,20 @@ namespace bv
         std::optional<GraphicsPipelineWPtr> base_pipeline;
     };
 
+    // describes the images that will be bound to an attachment of an
+    // imageless framebuffer. these must match the create info of the images
+    // whose views are passed to CommandBuffer::begin_render_pass().
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFramebufferAttachmentImageInfo.html
+    struct FramebufferAttachmentImageInfo
+    {
+        VkImageCreateFlags flags;
+        VkImageUsageFlags usage;
+        uint32_t width;
+        uint32_t height;
+        uint32_t layer_count;
+        std::vector<VkFormat> view_formats;
+    };
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFramebufferCreateInfo.html
     struct FramebufferConfig
     {
@@ -5095,6 +5618,15 @@ namespace bv
         uint32_t width;
         uint32_t height;
         uint32_t layers;
+
+        // if not empty, an imageless framebuffer is created
+        // (VK_KHR_imageless_framebuffer or Vulkan 1.2) and attachments must
+        // be empty. the views are provided when beginning the render pass
+        // instead, so a single framebuffer can be used with all swapchain
+        // images. the imagelessFramebuffer feature must be enabled in
+        // DeviceConfig.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFramebufferAttachmentsCreateInfo.html
+        std::vector<FramebufferAttachmentImageInfo> attachment_image_infos;
     };
 
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandPoolCreateInfo.html
@@ -5284,6 +5816,393 @@ namespace bv
         const VkImageFormatProperties& properties
     );
 
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferMemoryBarrier.html
+    struct BufferMemoryBarrier
+    {
+        VkAccessFlags src_access_mask;
+        VkAccessFlags dst_access_mask;
+        uint32_t src_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dst_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        BufferWPtr buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    VkBufferMemoryBarrier BufferMemoryBarrier_to_vk(
+        const BufferMemoryBarrier& barrier
+    );
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
+    struct ImageMemoryBarrier
+    {
+        VkAccessFlags src_access_mask;
+        VkAccessFlags dst_access_mask;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+        uint32_t src_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dst_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        ImageWPtr image;
+        ImageSubresourceRange subresource_range;
+    };
+
+    VkImageMemoryBarrier ImageMemoryBarrier_to_vk(
+        const ImageMemoryBarrier& barrier
+    );
+
+    // provided by VK_KHR_synchronization2 (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSemaphoreSubmitInfo.html
+    struct SemaphoreSubmitInfo
+    {
+        SemaphoreWPtr semaphore;
+
+        // ignored for binary semaphores
+        uint64_t value = 0;
+
+        VkPipelineStageFlags2 stage_mask;
+        uint32_t device_index = 0;
+    };
+
+    VkSemaphoreSubmitInfo SemaphoreSubmitInfo_to_vk(
+        const SemaphoreSubmitInfo& info
+    );
+
+    // provided by VK_KHR_synchronization2 (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryBarrier2.html
+    struct MemoryBarrier2
+    {
+        VkPipelineStageFlags2 src_stage_mask;
+        VkAccessFlags2 src_access_mask;
+        VkPipelineStageFlags2 dst_stage_mask;
+        VkAccessFlags2 dst_access_mask;
+    };
+
+    VkMemoryBarrier2 MemoryBarrier2_to_vk(const MemoryBarrier2& barrier);
+
+    // provided by VK_KHR_synchronization2 (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferMemoryBarrier2.html
+    struct BufferMemoryBarrier2
+    {
+        VkPipelineStageFlags2 src_stage_mask;
+        VkAccessFlags2 src_access_mask;
+        VkPipelineStageFlags2 dst_stage_mask;
+        VkAccessFlags2 dst_access_mask;
+        uint32_t src_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dst_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        BufferWPtr buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    VkBufferMemoryBarrier2 BufferMemoryBarrier2_to_vk(
+        const BufferMemoryBarrier2& barrier
+    );
+
+    // provided by VK_KHR_synchronization2 (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier2.html
+    struct ImageMemoryBarrier2
+    {
+        VkPipelineStageFlags2 src_stage_mask;
+        VkAccessFlags2 src_access_mask;
+        VkPipelineStageFlags2 dst_stage_mask;
+        VkAccessFlags2 dst_access_mask;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+        uint32_t src_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dst_queue_family_index = VK_QUEUE_FAMILY_IGNORED;
+        ImageWPtr image;
+        ImageSubresourceRange subresource_range;
+    };
+
+    VkImageMemoryBarrier2 ImageMemoryBarrier2_to_vk(
+        const ImageMemoryBarrier2& barrier
+    );
+
+    // provided by VK_KHR_synchronization2 (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDependencyInfo.html
+    struct DependencyInfo
+    {
+        VkDependencyFlags dependency_flags;
+        std::vector<MemoryBarrier2> memory_barriers;
+        std::vector<BufferMemoryBarrier2> buffer_memory_barriers;
+        std::vector<ImageMemoryBarrier2> image_memory_barriers;
+    };
+
+    VkDependencyInfo DependencyInfo_to_vk(
+        const DependencyInfo& info,
+        std::vector<VkMemoryBarrier2>& waste_vk_memory_barriers,
+        std::vector<VkBufferMemoryBarrier2>& waste_vk_buffer_memory_barriers,
+        std::vector<VkImageMemoryBarrier2>& waste_vk_image_memory_barriers
+    );
+
+    // provided by VK_KHR_dynamic_rendering (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkRenderingAttachmentInfo.html
+    struct RenderingAttachmentInfo
+    {
+        ImageViewWPtr image_view;
+        VkImageLayout image_layout;
+        VkResolveModeFlagBits resolve_mode = VK_RESOLVE_MODE_NONE;
+
+        // only used if resolve_mode isn't VK_RESOLVE_MODE_NONE
+        std::optional<ImageViewWPtr> resolve_image_view;
+        VkImageLayout resolve_image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkAttachmentLoadOp load_op;
+        VkAttachmentStoreOp store_op;
+        VkClearValue clear_value{};
+    };
+
+    VkRenderingAttachmentInfo RenderingAttachmentInfo_to_vk(
+        const RenderingAttachmentInfo& info
+    );
+
+    // provided by VK_KHR_dynamic_rendering (core in Vulkan 1.3)
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkRenderingInfo.html
+    struct RenderingInfo
+    {
+        VkRenderingFlags flags = 0;
+        Rect2d render_area;
+        uint32_t layer_count = 1;
+        uint32_t view_mask = 0;
+        std::vector<RenderingAttachmentInfo> color_attachments;
+        std::optional<RenderingAttachmentInfo> depth_attachment;
+        std::optional<RenderingAttachmentInfo> stencil_attachment;
+    };
+
+    VkRenderingInfo RenderingInfo_to_vk(
+        const RenderingInfo& info,
+        std::vector<VkRenderingAttachmentInfo>& waste_vk_color_attachments,
+        VkRenderingAttachmentInfo& waste_vk_depth_attachment,
+        VkRenderingAttachmentInfo& waste_vk_stencil_attachment
+    );
+
+    // raw handle view of a VkSubmitInfo for Queue::submit_batches(). unlike
+    // the rest of the data-only structs, this one references Vulkan handles
+    // directly through spans instead of holding smart pointers so that a hot
+    // submit path doesn't have to copy shared pointers or allocate. the
+    // memory behind the spans is owned by the caller and only needs to stay
+    // alive until submit_batches() returns.
+    // wait_values and signal_values are only needed for timeline semaphores.
+    // if not empty, they must have one value per semaphore (values for
+    // binary semaphores are ignored).
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo.html
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkTimelineSemaphoreSubmitInfo.html
+    struct SubmitBatch
+    {
+        std::span<const VkSemaphore> wait_semaphores;
+
+        // one per wait semaphore
+        std::span<const VkPipelineStageFlags> wait_stages;
+
+        std::span<const VkCommandBuffer> command_buffers;
+        std::span<const VkSemaphore> signal_semaphores;
+        std::span<const uint64_t> wait_values;
+        std::span<const uint64_t> signal_values;
+    };
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkQueryPoolCreateInfo.html
+    struct QueryPoolConfig
+    {
+        VkQueryType query_type;
+        uint32_t query_count;
+
+        // only used with VK_QUERY_TYPE_PIPELINE_STATISTICS
+        VkQueryPipelineStatisticFlags pipeline_statistics = 0;
+    };
+
+    // instance-level functions that Context loads once with
+    // vkGetInstanceProcAddr(). extension functions are nullptr if the
+    // extension isn't enabled.
+#define _BV_INSTANCE_FUNCTIONS(X) \
+    X(vkDestroyInstance) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceFeatures) \
+    X(vkGetPhysicalDeviceProperties2) \
+    X(vkGetPhysicalDeviceFeatures2) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceFormatProperties) \
+    X(vkGetPhysicalDeviceImageFormatProperties) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkCreateDevice) \
+    X(vkGetDeviceProcAddr) \
+    X(vkDestroySurfaceKHR) \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkCreateDebugUtilsMessengerEXT) \
+    X(vkDestroyDebugUtilsMessengerEXT) \
+    X(vkCreateHeadlessSurfaceEXT) \
+    X(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+
+    // device-level functions that Device loads once with
+    // vkGetDeviceProcAddr(). calling these skips the loader's trampoline
+    // which has to look up the device's dispatch table on every call.
+#define _BV_DEVICE_FUNCTIONS(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkBindImageMemory) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkResetCommandBuffer) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkWaitForFences) \
+    X(vkResetFences) \
+    X(vkGetFenceStatus) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkBindBufferMemory) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkFlushMappedMemoryRanges) \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkFreeDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateBufferView) \
+    X(vkDestroyBufferView) \
+    X(vkCreatePipelineCache) \
+    X(vkDestroyPipelineCache) \
+    X(vkGetPipelineCacheData) \
+    X(vkMergePipelineCaches) \
+    X(vkCreateQueryPool) \
+    X(vkDestroyQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdNextSubpass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdClearAttachments) \
+    X(vkCmdClearColorImage) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdUpdateBuffer) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyImage) \
+    X(vkCmdBlitImage) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCmdBeginQuery) \
+    X(vkCmdEndQuery) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdPushConstants) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDraw) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndirect) \
+    X(vkCmdDrawIndexedIndirect) \
+    X(vkCmdDispatch) \
+    X(vkCmdDispatchIndirect) \
+    X(vkCmdExecuteCommands) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR) \
+    X(vkGetCalibratedTimestampsEXT) \
+    X(vkCmdSetLogicOpEXT) \
+    X(vkCmdSetPatchControlPointsEXT) \
+    X(vkCmdSetDepthClampEnableEXT) \
+    X(vkCmdSetPolygonModeEXT) \
+    X(vkCmdSetRasterizationSamplesEXT) \
+    X(vkCmdSetSampleMaskEXT) \
+    X(vkCmdSetAlphaToCoverageEnableEXT) \
+    X(vkCmdSetAlphaToOneEnableEXT) \
+    X(vkCmdSetLogicOpEnableEXT) \
+    X(vkCmdSetColorBlendEnableEXT) \
+    X(vkCmdSetColorBlendEquationEXT) \
+    X(vkCmdSetColorWriteMaskEXT) \
+    X(vkCmdSetVertexInputEXT) \
+    X(vkGetShaderModuleIdentifierEXT)
+
+    // functions promoted to core that are loaded under their core name first
+    // and under their KHR name if that fails (devices created with an older
+    // API version that enable the extension).
+#define _BV_DEVICE_FUNCTIONS_CORE_OR_KHR(X) \
+    X(vkQueueSubmit2) \
+    X(vkCmdPipelineBarrier2) \
+    X(vkCmdBeginRendering) \
+    X(vkCmdEndRendering) \
+    X(vkGetSemaphoreCounterValue) \
+    X(vkSignalSemaphore) \
+    X(vkWaitSemaphores)
+
+    // same as above but with an EXT fallback (VK_EXT_extended_dynamic_state
+    // and VK_EXT_extended_dynamic_state2, core in Vulkan 1.3)
+#define _BV_DEVICE_FUNCTIONS_CORE_OR_EXT(X) \
+    X(vkCmdSetCullMode) \
+    X(vkCmdSetFrontFace) \
+    X(vkCmdSetPrimitiveTopology) \
+    X(vkCmdSetViewportWithCount) \
+    X(vkCmdSetScissorWithCount) \
+    X(vkCmdBindVertexBuffers2) \
+    X(vkCmdSetDepthTestEnable) \
+    X(vkCmdSetDepthWriteEnable) \
+    X(vkCmdSetDepthCompareOp) \
+    X(vkCmdSetDepthBoundsTestEnable) \
+    X(vkCmdSetStencilTestEnable) \
+    X(vkCmdSetStencilOp) \
+    X(vkCmdSetRasterizerDiscardEnable) \
+    X(vkCmdSetDepthBiasEnable) \
+    X(vkCmdSetPrimitiveRestartEnable)
+
+#define _BV_DECLARE_FUNCTION_POINTER(name) PFN_##name name = nullptr;
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetInstanceProcAddr.html
+    struct InstanceDispatch
+    {
+        _BV_INSTANCE_FUNCTIONS(_BV_DECLARE_FUNCTION_POINTER)
+    };
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetDeviceProcAddr.html
+    struct DeviceDispatch
+    {
+        _BV_DEVICE_FUNCTIONS(_BV_DECLARE_FUNCTION_POINTER)
+        _BV_DEVICE_FUNCTIONS_CORE_OR_KHR(_BV_DECLARE_FUNCTION_POINTER)
+        _BV_DEVICE_FUNCTIONS_CORE_OR_EXT(_BV_DECLARE_FUNCTION_POINTER)
+    };
+
 #pragma endregion
 
 #pragma region error handling
@@ -5319,6 +6238,145 @@ namespace bv
 
 #pragma endregion
 
+#pragma region tracing
+
+    // define BV_ENABLE_TRACING (for beva.cpp too) to record scoped zones in
+    // beva's hot paths, like submitting, presenting, waiting on fences, and
+    // allocating memory. without it, BV_TRACE_ZONE() expands to nothing and
+    // none of the declarations below exist, so code that exports traces
+    // must be guarded by the same define.
+#ifdef BV_ENABLE_TRACING
+#define _BV_TRACE_ZONE_CONCAT_IMPL(a, b) a##b
+#define _BV_TRACE_ZONE_CONCAT(a, b) _BV_TRACE_ZONE_CONCAT_IMPL(a, b)
+#define BV_TRACE_ZONE(name) \
+    ::bv::TraceZone _BV_TRACE_ZONE_CONCAT(_bv_trace_zone_, __LINE__)(name)
+
+    // times are in nanoseconds on the std::chrono::steady_clock timeline
+    struct TraceEvent
+    {
+        const char* name;
+        int64_t begin_ns;
+        int64_t end_ns;
+    };
+
+    // number of events every thread can record before new ones are dropped.
+    // call trace_clear() between captures to make room.
+    static constexpr size_t TRACE_EVENTS_PER_THREAD = 65'536;
+
+    // records an event from its construction to its destruction into a
+    // buffer owned by the calling thread, without locking. name must outlive
+    // the export, so it's usually a string literal. use BV_TRACE_ZONE()
+    // instead of constructing this directly so that it compiles out.
+    class TraceZone
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR(TraceZone);
+
+        TraceZone(const TraceZone& other) = delete;
+        TraceZone& operator=(const TraceZone& other) = delete;
+
+        TraceZone(const char* name);
+        ~TraceZone();
+
+    private:
+        const char* name;
+        int64_t begin_ns;
+
+    };
+
+    // export the events of every thread in the Chrome trace event format,
+    // which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+    // threads can keep recording while this runs.
+    std::string trace_to_chrome_json();
+
+    // forget all events. no thread may be recording zones while this runs.
+    void trace_clear();
+
+    // number of events dropped because a thread's buffer was full
+    uint64_t trace_n_dropped_events();
+
+#else
+#define BV_TRACE_ZONE(name)
+#endif
+
+#pragma endregion
+
+#pragma region stall statistics
+
+    // how long the host was blocked in calls like Fence::wait(), which is
+    // measured by default (unlike tracing) since it only costs two clock
+    // reads and a mutex lock per blocking call. see
+    // set_stall_tracking_enabled() to turn it off.
+    struct StallStats
+    {
+        uint64_t n_calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+
+        constexpr double total_ms() const
+        {
+            return (double)total_ns * 1e-6;
+        }
+
+        constexpr double max_ms() const
+        {
+            return (double)max_ns * 1e-6;
+        }
+    };
+
+    // stalls caused by the calls made from one place in the code. blocking
+    // functions take a std::source_location that defaults to their caller.
+    struct StallCallSite
+    {
+        // the blocking beva function, like "Fence::wait"
+        const char* call;
+
+        std::source_location location;
+        StallStats stats;
+    };
+
+    // stall statistics of a single object, see stall_stats() on Fence,
+    // TimelineSemaphore, Swapchain, Queue, and Device
+    class StallCounter
+    {
+    public:
+        // zero if nothing blocked since the last reset_stall_stats()
+        StallStats stats() const;
+
+        // used by beva's blocking functions
+        void add(uint64_t ns);
+
+    private:
+        StallStats _stats;
+
+        // counters from before the last reset_stall_stats() are stale
+        uint64_t epoch = 0;
+
+        // same as add() but the caller already holds the global stall lock
+        void add_locked(uint64_t ns);
+
+        friend class StallTimer;
+
+    };
+
+    // statistics of every call site that blocked since the last
+    // reset_stall_stats()
+    std::vector<StallCallSite> stall_call_sites();
+
+    // all stalls since the last reset_stall_stats()
+    StallStats total_stall_stats();
+
+    // start counting from zero, usually at the beginning of every frame. this
+    // resets the call sites and the counters of every object at once.
+    void reset_stall_stats();
+
+    // enabled by default. when disabled, blocking functions don't read the
+    // clock or lock anything and the statistics stop changing.
+    void set_stall_tracking_enabled(bool enabled);
+    bool stall_tracking_enabled();
+
+#pragma endregion
+
 #pragma region classes and object wrappers
 
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkAllocationCallbacks.html
@@ -5389,6 +6447,53 @@ namespace bv
             return _queue_families;
         }
 
+        // the Vulkan 1.1, 1.2, and 1.3 features and properties only have a
+        // value if both the physical device and the context's
+        // vulkan_api_version support the matching API version.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceFeatures2.html
+        constexpr const std::optional<PhysicalDeviceVulkan11Features>&
+            vulkan11_features() const
+        {
+            return _vulkan11_features;
+        }
+
+        constexpr const std::optional<PhysicalDeviceVulkan12Features>&
+            vulkan12_features() const
+        {
+            return _vulkan12_features;
+        }
+
+        constexpr const std::optional<PhysicalDeviceVulkan13Features>&
+            vulkan13_features() const
+        {
+            return _vulkan13_features;
+        }
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceProperties2.html
+        constexpr const std::optional<PhysicalDeviceVulkan11Properties>&
+            vulkan11_properties() const
+        {
+            return _vulkan11_properties;
+        }
+
+        constexpr const std::optional<PhysicalDeviceVulkan12Properties>&
+            vulkan12_properties() const
+        {
+            return _vulkan12_properties;
+        }
+
+        constexpr const std::optional<PhysicalDeviceVulkan13Properties>&
+            vulkan13_properties() const
+        {
+            return _vulkan13_properties;
+        }
+
+        // instance-level functions of the Context this was fetched from
+        const InstanceDispatch& dispatch() const
+        {
+            return *_dispatch;
+        }
+
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkEnumerateDeviceExtensionProperties.html
         std::vector<ExtensionProperties> fetch_available_extensions(
             const std::string& layer_name = ""
@@ -5451,7 +6556,17 @@ namespace bv
         PhysicalDeviceMemoryProperties _memory_properties;
         std::vector<QueueFamily> _queue_families;
 
+        std::optional<PhysicalDeviceVulkan11Features> _vulkan11_features;
+        std::optional<PhysicalDeviceVulkan12Features> _vulkan12_features;
+        std::optional<PhysicalDeviceVulkan13Features> _vulkan13_features;
+        std::optional<PhysicalDeviceVulkan11Properties> _vulkan11_properties;
+        std::optional<PhysicalDeviceVulkan12Properties> _vulkan12_properties;
+        std::optional<PhysicalDeviceVulkan13Properties> _vulkan13_properties;
+
+        std::shared_ptr<const InstanceDispatch> _dispatch;
+
         PhysicalDevice(
+            const std::shared_ptr<const InstanceDispatch>& dispatch,
             VkPhysicalDevice handle,
             const PhysicalDeviceProperties& properties,
             const PhysicalDeviceFeatures& features,
@@ -5516,6 +6631,13 @@ namespace bv
             return _vk_instance;
         }
 
+        // instance-level functions loaded once after the instance is created.
+        // global functions like vkCreateInstance() aren't included.
+        const InstanceDispatch& dispatch() const
+        {
+            return *_dispatch;
+        }
+
         // if _allocator == nullptr, this will return nullptr, otherwise it will
         // return the address of _vk_allocator which contains function pointers
         // for callbacks.
@@ -5526,6 +6648,8 @@ namespace bv
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceFeatures.html
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceMemoryProperties.html
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceQueueFamilyProperties.html
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceFeatures2.html
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPhysicalDeviceProperties2.html
         std::vector<PhysicalDevice> fetch_physical_devices() const;
 
         ~Context();
@@ -5538,6 +6662,8 @@ namespace bv
 
         VkInstance _vk_instance = nullptr;
 
+        std::shared_ptr<const InstanceDispatch> _dispatch;
+
         Context(
             const ContextConfig& config,
             const AllocatorPtr& allocator
@@ -5622,6 +6748,13 @@ namespace bv
             VkSurfaceKHR handle
         );
 
+        // create a surface that isn't tied to any window. presenting to it
+        // does nothing, which is useful for running without a display.
+        // * make sure to enable VK_KHR_surface and VK_EXT_headless_surface.
+        // provided by VK_EXT_headless_surface
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCreateHeadlessSurfaceEXT.html
+        static SurfacePtr create_headless(const ContextPtr& context);
+
         constexpr const ContextWPtr& context() const
         {
             return _context;
@@ -5672,13 +6805,79 @@ namespace bv
             return _handle;
         }
 
+        // same as the device's dispatch table, but without having to lock
+        // device()
+        const DeviceDispatch& dispatch() const
+        {
+            return *_dispatch;
+        }
+
+        // wait_values and signal_values are only needed for timeline
+        // semaphores. if not empty, they must have one value per semaphore
+        // (values for binary semaphores are ignored).
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo.html
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkTimelineSemaphoreSubmitInfo.html
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkQueueSubmit.html
         void submit(
             const std::vector<VkPipelineStageFlags>& wait_stages,
             const std::vector<SemaphorePtr>& wait_semaphores,
             const std::vector<CommandBufferPtr>& command_buffers,
             const std::vector<SemaphorePtr>& signal_semaphores,
+            const FencePtr& signal_fence = nullptr,
+            const std::vector<uint64_t>& wait_values = {},
+            const std::vector<uint64_t>& signal_values = {}
+        );
+
+        // same as submit() but returns the result of vkQueueSubmit() instead
+        // of throwing, or VK_ERROR_INITIALIZATION_FAILED without submitting
+        // if the sizes of the stages, semaphores, and values don't match.
+        // the try_*() functions are meant for per-frame code that wants to
+        // handle results like VK_ERROR_OUT_OF_DATE_KHR without exceptions.
+        VkResult try_submit(
+            const std::vector<VkPipelineStageFlags>& wait_stages,
+            const std::vector<SemaphorePtr>& wait_semaphores,
+            const std::vector<CommandBufferPtr>& command_buffers,
+            const std::vector<SemaphorePtr>& signal_semaphores,
+            const FencePtr& signal_fence = nullptr,
+            const std::vector<uint64_t>& wait_values = {},
+            const std::vector<uint64_t>& signal_values = {}
+        );
+
+        // submit multiple batches of command buffers without any heap
+        // allocations. up to max_batches_per_submit batches go into each call
+        // to vkQueueSubmit(), so there's one call per chunk of that many
+        // batches and no hard limit on their count. the fence (if any) is
+        // only signaled by the last chunk, meaning once all batches are
+        // done.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkQueueSubmit.html
+        void submit_batches(
+            std::span<const SubmitBatch> batches,
+            VkFence signal_fence = VK_NULL_HANDLE
+        );
+
+        // same as submit_batches() but returns the first result other than
+        // VK_SUCCESS instead of throwing. if the sizes of any batch's spans
+        // don't match, nothing is submitted and the result is
+        // VK_ERROR_INITIALIZATION_FAILED.
+        VkResult try_submit_batches(
+            std::span<const SubmitBatch> batches,
+            VkFence signal_fence = VK_NULL_HANDLE
+        );
+
+        // number of VkSubmitInfos that submit_batches() keeps on the stack
+        // and passes to a single vkQueueSubmit() call.
+        static constexpr size_t max_batches_per_submit = 16;
+
+        // provided by VK_KHR_synchronization2 (core in Vulkan 1.3). each
+        // semaphore gets its own stage mask (and value for timeline
+        // semaphores) instead of sharing a coarse VkPipelineStageFlags. the
+        // synchronization2 feature must be enabled in DeviceConfig.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo2.html
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkQueueSubmit2.html
+        void submit2(
+            const std::vector<SemaphoreSubmitInfo>& wait_semaphore_infos,
+            const std::vector<CommandBufferPtr>& command_buffers,
+            const std::vector<SemaphoreSubmitInfo>& signal_semaphore_infos,
             const FencePtr& signal_fence = nullptr
         );
 
@@ -5689,11 +6888,33 @@ namespace bv
             const std::vector<SemaphorePtr>& wait_semaphores,
             const SwapchainPtr& swapchain,
             uint32_t image_index,
-            VkResult* out_vk_result = nullptr
+            VkResult* out_vk_result = nullptr,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // same as present() but returns the result of vkQueuePresentKHR()
+        // (like VK_SUBOPTIMAL_KHR or VK_ERROR_OUT_OF_DATE_KHR) instead of
+        // throwing, and doesn't allocate for up to 16 wait semaphores
+        VkResult try_present(
+            std::span<const SemaphorePtr> wait_semaphores,
+            const SwapchainPtr& swapchain,
+            uint32_t image_index,
+            const std::source_location& location =
+            std::source_location::current()
         );
 
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkQueueWaitIdle.html
-        void wait_idle();
+        void wait_idle(
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // time spent in present() and wait_idle()
+        StallStats stall_stats() const
+        {
+            return _stall_counter.stats();
+        }
 
     protected:
         DeviceWPtr _device;
@@ -5701,8 +6922,12 @@ namespace bv
         uint32_t _queue_index;
         VkQueue _handle;
 
+        std::shared_ptr<const DeviceDispatch> _dispatch;
+
+        StallCounter _stall_counter;
+
         Queue(
-            const DeviceWPtr& device,
+            const DevicePtr& device,
             uint32_t queue_family_index,
             uint32_t queue_index,
             VkQueue handle
@@ -5710,6 +6935,11 @@ namespace bv
 
     };
 
+    // number of calls to vkQueueSubmit() and vkQueueSubmit2() made by the
+    // submit functions of every Queue, including the ones that failed.
+    // compare it at two points to count submits per frame.
+    uint64_t submit_count();
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDevice.html
     class Device
     {
@@ -5742,6 +6972,22 @@ namespace bv
             return _handle;
         }
 
+        // device-level functions loaded once with vkGetDeviceProcAddr() after
+        // the device is created. calling through these skips the loader's
+        // trampoline, which is noticeable in command recording.
+        const DeviceDispatch& dispatch() const
+        {
+            return *_dispatch;
+        }
+
+        // shared with the queues and command buffers so that they don't have
+        // to lock the device before every call
+        constexpr const std::shared_ptr<const DeviceDispatch>&
+            dispatch_ptr() const
+        {
+            return _dispatch;
+        }
+
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetDeviceQueue.html
         static QueuePtr retrieve_queue(
             const DevicePtr& device,
@@ -5750,7 +6996,16 @@ namespace bv
         );
 
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkDeviceWaitIdle.html
-        void wait_idle();
+        void wait_idle(
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // time spent in wait_idle()
+        StallStats stall_stats() const
+        {
+            return _stall_counter.stats();
+        }
 
         ~Device();
 
@@ -5761,6 +7016,10 @@ namespace bv
 
         VkDevice _handle = nullptr;
 
+        std::shared_ptr<const DeviceDispatch> _dispatch;
+
+        StallCounter _stall_counter;
+
         Device(
             const ContextPtr& context,
             const PhysicalDevice& physical_device,
@@ -5839,8 +7098,9 @@ namespace bv
             const ImageConfig& config
         );
 
-        // this should only be used by Swapchain when retrieving its images
-        Image(VkImage handle_created_externally);
+        // this should only be used by Swapchain when retrieving its images.
+        // the config is filled in from the swapchain config.
+        Image(VkImage handle_created_externally, const ImageConfig& config);
 
     };
 
@@ -5896,9 +7156,31 @@ namespace bv
             const SemaphorePtr& semaphore = nullptr,
             const FencePtr& fence = nullptr,
             uint64_t timeout = std::numeric_limits<uint64_t>::max(),
-            VkResult* out_vk_result = nullptr
+            VkResult* out_vk_result = nullptr,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // same as acquire_next_image() but returns the result of
+        // vkAcquireNextImageKHR() (like VK_SUBOPTIMAL_KHR, VK_TIMEOUT, or
+        // VK_ERROR_OUT_OF_DATE_KHR) instead of throwing. out_image_index is
+        // only written if an image was acquired. still throws if the device
+        // has been destroyed.
+        VkResult try_acquire_next_image(
+            uint32_t& out_image_index,
+            const SemaphorePtr& semaphore = nullptr,
+            const FencePtr& fence = nullptr,
+            uint64_t timeout = std::numeric_limits<uint64_t>::max(),
+            const std::source_location& location =
+            std::source_location::current()
         );
 
+        // time spent in acquire_next_image()
+        StallStats stall_stats() const
+        {
+            return _stall_counter.stats();
+        }
+
         ~Swapchain();
 
     protected:
@@ -5911,6 +7193,8 @@ namespace bv
 
         std::vector<ImagePtr> _images;
 
+        StallCounter _stall_counter;
+
         Swapchain(
             const DevicePtr& device,
             const SurfacePtr& surface,
@@ -5976,32 +7260,226 @@ namespace bv
     public:
         _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(ShaderModule);
 
+        // if DeviceConfig::enable_shader_module_identifier is set, the
+        // module's identifier is queried too
         static ShaderModulePtr create(
             const DevicePtr& device,
-            const std::vector<uint8_t>& code
+            std::span<const uint8_t> code
+        );
+
+        // create a module that only has an identifier that was queried from
+        // an identical module in an earlier run, and no handle. pipelines
+        // made with it are only created if they're in the pipeline cache,
+        // otherwise ensure_handle() is called and they're created normally.
+        // load_code is called by ensure_handle() to get the SPIR-V code.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineShaderStageModuleIdentifierCreateInfoEXT.html
+        static ShaderModulePtr create_from_identifier(
+            const DevicePtr& device,
+            uint64_t code_hash,
+            const std::vector<uint8_t>& identifier,
+            const std::function<std::vector<uint8_t>()>& load_code
+        );
+
+#ifdef BV_ENABLE_SHADERC
+        // compile the source with the compiler (or load it from its cache)
+        // and create a module from the SPIR-V code
+        static ShaderModulePtr create_from_glsl(
+            const DevicePtr& device,
+            const GlslCompilerPtr& compiler,
+            const GlslSource& source
         );
+#endif
 
         constexpr const DeviceWPtr& device() const
         {
             return _device;
         }
 
-        constexpr VkShaderModule handle() const
+        // nullptr if the module was created from an identifier and
+        // ensure_handle() wasn't called yet. this doesn't lock.
+        VkShaderModule handle() const;
+
+        // FNV-1a hash of the SPIR-V code. unlike the handle, this identifies
+        // the contents of the module across runs.
+        constexpr uint64_t code_hash() const
         {
-            return _handle;
+            return _code_hash;
         }
 
+        // empty if shader module identifiers aren't enabled
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetShaderModuleIdentifierEXT.html
+        constexpr const std::vector<uint8_t>& identifier() const
+        {
+            return _identifier;
+        }
+
+        // create the handle of a module that was created from an identifier.
+        // does nothing if it already has one. this is thread-safe.
+        void ensure_handle();
+
         ~ShaderModule();
 
     protected:
         DeviceWPtr _device;
 
-        VkShaderModule _handle = nullptr;
+        // atomic so that handle() doesn't have to lock, and behind a pointer
+        // so that the module stays movable. both pointers are nullptr in a
+        // moved-from module.
+        std::shared_ptr<std::atomic<VkShaderModule>> _handle;
+        uint64_t _code_hash = 0;
+        std::vector<uint8_t> _identifier;
+
+        std::function<std::vector<uint8_t>()> load_code;
+
+        // only taken by ensure_handle() to create the handle once
+        std::shared_ptr<std::mutex> handle_mutex;
 
         ShaderModule(const DevicePtr& device);
 
     };
 
+    // hands out one ShaderModule per distinct SPIR-V code. files are memory
+    // mapped and hashed, and modules with the same code_hash() are shared
+    // (the 64-bit hash is trusted to identify the code). the registry keeps
+    // its modules alive until prune() or clear() so that pipelines that are
+    // created at different times can share them. if
+    // DeviceConfig::enable_shader_module_identifier is set and the
+    // identifier of a module was saved by save_identifiers() in an earlier
+    // run, the module is created with ShaderModule::create_from_identifier()
+    // so its creation is skipped until a pipeline actually needs it.
+    class ShaderModuleRegistry
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(ShaderModuleRegistry);
+
+        // identifiers are loaded from identifier_cache_path if it's not
+        // empty. the file is ignored if it was written on another device or
+        // driver version.
+        static ShaderModuleRegistryPtr create(
+            const DevicePtr& device,
+            const std::string& identifier_cache_path = ""
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        // throws if the file can't be read
+        ShaderModulePtr get(const std::string& path);
+
+        ShaderModulePtr get(std::span<const uint8_t> code);
+
+        // write the identifiers of the modules to identifier_cache_path
+        void save_identifiers();
+
+        // release the modules that are only referenced by the registry.
+        // their identifiers are kept.
+        void prune();
+
+        void clear();
+
+        // number of modules that were requested again and reused
+        uint64_t n_reused() const;
+
+        // number of modules that were created from an identifier
+        uint64_t n_identifier_hits() const;
+
+        size_t size() const;
+
+    protected:
+        DeviceWPtr _device;
+        std::string identifier_cache_path;
+
+        std::unordered_map<uint64_t, ShaderModulePtr> modules;
+        std::unordered_map<uint64_t, std::vector<uint8_t>> identifiers;
+
+        uint64_t _n_reused = 0;
+        uint64_t _n_identifier_hits = 0;
+        std::shared_ptr<std::mutex> mutex;
+
+        ShaderModuleRegistry(
+            const DevicePtr& device,
+            const std::string& identifier_cache_path
+        );
+
+        ShaderModulePtr get(
+            uint64_t code_hash,
+            std::span<const uint8_t> code,
+            const std::function<std::vector<uint8_t>()>& load_code
+        );
+
+    };
+
+    // define BV_ENABLE_SHADERC (for beva.cpp too) and link against libshaderc
+    // to compile GLSL to SPIR-V at runtime instead of running glslc
+    // beforehand. the SPIR-V is cached in cache_dir under a hash of the
+    // preprocessed source (which covers #included files and defines), the
+    // compile options, the target Vulkan version, and the SPIR-V version
+    // that shaderc targets, so a source is only compiled again when
+    // something that affects its output changes. shaderc doesn't report its
+    // own version, so clear the cache after upgrading it. the source is
+    // preprocessed on every call, which is cheap compared to compiling it.
+#ifdef BV_ENABLE_SHADERC
+    class GlslCompiler
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(GlslCompiler);
+
+        // the cache is disabled if cache_dir is empty, otherwise the
+        // directory is created if it doesn't exist. target_vulkan_version is
+        // a VK_API_VERSION_* value.
+        static GlslCompilerPtr create(
+            const std::string& cache_dir = "",
+            uint32_t target_vulkan_version = VK_API_VERSION_1_0
+        );
+
+        constexpr const std::string& cache_dir() const
+        {
+            return _cache_dir;
+        }
+
+        constexpr uint32_t target_vulkan_version() const
+        {
+            return _target_vulkan_version;
+        }
+
+        // throws with the compiler's messages if the source doesn't compile.
+        // this is thread-safe.
+        std::vector<uint8_t> compile(const GlslSource& source);
+
+        // compile the sources in parallel and block until they're all done,
+        // like to warm the cache at startup. the code is returned in the
+        // same order as the sources. if any of them fails, the first error
+        // is thrown after the rest are done. if n_threads is 0,
+        // std::thread::hardware_concurrency() threads are used.
+        std::vector<std::vector<uint8_t>> compile_multiple(
+            const std::vector<GlslSource>& sources,
+            uint32_t n_threads = 0
+        );
+
+        // number of sources that were loaded from the cache
+        uint64_t n_cache_hits() const;
+
+        // number of sources that were actually compiled
+        uint64_t n_compiled() const;
+
+    protected:
+        std::string _cache_dir;
+        uint32_t _target_vulkan_version;
+
+        uint64_t _n_cache_hits = 0;
+        uint64_t _n_compiled = 0;
+        std::shared_ptr<std::mutex> stats_mutex;
+
+        GlslCompiler(
+            const std::string& cache_dir,
+            uint32_t target_vulkan_version
+        );
+
+    };
+#endif
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSampler.html
     class Sampler
     {
@@ -6179,6 +7657,14 @@ namespace bv
             const PipelineCachePtr& cache = nullptr
         );
 
+        // create all of the pipelines with a single call on this thread. see
+        // PipelineCompiler for creating pipelines on multiple threads.
+        static std::vector<GraphicsPipelinePtr> create_multiple(
+            const DevicePtr& device,
+            const std::vector<GraphicsPipelineConfig>& configs,
+            const PipelineCachePtr& cache = nullptr
+        );
+
         constexpr const DeviceWPtr& device() const
         {
             return _device;
@@ -6214,6 +7700,8 @@ namespace bv
             const PipelineCachePtr& cache = nullptr
         );
 
+        friend class PipelineCompiler;
+
     };
 
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipeline.html
@@ -6229,6 +7717,14 @@ namespace bv
             const PipelineCachePtr& cache = nullptr
         );
 
+        // create all of the pipelines with a single call on this thread. see
+        // PipelineCompiler for creating pipelines on multiple threads.
+        static std::vector<ComputePipelinePtr> create_multiple(
+            const DevicePtr& device,
+            const std::vector<ComputePipelineConfig>& configs,
+            const PipelineCachePtr& cache = nullptr
+        );
+
         constexpr const DeviceWPtr& device() const
         {
             return _device;
@@ -6264,6 +7760,8 @@ namespace bv
             const PipelineCachePtr& cache = nullptr
         );
 
+        friend class PipelineCompiler;
+
     };
 
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFramebuffer.html
@@ -6307,6 +7805,47 @@ namespace bv
 
     };
 
+    // reuses framebuffers with the same render pass, dimensions, and
+    // attachments (or attachment image infos for imageless framebuffers)
+    // instead of creating a new one for every use. imageless framebuffers
+    // only depend on the dimensions and formats of the attachments, so they
+    // survive swapchain recreation as long as those stay the same. cached
+    // framebuffers whose render pass or attachments were destroyed are never
+    // returned, call prune() to free them. this is thread-safe.
+    class FramebufferCache
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(FramebufferCache);
+
+        static FramebufferCachePtr create(const DevicePtr& device);
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        // return a cached framebuffer matching the config or create one
+        FramebufferPtr get(const FramebufferConfig& config);
+
+        // destroy the cached framebuffers whose render pass or attachments
+        // no longer exist
+        void prune();
+
+        // the device must not be using any of the cached framebuffers unless
+        // you're still holding on to them
+        void clear();
+
+        size_t size() const;
+
+    protected:
+        DeviceWPtr _device;
+        std::unordered_map<uint64_t, FramebufferPtr> framebufs;
+        std::shared_ptr<std::mutex> mutex;
+
+        FramebufferCache(const DevicePtr& device);
+
+    };
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBuffer.html
     class CommandBuffer
     {
@@ -6323,6 +7862,13 @@ namespace bv
             return _handle;
         }
 
+        // the device's dispatch table. use this for vkCmd*() calls that beva
+        // doesn't wrap, like dispatch().vkCmdDraw(cmd->handle(), ...).
+        const DeviceDispatch& dispatch() const
+        {
+            return *_dispatch;
+        }
+
         void reset(VkCommandBufferResetFlags flags);
 
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBufferBeginInfo.html
@@ -6335,15 +7881,219 @@ namespace bv
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkEndCommandBuffer.html
         void end();
 
+        // queue family ownership transfers are done by recording a release
+        // barrier on the source queue and a matching acquire barrier (same
+        // queue family indices and layouts) on the destination queue. global
+        // memory barriers are left out because MemoryBarrier is a macro in
+        // windows.h, use pipeline_barrier2() if you need them.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdPipelineBarrier.html
+        void pipeline_barrier(
+            VkPipelineStageFlags src_stage_mask,
+            VkPipelineStageFlags dst_stage_mask,
+            VkDependencyFlags dependency_flags,
+            const std::vector<BufferMemoryBarrier>& buffer_memory_barriers,
+            const std::vector<ImageMemoryBarrier>& image_memory_barriers
+        );
+
+        // provided by VK_KHR_synchronization2 (core in Vulkan 1.3). the
+        // synchronization2 feature must be enabled in DeviceConfig.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdPipelineBarrier2.html
+        void pipeline_barrier2(const DependencyInfo& dependency_info);
+
+        // queries must be reset before they're used, outside of a render pass
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdResetQueryPool.html
+        void reset_query_pool(
+            const QueryPoolPtr& query_pool,
+            uint32_t first_query,
+            uint32_t query_count
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdWriteTimestamp.html
+        void write_timestamp(
+            VkPipelineStageFlagBits stage,
+            const QueryPoolPtr& query_pool,
+            uint32_t query
+        );
+
+        // for occlusion and pipeline statistics queries
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdBeginQuery.html
+        void begin_query(
+            const QueryPoolPtr& query_pool,
+            uint32_t query,
+            VkQueryControlFlags flags = 0
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdEndQuery.html
+        void end_query(const QueryPoolPtr& query_pool, uint32_t query);
+
+        // render directly to image views without a RenderPass or Framebuffer.
+        // provided by VK_KHR_dynamic_rendering (core in Vulkan 1.3). the
+        // dynamicRendering feature must be enabled in DeviceConfig.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdBeginRendering.html
+        void begin_rendering(const RenderingInfo& rendering_info);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdEndRendering.html
+        void end_rendering();
+
+        // attachments must be provided if and only if the framebuffer is
+        // imageless, in which case VkRenderPassAttachmentBeginInfo is used to
+        // pass them.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdBeginRenderPass.html
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkRenderPassAttachmentBeginInfo.html
+        void begin_render_pass(
+            const RenderPassPtr& render_pass,
+            const FramebufferPtr& framebuffer,
+            const Rect2d& render_area,
+            const std::vector<VkClearValue>& clear_values,
+            VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE,
+            const std::vector<ImageViewPtr>& attachments = {}
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdEndRenderPass.html
+        void end_render_pass();
+
+        // the commands below set state that's declared dynamic in the bound
+        // pipeline's GraphicsPipelineConfig::dynamic_states. they're provided
+        // by VK_EXT_extended_dynamic_state, VK_EXT_extended_dynamic_state2
+        // (both core in Vulkan 1.3), VK_EXT_extended_dynamic_state3, and
+        // VK_EXT_vertex_input_dynamic_state, see DeviceConfig. an Error is
+        // thrown if the command isn't available.
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetCullMode.html
+        void set_cull_mode(VkCullModeFlags cull_mode);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetFrontFace.html
+        void set_front_face(VkFrontFace front_face);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetPrimitiveTopology.html
+        void set_primitive_topology(VkPrimitiveTopology topology);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetViewportWithCount.html
+        void set_viewport_with_count(const std::vector<Viewport>& viewports);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetScissorWithCount.html
+        void set_scissor_with_count(const std::vector<Rect2d>& scissors);
+
+        // sizes and strides can be empty. strides must only be provided if
+        // VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE is dynamic.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdBindVertexBuffers2.html
+        void bind_vertex_buffers2(
+            uint32_t first_binding,
+            const std::vector<BufferPtr>& buffers,
+            const std::vector<VkDeviceSize>& offsets,
+            const std::vector<VkDeviceSize>& sizes = {},
+            const std::vector<VkDeviceSize>& strides = {}
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthTestEnable.html
+        void set_depth_test_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthWriteEnable.html
+        void set_depth_write_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthCompareOp.html
+        void set_depth_compare_op(VkCompareOp compare_op);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthBoundsTestEnable.html
+        void set_depth_bounds_test_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetStencilTestEnable.html
+        void set_stencil_test_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetStencilOp.html
+        void set_stencil_op(
+            VkStencilFaceFlags face_mask,
+            VkStencilOp fail_op,
+            VkStencilOp pass_op,
+            VkStencilOp depth_fail_op,
+            VkCompareOp compare_op
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetRasterizerDiscardEnable.html
+        void set_rasterizer_discard_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthBiasEnable.html
+        void set_depth_bias_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetPrimitiveRestartEnable.html
+        void set_primitive_restart_enable(bool enable);
+
+        // needs extended_dynamic_state2_logic_op
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetLogicOpEXT.html
+        void set_logic_op(VkLogicOp logic_op);
+
+        // needs extended_dynamic_state2_patch_control_points
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetPatchControlPointsEXT.html
+        void set_patch_control_points(uint32_t patch_control_points);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetDepthClampEnableEXT.html
+        void set_depth_clamp_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetPolygonModeEXT.html
+        void set_polygon_mode(VkPolygonMode polygon_mode);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetRasterizationSamplesEXT.html
+        void set_rasterization_samples(VkSampleCountFlagBits samples);
+
+        // sample_mask must have (samples + 31) / 32 elements
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetSampleMaskEXT.html
+        void set_sample_mask(
+            VkSampleCountFlagBits samples,
+            const std::vector<VkSampleMask>& sample_mask
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetAlphaToCoverageEnableEXT.html
+        void set_alpha_to_coverage_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetAlphaToOneEnableEXT.html
+        void set_alpha_to_one_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetLogicOpEnableEXT.html
+        void set_logic_op_enable(bool enable);
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetColorBlendEnableEXT.html
+        void set_color_blend_enable(
+            uint32_t first_attachment,
+            const std::vector<bool>& enables
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetColorBlendEquationEXT.html
+        void set_color_blend_equation(
+            uint32_t first_attachment,
+            const std::vector<ColorBlendEquation>& equations
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetColorWriteMaskEXT.html
+        void set_color_write_mask(
+            uint32_t first_attachment,
+            const std::vector<VkColorComponentFlags>& masks
+        );
+
+        // replaces the vertex input state of pipelines that have
+        // VK_DYNAMIC_STATE_VERTEX_INPUT_EXT so their
+        // GraphicsPipelineConfig::vertex_input_state can be left empty. the
+        // instance rate divisor of every binding is 1.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkCmdSetVertexInputEXT.html
+        void set_vertex_input(const VertexInputState& state);
+
         ~CommandBuffer();
 
     protected:
         CommandPoolWPtr _pool;
         VkCommandBuffer _handle;
 
+        std::shared_ptr<const DeviceDispatch> _dispatch;
+
+        // reused between begin_rendering() and begin_render_pass() calls so
+        // that recording doesn't allocate every time. command buffers are
+        // externally synchronized so these don't need a lock.
+        std::vector<VkRenderingAttachmentInfo> scratch_vk_color_attachments;
+        std::vector<VkImageView> scratch_vk_attachments;
+
         CommandBuffer(
             const CommandPoolWPtr& pool,
-            VkCommandBuffer handle
+            VkCommandBuffer handle,
+            const std::shared_ptr<const DeviceDispatch>& dispatch
         );
 
     };
@@ -6433,6 +8183,139 @@ namespace bv
 
     };
 
+    // provided by VK_KHR_timeline_semaphore (core in Vulkan 1.2). the
+    // timelineSemaphore feature must be enabled in DeviceConfig. a timeline
+    // semaphore can be passed anywhere a Semaphore is expected, use the value
+    // fields in Queue::submit() or SemaphoreSubmitInfo to wait for or signal a
+    // specific value.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSemaphoreTypeCreateInfo.html
+    class TimelineSemaphore : public Semaphore
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(TimelineSemaphore);
+
+        static TimelineSemaphorePtr create(
+            const DevicePtr& device,
+            uint64_t initial_value = 0
+        );
+
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetSemaphoreCounterValue.html
+        uint64_t counter_value() const;
+
+        // signal the semaphore from the host
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkSignalSemaphore.html
+        void signal(uint64_t value);
+
+        // wait until the counter value is at least the provided value
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkWaitSemaphores.html
+        void wait(
+            uint64_t value,
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // all provided semaphores must be from the same device. there must be
+        // one value per semaphore.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkWaitSemaphores.html
+        static void wait_multiple(
+            const std::vector<TimelineSemaphorePtr>& semaphores,
+            const std::vector<uint64_t>& values,
+            bool wait_all,
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // time spent in wait() and wait_multiple()
+        StallStats stall_stats() const
+        {
+            return _stall_counter.stats();
+        }
+
+    protected:
+        StallCounter _stall_counter;
+
+        TimelineSemaphore(const DevicePtr& device);
+
+    };
+
+    // paces frames in flight with a single timeline semaphore instead of one
+    // fence per frame. frame number N must signal the timeline with the value
+    // N + 1 (see signal_value()) in its last submission. begin_frame() then
+    // waits for frame N - frames_in_flight to finish before its resources
+    // (the ones at frame_idx()) are reused, and there's nothing to reset.
+    class FramePacer
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(FramePacer);
+
+        static FramePacerPtr create(
+            const DevicePtr& device,
+            uint32_t frames_in_flight
+        );
+
+        constexpr uint32_t frames_in_flight() const
+        {
+            return _frames_in_flight;
+        }
+
+        constexpr const TimelineSemaphorePtr& timeline() const
+        {
+            return _timeline;
+        }
+
+        // number of frames ended so far
+        constexpr uint64_t frame_number() const
+        {
+            return _frame_number;
+        }
+
+        // index of the current frame in flight
+        constexpr uint32_t frame_idx() const
+        {
+            return (uint32_t)(_frame_number % _frames_in_flight);
+        }
+
+        // the value the current frame must signal the timeline with
+        constexpr uint64_t signal_value() const
+        {
+            return _frame_number + 1;
+        }
+
+        // wait until the resources at frame_idx() are no longer in use.
+        // returns frame_idx().
+        uint32_t begin_frame(
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // move on to the next frame. only call this if work signaling
+        // signal_value() was submitted, otherwise later frames will wait on a
+        // value that never gets signaled. it's fine to skip a frame by not
+        // calling this at all.
+        void end_frame();
+
+        // wait for every frame that was ended so far to finish
+        void wait_all(
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+    protected:
+        uint32_t _frames_in_flight;
+        TimelineSemaphorePtr _timeline;
+        uint64_t _frame_number = 0;
+
+        FramePacer(
+            uint32_t frames_in_flight,
+            const TimelineSemaphorePtr& timeline
+        );
+
+    };
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFence.html
     class Fence
     {
@@ -6455,7 +8338,20 @@ namespace bv
         }
 
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkWaitForFences.html
-        void wait(uint64_t timeout = UINT64_MAX);
+        void wait(
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
+
+        // same as wait() but returns the result of vkWaitForFences() (like
+        // VK_TIMEOUT) instead of throwing. still throws if the device has
+        // been destroyed.
+        VkResult try_wait(
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
+        );
 
         // all provided fences must be from the same device, bad things might
         // happen otherwise.
@@ -6463,7 +8359,9 @@ namespace bv
         static void wait_multiple(
             const std::vector<FencePtr>& fences,
             bool wait_all,
-            uint64_t timeout = UINT64_MAX
+            uint64_t timeout = UINT64_MAX,
+            const std::source_location& location =
+            std::source_location::current()
         );
 
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkResetFences.html
@@ -6472,6 +8370,12 @@ namespace bv
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetFenceStatus.html
         bool is_signaled() const;
 
+        // time spent in wait() and wait_multiple()
+        StallStats stall_stats() const
+        {
+            return _stall_counter.stats();
+        }
+
         ~Fence();
 
     protected:
@@ -6479,6 +8383,8 @@ namespace bv
 
         VkFence _handle = nullptr;
 
+        StallCounter _stall_counter;
+
         Fence(const DevicePtr& device);
 
     };
@@ -6743,6 +8649,31 @@ namespace bv
 
     };
 
+    // pipeline creation feedback of the pipelines created with a
+    // PipelineCache. only pipelines created on a device with
+    // VK_EXT_pipeline_creation_feedback enabled or Vulkan 1.3 are counted.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineCreationFeedback.html
+    struct PipelineCacheStats
+    {
+        uint64_t n_pipelines = 0;
+
+        // pipelines that didn't need to be compiled because the cache
+        // already had them
+        uint64_t n_hits = 0;
+
+        uint64_t total_creation_ns = 0;
+
+        constexpr double hit_rate() const
+        {
+            return n_pipelines == 0 ? 0. : (double)n_hits / n_pipelines;
+        }
+
+        constexpr double total_creation_ms() const
+        {
+            return (double)total_creation_ns * 1e-6;
+        }
+    };
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineCache.html
     class PipelineCache
     {
@@ -6752,12 +8683,32 @@ namespace bv
         static PipelineCachePtr create(
             const DevicePtr& device,
             VkPipelineCacheCreateFlags flags,
-            const std::vector<uint8_t>& initial_data
+            std::span<const uint8_t> initial_data
         );
 
-        constexpr const DeviceWPtr& device() const
-        {
-            return _device;
+        // create a pipeline cache from a file written by save(). the file is
+        // memory mapped while the driver reads it. if it doesn't exist or
+        // wasn't written for this physical device and driver (see
+        // is_compatible()), an empty cache is created instead.
+        static PipelineCachePtr load(
+            const DevicePtr& device,
+            const std::string& path,
+            VkPipelineCacheCreateFlags flags = 0
+        );
+
+        // whether the header of the cache data matches the vendor ID, device
+        // ID, and pipeline cache UUID of the physical device. drivers should
+        // reject incompatible data on their own, but not all of them do it
+        // gracefully.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineCacheHeaderVersionOne.html
+        static bool is_compatible(
+            const PhysicalDevice& physical_device,
+            std::span<const uint8_t> data
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
         }
 
         constexpr VkPipelineCacheCreateFlags flags() const
@@ -6773,6 +8724,26 @@ namespace bv
         // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetPipelineCacheData.html
         std::vector<uint8_t> get_cache_data();
 
+        // write get_cache_data() to a temporary file next to path and then
+        // rename it to path, so that the file is never left half-written.
+        void save(const std::string& path);
+
+        // merge other caches (usually from worker threads that created
+        // pipelines in parallel) into this one, along with their stats.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkMergePipelineCaches.html
+        void merge(const std::vector<PipelineCachePtr>& src_caches);
+
+        // stats of the pipelines created with this cache since it was created
+        // or since the last reset_stats()
+        PipelineCacheStats stats() const;
+
+        void reset_stats();
+
+        // used by pipeline creation
+        void add_creation_feedback(
+            const VkPipelineCreationFeedback& feedback
+        );
+
         ~PipelineCache();
 
     protected:
@@ -6781,6 +8752,9 @@ namespace bv
 
         VkPipelineCache _handle = nullptr;
 
+        PipelineCacheStats _stats;
+        std::shared_ptr<std::mutex> stats_mutex;
+
         PipelineCache(
             const DevicePtr& device,
             VkPipelineCacheCreateFlags flags
@@ -6788,6 +8762,352 @@ namespace bv
 
     };
 
+    // creates pipelines on a pool of worker threads. during each call, every
+    // worker that picks up a pipeline gets its own PipelineCache, seeded with
+    // the data of the target cache, so the workers don't contend on a single
+    // cache. the worker caches are merged into the target cache when the call
+    // returns.
+    class PipelineCompiler
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(PipelineCompiler);
+
+        // if n_threads is 0, std::thread::hardware_concurrency() threads are
+        // used. cache can be nullptr.
+        static PipelineCompilerPtr create(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache = nullptr,
+            uint32_t n_threads = 0
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const PipelineCacheWPtr& cache() const
+        {
+            return _cache;
+        }
+
+        uint32_t n_threads() const
+        {
+            return (uint32_t)threads.size();
+        }
+
+        // create the pipelines in parallel and block until they're all done.
+        // the pipelines are returned in the same order as their configs. if
+        // any of them fails, the first error is thrown after the rest are
+        // done. the cache() of the returned pipelines is cache(), which the
+        // worker caches they were created with have been merged into.
+        std::vector<GraphicsPipelinePtr> create_graphics_pipelines(
+            const std::vector<GraphicsPipelineConfig>& configs
+        );
+
+        std::vector<ComputePipelinePtr> create_compute_pipelines(
+            const std::vector<ComputePipelineConfig>& configs
+        );
+
+        ~PipelineCompiler();
+
+    protected:
+        using Job = std::function<void(
+            size_t job_idx,
+            const PipelineCachePtr& worker_cache
+        )>;
+
+        // shared with the worker threads so that the compiler can be moved
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::deque<std::function<void(uint32_t worker_idx)>> jobs;
+            bool stop = false;
+        };
+
+        DeviceWPtr _device;
+        PipelineCacheWPtr _cache;
+
+        std::shared_ptr<WorkQueue> work_queue;
+        std::vector<std::thread> threads;
+
+        PipelineCompiler(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache,
+            uint32_t n_threads
+        );
+
+        // run n_jobs jobs on the workers and wait for them to finish
+        void run(size_t n_jobs, const Job& job);
+
+    };
+
+    // a pipeline config flattened into words, with the objects it refers to
+    // replaced by identifying values: shader modules by their code_hash()
+    // and other objects by their address (not their handle, since distinct
+    // non-dispatchable objects may share a handle). configs with equal keys
+    // create equivalent pipelines. the objects have to be alive when the key
+    // is made, and since addresses can be reused after an object is
+    // destroyed, keys are only meaningful while those objects are alive.
+    struct PipelineStateKey
+    {
+        std::vector<uint64_t> words;
+        uint64_t hash = 0;
+
+        bool operator==(const PipelineStateKey& other) const = default;
+    };
+
+    struct PipelineStateKeyHash
+    {
+        size_t operator()(const PipelineStateKey& key) const
+        {
+            return (size_t)key.hash;
+        }
+    };
+
+    PipelineStateKey GraphicsPipelineConfig_key(
+        const GraphicsPipelineConfig& config
+    );
+
+    PipelineStateKey ComputePipelineConfig_key(
+        const ComputePipelineConfig& config
+    );
+
+    // returns an existing pipeline if an equivalent one (see
+    // PipelineStateKey) was already created through the registry, so that
+    // permutations which end up with the same state are only compiled once.
+    // graphics pipelines are created from the config with its dynamic state
+    // stripped (see GraphicsPipelineConfig_strip_dynamic_state()), so the
+    // config() of a returned pipeline has the dynamic state reset.
+    // the registry doesn't keep pipelines alive, call prune() every now and
+    // then to drop the entries of destroyed ones. this is thread-safe.
+    class PipelineRegistry
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(PipelineRegistry);
+
+        // cache is used when a pipeline has to be created and can be nullptr
+        static PipelineRegistryPtr create(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache = nullptr
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const PipelineCacheWPtr& cache() const
+        {
+            return _cache;
+        }
+
+        GraphicsPipelinePtr get_graphics_pipeline(
+            const GraphicsPipelineConfig& config
+        );
+
+        ComputePipelinePtr get_compute_pipeline(
+            const ComputePipelineConfig& config
+        );
+
+        // remove the entries of pipelines that were destroyed
+        void prune();
+
+        // number of pipelines that were requested again and reused
+        uint64_t n_reused() const;
+
+        size_t size() const;
+
+    protected:
+        DeviceWPtr _device;
+        PipelineCacheWPtr _cache;
+
+        std::unordered_map<
+            PipelineStateKey,
+            GraphicsPipelineWPtr,
+            PipelineStateKeyHash
+        > graphics_pipelines;
+
+        std::unordered_map<
+            PipelineStateKey,
+            ComputePipelineWPtr,
+            PipelineStateKeyHash
+        > compute_pipelines;
+
+        uint64_t _n_reused = 0;
+        std::shared_ptr<std::mutex> mutex;
+
+        PipelineRegistry(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache
+        );
+
+    };
+
+    // builds graphics pipelines out of graphics pipeline libraries so that
+    // new pipelines can be used right away without a compilation hitch.
+    // get() splits a config into its four library parts, creates the ones
+    // that weren't created before (parts are shared between configs), and
+    // links them without link time optimization, which is quick. a fully
+    // optimized pipeline is then linked from the same libraries on a
+    // background thread, and get() returns it instead once it's done. the
+    // linker keeps its libraries and pipelines alive until prune() or
+    // clear(). needs DeviceConfig::enable_graphics_pipeline_library.
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VK_EXT_graphics_pipeline_library.html
+    class PipelineLibraryLinker
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(PipelineLibraryLinker);
+
+        // cache is used for the libraries and both linked pipelines and can
+        // be nullptr
+        static PipelineLibraryLinkerPtr create(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache = nullptr
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const PipelineCacheWPtr& cache() const
+        {
+            return _cache;
+        }
+
+        // returns the optimized pipeline if it's ready and the fast-linked
+        // one otherwise. call this every time the pipeline is bound so that
+        // the optimized pipeline is picked up.
+        GraphicsPipelinePtr get(const GraphicsPipelineConfig& config);
+
+        // block until every queued optimized pipeline has been linked
+        void wait_idle();
+
+        // number of optimized pipelines that are still being linked
+        size_t n_pending() const;
+
+        // remove the libraries and pipelines whose layout or render pass was
+        // destroyed
+        void prune();
+
+        void clear();
+
+        size_t size() const;
+
+        ~PipelineLibraryLinker();
+
+    protected:
+        // optimized is nullptr until the background thread is done with it.
+        // shared with the background thread so that the linker can be moved.
+        struct LinkedPipeline
+        {
+            GraphicsPipelinePtr fast;
+            GraphicsPipelinePtr optimized;
+        };
+
+        struct BackgroundQueue
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::condition_variable idle_cv;
+            std::deque<std::function<void()>> jobs;
+            size_t n_pending = 0;
+            bool stop = false;
+        };
+
+        DeviceWPtr _device;
+        PipelineCacheWPtr _cache;
+
+        std::unordered_map<
+            PipelineStateKey,
+            GraphicsPipelinePtr,
+            PipelineStateKeyHash
+        > libraries;
+
+        std::unordered_map<
+            PipelineStateKey,
+            std::shared_ptr<LinkedPipeline>,
+            PipelineStateKeyHash
+        > pipelines;
+
+        std::shared_ptr<std::mutex> mutex;
+
+        std::shared_ptr<BackgroundQueue> background_queue;
+        std::thread background_thread;
+
+        PipelineLibraryLinker(
+            const DevicePtr& device,
+            const PipelineCachePtr& cache
+        );
+
+        GraphicsPipelinePtr get_library(
+            const GraphicsPipelineConfig& config,
+            VkGraphicsPipelineLibraryFlagBitsEXT part
+        );
+
+    };
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkQueryPool.html
+    class QueryPool
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(QueryPool);
+
+        static QueryPoolPtr create(
+            const DevicePtr& device,
+            const QueryPoolConfig& config
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const QueryPoolConfig& config() const
+        {
+            return _config;
+        }
+
+        constexpr VkQueryPool handle() const
+        {
+            return _handle;
+        }
+
+        // number of values a single query produces. this is the number of
+        // enabled statistics for pipeline statistics queries and 1 otherwise.
+        uint32_t values_per_query() const;
+
+        // read the results of query_count queries starting at first_query
+        // into results as 64-bit values (VK_QUERY_RESULT_64_BIT is always
+        // added to flags). every query takes values_per_query() values, plus
+        // one if VK_QUERY_RESULT_WITH_AVAILABILITY_BIT is in flags, and
+        // results must have room for all of them. returns false if some of
+        // the results weren't available yet (VK_NOT_READY), which can't happen
+        // with VK_QUERY_RESULT_WAIT_BIT.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetQueryPoolResults.html
+        bool get_results(
+            uint32_t first_query,
+            uint32_t query_count,
+            std::span<uint64_t> results,
+            VkQueryResultFlags flags = 0
+        );
+
+        ~QueryPool();
+
+    protected:
+        DeviceWPtr _device;
+        QueryPoolConfig _config;
+
+        VkQueryPool _handle = nullptr;
+
+        QueryPool(
+            const DevicePtr& device,
+            const QueryPoolConfig& config
+        );
+
+    };
+
 #pragma endregion
 
 #pragma region helper functions
@@ -6837,6 +9157,7 @@ namespace bv
         bv::DeviceMemoryPtr mem;
         sul::dynamic_bitset<> blocks; // for each block: 0 = free, 1 = allocated
         void* mapped = nullptr;
+        bool coherent = false;
 
         MemoryRegion(const bv::DeviceMemoryPtr& mem);
 
@@ -6868,6 +9189,15 @@ namespace bv
         void* mapped();
         void flush();
 
+        // invalidate a range (relative to the chunk) of mapped memory so that
+        // device writes become visible to the host. the range is expanded to
+        // the device's nonCoherentAtomSize. does nothing if the memory is
+        // host coherent or not mapped.
+        void invalidate(
+            VkDeviceSize offset = 0,
+            VkDeviceSize size = VK_WHOLE_SIZE
+        );
+
         ~MemoryChunk();
 
     protected:
@@ -6913,9 +9243,13 @@ namespace bv
             return _min_region_size;
         }
 
+        // preferred_properties are only used if a compatible memory type has
+        // them in addition to the required ones (like
+        // VK_MEMORY_PROPERTY_HOST_CACHED_BIT for memory the host reads from).
         MemoryChunkPtr allocate(
             const bv::MemoryRequirements& requirements,
-            VkMemoryPropertyFlags required_properties
+            VkMemoryPropertyFlags required_properties,
+            VkMemoryPropertyFlags preferred_properties = 0
         );
 
         // returns a string description of its status including the regions
@@ -6943,4 +9277,1153 @@ namespace bv
 
 #pragma endregion
 
+#pragma region render graph
+
+    // index of an image added to a RenderGraph
+    using RenderGraphImageId = uint32_t;
+
+    // index of a pass added to a RenderGraph
+    using RenderGraphPassId = uint32_t;
+
+    // how a pass uses an image. this decides the image layout, the pipeline
+    // stages and the access masks the render graph will use for barriers.
+    enum class RenderGraphAccess : uint8_t
+    {
+        ColorAttachment,
+        DepthStencilAttachment,
+        InputAttachment,
+        Sampled,
+        StorageRead,
+        StorageWrite,
+        StorageReadWrite,
+        TransferSrc,
+        TransferDst
+    };
+
+    // an image created and owned by the render graph. its contents are only
+    // meant to live within a single execution of the graph, which is what
+    // allows the graph to alias its memory with other transient images.
+    struct RenderGraphTransientImage
+    {
+        std::string name;
+        VkFormat format;
+        Extent2d extent;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    };
+
+    // an image owned by the user, like a swapchain image. the view can be
+    // changed between executions with RenderGraph::set_imported_view().
+    // imported images are assumed to either be accessed by a single queue
+    // family within the graph or use VK_SHARING_MODE_CONCURRENT.
+    struct RenderGraphImportedImage
+    {
+        std::string name;
+        VkFormat format;
+        Extent2d extent;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+        // the layout the image is in before the graph is executed and the
+        // pipeline stages that must finish before it can be used. for
+        // swapchain images, initial_stages should match the wait stage of the
+        // semaphore passed to acquire_next_image().
+        VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initial_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+        // the layout the image will be left in after the graph is executed
+        VkImageLayout final_layout;
+    };
+
+    struct RenderGraphImageAccess
+    {
+        RenderGraphImageId image;
+        RenderGraphAccess access;
+
+        // pipeline stages reading or writing the image. only used for
+        // Sampled and Storage* accesses. if 0, the fragment shader stage will
+        // be used in graphics passes and the compute shader stage in compute
+        // passes.
+        VkPipelineStageFlags stages = 0;
+
+        // only used for ColorAttachment and DepthStencilAttachment. the store
+        // op is decided by the graph based on whether the contents are used
+        // afterwards.
+        VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        VkClearValue clear_value{};
+    };
+
+    // graphics passes with attachments are recorded inside their subpass.
+    // other passes are recorded outside of any render pass.
+    using RenderGraphRecordFunc =
+        std::function<void(const CommandBufferPtr& cmd_buf)>;
+
+    struct RenderGraphPass
+    {
+        std::string name;
+
+        // VK_QUEUE_GRAPHICS_BIT or VK_QUEUE_COMPUTE_BIT
+        VkQueueFlagBits queue = VK_QUEUE_GRAPHICS_BIT;
+
+        // color attachments get their locations in the order they appear in
+        std::vector<RenderGraphImageAccess> accesses;
+
+        // passes are culled when nothing uses what they write. set this if
+        // the pass does something the graph can't see, like writing to a
+        // buffer.
+        bool has_side_effects = false;
+
+        RenderGraphRecordFunc record;
+    };
+
+    struct RenderGraphConfig
+    {
+        QueueWPtr graphics_queue;
+
+        // compute passes will run on the graphics queue if this is expired
+        // or refers to the same queue
+        QueueWPtr compute_queue;
+
+        // number of command buffers and semaphores to keep for each batch of
+        // passes, the frame index passed to execute() must be smaller than
+        // this.
+        uint32_t frames_in_flight;
+    };
+
+    // a render graph (also known as a frame graph) sits on top of the object
+    // wrappers and is built from passes that declare which images they read
+    // and write. compile() then does the following:
+    // 1. culls passes whose results are never used
+    // 2. merges consecutive graphics passes that only share images as
+    //    attachments into subpasses of a single render pass
+    // 3. creates the transient images and aliases the memory of the ones with
+    //    non-overlapping lifetimes
+    // 4. plans the layout transitions, barriers, and subpass dependencies
+    //    between passes, as well as load and store ops
+    // 5. groups passes running on the same queue into batches and connects
+    //    batches on different queues with semaphores
+    // execute() then records and submits the batches. passes must be added
+    // in a valid execution order, images are read from whatever pass last
+    // wrote to them before the reading pass was added.
+    class RenderGraph
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(RenderGraph);
+
+        static RenderGraphPtr create(
+            const DevicePtr& device,
+            const MemoryBankPtr& mem_bank,
+            const RenderGraphConfig& config
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const RenderGraphConfig& config() const
+        {
+            return _config;
+        }
+
+        constexpr bool compiled() const
+        {
+            return _compiled;
+        }
+
+        RenderGraphImageId add_transient_image(
+            const RenderGraphTransientImage& image
+        );
+
+        RenderGraphImageId import_image(const RenderGraphImportedImage& image);
+
+        RenderGraphPassId add_pass(const RenderGraphPass& pass);
+
+        // remove all images and passes and destroy everything compile()
+        // created. the device must not be using any of it.
+        void reset();
+
+        // this must be called after adding images and passes and before
+        // execute(). call reset() and rebuild the graph if anything changes,
+        // like the swapchain extent. the device must not be using the objects
+        // created by a previous compilation.
+        void compile();
+
+        // the view must have been created from an image with the format and
+        // extent declared in import_image(). if the device has the
+        // imagelessFramebuffer feature enabled, the views of an imported
+        // image must also all come from images with the same create info,
+        // like the images of a single swapchain.
+        void set_imported_view(
+            RenderGraphImageId image,
+            const ImageViewPtr& view
+        );
+
+        // only valid after compile(). returns nullptr for culled or imported
+        // images.
+        ImagePtr image(RenderGraphImageId image) const;
+
+        // only valid after compile(). returns nullptr for culled transient
+        // images.
+        ImageViewPtr image_view(RenderGraphImageId image) const;
+
+        // only valid after compile(). the render pass and subpass index a
+        // graphics pass ended up in, which is needed for creating graphics
+        // pipelines. returns nullptr for culled passes and passes without
+        // attachments.
+        RenderPassPtr render_pass(RenderGraphPassId pass) const;
+        uint32_t subpass_index(RenderGraphPassId pass) const;
+
+        // only valid after compile()
+        bool is_culled(RenderGraphPassId pass) const;
+
+        // record and submit all batches. the first batch on the graphics queue
+        // waits on wait_semaphores and the last batch signals
+        // signal_semaphores and signal_fence. you need to make sure the
+        // command buffers of frame_idx are no longer in use, usually by
+        // waiting on the fence used the last time frame_idx was executed.
+        void execute(
+            uint32_t frame_idx,
+            const std::vector<VkPipelineStageFlags>& wait_stages,
+            const std::vector<SemaphorePtr>& wait_semaphores,
+            const std::vector<SemaphorePtr>& signal_semaphores,
+            const FencePtr& signal_fence = nullptr
+        );
+
+        // returns a string description of the compiled graph including the
+        // physical passes, the batches, and memory aliasing
+        std::string to_string() const;
+
+        ~RenderGraph();
+
+    protected:
+        struct ImageNode
+        {
+            std::string name;
+            VkFormat format;
+            Extent2d extent;
+            VkSampleCountFlagBits samples;
+            bool imported;
+
+            // only used for imported images
+            VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags initial_stages = 0;
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            ImageViewPtr imported_view = nullptr;
+
+            // the following are filled by compile()
+            ImagePtr image = nullptr;
+            ImageViewPtr view = nullptr;
+            VkImageUsageFlags usage = 0;
+            int32_t memory_slot = -1;
+            int32_t first_physical_pass = -1;
+            int32_t last_physical_pass = -1;
+        };
+
+        struct ImageState
+        {
+            VkImageLayout layout;
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            int32_t batch;
+        };
+
+        struct Barrier
+        {
+            RenderGraphImageId image;
+            VkImageLayout old_layout;
+            VkImageLayout new_layout;
+            VkPipelineStageFlags src_stages;
+            VkPipelineStageFlags dst_stages;
+            VkAccessFlags src_access;
+            VkAccessFlags dst_access;
+        };
+
+        // a framebuffer for one combination of attachment views. the views
+        // are weak so that entries of destroyed views can be recognized and
+        // evicted, even if their handle values have been reused since.
+        struct CachedFramebuffer
+        {
+            std::vector<ImageViewWPtr> views;
+            FramebufferPtr framebuf;
+        };
+
+        struct PhysicalPass
+        {
+            std::vector<RenderGraphPassId> passes;
+            uint32_t batch = 0;
+
+            std::vector<Barrier> barriers_before;
+            std::vector<Barrier> barriers_after;
+
+            // only for passes with attachments
+            RenderPassPtr render_pass = nullptr;
+            std::vector<RenderGraphImageId> attachments;
+            std::vector<VkClearValue> clear_values;
+            Extent2d extent{};
+            std::vector<CachedFramebuffer> framebufs;
+
+            // used instead of framebufs when the device has the
+            // imagelessFramebuffer feature enabled
+            FramebufferPtr imageless_framebuf = nullptr;
+        };
+
+        struct Batch
+        {
+            QueuePtr queue = nullptr;
+            std::vector<uint32_t> physical_passes;
+            std::vector<uint32_t> wait_edges;
+            std::vector<uint32_t> signal_edges;
+
+            // per frame in flight
+            std::vector<CommandBufferPtr> cmd_bufs;
+        };
+
+        // a semaphore dependency between two batches on different queues
+        struct Edge
+        {
+            uint32_t src_batch;
+            uint32_t dst_batch;
+
+            // per frame in flight
+            std::vector<SemaphorePtr> semaphores;
+        };
+
+        struct MemorySlot
+        {
+            MemoryRequirements requirements;
+            uint32_t batch;
+            std::vector<RenderGraphImageId> images;
+            MemoryChunkPtr chunk = nullptr;
+        };
+
+        DeviceWPtr _device;
+        MemoryBankWPtr _mem_bank;
+        RenderGraphConfig _config;
+
+        std::vector<ImageNode> images;
+        std::vector<RenderGraphPass> passes;
+
+        bool _compiled = false;
+        std::vector<bool> culled;
+        std::vector<int32_t> pass_to_physical;
+        std::vector<uint32_t> pass_to_subpass;
+        std::vector<PhysicalPass> physical_passes;
+        std::vector<Batch> batches;
+        std::vector<Edge> edges;
+        std::vector<MemorySlot> memory_slots;
+        std::vector<CommandPoolPtr> cmd_pools;
+        std::vector<ImageState> frame_start_states;
+
+        // semaphores that make the root batches of a frame wait for the last
+        // batch of the previous frame when more than one queue is used. one
+        // vector per root batch, one semaphore per frame in flight.
+        std::vector<std::vector<SemaphorePtr>> frame_chain_semaphs;
+        std::vector<uint32_t> root_batches;
+        std::optional<uint32_t> last_frame_idx;
+
+        RenderGraph(
+            const DevicePtr& device,
+            const MemoryBankPtr& mem_bank,
+            const RenderGraphConfig& config
+        );
+
+        QueuePtr queue_for(const RenderGraphPass& pass) const;
+        bool can_merge(
+            const PhysicalPass& phys,
+            RenderGraphPassId pass
+        ) const;
+        void add_edge(uint32_t src_batch, uint32_t dst_batch);
+
+        void destroy_compiled_objects();
+        void cull_passes();
+        void build_physical_passes();
+        void build_batches();
+        void create_images();
+        void plan_physical_passes();
+        void create_sync_objects();
+
+        VkImage vk_image_of(RenderGraphImageId image) const;
+        VkImageView vk_view_of(RenderGraphImageId image) const;
+
+        void record_barriers(
+            const CommandBufferPtr& cmd_buf,
+            const std::vector<Barrier>& barriers
+        ) const;
+
+        void record_physical_pass(
+            const CommandBufferPtr& cmd_buf,
+            PhysicalPass& phys
+        );
+
+    };
+
+#pragma endregion
+
+#pragma region staging ring
+
+    // a host visible buffer that UploadEngine and ReadbackEngine use as a ring
+    // of staging memory. allocations are pending until submit() closes them
+    // into a batch, and batches are retired in the order they were submitted
+    // once the device is done with them.
+    class StagingRing
+    {
+    public:
+        StagingRing() = default;
+
+        StagingRing(
+            const DevicePtr& device,
+            const MemoryBankPtr& mem_bank,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags required_mem_props,
+            VkMemoryPropertyFlags preferred_mem_props = 0
+        );
+
+        constexpr const BufferPtr& buffer() const
+        {
+            return _buffer;
+        }
+
+        constexpr const MemoryChunkPtr& memory() const
+        {
+            return _memory;
+        }
+
+        constexpr uint8_t* mapped() const
+        {
+            return _mapped;
+        }
+
+        constexpr VkDeviceSize size() const
+        {
+            return _size;
+        }
+
+        // reserve size bytes and return their offset in the buffer. while the
+        // ring is full, make_room is called and it must submit or retire a
+        // batch.
+        VkDeviceSize allocate(
+            VkDeviceSize size,
+            const std::function<void()>& make_room
+        );
+
+        // close the pending allocations into a batch (possibly an empty one)
+        void submit();
+
+        // free the oldest submitted batch
+        void retire();
+
+    protected:
+        BufferPtr _buffer = nullptr;
+        MemoryChunkPtr _memory = nullptr;
+        uint8_t* _mapped = nullptr;
+        VkDeviceSize _size = 0;
+
+        // in the unwrapped (ever increasing) address space. physical offsets
+        // are these modulo the size.
+        VkDeviceSize head = 0;
+        VkDeviceSize pending_begin = 0;
+        bool has_pending = false;
+
+        // where each submitted batch begins, oldest first
+        std::deque<VkDeviceSize> batch_begins;
+
+    };
+
+#pragma endregion
+
+#pragma region upload engine
+
+    struct UploadEngineConfig
+    {
+        // preferably a queue from a family that supports transfers but not
+        // graphics so that uploads don't compete with rendering. find one with
+        // PhysicalDevice::find_queue_family_indices(VK_QUEUE_TRANSFER_BIT,
+        // VK_QUEUE_GRAPHICS_BIT), but any queue will work.
+        QueueWPtr transfer_queue;
+
+        // the queue that will use the uploaded resources. if it's from a
+        // different queue family than transfer_queue, ownership of the
+        // destination buffers and images is transferred to its family by an
+        // acquire submission on this queue after each flush. if this is
+        // expired, no ownership transfers will happen and the resources must
+        // either use VK_SHARING_MODE_CONCURRENT or be used by the transfer
+        // queue's family. Vulkan requires submissions to a queue to be
+        // externally synchronized, so while flush() or wait_idle() runs, no
+        // other thread may submit to this queue (or to transfer_queue).
+        QueueWPtr dst_queue;
+
+        // size of the host visible staging buffer that is used as a ring. a
+        // single upload can't be larger than this.
+        VkDeviceSize staging_size = 67'108'864;
+    };
+
+    // called by UploadEngine::poll() once the uploads of a flush are done
+    using UploadCallback = std::function<void()>;
+
+    // uploads data to device local buffers and images through a dedicated
+    // transfer queue. uploads are copied into a staging ring buffer right away
+    // and recorded into a command buffer, then flush() submits all of them at
+    // once and returns the value the engine's timeline semaphore will reach
+    // when they're done (including the ownership transfer if needed). the
+    // value can be waited for on the host with wait() or on the device by
+    // passing timeline() and the value to Queue::submit(). staging memory is
+    // reclaimed as flushes complete and if the ring is full, uploading will
+    // block until enough of it is free.
+    // the timelineSemaphore feature must be enabled in DeviceConfig. the
+    // destination buffers and images must outlive the uploads and images are
+    // assumed to not be in use by any queue while being uploaded to.
+    class UploadEngine
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(UploadEngine);
+
+        static UploadEnginePtr create(
+            const DevicePtr& device,
+            const MemoryBankPtr& mem_bank,
+            const UploadEngineConfig& config
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const UploadEngineConfig& config() const
+        {
+            return _config;
+        }
+
+        constexpr const TimelineSemaphorePtr& timeline() const
+        {
+            return _timeline;
+        }
+
+        // the value that was returned by the last call to flush()
+        constexpr uint64_t last_flushed_value() const
+        {
+            return _last_flushed_value;
+        }
+
+        // whether ownership of the resources is transferred to the family of
+        // dst_queue after each flush
+        constexpr bool transfers_ownership() const
+        {
+            return _transfers_ownership;
+        }
+
+        // copy size bytes from data to the destination buffer at dst_offset.
+        // the buffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT.
+        void upload_to_buffer(
+            const void* data,
+            VkDeviceSize size,
+            const BufferPtr& dst_buffer,
+            VkDeviceSize dst_offset = 0
+        );
+
+        // copy tightly packed texels to mip level 0 of all array layers of the
+        // destination image. the whole image is transitioned from
+        // VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        // before the copy and to final_layout after it. the image needs
+        // VK_IMAGE_USAGE_TRANSFER_DST_BIT. formats whose texel size isn't a
+        // power of 2 are not supported.
+        void upload_to_image(
+            const void* data,
+            VkDeviceSize size,
+            const ImagePtr& dst_image,
+            VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        // submit all uploads since the last flush in a single submission.
+        // returns the timeline value that marks their completion. if there
+        // is nothing to flush, the value of the last flush is returned. the
+        // callback (if any) is called by poll() once the value is reached.
+        // if ownership is transferred, this also submits the acquire barriers
+        // to dst_queue, so the caller must make sure no other thread submits
+        // to it at the same time.
+        uint64_t flush(const UploadCallback& callback = nullptr);
+
+        // reclaim the staging memory and command buffers of completed flushes
+        // and call their callbacks. this never blocks.
+        void poll();
+
+        // wait on the host until the timeline reaches value, then poll()
+        void wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+        // flush and wait for everything to finish
+        void wait_idle();
+
+        ~UploadEngine();
+
+    protected:
+        // a submitted flush
+        struct InFlight
+        {
+            uint64_t value;
+            CommandBufferPtr transfer_cmd_buf;
+            CommandBufferPtr acquire_cmd_buf;
+            std::vector<UploadCallback> callbacks;
+        };
+
+        DeviceWPtr _device;
+        UploadEngineConfig _config;
+
+        QueuePtr transfer_queue;
+        QueuePtr dst_queue;
+        bool _transfers_ownership;
+
+        TimelineSemaphorePtr _timeline;
+        uint64_t _last_flushed_value = 0;
+
+        StagingRing staging;
+
+        CommandPoolPtr transfer_cmd_pool;
+        CommandPoolPtr acquire_cmd_pool;
+        std::vector<CommandBufferPtr> free_transfer_cmd_bufs;
+        std::vector<CommandBufferPtr> free_acquire_cmd_bufs;
+
+        // the command buffer being recorded since the last flush, if any
+        CommandBufferPtr pending_cmd_buf = nullptr;
+
+        // ownership transfer barriers for the pending uploads
+        std::vector<VkBufferMemoryBarrier> pending_buffer_barriers;
+        std::vector<VkImageMemoryBarrier> pending_image_barriers;
+
+        std::deque<InFlight> in_flight;
+
+        UploadEngine(
+            const DevicePtr& device,
+            const UploadEngineConfig& config,
+            const QueuePtr& transfer_queue,
+            const QueuePtr& dst_queue,
+            const TimelineSemaphorePtr& timeline
+        );
+
+        CommandBufferPtr take_cmd_buf(bool acquire);
+
+        // start recording a command buffer if there isn't one already
+        void begin_pending();
+
+        // reserve size bytes in the staging ring and return their offset in
+        // the staging buffer. flushes or waits if the ring is full.
+        VkDeviceSize allocate_staging(VkDeviceSize size);
+
+    };
+
+#pragma endregion
+
+#pragma region readback engine
+
+    struct ReadbackEngineConfig
+    {
+        // the queue that copies are submitted to. the source buffers and
+        // images must be owned by its family (or use
+        // VK_SHARING_MODE_CONCURRENT) and must have been written by earlier
+        // submissions to the same queue.
+        QueueWPtr queue;
+
+        // size of the host visible staging buffer that is used as a ring. a
+        // single readback can't be larger than this.
+        VkDeviceSize staging_size = 67'108'864;
+
+        // whether to track flushes with a timeline semaphore instead of one
+        // fence per flush. the timelineSemaphore feature must be enabled in
+        // DeviceConfig for this.
+        bool use_timeline_semaphore = true;
+    };
+
+    // called by ReadbackEngine::poll() once a readback is done. the data is
+    // only valid during the call.
+    using ReadbackCallback = std::function<void(std::span<const uint8_t> data)>;
+
+    // reads data back from buffers and images without stalling. the copies
+    // are recorded into a command buffer that goes into a staging ring buffer
+    // (host cached memory if there is any) and flush() submits all of them at
+    // once. poll() checks which flushes are done, invalidates the exact
+    // staging ranges and calls the callbacks with the data. calling flush()
+    // and poll() once per frame gives readbacks with a few frames of latency
+    // and no waiting on either side. staging memory is reclaimed as flushes
+    // complete and if the ring is full, reading back will block until enough
+    // of it is free.
+    class ReadbackEngine
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(ReadbackEngine);
+
+        static ReadbackEnginePtr create(
+            const DevicePtr& device,
+            const MemoryBankPtr& mem_bank,
+            const ReadbackEngineConfig& config
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const ReadbackEngineConfig& config() const
+        {
+            return _config;
+        }
+
+        // nullptr if the engine uses fences
+        constexpr const TimelineSemaphorePtr& timeline() const
+        {
+            return _timeline;
+        }
+
+        // the value that was returned by the last call to flush()
+        constexpr uint64_t last_flushed_value() const
+        {
+            return _last_flushed_value;
+        }
+
+        // whether the staging memory is host cached. reads from uncached
+        // memory are a lot slower.
+        constexpr bool staging_is_cached() const
+        {
+            return _staging_is_cached;
+        }
+
+        // copy size bytes from the source buffer at src_offset. the buffer
+        // needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT.
+        void readback_buffer(
+            const BufferPtr& src_buffer,
+            VkDeviceSize src_offset,
+            VkDeviceSize size,
+            const ReadbackCallback& callback
+        );
+
+        // copy mip level 0 of all array layers of the source image as tightly
+        // packed texels. size is the size of the result in bytes and must
+        // match the size of the image data, otherwise this throws. the image
+        // is transitioned from layout to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+        // for the copy and back after it, unless layout is
+        // VK_IMAGE_LAYOUT_GENERAL or already the transfer source layout. the
+        // image needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT. formats whose texel
+        // size isn't a power of 2 are not supported.
+        void readback_image(
+            const ImagePtr& src_image,
+            VkImageLayout layout,
+            VkDeviceSize size,
+            const ReadbackCallback& callback,
+            VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT
+        );
+
+        // submit all readbacks since the last flush in a single submission.
+        // returns a value that marks their completion, which is the value the
+        // timeline will reach if there is one. if there is nothing to flush,
+        // the value of the last flush is returned.
+        uint64_t flush();
+
+        // call the callbacks of completed flushes and reclaim their staging
+        // memory and command buffers. this never blocks.
+        void poll();
+
+        // wait on the host until the flush with the provided value is done,
+        // then poll()
+        void wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+        // flush and wait for everything to finish
+        void wait_idle();
+
+        ~ReadbackEngine();
+
+    protected:
+        struct Readback
+        {
+            // offset in the staging buffer
+            VkDeviceSize staging_offset;
+            VkDeviceSize size;
+            ReadbackCallback callback;
+        };
+
+        // a submitted flush
+        struct InFlight
+        {
+            uint64_t value;
+            CommandBufferPtr cmd_buf;
+            FencePtr fence;
+            std::vector<Readback> readbacks;
+        };
+
+        DeviceWPtr _device;
+        ReadbackEngineConfig _config;
+
+        QueuePtr queue;
+
+        TimelineSemaphorePtr _timeline;
+        uint64_t _last_flushed_value = 0;
+
+        StagingRing staging;
+        bool _staging_is_cached;
+
+        CommandPoolPtr cmd_pool;
+        std::vector<CommandBufferPtr> free_cmd_bufs;
+        std::vector<FencePtr> free_fences;
+
+        // the command buffer being recorded since the last flush, if any
+        CommandBufferPtr pending_cmd_buf = nullptr;
+        std::vector<Readback> pending_readbacks;
+
+        std::deque<InFlight> in_flight;
+
+        ReadbackEngine(
+            const DevicePtr& device,
+            const ReadbackEngineConfig& config,
+            const QueuePtr& queue,
+            const TimelineSemaphorePtr& timeline
+        );
+
+        // whether the device is done with a flush
+        bool is_complete(const InFlight& flight) const;
+
+        // start recording a command buffer if there isn't one already
+        void begin_pending();
+
+        // reserve size bytes in the staging ring and return their offset in
+        // the staging buffer. flushes or waits if the ring is full.
+        VkDeviceSize allocate_staging(VkDeviceSize size);
+
+    };
+
+#pragma endregion
+
+#pragma region GPU profiler
+
+    struct GpuProfilerConfig
+    {
+        // the queue that the profiled command buffers are submitted to. its
+        // family must support timestamps (nonzero timestamp_valid_bits).
+        QueueWPtr queue;
+
+        // number of frames that can be in flight at once. the results of a
+        // frame are read when its query slot is reused this many frames
+        // later, by which point waiting on the frame's fence has made them
+        // available.
+        uint32_t frames_in_flight = 2;
+
+        // regions past this many in a frame throw an error
+        uint32_t max_regions_per_frame = 64;
+
+        // put the regions on the host's std::chrono::steady_clock timeline
+        // with VK_EXT_calibrated_timestamps, which must be enabled in
+        // DeviceConfig. see GpuProfiler::calibrate().
+        bool calibrate = false;
+
+        // if calibrate is set, begin_frame() calibrates again once this much
+        // host time has passed since the last calibration
+        uint32_t calibration_interval_ms = 10'000;
+    };
+
+    struct GpuProfilerRegion
+    {
+        std::string name;
+
+        // number of regions this one is nested in
+        uint32_t depth;
+
+        // time since the first timestamp of the frame
+        double begin_ms;
+        double end_ms;
+
+        // nanoseconds on the std::chrono::steady_clock timeline, only set if
+        // the profiler is calibrated
+        int64_t host_begin_ns = 0;
+        int64_t host_end_ns = 0;
+
+        constexpr double duration_ms() const
+        {
+            return end_ms - begin_ms;
+        }
+    };
+
+    // measures the GPU time of named regions of command buffers with
+    // timestamp queries. call begin_frame() on the first command buffer
+    // recorded in a frame (it must also be the first one submitted), wrap
+    // work in begin_region() and end_region() (or a GpuProfilerScope) on any
+    // command buffer submitted to the same queue, and call end_frame() after
+    // the frame is submitted. begin_frame() reads the results of the frame
+    // that used the same query slot frames_in_flight frames ago without
+    // waiting, so results() always lags behind by that many frames. if they
+    // aren't available yet, that frame is skipped and counted in
+    // n_dropped_frames(). ticks are converted to milliseconds with the
+    // device's timestampPeriod.
+    class GpuProfiler
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(GpuProfiler);
+
+        static GpuProfilerPtr create(
+            const DevicePtr& device,
+            const GpuProfilerConfig& config
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        constexpr const GpuProfilerConfig& config() const
+        {
+            return _config;
+        }
+
+        constexpr const QueryPoolPtr& query_pool() const
+        {
+            return _query_pool;
+        }
+
+        // regions of the last frame whose results were read, in the order
+        // they began
+        constexpr const std::vector<GpuProfilerRegion>& results() const
+        {
+            return _results;
+        }
+
+        // index of the frame that results() belongs to, counting calls to
+        // begin_frame() from 0. UINT64_MAX if there are no results yet.
+        constexpr uint64_t results_frame_idx() const
+        {
+            return _results_frame_idx;
+        }
+
+        constexpr uint64_t n_dropped_frames() const
+        {
+            return _n_dropped_frames;
+        }
+
+        // sample the device and host clocks at the same moment with
+        // vkGetCalibratedTimestampsEXT() so that later results also get
+        // host_begin_ns and host_end_ns. the clocks drift apart slowly, so
+        // if calibrate is enabled in the config, begin_frame() also does
+        // this every calibration_interval_ms. calibrating is expensive, so
+        // it shouldn't be done every frame.
+        // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/vkGetCalibratedTimestampsEXT.html
+        void calibrate();
+
+        // read the results of an older frame and reset this frame's queries
+        void begin_frame(const CommandBufferPtr& cmd_buf);
+
+        void begin_region(
+            const CommandBufferPtr& cmd_buf,
+            const std::string& name,
+            VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+        );
+
+        // ends the most recent region that hasn't ended yet
+        void end_region(
+            const CommandBufferPtr& cmd_buf,
+            VkPipelineStageFlagBits stage =
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+        );
+
+        void end_frame();
+
+    protected:
+        struct RegionInfo
+        {
+            std::string name;
+            uint32_t depth;
+        };
+
+        struct FrameSlot
+        {
+            uint64_t frame_idx = UINT64_MAX;
+            std::vector<RegionInfo> regions;
+        };
+
+        DeviceWPtr _device;
+        GpuProfilerConfig _config;
+
+        QueryPoolPtr _query_pool;
+        double ns_per_tick;
+        uint64_t timestamp_mask;
+
+        std::vector<FrameSlot> slots;
+        uint64_t frame_idx = 0;
+
+        // regions of the current frame that haven't ended yet
+        std::vector<uint32_t> open_regions;
+
+        // two timestamps per region of the frame being read
+        std::vector<uint64_t> timestamps;
+
+        std::vector<GpuProfilerRegion> _results;
+        uint64_t _results_frame_idx = UINT64_MAX;
+        uint64_t _n_dropped_frames = 0;
+
+        // the last calibration, if any
+        bool calibrated = false;
+        uint64_t calibration_ticks = 0;
+        int64_t calibration_host_ns = 0;
+
+        GpuProfiler(
+            const DevicePtr& device,
+            const GpuProfilerConfig& config
+        );
+
+        constexpr FrameSlot& current_slot()
+        {
+            return slots[frame_idx % slots.size()];
+        }
+
+        constexpr uint32_t first_query(uint64_t frame) const
+        {
+            return (uint32_t)(frame % slots.size())
+                * 2 * _config.max_regions_per_frame;
+        }
+
+        // read the results of the frame that last used the current slot
+        void read_results();
+
+    };
+
+    // begins a region on construction and ends it on destruction. errors
+    // from ending the region are ignored since destructors can't throw.
+    class GpuProfilerScope
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR(GpuProfilerScope);
+
+        GpuProfilerScope(const GpuProfilerScope& other) = delete;
+        GpuProfilerScope& operator=(const GpuProfilerScope& other) = delete;
+
+        GpuProfilerScope(
+            const GpuProfilerPtr& profiler,
+            const CommandBufferPtr& cmd_buf,
+            const std::string& name
+        );
+
+        ~GpuProfilerScope();
+
+    private:
+        GpuProfilerPtr profiler;
+        CommandBufferPtr cmd_buf;
+
+    };
+
+#pragma endregion
+
+#pragma region compute workgroup tuner
+
+    struct ComputeWorkgroupTunerConfig
+    {
+        // identifies the workload in the tuner's results, together with the
+        // device and the code hash of the shader module. put anything that
+        // changes which size is best in here, like the problem size.
+        std::string name;
+
+        // the shader must declare its local size with local_size_x_id,
+        // local_size_y_id, and local_size_z_id. the stage's other
+        // specialization constants are kept as they are.
+        ShaderStage stage;
+        std::array<uint32_t, 3> local_size_constant_ids = { 0, 1, 2 };
+
+        VkPipelineCreateFlags flags = 0;
+        PipelineLayoutWPtr layout;
+
+        // sizes to try in each dimension. combinations with more invocations
+        // than maxComputeWorkGroupInvocations or sizes above
+        // maxComputeWorkGroupSize are skipped, and so are the ones with
+        // fewer than min_invocations invocations.
+        std::vector<uint32_t> candidates_x = {
+            1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024
+        };
+        std::vector<uint32_t> candidates_y = {
+            1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024
+        };
+        std::vector<uint32_t> candidates_z = { 1 };
+        uint32_t min_invocations = 32;
+
+        // every candidate is run n_warmup_runs times without being timed,
+        // then n_timed_runs times. candidates are compared by the median of
+        // their timed runs.
+        uint32_t n_warmup_runs = 2;
+        uint32_t n_timed_runs = 5;
+    };
+
+    struct ComputeWorkgroupTunerResult
+    {
+        std::array<uint32_t, 3> local_size;
+        ComputePipelinePtr pipeline;
+
+        // false if the local size was found in an earlier run
+        bool measured;
+
+        // median time of the chosen candidate. 0 if it wasn't measured.
+        double time_ms;
+    };
+
+    // records the workload with a candidate pipeline, which is already bound.
+    // the group count has to be derived from local_size.
+    using ComputeWorkgroupTunerRecordFn = std::function<void(
+        const CommandBufferPtr& cmd_buf,
+        const ComputePipelinePtr& pipeline,
+        const std::array<uint32_t, 3>& local_size
+    )>;
+
+    // picks the fastest local size for a compute shader on the current
+    // device by creating a pipeline for each candidate through
+    // specialization constants and timing them with timestamp queries. the
+    // results are kept per device UUID (vendor and device ID if the
+    // physical device has no Vulkan 1.1 properties) and can be saved to a
+    // file so that later runs on the same device skip the measurements.
+    class ComputeWorkgroupTuner
+    {
+    public:
+        _BV_DELETE_DEFAULT_CTOR_AND_ALLOW_MOVE_ONLY(ComputeWorkgroupTuner);
+
+        // results are loaded from results_path if it's not empty. results
+        // of other devices are kept and saved again, unless their local size
+        // is out of this device's limits.
+        static ComputeWorkgroupTunerPtr create(
+            const DevicePtr& device,
+            const std::string& results_path = ""
+        );
+
+        constexpr const DeviceWPtr& device() const
+        {
+            return _device;
+        }
+
+        // if there's a result for the config on this device, only its
+        // pipeline is created. otherwise the candidates are created with
+        // ComputePipeline::create_multiple(), recorded into one command
+        // buffer from cmd_pool, submitted to queue, and waited on. queue
+        // must support compute and timestamps (nonzero
+        // timestamp_valid_bits). the workload's resources must be ready to
+        // use when this is called.
+        ComputeWorkgroupTunerResult tune(
+            const ComputeWorkgroupTunerConfig& config,
+            const QueuePtr& queue,
+            const CommandPoolPtr& cmd_pool,
+            const ComputeWorkgroupTunerRecordFn& record,
+            const PipelineCachePtr& cache = nullptr
+        );
+
+        // drop the result for the config on this device so that the next
+        // tune() measures again
+        void forget(const ComputeWorkgroupTunerConfig& config);
+
+        // write the results to results_path
+        void save();
+
+    protected:
+        DeviceWPtr _device;
+        std::string results_path;
+
+        std::unordered_map<uint64_t, std::array<uint32_t, 3>> results;
+
+        ComputeWorkgroupTuner(
+            const DevicePtr& device,
+            const std::string& results_path
+        );
+
+        uint64_t result_key(const ComputeWorkgroupTunerConfig& config);
+
+    };
+
+#pragma endregion
+
 }
@@ -1,12 +1,16 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <optional>
+#include <fstream>
 #include <cstdint>
 
 #include "demos/00_first_triangle.hpp"
 #include "demos/01_textured_model.hpp"
 #include "demos/02_compute_shader.hpp"
 #include "demos/03_deferred_rendering.hpp"
+#include "demos/headless.hpp"
+#include "demos/frame_stats.hpp"
 
 static const std::vector<std::string> demos{
     "first triangle",
@@ -20,43 +24,221 @@ static const std::vector<std::string> demos{
     "processing, filmic color transform"
 };
 
-void run_demo(int32_t idx)
+template<typename App>
+void run_app(const std::optional<beva_demos::HeadlessConfig>& headless)
 {
-    switch (idx)
-    {
-    case 0:
+    if (headless.has_value())
     {
-        beva_demo_00_first_triangle::App app{};
+        App app(headless.value());
         app.run();
-        break;
     }
-    case 1:
+    else
     {
-        beva_demo_01_textured_model::App app{};
+        App app{};
         app.run();
-        break;
     }
-    case 2:
+}
+
+void run_demo(
+    int32_t idx,
+    const std::optional<beva_demos::HeadlessConfig>& headless = std::nullopt
+)
+{
+    switch (idx)
     {
-        beva_demo_02_compute_shader::App app{};
-        app.run();
+    case 0:
+        run_app<beva_demo_00_first_triangle::App>(headless);
+        break;
+    case 1:
+        run_app<beva_demo_01_textured_model::App>(headless);
+        break;
+    case 2:
+        run_app<beva_demo_02_compute_shader::App>(headless);
         break;
-    }
     case 3:
-    {
-        beva_demo_03_deferred_rendering::App app{};
-        app.run();
+        run_app<beva_demo_03_deferred_rendering::App>(headless);
         break;
+    default:
+        throw std::runtime_error("invalid demo index");
     }
+}
+
+// run a demo headless and return its frame statistics
+template<typename App>
+beva_demos::FrameStats benchmark_app(
+    const beva_demos::HeadlessConfig& config
+)
+{
+    App app(config);
+    app.run();
+    return app.frame_stats();
+}
+
+beva_demos::FrameStats benchmark_demo(
+    int32_t idx,
+    const beva_demos::HeadlessConfig& config
+)
+{
+    switch (idx)
+    {
+    case 0:
+        return benchmark_app<beva_demo_00_first_triangle::App>(config);
+    case 1:
+        return benchmark_app<beva_demo_01_textured_model::App>(config);
+    case 2:
+        return benchmark_app<beva_demo_02_compute_shader::App>(config);
+    case 3:
+        return benchmark_app<beva_demo_03_deferred_rendering::App>(config);
     default:
         throw std::runtime_error("invalid demo index");
     }
 }
 
-int main()
+static const char* USAGE =
+    "usage:\n"
+    "  beva --headless <demo index> [--frames <n>] [--size <width>x<height>] "
+    "[--device <index>] [--async-compute <0|1>] [--dump <path.ppm>] "
+    "[--trace <path.json>]\n"
+    "  beva --benchmark [--frames <n>] [--size <width>x<height>] "
+    "[--device <index>] [--async-compute <0|1>] [--warmup <n>] "
+    "[--out <path.json>]";
+
+static void write_file(const std::string& path, const std::string& contents)
+{
+    std::ofstream f(path);
+    if (!f.is_open())
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+    f << contents;
+}
+
+// run a single demo without a window, or every demo back to back with
+// --benchmark, and return. see beva_demos::HeadlessConfig for the options.
+int run_headless(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        throw std::runtime_error(USAGE);
+    }
+
+    std::string mode = argv[1];
+    bool benchmark = mode == "--benchmark";
+    if (!benchmark && (mode != "--headless" || argc < 3))
+    {
+        throw std::runtime_error(USAGE);
+    }
+
+    int32_t idx = benchmark ? -1 : std::stoi(argv[2]);
+    beva_demos::HeadlessConfig config{};
+    size_t n_warmup_frames = 100;
+    std::string out_path;
+    std::string trace_path;
+    for (int i = benchmark ? 2 : 3; i < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            throw std::runtime_error(USAGE);
+        }
+        std::string value = argv[i + 1];
+
+        if (option == "--frames")
+        {
+            config.n_frames = std::stoull(value);
+        }
+        else if (option == "--size")
+        {
+            size_t x_pos = value.find('x');
+            if (x_pos == std::string::npos)
+            {
+                throw std::runtime_error(USAGE);
+            }
+            config.width = (uint32_t)std::stoul(value.substr(0, x_pos));
+            config.height = (uint32_t)std::stoul(value.substr(x_pos + 1));
+        }
+        else if (option == "--device")
+        {
+            config.physical_device_idx = (uint32_t)std::stoul(value);
+        }
+        else if (option == "--async-compute")
+        {
+            config.async_compute = std::stoul(value) != 0;
+        }
+        else if (option == "--dump" && !benchmark)
+        {
+            config.dump_path = value;
+        }
+        else if (option == "--trace" && !benchmark)
+        {
+#ifdef BV_ENABLE_TRACING
+            trace_path = value;
+#else
+            throw std::runtime_error(
+                "--trace requires building with BV_ENABLE_TRACING"
+            );
+#endif
+        }
+        else if (option == "--warmup" && benchmark)
+        {
+            n_warmup_frames = std::stoull(value);
+        }
+        else if (option == "--out" && benchmark)
+        {
+            out_path = value;
+        }
+        else
+        {
+            throw std::runtime_error(USAGE);
+        }
+    }
+
+    if (!benchmark)
+    {
+        run_demo(idx, config);
+
+#ifdef BV_ENABLE_TRACING
+        if (!trace_path.empty())
+        {
+            write_file(trace_path, bv::trace_to_chrome_json());
+        }
+#endif
+        return EXIT_SUCCESS;
+    }
+
+    // the report is a JSON array with one object per demo
+    std::string report = "[\n";
+    for (int32_t i = 0; i < (int32_t)demos.size(); i++)
+    {
+        std::cerr << std::format("benchmarking demo {}\n", i);
+        report += benchmark_demo(i, config).to_json(
+            demos[i].substr(0, demos[i].find(':')),
+            n_warmup_frames
+        );
+        report += i + 1 < (int32_t)demos.size() ? ",\n" : "\n";
+    }
+    report += "]\n";
+
+    if (out_path.empty())
+    {
+        std::cout << report;
+    }
+    else
+    {
+        write_file(out_path, report);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
 {
     try
     {
+        if (argc > 1)
+        {
+            return run_headless(argc, argv);
+        }
+
         while (true)
         {
             std::cout <<